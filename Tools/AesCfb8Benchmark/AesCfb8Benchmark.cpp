@@ -0,0 +1,112 @@
+
+// AesCfb8Benchmark.cpp
+
+// Measures the single-core throughput of the AES-128 / CFB8 stream cipher used for the client connections
+// Compares the mbedTLS implementation with the AES-NI one (cAesNiCfb8), for both directions and several piece sizes.
+// Usage: AesCfb8Benchmark [<MiBPerRun>]
+
+#include "Globals.h"
+#include "mbedTLS++/AesNiCfb8.h"
+#include "mbedtls/aes.h"
+
+
+
+
+
+/** Measures processing a_TotalSize bytes in pieces of a_PieceSize bytes through the specified function.
+Returns the throughput in MB / sec. */
+template <typename ProcessFn>
+static double Measure(size_t a_TotalSize, size_t a_PieceSize, ProcessFn a_Process)
+{
+	std::vector<Byte> In(a_PieceSize), Out(a_PieceSize);
+	for (size_t i = 0; i < a_PieceSize; i++)
+	{
+		In[i] = static_cast<Byte>(i * 7 + 3);
+	}
+	auto Start = std::chrono::steady_clock::now();
+	for (size_t Done = 0; Done < a_TotalSize; Done += a_PieceSize)
+	{
+		a_Process(Out.data(), In.data(), a_PieceSize);
+	}
+	auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - Start).count();
+	return static_cast<double>(a_TotalSize) / Elapsed / 1e6;
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	int MiBPerRun = (argc > 1) ? atoi(argv[1]) : 32;
+	if (MiBPerRun <= 0)
+	{
+		LOGERROR("Usage: AesCfb8Benchmark [<MiBPerRun>]");
+		return 1;
+	}
+	size_t TotalSize = static_cast<size_t>(MiBPerRun) * 1024 * 1024;
+	bool HasAesNi = cAesNiCfb8::IsSupported();
+	if (!HasAesNi)
+	{
+		LOGWARNING("AES-NI is not supported on this CPU, measuring mbedTLS only.");
+	}
+
+	Byte Key[16], IV[16];
+	for (size_t i = 0; i < sizeof(Key); i++)
+	{
+		Key[i] = static_cast<Byte>(i);
+		IV[i] = static_cast<Byte>(255 - i);
+	}
+	mbedtls_aes_context Aes;
+	mbedtls_aes_init(&Aes);
+	mbedtls_aes_setkey_enc(&Aes, Key, 128);
+	cAesNiCfb8 AesNi;
+	if (HasAesNi)
+	{
+		AesNi.Init(Key);
+	}
+
+	// Piece sizes: a small packet, a typical entity update batch and the 8 KiB pieces of cProtocol_1_8_0::SendData():
+	static const size_t PieceSizes[] = {16, 128, 1024, 8192};
+	printf("Single-core throughput, %d MiB per run, MB / sec:\n", MiBPerRun);
+	printf("%10s  %12s %12s %8s  %12s %12s %8s\n", "PieceSize", "Enc mbedTLS", "Enc AES-NI", "Speedup", "Dec mbedTLS", "Dec AES-NI", "Speedup");
+	for (auto PieceSize: PieceSizes)
+	{
+		double Results[4] = {0, 0, 0, 0};
+		Results[0] = Measure(TotalSize, PieceSize, [&](Byte * a_Out, const Byte * a_In, size_t a_Size)
+			{
+				mbedtls_aes_crypt_cfb8(&Aes, MBEDTLS_AES_ENCRYPT, a_Size, IV, a_In, a_Out);
+			}
+		);
+		Results[2] = Measure(TotalSize, PieceSize, [&](Byte * a_Out, const Byte * a_In, size_t a_Size)
+			{
+				mbedtls_aes_crypt_cfb8(&Aes, MBEDTLS_AES_DECRYPT, a_Size, IV, a_In, a_Out);
+			}
+		);
+		if (HasAesNi)
+		{
+			Results[1] = Measure(TotalSize, PieceSize, [&](Byte * a_Out, const Byte * a_In, size_t a_Size)
+				{
+					AesNi.Encrypt(IV, a_Out, a_In, a_Size);
+				}
+			);
+			Results[3] = Measure(TotalSize, PieceSize, [&](Byte * a_Out, const Byte * a_In, size_t a_Size)
+				{
+					AesNi.Decrypt(IV, a_Out, a_In, a_Size);
+				}
+			);
+		}
+		printf("%10u  %12.1f %12.1f %7.2fx  %12.1f %12.1f %7.2fx\n",
+			static_cast<unsigned>(PieceSize),
+			Results[0], Results[1], Results[1] / Results[0],
+			Results[2], Results[3], Results[3] / Results[2]
+		);
+	}
+
+	mbedtls_aes_free(&Aes);
+	return 0;
+}
+
+
+
+
@@ -1,8 +1,106 @@
 
+// GeneratorPerformanceTest.cpp
+
+// Measures the chunk generator throughput for an increasing number of generator threads
+// Usage: GeneratorPerformanceTest [<ChunkRadius> [<MaxThreads>]]
+
 #include "Globals.h"
 #include "ChunkGenerator.h"
+#include "ChunkDesc.h"
+#include "IniFile.h"
+
+
+
+
+
+/** Receives the generated chunks; counts them and checksums their blocks, so that the output of different thread counts can be compared. */
+class cBenchmarkCallbacks :
+	public cChunkGenerator::cChunkSink,
+	public cChunkGenerator::cPluginInterface
+{
+public:
+	cBenchmarkCallbacks(void):
+		m_NumGenerated(0),
+		m_Checksum(0)
+	{
+	}
+
+	std::atomic<int> m_NumGenerated;
+
+	/** XOR of the per-chunk checksums, so that it doesn't depend on the order in which the chunks were generated. */
+	std::atomic<UInt32> m_Checksum;
+
+protected:
+	virtual void OnChunkGenerated(cChunkDesc & a_ChunkDesc) override
+	{
+		UInt32 Checksum = static_cast<UInt32>(a_ChunkDesc.GetChunkX() * 73856093) ^ static_cast<UInt32>(a_ChunkDesc.GetChunkZ() * 19349663);
+		const auto & BlockTypes = a_ChunkDesc.GetBlockTypes();
+		for (size_t i = 0; i < ARRAYCOUNT(BlockTypes); i++)
+		{
+			Checksum = Checksum * 31 + BlockTypes[i];
+		}
+		m_Checksum ^= Checksum;
+		m_NumGenerated += 1;
+	}
+
+	virtual bool IsChunkValid(int a_ChunkX, int a_ChunkZ) override { return false; }
+	virtual bool HasChunkAnyClients(int a_ChunkX, int a_ChunkZ) override { return true; }
+	virtual bool IsChunkQueued(int a_ChunkX, int a_ChunkZ) override { return true; }
+	virtual void CallHookChunkGenerating(cChunkDesc & a_ChunkDesc) override {}
+	virtual void CallHookChunkGenerated(cChunkDesc & a_ChunkDesc) override {}
+} ;
+
+
+
+
 
 int main(int argc, char * argv[])
 {
-	cChunkGenerator Generator = cChunkGenerator();
+	int Radius = (argc > 1) ? atoi(argv[1]) : 16;
+	int MaxThreads = (argc > 2) ? atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+	MaxThreads = std::max(MaxThreads, 1);
+	int NumChunks = (2 * Radius + 1) * (2 * Radius + 1);
+
+	for (int NumThreads = 1; NumThreads <= MaxThreads; NumThreads *= 2)
+	{
+		cIniFile IniFile;
+		IniFile.SetValueI("Seed", "Seed", 1234);
+		IniFile.SetValueI("Generator", "NumThreads", NumThreads);
+
+		cBenchmarkCallbacks Callbacks;
+		cChunkGenerator Generator;
+		if (!Generator.Initialize(Callbacks, Callbacks, IniFile))
+		{
+			LOGERROR("Cannot initialize the generator");
+			return 1;
+		}
+		Generator.Start();
+
+		auto Start = std::chrono::steady_clock::now();
+		for (int z = -Radius; z <= Radius; z++)
+		{
+			for (int x = -Radius; x <= Radius; x++)
+			{
+				// Keep the queue short enough for the generator not to start skipping or warning:
+				while (Generator.GetQueueLength() > 400)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				Generator.QueueGenerateChunk(x, z, false);
+			}
+		}
+		Generator.WaitForQueueEmpty();
+		auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - Start).count();
+		Generator.Stop();
+
+		ASSERT(Callbacks.m_NumGenerated == NumChunks);
+		printf("%2d threads: %d chunks in %.2f sec, %.1f chunks / sec, checksum %08x\n",
+			NumThreads, NumChunks, Elapsed, static_cast<double>(NumChunks) / Elapsed, static_cast<unsigned>(Callbacks.m_Checksum)
+		);
+	}
+	return 0;
 }
+
+
+
+
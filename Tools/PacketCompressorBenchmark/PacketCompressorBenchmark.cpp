@@ -0,0 +1,306 @@
+
+// PacketCompressorBenchmark.cpp
+
+// Measures the throughput and the heap allocations of framing a mix of outgoing packets
+// Compares the per-connection cPacketCompressor with the previous one-shot compress2() framing
+// Usage: PacketCompressorBenchmark [<RecordedPacketsFile> [<NumRepeats> [<Threshold> [<Level>]]]]
+// The recorded packets file is a sequence of uncompressed packets, each prefixed by its length as a VarInt
+// (the format of the packets before compression is enabled). Use "-" to use the built-in packet mix.
+
+#include "Globals.h"
+#include "ByteBuffer.h"
+#include "Protocol/PacketCompressor.h"
+
+
+
+
+
+/** The number of heap allocations made so far, both through operator new and through zlib. */
+static size_t g_NumAllocations = 0;
+
+
+
+
+
+void * operator new(size_t a_Size)
+{
+	g_NumAllocations += 1;
+	void * Res = malloc(a_Size);
+	if (Res == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return Res;
+}
+
+
+
+
+
+void operator delete(void * a_Ptr) noexcept
+{
+	free(a_Ptr);
+}
+
+
+
+
+
+/** The zlib allocator used by the one-shot framing, counting the allocations made by deflateInit(). */
+static voidpf CountingAlloc(voidpf a_Opaque, uInt a_Items, uInt a_Size)
+{
+	UNUSED(a_Opaque);
+	g_NumAllocations += 1;
+	return calloc(a_Items, a_Size);
+}
+
+
+
+
+
+static void CountingFree(voidpf a_Opaque, voidpf a_Address)
+{
+	UNUSED(a_Opaque);
+	free(a_Address);
+}
+
+
+
+
+
+/** Simple deterministic generator for the built-in packet mix, so that all runs use the same data. */
+class cMixRandom
+{
+public:
+	cMixRandom(void): m_State(12345) {}
+
+	UInt32 Next(UInt32 a_Max)
+	{
+		m_State = m_State * 1103515245 + 12345;
+		return (m_State >> 8) % a_Max;
+	}
+
+protected:
+	UInt32 m_State;
+};
+
+
+
+
+
+/** Creates a packet mix resembling the outgoing traffic of a busy server:
+mostly tiny entity movement packets, some metadata and block changes, a few window and chunk packets. */
+static std::vector<AString> CreateBuiltInMix(void)
+{
+	static const struct
+	{
+		int m_Percent;
+		size_t m_MinSize;
+		size_t m_MaxSize;
+	} Kinds[] =
+	{
+		{45,    8,    12},  // Entity relative move / look
+		{20,    6,    10},  // Entity velocity / head look
+		{10,   10,    14},  // Block change
+		{10,   20,    60},  // Entity metadata
+		{ 8,  100,   300},  // Chat, player list, sounds
+		{ 5,  300,  1500},  // Window items, multi block change
+		{ 2, 8000, 30000},  // Chunk data
+	};
+
+	cMixRandom Random;
+	std::vector<AString> Res;
+	for (const auto & Kind : Kinds)
+	{
+		for (int i = 0; i < Kind.m_Percent * 10; i++)
+		{
+			size_t Size = Kind.m_MinSize + Random.Next(static_cast<UInt32>(Kind.m_MaxSize - Kind.m_MinSize + 1));
+			AString Packet;
+			Packet.reserve(Size);
+			for (size_t b = 0; b < Size; b++)
+			{
+				// Somewhat compressible data, like the real packets (lots of small numbers and repeated blocks):
+				Packet.push_back(static_cast<char>((Random.Next(4) == 0) ? Random.Next(256) : Random.Next(8)));
+			}
+			Res.push_back(std::move(Packet));
+		}
+	}
+
+	// Interleave the kinds, as they would be on the wire:
+	for (size_t i = Res.size() - 1; i > 0; i--)
+	{
+		std::swap(Res[i], Res[Random.Next(static_cast<UInt32>(i + 1))]);
+	}
+	return Res;
+}
+
+
+
+
+
+/** Loads the packets recorded in the specified file. */
+static std::vector<AString> LoadRecordedMix(const char * a_FileName)
+{
+	std::vector<AString> Res;
+	FILE * f = fopen(a_FileName, "rb");
+	if (f == nullptr)
+	{
+		LOGERROR("Cannot open file %s", a_FileName);
+		return Res;
+	}
+	AString Contents;
+	char Buffer[64 KiB];
+	size_t NumRead;
+	while ((NumRead = fread(Buffer, 1, sizeof(Buffer), f)) > 0)
+	{
+		Contents.append(Buffer, NumRead);
+	}
+	fclose(f);
+
+	cByteBuffer Buf(Contents.size() + 1);
+	Buf.Write(Contents.data(), Contents.size());
+	UInt32 PacketLen;
+	while (Buf.ReadVarInt32(PacketLen) && Buf.CanReadBytes(PacketLen))
+	{
+		AString Packet;
+		Buf.ReadString(Packet, PacketLen);
+		Res.push_back(std::move(Packet));
+	}
+	return Res;
+}
+
+
+
+
+
+/** Frames the packet the way the protocols used to: copy out of the buffer, one-shot compress, copy the result.
+Returns the framed size. */
+static size_t OneShotFramePacket(cByteBuffer & a_Buffer, int a_Threshold, int a_Level)
+{
+	static char CompressedData[200 KiB];  // Was on the stack in the protocols
+	UInt32 PacketLen = static_cast<UInt32>(a_Buffer.GetUsedSpace());
+	AString PacketData, CompressedPacket;
+	a_Buffer.ReadAll(PacketData);
+	a_Buffer.CommitRead();
+
+	if (PacketLen < static_cast<UInt32>(a_Threshold))
+	{
+		cByteBuffer LenBuffer(20);
+		LenBuffer.WriteVarInt32(PacketLen + 1);
+		LenBuffer.WriteVarInt32(0);
+		AString LengthData;
+		LenBuffer.ReadAll(LengthData);
+		return LengthData.size() + PacketData.size();
+	}
+
+	// Same as compress2(), but counting the zlib allocations:
+	z_stream Stream;
+	memset(&Stream, 0, sizeof(Stream));
+	Stream.zalloc = CountingAlloc;
+	Stream.zfree = CountingFree;
+	VERIFY(deflateInit(&Stream, a_Level) == Z_OK);
+	Stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(PacketData.data()));
+	Stream.avail_in = static_cast<uInt>(PacketData.size());
+	Stream.next_out = reinterpret_cast<Bytef *>(CompressedData);
+	Stream.avail_out = sizeof(CompressedData);
+	VERIFY(deflate(&Stream, Z_FINISH) == Z_STREAM_END);
+	size_t CompressedSize = Stream.total_out;
+	deflateEnd(&Stream);
+
+	AString LengthData;
+	cByteBuffer LenBuffer(20);
+	LenBuffer.WriteVarInt32(PacketLen);
+	LenBuffer.ReadAll(LengthData);
+	LenBuffer.CommitRead();
+	LenBuffer.WriteVarInt32(static_cast<UInt32>(CompressedSize + LengthData.size()));
+	LenBuffer.WriteVarInt32(PacketLen);
+	LenBuffer.ReadAll(LengthData);
+	LenBuffer.CommitRead();
+
+	CompressedPacket.reserve(LengthData.size() + CompressedSize);
+	CompressedPacket.append(LengthData.data(), LengthData.size());
+	CompressedPacket.append(CompressedData, CompressedSize);
+	return CompressedPacket.size();
+}
+
+
+
+
+
+/** Runs the packets through the specified framing function a_NumRepeats times and prints the results. */
+template <typename FramingFn>
+static void Measure(const char * a_Name, const std::vector<AString> & a_Packets, int a_NumRepeats, FramingFn a_Framing)
+{
+	cByteBuffer Buffer(64 KiB);  // Same as cProtocol::m_OutPacketBuffer
+	size_t NumPackets = 0;
+	size_t InSize = 0;
+	size_t OutSize = 0;
+	size_t StartAllocations = g_NumAllocations;
+	auto Start = std::chrono::steady_clock::now();
+	for (int r = 0; r < a_NumRepeats; r++)
+	{
+		for (const auto & Packet : a_Packets)
+		{
+			if (Packet.size() >= Buffer.GetFreeSpace())
+			{
+				continue;
+			}
+			Buffer.Write(Packet.data(), Packet.size());
+			OutSize += a_Framing(Buffer, Packet.size());
+			InSize += Packet.size();
+			NumPackets += 1;
+		}
+	}
+	auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - Start).count();
+	size_t NumAllocations = g_NumAllocations - StartAllocations;
+
+	printf("%-12s %10.0f packets / sec, %7.1f MiB / sec, %6.3f allocations / packet, output %5.1f %% of input\n",
+		a_Name,
+		static_cast<double>(NumPackets) / Elapsed,
+		static_cast<double>(InSize) / Elapsed / 1024 / 1024,
+		static_cast<double>(NumAllocations) / static_cast<double>(NumPackets),
+		100.0 * static_cast<double>(OutSize) / static_cast<double>(InSize)
+	);
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	bool UseRecorded = ((argc > 1) && (strcmp(argv[1], "-") != 0));
+	int NumRepeats = (argc > 2) ? atoi(argv[2]) : 20;
+	int Threshold = (argc > 3) ? atoi(argv[3]) : cPacketCompressor::DEFAULT_THRESHOLD;
+	int Level = (argc > 4) ? atoi(argv[4]) : Z_DEFAULT_COMPRESSION;
+
+	auto Packets = UseRecorded ? LoadRecordedMix(argv[1]) : CreateBuiltInMix();
+	if (Packets.empty())
+	{
+		LOGERROR("No packets to measure");
+		return 1;
+	}
+	printf("%u packets in the mix, %d repeats, threshold %d, level %d\n", static_cast<unsigned>(Packets.size()), NumRepeats, Threshold, Level);
+
+	Measure("one-shot", Packets, NumRepeats, [=](cByteBuffer & a_Buffer, size_t a_Size)
+		{
+			UNUSED(a_Size);
+			return OneShotFramePacket(a_Buffer, Threshold, Level);
+		}
+	);
+
+	cPacketCompressor Compressor(Threshold, Level);
+	Measure("streaming", Packets, NumRepeats, [&](cByteBuffer & a_Buffer, size_t a_Size)
+		{
+			const char * Framed;
+			size_t FramedSize;
+			VERIFY(Compressor.FramePacket(a_Buffer, a_Size, true, Framed, FramedSize));
+			return FramedSize;
+		}
+	);
+	return 0;
+}
+
+
+
+
@@ -11,8 +11,12 @@
 
 #include "../IniFile.h"
 #include "../Entities/Player.h"
+#include "../TickProfiler.h"
 
-#define FIND_HOOK(a_HookName) HookMap::iterator Plugins = m_Hooks.find(a_HookName);
+/** Looks up the plugins registered for the hook; if there are any, the rest of the hook call is measured by the tick profiler. */
+#define FIND_HOOK(a_HookName) \
+	HookMap::iterator Plugins = m_Hooks.find(a_HookName); \
+	cTickProfiler::cScope ProfilerScope(cTickProfiler::catPluginHook, (Plugins == m_Hooks.end()) ? nullptr : #a_HookName);
 #define VERIFY_HOOK \
 	if (Plugins == m_Hooks.end()) \
 	{ \
@@ -34,6 +38,7 @@ cPluginManager * cPluginManager::Get(void)
 
 cPluginManager::cPluginManager(cDeadlockDetect & a_DeadlockDetect) :
 	m_bReloadPlugins(false),
+	m_HasServerPingHook(false),
 	m_DeadlockDetect(a_DeadlockDetect)
 {
 }
@@ -1644,6 +1649,7 @@ void cPluginManager::UnloadPluginsNow()
 {
 	// Remove all bindings:
 	m_Hooks.clear();
+	m_HasServerPingHook = false;
 	m_Commands.clear();
 	m_ConsoleCommands.clear();
 
@@ -1703,6 +1709,8 @@ void cPluginManager::RemoveHooks(cPlugin * a_Plugin)
 	{
 		itr->second.remove(a_Plugin);
 	}
+	auto ServerPing = m_Hooks.find(HOOK_SERVER_PING);
+	m_HasServerPingHook = ((ServerPing != m_Hooks.end()) && !ServerPing->second.empty());
 }
 
 
@@ -2056,6 +2064,10 @@ void cPluginManager::AddHook(cPlugin * a_Plugin, int a_Hook)
 	{
 		Plugins.push_back(a_Plugin);
 	}
+	if (a_Hook == HOOK_SERVER_PING)
+	{
+		m_HasServerPingHook = true;
+	}
 }
 
 
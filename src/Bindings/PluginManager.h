@@ -223,6 +223,10 @@ public:
 	/** Returns the number of plugins that are psLoaded. */
 	size_t GetNumLoadedPlugins(void) const;  // tolua_export
 
+	/** Returns true if any plugin has registered the HOOK_SERVER_PING hook.
+	Thread-safe, the network threads use this to decide whether they can answer server list pings on their own. */
+	bool HasServerPingHook(void) const { return m_HasServerPingHook; }
+
 	// Calls for individual hooks. Each returns false if the action is to continue or true if the plugin wants to abort
 	bool CallHookBlockSpread              (cWorld & a_World, int a_BlockX, int a_BlockY, int a_BlockZ, eSpreadSource a_Source);
 	bool CallHookBlockToPickups           (cWorld & a_World, cEntity * a_Digger, int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, cItems & a_Pickups);
@@ -420,6 +424,9 @@ private:
 	/** If set to true, all the plugins will be reloaded within the next call to Tick(). */
 	bool m_bReloadPlugins;
 
+	/** Set if any plugin has registered HOOK_SERVER_PING. Mirrors m_Hooks, so that it can be read outside the tick thread. */
+	std::atomic<bool> m_HasServerPingHook;
+
 	/** The deadlock detect in which all plugins should track their CSs. */
 	cDeadlockDetect & m_DeadlockDetect;
 
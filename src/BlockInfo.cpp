@@ -18,6 +18,7 @@ cBlockInfo::cBlockInfoArray::cBlockInfoArray()
 	for (size_t i = 0; i < Info.size(); ++i)
 	{
 		Info[i].m_Handler.reset(cBlockHandler::CreateBlockHandler(static_cast<BLOCKTYPE>(i)));
+		Info[i].m_IsRandomTickable = Info[i].m_Handler->IsRandomTickable();
 	}
 
 	// Emissive blocks
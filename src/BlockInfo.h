@@ -75,6 +75,9 @@ public:
 	/** Associated block handler. */
 	std::unique_ptr<cBlockHandler, sHandlerDeleter> m_Handler;
 
+	/** Cached m_Handler->IsRandomTickable(), queried for every block set into a chunk. */
+	bool m_IsRandomTickable;
+
 	// tolua_begin
 
 	inline static NIBBLETYPE GetLightValue        (BLOCKTYPE a_Type) { return Get(a_Type).m_LightValue;          }
@@ -98,6 +101,7 @@ public:
 	// tolua_end
 
 	inline static cBlockHandler * GetHandler      (BLOCKTYPE a_Type) { return Get(a_Type).m_Handler.get();       }
+	inline static bool IsRandomTickable           (BLOCKTYPE a_Type) { return Get(a_Type).m_IsRandomTickable;    }
 
 	/** Creates a default BlockInfo structure, initializes all values to their defaults */
 	cBlockInfo()
@@ -116,6 +120,7 @@ public:
 		, m_BlockHeight(1.0)
 		, m_Hardness(0.0f)
 		, m_Handler()
+		, m_IsRandomTickable(false)
 	{}
 
 private:
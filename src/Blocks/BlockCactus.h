@@ -67,6 +67,11 @@ public:
 		return true;
 	}
 
+	virtual bool IsRandomTickable(void) const override
+	{
+		return true;
+	}
+
 	virtual void OnUpdate(cChunkInterface & cChunkInterface, cWorldInterface & a_WorldInterface, cBlockPluginInterface & a_PluginInterface, cChunk & a_Chunk, int a_RelX, int a_RelY, int a_RelZ) override
 	{
 		if (CanGrow(a_Chunk, a_RelX, a_RelY, a_RelZ) == paGrowth)
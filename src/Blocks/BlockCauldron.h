@@ -60,6 +60,11 @@ public:
 		return true;
 	}
 
+	virtual bool IsRandomTickable(void) const override
+	{
+		return true;
+	}
+
 	virtual void OnUpdate(cChunkInterface & a_ChunkInterface, cWorldInterface & a_WorldInterface, cBlockPluginInterface & a_PluginInterface, cChunk & a_Chunk, int a_RelX, int a_RelY, int a_RelZ) override
 	{
 		int BlockX = a_RelX + a_Chunk.GetPosX() * cChunkDef::Width;
@@ -33,6 +33,11 @@ public:
 		}
 	}
 
+	virtual bool IsRandomTickable(void) const override
+	{
+		return (m_BlockType == E_BLOCK_GRASS);
+	}
+
 	virtual void OnUpdate(cChunkInterface & cChunkInterface, cWorldInterface & a_WorldInterface, cBlockPluginInterface & a_PluginInterface, cChunk & a_Chunk, int a_RelX, int a_RelY, int a_RelZ) override
 	{
 		if (m_BlockType != E_BLOCK_GRASS)
@@ -86,6 +86,11 @@ public:
 	{
 	}
 
+	virtual bool IsRandomTickable(void) const override
+	{
+		return true;
+	}
+
 	/** Called to tick the block */
 	virtual void OnUpdate(cChunkInterface & cChunkInterface, cWorldInterface & a_WorldInterface, cBlockPluginInterface & a_PluginInterface, cChunk & a_Chunk, int a_RelX, int a_RelY, int a_RelZ) override
 	{
@@ -32,6 +32,10 @@ public:
 	Note that the coords are chunk-relative! */
 	virtual void OnUpdate(cChunkInterface & cChunkInterface, cWorldInterface & a_WorldInterface, cBlockPluginInterface & a_BlockPluginInterface, cChunk & a_Chunk, int a_RelX, int a_RelY, int a_RelZ);
 
+	/** Returns true if OnUpdate() does anything for this block type, so that it is worth spending random ticks on.
+	The chunks count such blocks in each section and only tick the sections that have any. */
+	virtual bool IsRandomTickable(void) const { return false; }
+
 	/** Returns the relative bounding box that must be entity-free in
 	order for the block to be placed. a_XM, a_XP, etc. stand for the
 	blocktype of the minus-X neighbor, the positive-X neighbor, etc. */
@@ -26,13 +26,18 @@ void cBroadcaster::BroadcastParticleEffect(const AString & a_ParticleName, const
 	m_World->DoWithChunkAt(a_Src,
 		[=](cChunk & a_Chunk) -> bool
 		{
+			cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+				{
+					a_Client.SendParticleEffect(a_ParticleName, a_Src.x, a_Src.y, a_Src.z, a_Offset.x, a_Offset.y, a_Offset.z, a_ParticleData, a_ParticleAmount);
+				}
+			);
 			for (auto && client : a_Chunk.GetAllClients())
 			{
 				if (client == a_Exclude)
 				{
 					continue;
 				}
-				client->SendParticleEffect(a_ParticleName, a_Src.x, a_Src.y, a_Src.z, a_Offset.x, a_Offset.y, a_Offset.z, a_ParticleData, a_ParticleAmount);
+				Broadcast.SendTo(*client);
 			};
 			return true;
 		});
@@ -47,14 +52,66 @@ void cBroadcaster::BroadcastParticleEffect(const AString & a_ParticleName, const
 	m_World->DoWithChunkAt(a_Src,
 		[=](cChunk & a_Chunk) -> bool
 		{
+			cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+				{
+					a_Client.SendParticleEffect(a_ParticleName, a_Src, a_Offset, a_ParticleData, a_ParticleAmount, a_Data);
+				}
+			);
 			for (auto && client : a_Chunk.GetAllClients())
 			{
 				if (client == a_Exclude)
 				{
 					continue;
 				}
-				client->SendParticleEffect(a_ParticleName, a_Src, a_Offset, a_ParticleData, a_ParticleAmount, a_Data);
+				Broadcast.SendTo(*client);
 			};
 			return true;
 		});
 }
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cSharedBroadcast:
+
+cSharedBroadcast::cSharedBroadcast(cSendFn a_SendFn):
+	m_SendFn(std::move(a_SendFn))
+{
+}
+
+
+
+
+
+void cSharedBroadcast::SendTo(cClientHandle & a_Client)
+{
+	UInt32 Key = a_Client.GetBroadcastKey();
+	if (Key == 0)
+	{
+		// The client can't share the packets:
+		m_SendFn(a_Client);
+		return;
+	}
+
+	for (const auto & Encoded: m_Encoded)
+	{
+		if (Encoded.first == Key)
+		{
+			a_Client.SendEncodedBroadcast(Encoded.second);
+			return;
+		}
+	}
+
+	// First client with this encoding, serialize the packets through it:
+	m_Encoded.emplace_back(Key, a_Client.EncodeBroadcast([this, &a_Client]()
+		{
+			m_SendFn(a_Client);
+		}
+	));
+}
+
+
+
+
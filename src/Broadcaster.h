@@ -1,5 +1,11 @@
 
+#pragma once
+
+#include <functional>
+#include "OSSupport/SendChain.h"
+
 class cWorld;
+class cClientHandle;
 
 class cBroadcaster
 {
@@ -16,3 +22,36 @@ private:
 	cWorld * m_World;
 
 };
+
+
+
+
+
+/** Sends the same packets to many clients, serializing and compressing them only once for each group of clients
+that share the packet encoding (protocol version and compression state). Only the encryption runs per client.
+The send function must not depend on the recipient beyond its protocol, and must not have any client-side
+effects other than sending, because it only runs for the first client of each group. */
+class cSharedBroadcast
+{
+public:
+
+	typedef std::function<void(cClientHandle &)> cSendFn;
+
+	cSharedBroadcast(cSendFn a_SendFn);
+
+	/** Sends the packets to the client, reusing the packets encoded for a previous client with the same encoding. */
+	void SendTo(cClientHandle & a_Client);
+
+protected:
+
+	/** Sends the packets to a single client through the regular per-client path. */
+	cSendFn m_SendFn;
+
+	/** The packets encoded so far, with the broadcast key of the clients that can use them.
+	There are only ever a few different keys, so a linear search is the fastest. */
+	std::vector<std::pair<UInt32, cSendChain::cSlicePtr>> m_Encoded;
+};
+
+
+
+
@@ -6,6 +6,7 @@
 #include "Globals.h"
 
 #include "ByteBuffer.h"
+#include "ByteView.h"
 #include "Endianness.h"
 #include "UUID.h"
 #include "OSSupport/IsThread.h"
@@ -395,10 +396,34 @@ bool cByteBuffer::ReadVarInt32(UInt32 & a_Value)
 	CheckValid();
 	UInt32 Value = 0;
 	int Shift = 0;
+
+	// Fast path: decode straight from the storage if the whole VarInt is in the contiguous part of the data:
+	const Byte * Src = reinterpret_cast<const Byte *>(m_Buffer + m_ReadPos);
+	size_t Contiguous = GetContiguousReadableSpace();
+	for (size_t i = 0; i < Contiguous; i++)
+	{
+		Value = Value | ((static_cast<UInt32>(Src[i] & 0x7f)) << Shift);
+		Shift += 7;
+		if ((Src[i] & 0x80) == 0)
+		{
+			AdvanceReadPos(i + 1);
+			a_Value = Value;
+			return true;
+		}
+	}
+
+	// The VarInt is incomplete or wraps around the ringbuffer end, read it byte by byte:
+	Value = 0;
+	Shift = 0;
+	size_t ReadPos = m_ReadPos;
 	unsigned char b = 0;
 	do
 	{
-		NEEDBYTES(1);
+		if (!CanReadBytes(1))
+		{
+			m_ReadPos = ReadPos;
+			return false;
+		}
 		ReadBuf(&b, 1);
 		Value = Value | ((static_cast<UInt32>(b & 0x7f)) << Shift);
 		Shift += 7;
@@ -417,10 +442,34 @@ bool cByteBuffer::ReadVarInt64(UInt64 & a_Value)
 	CheckValid();
 	UInt64 Value = 0;
 	int Shift = 0;
+
+	// Fast path: decode straight from the storage if the whole VarInt is in the contiguous part of the data:
+	const Byte * Src = reinterpret_cast<const Byte *>(m_Buffer + m_ReadPos);
+	size_t Contiguous = GetContiguousReadableSpace();
+	for (size_t i = 0; i < Contiguous; i++)
+	{
+		Value = Value | ((static_cast<UInt64>(Src[i] & 0x7f)) << Shift);
+		Shift += 7;
+		if ((Src[i] & 0x80) == 0)
+		{
+			AdvanceReadPos(i + 1);
+			a_Value = Value;
+			return true;
+		}
+	}
+
+	// The VarInt is incomplete or wraps around the ringbuffer end, read it byte by byte:
+	Value = 0;
+	Shift = 0;
+	size_t ReadPos = m_ReadPos;
 	unsigned char b = 0;
 	do
 	{
-		NEEDBYTES(1);
+		if (!CanReadBytes(1))
+		{
+			m_ReadPos = ReadPos;
+			return false;
+		}
 		ReadBuf(&b, 1);
 		Value = Value | ((static_cast<UInt64>(b & 0x7f)) << Shift);
 		Shift += 7;
@@ -866,13 +915,12 @@ bool cByteBuffer::ReadToByteBuffer(cByteBuffer & a_Dst, size_t a_NumBytes)
 		// There's not enough source bytes or space in the dest BB
 		return false;
 	}
-	char buf[1024];
-	// > 0 without generating warnings about unsigned comparisons where size_t is unsigned
+	// Copy directly from the storage, at most two pieces (before and after the ringbuffer end):
 	while (a_NumBytes != 0)
 	{
-		size_t num = (a_NumBytes > sizeof(buf)) ? sizeof(buf) : a_NumBytes;
-		VERIFY(ReadBuf(buf, num));
-		VERIFY(a_Dst.Write(buf, num));
+		size_t num = std::min(a_NumBytes, GetContiguousReadableSpace());
+		VERIFY(a_Dst.Write(m_Buffer + m_ReadPos, num));
+		AdvanceReadPos(num);
 		ASSERT(a_NumBytes >= num);
 		a_NumBytes -= num;
 	}
@@ -883,6 +931,31 @@ bool cByteBuffer::ReadToByteBuffer(cByteBuffer & a_Dst, size_t a_NumBytes)
 
 
 
+cByteView cByteBuffer::GetReadView(void) const
+{
+	CHECK_THREAD
+	CheckValid();
+	ASSERT(GetContiguousReadableSpace() == GetReadableSpace());
+	return cByteView(m_Buffer + m_ReadPos, GetContiguousReadableSpace());
+}
+
+
+
+
+
+void cByteBuffer::Clear(void)
+{
+	CHECK_THREAD
+	CheckValid();
+	m_DataStart = 0;
+	m_WritePos = 0;
+	m_ReadPos = 0;
+}
+
+
+
+
+
 void cByteBuffer::CommitRead(void)
 {
 	CHECK_THREAD
@@ -942,6 +1015,21 @@ void cByteBuffer::AdvanceReadPos(size_t a_Count)
 
 
 
+size_t cByteBuffer::GetContiguousReadableSpace(void) const
+{
+	if (m_ReadPos > m_WritePos)
+	{
+		// The data wraps around the buffer end, only the part up to the end is contiguous:
+		ASSERT(m_BufferSize >= m_ReadPos);
+		return m_BufferSize - m_ReadPos;
+	}
+	return m_WritePos - m_ReadPos;
+}
+
+
+
+
+
 void cByteBuffer::CheckValid(void) const
 {
 	ASSERT(m_ReadPos < m_BufferSize);
@@ -13,6 +13,7 @@
 
 // fwd:
 class cUUID;
+class cByteView;
 
 
 /** An object that can store incoming bytes and lets its clients read the bytes sequentially
@@ -44,6 +45,9 @@ public:
 	/** Returns the number of bytes that are currently available for reading (may be less than UsedSpace due to some data having been read already) */
 	size_t GetReadableSpace(void) const;
 
+	/** Returns the capacity of the buffer, the size it was created with. */
+	size_t GetBufferSize(void) const { return m_BufferSize - 1; }
+
 	/** Returns the current data start index. For debugging purposes. */
 	size_t  GetDataStart(void) const { return m_DataStart; }
 
@@ -120,6 +124,14 @@ public:
 	/** Reads the specified number of bytes and writes it into the destinatio bytebuffer. Returns true on success. */
 	bool ReadToByteBuffer(cByteBuffer & a_Dst, size_t a_NumBytes);
 
+	/** Returns a view of the data available for reading, without copying it.
+	The data must not wrap around the ringbuffer end, which is the case for a buffer written only once since created or cleared,
+	such as a single packet's buffer. The view doesn't move the read position; use SkipRead() with the view's GetReadSize() for that. */
+	cByteView GetReadView(void) const;
+
+	/** Removes all the data from the ringbuffer, so that it can be reused for different data */
+	void Clear(void);
+
 	/** Removes the bytes that have been read from the ringbuffer */
 	void CommitRead(void);
 
@@ -149,6 +161,9 @@ protected:
 		mutable std::thread::id m_ThreadID;
 	#endif
 
+	/** Returns the number of bytes that can be read from m_ReadPos without wrapping around the ringbuffer end */
+	size_t GetContiguousReadableSpace(void) const;
+
 	/** Advances the m_ReadPos by a_Count bytes */
 	void AdvanceReadPos(size_t a_Count);
 } ;
@@ -0,0 +1,199 @@
+
+// ByteView.h
+
+// Declares the cByteView class representing a read-only view of contiguous bytes, such as a single decoded packet
+
+/*
+cByteBuffer is a ringbuffer: each of its reads needs to check the readable space, which is computed from the
+read, write and start positions, and to handle the data wrapping around the buffer end. A packet decoded by
+cPacketDecoder is written into a buffer of its own from the start, so it never wraps. The packet handlers that
+run the most (the player's movement) read such packets through a cByteView over the packet's data instead:
+the bytes aren't copied, a read is a single compare against the end of the view and a load from the memory,
+and any strings or blobs can be referenced in place.
+
+The view doesn't own the data; the data must stay valid and unchanged for the lifetime of the view.
+*/
+
+
+
+
+
+#pragma once
+
+#include "Endianness.h"
+
+
+
+
+
+class cByteView
+{
+public:
+
+	cByteView(const void * a_Data, size_t a_Size):
+		m_Data(static_cast<const char *>(a_Data)),
+		m_ReadPos(m_Data),
+		m_End(m_Data + a_Size)
+	{
+	}
+
+	/** Returns the number of bytes that haven't been read yet. */
+	size_t GetReadableSpace(void) const { return static_cast<size_t>(m_End - m_ReadPos); }
+
+	/** Returns the number of bytes read so far. */
+	size_t GetReadSize(void) const { return static_cast<size_t>(m_ReadPos - m_Data); }
+
+	/** Returns true if the specified amount of bytes are available for reading. */
+	bool CanReadBytes(size_t a_Count) const { return (a_Count <= GetReadableSpace()); }
+
+	// Read the specified datatype and advance the read pointer; return true if successfully read.
+	// Same names and semantics as in cByteBuffer, so that the packet handlers' HANDLE_READ macro works with both:
+	bool ReadBEInt8  (Int8 & a_Value)   { return ReadRaw(a_Value); }
+	bool ReadBEUInt8 (UInt8 & a_Value)  { return ReadRaw(a_Value); }
+	bool ReadBEInt16 (Int16 & a_Value)  { UInt16 v; if (!ReadRaw(v)) { return false; } a_Value = static_cast<Int16>(NetworkToHost2(&v)); return true; }
+	bool ReadBEUInt16(UInt16 & a_Value) { UInt16 v; if (!ReadRaw(v)) { return false; } a_Value = NetworkToHost2(&v); return true; }
+	bool ReadBEInt32 (Int32 & a_Value)  { UInt32 v; if (!ReadRaw(v)) { return false; } a_Value = static_cast<Int32>(NetworkToHost4(&v)); return true; }
+	bool ReadBEUInt32(UInt32 & a_Value) { UInt32 v; if (!ReadRaw(v)) { return false; } a_Value = NetworkToHost4(&v); return true; }
+	bool ReadBEInt64 (Int64 & a_Value)  { UInt64 v; if (!ReadRaw(v)) { return false; } a_Value = NetworkToHostLong8(&v); return true; }
+	bool ReadBEUInt64(UInt64 & a_Value) { UInt64 v; if (!ReadRaw(v)) { return false; } a_Value = NetworkToHostULong8(&v); return true; }
+	bool ReadBEFloat (float & a_Value)  { UInt32 v; if (!ReadRaw(v)) { return false; } a_Value = NetworkToHostFloat4(&v); return true; }
+	bool ReadBEDouble(double & a_Value) { UInt64 v; if (!ReadRaw(v)) { return false; } a_Value = NetworkToHostDouble8(&v); return true; }
+	bool ReadBool    (bool & a_Value)   { UInt8 v; if (!ReadRaw(v)) { return false; } a_Value = (v != 0); return true; }
+
+	bool ReadVarInt32(UInt32 & a_Value)
+	{
+		UInt64 Value;
+		if (!ReadVarInt64(Value))
+		{
+			return false;
+		}
+		a_Value = static_cast<UInt32>(Value);
+		return true;
+	}
+
+	bool ReadVarInt64(UInt64 & a_Value)
+	{
+		UInt64 Value = 0;
+		int Shift = 0;
+		// A VarInt has at most 10 bytes, anything longer is malformed:
+		for (const char * Pos = m_ReadPos; (Pos < m_End) && (Shift < 64); ++Pos)
+		{
+			Byte b = static_cast<Byte>(*Pos);
+			Value = Value | (static_cast<UInt64>(b & 0x7f) << Shift);
+			Shift += 7;
+			if ((b & 0x80) == 0)
+			{
+				m_ReadPos = Pos + 1;
+				a_Value = Value;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** Reads VarInt, assigns it to anything that can be assigned from an UInt64 (unsigned short, char, Byte, double, ...) */
+	template <typename T> bool ReadVarInt(T & a_Value)
+	{
+		UInt64 v;
+		if (!ReadVarInt64(v))
+		{
+			return false;
+		}
+		a_Value = static_cast<T>(v);
+		return true;
+	}
+
+	/** Reads the position encoded in 64 bits, same as cByteBuffer::ReadPosition64(). */
+	bool ReadPosition64(int & a_BlockX, int & a_BlockY, int & a_BlockZ)
+	{
+		Int64 Value;
+		if (!ReadBEInt64(Value))
+		{
+			return false;
+		}
+		UInt32 BlockXRaw = (Value >> 38) & 0x03ffffff;  // Top 26 bits
+		UInt32 BlockYRaw = (Value >> 26) & 0x0fff;      // Middle 12 bits
+		UInt32 BlockZRaw = (Value & 0x03ffffff);        // Bottom 26 bits
+		a_BlockX = ((BlockXRaw & 0x02000000) == 0) ? static_cast<int>(BlockXRaw) : -(0x04000000 - static_cast<int>(BlockXRaw));
+		a_BlockY = ((BlockYRaw & 0x0800) == 0)     ? static_cast<int>(BlockYRaw) : -(0x0800     - static_cast<int>(BlockYRaw));
+		a_BlockZ = ((BlockZRaw & 0x02000000) == 0) ? static_cast<int>(BlockZRaw) : -(0x04000000 - static_cast<int>(BlockZRaw));
+		return true;
+	}
+
+	/** Returns a pointer to the next a_Count bytes in a_Bytes, without copying them, and skips them.
+	Returns false if there aren't as many bytes left. */
+	bool ReadBytes(const char *& a_Bytes, size_t a_Count)
+	{
+		if (!CanReadBytes(a_Count))
+		{
+			return false;
+		}
+		a_Bytes = m_ReadPos;
+		m_ReadPos += a_Count;
+		return true;
+	}
+
+	/** Reads a string prefixed by its length as a VarInt, returning a pointer to its bytes in a_String, without copying them.
+	Returns false if the string is incomplete. */
+	bool ReadVarUTF8String(const char *& a_String, size_t & a_Size)
+	{
+		const char * Start = m_ReadPos;
+		UInt32 Size;
+		if (!ReadVarInt32(Size) || !ReadBytes(a_String, Size))
+		{
+			m_ReadPos = Start;
+			return false;
+		}
+		a_Size = Size;
+		return true;
+	}
+
+	/** Reads a string prefixed by its length as a VarInt into a_Value. Returns false if the string is incomplete. */
+	bool ReadVarUTF8String(AString & a_Value)
+	{
+		const char * String;
+		size_t Size;
+		if (!ReadVarUTF8String(String, Size))
+		{
+			return false;
+		}
+		a_Value.assign(String, Size);
+		return true;
+	}
+
+	/** Skips reading by a_Count bytes; returns false if there aren't as many bytes left. */
+	bool SkipRead(size_t a_Count)
+	{
+		const char * Bytes;
+		return ReadBytes(Bytes, a_Count);
+	}
+
+protected:
+
+	/** The start of the data viewed. */
+	const char * m_Data;
+
+	/** The next byte to be read. */
+	const char * m_ReadPos;
+
+	/** The end of the data viewed, one byte past the last one. */
+	const char * m_End;
+
+
+	/** Copies the raw bytes of the next value into a_Value and advances the read position.
+	The bytes are copied with memcpy, since the data isn't aligned. */
+	template <typename T> bool ReadRaw(T & a_Value)
+	{
+		if (!CanReadBytes(sizeof(T)))
+		{
+			return false;
+		}
+		memcpy(&a_Value, m_ReadPos, sizeof(T));
+		m_ReadPos += sizeof(T);
+		return true;
+	}
+} ;
+
+
+
+
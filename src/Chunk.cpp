@@ -10,6 +10,7 @@
 #include "World.h"
 #include "ClientHandle.h"
 #include "Server.h"
+#include "Broadcaster.h"
 #include "zlib/zlib.h"
 #include "Defines.h"
 #include "BlockEntities/BeaconEntity.h"
@@ -38,10 +39,13 @@
 #include "Simulator/FluidSimulator.h"
 #include "MobCensus.h"
 #include "MobSpawner.h"
+#include "LightUpdater.h"
+#include "TickProfiler.h"
 #include "BlockInServerPluginInterface.h"
 #include "SetChunkData.h"
 #include "BoundingBox.h"
 #include "Blocks/ChunkInterface.h"
+#include "Mobs/NavSection.h"
 
 #include "json/json.h"
 
@@ -49,6 +53,38 @@
 
 
 
+/** The number of block changes per tick in a single chunk that update the light incrementally.
+Past that, the chunk's light is invalidated and relit as a whole by the lighting thread, which is cheaper than as many
+incremental updates, each going through the 3x3 chunks around the change. */
+static const int MAX_INCREMENTAL_LIGHT_UPDATES_PER_TICK = 64;
+
+
+
+
+
+/** Returns the table of the block types that react to random ticks (cBlockInfo::IsRandomTickable()), 256 items.
+The lookup through cBlockInfo::Get() isn't free, the table is used for the loops over many blocks. */
+static const bool * GetRandomTickableBlockTypes(void)
+{
+	static const struct sRandomTickableBlockTypes
+	{
+		bool m_IsTickable[256];
+
+		sRandomTickableBlockTypes(void)
+		{
+			for (size_t i = 0; i < ARRAYCOUNT(m_IsTickable); i++)
+			{
+				m_IsTickable[i] = cBlockInfo::IsRandomTickable(static_cast<BLOCKTYPE>(i));
+			}
+		}
+	} RandomTickableBlockTypes;
+	return RandomTickableBlockTypes.m_IsTickable;
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // sSetBlock:
 
@@ -73,7 +109,8 @@ cChunk::cChunk(
 	int a_ChunkX, int a_ChunkZ,
 	cChunkMap * a_ChunkMap, cWorld * a_World,
 	cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP,
-	cAllocationPool<cChunkData::sChunkSection> & a_Pool
+	cAllocationPool<cChunkData::sChunkSection> & a_Pool, cAllocationPool<cChunkData::sSectionNibbles> & a_NibblePool,
+	cAllocationPool<cChunkData::sSectionBlockTypes> & a_BlockTypePool
 ) :
 	m_Presence(cpInvalid),
 	m_ShouldGenerateIfLoadFailed(false),
@@ -81,15 +118,19 @@ cChunk::cChunk(
 	m_IsDirty(false),
 	m_IsSaving(false),
 	m_HasLoadFailed(false),
+	m_LightUpdatesWorldAge(-1),
+	m_NumLightUpdates(0),
+	m_HasEntitiesToMove(false),
 	m_StayCount(0),
 	m_PosX(a_ChunkX),
 	m_PosZ(a_ChunkZ),
 	m_World(a_World),
 	m_ChunkMap(a_ChunkMap),
-	m_ChunkData(a_Pool),
+	m_ChunkData(a_Pool, a_NibblePool, a_BlockTypePool),
 	m_BlockTickX(0),
 	m_BlockTickY(0),
 	m_BlockTickZ(0),
+	m_IsNextBlockTickSet(false),
 	m_NeighborXM(a_NeighborXM),
 	m_NeighborXP(a_NeighborXP),
 	m_NeighborZM(a_NeighborZM),
@@ -99,6 +140,8 @@ cChunk::cChunk(
 	m_RedstoneSimulatorData(a_World->GetRedstoneSimulator()->CreateChunkData()),
 	m_AlwaysTicked(0)
 {
+	memset(m_NumRandomTickableBlocks, 0, sizeof(m_NumRandomTickableBlocks));
+
 	if (a_NeighborXM != nullptr)
 	{
 		a_NeighborXM->m_NeighborXP = this;
@@ -136,6 +179,7 @@ cChunk::~cChunk()
 	// Remove and destroy all entities that are not players:
 	cEntityList Entities;
 	std::swap(Entities, m_Entities);  // Need another list because cEntity destructors check if they've been removed from chunk
+	m_EntityIndex.Clear();
 	for (auto & Entity : Entities)
 	{
 		if (!Entity->IsPlayer())
@@ -324,6 +368,11 @@ void cChunk::SetAllData(cSetChunkData & a_SetChunkData)
 
 	m_ChunkData.SetBlockTypes(a_SetChunkData.GetBlockTypes());
 	m_ChunkData.SetMetas(a_SetChunkData.GetBlockMetas());
+	CountRandomTickableBlocks();
+	for (auto & NavSection : m_NavSections)
+	{
+		NavSection.reset();
+	}
 	if (a_SetChunkData.IsLightValid())
 	{
 		m_ChunkData.SetBlockLight(a_SetChunkData.GetBlockLight());
@@ -366,6 +415,9 @@ void cChunk::SetAllData(cSetChunkData & a_SetChunkData)
 	// Set the chunk data as valid. This may be needed for some simulators that perform actions upon block adding (Vaporize)
 	SetPresence(cpPresent);
 
+	// All the blocks have changed, the redstone simulator needs to drop any topology it has cached in and around the chunk:
+	m_World->GetRedstoneSimulator()->ChunkBlocksSet(*this);
+
 	// Wake up all simulators for their respective blocks:
 	WakeUpSimulators();
 
@@ -429,6 +481,9 @@ void cChunk::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlock
 	int BaseZ = BlockStartZ - a_MinBlockZ;
 
 	// Copy blocktype and blockmeta:
+	// The whole chunk is relit afterwards rather than updating the light for each block written:
+	m_IsLightValid = false;
+
 	BLOCKTYPE *  AreaBlockTypes = a_Area.GetBlockTypes();
 	NIBBLETYPE * AreaBlockMetas = a_Area.GetBlockMetas();
 	for (int y = 0; y < SizeY; y++)
@@ -656,6 +711,19 @@ void cChunk::SpawnMobs(cMobSpawner & a_MobSpawner)
 
 
 
+void cChunk::PrepareTick(void)
+{
+	// Drop the blocks left over if the chunk got invalidated before its last tick got to them:
+	m_RandomTickBlocks.clear();
+
+	// Pick the random blocks in each section, skipping the sections that have nothing that would react:
+	m_ChunkData.PickRandomBlocks(GetRandomTickableBlockTypes(), m_NumRandomTickableBlocks, m_World->GetRandomTickSpeed(), m_RandomTickBlocks);
+}
+
+
+
+
+
 void cChunk::Tick(std::chrono::milliseconds a_Dt)
 {
 	// If we are not valid, tick players and bailout
@@ -671,6 +739,8 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 		return;
 	}
 
+	cTickProfiler::cScope ProfilerScope(cTickProfiler::catChunk, "Chunk", m_PosX, m_PosZ);
+
 	BroadcastPendingBlockChanges();
 
 	CheckBlocks();
@@ -683,26 +753,54 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 	// Tick all block entities in this chunk:
 	for (auto & KeyPair : m_BlockEntities)
 	{
+		cTickProfiler::cScope Scope(cTickProfiler::catBlockEntity, KeyPair.second->GetClass());
 		m_IsDirty = KeyPair.second->Tick(a_Dt, *this) | m_IsDirty;
 	}
 
-	for (auto itr = m_Entities.begin(); itr != m_Entities.end();)
+	for (const auto & Entity : m_Entities)
 	{
 		// Do not tick mobs that are detached from the world. They're either scheduled for teleportation or for removal.
-		if (!(*itr)->IsTicking())
+		if (!Entity->IsTicking())
 		{
-			++itr;
 			continue;
 		}
 
-		if (!((*itr)->IsMob()))  // Mobs are ticked inside cWorld::TickMobs() (as we don't have to tick them if they are far away from players)
+		if (!Entity->IsMob())  // Mobs are ticked inside cWorld::TickMobs() (as we don't have to tick them if they are far away from players)
 		{
 			// Tick all entities in this chunk (except mobs):
-			ASSERT((*itr)->GetParentChunk() == this);
-			(*itr)->Tick(a_Dt, *this);
-			ASSERT((*itr)->GetParentChunk() == this);
+			cTickProfiler::cScope Scope(cTickProfiler::catEntity, Entity->GetClass());
+			ASSERT(Entity->GetParentChunk() == this);
+			Entity->Tick(a_Dt, *this);
+			ASSERT(Entity->GetParentChunk() == this);
 		}
 
+		// The entity may have changed its height, either in its tick or since the last one (mobs, plugins):
+		m_EntityIndex.Update(*Entity);
+
+		// The entities that left the chunk are moved to their new chunks by MoveEntitiesToNewChunks(), once the whole chunkmap has been ticked
+		if ((Entity->GetChunkX() != m_PosX) || (Entity->GetChunkZ() != m_PosZ))
+		{
+			m_HasEntitiesToMove = true;
+		}
+	}  // for Entity - m_Entitites[]
+
+	ApplyWeatherToTop();
+}
+
+
+
+
+
+void cChunk::MoveEntitiesToNewChunks(void)
+{
+	if (!m_HasEntitiesToMove)
+	{
+		return;
+	}
+	m_HasEntitiesToMove = false;
+
+	for (auto itr = m_Entities.begin(); itr != m_Entities.end();)
+	{
 		// Do not move mobs that are detached from the world to neighbors. They're either scheduled for teleportation or for removal.
 		// Because the schedulded destruction is going to look for them in this chunk. See cEntity::destroy.
 		if (!(*itr)->IsTicking())
@@ -724,6 +822,7 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 
 			// This block is very similar to RemoveEntity, except it uses an iterator to avoid scanning the whole m_Entities
 			// The entity moved out of the chunk, move it to the neighbor
+			m_EntityIndex.Remove(**itr);
 			(*itr)->SetParentChunk(nullptr);
 			MoveEntityToNewChunk(std::move(*itr));
 
@@ -734,8 +833,6 @@ void cChunk::Tick(std::chrono::milliseconds a_Dt)
 			++itr;
 		}
 	}  // for itr - m_Entitites[]
-
-	ApplyWeatherToTop();
 }
 
 
@@ -857,43 +954,143 @@ void cChunk::CheckBlocks()
 
 void cChunk::TickBlocks(void)
 {
-	// Tick dem blocks
-	// _X: We must limit the random number or else we get a nasty int overflow bug - https://forum.cuberite.org/thread-457.html
-	int RandomX = m_World->GetTickRandomNumber(0x00ffffff);
-	int RandomY = m_World->GetTickRandomNumber(0x00ffffff);
-	int RandomZ = m_World->GetTickRandomNumber(0x00ffffff);
-	int TickX = m_BlockTickX;
-	int TickY = m_BlockTickY;
-	int TickZ = m_BlockTickZ;
-
 	cChunkInterface ChunkInterface(this->GetWorld()->GetChunkMap());
 	cBlockInServerPluginInterface PluginInterface(*this->GetWorld());
 
-	// This for loop looks disgusting, but it actually does a simple thing - first processes m_BlockTick, then adds random to it
-	// This is so that SetNextBlockTick() works
-	for (int i = 0; i < 50; i++,
+	// First tick the block requested by SetNextBlockTick(), regardless of its type:
+	if (m_IsNextBlockTickSet)
+	{
+		m_IsNextBlockTickSet = false;
+		cBlockHandler * Handler = BlockHandler(GetBlock(m_BlockTickX, m_BlockTickY, m_BlockTickZ));
+		ASSERT(Handler != nullptr);  // Happenned on server restart, FS #243
+		Handler->OnUpdate(ChunkInterface, *this->GetWorld(), PluginInterface, *this, m_BlockTickX, m_BlockTickY, m_BlockTickZ);
+	}
+
+	// Tick the random blocks picked by PrepareTick(); the blocks ticked before may have changed them since:
+	for (const auto & Pos : m_RandomTickBlocks)
+	{
+		BLOCKTYPE BlockType = GetBlock(Pos);
+		if (!cBlockInfo::IsRandomTickable(BlockType))
+		{
+			continue;
+		}
+		cBlockHandler * Handler = BlockHandler(BlockType);
+		ASSERT(Handler != nullptr);
+		Handler->OnUpdate(ChunkInterface, *this->GetWorld(), PluginInterface, *this, Pos.x, Pos.y, Pos.z);
+	}  // for Pos - m_RandomTickBlocks[]
+	m_RandomTickBlocks.clear();
+}
+
 
-		// This weird construct (*2, then /2) is needed,
-		// otherwise the blocktick distribution is too biased towards even coords!
 
-		TickX = (TickX + RandomX) % (Width * 2),
-		TickY = (TickY + RandomY) % (Height * 2),
-		TickZ = (TickZ + RandomZ) % (Width * 2),
-		m_BlockTickX = TickX / 2,
-		m_BlockTickY = TickY / 2,
-		m_BlockTickZ = TickZ / 2
-	)
+
+
+void cChunk::CountRandomTickableBlocks(void)
+{
+	const bool * IsTickable = GetRandomTickableBlockTypes();
+	for (size_t SectionNum = 0; SectionNum < cChunkData::NumSections; SectionNum++)
 	{
+		UInt16 NumTickable = 0;
+		const cChunkData::sChunkSection * Section = m_ChunkData.GetSection(SectionNum);
+		if (Section != nullptr)  // All-air sections are not stored
+		{
+			BLOCKTYPE Buffer[cChunkData::SectionBlockCount];
+			const BLOCKTYPE * BlockTypes = Section->GetBlockTypes(Buffer);
+			for (size_t i = 0; i < cChunkData::SectionBlockCount; i++)
+			{
+				if (IsTickable[BlockTypes[i]])
+				{
+					NumTickable += 1;
+				}
+			}
+		}
+		m_NumRandomTickableBlocks[SectionNum] = NumTickable;
+	}
+}
+
+
+
 
-		if (m_BlockTickY > cChunkDef::GetHeight(m_HeightMap, m_BlockTickX, m_BlockTickZ))
+
+const cNavSection & cChunk::GetNavSection(size_t a_SectionNum, const bool * a_IsSolid)
+{
+	ASSERT(a_SectionNum < cChunkData::NumSections);
+	auto & NavSection = m_NavSections[a_SectionNum];
+	if (NavSection == nullptr)
+	{
+		// All-air sections are not stored; the sections below the bottom and above the top are considered air, too.
+		// The sections not stored as the plain array are unpacked into the buffers:
+		BLOCKTYPE Buffers[3][cChunkData::SectionBlockCount];
+		auto GetBlockTypes = [this, &Buffers](size_t a_Num, size_t a_BufferIdx) -> const BLOCKTYPE *
 		{
-			continue;  // It's all air up here
+			const cChunkData::sChunkSection * Section = (a_Num < cChunkData::NumSections) ? m_ChunkData.GetSection(a_Num) : nullptr;
+			return (Section == nullptr) ? nullptr : Section->GetBlockTypes(Buffers[a_BufferIdx]);
+		};
+		NavSection = cpp14::make_unique<cNavSection>(
+			(a_SectionNum > 0) ? GetBlockTypes(a_SectionNum - 1, 0) : nullptr,
+			GetBlockTypes(a_SectionNum, 1),
+			GetBlockTypes(a_SectionNum + 1, 2),
+			a_IsSolid
+		);
+	}
+	return *NavSection;
+}
+
+
+
+
+
+void cChunk::UpdateLightAround(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_OldBlockType)
+{
+	cChunk * Chunks[3][3];
+	cChunkData * ChunkDatas[3][3];
+	for (int x = 0; x < 3; x++)
+	{
+		for (int z = 0; z < 3; z++)
+		{
+			int RelX = (x - 1) * cChunkDef::Width;
+			int RelZ = (z - 1) * cChunkDef::Width;
+			cChunk * Chunk = GetRelNeighborChunkAdjustCoords(RelX, RelZ);
+			if ((Chunk == nullptr) || !Chunk->IsValid() || !Chunk->IsLightValid())
+			{
+				Chunk = nullptr;
+			}
+			Chunks[x][z] = Chunk;
+			ChunkDatas[x][z] = (Chunk == nullptr) ? nullptr : &Chunk->m_ChunkData;
+		}  // for z
+	}  // for x
+
+	cLightUpdater Updater(ChunkDatas);
+	Updater.BlockChanged(a_RelX, a_RelY, a_RelZ, a_OldBlockType);
+	for (int x = 0; x < 3; x++)
+	{
+		for (int z = 0; z < 3; z++)
+		{
+			if (Updater.HasChanged(x, z))
+			{
+				Chunks[x][z]->MarkDirty();
+			}
 		}
+	}
+}
 
-		cBlockHandler * Handler = BlockHandler(GetBlock(m_BlockTickX, m_BlockTickY, m_BlockTickZ));
-		ASSERT(Handler != nullptr);  // Happenned on server restart, FS #243
-		Handler->OnUpdate(ChunkInterface, *this->GetWorld(), PluginInterface, *this, m_BlockTickX, m_BlockTickY, m_BlockTickZ);
-	}  // for i - tickblocks
+
+
+
+
+void cChunk::InvalidateNavSections(int a_RelY)
+{
+	size_t SectionNum = static_cast<size_t>(a_RelY / cChunkData::SectionHeight);
+	m_NavSections[SectionNum].reset();
+	int RelY = a_RelY % cChunkData::SectionHeight;
+	if ((RelY == 0) && (SectionNum > 0))
+	{
+		m_NavSections[SectionNum - 1].reset();
+	}
+	else if ((RelY == cChunkData::SectionHeight - 1) && (SectionNum + 1 < cChunkData::NumSections))
+	{
+		m_NavSections[SectionNum + 1].reset();
+	}
 }
 
 
@@ -1679,6 +1876,26 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 
 	m_ChunkData.SetBlock(a_RelX, a_RelY, a_RelZ, a_BlockType);
 
+	// Keep the random tick counts and the nav sections up to date:
+	if (OldBlockType != a_BlockType)
+	{
+		auto & NumTickable = m_NumRandomTickableBlocks[a_RelY / cChunkData::SectionHeight];
+		if (cBlockInfo::IsRandomTickable(OldBlockType))
+		{
+			ASSERT(NumTickable > 0);
+			NumTickable -= 1;
+		}
+		if (cBlockInfo::IsRandomTickable(a_BlockType))
+		{
+			NumTickable += 1;
+		}
+
+		InvalidateNavSections(a_RelY);
+
+		// Let the redstone simulator drop any topology it has cached around the block:
+		m_World->GetRedstoneSimulator()->BlockTypeChanged(PositionToWorldPosition(a_RelX, a_RelY, a_RelZ), *this);
+	}
+
 	// Queue block to be sent only if ...
 	if (
 		a_SendToClients &&                  // ... we are told to do so AND ...
@@ -1702,10 +1919,27 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 	if (
 		(cBlockInfo::GetLightValue        (OldBlockType) != cBlockInfo::GetLightValue        (a_BlockType)) ||
 		(cBlockInfo::GetSpreadLightFalloff(OldBlockType) != cBlockInfo::GetSpreadLightFalloff(a_BlockType)) ||
-		(cBlockInfo::IsTransparent        (OldBlockType) != cBlockInfo::IsTransparent        (a_BlockType))
+		(cBlockInfo::IsTransparent        (OldBlockType) != cBlockInfo::IsTransparent        (a_BlockType)) ||
+		(cBlockInfo::IsSkylightDispersant (OldBlockType) != cBlockInfo::IsSkylightDispersant (a_BlockType))
 	)
 	{
-		m_IsLightValid = false;
+		// If the light is already valid, update just the area affected by this block; otherwise the whole chunk will be lit later anyway.
+		// Too many changes in a single tick make the whole chunk relit, too:
+		Int64 WorldAge = m_World->GetWorldAge();
+		if (m_LightUpdatesWorldAge != WorldAge)
+		{
+			m_LightUpdatesWorldAge = WorldAge;
+			m_NumLightUpdates = 0;
+		}
+		if (m_IsLightValid && (m_NumLightUpdates < MAX_INCREMENTAL_LIGHT_UPDATES_PER_TICK))
+		{
+			m_NumLightUpdates += 1;
+			UpdateLightAround(a_RelX, a_RelY, a_RelZ, OldBlockType);
+		}
+		else
+		{
+			m_IsLightValid = false;
+		}
 	}
 
 	// Update heightmap, if needed:
@@ -1847,6 +2081,7 @@ bool cChunk::UseBlockEntity(cPlayer * a_Player, int a_X, int a_Y, int a_Z)
 void cChunk::SetBiomeAt(int a_RelX, int a_RelZ, EMCSBiome a_Biome)
 {
 	cChunkDef::SetBiome(m_BiomeMap, a_RelX, a_RelZ, a_Biome);
+	m_ChunkData.MarkChanged();  // Biomes are a part of the serialized chunk data
 	MarkDirty();
 }
 
@@ -1863,6 +2098,7 @@ void cChunk::SetAreaBiome(int a_MinRelX, int a_MaxRelX, int a_MinRelZ, int a_Max
 			cChunkDef::SetBiome(m_BiomeMap, x, z, a_Biome);
 		}
 	}
+	m_ChunkData.MarkChanged();  // Biomes are a part of the serialized chunk data
 	MarkDirty();
 
 	// Re-send the chunk to all clients:
@@ -1882,42 +2118,31 @@ void cChunk::CollectPickupsByPlayer(cPlayer & a_Player)
 	double PosY = a_Player.GetPosY();
 	double PosZ = a_Player.GetPosZ();
 
-	for (auto & Entity : m_Entities)
-	{
-		if ((!Entity->IsPickup()) && (!Entity->IsProjectile()))
-		{
-			continue;  // Only pickups and projectiles can be picked up
-		}
-		float DiffX = static_cast<float>(Entity->GetPosX() - PosX);
-		float DiffY = static_cast<float>(Entity->GetPosY() - PosY);
-		float DiffZ = static_cast<float>(Entity->GetPosZ() - PosZ);
-		float SqrDist = DiffX * DiffX + DiffY * DiffY + DiffZ * DiffZ;
-		if (SqrDist < 1.5f * 1.5f)  // 1.5 block
+	m_EntityIndex.ForEachAroundHeight(PosY - 1.5, PosY + 1.5, [&](cEntity & a_Entity)
 		{
-			/*
-			LOG("Pickup %d being collected by player \"%s\", distance %f",
-				(*itr)->GetUniqueID(), a_Player->GetName().c_str(), SqrDist
-			);
-			*/
-			MarkDirty();
-			if (Entity->IsPickup())
+			if ((!a_Entity.IsPickup()) && (!a_Entity.IsProjectile()))
 			{
-				reinterpret_cast<cPickup *>(Entity.get())->CollectedBy(a_Player);
+				return false;  // Only pickups and projectiles can be picked up
 			}
-			else
+			float DiffX = static_cast<float>(a_Entity.GetPosX() - PosX);
+			float DiffY = static_cast<float>(a_Entity.GetPosY() - PosY);
+			float DiffZ = static_cast<float>(a_Entity.GetPosZ() - PosZ);
+			float SqrDist = DiffX * DiffX + DiffY * DiffY + DiffZ * DiffZ;
+			if (SqrDist < 1.5f * 1.5f)  // 1.5 block
 			{
-				reinterpret_cast<cProjectileEntity *>(Entity.get())->CollectedBy(a_Player);
+				MarkDirty();
+				if (a_Entity.IsPickup())
+				{
+					static_cast<cPickup &>(a_Entity).CollectedBy(a_Player);
+				}
+				else
+				{
+					static_cast<cProjectileEntity &>(a_Entity).CollectedBy(a_Player);
+				}
 			}
+			return false;
 		}
-		else if (SqrDist < 5 * 5)
-		{
-			/*
-			LOG("Pickup %d close to player \"%s\", but still too far to collect: %f",
-				(*itr)->GetUniqueID(), a_Player->GetName().c_str(), SqrDist
-			);
-			*/
-		}
-	}
+	);
 }
 
 
@@ -2054,6 +2279,17 @@ void cChunk::AddEntity(OwnedEntity a_Entity)
 
 	ASSERT(EntityPtr->GetParentChunk() == nullptr);
 	EntityPtr->SetParentChunk(this);
+	m_EntityIndex.Add(*EntityPtr);
+}
+
+
+
+
+
+void cChunk::UpdateEntityIndex(cEntity & a_Entity)
+{
+	ASSERT(a_Entity.GetParentChunk() == this);
+	m_EntityIndex.Update(a_Entity);
 }
 
 
@@ -2064,6 +2300,7 @@ OwnedEntity cChunk::RemoveEntity(cEntity & a_Entity)
 {
 	ASSERT(a_Entity.GetParentChunk() == this);
 	ASSERT(!a_Entity.IsTicking());
+	m_EntityIndex.Remove(a_Entity);
 	a_Entity.SetParentChunk(nullptr);
 
 	// Mark as dirty if it was a server-generated entity:
@@ -2135,24 +2372,21 @@ bool cChunk::ForEachEntity(cEntityCallback a_Callback)
 bool cChunk::ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback a_Callback)
 {
 	// The entity list is locked by the parent chunkmap's CS
-	for (const auto & Entity : m_Entities)
-	{
-		if (!Entity->IsTicking())
-		{
-			continue;
-		}
-		cBoundingBox EntBox(Entity->GetPosition(), Entity->GetWidth() / 2, Entity->GetHeight());
-		if (!EntBox.DoesIntersect(a_Box))
+	return m_EntityIndex.ForEachAroundHeight(a_Box.GetMinY(), a_Box.GetMaxY(), [&](cEntity & a_Entity)
 		{
-			// The entity is not in the specified box
-			continue;
-		}
-		if (a_Callback(*Entity))
-		{
-			return false;
+			if (!a_Entity.IsTicking())
+			{
+				return false;
+			}
+			cBoundingBox EntBox(a_Entity.GetPosition(), a_Entity.GetWidth() / 2, a_Entity.GetHeight());
+			if (!EntBox.DoesIntersect(a_Box))
+			{
+				// The entity is not in the specified box
+				return false;
+			}
+			return a_Callback(a_Entity);
 		}
-	}  // for itr - m_Entitites[]
-	return true;
+	);
 }
 
 
@@ -2700,13 +2934,18 @@ void cChunk::BroadcastUnleashEntity(const cEntity & a_Entity)
 
 void cChunk::BroadcastBlockAction(Vector3i a_BlockPos, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendBlockAction(a_BlockPos.x, a_BlockPos.y, a_BlockPos.z, a_Byte1, a_Byte2, a_BlockType);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendBlockAction(a_BlockPos.x, a_BlockPos.y, a_BlockPos.z, a_Byte1, a_Byte2, a_BlockType);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2716,13 +2955,18 @@ void cChunk::BroadcastBlockAction(Vector3i a_BlockPos, char a_Byte1, char a_Byte
 
 void cChunk::BroadcastBlockBreakAnimation(UInt32 a_EntityID, Vector3i a_BlockPos, char a_Stage, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendBlockBreakAnim(a_EntityID, a_BlockPos.x, a_BlockPos.y, a_BlockPos.z, a_Stage);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendBlockBreakAnim(a_EntityID, a_BlockPos.x, a_BlockPos.y, a_BlockPos.z, a_Stage);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2798,13 +3042,18 @@ void cChunk::BroadcastDetachEntity(const cEntity & a_Entity, const cEntity & a_P
 
 void cChunk::BroadcastEntityEffect(const cEntity & a_Entity, int a_EffectID, int a_Amplifier, short a_Duration, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendEntityEffect(a_Entity, a_EffectID, a_Amplifier, a_Duration);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendEntityEffect(a_Entity, a_EffectID, a_Amplifier, a_Duration);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2814,13 +3063,18 @@ void cChunk::BroadcastEntityEffect(const cEntity & a_Entity, int a_EffectID, int
 
 void cChunk::BroadcastEntityEquipment(const cEntity & a_Entity, short a_SlotNum, const cItem & a_Item, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendEntityEquipment(a_Entity, a_SlotNum, a_Item);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendEntityEquipment(a_Entity, a_SlotNum, a_Item);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2830,13 +3084,18 @@ void cChunk::BroadcastEntityEquipment(const cEntity & a_Entity, short a_SlotNum,
 
 void cChunk::BroadcastEntityHeadLook(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendEntityHeadLook(a_Entity);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendEntityHeadLook(a_Entity);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2846,13 +3105,18 @@ void cChunk::BroadcastEntityHeadLook(const cEntity & a_Entity, const cClientHand
 
 void cChunk::BroadcastEntityLook(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendEntityLook(a_Entity);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendEntityLook(a_Entity);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2876,15 +3140,36 @@ void cChunk::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientHand
 
 
 
+void cChunk::BroadcastEntityMovement(const cEntity & a_Entity, const cClientHandle * a_Exclude)
+{
+	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
+	{
+		if (*itr == a_Exclude)
+		{
+			continue;
+		}
+		(*itr)->SendEntityMovement(a_Entity);
+	}  // for itr - LoadedByClient[]
+}
+
+
+
+
+
 void cChunk::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendEntityRelMove(a_Entity, a_RelX, a_RelY, a_RelZ);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendEntityRelMove(a_Entity, a_RelX, a_RelY, a_RelZ);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2894,13 +3179,18 @@ void cChunk::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char
 
 void cChunk::BroadcastEntityRelMoveLook(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendEntityRelMoveLook(a_Entity, a_RelX, a_RelY, a_RelZ);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendEntityRelMoveLook(a_Entity, a_RelX, a_RelY, a_RelZ);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2910,13 +3200,18 @@ void cChunk::BroadcastEntityRelMoveLook(const cEntity & a_Entity, char a_RelX, c
 
 void cChunk::BroadcastEntityStatus(const cEntity & a_Entity, char a_Status, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendEntityStatus(a_Entity, a_Status);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendEntityStatus(a_Entity, a_Status);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2942,13 +3237,18 @@ void cChunk::BroadcastEntityVelocity(const cEntity & a_Entity, const cClientHand
 
 void cChunk::BroadcastEntityAnimation(const cEntity & a_Entity, char a_Animation, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendEntityAnimation(a_Entity, a_Animation);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendEntityAnimation(a_Entity, a_Animation);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2958,13 +3258,18 @@ void cChunk::BroadcastEntityAnimation(const cEntity & a_Entity, char a_Animation
 
 void cChunk::BroadcastParticleEffect(const AString & a_ParticleName, float a_SrcX, float a_SrcY, float a_SrcZ, float a_OffsetX, float a_OffsetY, float a_OffsetZ, float a_ParticleData, int a_ParticleAmount, cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendParticleEffect(a_ParticleName, a_SrcX, a_SrcY, a_SrcZ, a_OffsetX, a_OffsetY, a_OffsetZ, a_ParticleData, a_ParticleAmount);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendParticleEffect(a_ParticleName, a_SrcX, a_SrcY, a_SrcZ, a_OffsetX, a_OffsetY, a_OffsetZ, a_ParticleData, a_ParticleAmount);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2974,13 +3279,18 @@ void cChunk::BroadcastParticleEffect(const AString & a_ParticleName, float a_Src
 
 void cChunk::BroadcastRemoveEntityEffect(const cEntity & a_Entity, int a_EffectID, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendRemoveEntityEffect(a_Entity, a_EffectID);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendRemoveEntityEffect(a_Entity, a_EffectID);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -2990,13 +3300,18 @@ void cChunk::BroadcastRemoveEntityEffect(const cEntity & a_Entity, int a_EffectI
 
 void cChunk::BroadcastSoundEffect(const AString & a_SoundName, Vector3d a_Position, float a_Volume, float a_Pitch, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendSoundEffect(a_SoundName, a_Position, a_Volume, a_Pitch);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendSoundEffect(a_SoundName, a_Position, a_Volume, a_Pitch);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -3006,13 +3321,18 @@ void cChunk::BroadcastSoundEffect(const AString & a_SoundName, Vector3d a_Positi
 
 void cChunk::BroadcastSoundParticleEffect(const EffectID a_EffectID, int a_SrcX, int a_SrcY, int a_SrcZ, int a_Data, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendSoundParticleEffect(a_EffectID, a_SrcX, a_SrcY, a_SrcZ, a_Data);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendSoundParticleEffect(a_EffectID, a_SrcX, a_SrcY, a_SrcZ, a_Data);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -3038,13 +3358,18 @@ void cChunk::BroadcastSpawnEntity(cEntity & a_Entity, const cClientHandle * a_Ex
 
 void cChunk::BroadcastThunderbolt(Vector3i a_BlockPos, const cClientHandle * a_Exclude)
 {
+	cSharedBroadcast Broadcast([&](cClientHandle & a_Client)
+		{
+			a_Client.SendThunderbolt(a_BlockPos.x, a_BlockPos.y, a_BlockPos.z);
+		}
+	);
 	for (auto itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
 	{
 		if (*itr == a_Exclude)
 		{
 			continue;
 		}
-		(*itr)->SendThunderbolt(a_BlockPos.x, a_BlockPos.y, a_BlockPos.z);
+		Broadcast.SendTo(**itr);
 	}  // for itr - LoadedByClient[]
 }
 
@@ -3,6 +3,7 @@
 
 #include "Entities/Entity.h"
 #include "ChunkData.h"
+#include "EntitySectionIndex.h"
 
 #include "Simulator/FireSimulator.h"
 #include "Simulator/SandSimulator.h"
@@ -36,6 +37,7 @@ class cFluidSimulatorData;
 class cMobCensus;
 class cMobSpawner;
 class cSetChunkData;
+class cNavSection;
 
 typedef std::list<cClientHandle *>                cClientHandleList;
 
@@ -63,7 +65,8 @@ public:
 		int a_ChunkX, int a_ChunkZ,   // Chunk coords
 		cChunkMap * a_ChunkMap, cWorld * a_World,   // Parent objects
 		cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP,  // Neighbor chunks
-		cAllocationPool<cChunkData::sChunkSection> & a_Pool
+		cAllocationPool<cChunkData::sChunkSection> & a_Pool, cAllocationPool<cChunkData::sSectionNibbles> & a_NibblePool,
+		cAllocationPool<cChunkData::sSectionBlockTypes> & a_BlockTypePool
 	);
 	cChunk(cChunk & other) = delete;
 	~cChunk();
@@ -125,6 +128,13 @@ public:
 	/** Copies m_BlockData into a_BlockTypes, only the block types */
 	void GetBlockTypes(BLOCKTYPE  * a_BlockTypes);
 
+	/** Returns the specified section of the block data, for direct reading; nullptr if the section is all air. */
+	const cChunkData::sChunkSection * GetSection(size_t a_SectionNum) const { return m_ChunkData.GetSection(a_SectionNum); }
+
+	/** Returns the walkable regions of the specified section, for the cNavPlanner; builds them first if needed.
+	a_IsSolid is the table of solid block types, expected to be the same for all the calls. */
+	const cNavSection & GetNavSection(size_t a_SectionNum, const bool * a_IsSolid);
+
 	/** Writes the specified cBlockArea at the coords specified. Note that the coords may extend beyond the chunk! */
 	void WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes);
 
@@ -142,8 +152,19 @@ public:
 	/** Try to Spawn Monsters inside chunk */
 	void SpawnMobs(cMobSpawner & a_MobSpawner);
 
+	/** Runs the part of the tick that only reads this chunk's own data and calls no plugin hooks or simulators:
+	picks the random blocks to be ticked by the following Tick().
+	Called by cChunkMap::Tick() for all the chunks before any of them is ticked, possibly on a worker thread of
+	the chunkmap's cChunkTickScheduler, at the same time as for other chunks. */
+	void PrepareTick(void);
+
 	void Tick(std::chrono::milliseconds a_Dt);
 
+	/** Moves the entities that have left this chunk during Tick() over to their new chunks.
+	Called by cChunkMap::Tick() after all chunks have been ticked, so that an entity moving into a chunk
+	that comes later in the tick order isn't ticked twice in the same tick. */
+	void MoveEntitiesToNewChunks(void);
+
 	/** Ticks a single block. Used by cWorld::TickQueuedBlocks() to tick the queued blocks */
 	void TickBlock(int a_RelX, int a_RelY, int a_RelZ);
 
@@ -244,6 +265,10 @@ public:
 	Returns an owning reference to the found entity. */
 	OwnedEntity RemoveEntity(cEntity & a_Entity);
 
+	/** Moves the entity, which must be in this chunk, to the entity index section matching its current height.
+	Expects the chunkmap to be locked. Used when an entity is teleported, rather than waiting for the chunk to tick. */
+	void UpdateEntityIndex(cEntity & a_Entity);
+
 	bool HasEntity(UInt32 a_EntityID);
 
 	/** Calls the callback for each entity; returns true if all entities processed, false if the callback aborted by returning true */
@@ -351,6 +376,7 @@ public:
 	void BroadcastEntityHeadLook     (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityLook         (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityMetadata     (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
+	void BroadcastEntityMovement     (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMove      (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMoveLook  (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityStatus       (const cEntity & a_Entity, char a_Status, const cClientHandle * a_Exclude = nullptr);
@@ -388,6 +414,7 @@ public:
 		m_BlockTickX = a_RelX;
 		m_BlockTickY = a_RelY;
 		m_BlockTickZ = a_RelZ;
+		m_IsNextBlockTickSet = true;
 	}
 
 	inline NIBBLETYPE GetMeta(int a_RelX, int a_RelY, int a_RelZ) const
@@ -423,6 +450,14 @@ public:
 	/** Get the level of sky light illuminating the block (0 - 15) independent of daytime. */
 	inline NIBBLETYPE GetSkyLight  (int a_RelX, int a_RelY, int a_RelZ) const {return m_ChunkData.GetSkyLight(a_RelX, a_RelY, a_RelZ); }
 
+	/** Sets the level of artificial light of a single block, without sending anything to the clients.
+	Used by cLightUpdater. Returns true if the value has changed. */
+	inline bool SetBlockLight(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light) { return m_ChunkData.SetBlockLight(a_RelX, a_RelY, a_RelZ, a_Light); }
+
+	/** Sets the level of sky light of a single block, without sending anything to the clients.
+	Used by cLightUpdater. Returns true if the value has changed. */
+	inline bool SetSkyLight  (int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light) { return m_ChunkData.SetSkyLight(a_RelX, a_RelY, a_RelZ, a_Light); }
+
 	/** Get the level of sky light illuminating the block (0 - 15), taking daytime into a account. */
 	inline NIBBLETYPE GetSkyLightAltered  (int a_RelX, int a_RelY, int a_RelZ) const {return GetTimeAlteredLight(m_ChunkData.GetSkyLight(a_RelX, a_RelY, a_RelZ)); }
 
@@ -515,6 +550,13 @@ private:
 	bool m_IsSaving;       // True if the chunk is being saved
 	bool m_HasLoadFailed;  // True if chunk failed to load and hasn't been generated yet since then
 
+	/** The world age of the tick in which the m_NumLightUpdates incremental light updates were made. */
+	Int64 m_LightUpdatesWorldAge;
+
+	/** The number of incremental light updates made in the tick m_LightUpdatesWorldAge.
+	Past a limit, FastSetBlock() invalidates the chunk's light instead, to be relit as a whole. */
+	int m_NumLightUpdates;
+
 	std::vector<Vector3i> m_ToTickBlocks;
 	sSetBlockVector       m_PendingSendBlocks;  ///< Blocks that have changed and need to be sent to all clients
 
@@ -523,6 +565,13 @@ private:
 	std::vector<OwnedEntity> m_Entities;
 	cBlockEntities               m_BlockEntities;
 
+	/** Index of m_Entities by the section of the chunk they are in, so that the box and radius queries only look at
+	the entities around the queried height. Updated by Tick() after each entity is ticked. */
+	cEntitySectionIndex<cEntity> m_EntityIndex;
+
+	/** Set by Tick() when any of m_Entities has moved out of this chunk; cleared by MoveEntitiesToNewChunks() */
+	bool m_HasEntitiesToMove;
+
 	/** Number of times the chunk has been requested to stay (by various cChunkStay objects); if zero, the chunk can be unloaded */
 	int m_StayCount;
 
@@ -537,6 +586,20 @@ private:
 
 	int m_BlockTickX, m_BlockTickY, m_BlockTickZ;
 
+	/** True if SetNextBlockTick() has been called since the last TickBlocks(), m_BlockTickX/Y/Z is to be ticked first. */
+	bool m_IsNextBlockTickSet;
+
+	/** The number of blocks in each section that react to random ticks (cBlockInfo::IsRandomTickable()).
+	PrepareTick() only spends random ticks on the sections where this is nonzero. */
+	UInt16 m_NumRandomTickableBlocks[cChunkData::NumSections];
+
+	/** The random blocks picked by PrepareTick(), to be ticked by the next TickBlocks(), in relative coords. */
+	std::vector<Vector3i> m_RandomTickBlocks;
+
+	/** The walkable regions of each section, built by GetNavSection() on demand.
+	nullptr if not built yet or dropped by InvalidateNavSections() since. */
+	std::unique_ptr<cNavSection> m_NavSections[cChunkData::NumSections];
+
 	cChunk * m_NeighborXM;  // Neighbor at [X - 1, Z]
 	cChunk * m_NeighborXP;  // Neighbor at [X + 1, Z]
 	cChunk * m_NeighborZM;  // Neighbor at [X,     Z - 1]
@@ -578,9 +641,20 @@ private:
 	/** Checks the block scheduled for checking in m_ToTickBlocks[] */
 	void CheckBlocks();
 
-	/** Ticks several random blocks in the chunk */
+	/** Ticks the block set by SetNextBlockTick(), then the random blocks picked by PrepareTick() that are still random-tickable */
 	void TickBlocks(void);
 
+	/** Recounts m_NumRandomTickableBlocks[] from scratch, after all the block types have been replaced */
+	void CountRandomTickableBlocks(void);
+
+	/** Updates the light around the block changed from a_OldBlockType, in this chunk and its lit neighbors, using cLightUpdater.
+	Marks the chunks whose light has changed as dirty. */
+	void UpdateLightAround(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_OldBlockType);
+
+	/** Drops the nav sections that depend on a block at the specified height: its own section and,
+	for the bottom and top layers, the section below or above it, which read the layer for their floor and headroom. */
+	void InvalidateNavSections(int a_RelY);
+
 	/** Adds snow to the top of snowy biomes and hydrates farmland / fills cauldrons in rainy biomes */
 	void ApplyWeatherToTop(void);
 
@@ -596,7 +670,7 @@ private:
 	/** Grows a melon or a pumpkin next to the block specified (assumed to be the stem); returns true if the pumpkin or melon sucessfully grew */
 	bool GrowMelonPumpkin(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType);
 
-	/** Called by Tick() when an entity moves out of this chunk into a neighbor; moves the entity and sends spawn / despawn packet to clients */
+	/** Called by MoveEntitiesToNewChunks() for an entity that moved out of this chunk into a neighbor; moves the entity and sends spawn / despawn packet to clients */
 	void MoveEntityToNewChunk(OwnedEntity a_Entity);
 };
 
@@ -5,6 +5,7 @@
 
 #include "Globals.h"
 #include "ChunkData.h"
+#include "FastRandom.h"
 
 
 
@@ -27,9 +28,118 @@ template <typename T> inline bool IsAllValue(const T * a_Array, size_t a_NumElem
 
 
 
-cChunkData::cChunkData(cAllocationPool<cChunkData::sChunkSection> & a_Pool):
+/** Holds the shared light arrays returned for the sections that have no light arrays allocated. */
+static const struct sUniformLightArrays
+{
+	NIBBLETYPE m_Dark[cChunkData::SectionNibbleCount];
+	NIBBLETYPE m_Lit [cChunkData::SectionNibbleCount];
+
+	sUniformLightArrays(void)
+	{
+		memset(m_Dark, 0x00, sizeof(m_Dark));
+		memset(m_Lit,  0xff, sizeof(m_Lit));
+	}
+} g_UniformLightArrays;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkData::sChunkSection:
+
+const NIBBLETYPE * cChunkData::sChunkSection::GetBlockLight(void) const
+{
+	if (m_BlockLight != nullptr)
+	{
+		return m_BlockLight->m_Nibbles;
+	}
+	return (m_UniformBlockLight == 0) ? g_UniformLightArrays.m_Dark : g_UniformLightArrays.m_Lit;
+}
+
+
+
+
+
+const NIBBLETYPE * cChunkData::sChunkSection::GetSkyLight(void) const
+{
+	if (m_BlockSkyLight != nullptr)
+	{
+		return m_BlockSkyLight->m_Nibbles;
+	}
+	return (m_UniformSkyLight == 0) ? g_UniformLightArrays.m_Dark : g_UniformLightArrays.m_Lit;
+}
+
+
+
+
+
+void cChunkData::sChunkSection::CopyBlockTypes(BLOCKTYPE * a_Dest, size_t a_Idx, size_t a_Length) const
+{
+	ASSERT(a_Idx + a_Length <= SectionBlockCount);
+	if (m_BlockTypes != nullptr)
+	{
+		memcpy(a_Dest, m_BlockTypes->m_BlockTypes + a_Idx, a_Length);
+		return;
+	}
+	if (m_PackedBlockTypes == nullptr)
+	{
+		memset(a_Dest, m_Palette[0], a_Length);
+		return;
+	}
+	const NIBBLETYPE * Packed = m_PackedBlockTypes->m_Nibbles;
+	size_t i = 0;
+	if (((a_Idx & 1) != 0) && (a_Length > 0))
+	{
+		// Start at the high nibble of the first byte:
+		a_Dest[0] = m_Palette[Packed[a_Idx / 2] >> 4];
+		i = 1;
+	}
+
+	// Unpack two indices per byte:
+	for (; i + 1 < a_Length; i += 2)
+	{
+		NIBBLETYPE Byte = Packed[(a_Idx + i) / 2];
+		a_Dest[i] = m_Palette[Byte & 0x0f];
+		a_Dest[i + 1] = m_Palette[Byte >> 4];
+	}
+	if (i < a_Length)
+	{
+		a_Dest[i] = m_Palette[Packed[(a_Idx + i) / 2] & 0x0f];
+	}
+}
+
+
+
+
+
+const BLOCKTYPE * cChunkData::sChunkSection::GetBlockTypes(BLOCKTYPE * a_Buffer) const
+{
+	if (m_BlockTypes != nullptr)
+	{
+		return m_BlockTypes->m_BlockTypes;
+	}
+	CopyBlockTypes(a_Buffer);
+	return a_Buffer;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkData:
+
+cChunkData::cChunkData(
+	cAllocationPool<cChunkData::sChunkSection> & a_Pool,
+	cAllocationPool<cChunkData::sSectionNibbles> & a_NibblePool,
+	cAllocationPool<cChunkData::sSectionBlockTypes> & a_BlockTypePool
+):
 	m_Sections(),
-	m_Pool(a_Pool)
+	m_Pool(a_Pool),
+	m_NibblePool(a_NibblePool),
+	m_BlockTypePool(a_BlockTypePool),
+	m_Generation(NewGeneration())
 {
 }
 
@@ -38,13 +148,17 @@ cChunkData::cChunkData(cAllocationPool<cChunkData::sChunkSection> & a_Pool):
 
 
 cChunkData::cChunkData(cChunkData && a_Other):
-	m_Pool(a_Other.m_Pool)
+	m_Pool(a_Other.m_Pool),
+	m_NibblePool(a_Other.m_NibblePool),
+	m_BlockTypePool(a_Other.m_BlockTypePool),
+	m_Generation(a_Other.m_Generation)
 {
 	for (size_t i = 0; i < NumSections; i++)
 	{
 		m_Sections[i] = a_Other.m_Sections[i];
 		a_Other.m_Sections[i] = nullptr;
 	}
+	a_Other.m_Generation = NewGeneration();
 }
 
 
@@ -71,12 +185,20 @@ void cChunkData::Assign(const cChunkData & a_Other)
 	Clear();
 	for (size_t i = 0; i < NumSections; ++i)
 	{
-		if (a_Other.m_Sections[i] != nullptr)
+		const sChunkSection * Other = a_Other.m_Sections[i];
+		if (Other == nullptr)
 		{
-			m_Sections[i] = Allocate();
-			*m_Sections[i] = *a_Other.m_Sections[i];
+			continue;
 		}
+		m_Sections[i] = Allocate();
+		ZeroSection(m_Sections[i]);
+		CopySectionBlockTypes(*m_Sections[i], *Other);
+		memcpy(m_Sections[i]->m_BlockMetas, Other->m_BlockMetas, sizeof(Other->m_BlockMetas));
+		SetSectionLight(m_Sections[i]->m_BlockLight,    m_Sections[i]->m_UniformBlockLight, Other->GetBlockLight());
+		SetSectionLight(m_Sections[i]->m_BlockSkyLight, m_Sections[i]->m_UniformSkyLight,   Other->GetSkyLight());
 	}
+	// The copy is modified independently of the original from now on, so it can't continue the original's generations:
+	m_Generation = NewGeneration();
 }
 
 
@@ -90,7 +212,7 @@ void cChunkData::Assign(cChunkData && a_Other)
 		return;
 	}
 
-	if (&m_Pool != &a_Other.m_Pool)
+	if ((&m_Pool != &a_Other.m_Pool) || (&m_NibblePool != &a_Other.m_NibblePool) || (&m_BlockTypePool != &a_Other.m_BlockTypePool))
 	{
 		// Cannot transfer the memory, do a copy instead
 		const cChunkData & CopyOther = a_Other;
@@ -104,6 +226,8 @@ void cChunkData::Assign(cChunkData && a_Other)
 		m_Sections[i] = a_Other.m_Sections[i];
 		a_Other.m_Sections[i] = nullptr;
 	}
+	m_Generation = a_Other.m_Generation;
+	a_Other.m_Generation = NewGeneration();
 }
 
 
@@ -124,7 +248,7 @@ BLOCKTYPE cChunkData::GetBlock(int a_X, int a_Y, int a_Z) const
 	if (m_Sections[Section] != nullptr)
 	{
 		int Index = cChunkDef::MakeIndexNoCheck(a_X, static_cast<int>(static_cast<UInt32>(a_Y) - (static_cast<UInt32>(Section) * SectionHeight)), a_Z);
-		return m_Sections[Section]->m_BlockTypes[Index];
+		return m_Sections[Section]->GetBlockType(static_cast<size_t>(Index));
 	}
 	else
 	{
@@ -163,8 +287,9 @@ void cChunkData::SetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_Block)
 		}
 		ZeroSection(m_Sections[Section]);
 	}
+	++m_Generation;
 	int Index = cChunkDef::MakeIndexNoCheck(a_RelX, static_cast<int>(static_cast<UInt32>(a_RelY) - (static_cast<UInt32>(Section) * SectionHeight)), a_RelZ);
-	m_Sections[Section]->m_BlockTypes[Index] = a_Block;
+	SetSectionBlockType(*m_Sections[Section], static_cast<size_t>(Index), a_Block);
 }
 
 
@@ -224,6 +349,7 @@ bool cChunkData::SetMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Nibble
 		}
 		ZeroSection(m_Sections[Section]);
 	}
+	++m_Generation;
 	int Index = cChunkDef::MakeIndexNoCheck(a_RelX, static_cast<int>(static_cast<UInt32>(a_RelY) - (static_cast<UInt32>(Section) * SectionHeight)), a_RelZ);
 	NIBBLETYPE oldval = m_Sections[Section]->m_BlockMetas[Index / 2] >> ((Index & 1) * 4) & 0xf;
 	m_Sections[Section]->m_BlockMetas[Index / 2] = static_cast<NIBBLETYPE>(
@@ -248,8 +374,12 @@ NIBBLETYPE cChunkData::GetBlockLight(int a_RelX, int a_RelY, int a_RelZ) const
 		int Section = static_cast<int>(static_cast<UInt32>(a_RelY) / SectionHeight);
 		if (m_Sections[Section] != nullptr)
 		{
+			if (m_Sections[Section]->m_BlockLight == nullptr)
+			{
+				return m_Sections[Section]->m_UniformBlockLight;
+			}
 			int Index = cChunkDef::MakeIndexNoCheck(a_RelX, static_cast<int>(static_cast<UInt32>(a_RelY) - (static_cast<UInt32>(Section) * SectionHeight)), a_RelZ);
-			return (m_Sections[Section]->m_BlockLight[Index / 2] >> ((Index & 1) * 4)) & 0x0f;
+			return (m_Sections[Section]->m_BlockLight->m_Nibbles[Index / 2] >> ((Index & 1) * 4)) & 0x0f;
 		}
 		else
 		{
@@ -271,8 +401,12 @@ NIBBLETYPE cChunkData::GetSkyLight(int a_RelX, int a_RelY, int a_RelZ) const
 		int Section = static_cast<int>(static_cast<UInt32>(a_RelY) / SectionHeight);
 		if (m_Sections[Section] != nullptr)
 		{
+			if (m_Sections[Section]->m_BlockSkyLight == nullptr)
+			{
+				return m_Sections[Section]->m_UniformSkyLight;
+			}
 			int Index = cChunkDef::MakeIndexNoCheck(a_RelX, static_cast<int>(static_cast<UInt32>(a_RelY) - (static_cast<UInt32>(Section) * SectionHeight)), a_RelZ);
-			return (m_Sections[Section]->m_BlockSkyLight[Index / 2] >> ((Index & 1) * 4)) & 0x0f;
+			return (m_Sections[Section]->m_BlockSkyLight->m_Nibbles[Index / 2] >> ((Index & 1) * 4)) & 0x0f;
 		}
 		else
 		{
@@ -287,6 +421,88 @@ NIBBLETYPE cChunkData::GetSkyLight(int a_RelX, int a_RelY, int a_RelZ) const
 
 
 
+bool cChunkData::SetBlockLight(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light)
+{
+	if (
+		(a_RelX >= cChunkDef::Width)  || (a_RelX < 0) ||
+		(a_RelY >= cChunkDef::Height) || (a_RelY < 0) ||
+		(a_RelZ >= cChunkDef::Width)  || (a_RelZ < 0)
+	)
+	{
+		ASSERT(!"cChunkData::SetBlockLight(): index out of range!");
+		return false;
+	}
+
+	int Section = static_cast<int>(static_cast<UInt32>(a_RelY) / SectionHeight);
+	if (m_Sections[Section] == nullptr)
+	{
+		if ((a_Light & 0x0f) == 0x00)
+		{
+			// Missing sections are dark already
+			return false;
+		}
+		m_Sections[Section] = Allocate();
+		if (m_Sections[Section] == nullptr)
+		{
+			ASSERT(!"Failed to allocate a new section in Chunkbuffer");
+			return false;
+		}
+		ZeroSection(m_Sections[Section]);
+	}
+	int Index = cChunkDef::MakeIndexNoCheck(a_RelX, static_cast<int>(static_cast<UInt32>(a_RelY) - (static_cast<UInt32>(Section) * SectionHeight)), a_RelZ);
+	if (!SetSectionLightNibble(m_Sections[Section]->m_BlockLight, m_Sections[Section]->m_UniformBlockLight, Index, a_Light))
+	{
+		return false;
+	}
+	++m_Generation;
+	return true;
+}
+
+
+
+
+
+bool cChunkData::SetSkyLight(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light)
+{
+	if (
+		(a_RelX >= cChunkDef::Width)  || (a_RelX < 0) ||
+		(a_RelY >= cChunkDef::Height) || (a_RelY < 0) ||
+		(a_RelZ >= cChunkDef::Width)  || (a_RelZ < 0)
+	)
+	{
+		ASSERT(!"cChunkData::SetSkyLight(): index out of range!");
+		return false;
+	}
+
+	int Section = static_cast<int>(static_cast<UInt32>(a_RelY) / SectionHeight);
+	if (m_Sections[Section] == nullptr)
+	{
+		if ((a_Light & 0x0f) == 0x0f)
+		{
+			// Missing sections are fully lit already
+			return false;
+		}
+		m_Sections[Section] = Allocate();
+		if (m_Sections[Section] == nullptr)
+		{
+			ASSERT(!"Failed to allocate a new section in Chunkbuffer");
+			return false;
+		}
+		ZeroSection(m_Sections[Section]);
+	}
+	int Index = cChunkDef::MakeIndexNoCheck(a_RelX, static_cast<int>(static_cast<UInt32>(a_RelY) - (static_cast<UInt32>(Section) * SectionHeight)), a_RelZ);
+	if (!SetSectionLightNibble(m_Sections[Section]->m_BlockSkyLight, m_Sections[Section]->m_UniformSkyLight, Index, a_Light))
+	{
+		return false;
+	}
+	++m_Generation;
+	return true;
+}
+
+
+
+
+
 const cChunkData::sChunkSection * cChunkData::GetSection(size_t a_SectionNum) const
 {
 	if (a_SectionNum < NumSections)
@@ -301,6 +517,37 @@ const cChunkData::sChunkSection * cChunkData::GetSection(size_t a_SectionNum) co
 
 
 
+void cChunkData::PickRandomBlocks(const bool * a_IsTickable, const UInt16 * a_NumTickable, int a_NumPerSection, std::vector<Vector3i> & a_Blocks) const
+{
+	auto & Random = GetRandomProvider();
+	for (size_t SectionNum = 0; SectionNum < NumSections; SectionNum++)
+	{
+		const sChunkSection * Section = m_Sections[SectionNum];
+		if ((a_NumTickable[SectionNum] == 0) || (Section == nullptr))
+		{
+			continue;
+		}
+		for (int i = 0; i < a_NumPerSection; i++)
+		{
+			// The index is in the section's XZY order:
+			size_t Index = static_cast<size_t>(Random.RandInt(static_cast<int>(SectionBlockCount) - 1));
+			if (!a_IsTickable[Section->GetBlockType(Index)])
+			{
+				continue;
+			}
+			a_Blocks.emplace_back(
+				static_cast<int>(Index % cChunkDef::Width),
+				static_cast<int>(SectionNum) * SectionHeight + static_cast<int>(Index / (cChunkDef::Width * cChunkDef::Width)),
+				static_cast<int>((Index / cChunkDef::Width) % cChunkDef::Width)
+			);
+		}
+	}
+}
+
+
+
+
+
 UInt16 cChunkData::GetSectionBitmask() const
 {
 	static_assert(NumSections <= 16U, "cChunkData::GetSectionBitmask needs a bigger data type");
@@ -318,6 +565,7 @@ UInt16 cChunkData::GetSectionBitmask() const
 
 void cChunkData::Clear()
 {
+	++m_Generation;
 	for (size_t i = 0; i < NumSections; ++i)
 	{
 		if (m_Sections[i] != nullptr)
@@ -350,8 +598,7 @@ void cChunkData::CopyBlockTypes(BLOCKTYPE * a_Dest, size_t a_Idx, size_t a_Lengt
 			a_Length -= ToCopy;
 			if (m_Sections[i] != nullptr)
 			{
-				BLOCKTYPE * blockbuffer = m_Sections[i]->m_BlockTypes;
-				memcpy(&a_Dest[(i * SectionBlockCount) + StartPos - a_Idx], blockbuffer + StartPos, sizeof(BLOCKTYPE) * ToCopy);
+				m_Sections[i]->CopyBlockTypes(&a_Dest[(i * SectionBlockCount) + StartPos - a_Idx], StartPos, ToCopy);
 			}
 			else
 			{
@@ -390,11 +637,11 @@ void cChunkData::CopyBlockLight(NIBBLETYPE * a_Dest) const
 	{
 		if (m_Sections[i] != nullptr)
 		{
-			memcpy(&a_Dest[i * SectionBlockCount / 2], &m_Sections[i]->m_BlockLight, sizeof(m_Sections[i]->m_BlockLight));
+			memcpy(&a_Dest[i * SectionNibbleCount], m_Sections[i]->GetBlockLight(), SectionNibbleCount);
 		}
 		else
 		{
-			memset(&a_Dest[i * SectionBlockCount / 2], 0, sizeof(m_Sections[i]->m_BlockLight));
+			memset(&a_Dest[i * SectionNibbleCount], 0, SectionNibbleCount);
 		}
 	}
 }
@@ -409,11 +656,11 @@ void cChunkData::CopySkyLight(NIBBLETYPE * a_Dest) const
 	{
 		if (m_Sections[i] != nullptr)
 		{
-			memcpy(&a_Dest[i * SectionBlockCount / 2], &m_Sections[i]->m_BlockSkyLight, sizeof(m_Sections[i]->m_BlockSkyLight));
+			memcpy(&a_Dest[i * SectionNibbleCount], m_Sections[i]->GetSkyLight(), SectionNibbleCount);
 		}
 		else
 		{
-			memset(&a_Dest[i * SectionBlockCount / 2], 0xff, sizeof(m_Sections[i]->m_BlockSkyLight));
+			memset(&a_Dest[i * SectionNibbleCount], 0xff, SectionNibbleCount);
 		}
 	}
 }
@@ -424,6 +671,7 @@ void cChunkData::CopySkyLight(NIBBLETYPE * a_Dest) const
 
 void cChunkData::FillBlockTypes(BLOCKTYPE a_Value)
 {
+	++m_Generation;
 	// If needed, allocate any missing sections
 	if (a_Value != 0x00)
 	{
@@ -432,9 +680,7 @@ void cChunkData::FillBlockTypes(BLOCKTYPE a_Value)
 			if (Section == nullptr)
 			{
 				Section = Allocate();
-				std::fill(std::begin(Section->m_BlockMetas),    std::end(Section->m_BlockMetas),    0x00);
-				std::fill(std::begin(Section->m_BlockLight),    std::end(Section->m_BlockLight),    0x00);
-				std::fill(std::begin(Section->m_BlockSkyLight), std::end(Section->m_BlockSkyLight), 0xff);
+				ZeroSection(Section);
 			}
 		}
 	}
@@ -443,7 +689,9 @@ void cChunkData::FillBlockTypes(BLOCKTYPE a_Value)
 	{
 		if (Section != nullptr)
 		{
-			std::fill(std::begin(Section->m_BlockTypes), std::end(Section->m_BlockTypes), a_Value);
+			// A single block type needs no array:
+			FreeBlockTypes(*Section);
+			Section->m_Palette[0] = a_Value;
 		}
 	}
 }
@@ -454,6 +702,7 @@ void cChunkData::FillBlockTypes(BLOCKTYPE a_Value)
 
 void cChunkData::FillMetas(NIBBLETYPE a_Value)
 {
+	++m_Generation;
 	// If needed, allocate any missing sections
 	if (a_Value != 0x00)
 	{
@@ -462,9 +711,7 @@ void cChunkData::FillMetas(NIBBLETYPE a_Value)
 			if (Section == nullptr)
 			{
 				Section = Allocate();
-				std::fill(std::begin(Section->m_BlockTypes),    std::end(Section->m_BlockTypes),    0x00);
-				std::fill(std::begin(Section->m_BlockLight),    std::end(Section->m_BlockLight),    0x00);
-				std::fill(std::begin(Section->m_BlockSkyLight), std::end(Section->m_BlockSkyLight), 0xff);
+				ZeroSection(Section);
 			}
 		}
 	}
@@ -485,6 +732,7 @@ void cChunkData::FillMetas(NIBBLETYPE a_Value)
 
 void cChunkData::FillBlockLight(NIBBLETYPE a_Value)
 {
+	++m_Generation;
 	// If needed, allocate any missing sections
 	if (a_Value != 0x00)
 	{
@@ -493,19 +741,16 @@ void cChunkData::FillBlockLight(NIBBLETYPE a_Value)
 			if (Section == nullptr)
 			{
 				Section = Allocate();
-				std::fill(std::begin(Section->m_BlockTypes), std::end(Section->m_BlockTypes), 0x00);
-				std::fill(std::begin(Section->m_BlockMetas), std::end(Section->m_BlockMetas), 0x00);
-				std::fill(std::begin(Section->m_BlockSkyLight), std::end(Section->m_BlockSkyLight), 0xff);
+				ZeroSection(Section);
 			}
 		}
 	}
 
-	NIBBLETYPE NewLight = static_cast<NIBBLETYPE>((a_Value << 4) | a_Value);
 	for (auto Section : m_Sections)
 	{
 		if (Section != nullptr)
 		{
-			std::fill(std::begin(Section->m_BlockLight), std::end(Section->m_BlockLight), NewLight);
+			FillSectionLight(Section->m_BlockLight, Section->m_UniformBlockLight, a_Value);
 		}
 	}
 }
@@ -516,6 +761,7 @@ void cChunkData::FillBlockLight(NIBBLETYPE a_Value)
 
 void cChunkData::FillSkyLight(NIBBLETYPE a_Value)
 {
+	++m_Generation;
 	// If needed, allocate any missing sections
 	if (a_Value != 0x0f)
 	{
@@ -524,19 +770,16 @@ void cChunkData::FillSkyLight(NIBBLETYPE a_Value)
 			if (Section == nullptr)
 			{
 				Section = Allocate();
-				std::fill(std::begin(Section->m_BlockTypes), std::end(Section->m_BlockTypes), 0x00);
-				std::fill(std::begin(Section->m_BlockMetas), std::end(Section->m_BlockMetas), 0x00);
-				std::fill(std::begin(Section->m_BlockLight), std::end(Section->m_BlockLight), 0x00);
+				ZeroSection(Section);
 			}
 		}
 	}
 
-	NIBBLETYPE NewSkyLight = static_cast<NIBBLETYPE>((a_Value << 4) | a_Value);
 	for (auto Section : m_Sections)
 	{
 		if (Section != nullptr)
 		{
-			std::fill(std::begin(Section->m_BlockSkyLight), std::end(Section->m_BlockSkyLight), NewSkyLight);
+			FillSectionLight(Section->m_BlockSkyLight, Section->m_UniformSkyLight, a_Value);
 		}
 	}
 }
@@ -548,13 +791,14 @@ void cChunkData::FillSkyLight(NIBBLETYPE a_Value)
 void cChunkData::SetBlockTypes(const BLOCKTYPE * a_Src)
 {
 	ASSERT(a_Src != nullptr);
+	++m_Generation;
 
 	for (size_t i = 0; i < NumSections; i++)
 	{
 		// If the section is already allocated, copy the data into it:
 		if (m_Sections[i] != nullptr)
 		{
-			memcpy(m_Sections[i]->m_BlockTypes, &a_Src[i * SectionBlockCount], sizeof(m_Sections[i]->m_BlockTypes));
+			SetSectionBlockTypes(*m_Sections[i], &a_Src[i * SectionBlockCount]);
 			continue;
 		}
 
@@ -567,10 +811,8 @@ void cChunkData::SetBlockTypes(const BLOCKTYPE * a_Src)
 
 		// Allocate the section and copy the data into it:
 		m_Sections[i] = Allocate();
-		memcpy(m_Sections[i]->m_BlockTypes, &a_Src[i * SectionBlockCount], sizeof(m_Sections[i]->m_BlockTypes));
-		memset(m_Sections[i]->m_BlockMetas,    0x00, sizeof(m_Sections[i]->m_BlockMetas));
-		memset(m_Sections[i]->m_BlockLight,    0x00, sizeof(m_Sections[i]->m_BlockLight));
-		memset(m_Sections[i]->m_BlockSkyLight, 0xff, sizeof(m_Sections[i]->m_BlockSkyLight));
+		ZeroSection(m_Sections[i]);
+		SetSectionBlockTypes(*m_Sections[i], &a_Src[i * SectionBlockCount]);
 	}  // for i - m_Sections[]
 }
 
@@ -580,6 +822,7 @@ void cChunkData::SetBlockTypes(const BLOCKTYPE * a_Src)
 void cChunkData::SetMetas(const NIBBLETYPE * a_Src)
 {
 	ASSERT(a_Src != nullptr);
+	++m_Generation;
 
 	for (size_t i = 0; i < NumSections; i++)
 	{
@@ -599,10 +842,8 @@ void cChunkData::SetMetas(const NIBBLETYPE * a_Src)
 
 		// Allocate the section and copy the data into it:
 		m_Sections[i] = Allocate();
+		ZeroSection(m_Sections[i]);
 		memcpy(m_Sections[i]->m_BlockMetas, &a_Src[i * SectionBlockCount / 2], sizeof(m_Sections[i]->m_BlockMetas));
-		memset(m_Sections[i]->m_BlockTypes,    0x00, sizeof(m_Sections[i]->m_BlockTypes));
-		memset(m_Sections[i]->m_BlockLight,    0x00, sizeof(m_Sections[i]->m_BlockLight));
-		memset(m_Sections[i]->m_BlockSkyLight, 0xff, sizeof(m_Sections[i]->m_BlockSkyLight));
 	}  // for i - m_Sections[]
 }
 
@@ -616,13 +857,14 @@ void cChunkData::SetBlockLight(const NIBBLETYPE * a_Src)
 	{
 		return;
 	}
+	++m_Generation;
 
 	for (size_t i = 0; i < NumSections; i++)
 	{
 		// If the section is already allocated, copy the data into it:
 		if (m_Sections[i] != nullptr)
 		{
-			memcpy(m_Sections[i]->m_BlockLight, &a_Src[i * SectionBlockCount / 2], sizeof(m_Sections[i]->m_BlockLight));
+			SetSectionLight(m_Sections[i]->m_BlockLight, m_Sections[i]->m_UniformBlockLight, &a_Src[i * SectionNibbleCount]);
 			continue;
 		}
 
@@ -635,10 +877,8 @@ void cChunkData::SetBlockLight(const NIBBLETYPE * a_Src)
 
 		// Allocate the section and copy the data into it:
 		m_Sections[i] = Allocate();
-		memcpy(m_Sections[i]->m_BlockLight, &a_Src[i * SectionBlockCount / 2], sizeof(m_Sections[i]->m_BlockLight));
-		memset(m_Sections[i]->m_BlockTypes,    0x00, sizeof(m_Sections[i]->m_BlockTypes));
-		memset(m_Sections[i]->m_BlockMetas,    0x00, sizeof(m_Sections[i]->m_BlockMetas));
-		memset(m_Sections[i]->m_BlockSkyLight, 0xff, sizeof(m_Sections[i]->m_BlockSkyLight));
+		ZeroSection(m_Sections[i]);
+		SetSectionLight(m_Sections[i]->m_BlockLight, m_Sections[i]->m_UniformBlockLight, &a_Src[i * SectionNibbleCount]);
 	}  // for i - m_Sections[]
 }
 
@@ -651,29 +891,28 @@ void cChunkData::SetSkyLight(const NIBBLETYPE * a_Src)
 	{
 		return;
 	}
+	++m_Generation;
 
 	for (size_t i = 0; i < NumSections; i++)
 	{
 		// If the section is already allocated, copy the data into it:
 		if (m_Sections[i] != nullptr)
 		{
-			memcpy(m_Sections[i]->m_BlockSkyLight, &a_Src[i * SectionBlockCount / 2], sizeof(m_Sections[i]->m_BlockSkyLight));
+			SetSectionLight(m_Sections[i]->m_BlockSkyLight, m_Sections[i]->m_UniformSkyLight, &a_Src[i * SectionNibbleCount]);
 			continue;
 		}
 
 		// The section doesn't exist, find out if it is needed:
 		if (IsAllValue(a_Src + i * SectionBlockCount / 2, SectionBlockCount / 2, static_cast<NIBBLETYPE>(0xff)))
 		{
-			// No need for the section, the data is all zeroes
+			// No need for the section, the data is all fully lit
 			continue;
 		}
 
 		// Allocate the section and copy the data into it:
 		m_Sections[i] = Allocate();
-		memcpy(m_Sections[i]->m_BlockSkyLight, &a_Src[i * SectionBlockCount / 2], sizeof(m_Sections[i]->m_BlockSkyLight));
-		memset(m_Sections[i]->m_BlockTypes, 0x00, sizeof(m_Sections[i]->m_BlockTypes));
-		memset(m_Sections[i]->m_BlockMetas, 0x00, sizeof(m_Sections[i]->m_BlockMetas));
-		memset(m_Sections[i]->m_BlockLight, 0x00, sizeof(m_Sections[i]->m_BlockLight));
+		ZeroSection(m_Sections[i]);
+		SetSectionLight(m_Sections[i]->m_BlockSkyLight, m_Sections[i]->m_UniformSkyLight, &a_Src[i * SectionNibbleCount]);
 	}  // for i - m_Sections[]
 }
 
@@ -698,6 +937,66 @@ UInt32 cChunkData::NumPresentSections() const
 
 
 
+size_t cChunkData::GetMemoryUsage(void) const
+{
+	sMemoryStats Stats;
+	AddMemoryStats(Stats);
+	return Stats.m_NumBytes;
+}
+
+
+
+
+
+void cChunkData::AddMemoryStats(sMemoryStats & a_Stats) const
+{
+	for (const auto Section : m_Sections)
+	{
+		if (Section == nullptr)
+		{
+			continue;
+		}
+		a_Stats.m_NumBytes += sizeof(sChunkSection);
+		if (Section->m_BlockTypes != nullptr)
+		{
+			a_Stats.m_NumPlain += 1;
+			a_Stats.m_NumBytes += sizeof(sSectionBlockTypes);
+		}
+		else if (Section->m_PackedBlockTypes != nullptr)
+		{
+			a_Stats.m_NumPacked += 1;
+			a_Stats.m_NumBytes += sizeof(sSectionNibbles);
+		}
+		else
+		{
+			a_Stats.m_NumSingleType += 1;
+		}
+		for (const auto Light : {Section->m_BlockLight, Section->m_BlockSkyLight})
+		{
+			if (Light != nullptr)
+			{
+				a_Stats.m_NumLightArrays += 1;
+				a_Stats.m_NumBytes += sizeof(sSectionNibbles);
+			}
+		}
+	}
+}
+
+
+
+
+
+UInt64 cChunkData::NewGeneration(void)
+{
+	// Each instance gets its own range of generations in the upper bits, so that unrelated data never compare equal:
+	static std::atomic<UInt32> NextInstance(0);
+	return static_cast<UInt64>(++NextInstance) << 32;
+}
+
+
+
+
+
 cChunkData::sChunkSection * cChunkData::Allocate(void)
 {
 	return m_Pool.Allocate();
@@ -709,6 +1008,13 @@ cChunkData::sChunkSection * cChunkData::Allocate(void)
 
 void cChunkData::Free(cChunkData::sChunkSection * a_Section)
 {
+	if (a_Section == nullptr)
+	{
+		return;
+	}
+	FreeBlockTypes(*a_Section);
+	FreeNibbles(a_Section->m_BlockLight);
+	FreeNibbles(a_Section->m_BlockSkyLight);
 	m_Pool.Free(a_Section);
 }
 
@@ -716,14 +1022,253 @@ void cChunkData::Free(cChunkData::sChunkSection * a_Section)
 
 
 
+void cChunkData::FreeNibbles(sSectionNibbles *& a_Nibbles)
+{
+	if (a_Nibbles != nullptr)
+	{
+		m_NibblePool.Free(a_Nibbles);
+		a_Nibbles = nullptr;
+	}
+}
+
+
+
+
+
+void cChunkData::FreeBlockTypes(sChunkSection & a_Section)
+{
+	FreeNibbles(a_Section.m_PackedBlockTypes);
+	if (a_Section.m_BlockTypes != nullptr)
+	{
+		m_BlockTypePool.Free(a_Section.m_BlockTypes);
+		a_Section.m_BlockTypes = nullptr;
+	}
+	a_Section.m_Palette[0] = E_BLOCK_AIR;
+	a_Section.m_PaletteCount = 1;
+}
+
+
+
+
+
 void cChunkData::ZeroSection(cChunkData::sChunkSection * a_Section) const
 {
-	memset(a_Section->m_BlockTypes,    0x00, sizeof(a_Section->m_BlockTypes));
-	memset(a_Section->m_BlockMetas,    0x00, sizeof(a_Section->m_BlockMetas));
-	memset(a_Section->m_BlockLight,    0x00, sizeof(a_Section->m_BlockLight));
-	memset(a_Section->m_BlockSkyLight, 0xff, sizeof(a_Section->m_BlockSkyLight));
+	a_Section->m_Palette[0] = E_BLOCK_AIR;
+	a_Section->m_PaletteCount = 1;
+	a_Section->m_PackedBlockTypes = nullptr;
+	a_Section->m_BlockTypes = nullptr;
+	memset(a_Section->m_BlockMetas, 0x00, sizeof(a_Section->m_BlockMetas));
+	a_Section->m_BlockLight = nullptr;
+	a_Section->m_BlockSkyLight = nullptr;
+	a_Section->m_UniformBlockLight = 0x00;
+	a_Section->m_UniformSkyLight = 0x0f;
 }
 
 
 
 
+
+void cChunkData::SetSectionLight(sSectionNibbles *& a_Light, NIBBLETYPE & a_UniformLight, const NIBBLETYPE * a_Src)
+{
+	// Fully dark and fully lit sections don't need the array:
+	if (IsAllValue(a_Src, SectionNibbleCount, static_cast<NIBBLETYPE>(0x00)))
+	{
+		FillSectionLight(a_Light, a_UniformLight, 0x00);
+		return;
+	}
+	if (IsAllValue(a_Src, SectionNibbleCount, static_cast<NIBBLETYPE>(0xff)))
+	{
+		FillSectionLight(a_Light, a_UniformLight, 0x0f);
+		return;
+	}
+
+	if (a_Light == nullptr)
+	{
+		a_Light = m_NibblePool.Allocate();
+	}
+	memcpy(a_Light->m_Nibbles, a_Src, SectionNibbleCount);
+}
+
+
+
+
+
+void cChunkData::FillSectionLight(sSectionNibbles *& a_Light, NIBBLETYPE & a_UniformLight, NIBBLETYPE a_Value)
+{
+	a_Value &= 0x0f;
+	if ((a_Value == 0x00) || (a_Value == 0x0f))
+	{
+		FreeNibbles(a_Light);
+		a_UniformLight = a_Value;
+		return;
+	}
+
+	if (a_Light == nullptr)
+	{
+		a_Light = m_NibblePool.Allocate();
+	}
+	memset(a_Light->m_Nibbles, static_cast<NIBBLETYPE>((a_Value << 4) | a_Value), SectionNibbleCount);
+}
+
+
+
+
+
+bool cChunkData::SetSectionLightNibble(sSectionNibbles *& a_Light, NIBBLETYPE a_UniformLight, int a_Index, NIBBLETYPE a_Value)
+{
+	a_Value &= 0x0f;
+	if (a_Light == nullptr)
+	{
+		if (a_UniformLight == a_Value)
+		{
+			return false;
+		}
+		a_Light = m_NibblePool.Allocate();
+		memset(a_Light->m_Nibbles, static_cast<NIBBLETYPE>((a_UniformLight << 4) | a_UniformLight), SectionNibbleCount);
+	}
+
+	NIBBLETYPE & Nibbles = a_Light->m_Nibbles[a_Index / 2];
+	NIBBLETYPE OldValue = (Nibbles >> ((a_Index & 1) * 4)) & 0x0f;
+	Nibbles = static_cast<NIBBLETYPE>(
+		(Nibbles & (0xf0 >> ((a_Index & 1) * 4))) |  // The untouched nibble
+		(a_Value << ((a_Index & 1) * 4))  // The nibble being set
+	);
+	return (OldValue != a_Value);
+}
+
+
+
+
+
+void cChunkData::SetSectionBlockType(sChunkSection & a_Section, size_t a_Index, BLOCKTYPE a_BlockType)
+{
+	if (a_Section.m_BlockTypes != nullptr)
+	{
+		a_Section.m_BlockTypes->m_BlockTypes[a_Index] = a_BlockType;
+		return;
+	}
+
+	// Find the type in the palette, add it if it's not there yet:
+	size_t PaletteIndex = 0;
+	while ((PaletteIndex < a_Section.m_PaletteCount) && (a_Section.m_Palette[PaletteIndex] != a_BlockType))
+	{
+		PaletteIndex++;
+	}
+	if (PaletteIndex == a_Section.m_PaletteCount)
+	{
+		if (a_Section.m_PaletteCount == PaletteSize)
+		{
+			// The palette is full, unpack the section into the plain array:
+			sSectionBlockTypes * BlockTypes = m_BlockTypePool.Allocate();
+			a_Section.CopyBlockTypes(BlockTypes->m_BlockTypes);
+			FreeNibbles(a_Section.m_PackedBlockTypes);
+			a_Section.m_BlockTypes = BlockTypes;
+			BlockTypes->m_BlockTypes[a_Index] = a_BlockType;
+			return;
+		}
+		a_Section.m_Palette[PaletteIndex] = a_BlockType;
+		a_Section.m_PaletteCount += 1;
+	}
+
+	if (a_Section.m_PackedBlockTypes == nullptr)
+	{
+		if (PaletteIndex == 0)
+		{
+			// A single-type section, and the block is of that type already
+			return;
+		}
+
+		// The second type in a single-type section, all the blocks so far are the first palette entry:
+		a_Section.m_PackedBlockTypes = m_NibblePool.Allocate();
+		memset(a_Section.m_PackedBlockTypes->m_Nibbles, 0, SectionNibbleCount);
+	}
+
+	NIBBLETYPE & Nibbles = a_Section.m_PackedBlockTypes->m_Nibbles[a_Index / 2];
+	Nibbles = static_cast<NIBBLETYPE>(
+		(Nibbles & (0xf0 >> ((a_Index & 1) * 4))) |  // The untouched nibble
+		(PaletteIndex << ((a_Index & 1) * 4))  // The nibble being set
+	);
+}
+
+
+
+
+
+void cChunkData::SetSectionBlockTypes(sChunkSection & a_Section, const BLOCKTYPE * a_Src)
+{
+	// Build the palette, until it overflows:
+	BLOCKTYPE Palette[PaletteSize];
+	size_t PaletteCount = 0;
+	UInt8 PaletteIndex[256];
+	memset(PaletteIndex, 0xff, sizeof(PaletteIndex));
+	for (size_t i = 0; i < SectionBlockCount; i++)
+	{
+		if (PaletteIndex[a_Src[i]] != 0xff)
+		{
+			continue;
+		}
+		if (PaletteCount == PaletteSize)
+		{
+			PaletteCount += 1;
+			break;
+		}
+		PaletteIndex[a_Src[i]] = static_cast<UInt8>(PaletteCount);
+		Palette[PaletteCount] = a_Src[i];
+		PaletteCount += 1;
+	}
+
+	if (PaletteCount > PaletteSize)
+	{
+		// Too many types for the palette, use the plain array:
+		FreeNibbles(a_Section.m_PackedBlockTypes);
+		if (a_Section.m_BlockTypes == nullptr)
+		{
+			a_Section.m_BlockTypes = m_BlockTypePool.Allocate();
+		}
+		memcpy(a_Section.m_BlockTypes->m_BlockTypes, a_Src, SectionBlockCount);
+		return;
+	}
+
+	sSectionNibbles * Packed = a_Section.m_PackedBlockTypes;
+	a_Section.m_PackedBlockTypes = nullptr;
+	FreeBlockTypes(a_Section);
+	memcpy(a_Section.m_Palette, Palette, PaletteCount);
+	a_Section.m_PaletteCount = static_cast<UInt8>(PaletteCount);
+	if (PaletteCount == 1)
+	{
+		// A single type needs no array:
+		FreeNibbles(Packed);
+		return;
+	}
+
+	if (Packed == nullptr)
+	{
+		Packed = m_NibblePool.Allocate();
+	}
+	for (size_t i = 0; i < SectionNibbleCount; i++)
+	{
+		Packed->m_Nibbles[i] = static_cast<NIBBLETYPE>(PaletteIndex[a_Src[2 * i]] | (PaletteIndex[a_Src[2 * i + 1]] << 4));
+	}
+	a_Section.m_PackedBlockTypes = Packed;
+}
+
+
+
+
+
+void cChunkData::CopySectionBlockTypes(sChunkSection & a_Dst, const sChunkSection & a_Src)
+{
+	ASSERT((a_Dst.m_BlockTypes == nullptr) && (a_Dst.m_PackedBlockTypes == nullptr));
+	memcpy(a_Dst.m_Palette, a_Src.m_Palette, sizeof(a_Src.m_Palette));
+	a_Dst.m_PaletteCount = a_Src.m_PaletteCount;
+	if (a_Src.m_BlockTypes != nullptr)
+	{
+		a_Dst.m_BlockTypes = m_BlockTypePool.Allocate();
+		memcpy(a_Dst.m_BlockTypes->m_BlockTypes, a_Src.m_BlockTypes->m_BlockTypes, SectionBlockCount);
+	}
+	else if (a_Src.m_PackedBlockTypes != nullptr)
+	{
+		a_Dst.m_PackedBlockTypes = m_NibblePool.Allocate();
+		memcpy(a_Dst.m_PackedBlockTypes->m_Nibbles, a_Src.m_PackedBlockTypes->m_Nibbles, SectionNibbleCount);
+	}
+}
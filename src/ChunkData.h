@@ -3,6 +3,17 @@
 
 // Declares the cChunkData class that represents the block's type, meta, blocklight and skylight storage for a chunk
 
+/*
+Each section's block types are stored in the smallest of three forms, chosen by the number of distinct types in it:
+	- a single type for the whole section (all stone, all air above the ground), with no array at all;
+	- up to PaletteSize types, listed in the section's palette, with a nibble array of 4-bit indices into it;
+	- any number of types, as the plain 8-bit array.
+BLOCKTYPE is a single byte, so a palette with 8-bit indices would save nothing over the plain array, which is
+what the 8-bit form is. SetBlock() moves a section to a larger form when a new type doesn't fit; the sections
+shrink back to the smallest form whenever their whole contents are replaced (SetBlockTypes(), FillBlockTypes()).
+The light arrays and the packed block types are nibble arrays of the same size, and share a pool.
+*/
+
 
 
 
@@ -24,15 +35,98 @@ public:
 	static const size_t NumSections = (cChunkDef::Height / SectionHeight);
 	static const size_t SectionBlockCount = SectionHeight * cChunkDef::Width * cChunkDef::Width;
 
+	static const size_t SectionNibbleCount = SectionBlockCount / 2;
+
+	/** The maximum number of distinct block types in a section stored as 4-bit indices into its palette. */
+	static const size_t PaletteSize = 16;
+
+	/** A nibble array of a single section, allocated from its own pool, separately from the section.
+	Used for the light and for the packed block types (4-bit indices into the section's palette). */
+	struct sSectionNibbles
+	{
+		NIBBLETYPE m_Nibbles[SectionNibbleCount];
+	};
+
+	/** The plain block types of a single section, allocated from its own pool, for the sections with too many types for the palette. */
+	struct sSectionBlockTypes
+	{
+		BLOCKTYPE m_BlockTypes[SectionBlockCount];
+	};
+
 	struct sChunkSection
 	{
-		BLOCKTYPE  m_BlockTypes[SectionBlockCount];
-		NIBBLETYPE m_BlockMetas[SectionBlockCount / 2];
-		NIBBLETYPE m_BlockLight[SectionBlockCount / 2];
-		NIBBLETYPE m_BlockSkyLight[SectionBlockCount / 2];
+		/** The block types used in the section, when not stored as the plain array. The first m_PaletteCount entries are valid.
+		With a single entry, the whole section is that block type. */
+		BLOCKTYPE m_Palette[PaletteSize];
+		UInt8 m_PaletteCount;
+
+		/** The 4-bit indices into m_Palette, allocated only if the section has more than one type and fits the palette. */
+		sSectionNibbles * m_PackedBlockTypes;
+
+		/** The plain block types, allocated only if the section has more types than fit the palette; m_Palette is unused then. */
+		sSectionBlockTypes * m_BlockTypes;
+
+		NIBBLETYPE m_BlockMetas[SectionNibbleCount];
+
+		/** The light arrays, allocated only if the section isn't fully dark or fully lit.
+		If nullptr, the entire section has the light value stored in m_UniformBlockLight / m_UniformSkyLight. */
+		sSectionNibbles * m_BlockLight;
+		sSectionNibbles * m_BlockSkyLight;
+		NIBBLETYPE m_UniformBlockLight;
+		NIBBLETYPE m_UniformSkyLight;
+
+		/** Returns the blocklight nibbles of the whole section, either the allocated array or a shared uniform one. */
+		const NIBBLETYPE * GetBlockLight(void) const;
+
+		/** Returns the skylight nibbles of the whole section, either the allocated array or a shared uniform one. */
+		const NIBBLETYPE * GetSkyLight(void) const;
+
+		/** Returns the block type at the specified index within the section, whatever its storage form. */
+		BLOCKTYPE GetBlockType(size_t a_Index) const
+		{
+			if (m_BlockTypes != nullptr)
+			{
+				return m_BlockTypes->m_BlockTypes[a_Index];
+			}
+			if (m_PackedBlockTypes != nullptr)
+			{
+				return m_Palette[(m_PackedBlockTypes->m_Nibbles[a_Index / 2] >> ((a_Index & 1) * 4)) & 0x0f];
+			}
+			return m_Palette[0];
+		}
+
+		/** Copies a_Length block types of the section, starting at index a_Idx, into the flat array a_Dest. */
+		void CopyBlockTypes(BLOCKTYPE * a_Dest, size_t a_Idx = 0, size_t a_Length = SectionBlockCount) const;
+
+		/** Returns the block types of the whole section as a flat array: the section's own plain array if it has one,
+		otherwise a_Buffer (of SectionBlockCount elements), filled with the unpacked types. */
+		const BLOCKTYPE * GetBlockTypes(BLOCKTYPE * a_Buffer) const;
+	};
+
+	/** The numbers of the sections in each storage form and the bytes taken from the pools, for the memory reports. */
+	struct sMemoryStats
+	{
+		size_t m_NumSingleType;  ///< Sections of a single block type, without any block type array
+		size_t m_NumPacked;      ///< Sections with the 4-bit palette indices
+		size_t m_NumPlain;       ///< Sections with the plain 8-bit block types
+		size_t m_NumLightArrays; ///< Light arrays allocated, for the sections that aren't fully dark or fully lit
+		size_t m_NumBytes;       ///< All the bytes taken from the pools
+
+		sMemoryStats(void):
+			m_NumSingleType(0),
+			m_NumPacked(0),
+			m_NumPlain(0),
+			m_NumLightArrays(0),
+			m_NumBytes(0)
+		{
+		}
 	};
 
-	cChunkData(cAllocationPool<sChunkSection> & a_Pool);
+	cChunkData(
+		cAllocationPool<sChunkSection> & a_Pool,
+		cAllocationPool<sSectionNibbles> & a_NibblePool,
+		cAllocationPool<sSectionBlockTypes> & a_BlockTypePool
+	);
 	cChunkData(cChunkData && a_Other);
 	~cChunkData();
 
@@ -58,9 +152,23 @@ public:
 
 	NIBBLETYPE GetSkyLight(int a_RelX, int a_RelY, int a_RelZ) const;
 
+	/** Sets the blocklight of a single block, allocating the section and its light array if needed.
+	Returns true if the value has changed. */
+	bool SetBlockLight(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light);
+
+	/** Sets the skylight of a single block, allocating the section and its light array if needed.
+	Returns true if the value has changed. */
+	bool SetSkyLight(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light);
+
 	/** Return a pointer to the chunk section or nullptr if all air */
 	const sChunkSection * GetSection(size_t a_SectionNum) const;
 
+	/** Picks a_NumPerSection random blocks in each section whose a_NumTickable[] count (NumSections items) is nonzero,
+	and adds the picked blocks whose types are set in a_IsTickable (256 items) to a_Blocks, as relative coords.
+	Used for the random block ticks. Only reads the data and uses the calling thread's random generator, so it can be
+	called for different chunks from multiple threads at once. */
+	void PickRandomBlocks(const bool * a_IsTickable, const UInt16 * a_NumTickable, int a_NumPerSection, std::vector<Vector3i> & a_Blocks) const;
+
 	/** Returns a bitmask of chunk sections which are currently stored. */
 	UInt16 GetSectionBitmask() const;
 
@@ -115,22 +223,75 @@ public:
 	/** Returns the number of sections present (i.e. non-air). */
 	UInt32 NumPresentSections() const;
 
+	/** Returns the number of bytes taken from the pools for the sections and their block type and light arrays. */
+	size_t GetMemoryUsage(void) const;
+
+	/** Adds the numbers of this chunk's sections in each storage form, and their memory, to a_Stats. */
+	void AddMemoryStats(sMemoryStats & a_Stats) const;
+
+	/** Returns the generation of the data, a number that changes with every modification.
+	Each instance, including each copy, has its own range of generations, so no two instances ever report the same one
+	and it can be used as a cache key. Callers that need to identify the data of a copy need to remember the original's generation. */
+	UInt64 GetGeneration(void) const { return m_Generation; }
+
+	/** Changes the generation, for modifications of data that is stored alongside but outside of this object, such as biomes. */
+	void MarkChanged(void) { ++m_Generation; }
+
 private:
 
 	sChunkSection * m_Sections[NumSections];
 
 	cAllocationPool<sChunkSection> & m_Pool;
 
+	/** The pool of the light arrays of the sections that aren't fully dark or fully lit, and of the packed block types. */
+	cAllocationPool<sSectionNibbles> & m_NibblePool;
+
+	/** The pool of the plain block type arrays of the sections with too many types for the palette. */
+	cAllocationPool<sSectionBlockTypes> & m_BlockTypePool;
+
+	/** The current generation of the data, see GetGeneration(). */
+	UInt64 m_Generation;
+
+	/** Returns the starting generation for a new instance. */
+	static UInt64 NewGeneration(void);
+
 	/** Allocates a new section. Entry-point to custom allocators. */
 	sChunkSection * Allocate(void);
 
-	/** Frees the specified section, previously allocated using Allocate().
+	/** Frees the specified section, previously allocated using Allocate(), including its block type and light arrays.
 	Note that a_Section may be nullptr. */
 	void Free(sChunkSection * a_Section);
 
-	/** Sets the data in the specified section to their default values. */
+	/** Frees the nibble array, if any, and sets it to nullptr. */
+	void FreeNibbles(sSectionNibbles *& a_Nibbles);
+
+	/** Frees the section's block type arrays, if any; the section is left with a single block type, air. */
+	void FreeBlockTypes(sChunkSection & a_Section);
+
+	/** Sets the data in the specified section to their default values.
+	Doesn't free the arrays, the section is expected to have none. */
 	void ZeroSection(sChunkSection * a_Section) const;
 
+	/** Sets a single block type in the section, moving the section to a larger storage form if the type doesn't fit. */
+	void SetSectionBlockType(sChunkSection & a_Section, size_t a_Index, BLOCKTYPE a_BlockType);
+
+	/** Replaces all the section's block types with the flat array a_Src, in the smallest storage form that fits it. */
+	void SetSectionBlockTypes(sChunkSection & a_Section, const BLOCKTYPE * a_Src);
+
+	/** Copies the block types of a_Src into a_Dst, in the same storage form. a_Dst is expected to have no arrays. */
+	void CopySectionBlockTypes(sChunkSection & a_Dst, const sChunkSection & a_Src);
+
+	/** Copies the specified flat light data into the section's light array.
+	Frees the array if the data is fully dark or fully lit, allocates it if needed otherwise. */
+	void SetSectionLight(sSectionNibbles *& a_Light, NIBBLETYPE & a_UniformLight, const NIBBLETYPE * a_Src);
+
+	/** Fills the section's light array with the specified value, allocating or freeing the array as needed. */
+	void FillSectionLight(sSectionNibbles *& a_Light, NIBBLETYPE & a_UniformLight, NIBBLETYPE a_Value);
+
+	/** Sets a single nibble in the section's light array, expanding a uniform section into an array first if needed.
+	Returns true if the value has changed. */
+	bool SetSectionLightNibble(sSectionNibbles *& a_Light, NIBBLETYPE a_UniformLight, int a_Index, NIBBLETYPE a_Value);
+
 };
 
 
@@ -106,8 +106,9 @@ class cChunkDataCopyCollector :
 	public cChunkDataCallback
 {
 public:
+	template <class T>
 	struct MemCallbacks:
-		cAllocationPool<cChunkData::sChunkSection>::cStarvationCallbacks
+		cAllocationPool<T>::cStarvationCallbacks
 	{
 		virtual void OnStartUsingReserve() override {}
 		virtual void OnEndUsingReserve() override {}
@@ -115,20 +116,29 @@ public:
 	};
 
 	cChunkDataCopyCollector():
-		m_Pool(cpp14::make_unique<MemCallbacks>()),
-		m_Data(m_Pool)
+		m_Pool(cpp14::make_unique<MemCallbacks<cChunkData::sChunkSection>>()),
+		m_NibblePool(cpp14::make_unique<MemCallbacks<cChunkData::sSectionNibbles>>()),
+		m_BlockTypePool(cpp14::make_unique<MemCallbacks<cChunkData::sSectionBlockTypes>>()),
+		m_Data(m_Pool, m_NibblePool, m_BlockTypePool),
+		m_SourceGeneration(0)
 	{
 	}
 
 
 	cListAllocationPool<cChunkData::sChunkSection, cChunkData::NumSections> m_Pool;  // Keep 1 chunk worth of reserve
+	cListAllocationPool<cChunkData::sSectionNibbles, cChunkData::NumSections * 3> m_NibblePool;  // Both light arrays and the packed block types of 1 chunk
+	cListAllocationPool<cChunkData::sSectionBlockTypes, cChunkData::NumSections> m_BlockTypePool;  // The plain block types of 1 chunk
 	cChunkData m_Data;
 
+	/** The generation of the data that m_Data was copied from (the copy gets its own). */
+	UInt64 m_SourceGeneration;
+
 protected:
 
 	virtual void ChunkData(const cChunkData & a_ChunkBuffer) override
 	{
 		m_Data.Assign(a_ChunkBuffer);
+		m_SourceGeneration = a_ChunkBuffer.GetGeneration();
 	}
 };
 
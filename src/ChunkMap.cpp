@@ -20,6 +20,7 @@
 #include "Entities/Pickup.h"
 #include "DeadlockDetect.h"
 #include "BlockEntities/BlockEntity.h"
+#include "TickProfiler.h"
 
 #ifndef _WIN32
 	#include <cstdlib>  // abs
@@ -40,7 +41,21 @@ cChunkMap::cChunkMap(cWorld * a_World) :
 	m_Pool(
 		new cListAllocationPool<cChunkData::sChunkSection, 1600>(
 			std::unique_ptr<cAllocationPool<cChunkData::sChunkSection>::cStarvationCallbacks>(
-				new cStarvationCallbacks()
+				new cStarvationCallbacks<cChunkData::sChunkSection>()
+			)
+		)
+	),
+	m_NibblePool(
+		new cListAllocationPool<cChunkData::sSectionNibbles, 1600>(
+			std::unique_ptr<cAllocationPool<cChunkData::sSectionNibbles>::cStarvationCallbacks>(
+				new cStarvationCallbacks<cChunkData::sSectionNibbles>()
+			)
+		)
+	),
+	m_BlockTypePool(
+		new cListAllocationPool<cChunkData::sSectionBlockTypes, 1600>(
+			std::unique_ptr<cAllocationPool<cChunkData::sSectionBlockTypes>::cStarvationCallbacks>(
+				new cStarvationCallbacks<cChunkData::sSectionBlockTypes>()
 			)
 		)
 	)
@@ -81,7 +96,9 @@ cChunkPtr cChunkMap::ConstructChunk(int a_ChunkX, int a_ChunkZ)
 					FindChunk(a_ChunkX + 1, a_ChunkZ),
 					FindChunk(a_ChunkX, a_ChunkZ - 1),
 					FindChunk(a_ChunkX, a_ChunkZ + 1),
-					*m_Pool
+					*m_Pool,
+					*m_NibblePool,
+					*m_BlockTypePool
 				)
 			).first
 		).second.get();
@@ -487,6 +504,22 @@ void cChunkMap::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientH
 
 
 
+void cChunkMap::BroadcastEntityMovement(const cEntity & a_Entity, const cClientHandle * a_Exclude)
+{
+	cCSLock Lock(m_CSChunks);
+	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), a_Entity.GetChunkZ());
+	if (Chunk == nullptr)
+	{
+		return;
+	}
+	// It's perfectly legal to broadcast packets even to invalid chunks!
+	Chunk->BroadcastEntityMovement(a_Entity, a_Exclude);
+}
+
+
+
+
+
 void cChunkMap::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
 	cCSLock Lock(m_CSChunks);
@@ -2486,6 +2519,21 @@ void cChunkMap::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty)
 
 
 
+cChunkData::sMemoryStats cChunkMap::GetChunkDataMemoryStats(void)
+{
+	cChunkData::sMemoryStats Res;
+	cCSLock Lock(m_CSChunks);
+	for (const auto & Chunk : m_Chunks)
+	{
+		Chunk.second->m_ChunkData.AddMemoryStats(Res);
+	}
+	return Res;
+}
+
+
+
+
+
 bool cChunkMap::GrowMelonPumpkin(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType)
 {
 	int ChunkX, ChunkZ;
@@ -2611,17 +2659,62 @@ void cChunkMap::SpawnMobs(cMobSpawner & a_MobSpawner)
 
 
 
+void cChunkMap::StartTickWorkers(int a_NumWorkers)
+{
+	m_TickScheduler.Start(a_NumWorkers);
+}
+
+
+
+
+
+void cChunkMap::StopTickWorkers(void)
+{
+	m_TickScheduler.Stop();
+}
+
+
+
+
+
 void cChunkMap::Tick(std::chrono::milliseconds a_Dt)
 {
 	cCSLock Lock(m_CSChunks);
+	std::vector<cChunk *> TickedChunks;
+	std::vector<cChunkCoords> TickedCoords;
+	TickedChunks.reserve(m_Chunks.size());
+	TickedCoords.reserve(m_Chunks.size());
 	for (const auto & Chunk : m_Chunks)
 	{
 		// Only tick chunks that are valid and should be ticked:
 		if (Chunk.second->IsValid() && Chunk.second->ShouldBeTicked())
 		{
-			Chunk.second->Tick(a_Dt);
+			TickedChunks.push_back(Chunk.second.get());
+			TickedCoords.emplace_back(Chunk.second->GetPosX(), Chunk.second->GetPosZ());
 		}
 	}
+
+	// Prepare the ticks of all the chunks, on the tick workers if there are any:
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "PrepareChunkTicks");
+		m_TickScheduler.Run(TickedCoords, [&TickedChunks](size_t a_ChunkIndex)
+			{
+				TickedChunks[a_ChunkIndex]->PrepareTick();
+			}
+		);
+	}
+
+	// GetChunk() may add new chunks into m_Chunks while ticking, hence the separate list:
+	for (auto Chunk : TickedChunks)
+	{
+		Chunk->Tick(a_Dt);
+	}
+
+	// Move the entities that crossed chunk borders only after all chunks have ticked, so that each entity is ticked exactly once:
+	for (auto Chunk : TickedChunks)
+	{
+		Chunk->MoveEntitiesToNewChunks();
+	}
 }
 
 
@@ -2671,12 +2764,36 @@ void cChunkMap::UnloadUnusedChunks(void)
 void cChunkMap::SaveAllChunks(void)
 {
 	cCSLock Lock(m_CSChunks);
+	std::vector<cChunkCoords> ToSave;
 	for (const auto & Chunk : m_Chunks)
 	{
 		if (Chunk.second->IsValid() && Chunk.second->IsDirty())
 		{
-			GetWorld()->GetStorage().QueueSaveChunk(Chunk.first.ChunkX, Chunk.first.ChunkZ);
+			ToSave.emplace_back(Chunk.first.ChunkX, Chunk.first.ChunkZ);
+		}
+	}
+
+	// Queue the chunks grouped by their region (32 x 32 chunks), so that the storage saves each region file in one go:
+	std::sort(ToSave.begin(), ToSave.end(), [](const cChunkCoords & a_Lhs, const cChunkCoords & a_Rhs)
+		{
+			int LhsRegionX = FAST_FLOOR_DIV(a_Lhs.m_ChunkX, 32);
+			int RhsRegionX = FAST_FLOOR_DIV(a_Rhs.m_ChunkX, 32);
+			if (LhsRegionX != RhsRegionX)
+			{
+				return (LhsRegionX < RhsRegionX);
+			}
+			int LhsRegionZ = FAST_FLOOR_DIV(a_Lhs.m_ChunkZ, 32);
+			int RhsRegionZ = FAST_FLOOR_DIV(a_Rhs.m_ChunkZ, 32);
+			if (LhsRegionZ != RhsRegionZ)
+			{
+				return (LhsRegionZ < RhsRegionZ);
+			}
+			return (a_Lhs.m_ChunkZ == a_Rhs.m_ChunkZ) ? (a_Lhs.m_ChunkX < a_Rhs.m_ChunkX) : (a_Lhs.m_ChunkZ < a_Rhs.m_ChunkZ);
 		}
+	);
+	for (const auto & Coords : ToSave)
+	{
+		GetWorld()->GetStorage().QueueSaveChunk(Coords.m_ChunkX, Coords.m_ChunkZ);
 	}
 }
 
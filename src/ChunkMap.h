@@ -9,6 +9,7 @@
 #include <functional>
 
 #include "ChunkDataCallback.h"
+#include "ChunkTickScheduler.h"
 #include "EffectID.h"
 #include "FunctionRef.h"
 
@@ -82,6 +83,7 @@ public:
 	void BroadcastEntityHeadLook(const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityLook(const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityMetadata(const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
+	void BroadcastEntityMovement(const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMoveLook(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityStatus(const cEntity & a_Entity, char a_Status, const cClientHandle * a_Exclude = nullptr);
@@ -369,6 +371,9 @@ public:
 	/** Returns the number of valid chunks and the number of dirty chunks */
 	void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty);
 
+	/** Returns the memory stats of the block and light data of all loaded chunks: the sections in each storage form and the bytes allocated */
+	cChunkData::sMemoryStats GetChunkDataMemoryStats(void);
+
 	/** Grows a melon or a pumpkin next to the block specified (assumed to be the stem); returns true if the pumpkin or melon sucessfully grew */
 	bool GrowMelonPumpkin(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType);
 
@@ -390,6 +395,15 @@ public:
 	/** Try to Spawn Monsters inside all Chunks */
 	void SpawnMobs(cMobSpawner & a_MobSpawner);
 
+	/** Starts the specified number of threads that prepare the chunks' ticks along with the tick thread (cChunkTickScheduler).
+	With zero threads, the ticks are prepared on the tick thread only. */
+	void StartTickWorkers(int a_NumWorkers);
+
+	/** Stops the threads started by StartTickWorkers(). Must not be called while the chunkmap is being ticked. */
+	void StopTickWorkers(void);
+
+	/** Ticks all the valid chunks that should be ticked: first prepares their ticks (cChunk::PrepareTick()), possibly on
+	the tick workers, then ticks them one by one on the calling thread, then moves the entities that crossed the chunks' borders. */
 	void Tick(std::chrono::milliseconds a_Dt);
 
 	/** Ticks a single block. Used by cWorld::TickQueuedBlocks() to tick the queued blocks */
@@ -435,8 +449,9 @@ private:
 	friend class cChunkStay;
 
 
+	template <class T>
 	class cStarvationCallbacks
-		: public cAllocationPool<cChunkData::sChunkSection>::cStarvationCallbacks
+		: public cAllocationPool<T>::cStarvationCallbacks
 	{
 		virtual void OnStartUsingReserve() override
 		{
@@ -476,6 +491,9 @@ private:
 
 	cEvent m_evtChunkValid;  // Set whenever any chunk becomes valid, via ChunkValidated()
 
+	/** Runs the chunks' PrepareTick() in Tick(), on the tick workers. */
+	cChunkTickScheduler m_TickScheduler;
+
 	cWorld * m_World;
 
 	/** The cChunkStay descendants that are currently enabled in this chunkmap */
@@ -483,6 +501,13 @@ private:
 
 	std::unique_ptr<cAllocationPool<cChunkData::sChunkSection> > m_Pool;
 
+	/** The pool of the sections' nibble arrays: the light arrays of the sections that aren't fully dark or fully lit,
+	and the packed block types of the sections with a few block types. */
+	std::unique_ptr<cAllocationPool<cChunkData::sSectionNibbles> > m_NibblePool;
+
+	/** The pool of the plain block type arrays, used by the sections with more block types than fit the palette. */
+	std::unique_ptr<cAllocationPool<cChunkData::sSectionBlockTypes> > m_BlockTypePool;
+
 	/** Returns or creates and returns a chunk pointer corresponding to the given chunk coordinates.
 	Emplaces this chunk in the chunk map.
 	Developers SHOULD use the GetChunk variants instead of this function. */
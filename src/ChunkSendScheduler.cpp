@@ -0,0 +1,209 @@
+
+// ChunkSendScheduler.cpp
+
+// Implements the cChunkSendScheduler class that paces the chunks streamed to a single client by its connection's capacity
+
+#include "Globals.h"
+#include "ChunkSendScheduler.h"
+
+
+
+
+
+/** The round trip time used for the budget is never lower than this, so that a client on the same host still gets a reasonable budget. */
+static const std::chrono::milliseconds MIN_BUDGET_RTT(50);
+
+/** The budget allows this many round trips' worth of data in flight. */
+static const double BUDGET_RTTS = 2.0;
+
+/** Round trip times this much over the minimum mean the data is queueing up on the way. */
+static const std::chrono::milliseconds RTT_QUEUEING_THRESHOLD(100);
+
+/** Weight of a new sample in the moving averages. */
+static const double SAMPLE_WEIGHT = 1.0 / 8.0;
+
+/** How much the bandwidth estimate grows in a single flush while probing. */
+static const double PROBE_GAIN = 1.125;
+
+/** How much the bandwidth estimate shrinks when the round trip time shows queueing. */
+static const double BACKOFF_FACTOR = 0.75;
+
+/** Flushes closer to each other than this don't give a usable drain rate sample. */
+static const std::chrono::milliseconds MIN_SAMPLE_INTERVAL(1);
+
+
+
+
+
+cChunkSendScheduler::cChunkSendScheduler(void) :
+	m_Bandwidth(INITIAL_BANDWIDTH),
+	m_NumRttSamples(0),
+	m_NextRttSample(0),
+	m_UnsentAfterFlush(0),
+	m_ChunkBytesInLink(0),
+	m_ChunkBytesSinceFlush(0),
+	m_WasBudgetLimited(false)
+{
+}
+
+
+
+
+
+void cChunkSendScheduler::OnFlush(std::chrono::steady_clock::time_point a_Now, size_t a_UnsentBefore, size_t a_NumFlushed)
+{
+	cCSLock Lock(m_CS);
+
+	// Update the bandwidth estimate from the drain rate since the last flush:
+	auto Interval = a_Now - m_LastFlushTime;
+	if ((m_LastFlushTime != std::chrono::steady_clock::time_point()) && (Interval >= MIN_SAMPLE_INTERVAL))
+	{
+		// Data sent directly into the link in the meantime (kicks etc.) could make the buffer grow, count that as no progress:
+		size_t Drained = (m_UnsentAfterFlush > a_UnsentBefore) ? (m_UnsentAfterFlush - a_UnsentBefore) : 0;
+		double Sample = static_cast<double>(Drained) / std::chrono::duration_cast<std::chrono::duration<double>>(Interval).count();
+		if (a_UnsentBefore > 0)
+		{
+			// The link never ran dry, the connection was the bottleneck for the whole interval:
+			m_Bandwidth += (Sample - m_Bandwidth) * SAMPLE_WEIGHT;
+		}
+		else if (m_WasBudgetLimited)
+		{
+			// The connection took everything and the budget held the streaming back, probe for more:
+			m_Bandwidth = std::max(Sample, m_Bandwidth * PROBE_GAIN);
+		}
+		else
+		{
+			// There wasn't enough data to fill the connection, the sample only says it's at least this fast:
+			m_Bandwidth = std::max(Sample, m_Bandwidth);
+		}
+		m_Bandwidth = std::max(m_Bandwidth, static_cast<double>(MIN_BANDWIDTH));
+	}
+	m_LastFlushTime = a_Now;
+	m_WasBudgetLimited = false;
+
+	// The chunk data in the link can't be more than all the data in it; what's left of it now also contains the newly flushed chunks:
+	m_ChunkBytesInLink = std::min(m_ChunkBytesInLink, a_UnsentBefore) + m_ChunkBytesSinceFlush;
+	m_ChunkBytesSinceFlush = 0;
+	m_UnsentAfterFlush = a_UnsentBefore + a_NumFlushed;
+}
+
+
+
+
+
+void cChunkSendScheduler::OnRttSample(std::chrono::steady_clock::duration a_Rtt)
+{
+	cCSLock Lock(m_CS);
+
+	// The keep-alive waited behind the data in the link, take that time out so that the budget doesn't feed on its own queue:
+	auto LinkDelay = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(static_cast<double>(m_UnsentAfterFlush) / m_Bandwidth)
+	);
+	auto Rtt = std::max(a_Rtt - LinkDelay, a_Rtt / 4);
+
+	// A round trip still much slower than the minimum means the packets wait in another queue (the OS's socket buffer), back off:
+	if ((m_NumRttSamples > 0) && (Rtt > MinRtt() * 2 + RTT_QUEUEING_THRESHOLD))
+	{
+		m_Bandwidth = std::max(m_Bandwidth * BACKOFF_FACTOR, static_cast<double>(MIN_BANDWIDTH));
+	}
+
+	m_RttSamples[m_NextRttSample] = Rtt;
+	m_NextRttSample = (m_NextRttSample + 1) % NUM_RTT_SAMPLES;
+	m_NumRttSamples = std::min(m_NumRttSamples + 1, m_RttSamples.size());
+}
+
+
+
+
+
+void cChunkSendScheduler::OnChunkQueued(size_t a_NumBytes)
+{
+	cCSLock Lock(m_CS);
+	m_ChunkBytesSinceFlush += a_NumBytes;
+}
+
+
+
+
+
+bool cChunkSendScheduler::CanRequestChunk(void)
+{
+	cCSLock Lock(m_CS);
+
+	// Only the data already serialized and queued counts, the chunks still being generated don't occupy the connection:
+	size_t InFlight = m_UnsentAfterFlush + m_ChunkBytesSinceFlush;
+	if (InFlight < Budget())
+	{
+		return true;
+	}
+	m_WasBudgetLimited = true;
+	return false;
+}
+
+
+
+
+
+size_t cChunkSendScheduler::GetQueuedChunkBytes(void) const
+{
+	cCSLock Lock(m_CS);
+	return m_ChunkBytesInLink + m_ChunkBytesSinceFlush;
+}
+
+
+
+
+
+double cChunkSendScheduler::GetBandwidth(void) const
+{
+	cCSLock Lock(m_CS);
+	return m_Bandwidth;
+}
+
+
+
+
+
+std::chrono::steady_clock::duration cChunkSendScheduler::GetMinRtt(void) const
+{
+	cCSLock Lock(m_CS);
+	return MinRtt();
+}
+
+
+
+
+
+size_t cChunkSendScheduler::GetBudget(void) const
+{
+	cCSLock Lock(m_CS);
+	return Budget();
+}
+
+
+
+
+
+std::chrono::steady_clock::duration cChunkSendScheduler::MinRtt(void) const
+{
+	if (m_NumRttSamples == 0)
+	{
+		return std::chrono::steady_clock::duration::zero();
+	}
+	return *std::min_element(m_RttSamples.begin(), m_RttSamples.begin() + static_cast<std::ptrdiff_t>(m_NumRttSamples));
+}
+
+
+
+
+
+size_t cChunkSendScheduler::Budget(void) const
+{
+	auto Rtt = std::max<std::chrono::steady_clock::duration>(MinRtt(), MIN_BUDGET_RTT);
+	double Budget = m_Bandwidth * std::chrono::duration_cast<std::chrono::duration<double>>(Rtt).count() * BUDGET_RTTS;
+	return static_cast<size_t>(Clamp(Budget, static_cast<double>(MIN_BUDGET), static_cast<double>(MAX_BUDGET)));
+}
+
+
+
+
@@ -0,0 +1,131 @@
+
+// ChunkSendScheduler.h
+
+// Declares the cChunkSendScheduler class that paces the chunks streamed to a single client by its connection's capacity
+
+/*
+Chunk data is by far the bulk of what the server sends. Without pacing, the client handle would ask for chunks
+as fast as the world can provide them and all of them would end up queued in the link's output buffer; on a
+slow connection that queue grows to megabytes and every other packet (movement, chat, block changes) waits
+behind it for seconds.
+
+The scheduler keeps the amount of data in flight (queued in the link and not yet written to the socket) close to
+what the connection can drain in a couple of round trips. It estimates the achieved bandwidth from how fast the
+link's output buffer drains between flushes, and the round trip time from the keep-alive packets, and allows
+the client handle to request another chunk only while the data in flight fits the resulting budget.
+Only the chunks whose data has been serialized and queued count as in flight; the chunks still being loaded or
+generated don't occupy the connection, and counting them would stall the streaming behind a slow generator.
+The client handle's limit on the chunks requested per tick bounds how far a single tick may overshoot.
+
+While the link's buffer doesn't empty between two flushes, the connection is the bottleneck and the drain rate
+is its bandwidth. When the buffer empties and the budget has been limiting the streaming, the estimate is probed
+upwards; a round trip time well above the minimum means the data is queueing up somewhere on the way (e.g. in
+the OS's socket buffer), and the estimate is backed off.
+
+All the functions are thread-safe: the flushes and keep-alives are reported from the tick thread, the chunks
+are reported from the chunk sender thread and the stats may be read from anywhere.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cChunkSendScheduler
+{
+public:
+
+	/** The budget is never lower than this, so that even the slowest connection gets a chunk or two going. */
+	static const size_t MIN_BUDGET = 64 KiB;
+
+	/** The budget is never higher than this, more in flight doesn't make the streaming any faster on a LAN. */
+	static const size_t MAX_BUDGET = 4 MiB;
+
+	/** The bandwidth assumed before anything is measured, in bytes per second. */
+	static const size_t INITIAL_BANDWIDTH = 512 KiB;
+
+	/** The bandwidth estimate is never lower than this, in bytes per second. */
+	static const size_t MIN_BANDWIDTH = 16 KiB;
+
+	/** The number of the latest round trip time samples that the minimum is taken from. */
+	static const size_t NUM_RTT_SAMPLES = 8;
+
+
+	cChunkSendScheduler(void);
+
+	/** Called each time the outgoing data is flushed into the link.
+	a_UnsentBefore is the number of bytes that were still waiting in the link before the flush, a_NumFlushed is the number of bytes flushed. */
+	void OnFlush(std::chrono::steady_clock::time_point a_Now, size_t a_UnsentBefore, size_t a_NumFlushed);
+
+	/** Called when a round trip time has been measured.
+	The time the measuring packet spent waiting behind the data in the link is subtracted from the sample. */
+	void OnRttSample(std::chrono::steady_clock::duration a_Rtt);
+
+	/** Called when the data of a chunk has been queued for sending to the client. */
+	void OnChunkQueued(size_t a_NumBytes);
+
+	/** Returns true if another chunk may be requested for the client, that is, the data in flight fits the budget.
+	Returning false marks the streaming as limited by the budget, which allows the bandwidth estimate to grow. */
+	bool CanRequestChunk(void);
+
+	/** Returns the number of chunk data bytes queued for the client and not yet written to the socket.
+	This is an upper bound: the data in the link is assumed to be chunk data first. */
+	size_t GetQueuedChunkBytes(void) const;
+
+	/** Returns the current estimate of the connection's bandwidth, in bytes per second. */
+	double GetBandwidth(void) const;
+
+	/** Returns the lowest of the latest round trip times measured, or zero if none has been measured yet. */
+	std::chrono::steady_clock::duration GetMinRtt(void) const;
+
+	/** Returns the number of bytes currently allowed to be in flight. */
+	size_t GetBudget(void) const;
+
+protected:
+
+	/** Protects all the members against multithreaded access. */
+	mutable cCriticalSection m_CS;
+
+	/** The estimated bandwidth, in bytes per second. */
+	double m_Bandwidth;
+
+	/** The latest round trip time samples, used as a ring buffer. */
+	std::array<std::chrono::steady_clock::duration, NUM_RTT_SAMPLES> m_RttSamples;
+
+	/** The number of valid samples in m_RttSamples. */
+	size_t m_NumRttSamples;
+
+	/** Index into m_RttSamples where the next sample is written. */
+	size_t m_NextRttSample;
+
+	/** The time of the last flush, or the epoch if there was none yet. */
+	std::chrono::steady_clock::time_point m_LastFlushTime;
+
+	/** The number of bytes waiting in the link right after the last flush. */
+	size_t m_UnsentAfterFlush;
+
+	/** The number of chunk data bytes that were in the link right after the last flush. */
+	size_t m_ChunkBytesInLink;
+
+	/** The number of chunk data bytes queued since the last flush. */
+	size_t m_ChunkBytesSinceFlush;
+
+	/** Set when CanRequestChunk() refused a chunk since the last flush. */
+	bool m_WasBudgetLimited;
+
+
+	/** Returns the lowest RTT sample, or zero if there's none. Expects m_CS to be locked. */
+	std::chrono::steady_clock::duration MinRtt(void) const;
+
+	/** Returns the budget for the current estimates. Expects m_CS to be locked. */
+	size_t Budget(void) const;
+} ;
+
+
+
+
@@ -257,7 +257,7 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkZ, std::unordered_set<cCli
 	{
 		return;
 	}
-	cChunkDataSerializer Data(m_Data, m_BiomeMap, m_World.GetDimension());
+	cChunkDataSerializer Data(m_Data, m_BiomeMap, m_World.GetDimension(), &m_Cache, m_SourceGeneration);
 
 	for (const auto client : a_Clients)
 	{
@@ -27,6 +27,7 @@ Note that it may be called by world's BroadcastToChunk() if the client is still
 
 #include "OSSupport/IsThread.h"
 #include "ChunkDataCallback.h"
+#include "Protocol/ChunkDataCache.h"
 
 #include <unordered_set>
 #include <unordered_map>
@@ -78,6 +79,9 @@ public:
 	/** Removes the a_Client from all waiting chunk send operations */
 	void RemoveClient(cClientHandle * a_Client);
 
+	/** Returns the cache of the serialized chunk data, shared by all the chunk sends in the world. */
+	cChunkDataCache & GetCache(void) { return m_Cache; }
+
 protected:
 
 	struct sChunkQueue
@@ -118,6 +122,9 @@ protected:
 	cEvent m_evtQueue;  // Set when anything is added to m_ChunksReady
 	cEvent m_evtRemoved;  // Set when removed clients are safe to be deleted
 
+	/** The serialized chunk data kept for reuse by the later sends of the same unchanged chunks. */
+	cChunkDataCache m_Cache;
+
 	// Data about the chunk that is being sent:
 	// NOTE that m_BlockData[] is inherited from the cChunkDataCollector
 	unsigned char m_BiomeMap[cChunkDef::Width * cChunkDef::Width];
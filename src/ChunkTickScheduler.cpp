@@ -0,0 +1,272 @@
+
+// ChunkTickScheduler.cpp
+
+// Implements the cChunkTickScheduler class that runs a part of the chunks' tick on a pool of worker threads
+
+#include "Globals.h"
+#include "ChunkTickScheduler.h"
+
+
+
+
+
+cChunkTickScheduler::cChunkTickScheduler(void) :
+	m_Job(nullptr),
+	m_NextRegion(0),
+	m_NextRegionEnd(0),
+	m_NumRegionsLeft(0),
+	m_ShouldTerminate(false)
+{
+	std::fill(std::begin(m_ColorStart), std::end(m_ColorStart), 0);
+}
+
+
+
+
+
+cChunkTickScheduler::~cChunkTickScheduler()
+{
+	Stop();
+}
+
+
+
+
+
+void cChunkTickScheduler::Start(int a_NumWorkers)
+{
+	ASSERT(m_Workers.empty());
+	for (int i = a_NumWorkers; i > 0; i--)
+	{
+		m_Workers.push_back(cpp14::make_unique<cWorker>(*this));
+		m_Workers.back()->Start();
+	}
+}
+
+
+
+
+
+void cChunkTickScheduler::Stop(void)
+{
+	m_ShouldTerminate = true;
+	m_evtPhaseStarted.Set();  // Each terminating worker passes the event on to the next one
+	for (auto & Worker : m_Workers)
+	{
+		Worker->Wait();
+	}
+	m_Workers.clear();
+
+	// Run() keeps working on the calling thread alone, it mustn't see the termination:
+	m_ShouldTerminate = false;
+}
+
+
+
+
+
+void cChunkTickScheduler::Run(const std::vector<cChunkCoords> & a_Chunks, const cJob & a_Job)
+{
+	SortIntoRegions(a_Chunks);
+	m_Job = &a_Job;
+
+	for (size_t Color = 0; Color < 4; Color++)
+	{
+		if (m_ColorStart[Color] == m_ColorStart[Color + 1])
+		{
+			continue;
+		}
+
+		// Start the phase:
+		{
+			cCSLock Lock(m_CS);
+			m_NextRegion = m_ColorStart[Color];
+			m_NextRegionEnd = m_ColorStart[Color + 1];
+			m_NumRegionsLeft = m_NextRegionEnd - m_NextRegion;
+		}
+		if (!m_Workers.empty())
+		{
+			m_evtPhaseStarted.Set();
+		}
+
+		// Work on the regions along with the workers, then wait for the regions that the workers took:
+		size_t Region;
+		while (DequeueRegion(Region, false))
+		{
+			RunRegion(Region);
+		}
+		cCSLock Lock(m_CS);
+		while (m_NumRegionsLeft > 0)
+		{
+			cCSUnlock Unlock(Lock);
+			m_evtPhaseFinished.Wait();
+		}
+	}
+
+	m_Job = nullptr;
+}
+
+
+
+
+
+void cChunkTickScheduler::SortIntoRegions(const std::vector<cChunkCoords> & a_Chunks)
+{
+	// The sort key of each chunk: the color, then the region's X and Z coords:
+	struct sKey
+	{
+		size_t m_Color;
+		int m_RegionX;
+		int m_RegionZ;
+
+		bool operator < (const sKey & a_Other) const
+		{
+			if (m_Color != a_Other.m_Color)
+			{
+				return (m_Color < a_Other.m_Color);
+			}
+			if (m_RegionX != a_Other.m_RegionX)
+			{
+				return (m_RegionX < a_Other.m_RegionX);
+			}
+			return (m_RegionZ < a_Other.m_RegionZ);
+		}
+
+		bool IsSameRegion(const sKey & a_Other) const
+		{
+			return ((m_RegionX == a_Other.m_RegionX) && (m_RegionZ == a_Other.m_RegionZ));
+		}
+	};
+	std::vector<sKey> Keys;
+	Keys.reserve(a_Chunks.size());
+	for (const auto & Chunk : a_Chunks)
+	{
+		int RegionX = ChunkToRegion(Chunk.m_ChunkX);
+		int RegionZ = ChunkToRegion(Chunk.m_ChunkZ);
+		Keys.push_back({static_cast<size_t>((RegionX & 1) | ((RegionZ & 1) << 1)), RegionX, RegionZ});
+	}
+
+	// Keep the chunks of each region in their original order, that's the order of the serial tick:
+	m_Order.resize(a_Chunks.size());
+	for (size_t i = 0; i < m_Order.size(); i++)
+	{
+		m_Order[i] = i;
+	}
+	std::stable_sort(m_Order.begin(), m_Order.end(), [&Keys](size_t a_Index1, size_t a_Index2)
+		{
+			return (Keys[a_Index1] < Keys[a_Index2]);
+		}
+	);
+
+	// Cut the sorted chunks into the regions:
+	m_Regions.clear();
+	size_t Color = 0;
+	for (size_t i = 0; i < m_Order.size(); i++)
+	{
+		const auto & Key = Keys[m_Order[i]];
+		if ((i > 0) && (Key.m_Color == Keys[m_Order[i - 1]].m_Color) && Key.IsSameRegion(Keys[m_Order[i - 1]]))
+		{
+			m_Regions.back().m_End = i + 1;
+			continue;
+		}
+		while (Color <= Key.m_Color)
+		{
+			m_ColorStart[Color] = m_Regions.size();
+			Color += 1;
+		}
+		m_Regions.push_back({i, i + 1});
+	}
+	while (Color <= 4)
+	{
+		m_ColorStart[Color] = m_Regions.size();
+		Color += 1;
+	}
+}
+
+
+
+
+
+bool cChunkTickScheduler::DequeueRegion(size_t & a_Region, bool a_ShouldWait)
+{
+	cCSLock Lock(m_CS);
+	for (;;)
+	{
+		if (m_ShouldTerminate)
+		{
+			// Wake up the next worker so that it terminates, too:
+			m_evtPhaseStarted.Set();
+			return false;
+		}
+
+		if (m_NextRegion < m_NextRegionEnd)
+		{
+			a_Region = m_NextRegion;
+			m_NextRegion += 1;
+			if ((m_NextRegion < m_NextRegionEnd) && a_ShouldWait)
+			{
+				// There's more work, wake up another worker:
+				m_evtPhaseStarted.Set();
+			}
+			return true;
+		}
+
+		if (!a_ShouldWait)
+		{
+			return false;
+		}
+		cCSUnlock Unlock(Lock);
+		m_evtPhaseStarted.Wait();
+	}
+}
+
+
+
+
+
+void cChunkTickScheduler::RunRegion(size_t a_Region)
+{
+	const auto & Region = m_Regions[a_Region];
+	for (size_t i = Region.m_Begin; i < Region.m_End; i++)
+	{
+		(*m_Job)(m_Order[i]);
+	}
+
+	cCSLock Lock(m_CS);
+	ASSERT(m_NumRegionsLeft > 0);
+	m_NumRegionsLeft -= 1;
+	if (m_NumRegionsLeft == 0)
+	{
+		m_evtPhaseFinished.Set();
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkTickScheduler::cWorker:
+
+cChunkTickScheduler::cWorker::cWorker(cChunkTickScheduler & a_Parent) :
+	super("cChunkTickScheduler"),
+	m_Parent(a_Parent)
+{
+}
+
+
+
+
+
+void cChunkTickScheduler::cWorker::Execute(void)
+{
+	size_t Region;
+	while (m_Parent.DequeueRegion(Region, true))
+	{
+		m_Parent.RunRegion(Region);
+	}
+}
+
+
+
+
@@ -0,0 +1,146 @@
+
+// ChunkTickScheduler.h
+
+// Declares the cChunkTickScheduler class that runs a part of the chunks' tick on a pool of worker threads
+
+/*
+The chunks are grouped into square regions of REGION_SIZE x REGION_SIZE chunks, and the regions are colored in a
+2 x 2 checkerboard pattern. A job is run for the chunks in four phases, one per color. Within a phase, the regions
+are handed out to the threads, each thread running the job for all the chunks of a region, one by one. Any two regions
+of the same color are a whole region apart, so the job may read and write its own chunk and its direct neighbors;
+it never touches a chunk that another thread is working with at the same time. The next phase starts only after
+all the regions of the previous one are done.
+
+The job must not call the plugin hooks, the simulators, or anything else in the world that isn't safe to use from
+multiple threads at once. It's meant for the parts of the chunk tick that only work with the chunks' own data.
+The caller holds the chunkmap's lock for the whole run, so that nothing else changes the chunks meanwhile.
+
+The thread calling Run() works on the regions, too, so a scheduler with N workers runs the job on N + 1 threads.
+With zero workers, the job is run on the calling thread only, in the same phases.
+*/
+
+
+
+
+
+#pragma once
+
+#include <functional>
+
+#include "ChunkDef.h"
+#include "OSSupport/IsThread.h"
+
+
+
+
+
+class cChunkTickScheduler
+{
+public:
+
+	/** The length of a region's side, in chunks. At least 2, so that the neighbors of the same-colored regions don't overlap. */
+	static const int REGION_SIZE = 4;
+
+	/** The job run for each chunk. Receives the index of the chunk in the array passed to Run(). */
+	typedef std::function<void(size_t a_ChunkIndex)> cJob;
+
+
+	cChunkTickScheduler(void);
+	~cChunkTickScheduler();
+
+	/** Starts the specified number of worker threads. With zero workers, the jobs are run on the calling thread only. */
+	void Start(int a_NumWorkers);
+
+	/** Stops the worker threads. Must not be called while Run() is running. */
+	void Stop(void);
+
+	/** Returns the number of worker threads, not counting the thread calling Run(). */
+	size_t GetNumWorkers(void) const { return m_Workers.size(); }
+
+	/** Runs a_Job for each of the specified chunks, in the checkerboard phases, on the workers and the calling thread.
+	Returns once the job has finished for all the chunks. To be called from a single thread at a time (the tick thread). */
+	void Run(const std::vector<cChunkCoords> & a_Chunks, const cJob & a_Job);
+
+protected:
+
+	/** A single thread running the jobs of the regions. */
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+
+		cWorker(cChunkTickScheduler & a_Parent);
+
+	protected:
+
+		cChunkTickScheduler & m_Parent;
+
+		virtual void Execute(void) override;
+	} ;
+
+
+	/** The indices of the chunks of a single region within m_Order, [m_Begin, m_End). */
+	struct sRegion
+	{
+		size_t m_Begin;
+		size_t m_End;
+	} ;
+
+
+	/** The mutex protecting the current phase's state, m_NextRegion and m_NumRegionsLeft. */
+	cCriticalSection m_CS;
+
+	/** The indices of the chunks passed to Run(), ordered by the color and then by the region. Set before the phases start. */
+	std::vector<size_t> m_Order;
+
+	/** The regions of all the colors, ordered by the color; m_ColorStart[c] is the index of the first region of color c,
+	m_ColorStart[4] is the number of all the regions. Set before the phases start. */
+	std::vector<sRegion> m_Regions;
+	size_t m_ColorStart[5];
+
+	/** The job being run. Set before the phases start. */
+	const cJob * m_Job;
+
+	/** The index into m_Regions of the next region of the current phase to hand out; m_NextRegionEnd is where the phase ends. */
+	size_t m_NextRegion;
+	size_t m_NextRegionEnd;
+
+	/** The number of the current phase's regions that haven't been finished yet. */
+	size_t m_NumRegionsLeft;
+
+	/** Set when a phase starts, to wake up the workers, or to stop the workers. */
+	cEvent m_evtPhaseStarted;
+
+	/** Set when the last region of a phase has been finished. */
+	cEvent m_evtPhaseFinished;
+
+	/** Set when the workers should terminate. */
+	std::atomic<bool> m_ShouldTerminate;
+
+	/** The worker threads. */
+	std::vector<std::unique_ptr<cWorker>> m_Workers;
+
+
+	/** Sorts the chunks by the color and the region into m_Order and m_Regions. */
+	void SortIntoRegions(const std::vector<cChunkCoords> & a_Chunks);
+
+	/** Takes the next region of the current phase into a_Region.
+	If there's none left, waits for the next phase if a_ShouldWait is true, otherwise returns false right away.
+	Returns false if the workers should terminate. */
+	bool DequeueRegion(size_t & a_Region, bool a_ShouldWait);
+
+	/** Runs the job for all the chunks of the region, then marks the region finished. */
+	void RunRegion(size_t a_Region);
+
+	/** Returns the region coord of the specified chunk coord, rounding towards negative infinity. */
+	static int ChunkToRegion(int a_ChunkCoord)
+	{
+		return (a_ChunkCoord >= 0) ? (a_ChunkCoord / REGION_SIZE) : ((a_ChunkCoord + 1) / REGION_SIZE - 1);
+	}
+} ;
+
+
+
+
@@ -8,6 +8,9 @@
 #include "Bindings/PluginManager.h"
 #include "Entities/Player.h"
 #include "Entities/Minecart.h"
+#include "Entities/Painting.h"
+#include "Entities/ExpOrb.h"
+#include "Entities/FallingBlock.h"
 #include "Inventory.h"
 #include "BlockEntities/BeaconEntity.h"
 #include "BlockEntities/ChestEntity.h"
@@ -29,6 +32,7 @@
 #include "Root.h"
 
 #include "Protocol/Authenticator.h"
+#include "Protocol/PingResponder.h"
 #include "Protocol/ProtocolRecognizer.h"
 #include "CompositeChat.h"
 #include "Items/ItemSword.h"
@@ -47,6 +51,60 @@
 Vanilla sends one ping every 1 second. */
 static const std::chrono::milliseconds PING_TIME_MS = std::chrono::milliseconds(1000);
 
+/** Number of ticks over which the network stats are averaged. */
+static const int STATS_PERIOD_TICKS = 20;
+
+/** Entities for which SendEntityMovement() hasn't been called for this many ticks are no longer tracked. */
+static const Int64 TRACKED_ENTITY_TIMEOUT_TICKS = 100;
+
+/** Entities closer than this to the player (in blocks) get a movement update each time it is broadcast (every 2 ticks). */
+static const double ENTITY_UPDATE_NEAR_DISTANCE = 32;
+
+/** Entities closer than this (and farther than ENTITY_UPDATE_NEAR_DISTANCE) get a movement update every 4 ticks, the rest every 8 ticks. */
+static const double ENTITY_UPDATE_MID_DISTANCE = 64;
+
+/** Maximum number of chunks requested for streaming in a single tick, even if the client's connection could take more. */
+static const int MAX_CHUNK_REQUESTS_PER_TICK = 16;
+
+/** Chunks at most this far from the player (in chunks) are requested with the high priority. */
+static const int STREAM_HIGH_PRIORITY_RANGE = 2;
+
+
+
+
+
+/** Returns the offsets of all the chunks within the maximum view distance, ordered from the nearest to the furthest.
+Chunks at the same distance are ordered by their angle, so the list forms a spiral around the player. */
+static const std::vector<cChunkCoords> & GetStreamingSpiral(void)
+{
+	static const std::vector<cChunkCoords> Spiral = []()
+	{
+		std::vector<cChunkCoords> Res;
+		const int Size = cClientHandle::MAX_VIEW_DISTANCE;
+		Res.reserve(static_cast<size_t>((2 * Size + 1) * (2 * Size + 1)));
+		for (int z = -Size; z <= Size; z++)
+		{
+			for (int x = -Size; x <= Size; x++)
+			{
+				Res.emplace_back(x, z);
+			}
+		}
+		std::sort(Res.begin(), Res.end(), [](const cChunkCoords & a_Lhs, const cChunkCoords & a_Rhs)
+			{
+				int DistLhs = a_Lhs.m_ChunkX * a_Lhs.m_ChunkX + a_Lhs.m_ChunkZ * a_Lhs.m_ChunkZ;
+				int DistRhs = a_Rhs.m_ChunkX * a_Rhs.m_ChunkX + a_Rhs.m_ChunkZ * a_Rhs.m_ChunkZ;
+				if (DistLhs != DistRhs)
+				{
+					return (DistLhs < DistRhs);
+				}
+				return (atan2(a_Lhs.m_ChunkZ, a_Lhs.m_ChunkX) < atan2(a_Rhs.m_ChunkZ, a_Rhs.m_ChunkX));
+			}
+		);
+		return Res;
+	}();
+	return Spiral;
+}
+
 
 
 
@@ -68,11 +126,14 @@ cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_CurrentViewDistance(a_ViewDistance),
 	m_RequestedViewDistance(a_ViewDistance),
 	m_IPString(a_IPString),
+	m_IsDecodingAsync(false),
 	m_Player(nullptr),
 	m_CachedSentChunk(0, 0),
 	m_HasSentDC(false),
 	m_LastStreamedChunkX(0x7fffffff),  // bogus chunk coords to force streaming upon login
 	m_LastStreamedChunkZ(0x7fffffff),
+	m_LastStreamedViewDistance(0),
+	m_StreamCursor(0),
 	m_TicksSinceLastPacket(0),
 	m_Ping(1000),
 	m_PingID(1),
@@ -93,10 +154,23 @@ cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_HasSentPlayerChunk(false),
 	m_Locale("en_GB"),
 	m_LastPlacedSign(0, -1, 0),
-	m_ProtocolVersion(0)
+	m_ProtocolVersion(0),
+	m_NumPacketsSent(0),
+	m_NumBytesSent(0),
+	m_NumBytesCopied(0),
+	m_NumStatsTicks(0),
+	m_PacketsPerTick(0),
+	m_BytesPerTick(0),
+	m_CopiedBytesPerByteSent(0)
 {
 	m_Protocol = cpp14::make_unique<cProtocolRecognizer>(this);
 
+	// Until the handshake arrives, this may be a server list ping; answer it here unless a plugin wants to see it:
+	m_PingResponder = cpp14::make_unique<cPingResponder>(
+		cRoot::Get()->GetServer()->GetStatusResponseCache(),
+		!cRoot::Get()->GetPluginManager()->HasServerPingHook()
+	);
+
 	s_ClientCount++;  // Not protected by CS because clients are always constructed from the same thread
 	m_UniqueID = s_ClientCount;
 	m_PingStartTime = std::chrono::steady_clock::now();
@@ -466,100 +540,59 @@ bool cClientHandle::StreamNextChunk(void)
 
 	int ChunkPosX = m_Player->GetChunkX();
 	int ChunkPosZ = m_Player->GetChunkZ();
-	if ((m_LastStreamedChunkX == ChunkPosX) && (m_LastStreamedChunkZ == ChunkPosZ))
+	if (
+		(m_LastStreamedChunkX != ChunkPosX) ||
+		(m_LastStreamedChunkZ != ChunkPosZ) ||
+		(m_LastStreamedViewDistance != m_CurrentViewDistance)
+	)
 	{
-		// All chunks are already loaded. Abort loading.
-		return true;
+		// The player moved to another chunk, drop the queued chunks left behind and start over from the nearest ones:
+		DropOutOfRangeQueuedChunks(ChunkPosX, ChunkPosZ);
+		m_LastStreamedChunkX = ChunkPosX;
+		m_LastStreamedChunkZ = ChunkPosZ;
+		m_LastStreamedViewDistance = m_CurrentViewDistance;
+		m_StreamCursor = 0;
 	}
 
-	// Get the look vector and normalize it.
-	Vector3d Position = m_Player->GetEyePosition();
+	// The chunks in the view direction of the player get a higher priority in the chunk sender:
 	Vector3d LookVector = m_Player->GetLookVector();
-	LookVector.Normalize();
 
-	// Lock the list
+	// Find the nearest chunk that is neither loaded nor queued:
+	const auto & Spiral = GetStreamingSpiral();
 	cCSLock Lock(m_CSChunkLists);
-
-	// High priority: Load the chunks that are in the view-direction of the player (with a radius of 3)
-	for (int Range = 0; Range < m_CurrentViewDistance; Range++)
+	for (; m_StreamCursor < Spiral.size(); ++m_StreamCursor)
 	{
-		Vector3d Vector = Position + LookVector * cChunkDef::Width * Range;
-
-		// Get the chunk from the x / z coords.
-		int RangeX, RangeZ = 0;
-		cChunkDef::BlockToChunk(FloorC(Vector.x), FloorC(Vector.z), RangeX, RangeZ);
-
-		for (int X = 0; X < 7; X++)
+		const auto & Offset = Spiral[m_StreamCursor];
+		if ((std::abs(Offset.m_ChunkX) > m_CurrentViewDistance) || (std::abs(Offset.m_ChunkZ) > m_CurrentViewDistance))
 		{
-			for (int Z = 0; Z < 7; Z++)
-			{
-				int ChunkX = RangeX + ((X >= 4) ? (3 - X) : X);
-				int ChunkZ = RangeZ + ((Z >= 4) ? (3 - Z) : Z);
-				cChunkCoords Coords(ChunkX, ChunkZ);
-
-				// Checks if the chunk is in distance
-				if ((Diff(ChunkX, ChunkPosX) > m_CurrentViewDistance) || (Diff(ChunkZ, ChunkPosZ) > m_CurrentViewDistance))
-				{
-					continue;
-				}
-
-				// If the chunk already loading / loaded -> skip
-				if (
-					(m_ChunksToSend.find(Coords) != m_ChunksToSend.end()) ||
-					(m_LoadedChunks.find(Coords) != m_LoadedChunks.end())
-				)
-				{
-					continue;
-				}
-
-				// Unloaded chunk found -> Send it to the client.
-				Lock.Unlock();
-				StreamChunk(ChunkX, ChunkZ, ((Range <= 2) ? cChunkSender::E_CHUNK_PRIORITY_HIGH : cChunkSender::E_CHUNK_PRIORITY_MEDIUM));
-				return false;
-			}
+			continue;
 		}
-	}
-
-	// Low priority: Add all chunks that are in range. (From the center out to the edge)
-	for (int d = 0; d <= m_CurrentViewDistance; ++d)  // cycle through (square) distance, from nearest to furthest
-	{
-		// For each distance add chunks in a hollow square centered around current position:
-		cChunkCoordsList CurcleChunks;
-		for (int i = -d; i <= d; ++i)
+		cChunkCoords Coords(ChunkPosX + Offset.m_ChunkX, ChunkPosZ + Offset.m_ChunkZ);
+		if (
+			(m_ChunksToSend.find(Coords) != m_ChunksToSend.end()) ||
+			(m_LoadedChunks.find(Coords) != m_LoadedChunks.end())
+		)
 		{
-			CurcleChunks.push_back(cChunkCoords(ChunkPosX + d, ChunkPosZ + i));
-			CurcleChunks.push_back(cChunkCoords(ChunkPosX - d, ChunkPosZ + i));
+			continue;
 		}
-		for (int i = -d + 1; i < d; ++i)
+
+		// Unloaded chunk found -> Send it to the client.
+		cChunkSender::eChunkPriority Priority = cChunkSender::E_CHUNK_PRIORITY_LOW;
+		if ((std::abs(Offset.m_ChunkX) <= STREAM_HIGH_PRIORITY_RANGE) && (std::abs(Offset.m_ChunkZ) <= STREAM_HIGH_PRIORITY_RANGE))
 		{
-			CurcleChunks.push_back(cChunkCoords(ChunkPosX + i, ChunkPosZ + d));
-			CurcleChunks.push_back(cChunkCoords(ChunkPosX + i, ChunkPosZ - d));
+			Priority = cChunkSender::E_CHUNK_PRIORITY_HIGH;
 		}
-
-		// For each the CurcleChunks list and send the first unloaded chunk:
-		for (cChunkCoordsList::iterator itr = CurcleChunks.begin(), end = CurcleChunks.end(); itr != end; ++itr)
+		else if (LookVector.x * Offset.m_ChunkX + LookVector.z * Offset.m_ChunkZ > 0)
 		{
-			cChunkCoords Coords = *itr;
-
-			// If the chunk already loading / loaded -> skip
-			if (
-				(m_ChunksToSend.find(Coords) != m_ChunksToSend.end()) ||
-				(m_LoadedChunks.find(Coords) != m_LoadedChunks.end())
-			)
-			{
-				continue;
-			}
-
-			// Unloaded chunk found -> Send it to the client.
-			Lock.Unlock();
-			StreamChunk(Coords.m_ChunkX, Coords.m_ChunkZ, cChunkSender::E_CHUNK_PRIORITY_LOW);
-			return false;
+			Priority = cChunkSender::E_CHUNK_PRIORITY_MEDIUM;
 		}
+		++m_StreamCursor;
+		Lock.Unlock();
+		StreamChunk(Coords.m_ChunkX, Coords.m_ChunkZ, Priority);
+		return false;
 	}
 
-	// All chunks are loaded -> Sets the last loaded chunk coordinates to current coordinates
-	m_LastStreamedChunkX = ChunkPosX;
-	m_LastStreamedChunkZ = ChunkPosZ;
+	// All chunks are loaded
 	return true;
 }
 
@@ -642,6 +675,49 @@ void cClientHandle::StreamChunk(int a_ChunkX, int a_ChunkZ, cChunkSender::eChunk
 
 
 
+void cClientHandle::DropOutOfRangeQueuedChunks(int a_ChunkPosX, int a_ChunkPosZ)
+{
+	// Chunks that haven't been sent yet can be forgotten right away, no need to wait for UnloadOutOfRangeChunks():
+	cChunkCoordsList ChunksToRemove;
+	{
+		cCSLock Lock(m_CSChunkLists);
+		for (auto itr = m_ChunksToSend.begin(); itr != m_ChunksToSend.end();)
+		{
+			int DiffX = Diff((*itr).m_ChunkX, a_ChunkPosX);
+			int DiffZ = Diff((*itr).m_ChunkZ, a_ChunkPosZ);
+			if ((DiffX > m_CurrentViewDistance) || (DiffZ > m_CurrentViewDistance))
+			{
+				ChunksToRemove.push_back(*itr);
+				m_LoadedChunks.erase(*itr);
+				itr = m_ChunksToSend.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}
+	}
+	if (ChunksToRemove.empty())
+	{
+		return;
+	}
+
+	// The chunk may have been sent before and queued again because of a change, so unload it in the client, too:
+	cWorld * World = m_Player->GetWorld();
+	for (const auto & Chunk: ChunksToRemove)
+	{
+		if (World != nullptr)
+		{
+			World->RemoveChunkClient(Chunk.m_ChunkX, Chunk.m_ChunkZ, this);
+		}
+		SendUnloadChunk(Chunk.m_ChunkX, Chunk.m_ChunkZ);
+	}
+}
+
+
+
+
+
 void cClientHandle::RemoveFromAllChunks()
 {
 	cWorld * World = m_Player->GetWorld();
@@ -1830,6 +1906,7 @@ void cClientHandle::HandleKeepAlive(UInt32 a_KeepAliveID)
 	if (a_KeepAliveID == m_PingID)
 	{
 		m_Ping = std::chrono::steady_clock::now() - m_PingStartTime;
+		m_ChunkSendScheduler.OnRttSample(m_Ping);
 	}
 }
 
@@ -1984,7 +2061,55 @@ void cClientHandle::SendData(const char * a_Data, size_t a_Size)
 	}
 
 	cCSLock Lock(m_CSOutgoingData);
-	m_OutgoingData.append(a_Data, a_Size);
+	m_OutgoingData.Append(a_Data, a_Size);
+}
+
+
+
+
+
+void cClientHandle::SendSharedData(const cSendChain::cSlicePtr & a_Data)
+{
+	if (m_HasSentDC)
+	{
+		// Same as in SendData()
+		return;
+	}
+
+	cCSLock Lock(m_CSOutgoingData);
+	m_OutgoingData.AppendShared(a_Data);
+}
+
+
+
+
+
+UInt32 cClientHandle::GetBroadcastKey(void)
+{
+	if (m_HasSentDC)
+	{
+		// Nothing gets sent anymore, don't capture anything from this client
+		return 0;
+	}
+	return m_Protocol->GetBroadcastKey();
+}
+
+
+
+
+
+cSendChain::cSlicePtr cClientHandle::EncodeBroadcast(const std::function<void()> & a_SendFn)
+{
+	return m_Protocol->EncodeBroadcast(a_SendFn);
+}
+
+
+
+
+
+void cClientHandle::SendEncodedBroadcast(const cSendChain::cSlicePtr & a_Data)
+{
+	m_Protocol->SendEncodedBroadcast(a_Data);
 }
 
 
@@ -2000,6 +2125,11 @@ void cClientHandle::RemoveFromWorld(void)
 		std::swap(Chunks, m_LoadedChunks);
 		m_ChunksToSend.clear();
 	}
+	{
+		// The client forgets all the entities together with the chunks:
+		cCSLock Lock(m_CSTrackedEntities);
+		m_TrackedEntities.clear();
+	}
 	for (auto && Chunk : Chunks)
 	{
 		SendUnloadChunk(Chunk.m_ChunkX, Chunk.m_ChunkZ);
@@ -2062,6 +2192,7 @@ void cClientHandle::Tick(float a_Dt)
 	}
 
 	ProcessProtocolInOut();
+	TickStats();
 
 	m_TicksSinceLastPacket += 1;
 	if (m_TicksSinceLastPacket > 600)  // 30 seconds time-out
@@ -2143,9 +2274,14 @@ void cClientHandle::Tick(float a_Dt)
 
 	if ((m_State >= csAuthenticated) && (m_State < csQueuedForDestruction))
 	{
-		// Stream 4 chunks per tick
-		for (int i = 0; i < 4; i++)
+		// Stream as many chunks as the client's connection can take:
+		for (int i = 0; i < MAX_CHUNK_REQUESTS_PER_TICK; i++)
 		{
+			if (!m_ChunkSendScheduler.CanRequestChunk())
+			{
+				break;
+			}
+
 			// Stream the next chunk
 			if (StreamNextChunk())
 			{
@@ -2479,6 +2615,7 @@ void cClientHandle::SendCollectEntity(const cEntity & a_Entity, const cPlayer &
 
 void cClientHandle::SendDestroyEntity(const cEntity & a_Entity)
 {
+	ForgetTrackedEntity(a_Entity);
 	m_Protocol->SendDestroyEntity(a_Entity);
 }
 
@@ -2574,6 +2711,108 @@ void cClientHandle::SendEntityMetadata(const cEntity & a_Entity)
 
 
 
+void cClientHandle::SendEntityMovement(const cEntity & a_Entity)
+{
+	// Each client keeps track of what it has been sent about each entity and only sends the differences.
+	// Entities far from the player are updated less often; their changes accumulate until the next update, so that
+	// superseded updates are never sent at all, yet the client ends up with the same state.
+	if ((m_Player == nullptr) || (a_Entity.GetUniqueID() == m_Player->GetUniqueID()))
+	{
+		return;
+	}
+
+	sTrackedEntity Current;
+	Current.m_PosX = FloorC(a_Entity.GetPosX() * 32.0);
+	Current.m_PosY = FloorC(a_Entity.GetPosY() * 32.0);
+	Current.m_PosZ = FloorC(a_Entity.GetPosZ() * 32.0);
+	Current.m_Yaw     = static_cast<Byte>(static_cast<int>(255 * a_Entity.GetYaw()     / 360));
+	Current.m_Pitch   = static_cast<Byte>(static_cast<int>(255 * a_Entity.GetPitch()   / 360));
+	Current.m_HeadYaw = static_cast<Byte>(static_cast<int>(255 * a_Entity.GetHeadYaw() / 360));
+	Current.m_SpeedX = static_cast<Int16>(a_Entity.GetSpeedX() * 400);  // Same conversion as in the protocols' SendEntityVelocity()
+	Current.m_SpeedY = static_cast<Int16>(a_Entity.GetSpeedY() * 400);
+	Current.m_SpeedZ = static_cast<Int16>(a_Entity.GetSpeedZ() * 400);
+	Current.m_LastSeen = a_Entity.GetWorld()->GetWorldAge();
+
+	double DistanceSqr = (a_Entity.GetPosition() - m_Player->GetPosition()).SqrLength();
+	if (DistanceSqr < ENTITY_UPDATE_NEAR_DISTANCE * ENTITY_UPDATE_NEAR_DISTANCE)
+	{
+		Current.m_NextUpdate = Current.m_LastSeen + 2;
+	}
+	else if (DistanceSqr < ENTITY_UPDATE_MID_DISTANCE * ENTITY_UPDATE_MID_DISTANCE)
+	{
+		Current.m_NextUpdate = Current.m_LastSeen + 4;
+	}
+	else
+	{
+		Current.m_NextUpdate = Current.m_LastSeen + 8;
+	}
+
+	cCSLock Lock(m_CSTrackedEntities);
+	auto itr = m_TrackedEntities.find(a_Entity.GetUniqueID());
+	if (itr == m_TrackedEntities.end())
+	{
+		// Nothing has been sent for this entity yet, send the full state:
+		m_TrackedEntities[a_Entity.GetUniqueID()] = Current;
+		m_Protocol->SendTeleportEntity(a_Entity);
+		m_Protocol->SendEntityVelocity(a_Entity);
+		if (a_Entity.IsMob() || a_Entity.IsPlayer())
+		{
+			m_Protocol->SendEntityHeadLook(a_Entity);
+		}
+		return;
+	}
+
+	sTrackedEntity & Tracked = itr->second;
+	Tracked.m_LastSeen = Current.m_LastSeen;
+	if (Current.m_LastSeen < Tracked.m_NextUpdate)
+	{
+		return;
+	}
+
+	bool HasLookChanged = ((Current.m_Yaw != Tracked.m_Yaw) || (Current.m_Pitch != Tracked.m_Pitch));
+	int DiffX = Current.m_PosX - Tracked.m_PosX;
+	int DiffY = Current.m_PosY - Tracked.m_PosY;
+	int DiffZ = Current.m_PosZ - Tracked.m_PosZ;
+	if ((DiffX != 0) || (DiffY != 0) || (DiffZ != 0))
+	{
+		if ((std::abs(DiffX) <= 127) && (std::abs(DiffY) <= 127) && (std::abs(DiffZ) <= 127))  // Limitations of a Byte
+		{
+			if (HasLookChanged)
+			{
+				m_Protocol->SendEntityRelMoveLook(a_Entity, static_cast<char>(DiffX), static_cast<char>(DiffY), static_cast<char>(DiffZ));
+				HasLookChanged = false;
+			}
+			else
+			{
+				m_Protocol->SendEntityRelMove(a_Entity, static_cast<char>(DiffX), static_cast<char>(DiffY), static_cast<char>(DiffZ));
+			}
+		}
+		else
+		{
+			// Too big a movement, do a teleport
+			m_Protocol->SendTeleportEntity(a_Entity);
+			HasLookChanged = false;
+		}
+	}
+	if (HasLookChanged)
+	{
+		m_Protocol->SendEntityLook(a_Entity);
+	}
+	if (Current.m_HeadYaw != Tracked.m_HeadYaw)
+	{
+		m_Protocol->SendEntityHeadLook(a_Entity);
+	}
+	if ((Current.m_SpeedX != Tracked.m_SpeedX) || (Current.m_SpeedY != Tracked.m_SpeedY) || (Current.m_SpeedZ != Tracked.m_SpeedZ))
+	{
+		m_Protocol->SendEntityVelocity(a_Entity);
+	}
+	Tracked = Current;
+}
+
+
+
+
+
 void cClientHandle::SendEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ)
 {
 	ASSERT(a_Entity.GetUniqueID() != m_Player->GetUniqueID());  // Must not send for self
@@ -2607,6 +2846,17 @@ void cClientHandle::SendEntityStatus(const cEntity & a_Entity, char a_Status)
 
 void cClientHandle::SendEntityVelocity(const cEntity & a_Entity)
 {
+	{
+		// Keep the movement tracking in sync, so that SendEntityMovement() doesn't send the velocity again:
+		cCSLock Lock(m_CSTrackedEntities);
+		auto itr = m_TrackedEntities.find(a_Entity.GetUniqueID());
+		if (itr != m_TrackedEntities.end())
+		{
+			itr->second.m_SpeedX = static_cast<Int16>(a_Entity.GetSpeedX() * 400);
+			itr->second.m_SpeedY = static_cast<Int16>(a_Entity.GetSpeedY() * 400);
+			itr->second.m_SpeedZ = static_cast<Int16>(a_Entity.GetSpeedZ() * 400);
+		}
+	}
 	m_Protocol->SendEntityVelocity(a_Entity);
 }
 
@@ -2697,6 +2947,7 @@ void cClientHandle::SendParticleEffect(const AString & a_ParticleName, const Vec
 
 void cClientHandle::SendPickupSpawn(const cPickup & a_Pickup)
 {
+	ForgetTrackedEntity(a_Pickup);
 	m_Protocol->SendPickupSpawn(a_Pickup);
 }
 
@@ -2705,6 +2956,7 @@ void cClientHandle::SendPickupSpawn(const cPickup & a_Pickup)
 
 void cClientHandle::SendPaintingSpawn(const cPainting & a_Painting)
 {
+	ForgetTrackedEntity(a_Painting);
 	m_Protocol->SendPaintingSpawn(a_Painting);
 }
 
@@ -2819,6 +3071,7 @@ void cClientHandle::SendPlayerSpawn(const cPlayer & a_Player)
 		a_Player.GetName().c_str(), GetPlayer()->GetName().c_str(), GetIPString().c_str()
 	);
 
+	ForgetTrackedEntity(a_Player);
 	m_Protocol->SendPlayerSpawn(a_Player);
 }
 
@@ -2884,6 +3137,7 @@ void cClientHandle::SendExperience(void)
 
 void cClientHandle::SendExperienceOrb(const cExpOrb & a_ExpOrb)
 {
+	ForgetTrackedEntity(a_ExpOrb);
 	m_Protocol->SendExperienceOrb(a_ExpOrb);
 }
 
@@ -2984,6 +3238,7 @@ void cClientHandle::SendSoundParticleEffect(const EffectID a_EffectID, int a_Src
 
 void cClientHandle::SendSpawnFallingBlock(const cFallingBlock & a_FallingBlock)
 {
+	ForgetTrackedEntity(a_FallingBlock);
 	m_Protocol->SendSpawnFallingBlock(a_FallingBlock);
 }
 
@@ -2993,6 +3248,7 @@ void cClientHandle::SendSpawnFallingBlock(const cFallingBlock & a_FallingBlock)
 
 void cClientHandle::SendSpawnMob(const cMonster & a_Mob)
 {
+	ForgetTrackedEntity(a_Mob);
 	m_Protocol->SendSpawnMob(a_Mob);
 }
 
@@ -3002,6 +3258,7 @@ void cClientHandle::SendSpawnMob(const cMonster & a_Mob)
 
 void cClientHandle::SendSpawnObject(const cEntity & a_Entity, char a_ObjectType, int a_ObjectData, Byte a_Yaw, Byte a_Pitch)
 {
+	ForgetTrackedEntity(a_Entity);
 	m_Protocol->SendSpawnObject(a_Entity, a_ObjectType, a_ObjectData, a_Yaw, a_Pitch);
 }
 
@@ -3011,6 +3268,7 @@ void cClientHandle::SendSpawnObject(const cEntity & a_Entity, char a_ObjectType,
 
 void cClientHandle::SendSpawnVehicle(const cEntity & a_Vehicle, char a_VehicleType, char a_VehicleSubType)  // VehicleSubType is specific to Minecarts
 {
+	ForgetTrackedEntity(a_Vehicle);
 	m_Protocol->SendSpawnVehicle(a_Vehicle, a_VehicleType, a_VehicleSubType);
 }
 
@@ -3038,6 +3296,19 @@ void cClientHandle::SendTabCompletionResults(const AStringVector & a_Results)
 
 void cClientHandle::SendTeleportEntity(const cEntity & a_Entity)
 {
+	{
+		// Keep the movement tracking in sync, so that SendEntityMovement() sends the following moves relative to the new position:
+		cCSLock Lock(m_CSTrackedEntities);
+		auto itr = m_TrackedEntities.find(a_Entity.GetUniqueID());
+		if (itr != m_TrackedEntities.end())
+		{
+			itr->second.m_PosX = FloorC(a_Entity.GetPosX() * 32.0);
+			itr->second.m_PosY = FloorC(a_Entity.GetPosY() * 32.0);
+			itr->second.m_PosZ = FloorC(a_Entity.GetPosZ() * 32.0);
+			itr->second.m_Yaw   = static_cast<Byte>(static_cast<int>(255 * a_Entity.GetYaw()   / 360));
+			itr->second.m_Pitch = static_cast<Byte>(static_cast<int>(255 * a_Entity.GetPitch() / 360));
+		}
+	}
 	m_Protocol->SendTeleportEntity(a_Entity);
 }
 
@@ -3313,26 +3584,93 @@ void cClientHandle::SetSelf(cClientHandlePtr a_Self)
 void cClientHandle::ProcessProtocolInOut(void)
 {
 	// Process received network data:
-	AString IncomingData;
+	if (!m_IsDecodingAsync)
 	{
-		cCSLock Lock(m_CSIncomingData);
-		std::swap(IncomingData, m_IncomingData);
-	}
-	if (!IncomingData.empty())
-	{
-		m_Protocol->DataReceived(IncomingData.data(), IncomingData.size());
+		AString IncomingData;
+		{
+			cCSLock Lock(m_CSIncomingData);
+
+			// While the data may still be a server list ping, it's up to the network thread:
+			if (m_PingResponder == nullptr)
+			{
+				std::swap(IncomingData, m_IncomingData);
+			}
+		}
+		if (!IncomingData.empty())
+		{
+			m_Protocol->DataReceived(IncomingData.data(), IncomingData.size());
+		}
+
+		// Once in the game state, move the decoding to the network thread, starting with any data that came in meanwhile:
+		if (m_Protocol->CanDecodeAsync())
+		{
+			cCSLock Lock(m_CSIncomingData);
+			if (!m_IncomingData.empty())
+			{
+				m_Protocol->DecodeReceivedData(m_IncomingData.data(), m_IncomingData.size());
+				m_IncomingData.clear();
+			}
+			m_IsDecodingAsync = true;
+		}
 	}
+	m_Protocol->HandleDecodedPackets();
 
-	// Send any queued outgoing data:
-	AString OutgoingData;
+	// Send any queued outgoing data, all in a single flush:
+	cSendChain OutgoingData;
 	{
 		cCSLock Lock(m_CSOutgoingData);
 		std::swap(OutgoingData, m_OutgoingData);
 	}
 	auto link = m_Link;
-	if ((link != nullptr) && !OutgoingData.empty())
+	if (link != nullptr)
+	{
+		// The amount of data still waiting in the link tells the scheduler how fast the connection drains it:
+		size_t UnsentBefore = link->GetOutgoingDataSize();
+		if (!OutgoingData.IsEmpty())
+		{
+			link->Send(OutgoingData);
+			m_NumBytesSent += OutgoingData.GetSize();
+			m_NumBytesCopied += OutgoingData.GetNumBytesCopied();
+		}
+		m_ChunkSendScheduler.OnFlush(std::chrono::steady_clock::now(), UnsentBefore, OutgoingData.GetSize());
+	}
+}
+
+
+
+
+
+void cClientHandle::TickStats(void)
+{
+	m_NumStatsTicks += 1;
+	if (m_NumStatsTicks < STATS_PERIOD_TICKS)
+	{
+		return;
+	}
+	m_PacketsPerTick = static_cast<float>(m_NumPacketsSent.exchange(0)) / m_NumStatsTicks;
+	m_BytesPerTick = static_cast<float>(m_NumBytesSent) / m_NumStatsTicks;
+	m_CopiedBytesPerByteSent = (m_NumBytesSent > 0) ? static_cast<float>(m_NumBytesCopied) / static_cast<float>(m_NumBytesSent) : 0.0f;
+	m_NumBytesSent = 0;
+	m_NumBytesCopied = 0;
+	m_NumStatsTicks = 0;
+
+	// Stop tracking the entities that haven't been around for a while, they will be sent in full if they come back:
+	if ((m_Player == nullptr) || (m_Player->GetWorld() == nullptr))
+	{
+		return;
+	}
+	Int64 WorldAge = m_Player->GetWorld()->GetWorldAge();
+	cCSLock Lock(m_CSTrackedEntities);
+	for (auto itr = m_TrackedEntities.begin(); itr != m_TrackedEntities.end();)
 	{
-		link->Send(OutgoingData.data(), OutgoingData.size());
+		if (WorldAge - itr->second.m_LastSeen > TRACKED_ENTITY_TIMEOUT_TICKS)
+		{
+			itr = m_TrackedEntities.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
 	}
 }
 
@@ -3340,6 +3678,26 @@ void cClientHandle::ProcessProtocolInOut(void)
 
 
 
+void cClientHandle::ForgetTrackedEntity(const cEntity & a_Entity)
+{
+	cCSLock Lock(m_CSTrackedEntities);
+	m_TrackedEntities.erase(a_Entity.GetUniqueID());
+}
+
+
+
+
+
+size_t cClientHandle::GetNumTrackedEntities(void)
+{
+	cCSLock Lock(m_CSTrackedEntities);
+	return m_TrackedEntities.size();
+}
+
+
+
+
+
 void cClientHandle::OnLinkCreated(cTCPLinkPtr a_Link)
 {
 	m_Link = a_Link;
@@ -3354,8 +3712,26 @@ void cClientHandle::OnReceivedData(const char * a_Data, size_t a_Length)
 	// Reset the timeout:
 	m_TicksSinceLastPacket = 0;
 
+	// In the game state, decode the data right here, the tick thread only handles the decoded packets.
+	// The protocol's decoder is used only by this thread then, so it needs no locking:
+	if (m_IsDecodingAsync)
+	{
+		m_Protocol->DecodeReceivedData(a_Data, a_Length);
+		return;
+	}
+
 	// Queue the incoming data to be processed in the tick thread:
 	cCSLock Lock(m_CSIncomingData);
+	if (m_IsDecodingAsync)
+	{
+		// The tick thread has switched to async decoding while we were waiting for the lock:
+		m_Protocol->DecodeReceivedData(a_Data, a_Length);
+		return;
+	}
+	if ((m_PingResponder != nullptr) && RespondToPing(a_Data, a_Length))
+	{
+		return;
+	}
 	m_IncomingData.append(a_Data, a_Length);
 }
 
@@ -3363,6 +3739,61 @@ void cClientHandle::OnReceivedData(const char * a_Data, size_t a_Length)
 
 
 
+bool cClientHandle::RespondToPing(const char * a_Data, size_t a_Length)
+{
+	AString Response;
+	bool ShouldClose = false;
+	switch (m_PingResponder->ProcessData(a_Data, a_Length, Response))
+	{
+		case cPingResponder::prUndecided:
+		{
+			// Keep the data, in case it's not a ping after all:
+			return false;
+		}
+		case cPingResponder::prNotAPing:
+		{
+			// Let the protocol have all the data, in the tick thread:
+			m_PingResponder.reset();
+			return false;
+		}
+		case cPingResponder::prResponded:
+		{
+			break;
+		}
+		case cPingResponder::prFinished:
+		{
+			ShouldClose = true;
+			break;
+		}
+	}
+
+	// The data is not going to the protocol:
+	m_IncomingData.clear();
+
+	cTCPLinkPtr Link;
+	{
+		cCSLock Lock(m_CSOutgoingData);
+		Link = m_Link;
+	}
+	if (Link == nullptr)
+	{
+		return true;
+	}
+	if (!Response.empty())
+	{
+		Link->Send(Response);
+	}
+	if (ShouldClose)
+	{
+		Link->Shutdown();
+	}
+	return true;
+}
+
+
+
+
+
 void cClientHandle::OnRemoteClosed(void)
 {
 	/*
@@ -9,12 +9,15 @@
 
 #pragma once
 
+#include <functional>
 #include "OSSupport/Network.h"
+#include "OSSupport/SendChain.h"
 #include "Defines.h"
 #include "Scoreboard.h"
 #include "UI/SlotArea.h"
 #include "json/json.h"
 #include "ChunkSender.h"
+#include "ChunkSendScheduler.h"
 #include "EffectID.h"
 #include "Protocol/ForgeHandshake.h"
 #include "UUID.h"
@@ -30,6 +33,7 @@ class cExpOrb;
 class cPainting;
 class cPickup;
 class cPlayer;
+class cPingResponder;
 class cProtocol;
 class cWindow;
 class cFallingBlock;
@@ -114,7 +118,7 @@ public:  // tolua_export
 	/** Authenticates the specified user, called by cAuthenticator */
 	void Authenticate(const AString & a_Name, const cUUID & a_UUID, const Json::Value & a_Properties);
 
-	/** This function sends a new unloaded chunk to the player. Returns true if all chunks are loaded. */
+	/** Requests the next chunk that the player doesn't have yet, nearest first. Returns true if all chunks are loaded. */
 	bool StreamNextChunk();
 
 	/** Remove all loaded chunks that are no longer in range */
@@ -166,6 +170,7 @@ public:  // tolua_export
 	void SendEntityHeadLook             (const cEntity & a_Entity);
 	void SendEntityLook                 (const cEntity & a_Entity);
 	void SendEntityMetadata             (const cEntity & a_Entity);
+	void SendEntityMovement             (const cEntity & a_Entity);
 	void SendEntityProperties           (const cEntity & a_Entity);
 	void SendEntityRelMove              (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ);
 	void SendEntityRelMoveLook          (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ);
@@ -265,12 +270,6 @@ public:  // tolua_export
 
 	// tolua_end
 
-	/** Add the Forge mod list to the server ping response. */
-	void ForgeAugmentServerListPing(Json::Value & a_Response)
-	{
-		m_ForgeHandshake.AugmentServerListPing(a_Response);
-	}
-
 	/** Mark a client connection as using Forge. Set by the protocol. */
 	void SetIsForgeClient()
 	{
@@ -378,6 +377,20 @@ public:  // tolua_export
 
 	void SendData(const char * a_Data, size_t a_Size);
 
+	/** Queues the shared data for sending, without copying it if it is large enough.
+	Used for data sent to many clients, such as the cached chunk serializations. The data must not be encrypted. */
+	void SendSharedData(const cSendChain::cSlicePtr & a_Data);
+
+	/** Returns the key identifying how the broadcast packets are encoded for this client, see cProtocol::GetBroadcastKey(). */
+	UInt32 GetBroadcastKey(void);
+
+	/** Sends the packets sent by a_SendFn to this client and returns them encoded for the other clients with the same
+	broadcast key, see cProtocol::EncodeBroadcast(). */
+	cSendChain::cSlicePtr EncodeBroadcast(const std::function<void()> & a_SendFn);
+
+	/** Sends the packets encoded by EncodeBroadcast() of a client with the same broadcast key. */
+	void SendEncodedBroadcast(const cSendChain::cSlicePtr & a_Data);
+
 	/** Called when the player moves into a different world.
 	Sends an UnloadChunk packet for each loaded chunk and resets the streamed chunks. */
 	void RemoveFromWorld(void);
@@ -392,6 +405,33 @@ public:  // tolua_export
 
 	bool IsPlayerChunkSent();
 
+	/** Called by the protocol for each packet sent to the client, for the network stats. */
+	void PacketSent(void) { m_NumPacketsSent += 1; }
+
+	/** Called by the protocol for each chunk's data queued for sending, for pacing the chunk streaming. */
+	void ChunkDataQueued(size_t a_NumBytes) { m_ChunkSendScheduler.OnChunkQueued(a_NumBytes); }
+
+	/** Returns the average number of packets sent to the client per tick, over the last stats period. */
+	float GetPacketsPerTick(void) const { return m_PacketsPerTick; }
+
+	/** Returns the average number of bytes sent to the client per tick, over the last stats period. */
+	float GetBytesPerTick(void) const { return m_BytesPerTick; }
+
+	/** Returns the average number of bytes copied into the outgoing buffers per byte sent, over the last stats period. */
+	float GetCopiedBytesPerByteSent(void) const { return m_CopiedBytesPerByteSent; }
+
+	/** Returns the number of chunk data bytes queued for the client and not yet written to the socket (an upper bound). */
+	size_t GetQueuedChunkBytes(void) const { return m_ChunkSendScheduler.GetQueuedChunkBytes(); }
+
+	/** Returns the estimated bandwidth of the client's connection, in bytes per second, as used for pacing the chunks. */
+	double GetChunkBandwidth(void) const { return m_ChunkSendScheduler.GetBandwidth(); }
+
+	/** Returns the number of bytes currently allowed to be in flight to the client while streaming chunks. */
+	size_t GetChunkSendBudget(void) const { return m_ChunkSendScheduler.GetBudget(); }
+
+	/** Returns the number of entities whose movement is being tracked for the client. */
+	size_t GetNumTrackedEntities(void);
+
 private:
 	/** The dimension that was last sent to a player in a Respawn or Login packet.
 	Used to avoid Respawning into the same dimension, which confuses the client. */
@@ -433,15 +473,27 @@ private:
 	cCriticalSection m_CSIncomingData;
 
 	/** Queue for the incoming data received on the link until it is processed in Tick().
+	Only used until the protocol can decode on the network thread (m_IsDecodingAsync).
 	Protected by m_CSIncomingData. */
 	AString m_IncomingData;
 
+	/** Set once the protocol has reached the game state. From then on, the network thread decodes the incoming data
+	into packets as it arrives and Tick() only handles the decoded packets.
+	Only set with m_CSIncomingData held; the network thread re-checks it under the lock. */
+	std::atomic<bool> m_IsDecodingAsync;
+
+	/** Answers the server list pings right on the network thread. Set for each new connection, until the handshake shows
+	that it's not a ping; meanwhile the incoming data is kept in m_IncomingData but not processed by Tick().
+	Protected by m_CSIncomingData. */
+	std::unique_ptr<cPingResponder> m_PingResponder;
+
 	/** Protects m_OutgoingData against multithreaded access. */
 	cCriticalSection m_CSOutgoingData;
 
 	/** Buffer for storing outgoing data from any thread; will get sent in Tick() (to prevent deadlocks).
+	The whole chain is handed to the link in a single call each tick.
 	Protected by m_CSOutgoingData. */
-	AString m_OutgoingData;
+	cSendChain m_OutgoingData;
 
 	Vector3d m_ConfirmPosition;
 
@@ -463,6 +515,15 @@ private:
 	int m_LastStreamedChunkX;
 	int m_LastStreamedChunkZ;
 
+	/** The view distance when the last StreamChunks() was called; a change restarts the streaming. */
+	int m_LastStreamedViewDistance;
+
+	/** Index into the streaming spiral of the next chunk to consider, reset whenever the player moves to another chunk. */
+	size_t m_StreamCursor;
+
+	/** Paces the chunk streaming by the connection's measured bandwidth and round trip time. */
+	cChunkSendScheduler m_ChunkSendScheduler;
+
 	/** Number of ticks since the last network packet was received (increased in Tick(), reset in OnReceivedData()) */
 	std::atomic<int> m_TicksSinceLastPacket;
 
@@ -556,6 +617,49 @@ private:
 
 	float m_BreakProgress;
 
+	/** What the client has been sent last about an entity's movement, see SendEntityMovement(). */
+	struct sTrackedEntity
+	{
+		/** The position, in the 1/32-block units of the protocol. */
+		int m_PosX, m_PosY, m_PosZ;
+
+		/** The yaw, pitch and head yaw, as angle bytes of the protocol. */
+		Byte m_Yaw, m_Pitch, m_HeadYaw;
+
+		/** The speed, in the units of the protocol's velocity packet. */
+		Int16 m_SpeedX, m_SpeedY, m_SpeedZ;
+
+		/** The world age at which the entity is next due for a movement update. */
+		Int64 m_NextUpdate;
+
+		/** The world age at which SendEntityMovement() was last called for the entity, used for pruning. */
+		Int64 m_LastSeen;
+	};
+
+	/** Protects m_TrackedEntities against multithreaded access. */
+	cCriticalSection m_CSTrackedEntities;
+
+	/** The movement state last sent to the client, for each entity it has been sent for; keyed by the entity ID.
+	Protected by m_CSTrackedEntities. */
+	std::unordered_map<UInt32, sTrackedEntity> m_TrackedEntities;
+
+	/** Number of packets sent since the start of the current stats period. */
+	std::atomic<int> m_NumPacketsSent;
+
+	/** Number of bytes sent since the start of the current stats period. */
+	size_t m_NumBytesSent;
+
+	/** Number of bytes copied into the outgoing buffers since the start of the current stats period. */
+	size_t m_NumBytesCopied;
+
+	/** Number of ticks elapsed in the current stats period. */
+	int m_NumStatsTicks;
+
+	/** The averages from the last complete stats period. */
+	std::atomic<float> m_PacketsPerTick;
+	std::atomic<float> m_BytesPerTick;
+	std::atomic<float> m_CopiedBytesPerByteSent;
+
 	/** Finish logging the user in after authenticating. */
 	void FinishAuthenticate(const AString & a_Name, const cUUID & a_UUID, const Json::Value & a_Properties);
 
@@ -565,6 +669,10 @@ private:
 	/** Adds a single chunk to be streamed to the client; used by StreamChunks() */
 	void StreamChunk(int a_ChunkX, int a_ChunkZ, cChunkSender::eChunkPriority a_Priority);
 
+	/** Forgets the chunks that are queued for sending but not sent yet and are out of the view distance
+	around the specified chunk, so that no bandwidth is spent on them. */
+	void DropOutOfRangeQueuedChunks(int a_ChunkPosX, int a_ChunkPosZ);
+
 	/** Handles the DIG_STARTED dig packet: */
 	void HandleBlockDigStarted (int a_BlockX, int a_BlockY, int a_BlockZ, eBlockFace a_BlockFace, BLOCKTYPE a_OldBlock, NIBBLETYPE a_OldMeta);
 
@@ -593,6 +701,17 @@ private:
 	Called by both Tick() and ServerTick(). */
 	void ProcessProtocolInOut(void);
 
+	/** Feeds the received data to m_PingResponder and sends its response, if any, straight to the link.
+	Returns true if the data was consumed as a part of a server list ping. Called in the network thread, with m_CSIncomingData held. */
+	bool RespondToPing(const char * a_Data, size_t a_Length);
+
+	/** Called each tick to update the network stats and to prune the tracked entities that haven't been seen for a while. */
+	void TickStats(void);
+
+	/** Removes the entity from the movement tracking, so that the next SendEntityMovement() sends its full state.
+	Called whenever the entity is spawned or destroyed on the client. */
+	void ForgetTrackedEntity(const cEntity & a_Entity);
+
 	// cTCPLink::cCallbacks overrides:
 	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override;
 	virtual void OnReceivedData(const char * a_Data, size_t a_Length) override;
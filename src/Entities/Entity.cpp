@@ -38,9 +38,6 @@ cEntity::cEntity(eEntityType a_EntityType, double a_X, double a_Y, double a_Z, d
 	m_MaxHealth(1),
 	m_AttachedTo(nullptr),
 	m_Attachee(nullptr),
-	m_bDirtyHead(true),
-	m_bDirtyOrientation(true),
-	m_bHasSentNoSpeed(true),
 	m_bOnGround(false),
 	m_Gravity(-9.81f),
 	m_AirDrag(0.02f),
@@ -61,6 +58,7 @@ cEntity::cEntity(eEntityType a_EntityType, double a_X, double a_Y, double a_Z, d
 	m_TicksAlive(0),
 	m_IsTicking(false),
 	m_ParentChunk(nullptr),
+	m_IndexedSection(-1),
 	m_HeadYaw(0.0),
 	m_Rot(0.0, 0.0, 0.0),
 	m_Position(a_X, a_Y, a_Z),
@@ -964,7 +962,6 @@ void cEntity::HandlePhysics(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 			NextPos.y += 0.5;
 		}
 
-		m_bHasSentNoSpeed = false;  // this unlocks movement sending to client in BroadcastMovementUpdate function
 		m_bOnGround = true;
 
 		/*
@@ -1853,6 +1850,16 @@ void cEntity::TeleportToCoords(double a_PosX, double a_PosY, double a_PosZ)
 	if (!cRoot::Get()->GetPluginManager()->CallHookEntityTeleport(*this, m_LastPosition, Vector3d(a_PosX, a_PosY, a_PosZ)))
 	{
 		SetPosition(a_PosX, a_PosY, a_PosZ);
+
+		// Re-index the entity at its new height now, the queries would miss it until its chunk ticks otherwise:
+		{
+			cWorld::cLock Lock(*m_World);
+			if (m_ParentChunk != nullptr)
+			{
+				m_ParentChunk->UpdateEntityIndex(*this);
+			}
+		}
+
 		m_World->BroadcastTeleportEntity(*this);
 	}
 }
@@ -1866,71 +1873,8 @@ void cEntity::BroadcastMovementUpdate(const cClientHandle * a_Exclude)
 	// Process packet sending every two ticks
 	if (GetWorld()->GetWorldAge() % 2 == 0)
 	{
-		double SpeedSqr = GetSpeed().SqrLength();
-		if (SpeedSqr == 0.0)
-		{
-			// Speed is zero, send this to clients once only as well as an absolute position
-			if (!m_bHasSentNoSpeed)
-			{
-				m_World->BroadcastEntityVelocity(*this, a_Exclude);
-				m_World->BroadcastTeleportEntity(*this, a_Exclude);
-				m_bHasSentNoSpeed = true;
-			}
-		}
-		else
-		{
-			// Movin'
-			m_World->BroadcastEntityVelocity(*this, a_Exclude);
-			m_bHasSentNoSpeed = false;
-		}
-
-		// Only send movement if speed is not 0 and 'no speed' was sent to client
-		if (!m_bHasSentNoSpeed || IsPlayer())
-		{
-			// TODO: Pickups move disgracefully if relative move packets are sent as opposed to just velocity. Have a system to send relmove only when SetPosXXX() is called with a large difference in position
-			int DiffX = FloorC(GetPosX() * 32.0) - FloorC(m_LastSentPosition.x * 32.0);
-			int DiffY = FloorC(GetPosY() * 32.0) - FloorC(m_LastSentPosition.y * 32.0);
-			int DiffZ = FloorC(GetPosZ() * 32.0) - FloorC(m_LastSentPosition.z * 32.0);
-
-			if ((DiffX != 0) || (DiffY != 0) || (DiffZ != 0))  // Have we moved?
-			{
-				if ((abs(DiffX) <= 127) && (abs(DiffY) <= 127) && (abs(DiffZ) <= 127))  // Limitations of a Byte
-				{
-					// Difference within Byte limitations, use a relative move packet
-					if (m_bDirtyOrientation)
-					{
-						m_World->BroadcastEntityRelMoveLook(*this, static_cast<char>(DiffX), static_cast<char>(DiffY), static_cast<char>(DiffZ), a_Exclude);
-						m_bDirtyOrientation = false;
-					}
-					else
-					{
-						m_World->BroadcastEntityRelMove(*this, static_cast<char>(DiffX), static_cast<char>(DiffY), static_cast<char>(DiffZ), a_Exclude);
-					}
-					// Clients seem to store two positions, one for the velocity packet and one for the teleport / relmove packet
-					// The latter is only changed with a relmove / teleport, and m_LastSentPosition stores this position
-					m_LastSentPosition = GetPosition();
-				}
-				else
-				{
-					// Too big a movement, do a teleport
-					m_World->BroadcastTeleportEntity(*this, a_Exclude);
-					m_LastSentPosition = GetPosition();  // See above
-					m_bDirtyOrientation = false;
-				}
-			}
-		}
-
-		if (m_bDirtyHead)
-		{
-			m_World->BroadcastEntityHeadLook(*this, a_Exclude);
-			m_bDirtyHead = false;
-		}
-		if (m_bDirtyOrientation)
-		{
-			// Send individual update in case above (sending with rel-move packet) wasn't done
-			GetWorld()->BroadcastEntityLook(*this, a_Exclude);
-			m_bDirtyOrientation = false;
-		}
+		m_World->BroadcastEntityMovement(*this, a_Exclude);
+		m_LastSentPosition = GetPosition();
 	}
 }
 
@@ -2014,7 +1958,6 @@ bool cEntity::IsAttachedTo(const cEntity * a_Entity) const
 void cEntity::SetHeadYaw(double a_HeadYaw)
 {
 	m_HeadYaw = a_HeadYaw;
-	m_bDirtyHead = true;
 	WrapHeadYaw();
 }
 
@@ -2046,7 +1989,6 @@ void cEntity::SetMass(double a_Mass)
 void cEntity::SetYaw(double a_Yaw)
 {
 	m_Rot.x = a_Yaw;
-	m_bDirtyOrientation = true;
 	WrapRotation();
 }
 
@@ -2057,7 +1999,6 @@ void cEntity::SetYaw(double a_Yaw)
 void cEntity::SetPitch(double a_Pitch)
 {
 	m_Rot.y = a_Pitch;
-	m_bDirtyOrientation = true;
 	WrapRotation();
 }
 
@@ -2068,7 +2009,6 @@ void cEntity::SetPitch(double a_Pitch)
 void cEntity::SetRoll(double a_Roll)
 {
 	m_Rot.z = a_Roll;
-	m_bDirtyOrientation = true;
 }
 
 
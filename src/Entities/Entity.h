@@ -447,7 +447,8 @@ public:
 
 	virtual bool DoMoveToWorld(cWorld * a_World, bool a_ShouldSendRespawn, Vector3d a_NewPosition);
 
-	/** Updates clients of changes in the entity. */
+	/** Updates clients of changes in the entity's position, orientation and velocity.
+	Each client only gets sent what has changed since it was last updated, see cClientHandle::SendEntityMovement(). */
 	virtual void BroadcastMovementUpdate(const cClientHandle * a_Exclude = nullptr);
 
 	/** Gets entity (vehicle) attached to this entity */
@@ -524,6 +525,11 @@ public:
 	/** Returns the chunk responsible for ticking this entity. */
 	cChunk * GetParentChunk();
 
+	/** Returns the section of the parent chunk's entity index that the entity is listed in, -1 if not listed.
+	Only the chunk's cEntitySectionIndex should ever call the setter. */
+	int GetIndexedSection(void) const { return m_IndexedSection; }
+	void SetIndexedSection(int a_Section) { m_IndexedSection = a_Section; }
+
 	/** Set the entity's status to either ticking or not ticking. */
 	void SetIsTicking(bool a_IsTicking);
 
@@ -565,16 +571,6 @@ protected:
 	/** The entity which is attached to this entity (rider), nullptr if none */
 	cEntity * m_Attachee;
 
-	/** Stores whether head yaw has been set manually */
-	bool m_bDirtyHead;
-
-	/** Stores whether our yaw / pitch / roll (body orientation) has been set manually */
-	bool m_bDirtyOrientation;
-
-	/** Stores whether we have sent a Velocity packet with a speed of zero (no speed) to the client
-	Ensures that said packet is sent only once */
-	bool m_bHasSentNoSpeed;
-
 	/** Stores if the entity is on the ground */
 	bool m_bOnGround;
 
@@ -658,6 +654,9 @@ private:
 	/** The chunk which is responsible for ticking this entity. */
 	cChunk * m_ParentChunk;
 
+	/** The section of m_ParentChunk's entity index that the entity is listed in, -1 if not listed. */
+	int m_IndexedSection;
+
 	/** Measured in degrees, [-180, +180) */
 	double   m_HeadYaw;
 
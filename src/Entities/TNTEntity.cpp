@@ -22,8 +22,6 @@ cTNTEntity::cTNTEntity(Vector3d a_Pos, int a_FuseTicks) :
 void cTNTEntity::SpawnOn(cClientHandle & a_ClientHandle)
 {
 	a_ClientHandle.SendSpawnObject(*this, 50, 1, 0, 0);  // 50 means TNT
-	m_bDirtyOrientation = false;
-	m_bDirtyHead = false;
 }
 
 
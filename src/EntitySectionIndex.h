@@ -0,0 +1,209 @@
+
+// EntitySectionIndex.h
+
+// Declares the cEntitySectionIndex class template that indexes a chunk's entities by the section of the chunk they are in
+
+/*
+The box and radius queries (ForEachEntityInBox(), picking up the pickups) would otherwise walk all the entities of
+each chunk they overlap, which in a mob farm is thousands of items. The index groups the entities by the 16-block
+tall section their position is in, so that a query only looks at the sections around the queried height.
+
+The index is only ever changed from within the chunkmap lock: the chunk adds and removes its entities, re-indexes
+each entity after ticking it (Update()), and re-indexes the teleported entities right away. An entity moved from
+elsewhere (plugins, the vehicle packets on the tick thread) or falling between the ticks isn't re-indexed until its
+chunk ticks next, so the queries treat the index as a hint only, always check the entities' actual positions, and
+also look one section above the queried range, so that an entity that has fallen by up to a section since it was
+indexed is still found. Players are moved by their clients all the time, so they aren't indexed by height at all;
+they are kept in a separate list that every query goes through.
+
+The queries' callbacks may add and remove entities (for example by spawning or collecting them). The lists are
+therefore walked by index, and a removal during a query only leaves an empty slot, which is compacted once the
+outermost query finishes.
+
+The entity type is a template parameter so that the index can be tested without the whole cEntity; it needs to
+provide IsPlayer(), GetPosY() and the GetIndexedSection() / SetIndexedSection() storage for the index.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkData.h"
+
+
+
+
+
+template <class EntityType>
+class cEntitySectionIndex
+{
+public:
+
+	cEntitySectionIndex(void):
+		m_NumQueries(0),
+		m_HasEmptySlots(false)
+	{
+	}
+
+	/** Returns the section for the specified Y coord. Positions above or below the world go to the top or bottom section. */
+	static int GetSection(double a_PosY)
+	{
+		return Clamp(FloorC(a_PosY / cChunkData::SectionHeight), 0, static_cast<int>(cChunkData::NumSections) - 1);
+	}
+
+	/** Adds the entity to the section matching its current position, or to the players. */
+	void Add(EntityType & a_Entity)
+	{
+		if (a_Entity.IsPlayer())
+		{
+			m_Players.push_back(&a_Entity);
+			return;
+		}
+		int Section = GetSection(a_Entity.GetPosY());
+		m_Sections[Section].push_back(&a_Entity);
+		a_Entity.SetIndexedSection(Section);
+	}
+
+	/** Removes the entity, which must be in the index. */
+	void Remove(EntityType & a_Entity)
+	{
+		auto & List = a_Entity.IsPlayer() ? m_Players : m_Sections[a_Entity.GetIndexedSection()];
+		auto itr = std::find(List.begin(), List.end(), &a_Entity);
+		ASSERT(itr != List.end());
+		if (itr != List.end())
+		{
+			if (m_NumQueries > 0)
+			{
+				// A query is walking the list, leave an empty slot so that the query doesn't skip any entity:
+				*itr = nullptr;
+				m_HasEmptySlots = true;
+			}
+			else
+			{
+				// The order doesn't matter, swap with the last one for a cheap removal:
+				*itr = List.back();
+				List.pop_back();
+			}
+		}
+		a_Entity.SetIndexedSection(-1);
+	}
+
+	/** Moves the entity to the section matching its current position, if it has changed. */
+	void Update(EntityType & a_Entity)
+	{
+		int OldSection = a_Entity.GetIndexedSection();
+		if ((OldSection < 0) || (OldSection == GetSection(a_Entity.GetPosY())))
+		{
+			// Not indexed by height (a player), or still in the same section
+			return;
+		}
+		Remove(a_Entity);
+		Add(a_Entity);
+	}
+
+	/** Removes all the entities from the index. */
+	void Clear(void)
+	{
+		ASSERT(m_NumQueries == 0);
+		for (auto & Section : m_Sections)
+		{
+			Section.clear();
+		}
+		m_Players.clear();
+		m_HasEmptySlots = false;
+	}
+
+	/** Calls a_Callback for each entity that may be touching the specified Y range: the players, then the entities
+	indexed in the sections around the range. The entities are assumed to be at most one section tall, and to have
+	fallen by at most one section since they were last indexed.
+	Stops and returns false once the callback returns true, returns true if all the entities were processed. */
+	template <class Callback>
+	bool ForEachAroundHeight(double a_MinY, double a_MaxY, Callback a_Callback)
+	{
+		// An entity's position is at its bottom, so an entity up to one section tall may reach in from the section below.
+		// An entity still indexed in the section above may have fallen into the range since the chunk last ticked:
+		int MinSection = GetSection(a_MinY - cChunkData::SectionHeight);
+		int MaxSection = GetSection(a_MaxY + cChunkData::SectionHeight);
+
+		m_NumQueries += 1;
+		bool Res = ForEachInList(m_Players, a_Callback);
+		for (int Section = MinSection; Res && (Section <= MaxSection); Section++)
+		{
+			Res = ForEachInList(m_Sections[Section], a_Callback);
+		}
+		m_NumQueries -= 1;
+
+		if ((m_NumQueries == 0) && m_HasEmptySlots)
+		{
+			RemoveEmptySlots();
+		}
+		return Res;
+	}
+
+	/** Returns the number of entities in the index, for the tests. */
+	size_t GetNumEntities(void) const
+	{
+		size_t Res = CountInList(m_Players);
+		for (const auto & Section : m_Sections)
+		{
+			Res += CountInList(Section);
+		}
+		return Res;
+	}
+
+protected:
+
+	typedef std::vector<EntityType *> cEntityPtrs;
+
+	/** The non-player entities, by the section of their position when they were last indexed. */
+	cEntityPtrs m_Sections[cChunkData::NumSections];
+
+	/** The players, not indexed by height. */
+	cEntityPtrs m_Players;
+
+	/** The number of ForEachAroundHeight() calls in progress, nested through the callbacks. */
+	int m_NumQueries;
+
+	/** Set when an entity has been removed during a query, leaving an empty slot (nullptr) behind. */
+	bool m_HasEmptySlots;
+
+
+	/** Calls a_Callback for each entity in the list; returns false if the callback aborted by returning true. */
+	template <class Callback>
+	static bool ForEachInList(const cEntityPtrs & a_List, Callback & a_Callback)
+	{
+		// The callback may add entities to the list, reallocating it, hence the index and the size re-read on each step:
+		for (size_t i = 0; i < a_List.size(); i++)
+		{
+			EntityType * Entity = a_List[i];
+			if ((Entity != nullptr) && a_Callback(*Entity))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Returns the number of entities in the list, not counting the empty slots. */
+	static size_t CountInList(const cEntityPtrs & a_List)
+	{
+		return a_List.size() - static_cast<size_t>(std::count(a_List.begin(), a_List.end(), nullptr));
+	}
+
+	/** Removes the empty slots left by the removals during the queries. */
+	void RemoveEmptySlots(void)
+	{
+		m_Players.erase(std::remove(m_Players.begin(), m_Players.end(), nullptr), m_Players.end());
+		for (auto & Section : m_Sections)
+		{
+			Section.erase(std::remove(Section.begin(), Section.end(), nullptr), Section.end());
+		}
+		m_HasEmptySlots = false;
+	}
+} ;
+
+
+
+
@@ -26,9 +26,9 @@ const unsigned int QUEUE_SKIP_LIMIT = 500;
 // cChunkGenerator:
 
 cChunkGenerator::cChunkGenerator(void) :
-	super("cChunkGenerator"),
 	m_Seed(0),  // Will be overwritten by the actual generator
-	m_Generator(nullptr),
+	m_ShouldTerminate(false),
+	m_NumChunksGenerated(0),
 	m_PluginInterface(nullptr),
 	m_ChunkSink(nullptr)
 {
@@ -64,29 +64,33 @@ bool cChunkGenerator::Initialize(cPluginInterface & a_PluginInterface, cChunkSin
 		a_IniFile.SetValueI("Seed", "Seed", m_Seed);
 	}
 
-	// Get the generator engine based on the INI file settings:
-	AString GeneratorName = a_IniFile.GetValueSet("Generator", "Generator", "Composable");
-	if (NoCaseCompare(GeneratorName, "Noise3D") == 0)
-	{
-		m_Generator = new cNoise3DGenerator(*this);
-	}
-	else
+	// Create a generator engine for each worker:
+	int NumThreads = Clamp(a_IniFile.GetValueSetI("Generator", "NumThreads", 1), 1, 64);
+	for (int i = 0; i < NumThreads; i++)
 	{
-		if (NoCaseCompare(GeneratorName, "composable") != 0)
+		auto Generator = CreateGenerator(a_IniFile);
+		if (Generator == nullptr)
 		{
-			LOGWARN("[Generator]::Generator value \"%s\" not recognized, using \"Composable\".", GeneratorName.c_str());
+			LOGERROR("Generator could not start, aborting the server");
+			m_Workers.clear();
+			return false;
 		}
-		m_Generator = new cComposableGenerator(*this);
+		m_Workers.push_back(cpp14::make_unique<cWorker>(*this, std::move(Generator)));
 	}
+	return true;
+}
+
 
-	if (m_Generator == nullptr)
+
+
+
+void cChunkGenerator::Start(void)
+{
+	m_ShouldTerminate = false;
+	for (auto & Worker : m_Workers)
 	{
-		LOGERROR("Generator could not start, aborting the server");
-		return false;
+		Worker->Start();
 	}
-
-	m_Generator->Initialize(a_IniFile);
-	return true;
 }
 
 
@@ -98,10 +102,12 @@ void cChunkGenerator::Stop(void)
 	m_ShouldTerminate = true;
 	m_Event.Set();
 	m_evtRemoved.Set();  // Wake up anybody waiting for empty queue
-	Wait();
+	for (auto & Worker : m_Workers)
+	{
+		Worker->Wait();
+	}
 
-	delete m_Generator;
-	m_Generator = nullptr;
+	m_Workers.clear();
 }
 
 
@@ -120,6 +126,13 @@ void cChunkGenerator::QueueGenerateChunk(int a_ChunkX, int a_ChunkZ, bool a_Forc
 		{
 			LOGWARN("WARNING: Adding chunk [%i, %i] to generation queue; Queue is too big! (" SIZE_T_FMT ")", a_ChunkX, a_ChunkZ, m_Queue.size());
 		}
+		// If the generator has been idle, restart the performance counting, so that the idle time isn't counted:
+		if (m_Queue.empty() && m_ChunksBeingGenerated.empty())
+		{
+			m_NumChunksGenerated = 0;
+			m_GenerationStart = std::chrono::steady_clock::now();
+			m_LastReport = m_GenerationStart;
+		}
 		m_Queue.push_back(cQueueItem{a_ChunkX, a_ChunkZ, a_ForceGenerate, a_Callback});
 	}
 
@@ -132,9 +145,9 @@ void cChunkGenerator::QueueGenerateChunk(int a_ChunkX, int a_ChunkZ, bool a_Forc
 
 void cChunkGenerator::GenerateBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap)
 {
-	if (m_Generator != nullptr)
+	if (!m_Workers.empty())
 	{
-		m_Generator->GenerateBiomes(a_ChunkX, a_ChunkZ, a_BiomeMap);
+		m_Workers[0]->GetGenerator().GenerateBiomes(a_ChunkX, a_ChunkZ, a_BiomeMap);
 	}
 }
 
@@ -145,7 +158,7 @@ void cChunkGenerator::GenerateBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::Biom
 void cChunkGenerator::WaitForQueueEmpty(void)
 {
 	cCSLock Lock(m_CS);
-	while (!m_ShouldTerminate && !m_Queue.empty())
+	while (!m_ShouldTerminate && (!m_Queue.empty() || !m_ChunksBeingGenerated.empty()))
 	{
 		cCSUnlock Unlock(Lock);
 		m_evtRemoved.Wait();
@@ -168,8 +181,8 @@ int cChunkGenerator::GetQueueLength(void)
 
 EMCSBiome cChunkGenerator::GetBiomeAt(int a_BlockX, int a_BlockZ)
 {
-	ASSERT(m_Generator != nullptr);
-	return m_Generator->GetBiomeAt(a_BlockX, a_BlockZ);
+	ASSERT(!m_Workers.empty());
+	return m_Workers[0]->GetGenerator().GetBiomeAt(a_BlockX, a_BlockZ);
 }
 
 
@@ -192,64 +205,140 @@ BLOCKTYPE cChunkGenerator::GetIniBlock(cIniFile & a_IniFile, const AString & a_S
 
 
 
-void cChunkGenerator::Execute(void)
+std::unique_ptr<cChunkGenerator::cGenerator> cChunkGenerator::CreateGenerator(cIniFile & a_IniFile)
 {
-	// To be able to display performance information, the generator counts the chunks generated.
-	// When the queue gets empty, the count is reset, so that waiting for the queue is not counted into the total time.
-	int NumChunksGenerated = 0;  // Number of chunks generated since the queue was last empty
-	clock_t GenerationStart = clock();  // Clock tick when the queue started to fill
-	clock_t LastReportTick = clock();  // Clock tick of the last report made (so that performance isn't reported too often)
+	// Get the generator engine based on the INI file settings:
+	std::unique_ptr<cGenerator> Generator;
+	AString GeneratorName = a_IniFile.GetValueSet("Generator", "Generator", "Composable");
+	if (NoCaseCompare(GeneratorName, "Noise3D") == 0)
+	{
+		Generator.reset(new cNoise3DGenerator(*this));
+	}
+	else
+	{
+		if (NoCaseCompare(GeneratorName, "composable") != 0)
+		{
+			LOGWARN("[Generator]::Generator value \"%s\" not recognized, using \"Composable\".", GeneratorName.c_str());
+		}
+		Generator.reset(new cComposableGenerator(*this));
+	}
 
-	while (!m_ShouldTerminate)
+	if (Generator != nullptr)
 	{
-		cCSLock Lock(m_CS);
-		while (m_Queue.empty())
+		Generator->Initialize(a_IniFile);
+	}
+	return Generator;
+}
+
+
+
+
+
+bool cChunkGenerator::DequeueItem(cQueueItem & a_Item, bool & a_SkipEnabled)
+{
+	cCSLock Lock(m_CS);
+	for (;;)
+	{
+		if (m_ShouldTerminate)
 		{
-			if ((NumChunksGenerated > 16) && (clock() - LastReportTick > CLOCKS_PER_SEC))
+			// Wake up the next worker so that it terminates, too:
+			m_Event.Set();
+			return false;
+		}
+
+		// Pick the first chunk that isn't being generated by another worker already:
+		for (auto itr = m_Queue.begin(), end = m_Queue.end(); itr != end; ++itr)
+		{
+			cChunkCoords Coords(itr->m_ChunkX, itr->m_ChunkZ);
+			if (std::find(m_ChunksBeingGenerated.begin(), m_ChunksBeingGenerated.end(), Coords) != m_ChunksBeingGenerated.end())
 			{
-				/* LOG("Chunk generator performance: %.2f ch / sec (%d ch total)",
-					static_cast<double>(NumChunksGenerated) * CLOCKS_PER_SEC/ (clock() - GenerationStart),
-					NumChunksGenerated
-				); */
+				continue;
 			}
-			cCSUnlock Unlock(Lock);
-			m_Event.Wait();
-			if (m_ShouldTerminate)
+			a_Item = *itr;
+			a_SkipEnabled = (m_Queue.size() > QUEUE_SKIP_LIMIT);
+			m_Queue.erase(itr);
+			m_ChunksBeingGenerated.push_back(Coords);
+			if (!m_Queue.empty())
 			{
-				return;
+				// There's more work, wake up another worker:
+				m_Event.Set();
 			}
-			NumChunksGenerated = 0;
-			GenerationStart = clock();
-			LastReportTick = clock();
+			m_evtRemoved.Set();
+			return true;
 		}
 
-		if (m_Queue.empty())
-		{
-			// Sometimes the queue remains empty
-			// If so, we can't do any front() operations on it!
-			continue;
-		}
+		cCSUnlock Unlock(Lock);
+		m_Event.Wait();
+	}
+}
+
 
-		cQueueItem item = m_Queue.front();  // Get next chunk from the queue
-		bool SkipEnabled = (m_Queue.size() > QUEUE_SKIP_LIMIT);
-		m_Queue.erase(m_Queue.begin());  // Remove the item from the queue
-		Lock.Unlock();  // Unlock ASAP
-		m_evtRemoved.Set();
+
+
+
+void cChunkGenerator::ItemDone(const cQueueItem & a_Item, bool a_HasGenerated)
+{
+	{
+		cCSLock Lock(m_CS);
+		auto itr = std::find(m_ChunksBeingGenerated.begin(), m_ChunksBeingGenerated.end(), cChunkCoords(a_Item.m_ChunkX, a_Item.m_ChunkZ));
+		ASSERT(itr != m_ChunksBeingGenerated.end());
+		m_ChunksBeingGenerated.erase(itr);
 
 		// Display perf info once in a while:
-		if ((NumChunksGenerated > 512) && (clock() - LastReportTick > 2 * CLOCKS_PER_SEC))
+		if (a_HasGenerated)
+		{
+			m_NumChunksGenerated++;
+			auto Now = std::chrono::steady_clock::now();
+			if ((m_NumChunksGenerated > 512) && (Now - m_LastReport > std::chrono::seconds(2)))
+			{
+				auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(Now - m_GenerationStart).count();
+				LOG("Chunk generator performance: %.2f ch / sec (%d ch total, " SIZE_T_FMT " threads)",
+					static_cast<double>(m_NumChunksGenerated) / Elapsed, m_NumChunksGenerated, m_Workers.size()
+				);
+				m_LastReport = Now;
+			}
+		}
+
+		if (m_Queue.empty())
 		{
-			LOG("Chunk generator performance: %.2f ch / sec (%d ch total)",
-				static_cast<double>(NumChunksGenerated) * CLOCKS_PER_SEC / (clock() - GenerationStart),
-				NumChunksGenerated
-			);
-			LastReportTick = clock();
+			m_evtRemoved.Set();  // WaitForQueueEmpty() waits for the chunks being generated, too
+			return;
 		}
+	}
+
+	// A queued duplicate of this chunk may have been skipped by the workers, wake them up again:
+	m_Event.Set();
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkGenerator::cWorker:
 
+cChunkGenerator::cWorker::cWorker(cChunkGenerator & a_Parent, std::unique_ptr<cGenerator> a_Generator) :
+	super("cChunkGenerator"),
+	m_Parent(a_Parent),
+	m_Generator(std::move(a_Generator))
+{
+}
+
+
+
+
+
+void cChunkGenerator::cWorker::Execute(void)
+{
+	cQueueItem item;
+	bool SkipEnabled;
+	while (m_Parent.DequeueItem(item, SkipEnabled))
+	{
 		// Skip the chunk if it's already generated and regeneration is not forced. Report as success:
-		if (!item.m_ForceGenerate && m_ChunkSink->IsChunkValid(item.m_ChunkX, item.m_ChunkZ))
+		if (!item.m_ForceGenerate && m_Parent.m_ChunkSink->IsChunkValid(item.m_ChunkX, item.m_ChunkZ))
 		{
 			LOGD("Chunk [%d, %d] already generated, skipping generation", item.m_ChunkX, item.m_ChunkZ);
+			m_Parent.ItemDone(item, false);
 			if (item.m_Callback != nullptr)
 			{
 				item.m_Callback->Call(item.m_ChunkX, item.m_ChunkZ, true);
@@ -258,9 +347,10 @@ void cChunkGenerator::Execute(void)
 		}
 
 		// Skip the chunk if the generator is overloaded:
-		if (SkipEnabled && !m_ChunkSink->HasChunkAnyClients(item.m_ChunkX, item.m_ChunkZ))
+		if (SkipEnabled && !m_Parent.m_ChunkSink->HasChunkAnyClients(item.m_ChunkX, item.m_ChunkZ))
 		{
 			LOGWARNING("Chunk generator overloaded, skipping chunk [%d, %d]", item.m_ChunkX, item.m_ChunkZ);
+			m_Parent.ItemDone(item, false);
 			if (item.m_Callback != nullptr)
 			{
 				item.m_Callback->Call(item.m_ChunkX, item.m_ChunkZ, false);
@@ -271,33 +361,34 @@ void cChunkGenerator::Execute(void)
 		// Generate the chunk:
 		// LOGD("Generating chunk [%d, %d]", item.m_ChunkX, item.m_ChunkZ);
 		DoGenerate(item.m_ChunkX, item.m_ChunkZ);
+		m_Parent.ItemDone(item, true);
 		if (item.m_Callback != nullptr)
 		{
 			item.m_Callback->Call(item.m_ChunkX, item.m_ChunkZ, true);
 		}
-		NumChunksGenerated++;
-	}  // while (!bStop)
+	}  // while (DequeueItem())
 }
 
 
 
 
-void cChunkGenerator::DoGenerate(int a_ChunkX, int a_ChunkZ)
+
+void cChunkGenerator::cWorker::DoGenerate(int a_ChunkX, int a_ChunkZ)
 {
-	ASSERT(m_PluginInterface != nullptr);
-	ASSERT(m_ChunkSink != nullptr);
+	ASSERT(m_Parent.m_PluginInterface != nullptr);
+	ASSERT(m_Parent.m_ChunkSink != nullptr);
 
 	cChunkDesc ChunkDesc(a_ChunkX, a_ChunkZ);
-	m_PluginInterface->CallHookChunkGenerating(ChunkDesc);
+	m_Parent.m_PluginInterface->CallHookChunkGenerating(ChunkDesc);
 	m_Generator->DoGenerate(a_ChunkX, a_ChunkZ, ChunkDesc);
-	m_PluginInterface->CallHookChunkGenerated(ChunkDesc);
+	m_Parent.m_PluginInterface->CallHookChunkGenerated(ChunkDesc);
 
 	#ifdef _DEBUG
 		// Verify that the generator has produced valid data:
 		ChunkDesc.VerifyHeightmap();
 	#endif
 
-	m_ChunkSink->OnChunkGenerated(ChunkDesc);
+	m_Parent.m_ChunkSink->OnChunkGenerated(ChunkDesc);
 }
 
 
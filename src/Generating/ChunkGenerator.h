@@ -4,11 +4,12 @@
 // Interfaces to the cChunkGenerator class representing the thread that generates chunks
 
 /*
-The object takes requests for generating chunks and processes them in a separate thread one by one.
-The requests are not added to the queue if there is already a request with the same coords
-Before generating, the thread checks if the chunk hasn't been already generated.
-It is theoretically possible to have multiple generator threads by having multiple instances of this object,
-but then it MAY happen that the chunk is generated twice.
+The object takes requests for generating chunks and processes them in one or more worker threads.
+Before generating, the worker checks if the chunk hasn't been already generated.
+Each worker has its own instance of the generator engine, so that the engines' caches need no locking. The
+engines generate each chunk purely from the seed and the chunk coords, so the output is the same regardless
+of the number of workers and the order in which they process the chunks. A chunk that is being generated by
+one worker is never picked up by another one.
 If the generator queue is overloaded, the generator skips chunks with no clients in them
 */
 
@@ -32,11 +33,8 @@ class cChunkDesc;
 
 
 
-class cChunkGenerator :
-	public cIsThread
+class cChunkGenerator
 {
-	typedef cIsThread super;
-
 public:
 	/** The interface that a class has to implement to become a generator */
 	class cGenerator
@@ -108,11 +106,15 @@ public:
 
 
 	cChunkGenerator (void);
-	virtual ~cChunkGenerator() override;
+	~cChunkGenerator();
 
-	/** Read settings from the ini file and initialize in preperation for being started. */
+	/** Read settings from the ini file and initialize in preperation for being started.
+	Creates a generator engine for each of the [Generator] NumThreads worker threads. */
 	bool Initialize(cPluginInterface & a_PluginInterface, cChunkSink & a_ChunkSink, cIniFile & a_IniFile);
 
+	/** Starts the worker threads. */
+	void Start(void);
+
 	void Stop(void);
 
 	/** Queues the chunk for generation
@@ -134,6 +136,9 @@ public:
 	/** Returns the biome at the specified coords. Used by ChunkMap if an invalid chunk is queried for biome */
 	EMCSBiome GetBiomeAt(int a_BlockX, int a_BlockZ);
 
+	/** Returns the number of worker threads generating the chunks. */
+	size_t GetNumWorkers(void) const { return m_Workers.size(); }
+
 	/** Reads a block type from the ini file; returns the blocktype on success, emits a warning and returns a_Default's representation on failure. */
 	static BLOCKTYPE GetIniBlock(cIniFile & a_IniFile, const AString & a_SectionName, const AString & a_ValueName, const AString & a_Default);
 
@@ -154,6 +159,32 @@ private:
 	typedef std::list<cQueueItem> cGenQueue;
 
 
+	/** A single thread generating the chunks from the shared queue. */
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+		cWorker(cChunkGenerator & a_Parent, std::unique_ptr<cGenerator> a_Generator);
+
+		/** Returns the generator engine used by this worker. */
+		cGenerator & GetGenerator(void) { return *m_Generator; }
+
+	protected:
+		cChunkGenerator & m_Parent;
+
+		/** The generator engine, owned by this worker so that its caches are never accessed from multiple threads. */
+		std::unique_ptr<cGenerator> m_Generator;
+
+		// cIsThread override:
+		virtual void Execute(void) override;
+
+		/** Generates the specified chunk and sets it into the chunksink. */
+		void DoGenerate(int a_ChunkX, int a_ChunkZ);
+	} ;
+
+
 	/** Seed used for the generator. */
 	int m_Seed;
 
@@ -163,14 +194,29 @@ private:
 	/** Queue of the chunks to be generated. Protected against multithreaded access by m_CS. */
 	cGenQueue m_Queue;
 
-	/** Set when an item is added to the queue or the thread should terminate. */
+	/** Coords of the chunks currently being generated by the workers. Protected against multithreaded access by m_CS. */
+	std::vector<cChunkCoords> m_ChunksBeingGenerated;
+
+	/** Set when an item is added to the queue or the threads should terminate. */
 	cEvent m_Event;
 
 	/** Set when an item is removed from the queue. */
 	cEvent m_evtRemoved;
 
-	/** The actual generator engine used to generate chunks. */
-	cGenerator * m_Generator;
+	/** Set when the worker threads should terminate. */
+	std::atomic<bool> m_ShouldTerminate;
+
+	/** The worker threads. The first worker's generator engine is also used for the direct GenerateBiomes() and GetBiomeAt() calls. */
+	std::vector<std::unique_ptr<cWorker>> m_Workers;
+
+	/** Number of chunks generated since the queue was last empty, for the performance reports. Protected by m_CS. */
+	int m_NumChunksGenerated;
+
+	/** Time when the queue started filling up, for the performance reports. Protected by m_CS. */
+	std::chrono::steady_clock::time_point m_GenerationStart;
+
+	/** Time of the last performance report (so that the performance isn't reported too often). Protected by m_CS. */
+	std::chrono::steady_clock::time_point m_LastReport;
 
 	/** The plugin interface that may modify the generated chunks */
 	cPluginInterface * m_PluginInterface;
@@ -179,11 +225,18 @@ private:
 	cChunkSink * m_ChunkSink;
 
 
-	// cIsThread override:
-	virtual void Execute(void) override;
+	/** Creates and initializes the generator engine specified in the ini file.
+	Returns nullptr if the engine cannot be created. */
+	std::unique_ptr<cGenerator> CreateGenerator(cIniFile & a_IniFile);
+
+	/** Waits for a queue item that isn't being generated by another worker and removes it from the queue.
+	a_SkipEnabled is set if the queue is overloaded.
+	Returns false if the workers should terminate. */
+	bool DequeueItem(cQueueItem & a_Item, bool & a_SkipEnabled);
 
-	/** Generates the specified chunk and sets it into the chunksink. */
-	void DoGenerate(int a_ChunkX, int a_ChunkZ);
+	/** Called by the worker when it has finished processing the specified item.
+	a_HasGenerated is true if the chunk was actually generated (rather than skipped). */
+	void ItemDone(const cQueueItem & a_Item, bool a_HasGenerated);
 };
 
 
@@ -0,0 +1,294 @@
+
+// LightCalculator.cpp
+
+// Implements the cLightCalculator class that calculates the light of a whole chunk from the blocks of its 3x3 chunk neighborhood
+
+#include "Globals.h"
+#include "LightCalculator.h"
+#include "ChunkData.h"
+
+
+
+
+
+cLightCalculator::cLightCalculator(void):
+	m_MaxHeight(0),
+	m_NumSeeds(0)
+{
+}
+
+
+
+
+
+void cLightCalculator::Reset(void)
+{
+	// The blocks above the heights read aren't copied, they need to be air rather than what the previous area had:
+	memset(m_BlockTypes, E_BLOCK_AIR, sizeof(m_BlockTypes));
+	m_MaxHeight = 0;
+}
+
+
+
+
+
+void cLightCalculator::ReadHeightMap(int a_X, int a_Z, const cChunkDef::HeightMap & a_HeightMap)
+{
+	// Copy the entire heightmap, distribute it into the 3x3 chunk blob:
+	typedef struct {HEIGHTTYPE m_Row[16]; } ROW;
+	const ROW * InputRows  = reinterpret_cast<const ROW *>(a_HeightMap);
+	ROW * OutputRows = reinterpret_cast<ROW *>(m_HeightMap);
+	int InputIdx = 0;
+	int OutputIdx = a_X + a_Z * cChunkDef::Width * 3;
+	for (int z = 0; z < cChunkDef::Width; z++)
+	{
+		OutputRows[OutputIdx] = InputRows[InputIdx++];
+		OutputIdx += 3;
+	}  // for z
+
+	// Find the highest block in the entire chunk, use it as a base for m_MaxHeight:
+	HEIGHTTYPE MaxHeight = m_MaxHeight;
+	for (size_t i = 0; i < ARRAYCOUNT(a_HeightMap); i++)
+	{
+		if (a_HeightMap[i] > MaxHeight)
+		{
+			MaxHeight = a_HeightMap[i];
+		}
+	}
+	m_MaxHeight = MaxHeight;
+}
+
+
+
+
+
+void cLightCalculator::ReadBlockTypes(int a_X, int a_Z, const cChunkData & a_ChunkData)
+{
+	BLOCKTYPE * OutputRows = m_BlockTypes;
+	int InputIdx = 0;
+	int OutputIdx = a_X + a_Z * cChunkDef::Width * 3;
+	int MaxHeight = std::min(+cChunkDef::Height, m_MaxHeight + 16);  // Need 16 blocks above the highest
+	for (int y = 0; y < MaxHeight; y++)
+	{
+		for (int z = 0; z < cChunkDef::Width; z++)
+		{
+			a_ChunkData.CopyBlockTypes(OutputRows + OutputIdx * 16, static_cast<size_t>(InputIdx * 16), 16);
+			InputIdx++;
+			OutputIdx += 3;
+		}  // for z
+		// Skip into the next y-level in the 3x3 chunk blob; each level has cChunkDef::Width * 9 rows
+		// We've already walked cChunkDef::Width * 3 in the "for z" cycle, that makes cChunkDef::Width * 6 rows left to skip
+		OutputIdx += cChunkDef::Width * 6;
+	}  // for y
+}
+
+
+
+
+
+void cLightCalculator::CalcLight(cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight)
+{
+	memset(m_BlockLight, 0, sizeof(m_BlockLight));
+	memset(m_SkyLight,   0, sizeof(m_SkyLight));
+
+	PrepareBlockLight();
+	CalcLight(m_BlockLight);
+
+	PrepareSkyLight();
+	CalcLight(m_SkyLight);
+
+	CompressLight(m_BlockLight, a_BlockLight);
+	CompressLight(m_SkyLight, a_SkyLight);
+}
+
+
+
+
+
+void cLightCalculator::PrepareSkyLight(void)
+{
+	// Clear seeds:
+	memset(m_IsSeed1, 0, sizeof(m_IsSeed1));
+	m_NumSeeds = 0;
+
+	// Fill the top of the chunk with all-light:
+	if (m_MaxHeight < cChunkDef::Height - 1)
+	{
+		std::fill(m_SkyLight + (m_MaxHeight + 1) * BlocksPerYLayer, m_SkyLight + ARRAYCOUNT(m_SkyLight), 15);
+	}
+
+	// Walk every column that has all XZ neighbors
+	for (int z = 1; z < cChunkDef::Width * 3 - 1; z++)
+	{
+		int BaseZ = z * cChunkDef::Width * 3;
+		for (int x = 1; x < cChunkDef::Width * 3 - 1; x++)
+		{
+			int idx = BaseZ + x;
+			// Find the lowest block in this column that receives full sunlight (go through transparent blocks):
+			int Current = m_HeightMap[idx];
+			ASSERT(Current < cChunkDef::Height);
+			while (
+				(Current >= 0) &&
+				cBlockInfo::IsTransparent(m_BlockTypes[idx + Current * BlocksPerYLayer]) &&
+				!cBlockInfo::IsSkylightDispersant(m_BlockTypes[idx + Current * BlocksPerYLayer])
+			)
+			{
+				Current -= 1;  // Sunlight goes down unchanged through this block
+			}
+			Current += 1;  // Point to the last sunlit block, rather than the first non-transparent one
+			// The other neighbors don't need transparent-block-checking. At worst we'll have a few dud seeds above the ground.
+			int Neighbor1 = m_HeightMap[idx + 1] + 1;  // X + 1
+			int Neighbor2 = m_HeightMap[idx - 1] + 1;  // X - 1
+			int Neighbor3 = m_HeightMap[idx + cChunkDef::Width * 3] + 1;  // Z + 1
+			int Neighbor4 = m_HeightMap[idx - cChunkDef::Width * 3] + 1;  // Z - 1
+			int MaxNeighbor = std::max(std::max(Neighbor1, Neighbor2), std::max(Neighbor3, Neighbor4));  // Maximum of the four neighbors
+
+			// Fill the column from m_MaxHeight to Current with all-light:
+			for (int y = m_MaxHeight, Index = idx + y * BlocksPerYLayer; y >= Current; y--, Index -= BlocksPerYLayer)
+			{
+				m_SkyLight[Index] = 15;
+			}
+
+			// Add Current as a seed:
+			if (Current < cChunkDef::Height)
+			{
+				int CurrentIdx = idx + Current * BlocksPerYLayer;
+				m_IsSeed1[CurrentIdx] = true;
+				m_SeedIdx1[m_NumSeeds++] = static_cast<UInt32>(CurrentIdx);
+			}
+
+			// Add seed from Current up to the highest neighbor:
+			for (int y = Current + 1, Index = idx + y * BlocksPerYLayer; y < MaxNeighbor; y++, Index += BlocksPerYLayer)
+			{
+				m_IsSeed1[Index] = true;
+				m_SeedIdx1[m_NumSeeds++] = static_cast<UInt32>(Index);
+			}
+		}
+	}
+}
+
+
+
+
+void cLightCalculator::PrepareBlockLight(void)
+{
+	// Clear seeds:
+	memset(m_IsSeed1, 0, sizeof(m_IsSeed1));
+	memset(m_IsSeed2, 0, sizeof(m_IsSeed2));
+	m_NumSeeds = 0;
+
+	// Add each emissive block into the seeds; the highest block may be emissive as well:
+	for (int Idx = 0; Idx < ((m_MaxHeight + 1) * BlocksPerYLayer); ++Idx)
+	{
+		if (cBlockInfo::GetLightValue(m_BlockTypes[Idx]) == 0)
+		{
+			// Not a light-emissive block
+			continue;
+		}
+
+		// Add current block as a seed:
+		m_IsSeed1[Idx] = true;
+		m_SeedIdx1[m_NumSeeds++] = static_cast<UInt32>(Idx);
+
+		// Light it up:
+		m_BlockLight[Idx] = cBlockInfo::GetLightValue(m_BlockTypes[Idx]);
+	}
+}
+
+
+
+
+void cLightCalculator::CalcLight(NIBBLETYPE * a_Light)
+{
+	size_t NumSeeds2 = 0;
+	while (m_NumSeeds > 0)
+	{
+		// Buffer 1 -> buffer 2
+		memset(m_IsSeed2, 0, sizeof(m_IsSeed2));
+		NumSeeds2 = 0;
+		CalcLightStep(a_Light, m_NumSeeds, m_IsSeed1, m_SeedIdx1, NumSeeds2, m_IsSeed2, m_SeedIdx2);
+		if (NumSeeds2 == 0)
+		{
+			return;
+		}
+
+		// Buffer 2 -> buffer 1
+		memset(m_IsSeed1, 0, sizeof(m_IsSeed1));
+		m_NumSeeds = 0;
+		CalcLightStep(a_Light, NumSeeds2, m_IsSeed2, m_SeedIdx2, m_NumSeeds, m_IsSeed1, m_SeedIdx1);
+	}
+}
+
+
+
+
+void cLightCalculator::CalcLightStep(
+	NIBBLETYPE * a_Light,
+	size_t a_NumSeedsIn,    unsigned char * a_IsSeedIn,  unsigned int * a_SeedIdxIn,
+	size_t & a_NumSeedsOut, unsigned char * a_IsSeedOut, unsigned int * a_SeedIdxOut
+)
+{
+	UNUSED(a_IsSeedIn);
+	size_t NumSeedsOut = 0;
+	for (size_t i = 0; i < a_NumSeedsIn; i++)
+	{
+		UInt32 SeedIdx = static_cast<UInt32>(a_SeedIdxIn[i]);
+		int SeedX = SeedIdx % (cChunkDef::Width * 3);
+		int SeedZ = (SeedIdx / (cChunkDef::Width * 3)) % (cChunkDef::Width * 3);
+
+		// Propagate seed:
+		if (SeedX < cChunkDef::Width * 3 - 1)
+		{
+			PropagateLight(a_Light, SeedIdx, SeedIdx + 1, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
+		}
+		if (SeedX > 0)
+		{
+			PropagateLight(a_Light, SeedIdx, SeedIdx - 1, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
+		}
+		if (SeedZ < cChunkDef::Width * 3 - 1)
+		{
+			PropagateLight(a_Light, SeedIdx, SeedIdx + cChunkDef::Width * 3, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
+		}
+		if (SeedZ > 0)
+		{
+			PropagateLight(a_Light, SeedIdx, SeedIdx - cChunkDef::Width * 3, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
+		}
+		if (SeedIdx < (cChunkDef::Height - 1) * BlocksPerYLayer)
+		{
+			PropagateLight(a_Light, SeedIdx, SeedIdx + BlocksPerYLayer, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
+		}
+		if (SeedIdx >= BlocksPerYLayer)
+		{
+			PropagateLight(a_Light, SeedIdx, SeedIdx - BlocksPerYLayer, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
+		}
+	}  // for i - a_SeedIdxIn[]
+	a_NumSeedsOut = NumSeedsOut;
+}
+
+
+
+
+void cLightCalculator::CompressLight(NIBBLETYPE * a_LightArray, NIBBLETYPE * a_ChunkLight)
+{
+	int InIdx = cChunkDef::Width * 49;  // Index to the first nibble of the middle chunk in the a_LightArray
+	int OutIdx = 0;
+	for (int y = 0; y < cChunkDef::Height; y++)
+	{
+		for (int z = 0; z < cChunkDef::Width; z++)
+		{
+			for (int x = 0; x < cChunkDef::Width; x += 2)
+			{
+				a_ChunkLight[OutIdx++] = static_cast<NIBBLETYPE>(a_LightArray[InIdx + 1] << 4) | a_LightArray[InIdx];
+				InIdx += 2;
+			}
+			InIdx += cChunkDef::Width * 2;
+		}
+		// Skip into the next y-level in the 3x3 chunk blob; each level has cChunkDef::Width * 9 rows
+		// We've already walked cChunkDef::Width * 3 in the "for z" cycle, that makes cChunkDef::Width * 6 rows left to skip
+		InIdx += cChunkDef::Width * cChunkDef::Width * 6;
+	}
+}
+
+
+
+
@@ -0,0 +1,140 @@
+
+// LightCalculator.h
+
+// Declares the cLightCalculator class that calculates the light of a whole chunk from the blocks of its 3x3 chunk neighborhood
+
+/*
+For the chunk to be lighted, the whole 3x3 chunk area around it is read, then it is processed, so that the middle
+chunk area has valid lighting, and the lighting is output as the middle chunk's nibble arrays.
+Lighting is calculated in full char arrays instead of nibbles, so that accessing the arrays is fast.
+Lighting is calculated in a flood-fill fashion:
+1. Generate seeds from where the light spreads (full skylight / light-emitting blocks)
+2. For each seed:
+	- Spread the light 1 block in each of the 6 cardinal directions, if the blocktype allows
+	- If the recipient block has had lower lighting value than that being spread, make it a new seed
+3. Repeat step 2, until there are no more seeds
+The seeds need two fast operations:
+	- Check if a block at [x, y, z] is already a seed
+	- Get the next seed in the row
+For that reason it is stored in two arrays, one stores a bool saying a seed is in that position,
+the other is an array of seed coords, encoded as a single int.
+Step 2 needs two separate storages for old seeds and new seeds, so there are two actual storages for that purpose,
+their content is swapped after each full step-2-cycle.
+
+The calculator doesn't access the world, the caller reads the chunks into it. The cLightingThread's workers read
+them from the ChunkMap, the tests from plain cChunkData.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkDef.h"
+#include "BlockInfo.h"
+
+
+
+
+
+class cChunkData;
+
+
+
+
+
+class cLightCalculator
+{
+public:
+
+	cLightCalculator(void);
+
+	/** Clears the chunks read so far, to be called before reading a new 3x3 chunk area. */
+	void Reset(void);
+
+	/** Reads the heightmap of a chunk in the 3x3 area; a_X and a_Z are the chunk's position in the area (0 .. 2).
+	The heightmap of a chunk needs to be read before its blocks. */
+	void ReadHeightMap(int a_X, int a_Z, const cChunkDef::HeightMap & a_HeightMap);
+
+	/** Reads the blocks of a chunk in the 3x3 area; a_X and a_Z are the chunk's position in the area (0 .. 2). */
+	void ReadBlockTypes(int a_X, int a_Z, const cChunkData & a_ChunkData);
+
+	/** Calculates the light of the middle chunk of the 3x3 area read. */
+	void CalcLight(cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight);
+
+protected:
+
+	/** The highest block in the current 3x3 chunk data */
+	HEIGHTTYPE m_MaxHeight;
+
+
+	// Buffers for the 3x3 chunk data
+	// These buffers alone are 1.7 MiB in size, therefore they cannot be located on the stack safely - some architectures may have only 1 MiB for stack, or even less
+	// The calculator is therefore always allocated on the heap
+	// The blobs are XZY organized as a whole, instead of 3x3 XZY-organized subarrays ->
+	//  -> This means data has to be scatterred when reading and gathered when writing!
+	static const int BlocksPerYLayer = cChunkDef::Width * cChunkDef::Width * 3 * 3;
+	BLOCKTYPE  m_BlockTypes[BlocksPerYLayer * cChunkDef::Height];
+	NIBBLETYPE m_BlockLight[BlocksPerYLayer * cChunkDef::Height];
+	NIBBLETYPE m_SkyLight  [BlocksPerYLayer * cChunkDef::Height];
+	HEIGHTTYPE m_HeightMap [BlocksPerYLayer];
+
+	// Seed management (5.7 MiB)
+	// Two buffers, in each calc step one is set as input and the other as output, then in the next step they're swapped
+	// Each seed is represented twice in this structure - both as a "list" and as a "position".
+	// "list" allows fast traversal from seed to seed
+	// "position" allows fast checking if a coord is already a seed
+	unsigned char m_IsSeed1 [BlocksPerYLayer * cChunkDef::Height];
+	unsigned int  m_SeedIdx1[BlocksPerYLayer * cChunkDef::Height];
+	unsigned char m_IsSeed2 [BlocksPerYLayer * cChunkDef::Height];
+	unsigned int  m_SeedIdx2[BlocksPerYLayer * cChunkDef::Height];
+	size_t m_NumSeeds;
+
+
+	/** Uses m_HeightMap to initialize the m_SkyLight[] data; fills in seeds for the skylight */
+	void PrepareSkyLight(void);
+
+	/** Uses m_BlockTypes to initialize the m_BlockLight[] data; fills in seeds for the blocklight */
+	void PrepareBlockLight(void);
+
+	/** Calculates light in the light array specified, using stored seeds */
+	void CalcLight(NIBBLETYPE * a_Light);
+
+	/** Does one step in the light calculation - one seed propagation and seed recalculation */
+	void CalcLightStep(
+		NIBBLETYPE * a_Light,
+		size_t a_NumSeedsIn,    unsigned char * a_IsSeedIn,  unsigned int * a_SeedIdxIn,
+		size_t & a_NumSeedsOut, unsigned char * a_IsSeedOut, unsigned int * a_SeedIdxOut
+	);
+
+	/** Compresses from 1-block-per-byte (faster calc) into 2-blocks-per-byte (MC storage): */
+	void CompressLight(NIBBLETYPE * a_LightArray, NIBBLETYPE * a_ChunkLight);
+
+	inline void PropagateLight(
+		NIBBLETYPE * a_Light,
+		unsigned int a_SrcIdx, unsigned int a_DstIdx,
+		size_t & a_NumSeedsOut, unsigned char * a_IsSeedOut, unsigned int * a_SeedIdxOut
+	)
+	{
+		ASSERT(a_SrcIdx < ARRAYCOUNT(m_SkyLight));
+		ASSERT(a_DstIdx < ARRAYCOUNT(m_BlockTypes));
+
+		if (a_Light[a_SrcIdx] <= a_Light[a_DstIdx] + cBlockInfo::GetSpreadLightFalloff(m_BlockTypes[a_DstIdx]))
+		{
+			// We're not offering more light than the dest block already has
+			return;
+		}
+
+		a_Light[a_DstIdx] = a_Light[a_SrcIdx] - cBlockInfo::GetSpreadLightFalloff(m_BlockTypes[a_DstIdx]);
+		if (!a_IsSeedOut[a_DstIdx])
+		{
+			a_IsSeedOut[a_DstIdx] = true;
+			a_SeedIdxOut[a_NumSeedsOut++] = a_DstIdx;
+		}
+	}
+} ;
+
+
+
+
@@ -0,0 +1,297 @@
+
+// LightUpdater.cpp
+
+// Implements the cLightUpdater class that updates the light around a single changed block, without relighting whole chunks
+
+#include "Globals.h"
+#include "LightUpdater.h"
+#include "BlockInfo.h"
+#include "ChunkData.h"
+
+
+
+
+
+/** The six direct neighbors of a block, through which the light spreads. */
+static const struct
+{
+	int x, y, z;
+} g_Neighbors[] =
+{
+	{ 1,  0,  0},
+	{-1,  0,  0},
+	{ 0,  1,  0},
+	{ 0, -1,  0},
+	{ 0,  0,  1},
+	{ 0,  0, -1},
+};
+
+
+
+
+
+cLightUpdater::cLightUpdater(cChunkData * a_Chunks[3][3])
+{
+	for (int x = 0; x < 3; x++)
+	{
+		for (int z = 0; z < 3; z++)
+		{
+			m_Chunks[x][z] = a_Chunks[x][z];
+			m_HasChanged[x][z] = false;
+		}  // for z
+	}  // for x
+}
+
+
+
+
+
+void cLightUpdater::BlockChanged(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_OldBlockType)
+{
+	ASSERT(m_Chunks[1][1] != nullptr);
+	BLOCKTYPE NewBlockType = m_Chunks[1][1]->GetBlock(a_RelX, a_RelY, a_RelZ);
+
+	// Blocklight depends only on the emitted light and the falloff:
+	if (
+		(cBlockInfo::GetLightValue        (a_OldBlockType) != cBlockInfo::GetLightValue        (NewBlockType)) ||
+		(cBlockInfo::GetSpreadLightFalloff(a_OldBlockType) != cBlockInfo::GetSpreadLightFalloff(NewBlockType))
+	)
+	{
+		UpdateLight(false, a_RelX, a_RelY, a_RelZ);
+	}
+
+	// Skylight depends on the falloff and on whether it can fall through the block:
+	if (
+		(cBlockInfo::GetSpreadLightFalloff(a_OldBlockType) != cBlockInfo::GetSpreadLightFalloff(NewBlockType)) ||
+		(cBlockInfo::IsTransparent        (a_OldBlockType) != cBlockInfo::IsTransparent        (NewBlockType)) ||
+		(cBlockInfo::IsSkylightDispersant (a_OldBlockType) != cBlockInfo::IsSkylightDispersant (NewBlockType))
+	)
+	{
+		UpdateLight(true, a_RelX, a_RelY, a_RelZ);
+	}
+}
+
+
+
+
+
+void cLightUpdater::UpdateLight(bool a_IsSkyLight, int a_RelX, int a_RelY, int a_RelZ)
+{
+	BLOCKTYPE BlockType;
+	NIBBLETYPE OldLight;
+	if (!GetBlockLight(a_IsSkyLight, a_RelX, a_RelY, a_RelZ, BlockType, OldLight))
+	{
+		return;
+	}
+	m_RemovalQueue.clear();
+	m_AdditionQueue.clear();
+
+	// Remove all the light that may have come through the changed block:
+	if (OldLight > 0)
+	{
+		SetLight(a_IsSkyLight, a_RelX, a_RelY, a_RelZ, 0);
+		m_RemovalQueue.emplace_back(a_RelX, a_RelY, a_RelZ, OldLight);
+		ProcessRemovalQueue(a_IsSkyLight);
+	}
+
+	// Seed the changed block's own light:
+	NIBBLETYPE OwnLight = GetOwnLight(a_IsSkyLight, a_RelY, BlockType);
+	if (OwnLight > 0)
+	{
+		SetLight(a_IsSkyLight, a_RelX, a_RelY, a_RelZ, OwnLight);
+		m_AdditionQueue.emplace_back(a_RelX, a_RelY, a_RelZ, 0);
+	}
+
+	// Let the neighbors' light spread into the changed block:
+	for (const auto & Neighbor : g_Neighbors)
+	{
+		m_AdditionQueue.emplace_back(a_RelX + Neighbor.x, a_RelY + Neighbor.y, a_RelZ + Neighbor.z, 0);
+	}
+
+	ProcessAdditionQueue(a_IsSkyLight);
+}
+
+
+
+
+
+void cLightUpdater::ProcessRemovalQueue(bool a_IsSkyLight)
+{
+	// Note that the queue grows while being processed, hence the indices and the item copies:
+	for (size_t i = 0; i < m_RemovalQueue.size(); i++)
+	{
+		sQueueItem Item = m_RemovalQueue[i];
+		for (const auto & Neighbor : g_Neighbors)
+		{
+			int RelX = Item.m_RelX + Neighbor.x;
+			int RelY = Item.m_RelY + Neighbor.y;
+			int RelZ = Item.m_RelZ + Neighbor.z;
+			BLOCKTYPE BlockType;
+			NIBBLETYPE Light;
+			if (!GetBlockLight(a_IsSkyLight, RelX, RelY, RelZ, BlockType, Light) || (Light == 0))
+			{
+				continue;
+			}
+
+			// Full sunlight falls down without any falloff, so it needs removing even though it isn't darker:
+			bool IsSunlightColumn = (a_IsSkyLight && (Neighbor.y < 0) && (Item.m_Light == 15));
+			if ((Light >= Item.m_Light) && !IsSunlightColumn)
+			{
+				// This light comes from elsewhere, spread it back into the darkened area:
+				m_AdditionQueue.emplace_back(RelX, RelY, RelZ, 0);
+				continue;
+			}
+
+			// This light may have come from the removed light, remove it as well:
+			SetLight(a_IsSkyLight, RelX, RelY, RelZ, 0);
+			m_RemovalQueue.emplace_back(RelX, RelY, RelZ, Light);
+
+			// Light sources keep their own light:
+			NIBBLETYPE OwnLight = GetOwnLight(a_IsSkyLight, RelY, BlockType);
+			if (OwnLight > 0)
+			{
+				SetLight(a_IsSkyLight, RelX, RelY, RelZ, OwnLight);
+				m_AdditionQueue.emplace_back(RelX, RelY, RelZ, 0);
+			}
+		}  // for Neighbor - g_Neighbors[]
+	}  // for i - m_RemovalQueue[]
+	m_RemovalQueue.clear();
+}
+
+
+
+
+
+void cLightUpdater::ProcessAdditionQueue(bool a_IsSkyLight)
+{
+	// Note that the queue grows while being processed, hence the indices and the item copies:
+	for (size_t i = 0; i < m_AdditionQueue.size(); i++)
+	{
+		sQueueItem Item = m_AdditionQueue[i];
+		BLOCKTYPE SrcBlockType;
+		NIBBLETYPE SrcLight;
+		if (!GetBlockLight(a_IsSkyLight, Item.m_RelX, Item.m_RelY, Item.m_RelZ, SrcBlockType, SrcLight) || (SrcLight == 0))
+		{
+			continue;
+		}
+
+		for (const auto & Neighbor : g_Neighbors)
+		{
+			int RelX = Item.m_RelX + Neighbor.x;
+			int RelY = Item.m_RelY + Neighbor.y;
+			int RelZ = Item.m_RelZ + Neighbor.z;
+			BLOCKTYPE BlockType;
+			NIBBLETYPE Light;
+			if (!GetBlockLight(a_IsSkyLight, RelX, RelY, RelZ, BlockType, Light))
+			{
+				continue;
+			}
+			NIBBLETYPE NewLight = GetPropagatedLight(a_IsSkyLight, SrcLight, BlockType, (Neighbor.y < 0));
+			if (NewLight > Light)
+			{
+				SetLight(a_IsSkyLight, RelX, RelY, RelZ, NewLight);
+				m_AdditionQueue.emplace_back(RelX, RelY, RelZ, 0);
+			}
+		}  // for Neighbor - g_Neighbors[]
+	}  // for i - m_AdditionQueue[]
+	m_AdditionQueue.clear();
+}
+
+
+
+
+
+cChunkData * cLightUpdater::GetChunk(int & a_RelX, int a_RelY, int & a_RelZ) const
+{
+	if (
+		!cChunkDef::IsValidHeight(a_RelY) ||
+		(a_RelX < -cChunkDef::Width) || (a_RelX >= 2 * cChunkDef::Width) ||
+		(a_RelZ < -cChunkDef::Width) || (a_RelZ >= 2 * cChunkDef::Width)
+	)
+	{
+		return nullptr;
+	}
+	int IdxX = (a_RelX + cChunkDef::Width) / cChunkDef::Width;
+	int IdxZ = (a_RelZ + cChunkDef::Width) / cChunkDef::Width;
+	a_RelX -= (IdxX - 1) * cChunkDef::Width;
+	a_RelZ -= (IdxZ - 1) * cChunkDef::Width;
+	return m_Chunks[IdxX][IdxZ];
+}
+
+
+
+
+
+bool cLightUpdater::GetBlockLight(bool a_IsSkyLight, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Light) const
+{
+	cChunkData * Chunk = GetChunk(a_RelX, a_RelY, a_RelZ);
+	if (Chunk == nullptr)
+	{
+		return false;
+	}
+	a_BlockType = Chunk->GetBlock(a_RelX, a_RelY, a_RelZ);
+	a_Light = a_IsSkyLight ? Chunk->GetSkyLight(a_RelX, a_RelY, a_RelZ) : Chunk->GetBlockLight(a_RelX, a_RelY, a_RelZ);
+	return true;
+}
+
+
+
+
+
+void cLightUpdater::SetLight(bool a_IsSkyLight, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light)
+{
+	int IdxX = (a_RelX + cChunkDef::Width) / cChunkDef::Width;
+	int IdxZ = (a_RelZ + cChunkDef::Width) / cChunkDef::Width;
+	cChunkData * Chunk = GetChunk(a_RelX, a_RelY, a_RelZ);
+	ASSERT(Chunk != nullptr);
+	bool HasChanged = a_IsSkyLight ?
+		Chunk->SetSkyLight(a_RelX, a_RelY, a_RelZ, a_Light) :
+		Chunk->SetBlockLight(a_RelX, a_RelY, a_RelZ, a_Light);
+	if (HasChanged)
+	{
+		m_HasChanged[IdxX][IdxZ] = true;
+	}
+}
+
+
+
+
+
+NIBBLETYPE cLightUpdater::GetPropagatedLight(bool a_IsSkyLight, NIBBLETYPE a_SrcLight, BLOCKTYPE a_DstBlockType, bool a_IsDown)
+{
+	// Full sunlight goes down unchanged through transparent blocks, same as in cLightingThread::PrepareSkyLight():
+	if (
+		a_IsSkyLight && a_IsDown && (a_SrcLight == 15) &&
+		cBlockInfo::IsTransparent(a_DstBlockType) &&
+		!cBlockInfo::IsSkylightDispersant(a_DstBlockType)
+	)
+	{
+		return 15;
+	}
+
+	NIBBLETYPE Falloff = cBlockInfo::GetSpreadLightFalloff(a_DstBlockType);
+	return (a_SrcLight > Falloff) ? static_cast<NIBBLETYPE>(a_SrcLight - Falloff) : 0;
+}
+
+
+
+
+
+NIBBLETYPE cLightUpdater::GetOwnLight(bool a_IsSkyLight, int a_RelY, BLOCKTYPE a_BlockType)
+{
+	if (!a_IsSkyLight)
+	{
+		return cBlockInfo::GetLightValue(a_BlockType);
+	}
+
+	// The topmost layer receives full sunlight from above the world:
+	if (a_RelY == cChunkDef::Height - 1)
+	{
+		return GetPropagatedLight(true, 15, a_BlockType, true);
+	}
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,122 @@
+
+// LightUpdater.h
+
+// Declares the cLightUpdater class that updates the light around a single changed block, without relighting whole chunks
+
+/*
+The cLightingThread always calculates the light of a whole chunk from scratch, reading the 3x3 chunk neighborhood.
+That is wasteful for a single block change (torch placed, block broken), so cChunk uses this class instead when
+its light is already valid.
+
+The update works on each light type separately, in two flood-fill passes:
+	- removal: starting at the changed block, all the light that may have come from there is zeroed out. Any light
+	found on the way that is too bright to have come from the changed block is remembered as a re-light seed.
+	- addition: light is spread from the seeds (and the changed block itself, if it emits light) using the same
+	falloff rules as cLightingThread, so the result matches a full relight.
+Light can travel at most 15 blocks, so only the 3x3 chunks around the changed block's chunk are ever touched.
+Neighbors that aren't loaded, or whose light isn't valid yet, are left alone; they will be fully lit later anyway.
+
+The updater works on the chunks' cChunkData only; the caller (cChunk) gives it the 3x3 chunks and then marks
+the chunks whose light has changed as dirty.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkDef.h"
+
+
+
+
+
+class cChunkData;
+
+
+
+
+
+class cLightUpdater
+{
+public:
+
+	/** Creates an updater over the data of the 3x3 chunks, indexed [x][z], the changed block's chunk at [1][1].
+	The chunks that aren't available or aren't lit yet are nullptr. The data must stay locked for the whole lifetime of the object. */
+	cLightUpdater(cChunkData * a_Chunks[3][3]);
+
+	/** Updates the blocklight and the skylight after the block at the specified coords (relative to the center chunk)
+	has been changed from a_OldBlockType to its current type. */
+	void BlockChanged(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_OldBlockType);
+
+	/** Returns true if the light of the chunk at [a_X][a_Z] of the 3x3 chunks has changed. */
+	bool HasChanged(int a_X, int a_Z) const { return m_HasChanged[a_X][a_Z]; }
+
+protected:
+
+	/** A single position in the flood-fill queues, relative to the center chunk. */
+	struct sQueueItem
+	{
+		int m_RelX, m_RelY, m_RelZ;
+
+		/** The light value the block had when it was queued for removal. Unused in the addition queue. */
+		NIBBLETYPE m_Light;
+
+		sQueueItem(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light):
+			m_RelX(a_RelX),
+			m_RelY(a_RelY),
+			m_RelZ(a_RelZ),
+			m_Light(a_Light)
+		{
+		}
+	};
+
+	typedef std::vector<sQueueItem> sQueueItems;
+
+
+	/** The data of the chunks in the 3x3 neighborhood, indexed [x][z]; the center chunk is at [1][1].
+	nullptr for chunks that aren't available or aren't lit yet. */
+	cChunkData * m_Chunks[3][3];
+
+	/** Whether the light of each of the chunks in m_Chunks has changed. */
+	bool m_HasChanged[3][3];
+
+	/** Queue of blocks whose light is being removed. */
+	sQueueItems m_RemovalQueue;
+
+	/** Queue of blocks whose light is to be spread to their neighbors. */
+	sQueueItems m_AdditionQueue;
+
+
+	/** Updates a single light type (skylight if a_IsSkyLight is true, blocklight otherwise) around the changed block. */
+	void UpdateLight(bool a_IsSkyLight, int a_RelX, int a_RelY, int a_RelZ);
+
+	/** Processes m_RemovalQueue, zeroing the light that could have come from the removed light, and seeding m_AdditionQueue with the light that couldn't. */
+	void ProcessRemovalQueue(bool a_IsSkyLight);
+
+	/** Processes m_AdditionQueue, spreading the light to the neighbors. */
+	void ProcessAdditionQueue(bool a_IsSkyLight);
+
+	/** Returns the chunk in m_Chunks containing the specified block and adjusts the coords to be relative to that chunk.
+	Returns nullptr if the coords are outside the neighborhood or the chunk isn't available. */
+	cChunkData * GetChunk(int & a_RelX, int a_RelY, int & a_RelZ) const;
+
+	/** Retrieves the blocktype and light at the specified coords. Returns false if the block is not available. */
+	bool GetBlockLight(bool a_IsSkyLight, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Light) const;
+
+	/** Sets the light at the specified coords, which must be available, and remembers the chunk if the light has changed. */
+	void SetLight(bool a_IsSkyLight, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Light);
+
+	/** Returns the light that a block of type a_DstBlockType receives from its neighbor with light a_SrcLight.
+	a_IsDown is true if the light is travelling straight down, where skylight passes unchanged through transparent blocks. */
+	static NIBBLETYPE GetPropagatedLight(bool a_IsSkyLight, NIBBLETYPE a_SrcLight, BLOCKTYPE a_DstBlockType, bool a_IsDown);
+
+	/** Returns the light the block has regardless of its neighbors:
+	the emitted light for blocklight, the sunlight falling onto the topmost layer for skylight. */
+	static NIBBLETYPE GetOwnLight(bool a_IsSkyLight, int a_RelY, BLOCKTYPE a_BlockType);
+} ;
+
+
+
+
@@ -13,70 +13,30 @@
 
 
 
-/** Chunk data callback that takes the chunk data and puts them into cLightingThread's m_BlockTypes[] / m_HeightMap[]: */
+/** Chunk data callback that reads the chunk data into the cLightCalculator's 3x3 chunk area: */
 class cReader :
 	public cChunkDataCallback
 {
-	virtual void ChunkData(const cChunkData & a_ChunkBuffer) override
+	virtual void HeightMap(const cChunkDef::HeightMap * a_Heightmap) override
 	{
-		BLOCKTYPE * OutputRows = m_BlockTypes;
-		int InputIdx = 0;
-		int OutputIdx = m_ReadingChunkX + m_ReadingChunkZ * cChunkDef::Width * 3;
-		int MaxHeight = std::min(+cChunkDef::Height, m_MaxHeight + 16);  // Need 16 blocks above the highest
-		for (int y = 0; y < MaxHeight; y++)
-		{
-			for (int z = 0; z < cChunkDef::Width; z++)
-			{
-				a_ChunkBuffer.CopyBlockTypes(OutputRows + OutputIdx * 16, static_cast<size_t>(InputIdx * 16), 16);
-				InputIdx++;
-				OutputIdx += 3;
-			}  // for z
-			// Skip into the next y-level in the 3x3 chunk blob; each level has cChunkDef::Width * 9 rows
-			// We've already walked cChunkDef::Width * 3 in the "for z" cycle, that makes cChunkDef::Width * 6 rows left to skip
-			OutputIdx += cChunkDef::Width * 6;
-		}  // for y
-	}  // BlockTypes()
+		m_Calculator.ReadHeightMap(m_ReadingChunkX, m_ReadingChunkZ, *a_Heightmap);
+	}
 
 
-	virtual void HeightMap(const cChunkDef::HeightMap * a_Heightmap) override
+	virtual void ChunkData(const cChunkData & a_ChunkBuffer) override
 	{
-		// Copy the entire heightmap, distribute it into the 3x3 chunk blob:
-		typedef struct {HEIGHTTYPE m_Row[16]; } ROW;
-		const ROW * InputRows  = reinterpret_cast<const ROW *>(a_Heightmap);
-		ROW * OutputRows = reinterpret_cast<ROW *>(m_HeightMap);
-		int InputIdx = 0;
-		int OutputIdx = m_ReadingChunkX + m_ReadingChunkZ * cChunkDef::Width * 3;
-		for (int z = 0; z < cChunkDef::Width; z++)
-		{
-			OutputRows[OutputIdx] = InputRows[InputIdx++];
-			OutputIdx += 3;
-		}  // for z
-
-		// Find the highest block in the entire chunk, use it as a base for m_MaxHeight:
-		HEIGHTTYPE MaxHeight = m_MaxHeight;
-		for (size_t i = 0; i < ARRAYCOUNT(*a_Heightmap); i++)
-		{
-			if ((*a_Heightmap)[i] > MaxHeight)
-			{
-				MaxHeight = (*a_Heightmap)[i];
-			}
-		}
-		m_MaxHeight = MaxHeight;
+		m_Calculator.ReadBlockTypes(m_ReadingChunkX, m_ReadingChunkZ, a_ChunkBuffer);
 	}
 
 public:
 	int m_ReadingChunkX;  // 0, 1 or 2; x-offset of the chunk we're reading from the BlockTypes start
 	int m_ReadingChunkZ;  // 0, 1 or 2; z-offset of the chunk we're reading from the BlockTypes start
-	HEIGHTTYPE m_MaxHeight;  // Maximum value in this chunk's heightmap
-	BLOCKTYPE * m_BlockTypes;  // 3x3 chunks of block types, organized as a single XZY blob of data (instead of 3x3 XZY blobs)
-	HEIGHTTYPE * m_HeightMap;  // 3x3 chunks of height map,  organized as a single XZY blob of data (instead of 3x3 XZY blobs)
+	cLightCalculator & m_Calculator;
 
-	cReader(BLOCKTYPE * a_BlockTypes, HEIGHTTYPE * a_HeightMap) :
+	cReader(cLightCalculator & a_Calculator) :
 		m_ReadingChunkX(0),
 		m_ReadingChunkZ(0),
-		m_MaxHeight(0),
-		m_BlockTypes(a_BlockTypes),
-		m_HeightMap(a_HeightMap)
+		m_Calculator(a_Calculator)
 	{
 	}
 } ;
@@ -89,10 +49,8 @@ public:
 // cLightingThread:
 
 cLightingThread::cLightingThread(cWorld & a_World):
-	super("cLightingThread"),
 	m_World(a_World),
-	m_MaxHeight(0),
-	m_NumSeeds(0)
+	m_ShouldTerminate(false)
 {
 }
 
@@ -109,6 +67,21 @@ cLightingThread::~cLightingThread()
 
 
 
+void cLightingThread::Start(int a_NumWorkers)
+{
+	ASSERT(m_Workers.empty());
+	m_ShouldTerminate = false;
+	for (int i = std::max(a_NumWorkers, 1); i > 0; i--)
+	{
+		m_Workers.push_back(cpp14::make_unique<cWorker>(*this));
+		m_Workers.back()->Start();
+	}
+}
+
+
+
+
+
 void cLightingThread::Stop(void)
 {
 	{
@@ -127,9 +100,13 @@ void cLightingThread::Stop(void)
 		m_Queue.clear();
 	}
 	m_ShouldTerminate = true;
-	m_evtItemAdded.Set();
+	m_evtItemAdded.Set();  // Each terminating worker passes the event on to the next one
 
-	Wait();
+	for (auto & Worker : m_Workers)
+	{
+		Worker->Wait();
+	}
+	m_Workers.clear();
 }
 
 
@@ -176,140 +153,57 @@ size_t cLightingThread::GetQueueLength(void)
 
 
 
-void cLightingThread::Execute(void)
+std::vector<cLightingThread::sWorkerStats> cLightingThread::GetWorkerStats(void)
 {
-	for (;;)
+	std::vector<sWorkerStats> Res;
+	for (const auto & Worker : m_Workers)
 	{
-		{
-			cCSLock Lock(m_CS);
-			if (m_Queue.empty())
-			{
-				cCSUnlock Unlock(Lock);
-				m_evtItemAdded.Wait();
-			}
-		}
-
-		if (m_ShouldTerminate)
-		{
-			return;
-		}
-
-		// Process one items from the queue:
-		cLightingChunkStay * Item;
-		{
-			cCSLock Lock(m_CS);
-			if (m_Queue.empty())
-			{
-				continue;
-			}
-			Item = static_cast<cLightingChunkStay *>(m_Queue.front());
-			m_Queue.pop_front();
-			if (m_Queue.empty())
-			{
-				m_evtQueueEmpty.Set();
-			}
-		}  // CSLock(m_CS)
-
-		LightChunk(*Item);
-		Item->Disable();
-		delete Item;
+		Res.push_back(Worker->GetStats());
 	}
+	return Res;
 }
 
 
 
 
 
-
-void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
+cLightingThread::cLightingChunkStay * cLightingThread::DequeueChunkStay(void)
 {
-	// If the chunk is already lit, skip it (report as success):
-	if (m_World.IsChunkLighted(a_Item.m_ChunkX, a_Item.m_ChunkZ))
+	cCSLock Lock(m_CS);
+	for (;;)
 	{
-		if (a_Item.m_CallbackAfter != nullptr)
+		if (m_ShouldTerminate)
 		{
-			a_Item.m_CallbackAfter->Call(a_Item.m_ChunkX, a_Item.m_ChunkZ, true);
+			// Wake up the next worker so that it terminates, too:
+			m_evtItemAdded.Set();
+			return nullptr;
 		}
-		return;
-	}
-
-	cChunkDef::BlockNibbles BlockLight, SkyLight;
-
-	ReadChunks(a_Item.m_ChunkX, a_Item.m_ChunkZ);
-
-	PrepareBlockLight();
-	CalcLight(m_BlockLight);
 
-	PrepareSkyLight();
-
-	/*
-	// DEBUG: Save chunk data with highlighted seeds for visual inspection:
-	cFile f4;
-	if (
-		f4.Open(Printf("Chunk_%d_%d_seeds.grab", a_Item.m_ChunkX, a_Item.m_ChunkZ), cFile::fmWrite)
-	)
-	{
-		for (int z = 0; z < cChunkDef::Width * 3; z++)
+		// Pick the first chunk that isn't being lit by another worker already:
+		for (auto itr = m_Queue.begin(), end = m_Queue.end(); itr != end; ++itr)
 		{
-			for (int y = cChunkDef::Height / 2; y >= 0; y--)
+			auto Item = static_cast<cLightingChunkStay *>(*itr);
+			cChunkCoords Coords(Item->m_ChunkX, Item->m_ChunkZ);
+			if (std::find(m_ChunksBeingLit.begin(), m_ChunksBeingLit.end(), Coords) != m_ChunksBeingLit.end())
 			{
-				unsigned char Seeds     [cChunkDef::Width * 3];
-				memcpy(Seeds, m_BlockTypes + y * BlocksPerYLayer + z * cChunkDef::Width * 3, cChunkDef::Width * 3);
-				for (int x = 0; x < cChunkDef::Width * 3; x++)
-				{
-					if (m_IsSeed1[y * BlocksPerYLayer + z * cChunkDef::Width * 3 + x])
-					{
-						Seeds[x] = E_BLOCK_DIAMOND_BLOCK;
-					}
-				}
-				f4.Write(Seeds, cChunkDef::Width * 3);
+				continue;
 			}
-		}
-		f4.Close();
-	}
-	//*/
-
-	CalcLight(m_SkyLight);
-
-	/*
-	// DEBUG: Save XY slices of the chunk data and lighting for visual inspection:
-	cFile f1, f2, f3;
-	if (
-		f1.Open(Printf("Chunk_%d_%d_data.grab",  a_Item.m_ChunkX, a_Item.m_ChunkZ), cFile::fmWrite) &&
-		f2.Open(Printf("Chunk_%d_%d_sky.grab",   a_Item.m_ChunkX, a_Item.m_ChunkZ), cFile::fmWrite) &&
-		f3.Open(Printf("Chunk_%d_%d_glow.grab",  a_Item.m_ChunkX, a_Item.m_ChunkZ), cFile::fmWrite)
-	)
-	{
-		for (int z = 0; z < cChunkDef::Width * 3; z++)
-		{
-			for (int y = cChunkDef::Height / 2; y >= 0; y--)
+			m_Queue.erase(itr);
+			m_ChunksBeingLit.push_back(Coords);
+			if (m_Queue.empty())
+			{
+				m_evtQueueEmpty.Set();
+			}
+			else
 			{
-				f1.Write(m_BlockTypes + y * BlocksPerYLayer + z * cChunkDef::Width * 3, cChunkDef::Width * 3);
-				unsigned char SkyLight  [cChunkDef::Width * 3];
-				unsigned char BlockLight[cChunkDef::Width * 3];
-				for (int x = 0; x < cChunkDef::Width * 3; x++)
-				{
-					SkyLight[x]   = m_SkyLight  [y * BlocksPerYLayer + z * cChunkDef::Width * 3 + x] << 4;
-					BlockLight[x] = m_BlockLight[y * BlocksPerYLayer + z * cChunkDef::Width * 3 + x] << 4;
-				}
-				f2.Write(SkyLight,   cChunkDef::Width * 3);
-				f3.Write(BlockLight, cChunkDef::Width * 3);
+				// There's more work, wake up another worker:
+				m_evtItemAdded.Set();
 			}
+			return Item;
 		}
-		f1.Close();
-		f2.Close();
-		f3.Close();
-	}
-	//*/
-
-	CompressLight(m_BlockLight, BlockLight);
-	CompressLight(m_SkyLight, SkyLight);
-
-	m_World.ChunkLighted(a_Item.m_ChunkX, a_Item.m_ChunkZ, BlockLight, SkyLight);
 
-	if (a_Item.m_CallbackAfter != nullptr)
-	{
-		a_Item.m_CallbackAfter->Call(a_Item.m_ChunkX, a_Item.m_ChunkZ, true);
+		cCSUnlock Unlock(Lock);
+		m_evtItemAdded.Wait();
 	}
 }
 
@@ -317,142 +211,88 @@ void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
 
 
 
-void cLightingThread::ReadChunks(int a_ChunkX, int a_ChunkZ)
+void cLightingThread::ChunkStayDone(cLightingChunkStay & a_ChunkStay)
 {
-	cReader Reader(m_BlockTypes, m_HeightMap);
-
-	for (int z = 0; z < 3; z++)
 	{
-		Reader.m_ReadingChunkZ = z;
-		for (int x = 0; x < 3; x++)
+		cCSLock Lock(m_CS);
+		auto itr = std::find(m_ChunksBeingLit.begin(), m_ChunksBeingLit.end(), cChunkCoords(a_ChunkStay.m_ChunkX, a_ChunkStay.m_ChunkZ));
+		ASSERT(itr != m_ChunksBeingLit.end());
+		m_ChunksBeingLit.erase(itr);
+		if (m_Queue.empty())
 		{
-			Reader.m_ReadingChunkX = x;
-			VERIFY(m_World.GetChunkData(a_ChunkX + x - 1, a_ChunkZ + z - 1, Reader));
-		}  // for z
-	}  // for x
+			return;
+		}
+	}
 
-	memset(m_BlockLight, 0, sizeof(m_BlockLight));
-	memset(m_SkyLight,   0, sizeof(m_SkyLight));
-	m_MaxHeight = Reader.m_MaxHeight;
+	// A queued duplicate of this chunk may have been skipped by the workers, wake them up again:
+	m_evtItemAdded.Set();
 }
 
 
 
 
 
-void cLightingThread::PrepareSkyLight(void)
+void cLightingThread::QueueChunkStay(cLightingChunkStay & a_ChunkStay)
 {
-	// Clear seeds:
-	memset(m_IsSeed1, 0, sizeof(m_IsSeed1));
-	m_NumSeeds = 0;
-
-	// Fill the top of the chunk with all-light:
-	if (m_MaxHeight < cChunkDef::Height - 1)
+	// Move the ChunkStay from the Pending queue to the lighting queue.
 	{
-		std::fill(m_SkyLight + (m_MaxHeight + 1) * BlocksPerYLayer, m_SkyLight + ARRAYCOUNT(m_SkyLight), 15);
+		cCSLock Lock(m_CS);
+		m_PendingQueue.remove(&a_ChunkStay);
+		m_Queue.push_back(&a_ChunkStay);
 	}
+	m_evtItemAdded.Set();
+}
 
-	// Walk every column that has all XZ neighbors
-	for (int z = 1; z < cChunkDef::Width * 3 - 1; z++)
-	{
-		int BaseZ = z * cChunkDef::Width * 3;
-		for (int x = 1; x < cChunkDef::Width * 3 - 1; x++)
-		{
-			int idx = BaseZ + x;
-			// Find the lowest block in this column that receives full sunlight (go through transparent blocks):
-			int Current = m_HeightMap[idx];
-			ASSERT(Current < cChunkDef::Height);
-			while (
-				(Current >= 0) &&
-				cBlockInfo::IsTransparent(m_BlockTypes[idx + Current * BlocksPerYLayer]) &&
-				!cBlockInfo::IsSkylightDispersant(m_BlockTypes[idx + Current * BlocksPerYLayer])
-			)
-			{
-				Current -= 1;  // Sunlight goes down unchanged through this block
-			}
-			Current += 1;  // Point to the last sunlit block, rather than the first non-transparent one
-			// The other neighbors don't need transparent-block-checking. At worst we'll have a few dud seeds above the ground.
-			int Neighbor1 = m_HeightMap[idx + 1] + 1;  // X + 1
-			int Neighbor2 = m_HeightMap[idx - 1] + 1;  // X - 1
-			int Neighbor3 = m_HeightMap[idx + cChunkDef::Width * 3] + 1;  // Z + 1
-			int Neighbor4 = m_HeightMap[idx - cChunkDef::Width * 3] + 1;  // Z - 1
-			int MaxNeighbor = std::max(std::max(Neighbor1, Neighbor2), std::max(Neighbor3, Neighbor4));  // Maximum of the four neighbors
-
-			// Fill the column from m_MaxHeight to Current with all-light:
-			for (int y = m_MaxHeight, Index = idx + y * BlocksPerYLayer; y >= Current; y--, Index -= BlocksPerYLayer)
-			{
-				m_SkyLight[Index] = 15;
-			}
 
-			// Add Current as a seed:
-			if (Current < cChunkDef::Height)
-			{
-				int CurrentIdx = idx + Current * BlocksPerYLayer;
-				m_IsSeed1[CurrentIdx] = true;
-				m_SeedIdx1[m_NumSeeds++] = static_cast<UInt32>(CurrentIdx);
-			}
 
-			// Add seed from Current up to the highest neighbor:
-			for (int y = Current + 1, Index = idx + y * BlocksPerYLayer; y < MaxNeighbor; y++, Index += BlocksPerYLayer)
-			{
-				m_IsSeed1[Index] = true;
-				m_SeedIdx1[m_NumSeeds++] = static_cast<UInt32>(Index);
-			}
-		}
-	}
-}
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cLightingThread::cWorker:
 
+cLightingThread::cWorker::cWorker(cLightingThread & a_Parent):
+	super("cLightingThread"),
+	m_Parent(a_Parent),
+	m_NumChunksLit(0),
+	m_LightingTimeUSec(0)
+{
+}
 
 
-void cLightingThread::PrepareBlockLight()
-{
-	// Clear seeds:
-	memset(m_IsSeed1, 0, sizeof(m_IsSeed1));
-	memset(m_IsSeed2, 0, sizeof(m_IsSeed2));
-	m_NumSeeds = 0;
 
-	// Add each emissive block into the seeds:
-	for (int Idx = 0; Idx < (m_MaxHeight * BlocksPerYLayer); ++Idx)
-	{
-		if (cBlockInfo::GetLightValue(m_BlockTypes[Idx]) == 0)
-		{
-			// Not a light-emissive block
-			continue;
-		}
 
-		// Add current block as a seed:
-		m_IsSeed1[Idx] = true;
-		m_SeedIdx1[m_NumSeeds++] = static_cast<UInt32>(Idx);
 
-		// Light it up:
-		m_BlockLight[Idx] = cBlockInfo::GetLightValue(m_BlockTypes[Idx]);
-	}
+cLightingThread::sWorkerStats cLightingThread::cWorker::GetStats(void) const
+{
+	sWorkerStats Res;
+	Res.m_NumChunksLit = m_NumChunksLit;
+	Int64 TimeUSec = m_LightingTimeUSec;
+	Res.m_ChunksPerSec = (TimeUSec > 0) ? (static_cast<double>(Res.m_NumChunksLit) * 1000000.0 / static_cast<double>(TimeUSec)) : 0.0;
+	return Res;
 }
 
 
 
 
 
-void cLightingThread::CalcLight(NIBBLETYPE * a_Light)
+void cLightingThread::cWorker::Execute(void)
 {
-	size_t NumSeeds2 = 0;
-	while (m_NumSeeds > 0)
+	for (;;)
 	{
-		// Buffer 1 -> buffer 2
-		memset(m_IsSeed2, 0, sizeof(m_IsSeed2));
-		NumSeeds2 = 0;
-		CalcLightStep(a_Light, m_NumSeeds, m_IsSeed1, m_SeedIdx1, NumSeeds2, m_IsSeed2, m_SeedIdx2);
-		if (NumSeeds2 == 0)
+		auto Item = m_Parent.DequeueChunkStay();
+		if (Item == nullptr)
 		{
 			return;
 		}
 
-		// Buffer 2 -> buffer 1
-		memset(m_IsSeed1, 0, sizeof(m_IsSeed1));
-		m_NumSeeds = 0;
-		CalcLightStep(a_Light, NumSeeds2, m_IsSeed2, m_SeedIdx2, m_NumSeeds, m_IsSeed1, m_SeedIdx1);
+		auto StartTime = std::chrono::steady_clock::now();
+		LightChunk(*Item);
+		m_LightingTimeUSec += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - StartTime).count();
+		m_NumChunksLit += 1;
+
+		m_Parent.ChunkStayDone(*Item);
+		Item->Disable();
+		delete Item;
 	}
 }
 
@@ -460,71 +300,28 @@ void cLightingThread::CalcLight(NIBBLETYPE * a_Light)
 
 
 
-void cLightingThread::CalcLightStep(
-	NIBBLETYPE * a_Light,
-	size_t a_NumSeedsIn,    unsigned char * a_IsSeedIn,  unsigned int * a_SeedIdxIn,
-	size_t & a_NumSeedsOut, unsigned char * a_IsSeedOut, unsigned int * a_SeedIdxOut
-)
+
+void cLightingThread::cWorker::LightChunk(cLightingChunkStay & a_Item)
 {
-	UNUSED(a_IsSeedIn);
-	size_t NumSeedsOut = 0;
-	for (size_t i = 0; i < a_NumSeedsIn; i++)
+	// If the chunk is already lit, skip it (report as success):
+	if (m_Parent.m_World.IsChunkLighted(a_Item.m_ChunkX, a_Item.m_ChunkZ))
 	{
-		UInt32 SeedIdx = static_cast<UInt32>(a_SeedIdxIn[i]);
-		int SeedX = SeedIdx % (cChunkDef::Width * 3);
-		int SeedZ = (SeedIdx / (cChunkDef::Width * 3)) % (cChunkDef::Width * 3);
-
-		// Propagate seed:
-		if (SeedX < cChunkDef::Width * 3 - 1)
-		{
-			PropagateLight(a_Light, SeedIdx, SeedIdx + 1, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
-		}
-		if (SeedX > 0)
-		{
-			PropagateLight(a_Light, SeedIdx, SeedIdx - 1, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
-		}
-		if (SeedZ < cChunkDef::Width * 3 - 1)
-		{
-			PropagateLight(a_Light, SeedIdx, SeedIdx + cChunkDef::Width * 3, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
-		}
-		if (SeedZ > 0)
-		{
-			PropagateLight(a_Light, SeedIdx, SeedIdx - cChunkDef::Width * 3, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
-		}
-		if (SeedIdx < (cChunkDef::Height - 1) * BlocksPerYLayer)
-		{
-			PropagateLight(a_Light, SeedIdx, SeedIdx + BlocksPerYLayer, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
-		}
-		if (SeedIdx >= BlocksPerYLayer)
+		if (a_Item.m_CallbackAfter != nullptr)
 		{
-			PropagateLight(a_Light, SeedIdx, SeedIdx - BlocksPerYLayer, NumSeedsOut, a_IsSeedOut, a_SeedIdxOut);
+			a_Item.m_CallbackAfter->Call(a_Item.m_ChunkX, a_Item.m_ChunkZ, true);
 		}
-	}  // for i - a_SeedIdxIn[]
-	a_NumSeedsOut = NumSeedsOut;
-}
-
-
+		return;
+	}
 
+	cChunkDef::BlockNibbles BlockLight, SkyLight;
+	ReadChunks(a_Item.m_ChunkX, a_Item.m_ChunkZ);
+	m_Calculator.CalcLight(BlockLight, SkyLight);
 
+	m_Parent.m_World.ChunkLighted(a_Item.m_ChunkX, a_Item.m_ChunkZ, BlockLight, SkyLight);
 
-void cLightingThread::CompressLight(NIBBLETYPE * a_LightArray, NIBBLETYPE * a_ChunkLight)
-{
-	int InIdx = cChunkDef::Width * 49;  // Index to the first nibble of the middle chunk in the a_LightArray
-	int OutIdx = 0;
-	for (int y = 0; y < cChunkDef::Height; y++)
+	if (a_Item.m_CallbackAfter != nullptr)
 	{
-		for (int z = 0; z < cChunkDef::Width; z++)
-		{
-			for (int x = 0; x < cChunkDef::Width; x += 2)
-			{
-				a_ChunkLight[OutIdx++] = static_cast<NIBBLETYPE>(a_LightArray[InIdx + 1] << 4) | a_LightArray[InIdx];
-				InIdx += 2;
-			}
-			InIdx += cChunkDef::Width * 2;
-		}
-		// Skip into the next y-level in the 3x3 chunk blob; each level has cChunkDef::Width * 9 rows
-		// We've already walked cChunkDef::Width * 3 in the "for z" cycle, that makes cChunkDef::Width * 6 rows left to skip
-		InIdx += cChunkDef::Width * cChunkDef::Width * 6;
+		a_Item.m_CallbackAfter->Call(a_Item.m_ChunkX, a_Item.m_ChunkZ, true);
 	}
 }
 
@@ -532,15 +329,20 @@ void cLightingThread::CompressLight(NIBBLETYPE * a_LightArray, NIBBLETYPE * a_Ch
 
 
 
-void cLightingThread::QueueChunkStay(cLightingChunkStay & a_ChunkStay)
+void cLightingThread::cWorker::ReadChunks(int a_ChunkX, int a_ChunkZ)
 {
-	// Move the ChunkStay from the Pending queue to the lighting queue.
+	m_Calculator.Reset();
+	cReader Reader(m_Calculator);
+
+	for (int z = 0; z < 3; z++)
 	{
-		cCSLock Lock(m_CS);
-		m_PendingQueue.remove(&a_ChunkStay);
-		m_Queue.push_back(&a_ChunkStay);
-	}
-	m_evtItemAdded.Set();
+		Reader.m_ReadingChunkZ = z;
+		for (int x = 0; x < 3; x++)
+		{
+			Reader.m_ReadingChunkX = x;
+			VERIFY(m_Parent.m_World.GetChunkData(a_ChunkX + x - 1, a_ChunkZ + z - 1, Reader));
+		}  // for z
+	}  // for x
 }
 
 
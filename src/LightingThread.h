@@ -4,27 +4,18 @@
 // Interfaces to the cLightingThread class representing the thread that processes requests for lighting
 
 /*
-Lighting is done on whole chunks. For each chunk to be lighted, the whole 3x3 chunk area around it is read,
-then it is processed, so that the middle chunk area has valid lighting, and the lighting is copied into the ChunkMap.
-Lighting is calculated in full char arrays instead of nibbles, so that accessing the arrays is fast.
-Lighting is calculated in a flood-fill fashion:
-1. Generate seeds from where the light spreads (full skylight / light-emitting blocks)
-2. For each seed:
-	- Spread the light 1 block in each of the 6 cardinal directions, if the blocktype allows
-	- If the recipient block has had lower lighting value than that being spread, make it a new seed
-3. Repeat step 2, until there are no more seeds
-The seeds need two fast operations:
-	- Check if a block at [x, y, z] is already a seed
-	- Get the next seed in the row
-For that reason it is stored in two arrays, one stores a bool saying a seed is in that position,
-the other is an array of seed coords, encoded as a single int.
-Step 2 needs two separate storages for old seeds and new seeds, so there are two actual storages for that purpose,
-their content is swapped after each full step-2-cycle.
-
-The thread has two queues of chunks that are to be lighted.
-The first queue, m_Queue, is the only one that is publicly visible, chunks get queued there by external requests.
-The second one, m_PostponedQueue, is for chunks that have been taken out of m_Queue and didn't have neighbors ready.
-Chunks from m_PostponedQueue are moved back into m_Queue when their neighbors get valid, using the ChunkReady callback.
+Lighting is done on whole chunks. For each chunk to be lighted, the whole 3x3 chunk area around it is read
+from the ChunkMap into a cLightCalculator, which calculates the middle chunk's light; the light is then copied
+into the ChunkMap.
+
+The lighting has two queues of chunks that are to be lighted.
+The first queue, m_PendingQueue, holds the chunks whose 3x3 neighborhood is still being loaded or generated.
+Once all the neighbors are available, the ChunkStay moves the chunk into the second queue, m_Queue.
+
+The chunks in m_Queue are processed by one or more worker threads. Each worker has its own buffers, so that
+the workers can run in parallel. Lighting a chunk only reads the 3x3 neighborhood (through the locked ChunkMap)
+and writes only the middle chunk, so workers may process overlapping neighborhoods safely. The only thing that
+is avoided is two workers lighting the very same chunk at once, the second one would only repeat the work.
 */
 
 
@@ -33,6 +24,7 @@ Chunks from m_PostponedQueue are moved back into m_Queue when their neighbors ge
 
 #include "OSSupport/IsThread.h"
 #include "ChunkStay.h"
+#include "LightCalculator.h"
 
 
 
@@ -45,15 +37,26 @@ class cWorld;
 
 
 
-class cLightingThread :
-	public cIsThread
+class cLightingThread
 {
-	typedef cIsThread super;
-
 public:
 
+	/** Statistics of a single worker thread */
+	struct sWorkerStats
+	{
+		/** Number of chunks that the worker has lit since it was started */
+		size_t m_NumChunksLit;
+
+		/** Number of chunks lit per second of the time the worker spent lighting */
+		double m_ChunksPerSec;
+	};
+
+
 	cLightingThread(cWorld & a_World);
-	virtual ~cLightingThread() override;
+	~cLightingThread();
+
+	/** Starts the specified number of worker threads (at least one). */
+	void Start(int a_NumWorkers);
 
 	void Stop(void);
 
@@ -66,6 +69,9 @@ public:
 
 	size_t GetQueueLength(void);
 
+	/** Returns the statistics for each of the worker threads. */
+	std::vector<sWorkerStats> GetWorkerStats(void);
+
 protected:
 
 	class cLightingChunkStay :
@@ -92,9 +98,45 @@ protected:
 	typedef std::list<cChunkStay *> cChunkStays;
 
 
+	/** A single thread doing the actual lighting calculations. Each worker has its own set of buffers. */
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+
+		cWorker(cLightingThread & a_Parent);
+
+		/** Returns the statistics for this worker. */
+		sWorkerStats GetStats(void) const;
+
+	protected:
+
+		cLightingThread & m_Parent;
+
+		/** Number of chunks that this worker has lit */
+		std::atomic<size_t> m_NumChunksLit;
+
+		/** Total time this worker spent in LightChunk(), in microseconds */
+		std::atomic<Int64> m_LightingTimeUSec;
+
+		/** The calculator with the buffers for the 3x3 chunk data; this is why the workers are allocated on the heap. */
+		cLightCalculator m_Calculator;
+
+		virtual void Execute(void) override;
+
+		/** Lights the entire chunk. If neighbor chunks don't exist, touches them and re-queues the chunk */
+		void LightChunk(cLightingChunkStay & a_Item);
+
+		/** Reads the 3x3 chunk area around the specified chunk into m_Calculator */
+		void ReadChunks(int a_ChunkX, int a_ChunkZ);
+	} ;
+
+
 	cWorld & m_World;
 
-	/** The mutex to protect m_Queue and m_PendingQueue */
+	/** The mutex to protect m_Queue, m_PendingQueue and m_ChunksBeingLit */
 	cCriticalSection m_CS;
 
 	/** The ChunkStays that are loaded and are waiting to be lit. */
@@ -103,89 +145,30 @@ protected:
 	/** The ChunkStays that are waiting for load. Used for stopping the thread. */
 	cChunkStays m_PendingQueue;
 
-	cEvent m_evtItemAdded;    // Set when queue is appended, or to stop the thread
+	/** The chunks that are currently being lit by the workers. */
+	std::vector<cChunkCoords> m_ChunksBeingLit;
+
+	cEvent m_evtItemAdded;    // Set when queue is appended, or to stop the workers
 	cEvent m_evtQueueEmpty;   // Set when the queue gets empty
 
-	/** The highest block in the current 3x3 chunk data */
-	HEIGHTTYPE m_MaxHeight;
-
-
-	// Buffers for the 3x3 chunk data
-	// These buffers alone are 1.7 MiB in size, therefore they cannot be located on the stack safely - some architectures may have only 1 MiB for stack, or even less
-	// Placing the buffers into the object means that this object can light chunks only in one thread!
-	// The blobs are XZY organized as a whole, instead of 3x3 XZY-organized subarrays ->
-	//  -> This means data has to be scatterred when reading and gathered when writing!
-	static const int BlocksPerYLayer = cChunkDef::Width * cChunkDef::Width * 3 * 3;
-	BLOCKTYPE  m_BlockTypes[BlocksPerYLayer * cChunkDef::Height];
-	NIBBLETYPE m_BlockLight[BlocksPerYLayer * cChunkDef::Height];
-	NIBBLETYPE m_SkyLight  [BlocksPerYLayer * cChunkDef::Height];
-	HEIGHTTYPE m_HeightMap [BlocksPerYLayer];
-
-	// Seed management (5.7 MiB)
-	// Two buffers, in each calc step one is set as input and the other as output, then in the next step they're swapped
-	// Each seed is represented twice in this structure - both as a "list" and as a "position".
-	// "list" allows fast traversal from seed to seed
-	// "position" allows fast checking if a coord is already a seed
-	unsigned char m_IsSeed1 [BlocksPerYLayer * cChunkDef::Height];
-	unsigned int  m_SeedIdx1[BlocksPerYLayer * cChunkDef::Height];
-	unsigned char m_IsSeed2 [BlocksPerYLayer * cChunkDef::Height];
-	unsigned int  m_SeedIdx2[BlocksPerYLayer * cChunkDef::Height];
-	size_t m_NumSeeds;
-
-	virtual void Execute(void) override;
-
-	/** Lights the entire chunk. If neighbor chunks don't exist, touches them and re-queues the chunk */
-	void LightChunk(cLightingChunkStay & a_Item);
-
-	/** Prepares m_BlockTypes and m_HeightMap data; zeroes out the light arrays */
-	void ReadChunks(int a_ChunkX, int a_ChunkZ);
-
-	/** Uses m_HeightMap to initialize the m_SkyLight[] data; fills in seeds for the skylight */
-	void PrepareSkyLight(void);
-
-	/** Uses m_BlockTypes to initialize the m_BlockLight[] data; fills in seeds for the blocklight */
-	void PrepareBlockLight(void);
-
-	/** Calculates light in the light array specified, using stored seeds */
-	void CalcLight(NIBBLETYPE * a_Light);
-
-	/** Does one step in the light calculation - one seed propagation and seed recalculation */
-	void CalcLightStep(
-		NIBBLETYPE * a_Light,
-		size_t a_NumSeedsIn,    unsigned char * a_IsSeedIn,  unsigned int * a_SeedIdxIn,
-		size_t & a_NumSeedsOut, unsigned char * a_IsSeedOut, unsigned int * a_SeedIdxOut
-	);
-
-	/** Compresses from 1-block-per-byte (faster calc) into 2-blocks-per-byte (MC storage): */
-	void CompressLight(NIBBLETYPE * a_LightArray, NIBBLETYPE * a_ChunkLight);
-
-	inline void PropagateLight(
-		NIBBLETYPE * a_Light,
-		unsigned int a_SrcIdx, unsigned int a_DstIdx,
-		size_t & a_NumSeedsOut, unsigned char * a_IsSeedOut, unsigned int * a_SeedIdxOut
-	)
-	{
-		ASSERT(a_SrcIdx < ARRAYCOUNT(m_SkyLight));
-		ASSERT(a_DstIdx < ARRAYCOUNT(m_BlockTypes));
+	/** Set when the workers should terminate */
+	std::atomic<bool> m_ShouldTerminate;
 
-		if (a_Light[a_SrcIdx] <= a_Light[a_DstIdx] + cBlockInfo::GetSpreadLightFalloff(m_BlockTypes[a_DstIdx]))
-		{
-			// We're not offering more light than the dest block already has
-			return;
-		}
+	/** The worker threads doing the lighting */
+	std::vector<std::unique_ptr<cWorker>> m_Workers;
 
-		a_Light[a_DstIdx] = a_Light[a_SrcIdx] - cBlockInfo::GetSpreadLightFalloff(m_BlockTypes[a_DstIdx]);
-		if (!a_IsSeedOut[a_DstIdx])
-		{
-			a_IsSeedOut[a_DstIdx] = true;
-			a_SeedIdxOut[a_NumSeedsOut++] = a_DstIdx;
-		}
-	}
 
 	/** Queues a chunkstay that has all of its chunks loaded.
 	Called by cLightingChunkStay when all of its chunks are loaded. */
 	void QueueChunkStay(cLightingChunkStay & a_ChunkStay);
 
+	/** Blocks until there's a chunk for the worker to light, then takes it out of the queue and marks it as being lit.
+	Returns nullptr if the workers should terminate. */
+	cLightingChunkStay * DequeueChunkStay(void);
+
+	/** Marks the chunkstay's chunk as no longer being lit, called by the workers after lighting. */
+	void ChunkStayDone(cLightingChunkStay & a_ChunkStay);
+
 } ;
 
 
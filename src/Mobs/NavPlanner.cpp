@@ -0,0 +1,219 @@
+
+// NavPlanner.cpp
+
+// Implements the cNavPlanner class that plans the mobs' long paths over the chunk sections' walkable regions
+
+#include "Globals.h"
+
+#include "NavPlanner.h"
+
+/** The paths at least this long (in blocks) are planned over the regions first. */
+#define NAV_MIN_DISTANCE 16
+
+/** The maximum distance (in blocks) of the first leg's end from the source, unless the first portal is farther. */
+#define NAV_LEG_LENGTH 16
+
+/** The maximum number of regions expanded by a single plan. */
+#define NAV_MAX_EXPANSIONS 256
+
+
+
+
+
+bool cNavPlanner::PlanFirstLeg(cSections & a_Sections, const Vector3i & a_Source, const Vector3i & a_Destination, Vector3i & a_LegEnd)
+{
+	if (
+		((a_Destination - a_Source).SqrLength() < NAV_MIN_DISTANCE * NAV_MIN_DISTANCE) ||
+		(a_Source.y < 0) || (a_Source.y >= cChunkDef::Height) ||
+		(a_Destination.y < 0) || (a_Destination.y >= cChunkDef::Height)
+	)
+	{
+		return false;
+	}
+
+	// Find the regions of the source and the destination:
+	int SrcChunkX, SrcChunkZ, DstChunkX, DstChunkZ;
+	cChunkDef::BlockToChunk(a_Source.x, a_Source.z, SrcChunkX, SrcChunkZ);
+	cChunkDef::BlockToChunk(a_Destination.x, a_Destination.z, DstChunkX, DstChunkZ);
+	int SrcSectionNum = a_Source.y / cChunkData::SectionHeight;
+	int DstSectionNum = a_Destination.y / cChunkData::SectionHeight;
+	const cNavSection * SrcNavSection = GetNavSection(a_Sections, SrcChunkX, SrcSectionNum, SrcChunkZ);
+	const cNavSection * DstNavSection = GetNavSection(a_Sections, DstChunkX, DstSectionNum, DstChunkZ);
+	if ((SrcNavSection == nullptr) || (DstNavSection == nullptr))
+	{
+		return false;
+	}
+	UInt8 SrcRegion = SrcNavSection->GetRegion(
+		a_Source.x - SrcChunkX * cChunkDef::Width, a_Source.y % cChunkData::SectionHeight, a_Source.z - SrcChunkZ * cChunkDef::Width
+	);
+	UInt8 DstRegion = DstNavSection->GetRegion(
+		a_Destination.x - DstChunkX * cChunkDef::Width, a_Destination.y % cChunkData::SectionHeight, a_Destination.z - DstChunkZ * cChunkDef::Width
+	);
+	if ((SrcRegion == cNavSection::NO_REGION) || (DstRegion == cNavSection::NO_REGION))
+	{
+		// The mob or its target is somewhere the regions don't cover (water, ladder, top of a fence...)
+		return false;
+	}
+
+	m_Nodes.clear();
+	m_NodeIndices.clear();
+	m_OpenList.clear();
+	int Start = GetNode(SrcChunkX, SrcSectionNum, SrcChunkZ, SrcRegion);
+	int Goal = GetNode(DstChunkX, DstSectionNum, DstChunkZ, DstRegion);
+	if (Start == Goal)
+	{
+		return false;
+	}
+	m_Nodes[static_cast<size_t>(Start)].m_Entry = a_Source;
+	m_Nodes[static_cast<size_t>(Start)].m_G = 0;
+	m_OpenList.push_back({GetCost(a_Source, a_Destination), 0, Start});
+
+	// A* over the regions:
+	std::vector<int> Improved;
+	bool HasFoundGoal = false;
+	for (int NumExpansions = 0; !m_OpenList.empty() && (NumExpansions < NAV_MAX_EXPANSIONS);)
+	{
+		std::pop_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<sOpenEntry>());
+		sOpenEntry Entry = m_OpenList.back();
+		m_OpenList.pop_back();
+
+		// The nodes may be reallocated while expanding, so copy the current one:
+		sNode Current = m_Nodes[static_cast<size_t>(Entry.m_Node)];
+		if (Current.m_IsClosed || (Entry.m_G > Current.m_G))
+		{
+			// Stale entry
+			continue;
+		}
+		m_Nodes[static_cast<size_t>(Entry.m_Node)].m_IsClosed = true;
+		if (Entry.m_Node == Goal)
+		{
+			HasFoundGoal = true;
+			break;
+		}
+		NumExpansions += 1;
+
+		const cNavSection * CurrentNavSection = GetNavSection(a_Sections, Current.m_ChunkX, Current.m_SectionNum, Current.m_ChunkZ);
+		ASSERT(CurrentNavSection != nullptr);  // Only the loaded sections' regions are ever added
+		Improved.clear();
+		for (int Neighbor = 0; Neighbor < cNavSection::NUM_NEIGHBORS; Neighbor++)
+		{
+			if (!CurrentNavSection->HasExits(Current.m_Region, Neighbor))
+			{
+				// The region doesn't reach this neighbor, don't even build its nav section
+				continue;
+			}
+			Vector3i Offset = cNavSection::GetNeighborOffset(Neighbor);
+			int NeighborChunkX = Current.m_ChunkX + Offset.x;
+			int NeighborChunkZ = Current.m_ChunkZ + Offset.z;
+			int NeighborSectionNum = Current.m_SectionNum + Offset.y;
+			const cNavSection * NeighborNavSection = GetNavSection(a_Sections, NeighborChunkX, NeighborSectionNum, NeighborChunkZ);
+			if (NeighborNavSection == nullptr)
+			{
+				continue;
+			}
+			m_Portals.clear();
+			CurrentNavSection->GetPortals(Current.m_Region, *NeighborNavSection, Neighbor, m_Portals);
+			Vector3i NeighborBase(
+				NeighborChunkX * cChunkDef::Width, NeighborSectionNum * cChunkData::SectionHeight, NeighborChunkZ * cChunkDef::Width
+			);
+			for (const auto & Portal: m_Portals)
+			{
+				Vector3i Cell = NeighborBase + Portal.m_ToCell;
+				int Idx = GetNode(NeighborChunkX, NeighborSectionNum, NeighborChunkZ, Portal.m_ToRegion);
+				auto & Node = m_Nodes[static_cast<size_t>(Idx)];
+				int G = Current.m_G + GetCost(Current.m_Entry, Cell);
+				if (Node.m_IsClosed || (G >= Node.m_G))
+				{
+					continue;
+				}
+				if (Node.m_Parent != Entry.m_Node)
+				{
+					// The first improvement of this node from the current one, push it once all the portals are processed:
+					Improved.push_back(Idx);
+				}
+				Node.m_Entry = Cell;
+				Node.m_G = G;
+				Node.m_Parent = Entry.m_Node;
+			}
+		}
+		for (auto Idx: Improved)
+		{
+			const auto & Node = m_Nodes[static_cast<size_t>(Idx)];
+			m_OpenList.push_back({Node.m_G + GetCost(Node.m_Entry, a_Destination), Node.m_G, Idx});
+			std::push_heap(m_OpenList.begin(), m_OpenList.end(), std::greater<sOpenEntry>());
+		}
+	}
+	if (!HasFoundGoal)
+	{
+		return false;
+	}
+
+	// The first leg ends at the last portal within NAV_LEG_LENGTH of the source, or at the first one if none is:
+	std::vector<int> Route;
+	for (int Idx = Goal; Idx != Start; Idx = m_Nodes[static_cast<size_t>(Idx)].m_Parent)
+	{
+		Route.push_back(Idx);
+	}
+	a_LegEnd = m_Nodes[static_cast<size_t>(Route.back())].m_Entry;
+	for (auto itr = Route.rbegin() + 1; itr != Route.rend(); ++itr)
+	{
+		const Vector3i & Entry = m_Nodes[static_cast<size_t>(*itr)].m_Entry;
+		if ((Entry - a_Source).SqrLength() > NAV_LEG_LENGTH * NAV_LEG_LENGTH)
+		{
+			break;
+		}
+		a_LegEnd = Entry;
+	}
+	return true;
+}
+
+
+
+
+
+const cNavSection * cNavPlanner::GetNavSection(cSections & a_Sections, int a_ChunkX, int a_SectionNum, int a_ChunkZ)
+{
+	if ((a_SectionNum < 0) || (a_SectionNum >= static_cast<int>(cChunkData::NumSections)))
+	{
+		return nullptr;
+	}
+	return a_Sections.GetNavSection(a_ChunkX, a_SectionNum, a_ChunkZ);
+}
+
+
+
+
+
+int cNavPlanner::GetNode(int a_ChunkX, int a_SectionNum, int a_ChunkZ, UInt8 a_Region)
+{
+	// 26 bits for each chunk coord are enough for the whole world:
+	UInt64 Key = (
+		((static_cast<UInt64>(static_cast<UInt32>(a_ChunkX)) & 0x3ffffff) << 38) |
+		((static_cast<UInt64>(static_cast<UInt32>(a_ChunkZ)) & 0x3ffffff) << 12) |
+		(static_cast<UInt64>(a_SectionNum) << 8) |
+		a_Region
+	);
+	auto itr = m_NodeIndices.find(Key);
+	if (itr != m_NodeIndices.end())
+	{
+		return itr->second;
+	}
+
+	int Idx = static_cast<int>(m_Nodes.size());
+	m_Nodes.push_back({a_ChunkX, a_ChunkZ, a_SectionNum, a_Region, Vector3i(), std::numeric_limits<int>::max(), -1, false});
+	m_NodeIndices[Key] = Idx;
+	return Idx;
+}
+
+
+
+
+
+int cNavPlanner::GetCost(const Vector3i & a_From, const Vector3i & a_To)
+{
+	return static_cast<int>(10 * sqrt(static_cast<double>((a_To - a_From).SqrLength())));
+}
+
+
+
+
@@ -0,0 +1,104 @@
+
+// NavPlanner.h
+
+// Declares the cNavPlanner class that plans the mobs' long paths over the chunk sections' walkable regions
+
+/*
+The block-level search (cPathSearch) expands a limited number of cells, so it can't find the long paths, such as
+a zombie chasing a player 40 blocks away through a base. For such paths the cPathFinderService first asks the
+planner: it runs A* over the regions of the chunk sections (cNavSection), each region being a single node entered
+through a portal cell, and returns the cell where the route leaves the block-level search's reach. Only this first
+leg is then searched block by block; once the mob walks it, the cPathFinder requests the path again, from the new
+position.
+
+The planner gets the cNavSections through the cSections interface. In the server, they are built lazily by the
+chunks (cChunk::GetNavSection()) and dropped whenever a block in or right next to them changes.
+*/
+
+
+
+
+
+#pragma once
+
+#include "NavSection.h"
+
+#include <unordered_map>
+
+
+
+
+
+class cNavPlanner
+{
+public:
+
+	/** The interface through which the planner gets the nav sections. */
+	class cSections
+	{
+	public:
+		virtual ~cSections() {}
+
+		/** Returns the nav section at the specified coords, building it if needed.
+		Returns nullptr if the section is out of the world's height or its chunk isn't loaded. */
+		virtual const cNavSection * GetNavSection(int a_ChunkX, int a_SectionNum, int a_ChunkZ) = 0;
+	} ;
+
+
+	/** Plans the route between the specified cells over the regions of the sections provided by a_Sections.
+	Returns true and sets a_LegEnd to the cell at which the first leg of the route ends, if the destination is far
+	enough and the route was found. Returns false if the block-level search should be used for the whole path instead. */
+	bool PlanFirstLeg(cSections & a_Sections, const Vector3i & a_Source, const Vector3i & a_Destination, Vector3i & a_LegEnd);
+
+protected:
+
+	/** A region of a section, as a node of the A*. */
+	struct sNode
+	{
+		/** The chunk and the section of the region. */
+		int m_ChunkX, m_ChunkZ, m_SectionNum;
+
+		UInt8 m_Region;
+
+		/** The cell through which the region is entered on the best route found so far; the source for the start. */
+		Vector3i m_Entry;
+
+		/** The cost of the best route found so far, from the source to m_Entry; max int if not reached yet. */
+		int m_G;
+
+		/** The index of the previous node on the best route found so far; -1 for the start. */
+		int m_Parent;
+
+		bool m_IsClosed;
+	} ;
+
+	/** A node in the open list. Stale entries (G higher than the node's current one) are skipped when popped. */
+	struct sOpenEntry
+	{
+		int m_F;
+		int m_G;
+		int m_Node;
+
+		bool operator > (const sOpenEntry & a_Other) const { return (m_F > a_Other.m_F); }
+	} ;
+
+	/* The state of the current search, kept between the searches to reuse the memory */
+	std::vector<sNode> m_Nodes;
+	std::unordered_map<UInt64, int> m_NodeIndices;
+	std::vector<sOpenEntry> m_OpenList;
+	std::vector<cNavSection::sPortal> m_Portals;
+
+
+	/** Returns the nav section at the specified coords from a_Sections, or nullptr if it isn't available. */
+	static const cNavSection * GetNavSection(cSections & a_Sections, int a_ChunkX, int a_SectionNum, int a_ChunkZ);
+
+	/** Returns the index of the node for the specified region, adding a new one, not reached yet, if not there yet. */
+	int GetNode(int a_ChunkX, int a_SectionNum, int a_ChunkZ, UInt8 a_Region);
+
+	/** Returns the cost of walking between the two cells, also used as the heuristic. */
+	static int GetCost(const Vector3i & a_From, const Vector3i & a_To);
+} ;
+
+
+
+
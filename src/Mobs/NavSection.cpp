@@ -0,0 +1,248 @@
+
+// NavSection.cpp
+
+// Implements the cNavSection class representing the walkable regions of a single chunk section, for the cNavPlanner
+
+#include "Globals.h"
+
+#include "NavSection.h"
+
+/** The number of cells in a single horizontal layer of a section. */
+#define LAYER_SIZE (cChunkDef::Width * cChunkDef::Width)
+
+
+
+
+
+/** The horizontal neighbors of a cell, the steps between the cells of a region. */
+static const struct
+{
+	int x, z;
+} g_HorizontalNeighbors[] =
+{
+	{ 1,  0},
+	{-1,  0},
+	{ 0,  1},
+	{ 0, -1},
+};
+
+
+
+
+
+/** The offsets of the neighboring sections, in chunks in X and Z and in sections in Y, see cNavSection::GetNeighborOffset(). */
+static const struct
+{
+	int x, y, z;
+} g_NeighborSections[cNavSection::NUM_NEIGHBORS] =
+{
+	// The chunk neighbors at the same height:
+	{ 1,  0,  0}, {-1,  0,  0}, { 0,  0,  1}, { 0,  0, -1},
+
+	// The sections above and below, in the same chunk:
+	{ 0,  1,  0}, { 0, -1,  0},
+
+	// The chunk neighbors of the sections above and below:
+	{ 1,  1,  0}, {-1,  1,  0}, { 0,  1,  1}, { 0,  1, -1},
+	{ 1, -1,  0}, {-1, -1,  0}, { 0, -1,  1}, { 0, -1, -1},
+};
+
+
+
+
+
+cNavSection::cNavSection(const BLOCKTYPE * a_Below, const BLOCKTYPE * a_BlockTypes, const BLOCKTYPE * a_Above, const bool * a_IsSolid) :
+	m_NumRegions(0)
+{
+	const int SectionHeight = cChunkData::SectionHeight;
+
+	// The solidity of the section's cells, with one more layer below and above; layer 0 is the top layer of the section below:
+	bool IsSolid[(SectionHeight + 2) * LAYER_SIZE];
+	for (int i = 0; i < LAYER_SIZE; i++)
+	{
+		IsSolid[i] = (a_Below != nullptr) && a_IsSolid[a_Below[(SectionHeight - 1) * LAYER_SIZE + i]];
+		IsSolid[(SectionHeight + 1) * LAYER_SIZE + i] = (a_Above != nullptr) && a_IsSolid[a_Above[i]];
+	}
+	for (int i = 0; i < SectionHeight * LAYER_SIZE; i++)
+	{
+		IsSolid[LAYER_SIZE + i] = (a_BlockTypes != nullptr) && a_IsSolid[a_BlockTypes[i]];
+	}
+
+	// Mark the walkable cells, so far without a region:
+	const UInt8 UNLABELED = OVERFLOW_REGION;
+	for (int i = 0; i < SectionHeight * LAYER_SIZE; i++)
+	{
+		bool IsWalkable = IsSolid[i] && !IsSolid[LAYER_SIZE + i] && !IsSolid[2 * LAYER_SIZE + i];
+		m_Regions[i] = IsWalkable ? UNLABELED : NO_REGION;
+	}
+
+	// Flood-fill the regions:
+	std::vector<int> Stack;
+	for (int Start = 0; Start < SectionHeight * LAYER_SIZE; Start++)
+	{
+		if (m_Regions[Start] != UNLABELED)
+		{
+			continue;
+		}
+		m_NumRegions += 1;
+		if (m_NumRegions == OVERFLOW_REGION)
+		{
+			// Out of labels, all the remaining walkable cells stay in OVERFLOW_REGION
+			break;
+		}
+		const UInt8 Region = static_cast<UInt8>(m_NumRegions);
+		m_Regions[Start] = Region;
+		Stack.push_back(Start);
+		while (!Stack.empty())
+		{
+			int Idx = Stack.back();
+			Stack.pop_back();
+			int x = Idx % cChunkDef::Width;
+			int z = (Idx / cChunkDef::Width) % cChunkDef::Width;
+			int y = Idx / LAYER_SIZE;
+			for (const auto & Neighbor: g_HorizontalNeighbors)
+			{
+				int NeighborX = x + Neighbor.x;
+				int NeighborZ = z + Neighbor.z;
+				if ((NeighborX < 0) || (NeighborX >= cChunkDef::Width) || (NeighborZ < 0) || (NeighborZ >= cChunkDef::Width))
+				{
+					continue;
+				}
+				for (int NeighborY = std::max(y - 1, 0); NeighborY <= std::min(y + 1, SectionHeight - 1); NeighborY++)
+				{
+					int NeighborIdx = cChunkDef::MakeIndexNoCheck(NeighborX, NeighborY, NeighborZ);
+					if (m_Regions[NeighborIdx] == UNLABELED)
+					{
+						m_Regions[NeighborIdx] = Region;
+						Stack.push_back(NeighborIdx);
+					}
+				}
+			}
+		}
+	}
+
+	FindExits();
+}
+
+
+
+
+
+Vector3i cNavSection::GetNeighborOffset(int a_Neighbor)
+{
+	ASSERT((a_Neighbor >= 0) && (a_Neighbor < NUM_NEIGHBORS));
+	const auto & Neighbor = g_NeighborSections[a_Neighbor];
+	return Vector3i(Neighbor.x, Neighbor.y, Neighbor.z);
+}
+
+
+
+
+
+bool cNavSection::HasExits(UInt8 a_Region, int a_Neighbor) const
+{
+	ASSERT(a_Region != NO_REGION);
+	ASSERT(a_Region <= m_NumRegions);
+	size_t Idx = GetExitsIndex(a_Region, a_Neighbor);
+	return (m_ExitStarts[Idx] != m_ExitStarts[Idx + 1]);
+}
+
+
+
+
+
+void cNavSection::GetPortals(UInt8 a_Region, const cNavSection & a_NeighborSection, int a_Neighbor, std::vector<sPortal> & a_Portals) const
+{
+	ASSERT(a_Region != NO_REGION);
+	ASSERT(a_Region <= m_NumRegions);
+	size_t Idx = GetExitsIndex(a_Region, a_Neighbor);
+	for (UInt32 i = m_ExitStarts[Idx]; i < m_ExitStarts[Idx + 1]; i++)
+	{
+		UInt16 Cell = m_ExitCells[i];
+		UInt8 ToRegion = a_NeighborSection.m_Regions[Cell];
+		if (ToRegion != NO_REGION)
+		{
+			a_Portals.push_back({ToRegion, Vector3i(Cell % cChunkDef::Width, Cell / LAYER_SIZE, (Cell / cChunkDef::Width) % cChunkDef::Width)});
+		}
+	}
+}
+
+
+
+
+
+void cNavSection::FindExits(void)
+{
+	if (m_NumRegions == 0)
+	{
+		return;
+	}
+	const int Max = cChunkDef::Width - 1;
+	const int MaxY = cChunkData::SectionHeight - 1;
+
+	// Collect the exits as (region, neighbor, cell) keys, so that sorting groups them and drops the duplicates
+	// (the cells reachable from several cells of the same region):
+	std::vector<UInt32> Keys;
+	for (int Idx = 0; Idx < static_cast<int>(cChunkData::SectionBlockCount); Idx++)
+	{
+		UInt8 Region = m_Regions[Idx];
+		int x = Idx % cChunkDef::Width;
+		int z = (Idx / cChunkDef::Width) % cChunkDef::Width;
+		int y = Idx / LAYER_SIZE;
+		if ((Region == NO_REGION) || ((x > 0) && (x < Max) && (z > 0) && (z < Max) && (y > 0) && (y < MaxY)))
+		{
+			// Only the walkable cells on the section's boundary can step out of it
+			continue;
+		}
+		for (const auto & Step: g_HorizontalNeighbors)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				int ToX = x + Step.x;
+				int ToY = y + dy;
+				int ToZ = z + Step.z;
+				int OffsetX = (ToX < 0) ? -1 : ((ToX > Max) ? 1 : 0);
+				int OffsetY = (ToY < 0) ? -1 : ((ToY > MaxY) ? 1 : 0);
+				int OffsetZ = (ToZ < 0) ? -1 : ((ToZ > Max) ? 1 : 0);
+				if ((OffsetX == 0) && (OffsetY == 0) && (OffsetZ == 0))
+				{
+					// A step within the section
+					continue;
+				}
+				int Neighbor = 0;
+				while (
+					(g_NeighborSections[Neighbor].x != OffsetX) ||
+					(g_NeighborSections[Neighbor].y != OffsetY) ||
+					(g_NeighborSections[Neighbor].z != OffsetZ)
+				)
+				{
+					Neighbor += 1;
+				}
+				int ToCell = cChunkDef::MakeIndexNoCheck(
+					ToX - OffsetX * cChunkDef::Width, ToY - OffsetY * cChunkData::SectionHeight, ToZ - OffsetZ * cChunkDef::Width
+				);
+				Keys.push_back((static_cast<UInt32>(GetExitsIndex(Region, Neighbor)) << 12) | static_cast<UInt32>(ToCell));
+			}
+		}
+	}
+	std::sort(Keys.begin(), Keys.end());
+	Keys.erase(std::unique(Keys.begin(), Keys.end()), Keys.end());
+
+	// Store the cells and the start of each group:
+	size_t NumGroups = static_cast<size_t>(m_NumRegions * NUM_NEIGHBORS);
+	m_ExitCells.reserve(Keys.size());
+	m_ExitStarts.assign(NumGroups + 1, 0);
+	for (auto Key: Keys)
+	{
+		m_ExitCells.push_back(static_cast<UInt16>(Key & 0xfff));
+		m_ExitStarts[(Key >> 12) + 1] += 1;
+	}
+	for (size_t i = 0; i < NumGroups; i++)
+	{
+		m_ExitStarts[i + 1] += m_ExitStarts[i];
+	}
+}
+
+
+
+
@@ -0,0 +1,115 @@
+
+// NavSection.h
+
+// Declares the cNavSection class representing the walkable regions of a single chunk section, for the cNavPlanner
+
+/*
+A cell is walkable if a mob can stand in it: the cell and the one above it are not solid, and the one below it is.
+The walkable cells of a section are grouped into regions, the sets of cells connected by steps into the
+horizontally neighboring cell at the same height or one block up or down. The regions of neighboring sections are
+connected by portals, the pairs of cells across the sections' boundary between which such a step is possible. A step
+may cross a chunk border, a section boundary (up from the top layer or down from the bottom one), or both at once,
+so each section has 14 neighbors, see GetNeighborOffset().
+
+Each section caches, for each of its regions and neighbors, the neighbor's cells into which a step from the region
+leads. GetPortals() only looks up the regions of these cells in the neighbor, so that each section still depends only
+on its own blocks and the layers right below and above it, and needn't be rebuilt when a neighbor is.
+
+The regions are a coarse approximation made for planning long paths; ladders, water, doors, fences and falls of
+more than a block are not considered, the block-level search handles them when refining the plan.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../ChunkData.h"
+#include "../Defines.h"
+
+
+
+
+
+class cNavSection
+{
+public:
+
+	/** The region of cells that are not walkable. */
+	static const UInt8 NO_REGION = 0;
+
+	/** The region shared by all the cells beyond the first 254 regions of a section, connected or not. */
+	static const UInt8 OVERFLOW_REGION = 255;
+
+	/** The number of the neighboring sections into which the portals lead. */
+	static const int NUM_NEIGHBORS = 14;
+
+
+	/** A step from a region of this section into a neighboring section. */
+	struct sPortal
+	{
+		/** The region of the neighboring section into which the step leads. */
+		UInt8 m_ToRegion;
+
+		/** The cell into which the step leads, relative to the neighboring section. */
+		Vector3i m_ToCell;
+	} ;
+
+
+	/** Labels the regions of the section with the specified block types (cChunkData::sChunkSection::GetBlockTypes() layout).
+	a_Below and a_Above are the block types of the sections below and above, only their nearest layer is used.
+	Any of the sections may be nullptr, meaning all air.
+	a_IsSolid is the table of solid block types (cBlockInfo::IsSolid(), 256 items). */
+	cNavSection(const BLOCKTYPE * a_Below, const BLOCKTYPE * a_BlockTypes, const BLOCKTYPE * a_Above, const bool * a_IsSolid);
+
+	/** Returns the region of the specified cell, relative to the section; NO_REGION if it is not walkable. */
+	UInt8 GetRegion(int a_RelX, int a_RelY, int a_RelZ) const
+	{
+		return m_Regions[cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ)];
+	}
+
+	/** Returns the number of regions in the section, including OVERFLOW_REGION if used. */
+	int GetNumRegions(void) const { return m_NumRegions; }
+
+	/** Returns the offset of the specified neighboring section (0 .. NUM_NEIGHBORS - 1), in chunks in X and Z and in sections in Y.
+	The first four are the chunk neighbors at the same height, then the sections above and below in the same chunk,
+	then the chunk neighbors of the sections above and below. */
+	static Vector3i GetNeighborOffset(int a_Neighbor);
+
+	/** Returns true if there is any step from the specified region into the specified neighboring section, whatever its blocks. */
+	bool HasExits(UInt8 a_Region, int a_Neighbor) const;
+
+	/** Appends all the portals from the specified region of this section into a_NeighborSection,
+	the section at the specified neighbor offset (see GetNeighborOffset()) from this one. */
+	void GetPortals(UInt8 a_Region, const cNavSection & a_NeighborSection, int a_Neighbor, std::vector<sPortal> & a_Portals) const;
+
+protected:
+
+	/** The region of each cell, indexed by cChunkDef::MakeIndexNoCheck(). */
+	UInt8 m_Regions[cChunkData::SectionBlockCount];
+
+	int m_NumRegions;
+
+	/** The cells of the neighboring sections into which the steps from the regions lead, relative to the neighbor
+	and indexed by cChunkDef::MakeIndexNoCheck(); grouped by the region and then by the neighbor, see m_ExitStarts. */
+	std::vector<UInt16> m_ExitCells;
+
+	/** The index into m_ExitCells of the first exit of each region and neighbor, at (Region - 1) * NUM_NEIGHBORS + Neighbor;
+	the exits end where the next ones start, the last item marks the end of all. Empty if there are no regions. */
+	std::vector<UInt32> m_ExitStarts;
+
+
+	/** Fills m_ExitCells and m_ExitStarts from the labeled regions. */
+	void FindExits(void);
+
+	/** Returns the index into m_ExitStarts of the exits of the specified region into the specified neighbor. */
+	static size_t GetExitsIndex(UInt8 a_Region, int a_Neighbor)
+	{
+		return static_cast<size_t>((a_Region - 1) * NUM_NEIGHBORS + a_Neighbor);
+	}
+} ;
+
+
+
+
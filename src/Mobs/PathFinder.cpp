@@ -1,6 +1,68 @@
 #include "Globals.h"
 #include "PathFinder.h"
 #include "../Chunk.h"
+#include "../World.h"
+#include "NavSection.h"
+
+
+
+
+
+/** Provides the blocks to the cPathFinderService from the mob's chunk and its neighbors. */
+class cChunkBlockSource :
+	public cPathFinderService::cBlockSource
+{
+public:
+
+	cChunkBlockSource(cChunk & a_Chunk, const bool * a_IsSolid) :
+		m_Chunk(a_Chunk),
+		m_IsSolid(a_IsSolid)
+	{
+	}
+
+	virtual bool IsChunkAvailable(int a_ChunkX, int a_ChunkZ) override
+	{
+		return (GetChunk(a_ChunkX, a_ChunkZ) != nullptr);
+	}
+
+	virtual bool CopySection(int a_ChunkX, int a_SectionNum, int a_ChunkZ, cPathSnapshot::sSection & a_Section) override
+	{
+		cChunk * Chunk = GetChunk(a_ChunkX, a_ChunkZ);
+		ASSERT(Chunk != nullptr);
+		const cChunkData::sChunkSection * Section = Chunk->GetSection(static_cast<size_t>(a_SectionNum));
+		if (Section == nullptr)
+		{
+			return false;
+		}
+		Section->CopyBlockTypes(a_Section.m_BlockTypes);
+		memcpy(a_Section.m_BlockMetas, Section->m_BlockMetas, sizeof(a_Section.m_BlockMetas));
+		return true;
+	}
+
+	virtual const cNavSection * GetNavSection(int a_ChunkX, int a_SectionNum, int a_ChunkZ) override
+	{
+		cChunk * Chunk = GetChunk(a_ChunkX, a_ChunkZ);
+		if (Chunk == nullptr)
+		{
+			return nullptr;
+		}
+		return &Chunk->GetNavSection(static_cast<size_t>(a_SectionNum), m_IsSolid);
+	}
+
+protected:
+
+	cChunk & m_Chunk;
+
+	const bool * m_IsSolid;
+
+
+	/** Returns the specified chunk, if it is valid, nullptr otherwise. */
+	cChunk * GetChunk(int a_ChunkX, int a_ChunkZ)
+	{
+		cChunk * Chunk = m_Chunk.GetNeighborChunk(a_ChunkX * cChunkDef::Width, a_ChunkZ * cChunkDef::Width);
+		return ((Chunk != nullptr) && Chunk->IsValid()) ? Chunk : nullptr;
+	}
+} ;
 
 
 
@@ -53,13 +115,13 @@ ePathFinderStatus cPathFinder::GetNextWayPoint(cChunk & a_Chunk, const Vector3d
 		ResetPathFinding(a_Chunk);
 	}
 
-	// If m_Path has not been initialized yet, initialize it.
-	if (!m_Path->IsValid())
+	// If m_Path has not been initialized yet and isn't being calculated, initialize it.
+	if (!m_Path->IsValid() && (m_PendingPath == nullptr))
 	{
 		ResetPathFinding(a_Chunk);
 	}
 
-	switch (m_Path->CalculationStep(a_Chunk))
+	switch (PollPath())
 	{
 		case ePathFinderStatus::NEARBY_FOUND:
 		{
@@ -172,7 +234,34 @@ void cPathFinder::ResetPathFinding(cChunk &a_Chunk)
 	m_NoPathToTarget = false;
 	m_PathDestination = m_FinalDestination;
 	m_DeviationOrigin = m_PathDestination;
-	m_Path.reset(new cPath(a_Chunk, m_Source, m_PathDestination, 20, m_Width, m_Height));
+	m_Path.reset(new cPath());
+	cPathFinderService & Service = a_Chunk.GetWorld()->GetPathFinderService();
+	cChunkBlockSource Blocks(a_Chunk, Service.GetIsSolid());
+	m_PendingPath = Service.RequestPath(Blocks, m_Source, m_PathDestination, m_Width, m_Height);
+}
+
+
+
+
+
+ePathFinderStatus cPathFinder::PollPath(void)
+{
+	if (m_PendingPath != nullptr)
+	{
+		if (!m_PendingPath->IsDone())
+		{
+			return ePathFinderStatus::CALCULATING;
+		}
+		const auto & Result = m_PendingPath->GetResult();
+		m_Path.reset(new cPath(Result.m_Status, Result.m_Destination, Result.m_PathPoints, 0.5));  // All mobs are treated as 1 block wide
+		if (m_PendingPath->IsLeg() && (Result.m_Status == ePathFinderStatus::PATH_FOUND))
+		{
+			// Only the first leg of a long path was searched, head for its end; the next leg is requested once there:
+			m_PathDestination = Vector3d(Result.m_Destination.x + 0.5, Result.m_Destination.y, Result.m_Destination.z + 0.5);
+		}
+		m_PendingPath.reset();
+	}
+	return m_Path->GetStatus();
 }
 
 
@@ -1,11 +1,14 @@
 
 #pragma once
 #include "Path.h"
+#include "PathFinderService.h"
 
 #define WAYPOINT_RADIUS 0.5
 
+class cChunk;
+
 /** This class wraps cPath.
-cPath is a "dumb device" - You give it point A and point B, and it returns a full path path.
+cPath is a "dumb device" - You give it point A and point B, and the cPathFinderService returns a full path path.
 cPathFinder - You give it a constant stream of point A (where you are) and point B (where you want to go),
 and it tells you where to go next. It manages path recalculation internally, and is much more efficient that calling cPath every step. */
 class cPathFinder
@@ -49,6 +52,9 @@ private:
 	/** The current cPath instance we have. This is discarded and recreated when a path recalculation is needed. */
 	std::unique_ptr<cPath> m_Path;
 
+	/** The path requested from the cPathFinderService and not received yet; m_Path is replaced by its result once it is done. */
+	cPathFinderService::cJobPtr m_PendingPath;
+
 	/** If 0, will give up reaching the next m_WayPoint and will recalculate path. */
 	int m_GiveUpCounter;
 
@@ -81,9 +87,13 @@ private:
 	2. If a_Vector is the position of air, a_Vector's Y will be modified to point to the first airblock below it which has solid or water beneath. */
 	bool EnsureProperPoint(Vector3d & a_Vector, cChunk & a_Chunk);
 
-	/** Resets a pathfinding task, typically because m_FinalDestination has deviated too much from m_DeviationOrigin. */
+	/** Resets a pathfinding task, typically because m_FinalDestination has deviated too much from m_DeviationOrigin.
+	Requests a new path from the world's cPathFinderService. */
 	void ResetPathFinding(cChunk &a_Chunk);
 
+	/** Returns the status of the current path; if the requested path has been found meanwhile, makes it the current one first. */
+	ePathFinderStatus PollPath(void);
+
 	/** Return true the the blocktype is either water or solid */
 	bool IsWaterOrSolid(BLOCKTYPE a_BlockType);
 
@@ -0,0 +1,323 @@
+
+// PathFinderService.cpp
+
+// Implements the cPathFinderService class that calculates the mobs' paths on a pool of worker threads
+
+#include "Globals.h"
+
+#include "PathFinderService.h"
+
+/** The maximum number of cells expanded by a single search. */
+#define PATH_MAX_CALCULATIONS 200
+
+/** The number of ticks for which a requested path is shared with the other mobs requesting the same path. */
+#define PATH_CACHE_TICKS 20
+
+/** The number of blocks around the source and the destination that are copied into a snapshot. */
+#define SNAPSHOT_MARGIN 16
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPathFinderService::cJob:
+
+cPathFinderService::cJob::cJob(const Vector3i & a_Source, const Vector3i & a_Destination, bool a_IsLeg, int a_Width, int a_Height, std::unique_ptr<cPathSnapshot> a_Snapshot, Int64 a_RequestTick) :
+	m_Source(a_Source),
+	m_Destination(a_Destination),
+	m_IsLeg(a_IsLeg),
+	m_Width(a_Width),
+	m_Height(a_Height),
+	m_Snapshot(std::move(a_Snapshot)),
+	m_IsDone(false),
+	m_RequestTick(a_RequestTick)
+{
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPathFinderService:
+
+cPathFinderService::cPathFinderService(const bool * a_IsSolid) :
+	m_IsSolid(),
+	m_Search(m_IsSolid),
+	m_ShouldTerminate(false),
+	m_CurrentTick(0)
+{
+	std::copy(a_IsSolid, a_IsSolid + ARRAYCOUNT(m_IsSolid), m_IsSolid);
+}
+
+
+
+
+
+cPathFinderService::~cPathFinderService()
+{
+	Stop();
+}
+
+
+
+
+
+void cPathFinderService::Start(int a_NumWorkers)
+{
+	ASSERT(m_Workers.empty());
+	m_ShouldTerminate = false;
+	for (int i = a_NumWorkers; i > 0; i--)
+	{
+		m_Workers.push_back(cpp14::make_unique<cWorker>(*this));
+		m_Workers.back()->Start();
+	}
+}
+
+
+
+
+
+void cPathFinderService::Stop(void)
+{
+	m_ShouldTerminate = true;
+	m_evtItemAdded.Set();  // Each terminating worker passes the event on to the next one
+	for (auto & Worker : m_Workers)
+	{
+		Worker->Wait();
+	}
+	m_Workers.clear();
+
+	// Finish the jobs that no worker has taken, so that nobody polls them forever:
+	cCSLock Lock(m_CS);
+	for (auto & Job : m_Queue)
+	{
+		Job->m_Snapshot.reset();
+		Job->m_Result.m_Status = ePathFinderStatus::PATH_NOT_FOUND;
+		Job->m_Result.m_Destination = Job->m_Destination;
+		Job->m_Result.m_PathPoints.clear();
+		Job->m_IsDone.store(true, std::memory_order_release);
+	}
+	m_Queue.clear();
+}
+
+
+
+
+
+cPathFinderService::cJobPtr cPathFinderService::RequestPath(cBlockSource & a_Blocks, const Vector3d & a_Source, const Vector3d & a_Destination, double a_Width, double a_Height)
+{
+	a_Width = 1;  // Treat all mobs width as 1 until physics is improved.
+
+	// Convert the positions to cells, "the block where the mob's knees are at":
+	int HalfWidthInt = FloorC(a_Width / 2);
+	Vector3i Source(FloorC(a_Source.x - HalfWidthInt), FloorC(a_Source.y), FloorC(a_Source.z - HalfWidthInt));
+	Vector3i Destination(FloorC(a_Destination.x - HalfWidthInt), FloorC(a_Destination.y), FloorC(a_Destination.z - HalfWidthInt));
+	sPathKey Key = {Source, Destination, CeilC(a_Width), CeilC(a_Height)};
+
+	// Share the job with the mobs that have asked for the same path recently:
+	auto itr = m_PathCache.find(Key);
+	if (itr != m_PathCache.end())
+	{
+		return itr->second;
+	}
+
+	// Plan the long paths over the sections' regions, then search only their first leg:
+	Vector3i LegEnd;
+	bool IsLeg = m_NavPlanner.PlanFirstLeg(a_Blocks, Source, Destination, LegEnd);
+	if (IsLeg)
+	{
+		Destination = LegEnd;
+	}
+
+	auto Job = std::make_shared<cJob>(Source, Destination, IsLeg, Key.m_Width, Key.m_Height, TakeSnapshot(a_Blocks, Source, Destination), m_CurrentTick);
+	m_PathCache[Key] = Job;
+
+	if (m_Workers.empty())
+	{
+		RunJob(*Job, m_Search);
+		return Job;
+	}
+
+	{
+		cCSLock Lock(m_CS);
+		m_Queue.push_back(Job);
+	}
+	m_evtItemAdded.Set();
+	return Job;
+}
+
+
+
+
+
+void cPathFinderService::Tick(void)
+{
+	m_CurrentTick += 1;
+	m_TickSections.clear();
+
+	for (auto itr = m_PathCache.begin(); itr != m_PathCache.end();)
+	{
+		if (itr->second->m_RequestTick + PATH_CACHE_TICKS < m_CurrentTick)
+		{
+			itr = m_PathCache.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+
+
+
+
+size_t cPathFinderService::GetQueueLength(void)
+{
+	cCSLock Lock(m_CS);
+	return m_Queue.size();
+}
+
+
+
+
+
+std::unique_ptr<cPathSnapshot> cPathFinderService::TakeSnapshot(cBlockSource & a_Blocks, const Vector3i & a_Source, const Vector3i & a_Destination)
+{
+	int MinChunkX, MinChunkZ, MaxChunkX, MaxChunkZ;
+	cChunkDef::BlockToChunk(std::min(a_Source.x, a_Destination.x) - SNAPSHOT_MARGIN, std::min(a_Source.z, a_Destination.z) - SNAPSHOT_MARGIN, MinChunkX, MinChunkZ);
+	cChunkDef::BlockToChunk(std::max(a_Source.x, a_Destination.x) + SNAPSHOT_MARGIN, std::max(a_Source.z, a_Destination.z) + SNAPSHOT_MARGIN, MaxChunkX, MaxChunkZ);
+	int MinY = Clamp(std::min(a_Source.y, a_Destination.y) - SNAPSHOT_MARGIN, 0, cChunkDef::Height - 1);
+	int MaxY = Clamp(std::max(a_Source.y, a_Destination.y) + SNAPSHOT_MARGIN, 0, cChunkDef::Height - 1);
+	int MinSection = MinY / cChunkData::SectionHeight;
+	int MaxSection = MaxY / cChunkData::SectionHeight;
+
+	auto Snapshot = cpp14::make_unique<cPathSnapshot>(
+		MinChunkX, MinChunkZ, MaxChunkX - MinChunkX + 1, MaxChunkZ - MinChunkZ + 1,
+		MinSection, MaxSection - MinSection + 1
+	);
+	for (int ChunkZ = MinChunkZ; ChunkZ <= MaxChunkZ; ChunkZ++)
+	{
+		for (int ChunkX = MinChunkX; ChunkX <= MaxChunkX; ChunkX++)
+		{
+			if (!a_Blocks.IsChunkAvailable(ChunkX, ChunkZ))
+			{
+				continue;
+			}
+			Snapshot->SetChunkAvailable(ChunkX, ChunkZ);
+			for (int SectionNum = MinSection; SectionNum <= MaxSection; SectionNum++)
+			{
+				auto Section = GetTickSection(a_Blocks, ChunkX, SectionNum, ChunkZ);
+				if (Section != nullptr)
+				{
+					Snapshot->SetSection(ChunkX, SectionNum, ChunkZ, std::move(Section));
+				}
+			}
+		}
+	}
+	return Snapshot;
+}
+
+
+
+
+
+cPathSnapshot::cSectionPtr cPathFinderService::GetTickSection(cBlockSource & a_Blocks, int a_ChunkX, int a_SectionNum, int a_ChunkZ)
+{
+	Vector3i Key(a_ChunkX, a_SectionNum, a_ChunkZ);
+	auto itr = m_TickSections.find(Key);
+	if (itr != m_TickSections.end())
+	{
+		return itr->second;
+	}
+
+	cPathSnapshot::cSectionPtr Res;
+	auto Copy = std::make_shared<cPathSnapshot::sSection>();
+	if (a_Blocks.CopySection(a_ChunkX, a_SectionNum, a_ChunkZ, *Copy))  // All-air sections are not stored
+	{
+		Res = std::move(Copy);
+	}
+	m_TickSections[Key] = Res;
+	return Res;
+}
+
+
+
+
+
+void cPathFinderService::RunJob(cJob & a_Job, cPathSearch & a_Search)
+{
+	a_Search.Search(*a_Job.m_Snapshot, a_Job.m_Source, a_Job.m_Destination, PATH_MAX_CALCULATIONS, a_Job.m_Width, a_Job.m_Height, a_Job.m_Result);
+	a_Job.m_Snapshot.reset();
+	a_Job.m_IsDone.store(true, std::memory_order_release);
+}
+
+
+
+
+
+cPathFinderService::cJobPtr cPathFinderService::DequeueJob(void)
+{
+	cCSLock Lock(m_CS);
+	for (;;)
+	{
+		if (m_ShouldTerminate)
+		{
+			// Wake up the next worker so that it terminates, too:
+			m_evtItemAdded.Set();
+			return nullptr;
+		}
+
+		if (!m_Queue.empty())
+		{
+			cJobPtr Job = std::move(m_Queue.front());
+			m_Queue.pop_front();
+			if (!m_Queue.empty())
+			{
+				// There's more work, wake up another worker:
+				m_evtItemAdded.Set();
+			}
+			return Job;
+		}
+
+		cCSUnlock Unlock(Lock);
+		m_evtItemAdded.Wait();
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPathFinderService::cWorker:
+
+cPathFinderService::cWorker::cWorker(cPathFinderService & a_Parent) :
+	super("cPathFinderService"),
+	m_Parent(a_Parent),
+	m_Search(a_Parent.m_IsSolid)
+{
+}
+
+
+
+
+
+void cPathFinderService::cWorker::Execute(void)
+{
+	for (;;)
+	{
+		auto Job = m_Parent.DequeueJob();
+		if (Job == nullptr)
+		{
+			return;
+		}
+		RunJob(*Job, m_Search);
+	}
+}
+
+
+
+
@@ -0,0 +1,237 @@
+
+// PathFinderService.h
+
+// Declares the cPathFinderService class that calculates the mobs' paths on a pool of worker threads
+
+/*
+The mobs' cPathFinders request their paths from the service of their world, then poll the returned job each tick
+until it is done. When a path is requested, the world thread takes a cPathSnapshot of the chunk sections around
+the source and the destination and queues the job for the workers; each worker runs the jobs with its own
+cPathSearch, whose arena is reused from job to job. The sections copied during a single tick are shared by all the
+snapshots taken in that tick, so a crowd of mobs in one place (such as a mob farm) copies each section only once.
+
+The jobs are kept in a cache for PATH_CACHE_TICKS ticks after they were requested, keyed by the source and
+destination cells and the mob's size, so that the mobs asking for the same path within that time share a single
+search, whether it has finished already or not.
+
+The long paths are planned over the chunk sections' walkable regions by the cNavPlanner first, on the world thread,
+and only their first leg is searched block by block (see cJob::IsLeg()).
+
+With zero worker threads, the jobs are searched on the world thread right when they are requested.
+
+The service reads the blocks through the cBlockSource interface, implemented over the mob's chunk and its
+neighbors by the cPathFinder, so that it can be driven without a world, such as by the PathSearchBenchmark.
+*/
+
+
+
+
+
+#pragma once
+
+#include "PathSearch.h"
+#include "NavPlanner.h"
+#include "../OSSupport/IsThread.h"
+
+#include <unordered_map>
+
+
+
+
+
+class cPathFinderService
+{
+public:
+
+	/** A single path request. Shared by all the cPathFinders that requested the same path, and by the cache. */
+	class cJob
+	{
+		friend class cPathFinderService;
+
+	public:
+
+		cJob(const Vector3i & a_Source, const Vector3i & a_Destination, bool a_IsLeg, int a_Width, int a_Height, std::unique_ptr<cPathSnapshot> a_Snapshot, Int64 a_RequestTick);
+
+		/** Returns true once the search is finished and GetResult() may be called. Safe to call from any thread. */
+		bool IsDone(void) const { return m_IsDone.load(std::memory_order_acquire); }
+
+		/** Returns the result of the search. Valid only once IsDone() returns true, doesn't change afterwards. */
+		const cPathSearch::sResult & GetResult(void) const
+		{
+			ASSERT(IsDone());
+			return m_Result;
+		}
+
+		/** Returns true if only the first leg of the requested path is searched, planned by the cNavPlanner.
+		Once the mob walks the leg, it is expected to request the path again. */
+		bool IsLeg(void) const { return m_IsLeg; }
+
+	protected:
+
+		/** The cells between which the path is searched; the destination is the end of the first leg if m_IsLeg is true. */
+		Vector3i m_Source;
+		Vector3i m_Destination;
+
+		bool m_IsLeg;
+
+		/** The mob's size, in cells. */
+		int m_Width;
+		int m_Height;
+
+		/** The blocks to search through; released as soon as the search is finished. */
+		std::unique_ptr<cPathSnapshot> m_Snapshot;
+
+		cPathSearch::sResult m_Result;
+
+		/** Set, with release semantics, after m_Result is written. */
+		std::atomic<bool> m_IsDone;
+
+		/** The service's tick in which the job was requested, for expiring it from the cache. */
+		Int64 m_RequestTick;
+	} ;
+
+	typedef std::shared_ptr<cJob> cJobPtr;
+
+
+	/** The interface through which the service reads the world's blocks, for the snapshots and for the cNavPlanner. */
+	class cBlockSource :
+		public cNavPlanner::cSections
+	{
+	public:
+
+		/** Returns true if the specified chunk is loaded and its blocks may be read. */
+		virtual bool IsChunkAvailable(int a_ChunkX, int a_ChunkZ) = 0;
+
+		/** Copies the blocks of the specified section of an available chunk into a_Section.
+		Returns false, leaving a_Section untouched, if the section is all air. */
+		virtual bool CopySection(int a_ChunkX, int a_SectionNum, int a_ChunkZ, cPathSnapshot::sSection & a_Section) = 0;
+	} ;
+
+
+	/** Creates the service, using the specified table of solid block types (cBlockInfo::IsSolid() in the server, 256 items).
+	The table is copied. */
+	cPathFinderService(const bool * a_IsSolid);
+	~cPathFinderService();
+
+	/** Starts the specified number of worker threads. With zero workers, the paths are searched right when requested. */
+	void Start(int a_NumWorkers);
+
+	/** Stops the worker threads. The jobs still in the queue are finished as PATH_NOT_FOUND. */
+	void Stop(void);
+
+	/** Requests a path between the specified points for a mob of the specified size (see cPathFinder::GetNextWayPoint()).
+	Returns the job to poll, possibly one already finished or shared with other mobs.
+	The snapshot is taken from a_Blocks. To be called on the world thread only. */
+	cJobPtr RequestPath(cBlockSource & a_Blocks, const Vector3d & a_Source, const Vector3d & a_Destination, double a_Width, double a_Height);
+
+	/** Expires the old paths from the cache and forgets the sections copied during the last tick.
+	Called by the world once per tick. */
+	void Tick(void);
+
+	/** Returns the number of jobs waiting for a worker. */
+	size_t GetQueueLength(void);
+
+	/** Returns the table of solid block types used by the searches, 256 items. */
+	const bool * GetIsSolid(void) const { return m_IsSolid; }
+
+protected:
+
+	/** The key of the path cache. */
+	struct sPathKey
+	{
+		Vector3i m_Source;
+		Vector3i m_Destination;
+		int m_Width;
+		int m_Height;
+
+		bool operator == (const sPathKey & a_Other) const
+		{
+			return (
+				(m_Source == a_Other.m_Source) && (m_Destination == a_Other.m_Destination) &&
+				(m_Width == a_Other.m_Width) && (m_Height == a_Other.m_Height)
+			);
+		}
+	} ;
+
+	struct sPathKeyHasher
+	{
+		size_t operator () (const sPathKey & a_Key) const
+		{
+			VectorHasher<int> Hasher;
+			return Hasher(a_Key.m_Source) ^ (Hasher(a_Key.m_Destination) * 31) ^ static_cast<size_t>(a_Key.m_Width * 7 + a_Key.m_Height);
+		}
+	} ;
+
+
+	/** A single thread running the searches. Each worker has its own cPathSearch. */
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+
+		cWorker(cPathFinderService & a_Parent);
+
+	protected:
+
+		cPathFinderService & m_Parent;
+
+		cPathSearch m_Search;
+
+		virtual void Execute(void) override;
+	} ;
+
+
+	/** For each block type, true if it is solid (cBlockInfo::IsSolid()); shared by all the searches. */
+	bool m_IsSolid[256];
+
+	/** The search used on the world thread when there are no workers. */
+	cPathSearch m_Search;
+
+	/** The planner of the long paths, used on the world thread only. */
+	cNavPlanner m_NavPlanner;
+
+	/** The mutex protecting m_Queue. */
+	cCriticalSection m_CS;
+
+	/** The jobs waiting for a worker. */
+	std::deque<cJobPtr> m_Queue;
+
+	/** Set when a job is queued, or to stop the workers. */
+	cEvent m_evtItemAdded;
+
+	/** Set when the workers should terminate. */
+	std::atomic<bool> m_ShouldTerminate;
+
+	/** The worker threads running the searches. */
+	std::vector<std::unique_ptr<cWorker>> m_Workers;
+
+	/** The number of times Tick() has been called. Used on the world thread only. */
+	Int64 m_CurrentTick;
+
+	/** The recently requested jobs, by their source, destination and mob size. Used on the world thread only. */
+	std::unordered_map<sPathKey, cJobPtr, sPathKeyHasher> m_PathCache;
+
+	/** The sections copied during the current tick, by (ChunkX, SectionNum, ChunkZ); nullptr for all-air sections.
+	Used on the world thread only. */
+	std::unordered_map<Vector3i, cPathSnapshot::cSectionPtr, VectorHasher<int>> m_TickSections;
+
+
+	/** Copies the sections around the source and the destination into a new snapshot. */
+	std::unique_ptr<cPathSnapshot> TakeSnapshot(cBlockSource & a_Blocks, const Vector3i & a_Source, const Vector3i & a_Destination);
+
+	/** Returns the copy of the specified section of an available chunk from m_TickSections, copying it first if not there yet. */
+	cPathSnapshot::cSectionPtr GetTickSection(cBlockSource & a_Blocks, int a_ChunkX, int a_SectionNum, int a_ChunkZ);
+
+	/** Runs the search of the job, using the specified search object, and marks the job done. */
+	static void RunJob(cJob & a_Job, cPathSearch & a_Search);
+
+	/** Blocks until there's a job for the worker, then takes it out of the queue.
+	Returns nullptr if the workers should terminate. */
+	cJobPtr DequeueJob(void);
+} ;
+
+
+
+
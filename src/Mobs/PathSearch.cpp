@@ -0,0 +1,862 @@
+
+// PathSearch.cpp
+
+// Implements the cPathSnapshot class representing an immutable copy of the blocks around a path request,
+// and the cPathSearch class that runs A* over such a snapshot
+
+#include "Globals.h"
+
+#include "PathSearch.h"
+#include "../Defines.h"
+#include "../FastRandom.h"
+
+#define JUMP_G_COST 20
+#define NORMAL_G_COST 10
+#define DIAGONAL_G_COST 14
+
+#define DISTANCE_MANHATTAN 0  // 1: More speed, a bit less accuracy 0: Max accuracy, less speed.
+#define HEURISTICS_ONLY 0  // 1: Much more speed, much less accurate.
+// The only version which guarantees the shortest path is 0, 0.
+
+/** The initial number of slots in the hash table, a power of two; enough for the usual searches. */
+#define INITIAL_NUM_SLOTS 1024
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPathSnapshot:
+
+cPathSnapshot::cPathSnapshot(int a_MinChunkX, int a_MinChunkZ, int a_SizeX, int a_SizeZ, int a_MinSection, int a_NumSections) :
+	m_MinChunkX(a_MinChunkX),
+	m_MinChunkZ(a_MinChunkZ),
+	m_SizeX(a_SizeX),
+	m_SizeZ(a_SizeZ),
+	m_MinSection(a_MinSection),
+	m_NumSections(a_NumSections),
+	m_Sections(static_cast<size_t>(a_SizeX * a_SizeZ * a_NumSections)),
+	m_IsChunkAvailable(static_cast<size_t>(a_SizeX * a_SizeZ), false)
+{
+	ASSERT((a_SizeX > 0) && (a_SizeZ > 0));
+	ASSERT((a_MinSection >= 0) && (a_NumSections > 0) && (a_MinSection + a_NumSections <= static_cast<int>(cChunkData::NumSections)));
+}
+
+
+
+
+
+void cPathSnapshot::SetSection(int a_ChunkX, int a_SectionNum, int a_ChunkZ, cSectionPtr a_Section)
+{
+	int RelChunkX = a_ChunkX - m_MinChunkX;
+	int RelChunkZ = a_ChunkZ - m_MinChunkZ;
+	int RelSection = a_SectionNum - m_MinSection;
+	ASSERT((RelChunkX >= 0) && (RelChunkX < m_SizeX));
+	ASSERT((RelChunkZ >= 0) && (RelChunkZ < m_SizeZ));
+	ASSERT((RelSection >= 0) && (RelSection < m_NumSections));
+	m_Sections[static_cast<size_t>(RelSection + m_NumSections * (RelChunkX + m_SizeX * RelChunkZ))] = std::move(a_Section);
+	m_IsChunkAvailable[static_cast<size_t>(RelChunkX + m_SizeX * RelChunkZ)] = true;
+}
+
+
+
+
+
+void cPathSnapshot::SetChunkAvailable(int a_ChunkX, int a_ChunkZ)
+{
+	int RelChunkX = a_ChunkX - m_MinChunkX;
+	int RelChunkZ = a_ChunkZ - m_MinChunkZ;
+	ASSERT((RelChunkX >= 0) && (RelChunkX < m_SizeX));
+	ASSERT((RelChunkZ >= 0) && (RelChunkZ < m_SizeZ));
+	m_IsChunkAvailable[static_cast<size_t>(RelChunkX + m_SizeX * RelChunkZ)] = true;
+}
+
+
+
+
+
+bool cPathSnapshot::GetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const
+{
+	ASSERT(IsInBox(a_BlockX, a_BlockY, a_BlockZ));
+
+	int ChunkX, ChunkZ;
+	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
+	int RelChunkX = ChunkX - m_MinChunkX;
+	int RelChunkZ = ChunkZ - m_MinChunkZ;
+	if (!m_IsChunkAvailable[static_cast<size_t>(RelChunkX + m_SizeX * RelChunkZ)])
+	{
+		return false;
+	}
+
+	int RelSection = a_BlockY / cChunkData::SectionHeight - m_MinSection;
+	const auto & Section = m_Sections[static_cast<size_t>(RelSection + m_NumSections * (RelChunkX + m_SizeX * RelChunkZ))];
+	if (Section == nullptr)
+	{
+		a_BlockType = E_BLOCK_AIR;
+		a_BlockMeta = 0;
+		return true;
+	}
+	int Index = cChunkDef::MakeIndexNoCheck(
+		a_BlockX - ChunkX * cChunkDef::Width,
+		a_BlockY % cChunkData::SectionHeight,
+		a_BlockZ - ChunkZ * cChunkDef::Width
+	);
+	a_BlockType = Section->m_BlockTypes[Index];
+	a_BlockMeta = (Section->m_BlockMetas[Index / 2] >> ((Index & 1) * 4)) & 0x0f;
+	return true;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPathSearch:
+
+cPathSearch::cPathSearch(const bool * a_IsSolid) :
+	m_IsSolid(a_IsSolid),
+	m_Snapshot(nullptr),
+	m_BoundingBoxWidth(1),
+	m_BoundingBoxHeight(2),
+	m_NearestPointToTarget(NO_CELL),
+	m_BadChunkFound(false),
+	m_Result(nullptr),
+	m_Slots(INITIAL_NUM_SLOTS),
+	m_SlotStamps(INITIAL_NUM_SLOTS, 0),
+	m_CurrentStamp(0),
+	m_MinBucket(std::numeric_limits<size_t>::max()),
+	m_NumUsedBuckets(0)
+{
+}
+
+
+
+
+
+void cPathSearch::Search(
+	const cPathSnapshot & a_Snapshot,
+	const Vector3i & a_Source, const Vector3i & a_Destination, int a_MaxCalculations,
+	int a_BoundingBoxWidth, int a_BoundingBoxHeight,
+	sResult & a_Result
+)
+{
+	m_Snapshot = &a_Snapshot;
+	m_Source = a_Source;
+	m_Destination = a_Destination;
+	m_BoundingBoxWidth = a_BoundingBoxWidth;
+	m_BoundingBoxHeight = a_BoundingBoxHeight;
+	m_BadChunkFound = false;
+	m_Result = &a_Result;
+	m_Result->m_Destination = a_Destination;
+	m_Result->m_PathPoints.clear();
+	Reset();
+
+	if (!IsWalkable(m_Source, m_Source))
+	{
+		m_Result->m_Status = ePathFinderStatus::PATH_NOT_FOUND;
+		return;
+	}
+
+	m_NearestPointToTarget = GetCell(m_Source);
+	ProcessCell(GetCell(m_Source), NO_CELL, 0);
+
+	bool IsFinished = false;
+	for (int i = 0; i < a_MaxCalculations; ++i)
+	{
+		if (m_BadChunkFound || StepOnce())  // StepOnce returns true when no more calculation is needed.
+		{
+			IsFinished = true;
+			break;
+		}
+	}
+	if (!IsFinished)
+	{
+		// Out of calculations, settle for the nearest point found so far:
+		AttemptToFindAlternative();
+	}
+
+	if (m_BadChunkFound)
+	{
+		m_Result->m_Status = ePathFinderStatus::PATH_NOT_FOUND;
+		m_Result->m_PathPoints.clear();
+	}
+	m_Snapshot = nullptr;
+	m_Result = nullptr;
+}
+
+
+
+
+
+void cPathSearch::Reset(void)
+{
+	m_Cells.clear();
+
+	// Invalidate all the slots by bumping the stamp; clear them for real only when the stamp wraps around:
+	m_CurrentStamp += 1;
+	if (m_CurrentStamp == 0)
+	{
+		std::fill(m_SlotStamps.begin(), m_SlotStamps.end(), 0);
+		m_CurrentStamp = 1;
+	}
+
+	for (size_t i = 0; i < m_NumUsedBuckets; i++)
+	{
+		m_Buckets[i].clear();
+	}
+	m_NumUsedBuckets = 0;
+	m_MinBucket = std::numeric_limits<size_t>::max();
+}
+
+
+
+
+
+bool cPathSearch::StepOnce(void)
+{
+	UInt32 CurrentCell = OpenListPop();
+
+	// Path not reachable.
+	if (CurrentCell == NO_CELL)
+	{
+		AttemptToFindAlternative();
+		return true;
+	}
+
+	// The cell indices stay valid, but the arena may be reallocated by GetCell(), so keep a copy of the location:
+	const Vector3i Location = m_Cells[CurrentCell].m_Location;
+
+	// Path found.
+	if (Location == m_Destination)
+	{
+		BuildPath();
+		m_Result->m_Status = ePathFinderStatus::PATH_FOUND;
+		return true;
+	}
+
+	// Calculation not finished yet
+	// Check if we have a new NearestPoint.
+	if ((m_Destination - Location).Length() < 5)
+	{
+		if (GetRandomProvider().RandBool(0.25))
+		{
+			m_NearestPointToTarget = CurrentCell;
+		}
+	}
+	else if (m_Cells[CurrentCell].m_H < m_Cells[m_NearestPointToTarget].m_H)
+	{
+		m_NearestPointToTarget = CurrentCell;
+	}
+	// process a currentCell by inspecting all neighbors.
+
+
+	// Now we start checking adjacent cells.
+
+
+	// If true, no need to do more checks in that direction
+	bool DoneEast = false,
+	DoneWest = false,
+	DoneNorth = false,
+	DoneSouth = false;
+
+	// If true, we can walk in that direction without changing height
+	// This is used for deciding if to calculate diagonals
+	bool WalkableEast = false,
+	WalkableWest = false,
+	WalkableNorth = false,
+	WalkableSouth = false;
+
+	// If we can jump without hitting the ceiling
+	if (BodyFitsIn(Location + Vector3i(0, 1, 0), Location))
+	{
+		// For ladder climbing
+		ProcessIfWalkable(Location + Vector3i(0, 1, 0), CurrentCell, JUMP_G_COST);
+
+		// Check east-up
+		if (ProcessIfWalkable(Location + Vector3i(1, 1, 0), CurrentCell, JUMP_G_COST))
+		{
+			DoneEast = true;
+		}
+
+		// Check west-up
+		if (ProcessIfWalkable(Location + Vector3i(-1, 1, 0), CurrentCell, JUMP_G_COST))
+		{
+			DoneWest = true;
+		}
+
+		// Check north-up
+		if (ProcessIfWalkable(Location + Vector3i(0, 1, -1), CurrentCell, JUMP_G_COST))
+		{
+			DoneNorth = true;
+		}
+
+		// Check south-up
+		if (ProcessIfWalkable(Location + Vector3i(0, 1, 1), CurrentCell, JUMP_G_COST))
+		{
+			DoneSouth = true;
+		}
+
+	}
+
+
+	// Check North, South, East, West at our own height or below. We are willing to jump up to 3 blocks down.
+
+
+	if (!DoneEast)
+	{
+		for (int y = 0; y >= -3; --y)
+		{
+			if (ProcessIfWalkable(Location + Vector3i(1, y, 0),  CurrentCell, NORMAL_G_COST))
+			{
+				DoneEast = true;
+				if (y == 0)
+				{
+					WalkableEast = true;
+				}
+				break;
+			}
+		}
+	}
+
+	if (!DoneWest)
+	{
+		for (int y = 0; y >= -3; --y)
+		{
+			if (ProcessIfWalkable(Location + Vector3i(-1, y, 0),  CurrentCell, NORMAL_G_COST))
+			{
+				DoneWest = true;
+				if (y == 0)
+				{
+					WalkableWest = true;
+				}
+				break;
+			}
+		}
+	}
+
+	if (!DoneSouth)
+	{
+		for (int y = 0; y >= -3; --y)
+		{
+			if (ProcessIfWalkable(Location + Vector3i(0, y, 1),  CurrentCell, NORMAL_G_COST))
+			{
+				DoneSouth = true;
+				if (y == 0)
+				{
+					WalkableSouth = true;
+				}
+				break;
+			}
+		}
+	}
+
+	if (!DoneNorth)
+	{
+		for (int y = 0; y >= -3; --y)
+		{
+			if (ProcessIfWalkable(Location + Vector3i(0, y, -1), CurrentCell, NORMAL_G_COST))
+			{
+				DoneNorth = true;
+				if (y == 0)
+				{
+					WalkableNorth = true;
+				}
+				break;
+			}
+		}
+	}
+
+	// Check diagonals
+
+	if (WalkableNorth && WalkableEast)
+	{
+		ProcessIfWalkable(Location + Vector3i(1, 0, -1), CurrentCell, DIAGONAL_G_COST);
+	}
+	if (WalkableNorth && WalkableWest)
+	{
+		ProcessIfWalkable(Location + Vector3i(-1, 0, -1), CurrentCell, DIAGONAL_G_COST);
+	}
+	if (WalkableSouth && WalkableEast)
+	{
+		ProcessIfWalkable(Location + Vector3i(1, 0, 1), CurrentCell, DIAGONAL_G_COST);
+	}
+	if (WalkableSouth && WalkableWest)
+	{
+		ProcessIfWalkable(Location + Vector3i(-1, 0, 1), CurrentCell, DIAGONAL_G_COST);
+	}
+
+	return false;
+}
+
+
+
+
+
+void cPathSearch::AttemptToFindAlternative(void)
+{
+	if (m_NearestPointToTarget == GetCell(m_Source))
+	{
+		m_Result->m_Status = ePathFinderStatus::PATH_NOT_FOUND;
+	}
+	else
+	{
+		m_Destination = m_Cells[m_NearestPointToTarget].m_Location;
+		m_Result->m_Destination = m_Destination;
+		BuildPath();
+		m_Result->m_Status = ePathFinderStatus::NEARBY_FOUND;
+	}
+}
+
+
+
+
+
+void cPathSearch::BuildPath(void)
+{
+	UInt32 CurrentCell = GetCell(m_Destination);
+	while (m_Cells[CurrentCell].m_Parent != NO_CELL)
+	{
+		// Waypoints are cylinders that start at some particular x, y, z and have infinite height.
+		// Submerging water waypoints allows swimming mobs to be able to touch them.
+		Vector3i Location = m_Cells[CurrentCell].m_Location;
+		if (IsBlockWater(m_Cells[GetCell(Location + Vector3i(0, -1, 0))].m_BlockType))
+		{
+			Location.y -= 30;
+		}
+		m_Result->m_PathPoints.push_back(Location);  // Populate the path with points. All midpoints are added. Destination is added. Source is excluded.
+		CurrentCell = m_Cells[CurrentCell].m_Parent;
+	}
+}
+
+
+
+
+
+void cPathSearch::OpenListAdd(UInt32 a_Cell)
+{
+	cPathCell & Cell = m_Cells[a_Cell];
+	Cell.m_Status = eCellStatus::OPENLIST;
+	size_t Bucket = static_cast<size_t>(std::max(Cell.m_F, 0));
+	if (Bucket >= m_Buckets.size())
+	{
+		m_Buckets.resize(Bucket + 1);
+	}
+	m_Buckets[Bucket].push_back(a_Cell);
+	m_MinBucket = std::min(m_MinBucket, Bucket);
+	m_NumUsedBuckets = std::max(m_NumUsedBuckets, Bucket + 1);
+	#ifdef COMPILING_PATHFIND_DEBUGGER
+	si::setBlock(Cell.m_Location.x, Cell.m_Location.y, Cell.m_Location.z, debug_open, SetMini(&Cell));
+	#endif
+}
+
+
+
+
+
+UInt32 cPathSearch::OpenListPop(void)  // Popping from the open list also means adding to the closed list.
+{
+	for (; m_MinBucket < m_NumUsedBuckets; ++m_MinBucket)
+	{
+		auto & Bucket = m_Buckets[m_MinBucket];
+		while (!Bucket.empty())
+		{
+			UInt32 Ret = Bucket.back();
+			Bucket.pop_back();
+			cPathCell & Cell = m_Cells[Ret];
+			if ((Cell.m_Status != eCellStatus::OPENLIST) || (static_cast<size_t>(std::max(Cell.m_F, 0)) != m_MinBucket))
+			{
+				// A stale entry, the cell has been improved and pushed into a lower bucket since
+				continue;
+			}
+			Cell.m_Status = eCellStatus::CLOSEDLIST;
+			#ifdef COMPILING_PATHFIND_DEBUGGER
+			si::setBlock(Cell.m_Location.x, Cell.m_Location.y, Cell.m_Location.z, debug_closed, SetMini(&Cell));
+			#endif
+			return Ret;
+		}
+	}
+
+	return NO_CELL;  // We've exhausted the search space and nothing was found, this will trigger a PATH_NOT_FOUND or NEARBY_FOUND status.
+}
+
+
+
+
+
+bool cPathSearch::ProcessIfWalkable(const Vector3i & a_Location, UInt32 a_Parent, int a_Cost)
+{
+	if (IsWalkable(a_Location, m_Cells[a_Parent].m_Location))
+	{
+		ProcessCell(GetCell(a_Location), a_Parent, a_Cost);
+		return true;
+	}
+	return false;
+}
+
+
+
+
+
+void cPathSearch::ProcessCell(UInt32 a_Cell, UInt32 a_Caller, int a_GDelta)
+{
+	cPathCell & Cell = m_Cells[a_Cell];
+
+	// Case 1: Cell is in the closed list, ignore it.
+	if (Cell.m_Status == eCellStatus::CLOSEDLIST)
+	{
+		return;
+	}
+	if (Cell.m_Status == eCellStatus::NOLIST)  // Case 2: The cell is not in any list.
+	{
+		// Cell is walkable, add it to the open list.
+		// Note that non-walkable cells are filtered out in StepOnce();
+		// Special case: Start cell goes here, gDelta is 0, caller is NO_CELL.
+		Cell.m_Parent = a_Caller;
+		if (a_Caller != NO_CELL)
+		{
+			Cell.m_G = m_Cells[a_Caller].m_G + a_GDelta;
+		}
+		else
+		{
+			Cell.m_G = 0;
+		}
+
+		// Calculate H. This is A*'s Heuristics value.
+		#if DISTANCE_MANHATTAN == 1
+			// Manhattan distance. DeltaX + DeltaY + DeltaZ.
+			Cell.m_H = 10 * (abs(Cell.m_Location.x - m_Destination.x) + abs(Cell.m_Location.y - m_Destination.y) + abs(Cell.m_Location.z - m_Destination.z));
+		#else
+			// Euclidian distance. sqrt(DeltaX^2 + DeltaY^2 + DeltaZ^2), more precise.
+			Cell.m_H = static_cast<decltype(Cell.m_H)>((Cell.m_Location - m_Destination).Length() * 10);
+		#endif
+
+		#if HEURISTICS_ONLY == 1
+			Cell.m_F = Cell.m_H;  // Greedy search. https://en.wikipedia.org/wiki/Greedy_search
+		#else
+			Cell.m_F = Cell.m_H + Cell.m_G;  // Regular A*.
+		#endif
+
+		OpenListAdd(a_Cell);
+		return;
+	}
+
+	// Case 3: Cell is in the open list, check if G needs an update.
+	int NewG = m_Cells[a_Caller].m_G + a_GDelta;
+	if (NewG < Cell.m_G)
+	{
+		Cell.m_G = NewG;
+		#if HEURISTICS_ONLY == 0
+			Cell.m_F = Cell.m_H + Cell.m_G;
+		#endif
+		Cell.m_Parent = a_Caller;
+
+		// Move the cell into its new bucket, the entry in the old one becomes stale:
+		OpenListAdd(a_Cell);
+	}
+}
+
+
+
+
+
+void cPathSearch::FillCellAttributes(UInt32 a_Cell)
+{
+	const Vector3i Location = m_Cells[a_Cell].m_Location;
+
+	ASSERT(m_Snapshot != nullptr);
+
+	if (!cChunkDef::IsValidHeight(Location.y))
+	{
+		// Players can't build outside the game height, so it must be air
+		cPathCell & Cell = m_Cells[a_Cell];
+		Cell.m_IsSolid = false;
+		Cell.m_IsSpecial = false;
+		Cell.m_BlockType = E_BLOCK_AIR;
+		Cell.m_BlockMeta = 0;
+		return;
+	}
+
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta;
+	if (!m_Snapshot->IsInBox(Location.x, Location.y, Location.z))
+	{
+		// Out of the snapshot, the path may not lead there. The cells beside and above the box act as walls, but below
+		// the box they'd be a floor that may not be there. The fence check below doesn't create cells, so the only cells
+		// created below the box are those that the walkability of a cell at the box's bottom depends on; the search
+		// fails for them instead, as it does for an unloaded chunk:
+		if (Location.y < m_Snapshot->GetMinSection() * cChunkData::SectionHeight)
+		{
+			m_BadChunkFound = true;
+		}
+		cPathCell & Cell = m_Cells[a_Cell];
+		Cell.m_IsSolid = true;
+		Cell.m_IsSpecial = false;
+		Cell.m_BlockType = E_BLOCK_AIR;  // m_BlockType is never used when m_IsSpecial is false, but it may be used if we implement dijkstra
+		Cell.m_BlockMeta = 0;
+		return;
+	}
+	if (!m_Snapshot->GetBlock(Location.x, Location.y, Location.z, BlockType, BlockMeta))
+	{
+		m_BadChunkFound = true;
+		cPathCell & Cell = m_Cells[a_Cell];
+		Cell.m_IsSolid = true;
+		Cell.m_IsSpecial = false;
+		Cell.m_BlockType = E_BLOCK_AIR;  // m_BlockType is never used when m_IsSpecial is false, but it may be used if we implement dijkstra
+		Cell.m_BlockMeta = 0;
+		return;
+	}
+
+	bool IsSpecial;
+	bool IsSolid;
+	if (BlockTypeIsSpecial(BlockType))
+	{
+		IsSpecial = true;
+		IsSolid = true;  // Specials are solids only from a certain direction. But their m_IsSolid is always true
+	}
+	else if (!m_IsSolid[BlockType] && IsFenceBelow(Location))
+	{
+		// Nonsolid blocks with fences below them are consider Special Solids. That is, they sometimes behave as solids.
+		IsSpecial = true;
+		IsSolid = true;
+	}
+	else
+	{
+		IsSpecial = false;
+		IsSolid = m_IsSolid[BlockType];
+	}
+
+	cPathCell & Cell = m_Cells[a_Cell];
+	Cell.m_BlockType = BlockType;
+	Cell.m_BlockMeta = BlockMeta;
+	Cell.m_IsSpecial = IsSpecial;
+	Cell.m_IsSolid = IsSolid;
+}
+
+
+
+
+
+bool cPathSearch::IsFenceBelow(const Vector3i & a_Location) const
+{
+	// Read the snapshot directly, rather than through GetCell(), which would fill the cells down the whole air column
+	// below a_Location and hit the bottom of the snapshot for no reason. Out of the box, the block is not a fence:
+	const int BelowY = a_Location.y - 1;
+	if (!cChunkDef::IsValidHeight(BelowY) || !m_Snapshot->IsInBox(a_Location.x, BelowY, a_Location.z))
+	{
+		return false;
+	}
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta;
+	return (
+		m_Snapshot->GetBlock(a_Location.x, BelowY, a_Location.z, BlockType, BlockMeta) &&
+		IsBlockFence(BlockType)
+	);
+}
+
+
+
+
+
+UInt32 cPathSearch::GetCell(const Vector3i & a_Location)
+{
+	size_t Mask = m_Slots.size() - 1;
+	size_t Slot = HashLocation(a_Location) & Mask;
+	while (m_SlotStamps[Slot] == m_CurrentStamp)
+	{
+		if (m_Cells[m_Slots[Slot]].m_Location == a_Location)
+		{
+			return m_Slots[Slot];
+		}
+		Slot = (Slot + 1) & Mask;
+	}
+
+	// The cell is not in the arena, we've never checked this cell before. Keep the table at most half full:
+	if (m_Cells.size() * 2 >= m_Slots.size())
+	{
+		GrowSlots();
+		Mask = m_Slots.size() - 1;
+		Slot = HashLocation(a_Location) & Mask;
+		while (m_SlotStamps[Slot] == m_CurrentStamp)
+		{
+			Slot = (Slot + 1) & Mask;
+		}
+	}
+
+	UInt32 Index = static_cast<UInt32>(m_Cells.size());
+	m_Cells.emplace_back();
+	cPathCell & Cell = m_Cells.back();
+	Cell.m_Location = a_Location;
+	Cell.m_Status = eCellStatus::NOLIST;
+	Cell.m_Parent = NO_CELL;
+	Cell.m_F = Cell.m_G = Cell.m_H = 0;
+	m_Slots[Slot] = Index;
+	m_SlotStamps[Slot] = m_CurrentStamp;
+
+	FillCellAttributes(Index);
+	#ifdef COMPILING_PATHFIND_DEBUGGER
+		#ifdef COMPILING_PATHFIND_DEBUGGER_MARK_UNCHECKED
+			si::setBlock(a_Location.x, a_Location.y, a_Location.z, debug_unchecked, m_Cells[Index].m_IsSolid ? NORMAL : MINI);
+		#endif
+	#endif
+	return Index;
+}
+
+
+
+
+
+void cPathSearch::GrowSlots(void)
+{
+	size_t NumSlots = m_Slots.size() * 2;
+	m_Slots.assign(NumSlots, 0);
+	m_SlotStamps.assign(NumSlots, 0);
+	m_CurrentStamp = 1;
+
+	size_t Mask = NumSlots - 1;
+	for (size_t i = 0; i < m_Cells.size(); i++)
+	{
+		size_t Slot = HashLocation(m_Cells[i].m_Location) & Mask;
+		while (m_SlotStamps[Slot] == m_CurrentStamp)
+		{
+			Slot = (Slot + 1) & Mask;
+		}
+		m_Slots[Slot] = static_cast<UInt32>(i);
+		m_SlotStamps[Slot] = m_CurrentStamp;
+	}
+}
+
+
+
+
+
+bool cPathSearch::IsWalkable(const Vector3i & a_Location, const Vector3i & a_Source)
+{
+	return (HasSolidBelow(a_Location) && BodyFitsIn(a_Location, a_Source));
+}
+
+
+
+
+// We need the source because some special blocks are solid only from a certain direction e.g. doors
+bool cPathSearch::BodyFitsIn(const Vector3i & a_Location, const Vector3i & a_Source)
+{
+	int x, y, z;
+	for (y = 0; y < m_BoundingBoxHeight; ++y)
+	{
+		for (x = 0; x < m_BoundingBoxWidth; ++x)
+		{
+			for (z = 0; z < m_BoundingBoxWidth; ++z)
+			{
+				const cPathCell & CurrentCell = m_Cells[GetCell(a_Location + Vector3i(x, y, z))];
+				if (CurrentCell.m_IsSolid)
+				{
+					if (CurrentCell.m_IsSpecial)
+					{
+						if (SpecialIsSolidFromThisDirection(CurrentCell.m_BlockType, CurrentCell.m_BlockMeta, a_Location - a_Source))
+						{
+							return false;
+						}
+					}
+					else
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+
+
+
+
+bool cPathSearch::BlockTypeIsSpecial(BLOCKTYPE a_Type)
+{
+	if (IsBlockFence(a_Type))
+	{
+		return true;
+	}
+
+	switch (a_Type)
+	{
+		case E_BLOCK_OAK_DOOR:
+		case E_BLOCK_DARK_OAK_DOOR:
+		case E_BLOCK_TRAPDOOR:
+		case E_BLOCK_WATER:
+		case E_BLOCK_STATIONARY_WATER:
+		{
+			return true;
+		}
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+
+
+
+
+bool cPathSearch::SpecialIsSolidFromThisDirection(BLOCKTYPE a_Type, NIBBLETYPE a_Meta,  const Vector3i & a_Direction)
+{
+	if (a_Direction == Vector3i(0, 0, 0))
+	{
+		return false;
+	}
+
+
+	// If there is a nonsolid above a fence
+	if (!m_IsSolid[a_Type])
+	{
+			// If we're coming from below
+			if (a_Direction.y > 0)
+			{
+				return true;  // treat the nonsolid as solid
+			}
+			else
+			{
+				return false;  // Treat it as a nonsolid because we are not coming from below
+			}
+	}
+
+	/* switch (a_Type)
+	{
+		case E_BLOCK_ETC:
+		{
+			Decide if solid from this direction and return either true or false.
+		}
+
+		// TODO Fill this with the other specials after physics is fixed
+	} */
+
+
+
+	return true;
+}
+
+
+
+
+
+bool cPathSearch::HasSolidBelow(const Vector3i & a_Location)
+{
+	int x, z;
+	for (x = 0; x < m_BoundingBoxWidth; ++x)
+	{
+		for (z = 0; z < m_BoundingBoxWidth; ++z)
+		{
+			if (m_Cells[GetCell(a_Location + Vector3i(x, -1, z))].m_IsSolid)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+
+
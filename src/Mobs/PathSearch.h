@@ -0,0 +1,266 @@
+
+// PathSearch.h
+
+// Declares the cPathSnapshot class representing an immutable copy of the blocks around a path request,
+// and the cPathSearch class that runs A* over such a snapshot
+
+/*
+The search doesn't touch cWorld or cChunk at all, so that it can run on the cPathFinderService's worker threads
+while the world keeps ticking. The world thread copies the needed chunk sections into a cPathSnapshot when the path
+is requested; the sections are shared (read-only) by all the snapshots taken during the same tick.
+
+Each worker owns one cPathSearch and reuses it for all of its searches. The cells are kept in an arena that is
+only cleared, not freed, between the searches, and they are looked up through an open-addressing hash table
+whose slots are invalidated by bumping a stamp instead of clearing them. The open list is a bucket queue indexed
+by the cells' F value; an improved cell is simply pushed again into its new bucket and the stale entry is skipped
+when popped.
+*/
+
+
+
+
+
+#pragma once
+
+#include "Path.h"
+#include "../ChunkData.h"
+#ifdef COMPILING_PATHFIND_DEBUGGER
+	/* Note: the COMPILING_PATHFIND_DEBUGGER flag is used by Native / WiseOldMan95 to debug
+	this class outside of Cuberite. This preprocessor flag is never set when compiling Cuberite. */
+	#include "PathFinderIrrlicht_Head.h"
+#endif
+
+
+
+
+
+/** An immutable copy of the blocks of the chunk sections around a path request. */
+class cPathSnapshot
+{
+public:
+
+	/** A copy of the block types and metas of a single chunk section, indexed the same way as cChunkData::sChunkSection. */
+	struct sSection
+	{
+		BLOCKTYPE  m_BlockTypes[cChunkData::SectionBlockCount];
+		NIBBLETYPE m_BlockMetas[cChunkData::SectionNibbleCount];
+	} ;
+
+	typedef std::shared_ptr<const sSection> cSectionPtr;
+
+
+	/** Creates a snapshot of the specified box of chunks and sections, with all the chunks unavailable.
+	The owner is expected to fill in the available chunks' sections using SetSection() / SetChunkAvailable(). */
+	cPathSnapshot(int a_MinChunkX, int a_MinChunkZ, int a_SizeX, int a_SizeZ, int a_MinSection, int a_NumSections);
+
+	/** Sets the specified section; nullptr means the section is all air. Marks the chunk as available. */
+	void SetSection(int a_ChunkX, int a_SectionNum, int a_ChunkZ, cSectionPtr a_Section);
+
+	/** Marks the chunk as available. Its sections that are not set are all air. */
+	void SetChunkAvailable(int a_ChunkX, int a_ChunkZ);
+
+	/** Returns true if the specified block is inside the box of this snapshot. */
+	bool IsInBox(int a_BlockX, int a_BlockY, int a_BlockZ) const
+	{
+		int ChunkX, ChunkZ;
+		cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
+		int SectionNum = a_BlockY / cChunkData::SectionHeight;
+		return (
+			(a_BlockY >= 0) &&
+			(ChunkX >= m_MinChunkX) && (ChunkX < m_MinChunkX + m_SizeX) &&
+			(ChunkZ >= m_MinChunkZ) && (ChunkZ < m_MinChunkZ + m_SizeZ) &&
+			(SectionNum >= m_MinSection) && (SectionNum < m_MinSection + m_NumSections)
+		);
+	}
+
+	/** Reads the specified block, which must be inside the box.
+	Returns false if the block's chunk is not available (was not loaded when the snapshot was taken). */
+	bool GetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const;
+
+	/** Returns the box of the snapshot, in chunks and sections. */
+	int GetMinChunkX(void) const { return m_MinChunkX; }
+	int GetMinChunkZ(void) const { return m_MinChunkZ; }
+	int GetSizeX(void) const { return m_SizeX; }
+	int GetSizeZ(void) const { return m_SizeZ; }
+	int GetMinSection(void) const { return m_MinSection; }
+	int GetNumSections(void) const { return m_NumSections; }
+
+protected:
+
+	int m_MinChunkX, m_MinChunkZ;
+	int m_SizeX, m_SizeZ;
+	int m_MinSection, m_NumSections;
+
+	/** The sections, indexed by [Section + NumSections * (ChunkX + SizeX * ChunkZ)], all relative to the box. nullptr if all air. */
+	std::vector<cSectionPtr> m_Sections;
+
+	/** Whether each chunk of the box was available, indexed by [ChunkX + SizeX * ChunkZ], relative to the box. */
+	std::vector<bool> m_IsChunkAvailable;
+} ;
+
+
+
+
+
+/* Various little structs and classes */
+enum class eCellStatus {OPENLIST,  CLOSEDLIST,  NOLIST};
+
+/** The pathfinder has 3 types of cells (cPathCell).
+1 - empty. m_IsSolid is false, m_IsSpecial is false.  Air cells are always traversable by A*.
+2 - occupied / solid. m_IsSolid is true, m_IsSpecial is false.  Air cells are never traversable by A*.
+3 - Special. m_IsSolid is true, m_IsSpecial is true. These cells are special: They may either behave as empty
+or as occupied / solid, depending on the mob's direction of movement. For instance, an airblock above a fence is a special cell,
+because when mobs attempt to travel to it by jumping, it acts as a solid. But when mobs fall and land on top of a fence,
+it acts as air. Special cells include: Doors, ladders, trapdoors, water, gates.
+
+The main function which handles special blocks is SpecialIsSolidFromThisDirection.
+This function receives a BlockType, a meta, and a direction of travel,
+then it uses those 3 parameters to decide whether the special block should behave as a solid or as air in this
+particular direction of travel.
+
+Currently, only fences and water are handled properly. The function always returns "true" (meaning: treat as occuiped/solid) for
+the rest of the blocks. This will be fixed once the physics engine issues are fixed. */
+struct cPathCell
+{
+	Vector3i m_Location;   // Location of the cell in the world.
+	int m_F, m_G, m_H;  // F, G, H as defined in regular A*.
+	eCellStatus m_Status;  // Which list is the cell in? Either non, open, or closed.
+	UInt32 m_Parent;  // Index of the cell's parent in the arena, as defined in regular A*. NO_CELL for the start cell.
+	bool m_IsSolid;	   // Is the cell an air or a solid? Partial solids are considered solids. If m_IsSpecial is true, this is always true.
+	bool m_IsSpecial;  // The cell is special - it acts as "solid" or "air" depending on direction, e.g. door or top of fence.
+	BLOCKTYPE m_BlockType;
+	NIBBLETYPE m_BlockMeta;
+};
+
+
+
+
+
+class cPathSearch
+{
+public:
+
+	/** The result of a single search. */
+	struct sResult
+	{
+		/** PATH_FOUND, NEARBY_FOUND or PATH_NOT_FOUND. */
+		ePathFinderStatus m_Status;
+
+		/** The destination cell; for NEARBY_FOUND, the nearby cell the path leads to instead. */
+		Vector3i m_Destination;
+
+		/** The waypoints, from the destination backwards; the source is excluded. Empty unless a path was found. */
+		std::vector<Vector3i> m_PathPoints;
+	} ;
+
+
+	/** The value of cPathCell::m_Parent for cells without a parent. */
+	static const UInt32 NO_CELL = 0xffffffff;
+
+
+	/** Creates a search that uses the specified table of solid block types (cBlockInfo::IsSolid(), 256 items).
+	The table is not copied, it needs to outlive the search. */
+	cPathSearch(const bool * a_IsSolid);
+
+	/** Searches for a path between the cells, within a_Snapshot, expanding at most a_MaxCalculations cells.
+	The cells are "the block where the mob's knees are at". The result is written into a_Result.
+	Any cell of an unavailable chunk makes the search fail, the same way as an unloaded chunk did in the world;
+	the cells outside the snapshot's box are treated as solid. */
+	void Search(
+		const cPathSnapshot & a_Snapshot,
+		const Vector3i & a_Source, const Vector3i & a_Destination, int a_MaxCalculations,
+		int a_BoundingBoxWidth, int a_BoundingBoxHeight,
+		sResult & a_Result
+	);
+
+	/** Returns the number of cells the arena can hold without reallocating; for the statistics and the tests. */
+	size_t GetArenaCapacity(void) const { return m_Cells.capacity(); }
+
+protected:
+
+	/** The table of solid block types. */
+	const bool * m_IsSolid;
+
+	/* Pathfinding fields, valid only inside Search() */
+	const cPathSnapshot * m_Snapshot;
+	Vector3i m_Destination;
+	Vector3i m_Source;
+	int m_BoundingBoxWidth;
+	int m_BoundingBoxHeight;
+	UInt32 m_NearestPointToTarget;
+	bool m_BadChunkFound;
+	sResult * m_Result;
+
+	/** The arena of the cells; cleared, but not freed, for each search. The cells refer to each other by their index. */
+	std::vector<cPathCell> m_Cells;
+
+	/** The hash table mapping locations to the cells' indices; open addressing, linear probing, size is a power of two. */
+	std::vector<UInt32> m_Slots;
+
+	/** The stamp of each slot in m_Slots; a slot is empty unless its stamp equals m_CurrentStamp. */
+	std::vector<UInt32> m_SlotStamps;
+
+	/** The stamp of the current search. */
+	UInt32 m_CurrentStamp;
+
+	/** The open list, the cell indices bucketed by their F value. Stale entries are skipped when popping. */
+	std::vector<std::vector<UInt32>> m_Buckets;
+
+	/** The lowest bucket that may be non-empty. */
+	size_t m_MinBucket;
+
+	/** The number of buckets used by the current search; only these need clearing for the next search. */
+	size_t m_NumUsedBuckets;
+
+
+	/** Resets the arena, the hash table and the open list for a new search. */
+	void Reset(void);
+
+	/** Expands a single cell; returns true if the search is finished. */
+	bool StepOnce(void);
+
+	void AttemptToFindAlternative(void);
+	void BuildPath(void);
+
+	/* Openlist and closedlist management */
+	void OpenListAdd(UInt32 a_Cell);
+	UInt32 OpenListPop(void);
+	bool ProcessIfWalkable(const Vector3i & a_Location, UInt32 a_Source, int a_Cost);
+
+	/* Map management */
+	void ProcessCell(UInt32 a_Cell, UInt32 a_Caller, int a_GDelta);
+
+	/** Returns the index of the cell at the specified location, creating and filling it if not there yet.
+	Note that this may reallocate the arena, invalidating any references to the cells. */
+	UInt32 GetCell(const Vector3i & a_Location);
+
+	/** Doubles the hash table, rehashing all the cells. */
+	void GrowSlots(void);
+
+	static size_t HashLocation(const Vector3i & a_Location)
+	{
+		return static_cast<size_t>(
+			static_cast<UInt32>(a_Location.x) * 73856093u ^
+			static_cast<UInt32>(a_Location.y) * 19349663u ^
+			static_cast<UInt32>(a_Location.z) * 83492791u
+		);
+	}
+
+	/* Interfacing with the snapshot */
+	void FillCellAttributes(UInt32 a_Cell);  // Query the snapshot and fill the cell with info
+	bool IsFenceBelow(const Vector3i & a_Location) const;  // Query the snapshot whether the block below is a fence, without creating cells
+
+	/* High level world queries */
+	bool IsWalkable(const Vector3i & a_Location, const Vector3i & a_Source);
+	bool BodyFitsIn(const Vector3i & a_Location, const Vector3i & a_Source);
+	bool BlockTypeIsSpecial(BLOCKTYPE a_Type);
+	bool SpecialIsSolidFromThisDirection(BLOCKTYPE a_Type, NIBBLETYPE a_Meta,  const Vector3i & a_Direction);
+	bool HasSolidBelow(const Vector3i & a_Location);
+	#ifdef COMPILING_PATHFIND_DEBUGGER
+	#include "../path_irrlicht.cpp"
+	#endif
+} ;
+
+
+
+
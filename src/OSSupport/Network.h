@@ -27,6 +27,7 @@ typedef std::shared_ptr<cX509Cert> cX509CertPtr;
 
 struct sockaddr_in;
 struct sockaddr_in6;
+class cSendChain;
 
 
 
@@ -81,6 +82,11 @@ public:
 		return Send(a_Data.data(), a_Data.size());
 	}
 
+	/** Queues all the data in the chain for sending to the remote peer, in a single operation.
+	The slices are referenced rather than copied where possible, and stay referenced until written to the socket.
+	Returns true on success, false on failure. Note that this success or failure only reports the queue status, not the actual data delivery. */
+	virtual bool Send(cSendChain & a_Chain) = 0;
+
 	/** Returns the IP address of the local endpoint of the connection. */
 	virtual AString GetLocalIP(void) const = 0;
 
@@ -93,6 +99,10 @@ public:
 	/** Returns the port used by the remote endpoint of the connection. */
 	virtual UInt16 GetRemotePort(void) const = 0;
 
+	/** Returns the number of bytes queued for sending that haven't been written to the socket yet.
+	Used for pacing the outgoing data to what the connection can take. Thread-safe. */
+	virtual size_t GetOutgoingDataSize(void) const = 0;
+
 	/** Closes the link gracefully.
 	The link will send any queued outgoing data, then it will send the FIN packet.
 	The link will still receive incoming data from remote until the remote closes the connection. */
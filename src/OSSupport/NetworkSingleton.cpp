@@ -2,7 +2,7 @@
 // NetworkSingleton.cpp
 
 // Implements the cNetworkSingleton class representing the storage for global data pertaining to network API
-// such as a list of all connections, all listening sockets and the LibEvent dispatch thread.
+// such as a list of all connections, all listening sockets and the LibEvent dispatch threads.
 
 #include "Globals.h"
 #include "NetworkSingleton.h"
@@ -44,7 +44,7 @@ cNetworkSingleton & cNetworkSingleton::Get(void)
 
 
 
-void cNetworkSingleton::Initialise(void)
+void cNetworkSingleton::Initialise(size_t a_NumEventLoops)
 {
 	// Start the lookup thread
 	m_LookupThread.Start();
@@ -74,18 +74,34 @@ void cNetworkSingleton::Initialise(void)
 		#error No threading implemented for EVTHREAD
 	#endif
 
-	// Create the main event_base:
-	m_EventBase = event_base_new();
-	if (m_EventBase == nullptr)
+	// By default, use one loop per two cores, up to 4 loops; a single loop is plenty for small servers, but a busy
+	// server with hundreds of connections (and status pings) would have the single loop thread as its bottleneck:
+	if (a_NumEventLoops == 0)
 	{
-		LOGERROR("Failed to initialize LibEvent. The server will now terminate.");
-		abort();
+		a_NumEventLoops = Clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, 4);
 	}
 
-	// Create the event loop thread:
+	// Create the event_bases:
+	m_EventLoops.clear();
+	for (size_t i = 0; i < a_NumEventLoops; i++)
+	{
+		std::unique_ptr<sEventLoop> EventLoop(new sEventLoop);
+		EventLoop->m_EventBase = event_base_new();
+		if (EventLoop->m_EventBase == nullptr)
+		{
+			LOGERROR("Failed to initialize LibEvent. The server will now terminate.");
+			abort();
+		}
+		m_EventLoops.push_back(std::move(EventLoop));
+	}
+
+	// Create the event loop threads:
 	m_HasTerminated = false;
-	m_EventLoopThread = std::thread(RunEventLoop, this);
-	m_StartupEvent.Wait();  // Wait for the LibEvent loop to actually start running (otherwise calling Terminate too soon would hang, see #3228)
+	for (auto & EventLoop : m_EventLoops)
+	{
+		EventLoop->m_Thread = std::thread(RunEventLoop, EventLoop.get());
+		EventLoop->m_StartupEvent.Wait();  // Wait for the LibEvent loop to actually start running (otherwise calling Terminate too soon would hang, see #3228)
+	}
 }
 
 
@@ -99,9 +115,15 @@ void cNetworkSingleton::Terminate(void)
 	// Wait for the lookup thread to stop
 	m_LookupThread.Stop();
 
-	// Wait for the LibEvent event loop to terminate:
-	event_base_loopbreak(m_EventBase);
-	m_EventLoopThread.join();
+	// Wait for the LibEvent event loops to terminate:
+	for (auto & EventLoop : m_EventLoops)
+	{
+		event_base_loopbreak(EventLoop->m_EventBase);
+	}
+	for (auto & EventLoop : m_EventLoops)
+	{
+		EventLoop->m_Thread.join();
+	}
 
 	// Remove all objects:
 	{
@@ -111,7 +133,11 @@ void cNetworkSingleton::Terminate(void)
 	}
 
 	// Free the underlying LibEvent objects:
-	event_base_free(m_EventBase);
+	for (auto & EventLoop : m_EventLoops)
+	{
+		event_base_free(EventLoop->m_EventBase);
+		EventLoop->m_EventBase = nullptr;
+	}
 
 	libevent_global_shutdown();
 
@@ -144,12 +170,12 @@ void cNetworkSingleton::LogCallback(int a_Severity, const char * a_Msg)
 
 
 
-void cNetworkSingleton::RunEventLoop(cNetworkSingleton * a_Self)
+void cNetworkSingleton::RunEventLoop(sEventLoop * a_EventLoop)
 {
-	auto timer = evtimer_new(a_Self->m_EventBase, SignalizeStartup, a_Self);
+	auto timer = evtimer_new(a_EventLoop->m_EventBase, SignalizeStartup, a_EventLoop);
 	timeval timeout{};  // Zero timeout - execute immediately
 	evtimer_add(timer, &timeout);
-	event_base_loop(a_Self->m_EventBase, EVLOOP_NO_EXIT_ON_EMPTY);
+	event_base_loop(a_EventLoop->m_EventBase, EVLOOP_NO_EXIT_ON_EMPTY);
 	event_free(timer);
 }
 
@@ -157,11 +183,48 @@ void cNetworkSingleton::RunEventLoop(cNetworkSingleton * a_Self)
 
 
 
-void cNetworkSingleton::SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self)
+void cNetworkSingleton::SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_EventLoop)
+{
+	auto EventLoop = reinterpret_cast<sEventLoop *>(a_EventLoop);
+	ASSERT(EventLoop != nullptr);
+	EventLoop->m_StartupEvent.Set();
+}
+
+
+
+
+
+size_t cNetworkSingleton::AcquireLinkEventLoop(void)
 {
-	auto self = reinterpret_cast<cNetworkSingleton *>(a_Self);
-	ASSERT(self != nullptr);
-	self->m_StartupEvent.Set();
+	ASSERT(!m_EventLoops.empty());
+
+	// Pick the least loaded loop. The counts may change meanwhile, but an occasional imbalance of one link doesn't matter:
+	size_t Res = 0;
+	int MinLinks = m_EventLoops[0]->m_NumLinks;
+	for (size_t i = 1; i < m_EventLoops.size(); i++)
+	{
+		int NumLinks = m_EventLoops[i]->m_NumLinks;
+		if (NumLinks < MinLinks)
+		{
+			MinLinks = NumLinks;
+			Res = i;
+		}
+	}
+	m_EventLoops[Res]->m_NumLinks += 1;
+	return Res;
+}
+
+
+
+
+
+void cNetworkSingleton::ReleaseLinkEventLoop(size_t a_EventLoopIndex)
+{
+	// The loops may have been re-created by a restart while an old link was still alive:
+	if (a_EventLoopIndex < m_EventLoops.size())
+	{
+		m_EventLoops[a_EventLoopIndex]->m_NumLinks -= 1;
+	}
 }
 
 
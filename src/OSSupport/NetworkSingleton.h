@@ -2,7 +2,7 @@
 // NetworkSingleton.h
 
 // Declares the cNetworkSingleton class representing the storage for global data pertaining to network API
-// such as a list of all connections, all listening sockets and the LibEvent dispatch thread.
+// such as a list of all connections, all listening sockets and the LibEvent dispatch threads.
 
 // This is an internal header, no-one outside OSSupport should need to include it; use Network.h instead;
 // the only exception being the main app entrypoint that needs to call Terminate before quitting.
@@ -45,16 +45,32 @@ public:
 	static cNetworkSingleton & Get(void);
 
 	/** Initialises all network-related threads.
+	a_NumEventLoops is the number of LibEvent loops (and threads) among which the TCP links are distributed;
+	0 picks a default based on the number of CPU cores.
 	To be called on first run or after app restart. */
-	void Initialise(void);
+	void Initialise(size_t a_NumEventLoops = 0);
 
 	/** Terminates all network-related threads.
 	To be used only on app shutdown or restart.
 	MSVC runtime requires that the LibEvent networking be shut down before the main() function is exitted; this is the way to do it. */
 	void Terminate(void);
 
-	/** Returns the main LibEvent handle for event registering. */
-	event_base * GetEventBase(void) { return m_EventBase; }
+	/** Returns the main LibEvent handle for event registering.
+	The listening sockets and UDP endpoints live here, the TCP links are spread over all the event loops. */
+	event_base * GetEventBase(void) { return m_EventLoops[0]->m_EventBase; }
+
+	/** Returns the LibEvent handle of the specified event loop. */
+	event_base * GetEventBase(size_t a_EventLoopIndex) { return m_EventLoops[a_EventLoopIndex]->m_EventBase; }
+
+	/** Returns the number of event loops. */
+	size_t GetNumEventLoops(void) const { return m_EventLoops.size(); }
+
+	/** Picks the event loop for a new TCP link, the one with the fewest links, and counts the link in it.
+	Returns the index of the picked loop. The link must call ReleaseLinkEventLoop() once it frees its bufferevent. */
+	size_t AcquireLinkEventLoop(void);
+
+	/** Stops counting a link in the specified event loop. */
+	void ReleaseLinkEventLoop(size_t a_EventLoopIndex);
 
 	/** Returns the thread used to perform hostname and IP lookups */
 	cNetworkLookup & GetLookupThread() { return m_LookupThread; }
@@ -78,8 +94,31 @@ public:
 
 protected:
 
-	/** The main LibEvent container for driving the event loop. */
-	event_base * m_EventBase;
+	/** A single LibEvent loop with its own thread. */
+	struct sEventLoop
+	{
+		/** The LibEvent container for driving the event loop. */
+		event_base * m_EventBase;
+
+		/** The thread in which the loop runs. */
+		std::thread m_Thread;
+
+		/** Event that is signalled once the loop is running. */
+		cEvent m_StartupEvent;
+
+		/** The number of TCP links whose bufferevents live in this loop. */
+		std::atomic<int> m_NumLinks;
+
+		sEventLoop(void):
+			m_EventBase(nullptr),
+			m_NumLinks(0)
+		{
+		}
+	};
+
+
+	/** The event loops. The first one is the main loop, which also hosts the listeners and UDP endpoints. */
+	std::vector<std::unique_ptr<sEventLoop>> m_EventLoops;
 
 	/** Container for all client connections, including ones with pending-connect. */
 	cTCPLinkImplPtrs m_Connections;
@@ -93,12 +132,6 @@ protected:
 	/** Set to true if Terminate has been called. */
 	std::atomic<bool> m_HasTerminated;
 
-	/** The thread in which the main LibEvent loop runs. */
-	std::thread m_EventLoopThread;
-
-	/** Event that is signalled once the startup is finished and the LibEvent loop is running. */
-	cEvent m_StartupEvent;
-
 	/** The thread on which hostname and ip address lookup is performed. */
 	cNetworkLookup m_LookupThread;
 
@@ -107,10 +140,10 @@ protected:
 	static void LogCallback(int a_Severity, const char * a_Msg);
 
 	/** Implements the thread that runs LibEvent's event dispatcher loop. */
-	static void RunEventLoop(cNetworkSingleton * a_Self);
+	static void RunEventLoop(sEventLoop * a_EventLoop);
 
 	/** Callback called by LibEvent when the event loop is started. */
-	static void SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self);
+	static void SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_EventLoop);
 };
 
 
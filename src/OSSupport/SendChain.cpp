@@ -0,0 +1,95 @@
+
+// SendChain.cpp
+
+// Implements the cSendChain class representing a chain of data slices queued for sending over a link in a single flush
+
+#include "Globals.h"
+#include "SendChain.h"
+
+
+
+
+
+cSendChain::cSendChain(void):
+	m_Size(0),
+	m_NumBytesCopied(0)
+{
+}
+
+
+
+
+
+void cSendChain::Append(const char * a_Data, size_t a_Size)
+{
+	if (a_Size == 0)
+	{
+		return;
+	}
+	if (m_Tail == nullptr)
+	{
+		m_Tail = std::make_shared<AString>();
+	}
+	m_Tail->append(a_Data, a_Size);
+	m_Size += a_Size;
+	m_NumBytesCopied += a_Size;
+}
+
+
+
+
+
+void cSendChain::AppendShared(const cSlicePtr & a_Data)
+{
+	if ((a_Data == nullptr) || a_Data->empty())
+	{
+		return;
+	}
+	if (a_Data->size() < MIN_SHARED_SLICE_SIZE)
+	{
+		Append(a_Data->data(), a_Data->size());
+		return;
+	}
+	CloseTail();
+	m_Slices.push_back(a_Data);
+	m_Size += a_Data->size();
+}
+
+
+
+
+
+const cSendChain::cSlicePtrs & cSendChain::GetSlices(void)
+{
+	CloseTail();
+	return m_Slices;
+}
+
+
+
+
+
+void cSendChain::Clear(void)
+{
+	m_Slices.clear();
+	m_Tail.reset();
+	m_Size = 0;
+	m_NumBytesCopied = 0;
+}
+
+
+
+
+
+void cSendChain::CloseTail(void)
+{
+	if ((m_Tail != nullptr) && !m_Tail->empty())
+	{
+		m_Slices.push_back(std::move(m_Tail));
+	}
+	m_Tail.reset();
+}
+
+
+
+
@@ -0,0 +1,86 @@
+
+// SendChain.h
+
+// Declares the cSendChain class representing a chain of data slices queued for sending over a link in a single flush
+
+/*
+The data queued for a link during a tick is collected in a chain of slices instead of a single string. Small
+pieces of data are copied into an owned slice at the end of the chain, the same as appending them to a string.
+Large pieces of data that are sent to many links (serialized chunks, broadcast packets) can be added as shared
+slices instead, which are only referenced, never copied. The link then hands all the slices to LibEvent by
+reference and LibEvent writes them to the socket using scatter / gather IO, so the whole tick's worth of data
+reaches the OS in as few calls as possible, without copying the data again.
+
+The chain counts the bytes it had to copy, so that the ratio of copied to sent bytes can be monitored.
+The object is not thread-safe, cClientHandle protects it with m_CSOutgoingData.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cSendChain
+{
+public:
+
+	/** A slice of data shared between the chain and any other owners. The data must not change once shared. */
+	typedef std::shared_ptr<const AString> cSlicePtr;
+	typedef std::vector<cSlicePtr> cSlicePtrs;
+
+	/** Shared slices smaller than this are copied instead of referenced, because referencing a slice
+	costs about as much as copying this many bytes. */
+	static const size_t MIN_SHARED_SLICE_SIZE = 256;
+
+
+	cSendChain(void);
+
+	/** Copies the data to the end of the chain. */
+	void Append(const char * a_Data, size_t a_Size);
+
+	/** Adds the shared data to the end of the chain. Large data is referenced, small data is copied. */
+	void AppendShared(const cSlicePtr & a_Data);
+
+	/** Returns the slices making up the chain, in the order in which they are to be sent. */
+	const cSlicePtrs & GetSlices(void);
+
+	/** Returns the total number of bytes in the chain. */
+	size_t GetSize(void) const { return m_Size; }
+
+	/** Returns true if there's no data in the chain. */
+	bool IsEmpty(void) const { return (m_Size == 0); }
+
+	/** Returns the number of bytes that had to be copied into the chain. */
+	size_t GetNumBytesCopied(void) const { return m_NumBytesCopied; }
+
+	/** Removes all the data from the chain. */
+	void Clear(void);
+
+protected:
+
+	/** The slices that are complete and won't change anymore. */
+	cSlicePtrs m_Slices;
+
+	/** The owned slice at the end of the chain into which the appended data is copied.
+	Moved into m_Slices once a shared slice is appended after it, or the slices are requested. */
+	std::shared_ptr<AString> m_Tail;
+
+	/** The total number of bytes in the chain. */
+	size_t m_Size;
+
+	/** The number of bytes that were copied into the chain. */
+	size_t m_NumBytesCopied;
+
+
+	/** Moves the tail slice, if not empty, to the end of m_Slices. */
+	void CloseTail(void);
+} ;
+
+
+
+
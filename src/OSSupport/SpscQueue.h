@@ -0,0 +1,113 @@
+
+// SpscQueue.h
+
+// Implements the cSpscQueue class representing a bounded lock-free single-producer single-consumer queue
+
+#pragma once
+
+/*
+The queue is a ring buffer of a fixed capacity. Exactly one thread may push items (the producer) and exactly
+one thread may pop them (the consumer); neither side ever blocks or takes a lock. Pushing into a full queue fails,
+which the producer is expected to handle (usually by treating it as a flood). One slot of the ring is always
+kept empty, so that a full queue can be told apart from an empty one.
+
+Usage:
+	cSpscQueue<AString> Queue(1024);
+	// Producer thread:
+	if (!Queue.Push(std::move(Item))) { ... the queue is full ... }
+	// Consumer thread:
+	AString Item;
+	while (Queue.Pop(Item)) { ... }
+*/
+
+
+
+
+
+template <class ItemType>
+class cSpscQueue
+{
+public:
+
+	/** Creates a queue that can hold up to a_Capacity items. */
+	cSpscQueue(size_t a_Capacity):
+		m_Items(a_Capacity + 1),
+		m_ReadPos(0),
+		m_WritePos(0)
+	{
+	}
+
+
+	/** Moves the item to the end of the queue.
+	Returns false if the queue is full, a_Item is left untouched in such a case.
+	Only call from the producer thread. */
+	bool Push(ItemType && a_Item)
+	{
+		size_t WritePos = m_WritePos.load(std::memory_order_relaxed);
+		size_t NextPos = NextPosition(WritePos);
+		if (NextPos == m_ReadPos.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		m_Items[WritePos] = std::move(a_Item);
+		m_WritePos.store(NextPos, std::memory_order_release);
+		return true;
+	}
+
+
+	/** Moves the item from the front of the queue into a_Item.
+	Returns false if the queue is empty.
+	Only call from the consumer thread. */
+	bool Pop(ItemType & a_Item)
+	{
+		size_t ReadPos = m_ReadPos.load(std::memory_order_relaxed);
+		if (ReadPos == m_WritePos.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		a_Item = std::move(m_Items[ReadPos]);
+		m_ReadPos.store(NextPosition(ReadPos), std::memory_order_release);
+		return true;
+	}
+
+
+	/** Returns true if there are no items in the queue.
+	Exact only when called from the consumer thread, other threads may see an outdated state. */
+	bool IsEmpty(void) const
+	{
+		return (m_ReadPos.load(std::memory_order_acquire) == m_WritePos.load(std::memory_order_acquire));
+	}
+
+
+	/** Returns the maximum number of items that the queue can hold. */
+	size_t GetCapacity(void) const
+	{
+		return m_Items.size() - 1;
+	}
+
+protected:
+
+	/** The ring buffer storage. */
+	std::vector<ItemType> m_Items;
+
+	/** The position of the next item to pop. Written only by the consumer. */
+	std::atomic<size_t> m_ReadPos;
+
+	/** Keeps m_ReadPos and m_WritePos on separate cache lines, so that the two threads don't keep stealing the line from each other. */
+	char m_Padding[64];
+
+	/** The position where the next item will be pushed. Written only by the producer. */
+	std::atomic<size_t> m_WritePos;
+
+
+	/** Returns the ring position following a_Pos. */
+	size_t NextPosition(size_t a_Pos) const
+	{
+		a_Pos += 1;
+		return (a_Pos == m_Items.size()) ? 0 : a_Pos;
+	}
+} ;
+
+
+
+
@@ -7,6 +7,7 @@
 #include "TCPLinkImpl.h"
 #include "mbedTLS++/SslConfig.h"
 #include "NetworkSingleton.h"
+#include "SendChain.h"
 #include "ServerHandleImpl.h"
 #include <event2/buffer.h>
 #include "OSSupport/WindowsUndefs.h"
@@ -20,7 +21,8 @@
 
 cTCPLinkImpl::cTCPLinkImpl(cTCPLink::cCallbacksPtr a_LinkCallbacks):
 	super(a_LinkCallbacks),
-	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(), -1, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
+	m_EventLoopIndex(cNetworkSingleton::Get().AcquireLinkEventLoop()),
+	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(m_EventLoopIndex), -1, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
 	m_LocalPort(0),
 	m_RemotePort(0),
 	m_ShouldShutdown(false)
@@ -33,7 +35,8 @@ cTCPLinkImpl::cTCPLinkImpl(cTCPLink::cCallbacksPtr a_LinkCallbacks):
 
 cTCPLinkImpl::cTCPLinkImpl(evutil_socket_t a_Socket, cTCPLink::cCallbacksPtr a_LinkCallbacks, cServerHandleImplPtr a_Server, const sockaddr * a_Address, socklen_t a_AddrLen):
 	super(a_LinkCallbacks),
-	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(), a_Socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
+	m_EventLoopIndex(cNetworkSingleton::Get().AcquireLinkEventLoop()),
+	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(m_EventLoopIndex), a_Socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
 	m_Server(a_Server),
 	m_LocalPort(0),
 	m_RemotePort(0),
@@ -54,6 +57,7 @@ cTCPLinkImpl::~cTCPLinkImpl()
 	m_TlsContext.reset();
 
 	bufferevent_free(m_BufferEvent);
+	cNetworkSingleton::Get().ReleaseLinkEventLoop(m_EventLoopIndex);
 }
 
 
@@ -184,6 +188,59 @@ bool cTCPLinkImpl::Send(const void * a_Data, size_t a_Length)
 
 
 
+bool cTCPLinkImpl::Send(cSendChain & a_Chain)
+{
+	if (m_ShouldShutdown)
+	{
+		LOGD("%s: Cannot send data, the link is already shut down.", __FUNCTION__);
+		return false;
+	}
+
+	const auto & Slices = a_Chain.GetSlices();
+
+	// The TLS context needs to encrypt the data anyway, push the slices into it one by one:
+	if (m_TlsContext != nullptr)
+	{
+		for (const auto & Slice: Slices)
+		{
+			m_TlsContext->Send(Slice->data(), Slice->size());
+		}
+		return true;
+	}
+
+	// Reference the slices in the output buffer, LibEvent writes them using scatter / gather IO
+	// Lock the bufferevent so that data sent from other threads doesn't get interleaved with the chain:
+	bool Res = true;
+	bufferevent_lock(m_BufferEvent);
+	auto Output = bufferevent_get_output(m_BufferEvent);
+	for (const auto & Slice: Slices)
+	{
+		auto Ref = new cSendChain::cSlicePtr(Slice);
+		if (evbuffer_add_reference(Output, Slice->data(), Slice->size(), ReleaseSliceCallback, Ref) != 0)
+		{
+			delete Ref;
+			Res = false;
+			break;
+		}
+	}
+	bufferevent_unlock(m_BufferEvent);
+	return Res;
+}
+
+
+
+
+
+size_t cTCPLinkImpl::GetOutgoingDataSize(void) const
+{
+	// The output buffer is locked by LibEvent itself, the bufferevent is created as threadsafe:
+	return evbuffer_get_length(bufferevent_get_output(m_BufferEvent));
+}
+
+
+
+
+
 void cTCPLinkImpl::Shutdown(void)
 {
 	// If running in TLS mode, notify the TLS layer:
@@ -446,6 +503,17 @@ void cTCPLinkImpl::EventCallback(bufferevent * a_BufferEvent, short a_What, void
 
 
 
+void cTCPLinkImpl::ReleaseSliceCallback(const void * a_Data, size_t a_Length, void * a_Extra)
+{
+	UNUSED(a_Data);
+	UNUSED(a_Length);
+	delete static_cast<cSendChain::cSlicePtr *>(a_Extra);
+}
+
+
+
+
+
 void cTCPLinkImpl::UpdateAddress(const sockaddr * a_Address, socklen_t a_AddrLen, AString & a_IP, UInt16 & a_Port)
 {
 	// Based on the family specified in the address, use the correct datastructure to convert to IP string:
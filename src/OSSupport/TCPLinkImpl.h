@@ -60,10 +60,12 @@ public:
 
 	// cTCPLink overrides:
 	virtual bool Send(const void * a_Data, size_t a_Length) override;
+	virtual bool Send(cSendChain & a_Chain) override;
 	virtual AString GetLocalIP(void) const override { return m_LocalIP; }
 	virtual UInt16 GetLocalPort(void) const override { return m_LocalPort; }
 	virtual AString GetRemoteIP(void) const override { return m_RemoteIP; }
 	virtual UInt16 GetRemotePort(void) const override { return m_RemotePort; }
+	virtual size_t GetOutgoingDataSize(void) const override;
 	virtual void Shutdown(void) override;
 	virtual void Close(void) override;
 	virtual AString StartTLSClient(
@@ -137,6 +139,9 @@ protected:
 	May be NULL if not used. Only used for outgoing connections (cNetwork::Connect()). */
 	cNetwork::cConnectCallbacksPtr m_ConnectCallbacks;
 
+	/** The index of the cNetworkSingleton's event loop in which m_BufferEvent lives. */
+	size_t m_EventLoopIndex;
+
 	/** The LibEvent handle representing this connection. */
 	bufferevent * m_BufferEvent;
 
@@ -185,6 +190,10 @@ protected:
 	/** Callback that LibEvent calls when there's a non-data-related event on the socket. */
 	static void EventCallback(bufferevent * a_BufferEvent, short a_What, void * a_Self);
 
+	/** Callback that LibEvent calls when it no longer needs a slice referenced by Send(cSendChain &).
+	a_Extra is the heap-allocated cSendChain::cSlicePtr keeping the slice alive. */
+	static void ReleaseSliceCallback(const void * a_Data, size_t a_Length, void * a_Extra);
+
 	/** Sets a_IP and a_Port to values read from a_Address, based on the correct address family. */
 	static void UpdateAddress(const sockaddr * a_Address, socklen_t a_AddrLen, AString & a_IP, UInt16 & a_Port);
 
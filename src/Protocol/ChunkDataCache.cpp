@@ -0,0 +1,129 @@
+
+// ChunkDataCache.cpp
+
+// Implements the cChunkDataCache class that keeps recently serialized chunk data packets for reuse
+
+#include "Globals.h"
+#include "ChunkDataCache.h"
+
+
+
+
+
+cChunkDataCache::cChunkDataCache(void):
+	m_Size(0),
+	m_MaxSize(0),
+	m_NumHits(0),
+	m_NumMisses(0)
+{
+}
+
+
+
+
+
+void cChunkDataCache::SetMaxSize(size_t a_MaxSize)
+{
+	cCSLock Lock(m_CS);
+	m_MaxSize = a_MaxSize;
+	Trim();
+}
+
+
+
+
+
+bool cChunkDataCache::Get(int a_ChunkX, int a_ChunkZ, int a_Version, UInt64 a_Generation, std::shared_ptr<const AString> & a_Data)
+{
+	cCSLock Lock(m_CS);
+	auto itr = m_Index.find(sKey{a_ChunkX, a_ChunkZ, a_Version});
+	if (itr == m_Index.end())
+	{
+		m_NumMisses += 1;
+		return false;
+	}
+	auto Entry = itr->second;
+	if (Entry->m_Generation != a_Generation)
+	{
+		// The chunk has changed since, the data is of no use anymore:
+		Remove(Entry);
+		m_NumMisses += 1;
+		return false;
+	}
+
+	// Move to the front of the LRU list:
+	m_Entries.splice(m_Entries.begin(), m_Entries, Entry);
+	a_Data = Entry->m_Data;
+	m_NumHits += 1;
+	return true;
+}
+
+
+
+
+
+void cChunkDataCache::Put(int a_ChunkX, int a_ChunkZ, int a_Version, UInt64 a_Generation, const std::shared_ptr<const AString> & a_Data)
+{
+	cCSLock Lock(m_CS);
+	if (a_Data->size() > m_MaxSize)
+	{
+		// Wouldn't fit at all (or the cache is disabled)
+		return;
+	}
+
+	sKey Key{a_ChunkX, a_ChunkZ, a_Version};
+	auto itr = m_Index.find(Key);
+	if (itr != m_Index.end())
+	{
+		Remove(itr->second);
+	}
+
+	m_Entries.push_front(sEntry{Key, a_Generation, a_Data});
+	m_Index[Key] = m_Entries.begin();
+	m_Size += a_Data->size();
+	Trim();
+}
+
+
+
+
+
+cChunkDataCache::sStats cChunkDataCache::GetStats(void)
+{
+	cCSLock Lock(m_CS);
+	sStats Res;
+	Res.m_NumHits = m_NumHits;
+	Res.m_NumMisses = m_NumMisses;
+	Res.m_NumEntries = m_Index.size();
+	Res.m_Size = m_Size;
+	Res.m_MaxSize = m_MaxSize;
+	return Res;
+}
+
+
+
+
+
+void cChunkDataCache::Remove(cEntries::iterator a_Entry)
+{
+	ASSERT(m_Size >= a_Entry->m_Data->size());
+	m_Size -= a_Entry->m_Data->size();
+	m_Index.erase(a_Entry->m_Key);
+	m_Entries.erase(a_Entry);
+}
+
+
+
+
+
+void cChunkDataCache::Trim(void)
+{
+	while ((m_Size > m_MaxSize) && !m_Entries.empty())
+	{
+		Remove(std::prev(m_Entries.end()));
+	}
+}
+
+
+
+
@@ -0,0 +1,123 @@
+
+// ChunkDataCache.h
+
+// Declares the cChunkDataCache class that keeps recently serialized chunk data packets for reuse
+
+/*
+Serializing and compressing a chunk is the most expensive part of sending it. When many players are around the
+same area (typically spawn), the same chunks are sent over and over again, so the cChunkSender keeps the
+serialized packets in this LRU cache. Each entry is tagged with the cChunkData generation it was made from,
+so any modification of the chunk makes the entry stale; a stale entry is dropped when it is next looked up,
+or when it falls off the end of the LRU list.
+*/
+
+
+
+
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+
+
+
+
+
+class cChunkDataCache
+{
+public:
+
+	struct sStats
+	{
+		size_t m_NumHits;
+		size_t m_NumMisses;
+		size_t m_NumEntries;
+		size_t m_Size;
+		size_t m_MaxSize;
+	};
+
+
+	cChunkDataCache(void);
+
+	/** Sets the maximum number of bytes of serialized data kept in the cache, evicting entries if needed.
+	A size of 0 disables the cache. */
+	void SetMaxSize(size_t a_MaxSize);
+
+	/** Retrieves the serialized data for the specified chunk, protocol version and chunk data generation.
+	Returns true and sets a_Data on a hit, returns false on a miss.
+	The data is shared with the cache and must not be modified. */
+	bool Get(int a_ChunkX, int a_ChunkZ, int a_Version, UInt64 a_Generation, std::shared_ptr<const AString> & a_Data);
+
+	/** Stores the serialized data for the specified chunk, protocol version and chunk data generation,
+	replacing any previous data for the same chunk and version. */
+	void Put(int a_ChunkX, int a_ChunkZ, int a_Version, UInt64 a_Generation, const std::shared_ptr<const AString> & a_Data);
+
+	/** Returns the hit / miss counters and the current size of the cache. */
+	sStats GetStats(void);
+
+protected:
+
+	struct sKey
+	{
+		int m_ChunkX;
+		int m_ChunkZ;
+		int m_Version;
+
+		bool operator == (const sKey & a_Other) const
+		{
+			return (
+				(m_ChunkX == a_Other.m_ChunkX) &&
+				(m_ChunkZ == a_Other.m_ChunkZ) &&
+				(m_Version == a_Other.m_Version)
+			);
+		}
+	};
+
+	struct sKeyHash
+	{
+		size_t operator () (const sKey & a_Key) const
+		{
+			return cChunkCoordsHash()(cChunkCoords(a_Key.m_ChunkX, a_Key.m_ChunkZ)) ^ static_cast<size_t>(a_Key.m_Version);
+		}
+	};
+
+	struct sEntry
+	{
+		sKey m_Key;
+		UInt64 m_Generation;
+		std::shared_ptr<const AString> m_Data;
+	};
+
+	typedef std::list<sEntry> cEntries;
+
+
+	/** Protects all the members against multithreaded access. */
+	cCriticalSection m_CS;
+
+	/** The cached entries, the most recently used first. */
+	cEntries m_Entries;
+
+	/** Maps the keys to their entries in m_Entries. */
+	std::unordered_map<sKey, cEntries::iterator, sKeyHash> m_Index;
+
+	/** The total number of bytes of serialized data in m_Entries. */
+	size_t m_Size;
+
+	/** The maximum allowed m_Size. */
+	size_t m_MaxSize;
+
+	size_t m_NumHits;
+	size_t m_NumMisses;
+
+
+	/** Removes the specified entry from the cache. Expects m_CS to be locked. */
+	void Remove(cEntries::iterator a_Entry);
+
+	/** Removes the least recently used entries until the cache fits into m_MaxSize. Expects m_CS to be locked. */
+	void Trim(void);
+} ;
+
+
+
+
@@ -7,6 +7,7 @@
 
 #include "Globals.h"
 #include "ChunkDataSerializer.h"
+#include "ChunkDataCache.h"
 #include "zlib/zlib.h"
 #include "ByteBuffer.h"
 #include "Protocol_1_8.h"
@@ -40,11 +41,15 @@ void ForEachSection(const cChunkData & a_Data, Func a_Func)
 cChunkDataSerializer::cChunkDataSerializer(
 	const cChunkData &    a_Data,
 	const unsigned char * a_BiomeData,
-	const eDimension      a_Dimension
+	const eDimension      a_Dimension,
+	cChunkDataCache *     a_Cache,
+	UInt64                a_Generation
 ):
 	m_Data(a_Data),
 	m_BiomeData(a_BiomeData),
-	m_Dimension(a_Dimension)
+	m_Dimension(a_Dimension),
+	m_Cache(a_Cache),
+	m_Generation(a_Generation)
 {
 }
 
@@ -52,7 +57,7 @@ cChunkDataSerializer::cChunkDataSerializer(
 
 
 
-const AString & cChunkDataSerializer::Serialize(int a_Version, int a_ChunkX, int a_ChunkZ)
+std::shared_ptr<const AString> cChunkDataSerializer::Serialize(int a_Version, int a_ChunkX, int a_ChunkZ)
 {
 	Serializations::const_iterator itr = m_Serializations.find(a_Version);
 	if (itr != m_Serializations.end())
@@ -60,6 +65,13 @@ const AString & cChunkDataSerializer::Serialize(int a_Version, int a_ChunkX, int
 		return itr->second;
 	}
 
+	// If the chunk hasn't changed since it was last serialized, reuse the data:
+	std::shared_ptr<const AString> Cached;
+	if ((m_Cache != nullptr) && m_Cache->Get(a_ChunkX, a_ChunkZ, a_Version, m_Generation, Cached))
+	{
+		return m_Serializations[a_Version] = Cached;
+	}
+
 	AString data;
 	switch (a_Version)
 	{
@@ -75,11 +87,12 @@ const AString & cChunkDataSerializer::Serialize(int a_Version, int a_ChunkX, int
 			break;
 		}
 	}
-	if (!data.empty())
+	auto Res = std::make_shared<const AString>(std::move(data));
+	if (!Res->empty() && (m_Cache != nullptr))
 	{
-		m_Serializations[a_Version] = data;
+		m_Cache->Put(a_ChunkX, a_ChunkZ, a_Version, m_Generation, Res);
 	}
-	return m_Serializations[a_Version];
+	return m_Serializations[a_Version] = Res;
 }
 
 
@@ -112,9 +125,11 @@ void cChunkDataSerializer::Serialize47(AString & a_Data, int a_ChunkX, int a_Chu
 	// Write the block types to the packet:
 	ForEachSection(m_Data, [&](const cChunkData::sChunkSection & a_Section)
 		{
+			BLOCKTYPE Buffer[cChunkData::SectionBlockCount];
+			const BLOCKTYPE * BlockTypes = a_Section.GetBlockTypes(Buffer);
 			for (size_t BlockIdx = 0; BlockIdx != cChunkData::SectionBlockCount; ++BlockIdx)
 			{
-				BLOCKTYPE BlockType = a_Section.m_BlockTypes[BlockIdx] & 0xFF;
+				BLOCKTYPE BlockType = BlockTypes[BlockIdx] & 0xFF;
 				NIBBLETYPE BlockMeta = a_Section.m_BlockMetas[BlockIdx / 2] >> ((BlockIdx & 1) * 4) & 0x0f;
 				Packet.WriteBEUInt8(static_cast<unsigned char>(BlockType << 4) | BlockMeta);
 				Packet.WriteBEUInt8(static_cast<unsigned char>(BlockType >> 4));
@@ -125,14 +140,14 @@ void cChunkDataSerializer::Serialize47(AString & a_Data, int a_ChunkX, int a_Chu
 	// Write the block lights:
 	ForEachSection(m_Data, [&](const cChunkData::sChunkSection & a_Section)
 		{
-			Packet.WriteBuf(a_Section.m_BlockLight, sizeof(a_Section.m_BlockLight));
+			Packet.WriteBuf(a_Section.GetBlockLight(), cChunkData::SectionNibbleCount);
 		}
 	);
 
 	// Write the sky lights:
 	ForEachSection(m_Data, [&](const cChunkData::sChunkSection & a_Section)
 		{
-			Packet.WriteBuf(a_Section.m_BlockSkyLight, sizeof(a_Section.m_BlockSkyLight));
+			Packet.WriteBuf(a_Section.GetSkyLight(), cChunkData::SectionNibbleCount);
 		}
 	);
 
@@ -143,28 +158,12 @@ void cChunkDataSerializer::Serialize47(AString & a_Data, int a_ChunkX, int a_Chu
 	Packet.ReadAll(PacketData);
 	Packet.CommitRead();
 
-	cByteBuffer Buffer(20);
-	if (PacketData.size() >= 256)
+	// Frame the packet, compressing it if it is over the server's compression threshold:
+	if (!cProtocol_1_8_0::CompressPacket(PacketData, a_Data))
 	{
-		if (!cProtocol_1_8_0::CompressPacket(PacketData, a_Data))
-		{
-			ASSERT(!"Packet compression failed.");
-			a_Data.clear();
-			return;
-		}
-	}
-	else
-	{
-		AString PostData;
-		Buffer.WriteVarInt32(static_cast<UInt32>(Packet.GetUsedSpace() + 1));
-		Buffer.WriteVarInt32(0);
-		Buffer.ReadAll(PostData);
-		Buffer.CommitRead();
-
+		ASSERT(!"Packet compression failed.");
 		a_Data.clear();
-		a_Data.reserve(PostData.size() + PacketData.size());
-		a_Data.append(PostData.data(), PostData.size());
-		a_Data.append(PacketData.data(), PacketData.size());
+		return;
 	}
 }
 
@@ -218,9 +217,11 @@ void cChunkDataSerializer::Serialize107(AString & a_Data, int a_ChunkX, int a_Ch
 			UInt64 TempLong = 0;  // Temporary value that will be stored into
 			UInt64 CurrentlyWrittenIndex = 0;  // "Index" of the long that would be written to
 
+			BLOCKTYPE Buffer[cChunkData::SectionBlockCount];
+			const BLOCKTYPE * BlockTypes = a_Section.GetBlockTypes(Buffer);
 			for (size_t Index = 0; Index < cChunkData::SectionBlockCount; Index++)
 			{
-				UInt64 Value = static_cast<UInt64>(a_Section.m_BlockTypes[Index] << 4);
+				UInt64 Value = static_cast<UInt64>(BlockTypes[Index] << 4);
 				if (Index % 2 == 0)
 				{
 					Value |= a_Section.m_BlockMetas[Index / 2] & 0x0f;
@@ -260,11 +261,11 @@ void cChunkDataSerializer::Serialize107(AString & a_Data, int a_ChunkX, int a_Ch
 			Packet.WriteBEUInt64(TempLong);
 
 			// Write lighting:
-			Packet.WriteBuf(a_Section.m_BlockLight, sizeof(a_Section.m_BlockLight));
+			Packet.WriteBuf(a_Section.GetBlockLight(), cChunkData::SectionNibbleCount);
 			if (m_Dimension == dimOverworld)
 			{
 				// Skylight is only sent in the overworld; the nether and end do not use it
-				Packet.WriteBuf(a_Section.m_BlockSkyLight, sizeof(a_Section.m_BlockSkyLight));
+				Packet.WriteBuf(a_Section.GetSkyLight(), cChunkData::SectionNibbleCount);
 			}
 		}
 	);
@@ -276,28 +277,12 @@ void cChunkDataSerializer::Serialize107(AString & a_Data, int a_ChunkX, int a_Ch
 	Packet.ReadAll(PacketData);
 	Packet.CommitRead();
 
-	cByteBuffer Buffer(20);
-	if (PacketData.size() >= 256)
-	{
-		if (!cProtocol_1_9_0::CompressPacket(PacketData, a_Data))
-		{
-			ASSERT(!"Packet compression failed.");
-			a_Data.clear();
-			return;
-		}
-	}
-	else
+	// Frame the packet, compressing it if it is over the server's compression threshold:
+	if (!cProtocol_1_9_0::CompressPacket(PacketData, a_Data))
 	{
-		AString PostData;
-		Buffer.WriteVarInt32(static_cast<UInt32>(Packet.GetUsedSpace() + 1));
-		Buffer.WriteVarInt32(0);
-		Buffer.ReadAll(PostData);
-		Buffer.CommitRead();
-
+		ASSERT(!"Packet compression failed.");
 		a_Data.clear();
-		a_Data.reserve(PostData.size() + PacketData.size());
-		a_Data.append(PostData.data(), PostData.size());
-		a_Data.append(PacketData.data(), PacketData.size());
+		return;
 	}
 }
 
@@ -351,9 +336,11 @@ void cChunkDataSerializer::Serialize110(AString & a_Data, int a_ChunkX, int a_Ch
 			UInt64 TempLong = 0;  // Temporary value that will be stored into
 			UInt64 CurrentlyWrittenIndex = 0;  // "Index" of the long that would be written to
 
+			BLOCKTYPE Buffer[cChunkData::SectionBlockCount];
+			const BLOCKTYPE * BlockTypes = a_Section.GetBlockTypes(Buffer);
 			for (size_t Index = 0; Index < cChunkData::SectionBlockCount; Index++)
 			{
-				UInt64 Value = static_cast<UInt64>(a_Section.m_BlockTypes[Index] << 4);
+				UInt64 Value = static_cast<UInt64>(BlockTypes[Index] << 4);
 				if (Index % 2 == 0)
 				{
 					Value |= a_Section.m_BlockMetas[Index / 2] & 0x0f;
@@ -393,11 +380,11 @@ void cChunkDataSerializer::Serialize110(AString & a_Data, int a_ChunkX, int a_Ch
 			Packet.WriteBEUInt64(TempLong);
 
 			// Write lighting:
-			Packet.WriteBuf(a_Section.m_BlockLight, sizeof(a_Section.m_BlockLight));
+			Packet.WriteBuf(a_Section.GetBlockLight(), cChunkData::SectionNibbleCount);
 			if (m_Dimension == dimOverworld)
 			{
 				// Skylight is only sent in the overworld; the nether and end do not use it
-				Packet.WriteBuf(a_Section.m_BlockSkyLight, sizeof(a_Section.m_BlockSkyLight));
+				Packet.WriteBuf(a_Section.GetSkyLight(), cChunkData::SectionNibbleCount);
 			}
 		}
 	);
@@ -412,28 +399,12 @@ void cChunkDataSerializer::Serialize110(AString & a_Data, int a_ChunkX, int a_Ch
 	Packet.ReadAll(PacketData);
 	Packet.CommitRead();
 
-	cByteBuffer Buffer(20);
-	if (PacketData.size() >= 256)
+	// Frame the packet, compressing it if it is over the server's compression threshold:
+	if (!cProtocol_1_9_0::CompressPacket(PacketData, a_Data))
 	{
-		if (!cProtocol_1_9_0::CompressPacket(PacketData, a_Data))
-		{
-			ASSERT(!"Packet compression failed.");
-			a_Data.clear();
-			return;
-		}
-	}
-	else
-	{
-		AString PostData;
-		Buffer.WriteVarInt32(static_cast<UInt32>(Packet.GetUsedSpace() + 1));
-		Buffer.WriteVarInt32(0);
-		Buffer.ReadAll(PostData);
-		Buffer.CommitRead();
-
+		ASSERT(!"Packet compression failed.");
 		a_Data.clear();
-		a_Data.reserve(PostData.size() + PacketData.size());
-		a_Data.append(PostData.data(), PostData.size());
-		a_Data.append(PacketData.data(), PacketData.size());
+		return;
 	}
 }
 
@@ -10,6 +10,10 @@
 
 
 
+class cChunkDataCache;
+
+
+
 class cChunkDataSerializer
 {
 protected:
@@ -17,7 +21,13 @@ protected:
 	const unsigned char * m_BiomeData;
 	const eDimension m_Dimension;
 
-	typedef std::map<int, AString> Serializations;
+	/** The cache to look the serializations up in and store them to, nullptr if not caching across serializers. */
+	cChunkDataCache * m_Cache;
+
+	/** The generation of the data under which the serializations are cached. */
+	UInt64 m_Generation;
+
+	typedef std::map<int, std::shared_ptr<const AString>> Serializations;
 
 	Serializations m_Serializations;
 
@@ -33,13 +43,20 @@ public:
 		RELEASE_1_9_4 = 110,
 	} ;
 
+	/** Creates a serializer of the specified data.
+	If a_Cache is given, a_Generation is the generation under which the data is cached; when serializing a copy of a chunk's
+	data, this needs to be the chunk's generation at the time of copying, since the copy gets a generation of its own. */
 	cChunkDataSerializer(
 		const cChunkData &    a_Data,
 		const unsigned char * a_BiomeData,
-		const eDimension      a_Dimension
+		const eDimension      a_Dimension,
+		cChunkDataCache *     a_Cache = nullptr,
+		UInt64                a_Generation = 0
 	);
 
-	const AString & Serialize(int a_Version, int a_ChunkX, int a_ChunkZ);  // Returns one of the internal m_Serializations[]
+	/** Returns the serialization for the specified protocol version, as one of the internal m_Serializations[].
+	The string is shared so that it can be queued for sending to multiple clients without copying. Never returns nullptr. */
+	std::shared_ptr<const AString> Serialize(int a_Version, int a_ChunkX, int a_ChunkZ);
 } ;
 
 
@@ -65,38 +65,6 @@ void cForgeHandshake::SetError(const AString & message)
 
 
 
-void cForgeHandshake::AugmentServerListPing(Json::Value & a_ResponseValue)
-{
-	auto ProtocolVersion = m_Client->GetProtocolVersion();
-	auto & Mods = cRoot::Get()->GetServer()->GetRegisteredForgeMods(ProtocolVersion);
-
-	if (Mods.empty())
-	{
-		return;
-	}
-
-	LOGD("Received server ping from version: %d", ProtocolVersion);
-
-	Json::Value Modinfo;
-	Modinfo["type"] = "FML";
-
-	Json::Value ModList(Json::arrayValue);
-	for (auto & item: Mods)
-	{
-		Json::Value Mod;
-		Mod["modid"] = item.first;
-		Mod["version"] = item.second;
-		ModList.append(Mod);
-	}
-	Modinfo["modList"] = ModList;
-
-	a_ResponseValue["modinfo"] = Modinfo;
-}
-
-
-
-
-
 void cForgeHandshake::BeginForgeHandshake(const AString & a_Name, const cUUID & a_UUID, const Json::Value & a_Properties)
 {
 	ASSERT(m_IsForgeClient);
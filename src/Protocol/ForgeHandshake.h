@@ -24,9 +24,6 @@ public:
 
 	cForgeHandshake(cClientHandle * client);
 
-	/** Add the registered Forge mods to the server ping list packet. */
-	void AugmentServerListPing(Json::Value & ResponseValue);
-
 	/** Begin the Forge Modloader Handshake (FML|HS) sequence. */
 	void BeginForgeHandshake(const AString & a_Name, const cUUID & a_UUID, const Json::Value & a_Properties);
 
@@ -0,0 +1,143 @@
+
+// PacketCapture.cpp
+
+// Implements the cPacketCapture class that records a client's game state traffic into a binary file, for replaying in benchmarks
+
+#include "Globals.h"
+#include "PacketCapture.h"
+
+
+
+
+
+/** The magic at the start of each capture file; the trailing digit is the format version. */
+static const char CAPTURE_MAGIC[] = "CUBECAP1";
+static const size_t CAPTURE_MAGIC_SIZE = sizeof(CAPTURE_MAGIC) - 1;
+
+/** The size of the header of a single record: the time, direction and size. */
+static const size_t RECORD_HEADER_SIZE = 8 + 1 + 4;
+
+
+
+
+
+/** Appends the big-endian representation of the lowest a_NumBytes bytes of a_Value to a_Dest. */
+static void AppendBE(AString & a_Dest, UInt64 a_Value, size_t a_NumBytes)
+{
+	for (size_t i = a_NumBytes; i > 0; i--)
+	{
+		a_Dest.push_back(static_cast<char>((a_Value >> (8 * (i - 1))) & 0xff));
+	}
+}
+
+
+
+
+
+/** Reads a big-endian number of a_NumBytes bytes from a_Src at a_Pos. The caller is responsible for checking the size. */
+static UInt64 ReadBE(const AString & a_Src, size_t a_Pos, size_t a_NumBytes)
+{
+	UInt64 Res = 0;
+	for (size_t i = 0; i < a_NumBytes; i++)
+	{
+		Res = (Res << 8) | static_cast<Byte>(a_Src[a_Pos + i]);
+	}
+	return Res;
+}
+
+
+
+
+
+cPacketCapture::cPacketCapture(void) :
+	m_StartTime(std::chrono::steady_clock::now())
+{
+}
+
+
+
+
+
+std::unique_ptr<cPacketCapture> cPacketCapture::Create(const AString & a_ClientIP, UInt32 a_ProtocolVersion, int a_CompressionThreshold)
+{
+	static std::atomic<int> Counter(0);
+	cFile::CreateFolder("PacketCaptures");
+	AString IP(a_ClientIP);
+	ReplaceString(IP, ":", "_");
+	AString FileName = Printf("PacketCaptures/%x_%d__%s.cap",
+		static_cast<unsigned>(time(nullptr)),
+		Counter++,
+		IP.c_str()
+	);
+
+	std::unique_ptr<cPacketCapture> Res(new cPacketCapture);
+	if (!Res->m_File.Open(FileName, cFile::fmWrite))
+	{
+		LOGWARNING("Cannot capture packets, the file \"%s\" cannot be opened for writing.", FileName.c_str());
+		return nullptr;
+	}
+
+	AString Header(CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE);
+	AppendBE(Header, a_ProtocolVersion, 4);
+	AppendBE(Header, static_cast<UInt32>(a_CompressionThreshold), 4);
+	Res->m_File.Write(Header.data(), Header.size());
+	return Res;
+}
+
+
+
+
+
+bool cPacketCapture::Parse(const AString & a_Data, UInt32 & a_ProtocolVersion, int & a_CompressionThreshold, std::vector<sRecord> & a_Records)
+{
+	if ((a_Data.size() < CAPTURE_MAGIC_SIZE + 8) || (a_Data.compare(0, CAPTURE_MAGIC_SIZE, CAPTURE_MAGIC) != 0))
+	{
+		return false;
+	}
+	a_ProtocolVersion = static_cast<UInt32>(ReadBE(a_Data, CAPTURE_MAGIC_SIZE, 4));
+	a_CompressionThreshold = static_cast<int>(static_cast<Int32>(ReadBE(a_Data, CAPTURE_MAGIC_SIZE + 4, 4)));
+
+	size_t Pos = CAPTURE_MAGIC_SIZE + 8;
+	while (a_Data.size() - Pos >= RECORD_HEADER_SIZE)
+	{
+		sRecord Record;
+		Record.m_Time = std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(ReadBE(a_Data, Pos, 8)));
+		auto Direction = ReadBE(a_Data, Pos + 8, 1);
+		size_t Size = static_cast<size_t>(ReadBE(a_Data, Pos + 9, 4));
+		if ((Direction != dirFromClient) && (Direction != dirToClient))
+		{
+			return false;
+		}
+		if (a_Data.size() - Pos - RECORD_HEADER_SIZE < Size)
+		{
+			// The last record is incomplete, the capture was cut short:
+			break;
+		}
+		Record.m_Direction = static_cast<eDirection>(Direction);
+		Record.m_Data.assign(a_Data, Pos + RECORD_HEADER_SIZE, Size);
+		a_Records.push_back(std::move(Record));
+		Pos += RECORD_HEADER_SIZE + Size;
+	}
+	return true;
+}
+
+
+
+
+
+void cPacketCapture::Write(eDirection a_Direction, const char * a_Data, size_t a_Size)
+{
+	cCSLock Lock(m_CS);
+	auto Time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_StartTime);
+	AString Header;
+	Header.reserve(RECORD_HEADER_SIZE);
+	AppendBE(Header, static_cast<UInt64>(Time.count()), 8);
+	AppendBE(Header, static_cast<UInt64>(a_Direction), 1);
+	AppendBE(Header, a_Size, 4);
+	m_File.Write(Header.data(), Header.size());
+	m_File.Write(a_Data, a_Size);
+}
+
+
+
+
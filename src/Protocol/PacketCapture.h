@@ -0,0 +1,89 @@
+
+// PacketCapture.h
+
+// Declares the cPacketCapture class that records a client's game state traffic into a binary file, for replaying in benchmarks
+
+/*
+When the server is started with the --capture-packets switch, each protocol creates a capture once its client
+enters the game state, and writes into it all the data received from and sent to the client, decrypted but
+otherwise exactly as on the wire (framed, with the compression header). That is everything a benchmark needs to
+reproduce the protocol's decoding and encoding work without a real client, e.g. the PacketDecodeBenchmark in tests/Protocol.
+
+The file format:
+	Header:
+		8 bytes: the magic, "CUBECAP1"
+		UInt32: the protocol version of the client
+		Int32:  the compression threshold used by the server
+	Followed by any number of records:
+		UInt64: the time since the capture started, in microseconds
+		UInt8:  the direction, see eDirection
+		UInt32: the size of the data
+		the data
+All numbers are big-endian. The game state traffic contains whole packets only, the records in the outgoing
+direction start and end at packet boundaries; the incoming records are the pieces as received from the network.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../OSSupport/File.h"
+
+
+
+
+
+class cPacketCapture
+{
+public:
+
+	/** The direction of the data in a single record. */
+	enum eDirection
+	{
+		dirFromClient = 0,
+		dirToClient = 1,
+	} ;
+
+	/** A single record of a capture, as read back by Parse(). */
+	struct sRecord
+	{
+		/** The time since the capture started. */
+		std::chrono::microseconds m_Time;
+
+		eDirection m_Direction;
+
+		/** The decrypted data, framed as on the wire. */
+		AString m_Data;
+	} ;
+
+
+	/** Creates a new capture file in the "PacketCaptures" folder, named by the time and the client's IP.
+	Returns nullptr if the file cannot be created. */
+	static std::unique_ptr<cPacketCapture> Create(const AString & a_ClientIP, UInt32 a_ProtocolVersion, int a_CompressionThreshold);
+
+	/** Parses the contents of a capture file. Returns false if the data is not a (complete) capture.
+	A capture that has been cut short (the server was killed) is parsed up to the last complete record. */
+	static bool Parse(const AString & a_Data, UInt32 & a_ProtocolVersion, int & a_CompressionThreshold, std::vector<sRecord> & a_Records);
+
+	/** Writes a single record with the specified data into the capture. Thread-safe. */
+	void Write(eDirection a_Direction, const char * a_Data, size_t a_Size);
+
+protected:
+
+	/** Protects m_File against multithreaded access; the incoming data is written from the network thread and the outgoing data from any thread. */
+	cCriticalSection m_CS;
+
+	cFile m_File;
+
+	/** The time when the capture was created, the records' times are relative to this. */
+	std::chrono::steady_clock::time_point m_StartTime;
+
+
+	cPacketCapture(void);
+} ;
+
+
+
+
@@ -0,0 +1,207 @@
+
+// PacketCompressor.cpp
+
+// Implements the cPacketCompressor class that frames and compresses outgoing packets for a single connection
+
+#include "Globals.h"
+#include "PacketCompressor.h"
+#include "../ByteBuffer.h"
+
+
+
+
+
+cPacketCompressor::cPacketCompressor(int a_Threshold, int a_Level):
+	m_Threshold(a_Threshold),
+	m_Level(a_Level),
+	m_IsStreamInitialized(false)
+{
+	ASSERT(a_Threshold >= 0);
+	ASSERT((a_Level == Z_DEFAULT_COMPRESSION) || ((a_Level >= 0) && (a_Level <= 9)));
+	memset(&m_Stream, 0, sizeof(m_Stream));
+}
+
+
+
+
+
+cPacketCompressor::~cPacketCompressor()
+{
+	if (m_IsStreamInitialized)
+	{
+		deflateEnd(&m_Stream);
+	}
+}
+
+
+
+
+
+bool cPacketCompressor::FramePacket(cByteBuffer & a_Payload, size_t a_Size, bool a_IsCompressionEnabled, const char *& a_Framed, size_t & a_FramedSize)
+{
+	if (a_Payload.GetReadableSpace() < a_Size)
+	{
+		return false;
+	}
+
+	if (a_IsCompressionEnabled && (a_Size >= static_cast<size_t>(m_Threshold)))
+	{
+		// Deflate needs contiguous input, but the bytebuffer may wrap around:
+		if (m_Input.size() < a_Size)
+		{
+			m_Input.resize(a_Size);
+		}
+		VERIFY(a_Payload.ReadBuf(m_Input.data(), a_Size));
+		a_Payload.CommitRead();
+		return FramePacket(m_Input.data(), a_Size, true, a_Framed, a_FramedSize);
+	}
+
+	// Read the payload straight into place behind the header:
+	char * Buffer = GetUncompressedBuffer(a_Size);
+	VERIFY(a_Payload.ReadBuf(Buffer + MAX_HEADER_SIZE, a_Size));
+	a_Payload.CommitRead();
+	a_Framed = WriteHeader(Buffer + MAX_HEADER_SIZE, a_Size, a_IsCompressionEnabled, 0, a_FramedSize);
+	return true;
+}
+
+
+
+
+
+bool cPacketCompressor::FramePacket(const char * a_Payload, size_t a_Size, bool a_IsCompressionEnabled, const char *& a_Framed, size_t & a_FramedSize)
+{
+	if (a_IsCompressionEnabled && (a_Size >= static_cast<size_t>(m_Threshold)))
+	{
+		size_t CompressedSize = Compress(a_Payload, a_Size);
+		if (CompressedSize == 0)
+		{
+			return false;
+		}
+		a_Framed = WriteHeader(m_Output.data() + MAX_HEADER_SIZE, CompressedSize, true, a_Size, a_FramedSize);
+		return true;
+	}
+
+	char * Buffer = GetUncompressedBuffer(a_Size);
+	memcpy(Buffer + MAX_HEADER_SIZE, a_Payload, a_Size);
+	a_Framed = WriteHeader(Buffer + MAX_HEADER_SIZE, a_Size, a_IsCompressionEnabled, 0, a_FramedSize);
+	return true;
+}
+
+
+
+
+
+size_t cPacketCompressor::Compress(const char * a_Payload, size_t a_Size)
+{
+	if (!m_IsStreamInitialized)
+	{
+		if (deflateInit2(&m_Stream, m_Level, Z_DEFLATED, WINDOW_BITS, MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			return 0;
+		}
+		m_IsStreamInitialized = true;
+	}
+	else if (deflateReset(&m_Stream) != Z_OK)
+	{
+		return 0;
+	}
+
+	// Make sure the whole packet can be deflated in a single call:
+	uLong Bound = deflateBound(&m_Stream, static_cast<uLong>(a_Size));
+	if (m_Output.size() < MAX_HEADER_SIZE + Bound)
+	{
+		m_Output.resize(MAX_HEADER_SIZE + Bound);
+	}
+
+	m_Stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(a_Payload));
+	m_Stream.avail_in = static_cast<uInt>(a_Size);
+	m_Stream.next_out = reinterpret_cast<Bytef *>(m_Output.data() + MAX_HEADER_SIZE);
+	m_Stream.avail_out = static_cast<uInt>(Bound);
+	if (deflate(&m_Stream, Z_FINISH) != Z_STREAM_END)
+	{
+		return 0;
+	}
+	return static_cast<size_t>(m_Stream.total_out);
+}
+
+
+
+
+
+char * cPacketCompressor::GetUncompressedBuffer(size_t a_PayloadSize)
+{
+	if (a_PayloadSize <= SMALL_PACKET_SIZE)
+	{
+		return m_SmallBuffer;
+	}
+	if (m_Output.size() < MAX_HEADER_SIZE + a_PayloadSize)
+	{
+		m_Output.resize(MAX_HEADER_SIZE + a_PayloadSize);
+	}
+	return m_Output.data();
+}
+
+
+
+
+
+const char * cPacketCompressor::WriteHeader(char * a_Data, size_t a_DataSize, bool a_IsCompressionEnabled, size_t a_UncompressedSize, size_t & a_FramedSize)
+{
+	// Compressed format:   [PacketLength][DataLength][Data], DataLength is 0 for packets that aren't compressed
+	// Uncompressed format: [PacketLength][Data]
+	UInt32 PacketLength = static_cast<UInt32>(a_DataSize);
+	size_t HeaderSize = 0;
+	if (a_IsCompressionEnabled)
+	{
+		PacketLength += static_cast<UInt32>(GetVarIntSize(static_cast<UInt32>(a_UncompressedSize)));
+		HeaderSize = GetVarIntSize(static_cast<UInt32>(a_UncompressedSize));
+	}
+	HeaderSize += GetVarIntSize(PacketLength);
+	ASSERT(HeaderSize <= MAX_HEADER_SIZE);
+
+	char * Start = a_Data - HeaderSize;
+	char * Pos = WriteVarInt(Start, PacketLength);
+	if (a_IsCompressionEnabled)
+	{
+		Pos = WriteVarInt(Pos, static_cast<UInt32>(a_UncompressedSize));
+	}
+	ASSERT(Pos == a_Data);
+	UNUSED(Pos);
+
+	a_FramedSize = HeaderSize + a_DataSize;
+	return Start;
+}
+
+
+
+
+
+size_t cPacketCompressor::GetVarIntSize(UInt32 a_Value)
+{
+	size_t Res = 1;
+	while (a_Value >= 0x80)
+	{
+		a_Value >>= 7;
+		Res += 1;
+	}
+	return Res;
+}
+
+
+
+
+
+char * cPacketCompressor::WriteVarInt(char * a_Dst, UInt32 a_Value)
+{
+	while (a_Value >= 0x80)
+	{
+		*a_Dst++ = static_cast<char>((a_Value & 0x7f) | 0x80);
+		a_Value >>= 7;
+	}
+	*a_Dst++ = static_cast<char>(a_Value);
+	return a_Dst;
+}
+
+
+
+
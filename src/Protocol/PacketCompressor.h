@@ -0,0 +1,132 @@
+
+// PacketCompressor.h
+
+// Declares the cPacketCompressor class that frames and compresses outgoing packets for a single connection
+
+/*
+Each outgoing packet needs to be prefixed by its length and, once compression is enabled, compressed if it is
+large enough. Instead of compressing each packet with a fresh one-shot compress2() call and copying the result
+around, the compressor keeps a single deflate stream per connection, resets it for each packet and deflates
+directly into its output buffer. The buffer is left enough room in front of the data for the length prefixes,
+which are then written backwards in front of the data once their values are known, so that the framed packet
+is contiguous and can be sent with a single call.
+
+A stream with zlib's default parameters holds about 256 KiB per connection, which adds up with many players
+connected. Since a single packet is compressed at a time and most of them are small, the stream is created with a
+4 KiB window and a reduced hash table instead (WINDOW_BITS, MEM_LEVEL), about 38 KiB in total; even the chunk data
+packets compress only marginally worse, because most of their repetition is short-range. The result is still a
+regular zlib stream that the client inflates with its default settings.
+
+Packets up to SMALL_PACKET_SIZE bytes that aren't compressed are framed in a buffer embedded in the object,
+so that they never touch the heap. Larger packets use scratch buffers that only grow, so once a connection
+has warmed up, framing doesn't allocate at all.
+
+The framed data is only valid until the next FramePacket() call. The object is not thread-safe, the protocol
+calls it with its m_CSPacket locked.
+*/
+
+
+
+
+
+#pragma once
+
+#include "zlib/zlib.h"
+
+
+
+
+
+class cByteBuffer;
+
+
+
+
+
+class cPacketCompressor
+{
+public:
+
+	/** The maximum number of bytes the length prefixes of a single packet take (two VarInt32s). */
+	static const size_t MAX_HEADER_SIZE = 10;
+
+	/** The largest uncompressed payload that is framed in the object's own buffer. */
+	static const size_t SMALL_PACKET_SIZE = 512;
+
+	/** The default minimum payload size for a packet to be compressed; the vanilla server uses the same value. */
+	static const int DEFAULT_THRESHOLD = 256;
+
+	/** The base two logarithm of the deflate window size; zlib's default is 15 (32 KiB). */
+	static const int WINDOW_BITS = 12;
+
+	/** The deflate memory level, affecting the hash table size; zlib's default is 8. */
+	static const int MEM_LEVEL = 5;
+
+
+	/** Creates a compressor that compresses packets of at least a_Threshold bytes using the specified zlib level
+	(Z_DEFAULT_COMPRESSION or 0 - 9). */
+	cPacketCompressor(int a_Threshold, int a_Level);
+
+	~cPacketCompressor();
+
+	/** Returns the minimum payload size of compressed packets. Sent to the client when enabling compression. */
+	int GetThreshold(void) const { return m_Threshold; }
+
+	/** Reads a_Size bytes of packet payload from a_Payload and frames them.
+	If a_IsCompressionEnabled is false, the payload is only prefixed with its length; otherwise the compressed
+	packet format is used and the payload is compressed if it is at least the threshold long.
+	Sets a_Framed to point to the framed data, valid until the next call, and a_FramedSize to its size.
+	The read from a_Payload is committed.
+	Returns false on failure (not enough data in a_Payload, compression error). */
+	bool FramePacket(cByteBuffer & a_Payload, size_t a_Size, bool a_IsCompressionEnabled, const char *& a_Framed, size_t & a_FramedSize);
+
+	/** Same as above, but reads the payload from contiguous memory. */
+	bool FramePacket(const char * a_Payload, size_t a_Size, bool a_IsCompressionEnabled, const char *& a_Framed, size_t & a_FramedSize);
+
+protected:
+
+	/** The minimum payload size for a packet to be compressed. */
+	int m_Threshold;
+
+	/** The zlib compression level. */
+	int m_Level;
+
+	/** The deflate stream reused for all the packets; initialized on first use. */
+	z_stream m_Stream;
+
+	/** True if m_Stream has been initialized by deflateInit2(). */
+	bool m_IsStreamInitialized;
+
+	/** Buffer for framing the small uncompressed packets without touching the heap. */
+	char m_SmallBuffer[MAX_HEADER_SIZE + SMALL_PACKET_SIZE];
+
+	/** Scratch buffer for the large payloads that need to be compressed, read from a cByteBuffer. */
+	std::vector<char> m_Input;
+
+	/** Scratch buffer for the large framed packets. */
+	std::vector<char> m_Output;
+
+
+	/** Deflates the payload into m_Output, after MAX_HEADER_SIZE bytes left for the header.
+	Returns the size of the compressed data, or 0 on failure. */
+	size_t Compress(const char * a_Payload, size_t a_Size);
+
+	/** Returns a buffer of at least MAX_HEADER_SIZE + a_PayloadSize bytes for framing an uncompressed packet. */
+	char * GetUncompressedBuffer(size_t a_PayloadSize);
+
+	/** Writes the length prefixes of the packet right in front of a_Data, which already contains a_DataSize bytes
+	(the payload, or the compressed payload if a_UncompressedSize is nonzero).
+	If a_IsCompressionEnabled is true, the packet uses the compressed format, with a_UncompressedSize as the data length.
+	Returns the start of the framed packet and sets a_FramedSize. a_Data must be preceded by at least MAX_HEADER_SIZE bytes. */
+	static const char * WriteHeader(char * a_Data, size_t a_DataSize, bool a_IsCompressionEnabled, size_t a_UncompressedSize, size_t & a_FramedSize);
+
+	/** Returns the number of bytes needed to write the value as a VarInt. */
+	static size_t GetVarIntSize(UInt32 a_Value);
+
+	/** Writes the value as a VarInt into a_Dst, returns the pointer past the last written byte. */
+	static char * WriteVarInt(char * a_Dst, UInt32 a_Value);
+} ;
+
+
+
+
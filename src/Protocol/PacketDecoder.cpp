@@ -0,0 +1,259 @@
+
+// PacketDecoder.cpp
+
+// Implements the cPacketDecoder class that frames and decompresses incoming game packets on the network thread
+
+#include "Globals.h"
+#include "PacketDecoder.h"
+#include "../ByteBuffer.h"
+#include "../StringCompression.h"
+#include "zlib/zlib.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPacketDecoder:
+
+cPacketDecoder::cPacketDecoder(void):
+	m_Packets(MAX_QUEUED_PACKETS),
+	m_FreeBuffers(MAX_POOLED_BUFFERS),
+	m_ShouldParseMovement(false),
+	m_QueuedBytes(0),
+	m_HasFailed(false),
+	m_IsFailureTaken(false)
+{
+}
+
+
+
+
+
+void cPacketDecoder::SetMovementPacketTypes(UInt32 a_OnGround, UInt32 a_Position, UInt32 a_Look, UInt32 a_PositionLook)
+{
+	m_MovementPacketTypes[mvOnGround] = a_OnGround;
+	m_MovementPacketTypes[mvPosition] = a_Position;
+	m_MovementPacketTypes[mvLook] = a_Look;
+	m_MovementPacketTypes[mvPositionLook] = a_PositionLook;
+	m_ShouldParseMovement = true;
+}
+
+
+
+
+
+bool cPacketDecoder::Decode(cByteBuffer & a_ReceivedData, const char * a_Data, size_t a_Size)
+{
+	if (HasFailed())
+	{
+		return false;
+	}
+	if (!a_ReceivedData.Write(a_Data, a_Size))
+	{
+		return Fail("Too much incoming data");
+	}
+
+	for (;;)
+	{
+		UInt32 PacketLen;
+		if (!a_ReceivedData.ReadVarInt(PacketLen) || !a_ReceivedData.CanReadBytes(PacketLen))
+		{
+			// The full packet hasn't been received yet
+			a_ReceivedData.ResetRead();
+			return true;
+		}
+
+		// Read the compression header:
+		size_t NumBytesBefore = a_ReceivedData.GetReadableSpace();
+		UInt32 UncompressedSize;
+		if (!a_ReceivedData.ReadVarInt(UncompressedSize))
+		{
+			return Fail("Compression packet incomplete");
+		}
+		size_t HeaderSize = NumBytesBefore - a_ReceivedData.GetReadableSpace();
+		if (PacketLen <= HeaderSize)
+		{
+			return Fail("Compression packet incomplete");
+		}
+
+		// Put the packet into a buffer of its own, with room for the extra NUL:
+		sPacket Decoded;
+		if (UncompressedSize > 0)
+		{
+			// Check the declared size first, so that a client can't make the server inflate huge packets:
+			if (UncompressedSize > MAX_UNCOMPRESSED_SIZE)
+			{
+				return Fail("Uncompressed packet too large");
+			}
+			AString Compressed, Uncompressed;
+			VERIFY(a_ReceivedData.ReadString(Compressed, PacketLen - HeaderSize));
+			a_ReceivedData.CommitRead();
+			if (InflateString(Compressed.data(), Compressed.size(), Uncompressed) != Z_OK)
+			{
+				return Fail("Compression failure");
+			}
+			if (Uncompressed.size() != UncompressedSize)
+			{
+				return Fail("Wrong uncompressed packet size given");
+			}
+			Decoded.m_Data = TakeBuffer(Uncompressed.size() + 1);
+			VERIFY(Decoded.m_Data->Write(Uncompressed.data(), Uncompressed.size()));
+		}
+		else
+		{
+			Decoded.m_Data = TakeBuffer(PacketLen - HeaderSize + 1);
+			VERIFY(a_ReceivedData.ReadToByteBuffer(*Decoded.m_Data, PacketLen - HeaderSize));
+			a_ReceivedData.CommitRead();
+		}
+		Decoded.m_PacketLen = static_cast<UInt32>(Decoded.m_Data->GetReadableSpace());
+
+		// Read the packet type before adding the NUL, so that the NUL can't complete a truncated type:
+		if (!Decoded.m_Data->ReadVarInt32(Decoded.m_PacketType))
+		{
+			return Fail("Packet type missing");
+		}
+		eMovementType MovementType = GetMovementType(Decoded.m_PacketType);
+		if (MovementType != mvNone)
+		{
+			// Parse the movement here, the packet must contain exactly the movement fields:
+			if (
+				!ReadMovement(MovementType, *Decoded.m_Data, Decoded.m_Movement) ||
+				(Decoded.m_Data->GetReadableSpace() != 0)
+			)
+			{
+				return Fail("Malformed movement packet");
+			}
+			if (!Decoded.m_Movement.IsValid())
+			{
+				return Fail("Invalid movement");
+			}
+			m_SpareBuffer = std::move(Decoded.m_Data);
+		}
+		else
+		{
+			VERIFY(Decoded.m_Data->Write("\0", 1));
+		}
+
+		// Queue the packet, unless the client is sending more than the tick thread can keep up with:
+		size_t PacketSize = Decoded.m_PacketLen;
+		if (m_QueuedBytes.load() + PacketSize > MAX_QUEUED_BYTES)
+		{
+			return Fail("Too much incoming data");
+		}
+		m_QueuedBytes += PacketSize;
+		if (!m_Packets.Push(std::move(Decoded)))
+		{
+			return Fail("Too many packets");
+		}
+	}
+}
+
+
+
+
+
+bool cPacketDecoder::Pop(sPacket & a_Packet)
+{
+	if (!m_Packets.Pop(a_Packet))
+	{
+		return false;
+	}
+	m_QueuedBytes -= a_Packet.m_PacketLen;
+	return true;
+}
+
+
+
+
+
+void cPacketDecoder::Recycle(sPacket && a_Packet)
+{
+	if ((a_Packet.m_Data == nullptr) || (a_Packet.m_Data->GetBufferSize() != POOLED_BUFFER_SIZE))
+	{
+		// Not a pooled buffer, let it be freed:
+		a_Packet.m_Data.reset();
+		return;
+	}
+
+	// If the pool is full, the buffer is left in a_Packet and freed with it:
+	m_FreeBuffers.Push(std::move(a_Packet.m_Data));
+}
+
+
+
+
+
+bool cPacketDecoder::TakeFailure(AString & a_Reason)
+{
+	if (m_IsFailureTaken || !m_HasFailed.load())
+	{
+		return false;
+	}
+	m_IsFailureTaken = true;
+	a_Reason = m_FailureReason;
+	return true;
+}
+
+
+
+
+
+std::unique_ptr<cByteBuffer> cPacketDecoder::TakeBuffer(size_t a_Size)
+{
+	if (a_Size > POOLED_BUFFER_SIZE)
+	{
+		return cpp14::make_unique<cByteBuffer>(a_Size);
+	}
+	std::unique_ptr<cByteBuffer> Buffer;
+	if ((m_SpareBuffer != nullptr) && (m_SpareBuffer->GetBufferSize() == POOLED_BUFFER_SIZE))
+	{
+		Buffer = std::move(m_SpareBuffer);
+		Buffer->Clear();
+		return Buffer;
+	}
+	if (m_FreeBuffers.Pop(Buffer))
+	{
+		Buffer->Clear();
+		return Buffer;
+	}
+	return cpp14::make_unique<cByteBuffer>(POOLED_BUFFER_SIZE);
+}
+
+
+
+
+
+cPacketDecoder::eMovementType cPacketDecoder::GetMovementType(UInt32 a_PacketType) const
+{
+	if (!m_ShouldParseMovement)
+	{
+		return mvNone;
+	}
+	for (int Type = mvOnGround; Type <= mvPositionLook; Type++)
+	{
+		if (m_MovementPacketTypes[Type] == a_PacketType)
+		{
+			return static_cast<eMovementType>(Type);
+		}
+	}
+	return mvNone;
+}
+
+
+
+
+
+bool cPacketDecoder::Fail(const AString & a_Reason)
+{
+	if (!m_HasFailed.load())
+	{
+		m_FailureReason = a_Reason;
+		m_HasFailed.store(true);
+	}
+	return false;
+}
+
+
+
+
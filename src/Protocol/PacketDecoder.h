@@ -0,0 +1,236 @@
+
+// PacketDecoder.h
+
+// Declares the cPacketDecoder class that frames and decompresses incoming game packets on the network thread
+
+/*
+Once a client reaches the game state, its incoming data is no longer parsed in the tick thread. Instead, the
+network thread that receives the data decrypts it (in the protocol) and passes it to Decode(), which splits it
+into packets, decompresses them and checks their sizes. Each packet is then pushed, as a (type, buffer) record,
+into a lock-free single-producer single-consumer queue. The tick thread pops the records and only runs the
+packet handlers on them.
+
+Each packet is written, exactly once, into a cByteBuffer of its own that is laid out the way the packet handlers
+expect it, so the tick thread handles the packet in place without copying it; the handlers of the most frequent
+packets read it through a cByteView over the buffer's storage. The sizes are known from the framing before the
+buffer is taken, so the buffer never needs to grow. Small packets, which are nearly all the client
+sends, use buffers from a pool: the tick thread returns the handled packets using Recycle(), through a second
+lock-free queue going in the opposite direction, and the network thread reuses their buffers for the next packets.
+
+The player movement packets, which make up most of the client's traffic, are parsed on the network thread, too,
+once the protocol has told the decoder their packet types (SetMovementPacketTypes()). Their fields are read and
+validated into an sMovement record, which is queued instead of the packet's buffer, so the tick thread only applies
+the movement.
+
+Malformed data (bad framing, decompression errors, oversized packets, movement packets of the wrong size or with
+coords that aren't finite or are out of the world) and floods (the queue filling up faster than the tick thread
+drains it) are detected on the network thread. The decoder then stops decoding any further
+data and stores the reason; the tick thread picks it up using TakeFailure() and kicks the client. The bad data
+never reaches the tick thread.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../OSSupport/SpscQueue.h"
+#include "../ByteBuffer.h"
+
+
+
+
+
+class cPacketDecoder
+{
+public:
+
+	/** The player movement packets, the same in all the protocol versions apart from their packet types. */
+	enum eMovementType
+	{
+		mvNone,          ///< Not a movement packet
+		mvOnGround,      ///< Player: the on-ground flag only
+		mvPosition,      ///< Player Position: position and on-ground
+		mvLook,          ///< Player Look: yaw, pitch and on-ground
+		mvPositionLook,  ///< Player Position And Look: all of the above
+	};
+
+
+	/** The fields of a player movement packet. */
+	struct sMovement
+	{
+		eMovementType m_Type;
+		double m_PosX;
+		double m_PosY;
+		double m_PosZ;
+		float m_Yaw;
+		float m_Pitch;
+		bool m_IsOnGround;
+
+		sMovement(void):
+			m_Type(mvNone),
+			m_PosX(0),
+			m_PosY(0),
+			m_PosZ(0),
+			m_Yaw(0),
+			m_Pitch(0),
+			m_IsOnGround(false)
+		{
+		}
+
+		/** Returns true if all the values are finite and the position is within MAX_MOVEMENT_COORD in each axis.
+		A NaN position would pass all the distance checks in cClientHandle, since all comparisons with NaN are false. */
+		bool IsValid(void) const
+		{
+			return (
+				IsValidCoord(m_PosX) && IsValidCoord(m_PosY) && IsValidCoord(m_PosZ) &&
+				std::isfinite(m_Yaw) && std::isfinite(m_Pitch)
+			);
+		}
+
+		static bool IsValidCoord(double a_Coord)
+		{
+			return (std::isfinite(a_Coord) && (std::abs(a_Coord) <= MAX_MOVEMENT_COORD));
+		}
+	};
+
+
+	/** A single packet decoded from the incoming data, waiting to be handled in the tick thread. */
+	struct sPacket
+	{
+		/** The packet type (ID), already read from the packet. */
+		UInt32 m_PacketType;
+
+		/** The size of the packet, including the type. */
+		UInt32 m_PacketLen;
+
+		/** The packet, including the type, followed by an extra NUL to detect over-reads.
+		The read position is right after the type; ResetRead() goes back to the type.
+		nullptr for a movement packet that has been parsed into m_Movement. */
+		std::unique_ptr<cByteBuffer> m_Data;
+
+		/** The parsed and validated movement, if m_Movement.m_Type isn't mvNone. */
+		sMovement m_Movement;
+	};
+
+
+	/** The maximum number of packets waiting in the queue. A vanilla client sends a few dozen packets per tick at most. */
+	static const size_t MAX_QUEUED_PACKETS = 1024;
+
+	/** The maximum number of payload bytes waiting in the queue. */
+	static const size_t MAX_QUEUED_BYTES = 1 MiB;
+
+	/** The maximum size of a decompressed packet, the same limit as used by the vanilla server. */
+	static const UInt32 MAX_UNCOMPRESSED_SIZE = 2 MiB;
+
+	/** The size of the pooled packet buffers. Larger packets get a buffer of their own that isn't reused. */
+	static const size_t POOLED_BUFFER_SIZE = 1 KiB;
+
+	/** The maximum number of buffers waiting to be reused. */
+	static const size_t MAX_POOLED_BUFFERS = 64;
+
+	/** The maximum absolute value of the movement coords; a bit over the vanilla world border at 30 million blocks.
+	Keeps the block coords computed from the position well within an int. */
+	static const int MAX_MOVEMENT_COORD = 32000000;
+
+
+	cPacketDecoder(void);
+
+	/** Appends the (decrypted) data to a_ReceivedData, decodes all complete packets in there and queues them.
+	The packets are expected to use the game state framing, with the compression header.
+	Returns false if the data is malformed or the queue is full; the decoder is then failed and ignores all further data.
+	Only call from a single thread at a time (the producer side of the queue). */
+	bool Decode(cByteBuffer & a_ReceivedData, const char * a_Data, size_t a_Size);
+
+	/** Sets the packet types of the movement packets, so that Decode() parses them into sMovement records.
+	Until called, the movement packets are queued as any other packets. Call before the decoding starts. */
+	void SetMovementPacketTypes(UInt32 a_OnGround, UInt32 a_Position, UInt32 a_Look, UInt32 a_PositionLook);
+
+	/** Reads the fields of the movement packet of the specified type into a_Movement.
+	a_Packet is either a cByteBuffer or a cByteView, read right after the packet type.
+	Returns false if the packet is incomplete. The values aren't validated, use sMovement::IsValid(). */
+	template <class PacketReader>
+	static bool ReadMovement(eMovementType a_Type, PacketReader & a_Packet, sMovement & a_Movement)
+	{
+		a_Movement.m_Type = a_Type;
+		if ((a_Type == mvPosition) || (a_Type == mvPositionLook))
+		{
+			if (
+				!a_Packet.ReadBEDouble(a_Movement.m_PosX) ||
+				!a_Packet.ReadBEDouble(a_Movement.m_PosY) ||
+				!a_Packet.ReadBEDouble(a_Movement.m_PosZ)
+			)
+			{
+				return false;
+			}
+		}
+		if ((a_Type == mvLook) || (a_Type == mvPositionLook))
+		{
+			if (!a_Packet.ReadBEFloat(a_Movement.m_Yaw) || !a_Packet.ReadBEFloat(a_Movement.m_Pitch))
+			{
+				return false;
+			}
+		}
+		return a_Packet.ReadBool(a_Movement.m_IsOnGround);
+	}
+
+	/** Moves the next decoded packet into a_Packet. Returns false if there's none.
+	Only call from the tick thread (the consumer side of the queue). */
+	bool Pop(sPacket & a_Packet);
+
+	/** Returns the packet's buffer to the pool, once the packet has been handled.
+	Only call from the tick thread (the consumer side of the queue). */
+	void Recycle(sPacket && a_Packet);
+
+	/** Returns true if the decoder has failed. Any further data is ignored by Decode(). */
+	bool HasFailed(void) const { return m_HasFailed.load(); }
+
+	/** If the decoder has failed and the failure hasn't been taken yet, stores the reason in a_Reason and returns true.
+	Returns false otherwise, so the failure is reported only once. Only call from the tick thread. */
+	bool TakeFailure(AString & a_Reason);
+
+protected:
+
+	/** The decoded packets waiting to be handled. */
+	cSpscQueue<sPacket> m_Packets;
+
+	/** The buffers of the handled packets, waiting to be reused by Decode(). */
+	cSpscQueue<std::unique_ptr<cByteBuffer>> m_FreeBuffers;
+
+	/** The buffer of the last parsed movement packet, which never left the decoding thread. Reused first by TakeBuffer(). */
+	std::unique_ptr<cByteBuffer> m_SpareBuffer;
+
+	/** The packet types of the movement packets, indexed by eMovementType; unused for mvNone. */
+	UInt32 m_MovementPacketTypes[mvPositionLook + 1];
+
+	/** Set by SetMovementPacketTypes(); until then, the movement packets aren't parsed. */
+	bool m_ShouldParseMovement;
+
+	/** The total size of the packets in m_Packets. Limits the memory a flooding client can take. */
+	std::atomic<size_t> m_QueuedBytes;
+
+	/** Set when malformed data or a flood has been detected. */
+	std::atomic<bool> m_HasFailed;
+
+	/** The reason for the failure. Written by the decoding thread before m_HasFailed is set, read-only afterwards. */
+	AString m_FailureReason;
+
+	/** Set once TakeFailure() has reported the failure. Only used in the tick thread. */
+	bool m_IsFailureTaken;
+
+
+	/** Returns an empty buffer that can hold at least a_Size bytes, reusing a pooled one if possible.
+	Only call from the decoding thread. */
+	std::unique_ptr<cByteBuffer> TakeBuffer(size_t a_Size);
+
+	/** Returns the movement type of the packet type, mvNone if it isn't a movement packet or they aren't parsed. */
+	eMovementType GetMovementType(UInt32 a_PacketType) const;
+
+	/** Marks the decoder as failed, for the specified reason. Returns false, so that the callers can "return Fail(...)". */
+	bool Fail(const AString & a_Reason);
+} ;
+
+
+
+
@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include "Packetizer.h"
 #include "UUID.h"
+#include "../ClientHandle.h"
 
 
 
@@ -17,6 +18,7 @@
 cPacketizer::~cPacketizer()
 {
 	m_Protocol.SendPacket(*this);
+	m_Protocol.m_Client->PacketSent();
 }
 
 
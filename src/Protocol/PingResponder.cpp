@@ -0,0 +1,213 @@
+
+// PingResponder.cpp
+
+// Implements the cPingResponder class that answers server list pings on the network thread
+
+#include "Globals.h"
+#include "PingResponder.h"
+#include "StatusResponseCache.h"
+
+
+
+
+
+/** The maximum size of the data kept by the responder. A handshake is a few hundred bytes,
+anything larger is left for the protocol to deal with. */
+static const size_t MAX_BUFFERED_DATA = 4 KiB;
+
+
+
+
+
+cPingResponder::cPingResponder(cStatusResponseCache & a_Cache, bool a_ShouldAnswerStatus) :
+	m_Cache(a_Cache),
+	m_ShouldAnswerStatus(a_ShouldAnswerStatus),
+	m_State(stUndecided),
+	m_Buffer(MAX_BUFFERED_DATA),
+	m_ProtocolVersion(0)
+{
+}
+
+
+
+
+
+cPingResponder::eResult cPingResponder::ProcessData(const char * a_Data, size_t a_Size, AString & a_Response)
+{
+	switch (m_State)
+	{
+		case stUndecided:
+		{
+			if (!m_Buffer.Write(a_Data, a_Size))
+			{
+				// Too much data for a handshake:
+				m_State = stDone;
+				return prNotAPing;
+			}
+			return ProcessHandshake(a_Response);
+		}
+		case stStatus:
+		{
+			if (!m_Buffer.Write(a_Data, a_Size))
+			{
+				// The client is sending something else than the tiny status packets:
+				m_State = stDone;
+				return prFinished;
+			}
+			return ProcessStatusPackets(a_Response);
+		}
+		case stDone:
+		{
+			// The link is being closed, ignore anything more:
+			return prResponded;
+		}
+	}
+	ASSERT(!"Unhandled responder state");
+	return prFinished;
+}
+
+
+
+
+
+cPingResponder::eResult cPingResponder::ProcessHandshake(AString & a_Response)
+{
+	UInt8 FirstByte;
+	if (!m_Buffer.ReadBEUInt8(FirstByte))
+	{
+		return prUndecided;
+	}
+	if (FirstByte == 0xfe)
+	{
+		// Legacy ping. Beta 1.8 - 1.3 clients send just this byte, 1.4 and later follow it with 0x01 and possibly more data:
+		UInt8 Payload;
+		bool IsExtended = (m_Buffer.ReadBEUInt8(Payload) && (Payload == 0x01));
+		a_Response.append(*m_Cache.GetLegacyResponse(IsExtended));
+		m_State = stDone;
+		return prFinished;
+	}
+	m_Buffer.ResetRead();
+
+	// Lengthed handshake packet, wait until it's complete:
+	UInt32 PacketLen;
+	if (!m_Buffer.ReadVarInt(PacketLen) || !m_Buffer.CanReadBytes(PacketLen))
+	{
+		m_Buffer.ResetRead();
+		return prUndecided;
+	}
+	size_t PacketEnd = m_Buffer.GetReadableSpace() - PacketLen;
+
+	UInt32 PacketType, ProtocolVersion, NextState;
+	AString ServerAddress;
+	UInt16 ServerPort;
+	if (
+		!m_Buffer.ReadVarInt(PacketType) ||
+		(PacketType != 0x00) ||
+		!m_Buffer.ReadVarInt(ProtocolVersion) ||
+		!m_Buffer.ReadVarUTF8String(ServerAddress) ||
+		!m_Buffer.ReadBEUInt16(ServerPort) ||
+		!m_Buffer.ReadVarInt(NextState) ||
+		(m_Buffer.GetReadableSpace() != PacketEnd)
+	)
+	{
+		// Not a handshake we understand, let the protocol recognizer deal with it:
+		m_State = stDone;
+		return prNotAPing;
+	}
+	if ((NextState != 1) || !m_ShouldAnswerStatus)
+	{
+		// A login, or a ping that a plugin wants to see:
+		m_State = stDone;
+		return prNotAPing;
+	}
+	m_Buffer.CommitRead();
+	m_ProtocolVersion = ProtocolVersion;
+	m_State = stStatus;
+
+	// The client usually sends the status request right after the handshake:
+	return ProcessStatusPackets(a_Response);
+}
+
+
+
+
+
+cPingResponder::eResult cPingResponder::ProcessStatusPackets(AString & a_Response)
+{
+	for (;;)
+	{
+		UInt32 PacketLen;
+		if (!m_Buffer.ReadVarInt(PacketLen) || !m_Buffer.CanReadBytes(PacketLen))
+		{
+			// Not a complete packet, wait for more data:
+			m_Buffer.ResetRead();
+			return prResponded;
+		}
+		size_t PacketEnd = m_Buffer.GetReadableSpace() - PacketLen;
+		UInt32 PacketType;
+		if (!m_Buffer.ReadVarInt(PacketType))
+		{
+			m_State = stDone;
+			return prFinished;
+		}
+		switch (PacketType)
+		{
+			case 0x00:
+			{
+				// Status request, answer with the cached status:
+				auto Status = m_Cache.GetResponse(m_ProtocolVersion);
+				cByteBuffer Length(8);
+				Length.WriteVarInt32(static_cast<UInt32>(Status->size()));
+				AString Payload;
+				Length.ReadAll(Payload);
+				Payload.append(*Status);
+				AppendPacket(a_Response, 0x00, Payload.data(), Payload.size());
+				break;
+			}
+			case 0x01:
+			{
+				// Ping, echo the timestamp back. The ping is over after that:
+				AString Timestamp;
+				if (!m_Buffer.ReadString(Timestamp, 8) || (m_Buffer.GetReadableSpace() != PacketEnd))
+				{
+					m_State = stDone;
+					return prFinished;
+				}
+				AppendPacket(a_Response, 0x01, Timestamp.data(), Timestamp.size());
+				m_State = stDone;
+				return prFinished;
+			}
+			default:
+			{
+				// Only the two packets are valid in the status state:
+				m_State = stDone;
+				return prFinished;
+			}
+		}
+		if (m_Buffer.GetReadableSpace() != PacketEnd)
+		{
+			m_State = stDone;
+			return prFinished;
+		}
+		m_Buffer.CommitRead();
+	}
+}
+
+
+
+
+
+void cPingResponder::AppendPacket(AString & a_Response, UInt32 a_PacketType, const char * a_Payload, size_t a_PayloadSize)
+{
+	cByteBuffer Header(16);
+	Header.WriteVarInt32(static_cast<UInt32>(cByteBuffer::GetVarIntSize(a_PacketType) + a_PayloadSize));
+	Header.WriteVarInt32(a_PacketType);
+	AString HeaderData;
+	Header.ReadAll(HeaderData);
+	a_Response.append(HeaderData);
+	a_Response.append(a_Payload, a_PayloadSize);
+}
+
+
+
+
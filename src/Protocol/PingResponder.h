@@ -0,0 +1,98 @@
+
+// PingResponder.h
+
+// Declares the cPingResponder class that answers server list pings on the network thread
+
+/*
+A server list ping is a short connection of its own: the client sends the handshake with the status state,
+asks for the status, optionally pings for the latency and disconnects. None of that needs the tick thread,
+the worlds or (unless they hook the ping) the plugins, so cClientHandle feeds the first data of each new
+connection into a cPingResponder right on the network thread. The responder looks at the handshake; for a
+status ping it answers everything from the cStatusResponseCache, the data is never queued for the tick thread
+and no protocol object gets involved. Anything else is reported as not a ping and the client handle lets the
+protocol recognizer in the tick thread handle the data as usual.
+
+Legacy pings (the 0xfe packet sent by pre-1.7 clients, and by the newer ones as a fallback) are always answered
+from the cache, the regular protocols don't support them.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../ByteBuffer.h"
+
+
+
+
+
+// fwd:
+class cStatusResponseCache;
+
+
+
+
+
+class cPingResponder
+{
+public:
+
+	/** The outcome of processing a piece of incoming data. */
+	enum eResult
+	{
+		prUndecided,  ///< The handshake is not complete yet, keep the data in case it's not a ping
+		prNotAPing,   ///< The connection is not a ping that can be answered here, hand all its data to the protocol
+		prResponded,  ///< The data was a part of a ping and has been processed; send the response, if any
+		prFinished,   ///< The ping is over (or the client sent garbage); send the response, if any, and close the link
+	} ;
+
+
+	/** Creates a new responder for a single connection.
+	If a_ShouldAnswerStatus is false (a plugin wants to see each ping), only the legacy pings are answered and
+	the modern status pings are reported as not a ping. */
+	cPingResponder(cStatusResponseCache & a_Cache, bool a_ShouldAnswerStatus);
+
+	/** Processes the data received from the client.
+	Any data that is to be sent back to the client is appended to a_Response. */
+	eResult ProcessData(const char * a_Data, size_t a_Size, AString & a_Response);
+
+protected:
+
+	enum eState
+	{
+		stUndecided,  ///< Waiting for the complete handshake
+		stStatus,     ///< The handshake asked for the status state, answering the status packets
+		stDone,       ///< Not a ping, or the ping is over; ignoring any further data
+	} ;
+
+
+	/** The cache providing the responses. */
+	cStatusResponseCache & m_Cache;
+
+	/** If false, the modern status pings are left for the protocol in the tick thread. */
+	bool m_ShouldAnswerStatus;
+
+	eState m_State;
+
+	/** The data received that hasn't been processed yet. */
+	cByteBuffer m_Buffer;
+
+	/** The protocol version sent in the handshake. */
+	UInt32 m_ProtocolVersion;
+
+
+	/** Looks at the handshake (if complete) and decides whether the connection is a ping. */
+	eResult ProcessHandshake(AString & a_Response);
+
+	/** Answers all the complete status packets in m_Buffer. */
+	eResult ProcessStatusPackets(AString & a_Response);
+
+	/** Appends a packet with the specified type and payload to a_Response, using the uncompressed framing. */
+	static void AppendPacket(AString & a_Response, UInt32 a_PacketType, const char * a_Payload, size_t a_PayloadSize);
+} ;
+
+
+
+
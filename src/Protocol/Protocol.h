@@ -10,10 +10,12 @@
 
 #pragma once
 
+#include <functional>
 #include "../Defines.h"
 #include "../Scoreboard.h"
 #include "../ByteBuffer.h"
 #include "../EffectID.h"
+#include "../OSSupport/SendChain.h"
 
 
 
@@ -131,6 +133,17 @@ public:
 	/** Called when client sends some data */
 	virtual void DataReceived(const char * a_Data, size_t a_Size) = 0;
 
+	/** Returns true if the incoming data can be decoded by DecodeReceivedData() on the network thread from now on.
+	That is the case once the client is in the game state; the earlier states are parsed by DataReceived() in the tick thread. */
+	virtual bool CanDecodeAsync(void) = 0;
+
+	/** Decrypts the received data, decodes it into packets and queues them for HandleDecodedPackets().
+	Called on the network thread, only once CanDecodeAsync() has returned true. */
+	virtual void DecodeReceivedData(const char * a_Data, size_t a_Size) = 0;
+
+	/** Handles the packets queued by DecodeReceivedData(), kicks the client if the decoding failed. Called in the tick thread. */
+	virtual void HandleDecodedPackets(void) = 0;
+
 	// Sending stuff to clients (alphabetically sorted):
 	virtual void SendAttachEntity               (const cEntity & a_Entity, const cEntity & a_Vehicle) = 0;
 	virtual void SendBlockAction                (int a_BlockX, int a_BlockY, int a_BlockZ, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType) = 0;
@@ -221,6 +234,19 @@ public:
 	/** Returns the ServerID used for authentication through session.minecraft.net */
 	virtual AString GetAuthServerID(void) = 0;
 
+	/** Returns a key identifying how the packets are encoded for this client. Clients with the same nonzero key
+	receive byte-identical framed packets (before encryption), so a broadcast packet can be serialized once for all of them.
+	Returns 0 if the client can't share broadcast packets (not in the game state yet). */
+	virtual UInt32 GetBroadcastKey(void) = 0;
+
+	/** Calls a_SendFn, which is expected to send packets to this client through the regular SendXYZ() functions,
+	and captures the framed packets. The captured packets are then sent to this client and returned (unencrypted),
+	so that they can be sent to the other clients with the same broadcast key using SendEncodedBroadcast(). */
+	virtual cSendChain::cSlicePtr EncodeBroadcast(const std::function<void()> & a_SendFn) = 0;
+
+	/** Sends the packets returned by EncodeBroadcast() of a client with the same broadcast key. */
+	virtual void SendEncodedBroadcast(const cSendChain::cSlicePtr & a_Data) = 0;
+
 protected:
 	friend class cPacketizer;
 
@@ -1007,6 +1007,70 @@ AString cProtocolRecognizer::GetAuthServerID(void)
 
 
 
+bool cProtocolRecognizer::CanDecodeAsync(void)
+{
+	return ((m_Protocol != nullptr) && m_Protocol->CanDecodeAsync());
+}
+
+
+
+
+
+void cProtocolRecognizer::DecodeReceivedData(const char * a_Data, size_t a_Size)
+{
+	ASSERT(m_Protocol != nullptr);
+	m_Protocol->DecodeReceivedData(a_Data, a_Size);
+}
+
+
+
+
+
+void cProtocolRecognizer::HandleDecodedPackets(void)
+{
+	if (m_Protocol != nullptr)
+	{
+		m_Protocol->HandleDecodedPackets();
+	}
+}
+
+
+
+
+
+UInt32 cProtocolRecognizer::GetBroadcastKey(void)
+{
+	if (m_Protocol == nullptr)
+	{
+		return 0;
+	}
+	return m_Protocol->GetBroadcastKey();
+}
+
+
+
+
+
+cSendChain::cSlicePtr cProtocolRecognizer::EncodeBroadcast(const std::function<void()> & a_SendFn)
+{
+	ASSERT(m_Protocol != nullptr);
+	return m_Protocol->EncodeBroadcast(a_SendFn);
+}
+
+
+
+
+
+void cProtocolRecognizer::SendEncodedBroadcast(const cSendChain::cSlicePtr & a_Data)
+{
+	ASSERT(m_Protocol != nullptr);
+	m_Protocol->SendEncodedBroadcast(a_Data);
+}
+
+
+
+
+
 void cProtocolRecognizer::SendData(const char * a_Data, size_t a_Size)
 {
 	// This is used only when handling the server ping
@@ -1186,43 +1250,9 @@ void cProtocolRecognizer::SendPacket(cPacketizer & a_Pkt)
 
 void cProtocolRecognizer::HandlePacketStatusRequest(void)
 {
-	cServer * Server = cRoot::Get()->GetServer();
-	AString ServerDescription = Server->GetDescription();
-	auto NumPlayers = static_cast<signed>(Server->GetNumPlayers());
-	auto MaxPlayers = static_cast<signed>(Server->GetMaxPlayers());
-	AString Favicon = Server->GetFaviconData();
-	cRoot::Get()->GetPluginManager()->CallHookServerPing(*m_Client, ServerDescription, NumPlayers, MaxPlayers, Favicon);
-
-	// Version:
-	Json::Value Version;
-	Version["name"] = "Cuberite " MCS_CLIENT_VERSIONS;
-	Version["protocol"] = MCS_LATEST_PROTOCOL_VERSION;
-
-	// Players:
-	Json::Value Players;
-	Players["online"] = NumPlayers;
-	Players["max"] = MaxPlayers;
-	// TODO: Add "sample"
-
-	// Description:
-	Json::Value Description;
-	Description["text"] = ServerDescription.c_str();
-
-	// Create the response:
-	Json::Value ResponseValue;
-	ResponseValue["version"] = Version;
-	ResponseValue["players"] = Players;
-	ResponseValue["description"] = Description;
-	if (!Favicon.empty())
-	{
-		ResponseValue["favicon"] = Printf("data:image/png;base64,%s", Favicon.c_str());
-	}
-
-	Json::FastWriter Writer;
-	AString Response = Writer.write(ResponseValue);
-
+	// The client's version is not supported, the response lists the supported ones:
 	cPacketizer Pkt(*this, 0x00);  // Response packet
-	Pkt.WriteString(Response);
+	Pkt.WriteString(cRoot::Get()->GetServer()->GetStatusResponse(*m_Client, m_Client->GetProtocolVersion()));
 }
 
 
@@ -56,6 +56,11 @@ public:
 	/** Called when client sends some data: */
 	virtual void DataReceived(const char * a_Data, size_t a_Size) override;
 
+	/** Decoding the game state packets on the network thread (see cPacketDecoder): */
+	virtual bool CanDecodeAsync(void) override;
+	virtual void DecodeReceivedData(const char * a_Data, size_t a_Size) override;
+	virtual void HandleDecodedPackets(void) override;
+
 	/** Sending stuff to clients (alphabetically sorted): */
 	virtual void SendAttachEntity               (const cEntity & a_Entity, const cEntity & a_Vehicle) override;
 	virtual void SendBlockAction                (int a_BlockX, int a_BlockY, int a_BlockZ, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType) override;
@@ -145,6 +150,10 @@ public:
 
 	virtual AString GetAuthServerID(void) override;
 
+	virtual UInt32 GetBroadcastKey(void) override;
+	virtual cSendChain::cSlicePtr EncodeBroadcast(const std::function<void()> & a_SendFn) override;
+	virtual void SendEncodedBroadcast(const cSendChain::cSlicePtr & a_Data) override;
+
 	virtual void SendData(const char * a_Data, size_t a_Size) override;
 
 protected:
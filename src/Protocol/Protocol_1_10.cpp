@@ -9,6 +9,7 @@ Implements the 1.10 protocol classes:
 
 #include "Globals.h"
 #include "Protocol_1_10.h"
+#include "ProtocolRecognizer.h"
 #include "Packetizer.h"
 
 #include "json/json.h"
@@ -320,44 +321,8 @@ void cProtocol_1_10_0::SendSoundEffect(const AString & a_SoundName, double a_X,
 
 void cProtocol_1_10_0::HandlePacketStatusRequest(cByteBuffer & a_ByteBuffer)
 {
-	cServer * Server = cRoot::Get()->GetServer();
-	AString ServerDescription = Server->GetDescription();
-	auto NumPlayers = static_cast<signed>(Server->GetNumPlayers());
-	auto MaxPlayers = static_cast<signed>(Server->GetMaxPlayers());
-	AString Favicon = Server->GetFaviconData();
-	cRoot::Get()->GetPluginManager()->CallHookServerPing(*m_Client, ServerDescription, NumPlayers, MaxPlayers, Favicon);
-
-	// Version:
-	Json::Value Version;
-	Version["name"] = "Cuberite 1.10";
-	Version["protocol"] = 210;
-
-	// Players:
-	Json::Value Players;
-	Players["online"] = NumPlayers;
-	Players["max"] = MaxPlayers;
-	// TODO: Add "sample"
-
-	// Description:
-	Json::Value Description;
-	Description["text"] = ServerDescription.c_str();
-
-	// Create the response:
-	Json::Value ResponseValue;
-	ResponseValue["version"] = Version;
-	ResponseValue["players"] = Players;
-	ResponseValue["description"] = Description;
-	m_Client->ForgeAugmentServerListPing(ResponseValue);
-	if (!Favicon.empty())
-	{
-		ResponseValue["favicon"] = Printf("data:image/png;base64,%s", Favicon.c_str());
-	}
-
-	Json::FastWriter Writer;
-	AString Response = Writer.write(ResponseValue);
-
 	cPacketizer Pkt(*this, 0x00);  // Response packet
-	Pkt.WriteString(Response);
+	Pkt.WriteString(cRoot::Get()->GetServer()->GetStatusResponse(*m_Client, cProtocolRecognizer::PROTO_VERSION_1_10_0));
 }
 
 
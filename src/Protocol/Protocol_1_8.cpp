@@ -10,10 +10,12 @@ Implements the 1.8 protocol classes:
 #include "Globals.h"
 #include "json/json.h"
 #include "Protocol_1_8.h"
+#include "ProtocolRecognizer.h"
 #include "ChunkDataSerializer.h"
 #include "mbedTLS++/Sha1Checksum.h"
 #include "Packetizer.h"
 
+#include "../ByteView.h"
 #include "../ClientHandle.h"
 #include "../Root.h"
 #include "../Server.h"
@@ -87,14 +89,13 @@ static const Int16 SLOT_NUM_OUTSIDE = -999;
 
 
 const int MAX_ENC_LEN = 512;  // Maximum size of the encrypted message; should be 128, but who knows...
-const uLongf MAX_COMPRESSED_PACKET_LEN = 200 KiB;  // Maximum size of compressed packets.
 
 
 
 
 
 // fwd: main.cpp:
-extern bool g_ShouldLogCommIn, g_ShouldLogCommOut;
+extern bool g_ShouldLogCommIn, g_ShouldLogCommOut, g_ShouldCapturePackets;
 
 
 
@@ -109,7 +110,9 @@ cProtocol_1_8_0::cProtocol_1_8_0(cClientHandle * a_Client, const AString & a_Ser
 	m_ServerPort(a_ServerPort),
 	m_State(a_State),
 	m_ReceivedData(32 KiB),
-	m_IsEncrypted(false)
+	m_IsEncrypted(false),
+	m_Compressor(cRoot::Get()->GetServer()->GetCompressionThreshold(), cRoot::Get()->GetServer()->GetCompressionLevel()),
+	m_BroadcastCapture(nullptr)
 {
 
 	// BungeeCord handling:
@@ -146,6 +149,12 @@ cProtocol_1_8_0::cProtocol_1_8_0(cClientHandle * a_Client, const AString & a_Ser
 			LOG("Cannot log communication to file, the log file \"%s\" cannot be opened for writing.", FileName.c_str());
 		}
 	}
+
+	// Parse the movement packets on the network thread, unless they need to be comm-logged along with the other packets:
+	if (!g_ShouldLogCommIn)
+	{
+		m_Decoder.SetMovementPacketTypes(0x03, 0x04, 0x05, 0x06);
+	}
 }
 
 
@@ -176,6 +185,152 @@ void cProtocol_1_8_0::DataReceived(const char * a_Data, size_t a_Size)
 
 
 
+bool cProtocol_1_8_0::CanDecodeAsync(void)
+{
+	return (m_State == 3);
+}
+
+
+
+
+
+void cProtocol_1_8_0::DecodeReceivedData(const char * a_Data, size_t a_Size)
+{
+	ASSERT(m_State == 3);
+	if (!m_IsEncrypted)
+	{
+		if (m_PacketCapture != nullptr)
+		{
+			m_PacketCapture->Write(cPacketCapture::dirFromClient, a_Data, a_Size);
+		}
+		m_Decoder.Decode(m_ReceivedData, a_Data, a_Size);
+		return;
+	}
+
+	// Decrypt in larger pieces than DataReceived(), the network thread has the stack to spare and the decryptor runs faster on longer data:
+	Byte Decrypted[4096];
+	while (a_Size > 0)
+	{
+		size_t NumBytes = (a_Size > sizeof(Decrypted)) ? sizeof(Decrypted) : a_Size;
+		m_Decryptor.ProcessData(Decrypted, reinterpret_cast<const Byte *>(a_Data), NumBytes);
+		if (m_PacketCapture != nullptr)
+		{
+			m_PacketCapture->Write(cPacketCapture::dirFromClient, reinterpret_cast<const char *>(Decrypted), NumBytes);
+		}
+		if (!m_Decoder.Decode(m_ReceivedData, reinterpret_cast<const char *>(Decrypted), NumBytes))
+		{
+			return;
+		}
+		a_Size -= NumBytes;
+		a_Data += NumBytes;
+	}
+}
+
+
+
+
+
+void cProtocol_1_8_0::HandleDecodedPackets(void)
+{
+	cPacketDecoder::sPacket Packet;
+	while (m_Decoder.Pop(Packet))
+	{
+		bool IsHandled = HandleDecodedPacket(Packet);
+		m_Decoder.Recycle(std::move(Packet));
+		if (!IsHandled)
+		{
+			return;
+		}
+	}
+
+	AString Reason;
+	if (m_Decoder.TakeFailure(Reason))
+	{
+		LOGWARNING("Protocol 1.8: Bad data from client \"%s\" @ %s (%s), kicking.",
+			m_Client->GetUsername().c_str(), m_Client->GetIPString().c_str(), Reason.c_str()
+		);
+		m_Client->Kick(Reason);
+	}
+}
+
+
+
+
+
+bool cProtocol_1_8_0::HandleDecodedPacket(cPacketDecoder::sPacket & a_Packet)
+{
+	if (a_Packet.m_Movement.m_Type != cPacketDecoder::mvNone)
+	{
+		// Already parsed and validated on the network thread:
+		HandleMovement(a_Packet.m_Movement);
+		return true;
+	}
+
+	// The decoder has laid the packet out the same way AddReceivedData() does, handle it in place:
+	return HandleFramedPacket(*a_Packet.m_Data, a_Packet.m_PacketType, a_Packet.m_PacketLen);
+}
+
+
+
+
+
+void cProtocol_1_8_0::HandleMovement(const cPacketDecoder::sMovement & a_Movement)
+{
+	switch (a_Movement.m_Type)
+	{
+		case cPacketDecoder::mvOnGround:
+		{
+			// TODO: m_Client->HandlePlayerOnGround(a_Movement.m_IsOnGround);
+			break;
+		}
+		case cPacketDecoder::mvPosition:
+		{
+			m_Client->HandlePlayerPos(a_Movement.m_PosX, a_Movement.m_PosY, a_Movement.m_PosZ, a_Movement.m_PosY + (m_Client->GetPlayer()->IsCrouched() ? 1.54 : 1.62), a_Movement.m_IsOnGround);
+			break;
+		}
+		case cPacketDecoder::mvLook:
+		{
+			m_Client->HandlePlayerLook(a_Movement.m_Yaw, a_Movement.m_Pitch, a_Movement.m_IsOnGround);
+			break;
+		}
+		case cPacketDecoder::mvPositionLook:
+		{
+			m_Client->HandlePlayerMoveLook(a_Movement.m_PosX, a_Movement.m_PosY, a_Movement.m_PosZ, a_Movement.m_PosY + 1.62, a_Movement.m_Yaw, a_Movement.m_Pitch, a_Movement.m_IsOnGround);
+			break;
+		}
+		case cPacketDecoder::mvNone:
+		{
+			ASSERT(!"Not a movement");
+			break;
+		}
+	}
+}
+
+
+
+
+
+void cProtocol_1_8_0::HandleMovementPacket(cByteBuffer & a_ByteBuffer, cPacketDecoder::eMovementType a_Type)
+{
+	cByteView Packet = a_ByteBuffer.GetReadView();
+	cPacketDecoder::sMovement Movement;
+	if (!cPacketDecoder::ReadMovement(a_Type, Packet, Movement))
+	{
+		return;
+	}
+	a_ByteBuffer.SkipRead(Packet.GetReadSize());
+	if (!Movement.IsValid())
+	{
+		m_Client->Kick("Invalid movement");
+		return;
+	}
+	HandleMovement(Movement);
+}
+
+
+
+
+
 void cProtocol_1_8_0::SendAttachEntity(const cEntity & a_Entity, const cEntity & a_Vehicle)
 {
 	ASSERT(m_State == 3);  // In game mode?
@@ -304,10 +459,12 @@ void cProtocol_1_8_0::SendChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataSerial
 
 	// Serialize first, before creating the Packetizer (the packetizer locks a CS)
 	// This contains the flags and bitmasks, too
-	const AString & ChunkData = a_Serializer.Serialize(cChunkDataSerializer::RELEASE_1_8_0, a_ChunkX, a_ChunkZ);
+	auto ChunkData = a_Serializer.Serialize(cChunkDataSerializer::RELEASE_1_8_0, a_ChunkX, a_ChunkZ);
 
 	cCSLock Lock(m_CSPacket);
-	SendData(ChunkData.data(), ChunkData.size());
+	SendSharedData(ChunkData);
+	m_Client->ChunkDataQueued(ChunkData->size());
+	m_Client->PacketSent();
 }
 
 
@@ -705,11 +862,17 @@ void cProtocol_1_8_0::SendLoginSuccess(void)
 	// Enable compression:
 	{
 		cPacketizer Pkt(*this, 0x03);  // Set compression packet
-		Pkt.WriteVarInt32(256);
+		Pkt.WriteVarInt32(static_cast<UInt32>(m_Compressor.GetThreshold()));
 	}
 
 	m_State = 3;  // State = Game
 
+	// Capture the game state traffic, if so requested:
+	if (g_ShouldCapturePackets)
+	{
+		m_PacketCapture = cPacketCapture::Create(m_Client->GetIPString(), m_Client->GetProtocolVersion(), m_Compressor.GetThreshold());
+	}
+
 	{
 		cPacketizer Pkt(*this, 0x02);  // Login success packet
 		Pkt.WriteString(m_Client->GetUUID().ToLongString());
@@ -1705,40 +1868,15 @@ void cProtocol_1_8_0::SendWindowProperty(const cWindow & a_Window, short a_Prope
 
 bool cProtocol_1_8_0::CompressPacket(const AString & a_Packet, AString & a_CompressedData)
 {
-	// Compress the data:
-	char CompressedData[MAX_COMPRESSED_PACKET_LEN];
-
-	uLongf CompressedSize = compressBound(static_cast<uLongf>(a_Packet.size()));
-	if (CompressedSize >= MAX_COMPRESSED_PACKET_LEN)
+	// Used for the cached chunk data, so it cannot use any connection's compressor:
+	cPacketCompressor Compressor(cRoot::Get()->GetServer()->GetCompressionThreshold(), cRoot::Get()->GetServer()->GetCompressionLevel());
+	const char * Framed;
+	size_t FramedSize;
+	if (!Compressor.FramePacket(a_Packet.data(), a_Packet.size(), true, Framed, FramedSize))
 	{
-		ASSERT(!"Too high packet size.");
 		return false;
 	}
-
-	int Status = compress2(
-		reinterpret_cast<Bytef *>(CompressedData), &CompressedSize,
-		reinterpret_cast<const Bytef *>(a_Packet.data()), static_cast<uLongf>(a_Packet.size()), Z_DEFAULT_COMPRESSION
-	);
-	if (Status != Z_OK)
-	{
-		return false;
-	}
-
-	AString LengthData;
-	cByteBuffer Buffer(20);
-	Buffer.WriteVarInt32(static_cast<UInt32>(a_Packet.size()));
-	Buffer.ReadAll(LengthData);
-	Buffer.CommitRead();
-
-	Buffer.WriteVarInt32(static_cast<UInt32>(CompressedSize + LengthData.size()));
-	Buffer.WriteVarInt32(static_cast<UInt32>(a_Packet.size()));
-	Buffer.ReadAll(LengthData);
-	Buffer.CommitRead();
-
-	a_CompressedData.clear();
-	a_CompressedData.reserve(LengthData.size() + CompressedSize);
-	a_CompressedData.append(LengthData.data(), LengthData.size());
-	a_CompressedData.append(CompressedData, CompressedSize);
+	a_CompressedData.assign(Framed, FramedSize);
 	return true;
 }
 
@@ -1855,6 +1993,11 @@ void cProtocol_1_8_0::FixItemFramePositions(int a_ObjectData, double & a_PosX, d
 
 void cProtocol_1_8_0::AddReceivedData(const char * a_Data, size_t a_Size)
 {
+	if (m_PacketCapture != nullptr)
+	{
+		m_PacketCapture->Write(cPacketCapture::dirFromClient, a_Data, a_Size);
+	}
+
 	// Write the incoming data into the comm log file:
 	if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 	{
@@ -1964,67 +2107,10 @@ void cProtocol_1_8_0::AddReceivedData(const char * a_Data, size_t a_Size)
 		// Write one NUL extra, so that we can detect over-reads
 		bb.Write("\0", 1);
 
-		// Log the packet info into the comm log file:
-		if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
-		{
-			AString PacketData;
-			bb.ReadAll(PacketData);
-			bb.ResetRead();
-			bb.ReadVarInt(PacketType);  // We have already read the packet type once, it will be there again
-			ASSERT(PacketData.size() > 0);  // We have written an extra NUL, so there had to be at least one byte read
-			PacketData.resize(PacketData.size() - 1);
-			AString PacketDataHex;
-			CreateHexDump(PacketDataHex, PacketData.data(), PacketData.size(), 16);
-			m_CommLogFile.Printf("Next incoming packet is type %u (0x%x), length %u (0x%x) at state %d. Payload:\n%s\n",
-				PacketType, PacketType, PacketLen, PacketLen, m_State, PacketDataHex.c_str()
-			);
-		}
-
-		if (!HandlePacket(bb, PacketType))
+		if (!HandleFramedPacket(bb, PacketType, PacketLen))
 		{
-			// Unknown packet, already been reported, but without the length. Log the length here:
-			LOGWARNING("Unhandled packet: type 0x%x, state %d, length %u", PacketType, m_State, PacketLen);
-
-			#ifdef _DEBUG
-				// Dump the packet contents into the log:
-				bb.ResetRead();
-				AString Packet;
-				bb.ReadAll(Packet);
-				Packet.resize(Packet.size() - 1);  // Drop the final NUL pushed there for over-read detection
-				AString Out;
-				CreateHexDump(Out, Packet.data(), Packet.size(), 24);
-				LOGD("Packet contents:\n%s", Out.c_str());
-			#endif  // _DEBUG
-
-			// Put a message in the comm log:
-			if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
-			{
-				m_CommLogFile.Printf("^^^^^^ Unhandled packet ^^^^^^\n\n\n");
-			}
-
 			return;
 		}
-
-		// The packet should have 1 byte left in the buffer - the NUL we had added
-		if (bb.GetReadableSpace() != 1)
-		{
-			// Read more or less than packet length, report as error
-			LOGWARNING("Protocol 1.8: Wrong number of bytes read for packet 0x%x, state %d. Read " SIZE_T_FMT " bytes, packet contained %u bytes",
-				PacketType, m_State, bb.GetUsedSpace() - bb.GetReadableSpace(), PacketLen
-			);
-
-			// Put a message in the comm log:
-			if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
-			{
-				m_CommLogFile.Printf("^^^^^^ Wrong number of bytes read for this packet (exp %d left, got " SIZE_T_FMT " left) ^^^^^^\n\n\n",
-					1, bb.GetReadableSpace()
-				);
-				m_CommLogFile.Flush();
-			}
-
-			ASSERT(!"Read wrong number of bytes!");
-			m_Client->PacketError(PacketType);
-		}
 	}  // for (ever)
 
 	// Log any leftover bytes into the logfile:
@@ -2048,6 +2134,76 @@ void cProtocol_1_8_0::AddReceivedData(const char * a_Data, size_t a_Size)
 
 
 
+bool cProtocol_1_8_0::HandleFramedPacket(cByteBuffer & a_Packet, UInt32 a_PacketType, UInt32 a_PacketLen)
+{
+	// Log the packet info into the comm log file:
+	if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
+	{
+		AString PacketData;
+		a_Packet.ReadAll(PacketData);
+		a_Packet.ResetRead();
+		a_Packet.ReadVarInt(a_PacketType);  // We have already read the packet type once, it will be there again
+		ASSERT(PacketData.size() > 0);  // We have written an extra NUL, so there had to be at least one byte read
+		PacketData.resize(PacketData.size() - 1);
+		AString PacketDataHex;
+		CreateHexDump(PacketDataHex, PacketData.data(), PacketData.size(), 16);
+		m_CommLogFile.Printf("Next incoming packet is type %u (0x%x), length %u (0x%x) at state %d. Payload:\n%s\n",
+			a_PacketType, a_PacketType, a_PacketLen, a_PacketLen, m_State, PacketDataHex.c_str()
+		);
+	}
+
+	if (!HandlePacket(a_Packet, a_PacketType))
+	{
+		// Unknown packet, already been reported, but without the length. Log the length here:
+		LOGWARNING("Unhandled packet: type 0x%x, state %d, length %u", a_PacketType, m_State, a_PacketLen);
+
+		#ifdef _DEBUG
+			// Dump the packet contents into the log:
+			a_Packet.ResetRead();
+			AString Packet;
+			a_Packet.ReadAll(Packet);
+			Packet.resize(Packet.size() - 1);  // Drop the final NUL pushed there for over-read detection
+			AString Out;
+			CreateHexDump(Out, Packet.data(), Packet.size(), 24);
+			LOGD("Packet contents:\n%s", Out.c_str());
+		#endif  // _DEBUG
+
+		// Put a message in the comm log:
+		if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
+		{
+			m_CommLogFile.Printf("^^^^^^ Unhandled packet ^^^^^^\n\n\n");
+		}
+
+		return false;
+	}
+
+	// The packet should have 1 byte left in the buffer - the NUL we had added
+	if (a_Packet.GetReadableSpace() != 1)
+	{
+		// Read more or less than packet length, report as error
+		LOGWARNING("Protocol 1.8: Wrong number of bytes read for packet 0x%x, state %d. Read " SIZE_T_FMT " bytes, packet contained %u bytes",
+			a_PacketType, m_State, a_Packet.GetUsedSpace() - a_Packet.GetReadableSpace(), a_PacketLen
+		);
+
+		// Put a message in the comm log:
+		if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
+		{
+			m_CommLogFile.Printf("^^^^^^ Wrong number of bytes read for this packet (exp %d left, got " SIZE_T_FMT " left) ^^^^^^\n\n\n",
+				1, a_Packet.GetReadableSpace()
+			);
+			m_CommLogFile.Flush();
+		}
+
+		ASSERT(!"Read wrong number of bytes!");
+		m_Client->PacketError(a_PacketType);
+	}
+	return true;
+}
+
+
+
+
+
 bool cProtocol_1_8_0::HandlePacket(cByteBuffer & a_ByteBuffer, UInt32 a_PacketType)
 {
 	switch (m_State)
@@ -2149,44 +2305,8 @@ void cProtocol_1_8_0::HandlePacketStatusPing(cByteBuffer & a_ByteBuffer)
 
 void cProtocol_1_8_0::HandlePacketStatusRequest(cByteBuffer & a_ByteBuffer)
 {
-	cServer * Server = cRoot::Get()->GetServer();
-	AString ServerDescription = Server->GetDescription();
-	auto NumPlayers = static_cast<signed>(Server->GetNumPlayers());
-	auto MaxPlayers = static_cast<signed>(Server->GetMaxPlayers());
-	AString Favicon = Server->GetFaviconData();
-	cRoot::Get()->GetPluginManager()->CallHookServerPing(*m_Client, ServerDescription, NumPlayers, MaxPlayers, Favicon);
-
-	// Version:
-	Json::Value Version;
-	Version["name"] = "Cuberite 1.8";
-	Version["protocol"] = 47;
-
-	// Players:
-	Json::Value Players;
-	Players["online"] = NumPlayers;
-	Players["max"] = MaxPlayers;
-	// TODO: Add "sample"
-
-	// Description:
-	Json::Value Description;
-	Description["text"] = ServerDescription.c_str();
-
-	// Create the response:
-	Json::Value ResponseValue;
-	ResponseValue["version"] = Version;
-	ResponseValue["players"] = Players;
-	ResponseValue["description"] = Description;
-	m_Client->ForgeAugmentServerListPing(ResponseValue);
-	if (!Favicon.empty())
-	{
-		ResponseValue["favicon"] = Printf("data:image/png;base64,%s", Favicon.c_str());
-	}
-
-	Json::FastWriter Writer;
-	AString Response = Writer.write(ResponseValue);
-
 	cPacketizer Pkt(*this, 0x00);  // Response packet
-	Pkt.WriteString(Response);
+	Pkt.WriteString(cRoot::Get()->GetServer()->GetStatusResponse(*m_Client, cProtocolRecognizer::PROTO_VERSION_1_8_0));
 }
 
 
@@ -2451,8 +2571,7 @@ void cProtocol_1_8_0::HandlePacketKeepAlive(cByteBuffer & a_ByteBuffer)
 
 void cProtocol_1_8_0::HandlePacketPlayer(cByteBuffer & a_ByteBuffer)
 {
-	HANDLE_READ(a_ByteBuffer, ReadBool, bool, IsOnGround);
-	// TODO: m_Client->HandlePlayerOnGround(IsOnGround);
+	HandleMovementPacket(a_ByteBuffer, cPacketDecoder::mvOnGround);
 }
 
 
@@ -2485,10 +2604,7 @@ void cProtocol_1_8_0::HandlePacketPlayerAbilities(cByteBuffer & a_ByteBuffer)
 
 void cProtocol_1_8_0::HandlePacketPlayerLook(cByteBuffer & a_ByteBuffer)
 {
-	HANDLE_READ(a_ByteBuffer, ReadBEFloat, float, Yaw);
-	HANDLE_READ(a_ByteBuffer, ReadBEFloat, float, Pitch);
-	HANDLE_READ(a_ByteBuffer, ReadBool,    bool,  IsOnGround);
-	m_Client->HandlePlayerLook(Yaw, Pitch, IsOnGround);
+	HandleMovementPacket(a_ByteBuffer, cPacketDecoder::mvLook);
 }
 
 
@@ -2497,11 +2613,7 @@ void cProtocol_1_8_0::HandlePacketPlayerLook(cByteBuffer & a_ByteBuffer)
 
 void cProtocol_1_8_0::HandlePacketPlayerPos(cByteBuffer & a_ByteBuffer)
 {
-	HANDLE_READ(a_ByteBuffer, ReadBEDouble, double, PosX);
-	HANDLE_READ(a_ByteBuffer, ReadBEDouble, double, PosY);
-	HANDLE_READ(a_ByteBuffer, ReadBEDouble, double, PosZ);
-	HANDLE_READ(a_ByteBuffer, ReadBool,     bool,   IsOnGround);
-	m_Client->HandlePlayerPos(PosX, PosY, PosZ, PosY + (m_Client->GetPlayer()->IsCrouched() ? 1.54 : 1.62), IsOnGround);
+	HandleMovementPacket(a_ByteBuffer, cPacketDecoder::mvPosition);
 }
 
 
@@ -2510,13 +2622,7 @@ void cProtocol_1_8_0::HandlePacketPlayerPos(cByteBuffer & a_ByteBuffer)
 
 void cProtocol_1_8_0::HandlePacketPlayerPosLook(cByteBuffer & a_ByteBuffer)
 {
-	HANDLE_READ(a_ByteBuffer, ReadBEDouble, double, PosX);
-	HANDLE_READ(a_ByteBuffer, ReadBEDouble, double, PosY);
-	HANDLE_READ(a_ByteBuffer, ReadBEDouble, double, PosZ);
-	HANDLE_READ(a_ByteBuffer, ReadBEFloat,  float,  Yaw);
-	HANDLE_READ(a_ByteBuffer, ReadBEFloat,  float,  Pitch);
-	HANDLE_READ(a_ByteBuffer, ReadBool,     bool,   IsOnGround);
-	m_Client->HandlePlayerMoveLook(PosX, PosY, PosZ, PosY + 1.62, Yaw, Pitch, IsOnGround);
+	HandleMovementPacket(a_ByteBuffer, cPacketDecoder::mvPositionLook);
 }
 
 
@@ -2829,6 +2935,11 @@ void cProtocol_1_8_0::HandleVanillaPluginMessage(cByteBuffer & a_ByteBuffer, con
 
 void cProtocol_1_8_0::SendData(const char * a_Data, size_t a_Size)
 {
+	if (m_PacketCapture != nullptr)
+	{
+		m_PacketCapture->Write(cPacketCapture::dirToClient, a_Data, a_Size);
+	}
+
 	if (m_IsEncrypted)
 	{
 		Byte Encrypted[8192];  // Larger buffer, we may be sending lots of data (chunks)
@@ -2851,6 +2962,75 @@ void cProtocol_1_8_0::SendData(const char * a_Data, size_t a_Size)
 
 
 
+UInt32 cProtocol_1_8_0::GetBroadcastKey(void)
+{
+	if (m_State != 3)
+	{
+		return 0;
+	}
+
+	// All in-game packets use the compressed format with the server-wide threshold and level,
+	// so the protocol version alone determines the encoding; the low bit marks the compressed format:
+	return (m_Client->GetProtocolVersion() << 1) | 1;
+}
+
+
+
+
+
+cSendChain::cSlicePtr cProtocol_1_8_0::EncodeBroadcast(const std::function<void()> & a_SendFn)
+{
+	ASSERT(GetBroadcastKey() != 0);
+
+	cCSLock Lock(m_CSPacket);
+	ASSERT(m_BroadcastCapture == nullptr);
+	AString Encoded;
+	m_BroadcastCapture = &Encoded;
+	a_SendFn();
+	m_BroadcastCapture = nullptr;
+
+	auto Res = std::make_shared<const AString>(std::move(Encoded));
+	SendSharedData(Res);
+	return Res;
+}
+
+
+
+
+
+void cProtocol_1_8_0::SendEncodedBroadcast(const cSendChain::cSlicePtr & a_Data)
+{
+	ASSERT(GetBroadcastKey() != 0);
+
+	cCSLock Lock(m_CSPacket);
+	SendSharedData(a_Data);
+	m_Client->PacketSent();
+}
+
+
+
+
+
+void cProtocol_1_8_0::SendSharedData(const cSendChain::cSlicePtr & a_Data)
+{
+	if (m_IsEncrypted)
+	{
+		SendData(a_Data->data(), a_Data->size());
+	}
+	else
+	{
+		if (m_PacketCapture != nullptr)
+		{
+			m_PacketCapture->Write(cPacketCapture::dirToClient, a_Data->data(), a_Data->size());
+		}
+		m_Client->SendSharedData(a_Data);
+	}
+}
+
+
+
+
+
 bool cProtocol_1_8_0::ReadItem(cByteBuffer & a_ByteBuffer, cItem & a_Item, size_t a_KeepRemainingBytes)
 {
 	HANDLE_PACKET_READ(a_ByteBuffer, ReadBEInt16, Int16, ItemType);
@@ -3007,57 +3187,34 @@ eBlockFace cProtocol_1_8_0::FaceIntToBlockFace(Int8 a_BlockFace)
 void cProtocol_1_8_0::SendPacket(cPacketizer & a_Pkt)
 {
 	UInt32 PacketLen = static_cast<UInt32>(m_OutPacketBuffer.GetUsedSpace());
-	AString PacketData, CompressedPacket;
-	m_OutPacketBuffer.ReadAll(PacketData);
-	m_OutPacketBuffer.CommitRead();
-
-	if ((m_State == 3) && (PacketLen >= 256))
-	{
-		// Compress the packet payload:
-		if (!cProtocol_1_8_0::CompressPacket(PacketData, CompressedPacket))
-		{
-			return;
-		}
-	}
-	else if (m_State == 3)
-	{
-		// The packet is not compressed, indicate this in the packet header:
-		m_OutPacketLenBuffer.WriteVarInt32(PacketLen + 1);
-		m_OutPacketLenBuffer.WriteVarInt32(0);
-		AString LengthData;
-		m_OutPacketLenBuffer.ReadAll(LengthData);
-		SendData(LengthData.data(), LengthData.size());
-	}
-	else
-	{
-		// Compression doesn't apply to this state, send raw data:
-		m_OutPacketLenBuffer.WriteVarInt32(PacketLen);
-		AString LengthData;
-		m_OutPacketLenBuffer.ReadAll(LengthData);
-		SendData(LengthData.data(), LengthData.size());
-	}
-
-	// Send the packet's payload, either direct or compressed:
-	if (CompressedPacket.empty())
-	{
-		m_OutPacketLenBuffer.CommitRead();
-		SendData(PacketData.data(), PacketData.size());
-	}
-	else
-	{
-		SendData(CompressedPacket.data(), CompressedPacket.size());
-	}
 
 	// Log the comm into logfile:
 	if (g_ShouldLogCommOut && m_CommLogFile.IsOpen())
 	{
-		AString Hex;
+		AString PacketData, Hex;
+		m_OutPacketBuffer.ReadAll(PacketData);
+		m_OutPacketBuffer.ResetRead();
 		ASSERT(PacketData.size() > 0);
 		CreateHexDump(Hex, PacketData.data(), PacketData.size(), 16);
 		m_CommLogFile.Printf("Outgoing packet: type %d (0x%x), length %u (0x%x), state %d. Payload (incl. type):\n%s\n",
 			a_Pkt.GetPacketType(), a_Pkt.GetPacketType(), PacketLen, PacketLen, m_State, Hex.c_str()
 		);
 	}
+
+	// Frame the packet, compressing it if it is large enough and the compression is enabled (State = Game):
+	const char * Framed;
+	size_t FramedSize;
+	if (!m_Compressor.FramePacket(m_OutPacketBuffer, PacketLen, (m_State == 3), Framed, FramedSize))
+	{
+		m_OutPacketBuffer.CommitRead();
+		return;
+	}
+	if (m_BroadcastCapture != nullptr)
+	{
+		m_BroadcastCapture->append(Framed, FramedSize);
+		return;
+	}
+	SendData(Framed, FramedSize);
 }
 
 
@@ -37,6 +37,9 @@ Declares the 1.9 protocol classes:
 
 #include "mbedTLS++/AesCfb128Decryptor.h"
 #include "mbedTLS++/AesCfb128Encryptor.h"
+#include "PacketCompressor.h"
+#include "PacketDecoder.h"
+#include "PacketCapture.h"
 
 
 
@@ -54,6 +57,11 @@ public:
 	/** Called when client sends some data: */
 	virtual void DataReceived(const char * a_Data, size_t a_Size) override;
 
+	/** Decoding the game state packets on the network thread (see cPacketDecoder): */
+	virtual bool CanDecodeAsync(void) override;
+	virtual void DecodeReceivedData(const char * a_Data, size_t a_Size) override;
+	virtual void HandleDecodedPackets(void) override;
+
 	/** Sending stuff to clients (alphabetically sorted): */
 	virtual void SendAttachEntity               (const cEntity & a_Entity, const cEntity & a_Vehicle) override;
 	virtual void SendBlockAction                (int a_BlockX, int a_BlockY, int a_BlockZ, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType) override;
@@ -143,8 +151,13 @@ public:
 
 	virtual AString GetAuthServerID(void) override { return m_AuthServerID; }
 
-	/** Compress the packet. a_Packet must be without packet length.
-	a_Compressed will be set to the compressed packet includes packet length and data length.
+	virtual UInt32 GetBroadcastKey(void) override;
+	virtual cSendChain::cSlicePtr EncodeBroadcast(const std::function<void()> & a_SendFn) override;
+	virtual void SendEncodedBroadcast(const cSendChain::cSlicePtr & a_Data) override;
+
+	/** Frames the packet for sending once compression has been enabled, compressing it if it is at least
+	the server's compression threshold long. a_Packet must be without packet length.
+	a_Compressed will be set to the framed packet, including the packet length and data length.
 	If compression fails, the function returns false. */
 	static bool CompressPacket(const AString & a_Packet, AString & a_Compressed);
 
@@ -177,12 +190,45 @@ protected:
 	cAesCfb128Decryptor m_Decryptor;
 	cAesCfb128Encryptor m_Encryptor;
 
+	/** Frames and compresses the outgoing packets, reusing its deflate stream and buffers across packets. */
+	cPacketCompressor m_Compressor;
+
+	/** Decodes the incoming game state packets on the network thread, see CanDecodeAsync(). */
+	cPacketDecoder m_Decoder;
+
+	/** While EncodeBroadcast() is running, the framed packets are appended here instead of being sent.
+	nullptr otherwise. Protected by m_CSPacket. */
+	AString * m_BroadcastCapture;
+
 	/** The logfile where the comm is logged, when g_ShouldLogComm is true */
 	cFile m_CommLogFile;
 
+	/** The capture of the game state traffic, when g_ShouldCapturePackets is true; nullptr otherwise. */
+	std::unique_ptr<cPacketCapture> m_PacketCapture;
+
+	/** Sets the packet types of the movement packets for m_Decoder to parse on the network thread, unless comm-logging the incoming packets.
+	Called from the constructors, the descendants call it again with their own packet types. */
+	void SetMovementPacketTypes(UInt32 a_OnGround, UInt32 a_Position, UInt32 a_Look, UInt32 a_PositionLook);
+
 	/** Adds the received (unencrypted) data to m_ReceivedData, parses complete packets */
 	void AddReceivedData(const char * a_Data, size_t a_Size);
 
+	/** Logs the packet into the comm log, handles it and checks that all of its data has been read.
+	a_Packet contains the whole packet, read up to the payload, with an extra NUL at the end to detect over-reads.
+	Returns false if the packet was not understood, in which case no further packets should be handled. */
+	bool HandleFramedPacket(cByteBuffer & a_Packet, UInt32 a_PacketType, UInt32 a_PacketLen);
+
+	/** Handles a packet popped from m_Decoder: applies the movement parsed by the decoder, or handles the packet in place.
+	Returns false if the packet was not understood, in which case no further packets should be handled. */
+	bool HandleDecodedPacket(cPacketDecoder::sPacket & a_Packet);
+
+	/** Applies the player movement, parsed either by m_Decoder or by HandleMovementPacket(). */
+	void HandleMovement(const cPacketDecoder::sMovement & a_Movement);
+
+	/** Reads and validates the movement packet of the specified type that hasn't been parsed by m_Decoder, then applies it.
+	Kicks the client if the values are invalid. */
+	void HandleMovementPacket(cByteBuffer & a_ByteBuffer, cPacketDecoder::eMovementType a_Type);
+
 	/** Get the packet ID for a given packet */
 	virtual UInt32 GetPacketId(eOutgoingPackets a_Packet) override;
 
@@ -236,6 +282,10 @@ protected:
 	/** Sends the data to the client, encrypting them if needed. */
 	virtual void SendData(const char * a_Data, size_t a_Size) override;
 
+	/** Sends the data shared with other clients, such as a cached chunk serialization.
+	Unencrypted connections queue it without copying, encrypted ones need to encrypt a private copy. */
+	void SendSharedData(const cSendChain::cSlicePtr & a_Data);
+
 	/** Sends the packet to the client. Called by the cPacketizer's destructor. */
 	virtual void SendPacket(cPacketizer & a_Packet) override;
 
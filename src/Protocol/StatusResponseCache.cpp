@@ -0,0 +1,261 @@
+
+// StatusResponseCache.cpp
+
+// Implements the cStatusResponseCache class that keeps the serialized server list ping responses
+
+#include "Globals.h"
+#include "StatusResponseCache.h"
+#include "json/json.h"
+#include "ProtocolRecognizer.h"
+
+
+
+
+
+cStatusResponseCache::cStatusResponseCache(void) :
+	m_NumPlayers(0),
+	m_MaxPlayers(0)
+{
+}
+
+
+
+
+
+void cStatusResponseCache::SetDescription(const AString & a_Description)
+{
+	cCSLock Lock(m_CS);
+	if (m_Description != a_Description)
+	{
+		m_Description = a_Description;
+		Invalidate();
+	}
+}
+
+
+
+
+
+void cStatusResponseCache::SetFavicon(const AString & a_FaviconData)
+{
+	cCSLock Lock(m_CS);
+	if (m_FaviconData != a_FaviconData)
+	{
+		m_FaviconData = a_FaviconData;
+		Invalidate();
+	}
+}
+
+
+
+
+
+void cStatusResponseCache::SetPlayerCounts(int a_NumPlayers, int a_MaxPlayers)
+{
+	cCSLock Lock(m_CS);
+	if ((m_NumPlayers != a_NumPlayers) || (m_MaxPlayers != a_MaxPlayers))
+	{
+		m_NumPlayers = a_NumPlayers;
+		m_MaxPlayers = a_MaxPlayers;
+		Invalidate();
+	}
+}
+
+
+
+
+
+void cStatusResponseCache::SetForgeMods(UInt32 a_ProtocolVersion, const AStringMap & a_Mods)
+{
+	cCSLock Lock(m_CS);
+	if (a_Mods.empty())
+	{
+		m_ForgeMods.erase(a_ProtocolVersion);
+	}
+	else
+	{
+		m_ForgeMods[a_ProtocolVersion] = a_Mods;
+	}
+	Invalidate();
+}
+
+
+
+
+
+std::shared_ptr<const AString> cStatusResponseCache::GetResponse(UInt32 a_ProtocolVersion)
+{
+	// All unsupported versions get the same response, so that clients cannot fill the cache with bogus versions:
+	AString VersionName;
+	UInt32 StatusProtocolVersion;
+	GetStatusVersion(a_ProtocolVersion, VersionName, StatusProtocolVersion);
+	UInt32 Key = (StatusProtocolVersion == a_ProtocolVersion) ? a_ProtocolVersion : 0;
+
+	cCSLock Lock(m_CS);
+	auto & Response = m_Responses[Key];
+	if (Response == nullptr)
+	{
+		auto Mods = m_ForgeMods.find(Key);
+		Response = std::make_shared<const AString>(BuildResponse(
+			a_ProtocolVersion, m_Description, m_NumPlayers, m_MaxPlayers, m_FaviconData,
+			(Mods == m_ForgeMods.end()) ? AStringMap() : Mods->second
+		));
+	}
+	return Response;
+}
+
+
+
+
+
+std::shared_ptr<const AString> cStatusResponseCache::GetLegacyResponse(bool a_IsExtended)
+{
+	cCSLock Lock(m_CS);
+	auto & Response = m_LegacyResponses[a_IsExtended ? 1 : 0];
+	if (Response == nullptr)
+	{
+		Response = std::make_shared<const AString>(BuildLegacyResponse(a_IsExtended));
+	}
+	return Response;
+}
+
+
+
+
+
+AString cStatusResponseCache::BuildResponse(
+	UInt32 a_ProtocolVersion,
+	const AString & a_Description,
+	int a_NumPlayers,
+	int a_MaxPlayers,
+	const AString & a_FaviconData,
+	const AStringMap & a_ForgeMods
+)
+{
+	// Version:
+	AString VersionName;
+	UInt32 StatusProtocolVersion;
+	GetStatusVersion(a_ProtocolVersion, VersionName, StatusProtocolVersion);
+	Json::Value Version;
+	Version["name"] = VersionName;
+	Version["protocol"] = StatusProtocolVersion;
+
+	// Players:
+	Json::Value Players;
+	Players["online"] = a_NumPlayers;
+	Players["max"] = a_MaxPlayers;
+	// TODO: Add "sample"
+
+	// Description:
+	Json::Value Description;
+	Description["text"] = a_Description.c_str();
+
+	// Create the response:
+	Json::Value ResponseValue;
+	ResponseValue["version"] = Version;
+	ResponseValue["players"] = Players;
+	ResponseValue["description"] = Description;
+	if (!a_ForgeMods.empty())
+	{
+		Json::Value Modinfo;
+		Modinfo["type"] = "FML";
+
+		Json::Value ModList(Json::arrayValue);
+		for (const auto & Mod: a_ForgeMods)
+		{
+			Json::Value ModValue;
+			ModValue["modid"] = Mod.first;
+			ModValue["version"] = Mod.second;
+			ModList.append(ModValue);
+		}
+		Modinfo["modList"] = ModList;
+		ResponseValue["modinfo"] = Modinfo;
+	}
+	if (!a_FaviconData.empty())
+	{
+		ResponseValue["favicon"] = Printf("data:image/png;base64,%s", a_FaviconData.c_str());
+	}
+
+	Json::FastWriter Writer;
+	return Writer.write(ResponseValue);
+}
+
+
+
+
+
+void cStatusResponseCache::GetStatusVersion(UInt32 a_ProtocolVersion, AString & a_VersionName, UInt32 & a_StatusProtocolVersion)
+{
+	a_StatusProtocolVersion = a_ProtocolVersion;
+	switch (a_ProtocolVersion)
+	{
+		case cProtocolRecognizer::PROTO_VERSION_1_8_0:  a_VersionName = "Cuberite 1.8";    return;
+		case cProtocolRecognizer::PROTO_VERSION_1_9_0:  a_VersionName = "Cuberite 1.9";    return;
+		case cProtocolRecognizer::PROTO_VERSION_1_9_1:  a_VersionName = "Cuberite 1.9.1";  return;
+		case cProtocolRecognizer::PROTO_VERSION_1_9_2:  a_VersionName = "Cuberite 1.9.2";  return;
+		case cProtocolRecognizer::PROTO_VERSION_1_9_4:  a_VersionName = "Cuberite 1.9.4";  return;
+		case cProtocolRecognizer::PROTO_VERSION_1_10_0: a_VersionName = "Cuberite 1.10";   return;
+		case cProtocolRecognizer::PROTO_VERSION_1_11_0: a_VersionName = "Cuberite 1.11";   return;
+		case cProtocolRecognizer::PROTO_VERSION_1_11_1: a_VersionName = "Cuberite 1.11.1"; return;
+		case cProtocolRecognizer::PROTO_VERSION_1_12:   a_VersionName = "Cuberite 1.12";   return;
+		case cProtocolRecognizer::PROTO_VERSION_1_12_1: a_VersionName = "Cuberite 1.12.1"; return;
+		case cProtocolRecognizer::PROTO_VERSION_1_12_2: a_VersionName = "Cuberite 1.12.2"; return;
+	}
+	a_VersionName = "Cuberite " MCS_CLIENT_VERSIONS;
+	a_StatusProtocolVersion = MCS_LATEST_PROTOCOL_VERSION;
+}
+
+
+
+
+
+void cStatusResponseCache::Invalidate(void)
+{
+	m_Responses.clear();
+	m_LegacyResponses[0].reset();
+	m_LegacyResponses[1].reset();
+}
+
+
+
+
+
+AString cStatusResponseCache::BuildLegacyResponse(bool a_IsExtended)
+{
+	AString Text;
+	if (a_IsExtended)
+	{
+		// 1.4 - 1.6: the section sign and "1", protocol, version, MOTD, players online, max players; all NUL-separated:
+		const char Separator = 0;
+		Text.append("\xc2\xa7" "1");
+		Text.push_back(Separator);
+		Text.append(Printf("%u", LEGACY_PROTOCOL_VERSION));
+		Text.push_back(Separator);
+		Text.append("Cuberite " MCS_CLIENT_VERSIONS);
+		Text.push_back(Separator);
+		Text.append(m_Description);
+		Text.push_back(Separator);
+		Text.append(Printf("%d", m_NumPlayers));
+		Text.push_back(Separator);
+		Text.append(Printf("%d", m_MaxPlayers));
+	}
+	else
+	{
+		// Beta 1.8 - 1.3: MOTD, players online, max players; all separated by the section sign:
+		Text = Printf("%s\xc2\xa7%d\xc2\xa7%d", m_Description.c_str(), m_NumPlayers, m_MaxPlayers);
+	}
+
+	// The kick packet: packet ID, the length in UTF-16 characters, then the UTF-16BE string:
+	std::u16string UTF16 = UTF8ToRawBEUTF16(Text);
+	AString Packet;
+	Packet.reserve(3 + UTF16.size() * 2);
+	Packet.push_back(static_cast<char>(0xff));
+	Packet.push_back(static_cast<char>((UTF16.size() >> 8) & 0xff));
+	Packet.push_back(static_cast<char>(UTF16.size() & 0xff));
+	Packet.append(reinterpret_cast<const char *>(UTF16.data()), UTF16.size() * 2);
+	return Packet;
+}
+
+
+
+
@@ -0,0 +1,100 @@
+
+// StatusResponseCache.h
+
+// Declares the cStatusResponseCache class that keeps the serialized server list ping responses
+
+/*
+Every client that displays the server in its server list asks for the status: the description (MOTD), the
+player counts, the favicon and the version. Serializing that into JSON for each ping, with the favicon being
+several KiB of Base64, is the bulk of the work of answering a ping. The cache keeps the serialized responses
+per protocol version and rebuilds them only after any of the values change. The values are pushed into the
+cache by cServer, so the cache never needs to touch the server, world or plugin objects and can be used from
+the network threads directly.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cStatusResponseCache
+{
+public:
+
+	/** The protocol version reported in the legacy ping response. Higher than any legacy client's, so that they show the server as newer. */
+	static const UInt32 LEGACY_PROTOCOL_VERSION = 127;
+
+
+	cStatusResponseCache(void);
+
+	/** Sets the server description (MOTD). */
+	void SetDescription(const AString & a_Description);
+
+	/** Sets the favicon, as Base64-encoded PNG data. Empty for no favicon. */
+	void SetFavicon(const AString & a_FaviconData);
+
+	/** Sets the number of players online and the maximum number of players. */
+	void SetPlayerCounts(int a_NumPlayers, int a_MaxPlayers);
+
+	/** Sets the Forge mods (ModName -> ModVersion) reported to clients using the specified protocol version. */
+	void SetForgeMods(UInt32 a_ProtocolVersion, const AStringMap & a_Mods);
+
+	/** Returns the JSON status response for a client using the specified protocol version.
+	The response is built only if there's none cached for the current values. Thread-safe. */
+	std::shared_ptr<const AString> GetResponse(UInt32 a_ProtocolVersion);
+
+	/** Returns the complete kick packet that answers a legacy (pre-1.7 client) server list ping. Thread-safe.
+	a_IsExtended selects the 1.4 - 1.6 format that includes the version, over the Beta 1.8 - 1.3 one. */
+	std::shared_ptr<const AString> GetLegacyResponse(bool a_IsExtended);
+
+	/** Builds the JSON status response from the specified values, without caching.
+	Used for the pings that a plugin modifies, and internally. */
+	static AString BuildResponse(
+		UInt32 a_ProtocolVersion,
+		const AString & a_Description,
+		int a_NumPlayers,
+		int a_MaxPlayers,
+		const AString & a_FaviconData,
+		const AStringMap & a_ForgeMods
+	);
+
+	/** Returns the version name and protocol version to report in the status response to a client using the specified protocol version.
+	Unsupported versions get a name listing all the supported ones, and the latest protocol version. */
+	static void GetStatusVersion(UInt32 a_ProtocolVersion, AString & a_VersionName, UInt32 & a_StatusProtocolVersion);
+
+protected:
+
+	/** Protects all the members against multithreaded access. */
+	cCriticalSection m_CS;
+
+	AString m_Description;
+	AString m_FaviconData;
+	int m_NumPlayers;
+	int m_MaxPlayers;
+
+	/** The Forge mods reported to each protocol version. Versions without mods are not present. */
+	std::map<UInt32, AStringMap> m_ForgeMods;
+
+	/** The cached JSON responses, per protocol version. Unsupported versions share the entry for version 0.
+	Cleared whenever any of the values change. */
+	std::map<UInt32, std::shared_ptr<const AString>> m_Responses;
+
+	/** The cached legacy responses, [0] for the Beta 1.8 - 1.3 format, [1] for the 1.4 - 1.6 one. Reset whenever any of the values change. */
+	std::shared_ptr<const AString> m_LegacyResponses[2];
+
+
+	/** Drops all the cached responses, so that they get rebuilt with the current values. Expects m_CS to be locked. */
+	void Invalidate(void);
+
+	/** Builds the kick packet answering a legacy ping, from the current values. Expects m_CS to be locked. */
+	AString BuildLegacyResponse(bool a_IsExtended);
+} ;
+
+
+
+
@@ -195,6 +195,9 @@ void cRoot::Start(std::unique_ptr<cSettingsRepositoryInterface> a_OverridesRepo)
 	// cClientHandle::FASTBREAK_PERCENTAGE = settingsRepo->GetValueSetI("AntiCheat", "FastBreakPercentage", 97) / 100.0f;
 	cClientHandle::FASTBREAK_PERCENTAGE = 0;  // AntiCheat disabled due to bugs. We will enabled it once they are fixed. See #3506.
 
+	// The network has already been initialised by main(), only make sure the setting is present in the file:
+	settingsRepo->GetValueSetI("Server", "NetworkEventLoops", 0);
+
 	m_MojangAPI = new cMojangAPI;
 	bool ShouldAuthenticate = settingsRepo->GetValueSetB("Authentication", "Authenticate", true);
 	m_MojangAPI->Start(*settingsRepo, ShouldAuthenticate);  // Mojang API needs to be started before plugins, so that plugins may use it for DB upgrades on server init
@@ -1026,15 +1029,34 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		a_Output.Out("  Num loaded chunks: %d", NumValid);
 		a_Output.Out("  Num dirty chunks: %d", NumDirty);
 		a_Output.Out("  Num chunks in lighting queue: %d", NumInLighting);
+		auto LightingStats = World->GetLightingThread().GetWorkerStats();
+		for (size_t i = 0; i < LightingStats.size(); i++)
+		{
+			a_Output.Out("    Lighting thread %u: " SIZE_T_FMT " chunks lit, %.1f chunks/s",
+				static_cast<unsigned>(i), LightingStats[i].m_NumChunksLit, LightingStats[i].m_ChunksPerSec
+			);
+		}
+		auto CacheStats = World->GetChunkSender().GetCache().GetStats();
+		a_Output.Out("  Serialized chunk cache: " SIZE_T_FMT " entries, " SIZE_T_FMT " of " SIZE_T_FMT " KiB, " SIZE_T_FMT " hits, " SIZE_T_FMT " misses",
+			CacheStats.m_NumEntries, (CacheStats.m_Size + 1023) / 1024, CacheStats.m_MaxSize / 1024, CacheStats.m_NumHits, CacheStats.m_NumMisses
+		);
 		a_Output.Out("  Num chunks in generator queue: %d", NumInGenerator);
 		a_Output.Out("  Num chunks in storage load queue: %d", NumInLoadQueue);
 		a_Output.Out("  Num chunks in storage save queue: %d", NumInSaveQueue);
-		int Mem = NumValid * static_cast<int>(sizeof(cChunk));
+		auto ChunkDataStats = World->GetChunkDataMemoryStats();
+		size_t ChunkDataMem = ChunkDataStats.m_NumBytes;
+		int Mem = NumValid * static_cast<int>(sizeof(cChunk)) + static_cast<int>(ChunkDataMem);
 		a_Output.Out("  Memory used by chunks: %d KiB (%d MiB)", (Mem + 1023) / 1024, (Mem + 1024 * 1024 - 1) / (1024 * 1024));
 		a_Output.Out("  Per-chunk memory size breakdown:");
-		a_Output.Out("    block types:    " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunkDef::BlockTypes), (sizeof(cChunkDef::BlockTypes) + 1023) / 1024);
-		a_Output.Out("    block metadata: " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunkDef::BlockNibbles), (sizeof(cChunkDef::BlockNibbles) + 1023) / 1024);
-		a_Output.Out("    block lighting: " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", 2 * sizeof(cChunkDef::BlockNibbles), (2 * sizeof(cChunkDef::BlockNibbles) + 1023) / 1024);
+		a_Output.Out("    chunk object:   " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunk), (sizeof(cChunk) + 1023) / 1024);
+		if (NumValid > 0)
+		{
+			size_t PerChunk = ChunkDataMem / static_cast<size_t>(NumValid);
+			a_Output.Out("    blocks + light: " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB) on average", PerChunk, (PerChunk + 1023) / 1024);
+		}
+		a_Output.Out("  Sections: " SIZE_T_FMT " single-type, " SIZE_T_FMT " packed (4-bit palette), " SIZE_T_FMT " plain (8-bit); " SIZE_T_FMT " light arrays",
+			ChunkDataStats.m_NumSingleType, ChunkDataStats.m_NumPacked, ChunkDataStats.m_NumPlain, ChunkDataStats.m_NumLightArrays
+		);
 		a_Output.Out("    heightmap:      " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunkDef::HeightMap), (sizeof(cChunkDef::HeightMap) + 1023) / 1024);
 		a_Output.Out("    biomemap:       " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunkDef::BiomeMap), (sizeof(cChunkDef::BiomeMap) + 1023) / 1024);
 		SumNumValid += NumValid;
@@ -15,8 +15,10 @@
 #include "FurnaceRecipe.h"
 #include "WebAdmin.h"
 #include "Protocol/ProtocolRecognizer.h"
+#include "Protocol/PacketCompressor.h"
 #include "CommandOutput.h"
 #include "FastRandom.h"
+#include "TickProfiler.h"
 
 #include "IniFile.h"
 
@@ -125,7 +127,9 @@ cServer::cServer(void) :
 	m_TickThread(*this),
 	m_ShouldAuthenticate(false),
 	m_ShouldLoadOfflinePlayerData(false),
-	m_ShouldLoadNamedPlayerData(true)
+	m_ShouldLoadNamedPlayerData(true),
+	m_CompressionThreshold(cPacketCompressor::DEFAULT_THRESHOLD),
+	m_CompressionLevel(Z_DEFAULT_COMPRESSION)
 {
 	// Initialize the LuaStateTracker singleton before the app goes multithreaded:
 	cLuaStateTracker::GetStats();
@@ -148,6 +152,7 @@ void cServer::ClientMovedToWorld(const cClientHandle * a_Client)
 void cServer::PlayerCreated()
 {
 	m_PlayerCount++;
+	UpdateStatusPlayerCounts();
 }
 
 
@@ -157,6 +162,27 @@ void cServer::PlayerCreated()
 void cServer::PlayerDestroyed()
 {
 	m_PlayerCount--;
+	UpdateStatusPlayerCounts();
+}
+
+
+
+
+
+void cServer::SetMaxPlayers(size_t a_MaxPlayers)
+{
+	m_MaxPlayers = a_MaxPlayers;
+	UpdateStatusPlayerCounts();
+}
+
+
+
+
+
+void cServer::UpdateStatusPlayerCounts(void)
+{
+	cCSLock Lock(m_CSStatusPlayerCounts);
+	m_StatusResponseCache.SetPlayerCounts(static_cast<int>(m_PlayerCount.load()), static_cast<int>(m_MaxPlayers));
 }
 
 
@@ -172,6 +198,9 @@ bool cServer::InitServer(cSettingsRepositoryInterface & a_Settings, bool a_Shoul
 	m_bAllowMultiLogin = a_Settings.GetValueSetB("Server", "AllowMultiLogin", false);
 
 	m_FaviconData = Base64Encode(cFile::ReadWholeFile(FILE_IO_PREFIX + AString("favicon.png")));  // Will return empty string if file nonexistant; client doesn't mind
+	m_StatusResponseCache.SetDescription(m_Description);
+	m_StatusResponseCache.SetFavicon(m_FaviconData);
+	UpdateStatusPlayerCounts();
 
 	if (m_bIsConnected)
 	{
@@ -214,6 +243,9 @@ bool cServer::InitServer(cSettingsRepositoryInterface & a_Settings, bool a_Shoul
 	m_ShouldLoadOfflinePlayerData = a_Settings.GetValueSetB("PlayerData", "LoadOfflinePlayerData", false);
 	m_ShouldLoadNamedPlayerData   = a_Settings.GetValueSetB("PlayerData", "LoadNamedPlayerData", true);
 
+	m_CompressionThreshold = std::max(a_Settings.GetValueSetI("Server", "CompressionThreshold", cPacketCompressor::DEFAULT_THRESHOLD), 0);
+	m_CompressionLevel = Clamp(a_Settings.GetValueSetI("Server", "CompressionLevel", Z_DEFAULT_COMPRESSION), Z_DEFAULT_COMPRESSION, Z_BEST_COMPRESSION);
+
 	m_ClientViewDistance = a_Settings.GetValueSetI("Server", "DefaultViewDistance", cClientHandle::DEFAULT_VIEW_DISTANCE);
 	if (m_ClientViewDistance < cClientHandle::MIN_VIEW_DISTANCE)
 	{
@@ -239,7 +271,12 @@ bool cServer::RegisterForgeMod(const AString & a_ModName, const AString & a_ModV
 {
 	auto & Mods = RegisteredForgeMods(a_ProtocolVersionNumber);
 
-	return Mods.insert({a_ModName, a_ModVersion}).second;
+	if (!Mods.insert({a_ModName, a_ModVersion}).second)
+	{
+		return false;
+	}
+	m_StatusResponseCache.SetForgeMods(a_ProtocolVersionNumber, Mods);
+	return true;
 }
 
 
@@ -254,6 +291,7 @@ void cServer::UnregisterForgeMod(const AString & a_ModName, UInt32 a_ProtocolVer
 	if (it != Mods.end())
 	{
 		Mods.erase(it);
+		m_StatusResponseCache.SetForgeMods(a_ProtocolVersionNumber, Mods);
 	}
 }
 
@@ -285,6 +323,31 @@ const AStringMap & cServer::GetRegisteredForgeMods(const UInt32 a_Protocol)
 
 
 
+
+AString cServer::GetStatusResponse(cClientHandle & a_Client, UInt32 a_ProtocolVersion)
+{
+	auto PluginManager = cRoot::Get()->GetPluginManager();
+	if (!PluginManager->HasServerPingHook())
+	{
+		return *m_StatusResponseCache.GetResponse(a_ProtocolVersion);
+	}
+
+	// A plugin may change the response for each client, build it from scratch:
+	AString ServerDescription = m_Description;
+	auto NumPlayers = static_cast<signed>(GetNumPlayers());
+	auto MaxPlayers = static_cast<signed>(GetMaxPlayers());
+	AString Favicon = m_FaviconData;
+	PluginManager->CallHookServerPing(a_Client, ServerDescription, NumPlayers, MaxPlayers, Favicon);
+	auto Mods = m_ForgeModsByVersion.find(a_ProtocolVersion);
+	return cStatusResponseCache::BuildResponse(
+		a_ProtocolVersion, ServerDescription, NumPlayers, MaxPlayers, Favicon,
+		(Mods == m_ForgeModsByVersion.end()) ? AStringMap() : Mods->second
+	);
+}
+
+
+
+
 bool cServer::IsPlayerInQueue(AString a_Username)
 {
 	cCSLock Lock(m_CSClients);
@@ -525,12 +588,83 @@ void cServer::ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallbac
 		return;
 	}
 
+	else if (split[0].compare("netstats") == 0)
+	{
+		a_Output.Out("Outgoing network traffic per client:");
+		cRoot::Get()->ForEachPlayer([&a_Output](cPlayer & a_Player)
+			{
+				auto Client = a_Player.GetClientHandle();
+				if (Client != nullptr)
+				{
+					a_Output.Out(Printf("  %s: %.1f packets / tick, %.0f bytes / tick, %.2f bytes copied / byte sent, %u tracked entities",
+						a_Player.GetName().c_str(), Client->GetPacketsPerTick(), Client->GetBytesPerTick(), Client->GetCopiedBytesPerByteSent(),
+						static_cast<unsigned>(Client->GetNumTrackedEntities())
+					));
+					a_Output.Out(Printf("    chunks: %u KiB queued, %.0f KiB / sec bandwidth, %u KiB budget, %d ms ping",
+						static_cast<unsigned>(Client->GetQueuedChunkBytes() / 1024), Client->GetChunkBandwidth() / 1024,
+						static_cast<unsigned>(Client->GetChunkSendBudget() / 1024), Client->GetPing()
+					));
+				}
+				return false;
+			}
+		);
+		a_Output.Finished();
+		return;
+	}
+
 	else if (split[0].compare("luastats") == 0)
 	{
 		a_Output.Out(cLuaStateTracker::GetStats());
 		a_Output.Finished();
 		return;
 	}
+
+	else if (split[0].compare("tickprof") == 0)
+	{
+		auto & Profiler = cTickProfiler::Get();
+		if ((split.size() >= 2) && (split[1] == "start"))
+		{
+			Profiler.Start();
+			a_Output.Out("Tick profiler started.");
+		}
+		else if ((split.size() >= 2) && (split[1] == "stop"))
+		{
+			Profiler.Stop();
+			a_Output.Out("Tick profiler stopped.");
+		}
+		else if ((split.size() >= 2) && (split[1] == "report"))
+		{
+			int WindowSec = 10;
+			if ((split.size() >= 3) && (!StringToInteger(split[2], WindowSec) || (WindowSec <= 0)))
+			{
+				a_Output.Out("Invalid number of seconds: " + split[2]);
+				a_Output.Finished();
+				return;
+			}
+			for (const auto & Line : Profiler.GetReport(WindowSec))
+			{
+				a_Output.Out(Line);
+			}
+		}
+		else if ((split.size() >= 3) && (split[1] == "export"))
+		{
+			int NumEvents = Profiler.ExportChromeTrace(split[2]);
+			if (NumEvents < 0)
+			{
+				a_Output.Out("Cannot write file " + split[2]);
+			}
+			else
+			{
+				a_Output.Out(Printf("Exported %d events to %s", NumEvents, split[2].c_str()));
+			}
+		}
+		else
+		{
+			a_Output.Out("Usage: tickprof start | stop | report [<seconds>] | export <filename>");
+		}
+		a_Output.Finished();
+		return;
+	}
 	else if (cPluginManager::Get()->ExecuteConsoleCommand(split, a_Output, a_Cmd))
 	{
 		a_Output.Finished();
@@ -613,6 +747,8 @@ void cServer::BindBuiltInConsoleCommands(void)
 	PlgMgr->BindConsoleCommand("restart",         nullptr, handler, "Restarts the server cleanly");
 	PlgMgr->BindConsoleCommand("stop",            nullptr, handler, "Stops the server cleanly");
 	PlgMgr->BindConsoleCommand("chunkstats",      nullptr, handler, "Displays detailed chunk memory statistics");
+	PlgMgr->BindConsoleCommand("netstats",        nullptr, handler, "Displays the outgoing network traffic of each client");
+	PlgMgr->BindConsoleCommand("tickprof",        nullptr, handler, "Controls the tick profiler: start, stop, report [<seconds>], export <filename>");
 	PlgMgr->BindConsoleCommand("load",            nullptr, handler, "Adds and enables the specified plugin");
 	PlgMgr->BindConsoleCommand("unload",          nullptr, handler, "Disables the specified plugin");
 	PlgMgr->BindConsoleCommand("destroyentities", nullptr, handler, "Destroys all entities in all worlds");
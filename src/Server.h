@@ -12,6 +12,7 @@
 #include "RCONServer.h"
 #include "OSSupport/IsThread.h"
 #include "OSSupport/Network.h"
+#include "Protocol/StatusResponseCache.h"
 
 #ifdef _MSC_VER
 	#pragma warning(push)
@@ -69,7 +70,7 @@ public:
 	// Player counts:
 	size_t GetMaxPlayers(void) const { return m_MaxPlayers; }
 	size_t GetNumPlayers(void) const { return m_PlayerCount; }
-	void SetMaxPlayers(size_t a_MaxPlayers) { m_MaxPlayers = a_MaxPlayers; }
+	void SetMaxPlayers(size_t a_MaxPlayers);
 
 	// tolua_end
 
@@ -155,9 +156,24 @@ public:
 	from the settings. */
 	bool ShouldAllowMultiWorldTabCompletion(void) const { return m_ShouldAllowMultiWorldTabCompletion; }
 
+	/** Returns the minimum size of the outgoing packets that get compressed.
+	Loaded from the settings.ini [Server].CompressionThreshold setting. */
+	int GetCompressionThreshold(void) const { return m_CompressionThreshold; }
+
+	/** Returns the zlib level used for compressing the outgoing packets.
+	Loaded from the settings.ini [Server].CompressionLevel setting. */
+	int GetCompressionLevel(void) const { return m_CompressionLevel; }
+
 	/** Get the Forge mods (map of ModName -> ModVersionString) registered for a given protocol. */
 	const AStringMap & GetRegisteredForgeMods(const UInt32 a_Protocol);
 
+	/** Returns the JSON status response to a server list ping from a_Client, which uses the specified protocol version.
+	If a plugin hooks the ping, the hook is called and the response is built for this client; otherwise the cached one is returned. */
+	AString GetStatusResponse(cClientHandle & a_Client, UInt32 a_ProtocolVersion);
+
+	/** Returns the cache of the server list ping responses, used by the network threads to answer pings on their own. */
+	cStatusResponseCache & GetStatusResponseCache(void) { return m_StatusResponseCache; }
+
 private:
 
 	friend class cRoot;  // so cRoot can create and destroy cServer
@@ -218,6 +234,12 @@ private:
 	/** Map of protocol version to Forge mods (map of ModName -> ModVersionString) */
 	std::map<UInt32, AStringMap> m_ForgeModsByVersion;
 
+	/** The serialized server list ping responses, kept up to date with the description, favicon, player counts and Forge mods. */
+	cStatusResponseCache m_StatusResponseCache;
+
+	/** Serializes the player count updates to m_StatusResponseCache, so that the last one always carries the current count. */
+	cCriticalSection m_CSStatusPlayerCounts;
+
 	/** True - allow same username to login more than once False - only once */
 	bool m_bAllowMultiLogin;
 
@@ -244,6 +266,12 @@ private:
 	Loaded from the settings.ini [PlayerData].LoadNamedPlayerData setting. */
 	bool m_ShouldLoadNamedPlayerData;
 
+	/** The minimum size of the outgoing packets that get compressed. */
+	int m_CompressionThreshold;
+
+	/** The zlib level used for compressing the outgoing packets. */
+	int m_CompressionLevel;
+
 	/** True if BungeeCord handshake packets (with player UUID) should be accepted. */
 	bool m_ShouldAllowBungeeCord;
 
@@ -260,6 +288,9 @@ private:
 	/** Get the Forge mods registered for a given protocol, for modification */
 	AStringMap & RegisteredForgeMods(const UInt32 a_Protocol);
 
+	/** Pushes the current player counts into m_StatusResponseCache. */
+	void UpdateStatusPlayerCounts(void);
+
 	/** Loads, or generates, if missing, RSA keys for protocol encryption */
 	void PrepareKeys(void);
 
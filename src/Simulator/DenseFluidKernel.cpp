@@ -0,0 +1,499 @@
+
+// DenseFluidKernel.cpp
+
+// Implements the cDenseFluidKernel class that simulates the fluid blocks of a single chunk section in one sweep over a dense array
+
+#include "Globals.h"
+
+#include "DenseFluidKernel.h"
+#include "FluidSimulator.h"
+#include "../Defines.h"
+
+
+
+
+
+/** The offsets of the four horizontal neighbors, in the order the Floody simulator checks them for hardening and feeding. */
+static const int g_LateralX[] = { 1, -1, 0,  0 };
+static const int g_LateralZ[] = { 0,  0, 1, -1 };
+
+/** The offsets of the four horizontal neighbors, in the order the Floody simulator spreads into them (cFloodyFluidSimulator::SpreadXZ()). */
+static const int g_SpreadX[] = { -1, 1,  0, 0 };
+static const int g_SpreadZ[] = {  0, 0, -1, 1 };
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cDenseFluidKernel::cDirtyMask:
+
+void cDenseFluidKernel::cDirtyMask::Clear(void)
+{
+	memset(m_Bits, 0, sizeof(m_Bits));
+}
+
+
+
+
+
+bool cDenseFluidKernel::cDirtyMask::IsEmpty(void) const
+{
+	for (auto Bits: m_Bits)
+	{
+		if (Bits != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+int cDenseFluidKernel::cDirtyMask::Count(void) const
+{
+	int Res = 0;
+	for (auto Bits: m_Bits)
+	{
+		for (; Bits != 0; Bits &= Bits - 1)
+		{
+			Res += 1;
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+int cDenseFluidKernel::cDirtyMask::GetTouchedFaces(void) const
+{
+	// Each item holds four rows of 16 blocks along the X axis, an item per a quarter of a layer:
+	static_assert(cChunkDef::Width == 16, "The masks below assume 16 blocks per row");
+	const UInt64 MaskX0  = 0x0001000100010001ULL;
+	const UInt64 MaskX15 = 0x8000800080008000ULL;
+	const UInt64 MaskZ0  = 0x000000000000ffffULL;
+	const UInt64 MaskZ15 = 0xffff000000000000ULL;
+	const size_t ItemsPerLayer = ARRAYCOUNT(m_Bits) / cChunkData::SectionHeight;
+
+	int Res = 0;
+	for (size_t i = 0; i < ARRAYCOUNT(m_Bits); i++)
+	{
+		UInt64 Bits = m_Bits[i];
+		if (Bits == 0)
+		{
+			continue;
+		}
+		if ((Bits & MaskX0) != 0)
+		{
+			Res |= faceXM;
+		}
+		if ((Bits & MaskX15) != 0)
+		{
+			Res |= faceXP;
+		}
+		if (((i % ItemsPerLayer) == 0) && ((Bits & MaskZ0) != 0))
+		{
+			Res |= faceZM;
+		}
+		if (((i % ItemsPerLayer) == ItemsPerLayer - 1) && ((Bits & MaskZ15) != 0))
+		{
+			Res |= faceZP;
+		}
+		if (i < ItemsPerLayer)
+		{
+			Res |= faceYM;
+		}
+		if (i >= ARRAYCOUNT(m_Bits) - ItemsPerLayer)
+		{
+			Res |= faceYP;
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cDenseFluidKernel::cWindow:
+
+cDenseFluidKernel::cWindow::cWindow(void) :
+	m_BaseY(0)
+{
+	Reset();
+	memset(m_Metas, 0, sizeof(m_Metas));
+}
+
+
+
+
+
+void cDenseFluidKernel::cWindow::Reset(void)
+{
+	memset(m_BlockTypes, UNAVAILABLE_BLOCK, sizeof(m_BlockTypes));
+}
+
+
+
+
+
+void cDenseFluidKernel::cWindow::CopyFromSection(
+	const cChunkData::sChunkSection * a_Section,
+	int a_MinX, int a_MinY, int a_MinZ,
+	int a_MaxX, int a_MaxY, int a_MaxZ,
+	int a_OffsetX, int a_OffsetY, int a_OffsetZ
+)
+{
+	int SizeX = a_MaxX - a_MinX + 1;
+	for (int y = a_MinY; y <= a_MaxY; y++)
+	{
+		for (int z = a_MinZ; z <= a_MaxZ; z++)
+		{
+			int Dst = MakeIndex(a_MinX + a_OffsetX, y + a_OffsetY, z + a_OffsetZ);
+			if (a_Section == nullptr)
+			{
+				memset(m_BlockTypes + Dst, E_BLOCK_AIR, static_cast<size_t>(SizeX));
+				memset(m_Metas + Dst, 0, static_cast<size_t>(SizeX));
+				continue;
+			}
+			int Src = cChunkDef::MakeIndexNoCheck(a_MinX, y, z);
+			a_Section->CopyBlockTypes(m_BlockTypes + Dst, static_cast<size_t>(Src), static_cast<size_t>(SizeX));
+			for (int x = 0; x < SizeX; x++)
+			{
+				int Idx = Src + x;
+				m_Metas[Dst + x] = (a_Section->m_BlockMetas[Idx / 2] >> ((Idx & 1) * 4)) & 0x0f;
+			}
+		}
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cDenseFluidKernel:
+
+cDenseFluidKernel::cDenseFluidKernel(BLOCKTYPE a_FluidBlock, BLOCKTYPE a_StationaryFluidBlock, NIBBLETYPE a_Falloff, int a_NumNeighborsForSource) :
+	m_FluidBlock(a_FluidBlock),
+	m_StationaryFluidBlock(a_StationaryFluidBlock),
+	m_Falloff(a_Falloff),
+	m_NumNeighborsForSource(a_NumNeighborsForSource)
+{
+	for (size_t i = 0; i < ARRAYCOUNT(m_IsPassable); i++)
+	{
+		BLOCKTYPE BlockType = static_cast<BLOCKTYPE>(i);
+		m_IsPassable[i] = (
+			(BlockType == E_BLOCK_AIR) ||
+			(BlockType == E_BLOCK_FIRE) ||
+			IsAnyFluidBlock(BlockType) ||
+			cFluidSimulator::CanWashAway(BlockType)
+		);
+	}
+}
+
+
+
+
+
+void cDenseFluidKernel::FillWindow(cWindow & a_Window, int a_BaseY, const cDirtyMask & a_Dirty, const sNeighborhood & a_Neighborhood) const
+{
+	const int Max = cChunkDef::Width - 1;
+	a_Window.m_BaseY = a_BaseY;
+	a_Window.Reset();
+	a_Window.CopyFromSection(a_Neighborhood.m_Center, 0, 0, 0, Max, Max, Max, 0, 0, 0);
+
+	// Exchange the halo only on the faces that are next to a dirty block, in the order of eFace:
+	int Faces = a_Dirty.GetTouchedFaces();
+	static const struct
+	{
+		int m_MinX, m_MinY, m_MinZ, m_MaxX, m_MaxY, m_MaxZ;
+		int m_OffsetX, m_OffsetY, m_OffsetZ;
+	} HaloBoxes[] =
+	{
+		{ Max, 0,   0,   Max, Max, Max, -16,   0,   0 },  // XM
+		{ 0,   0,   0,   0,   Max, Max,  16,   0,   0 },  // XP
+		{ 0,   Max, 0,   Max, Max, Max,   0, -16,   0 },  // YM
+		{ 0,   0,   0,   Max, 0,   Max,   0,  16,   0 },  // YP
+		{ 0,   0,   Max, Max, Max, Max,   0,   0, -16 },  // ZM
+		{ 0,   0,   0,   Max, Max, 0,     0,   0,  16 },  // ZP
+	};
+	for (size_t i = 0; i < ARRAYCOUNT(HaloBoxes); i++)
+	{
+		if (((Faces & (1 << i)) == 0) || !a_Neighborhood.m_IsAvailable[i])
+		{
+			continue;
+		}
+		const auto & Box = HaloBoxes[i];
+		a_Window.CopyFromSection(a_Neighborhood.m_Neighbors[i],
+			Box.m_MinX, Box.m_MinY, Box.m_MinZ, Box.m_MaxX, Box.m_MaxY, Box.m_MaxZ,
+			Box.m_OffsetX, Box.m_OffsetY, Box.m_OffsetZ
+		);
+	}
+}
+
+
+
+
+
+void cDenseFluidKernel::Sweep(cWindow & a_Window, const cDirtyMask & a_Dirty, cChanges & a_Changes) const
+{
+	// The bits are in the XZY order of the section arrays:
+	static_assert(AXIS_ORDER == AXIS_ORDER_XZY, "The sweep expects the XZY axis order");
+	for (size_t i = 0; i < ARRAYCOUNT(a_Dirty.m_Bits); i++)
+	{
+		UInt64 Bits = a_Dirty.m_Bits[i];
+		for (int Bit = 0; Bits != 0; Bit++, Bits >>= 1)
+		{
+			if ((Bits & 1) == 0)
+			{
+				continue;
+			}
+			int Index = static_cast<int>(i * 64) + Bit;
+			SimulateBlock(a_Window, Index % cChunkDef::Width, Index / (cChunkDef::Width * cChunkDef::Width), (Index / cChunkDef::Width) % cChunkDef::Width, a_Changes);
+		}
+	}
+}
+
+
+
+
+
+void cDenseFluidKernel::SimulateBlock(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, cChanges & a_Changes) const
+{
+	int Index = cWindow::MakeIndex(a_RelX, a_RelY, a_RelZ);
+	BLOCKTYPE MyBlock = a_Window.m_BlockTypes[Index];
+	NIBBLETYPE MyMeta = a_Window.m_Metas[Index];
+	if (!IsAnyFluidBlock(MyBlock))
+	{
+		// The block has been replaced since it was scheduled
+		return;
+	}
+
+	if (HardenBlock(a_Window, a_RelX, a_RelY, a_RelZ, MyBlock, MyMeta, a_Changes))
+	{
+		return;
+	}
+
+	if ((MyMeta != 0) && CheckTributaries(a_Window, a_RelX, a_RelY, a_RelZ, MyMeta, a_Changes))
+	{
+		// Not fed, has been decreased
+		return;
+	}
+
+	// New meta for the spreading to neighbors, see cFloodyFluidSimulator::SimulateBlock():
+	NIBBLETYPE NewMeta = ((MyMeta == 0) || ((MyMeta & 0x08) != 0)) ? m_Falloff : (MyMeta + m_Falloff);
+	if (a_Window.m_BaseY + a_RelY > 0)
+	{
+		bool SpreadFurther = true;
+		BLOCKTYPE Below = a_Window.m_BlockTypes[cWindow::MakeIndex(a_RelX, a_RelY - 1, a_RelZ)];
+		if (m_IsPassable[Below] || IsBlockLava(Below) || IsBlockWater(Below))
+		{
+			SpreadToNeighbor(a_Window, a_RelX, a_RelY - 1, a_RelZ, 8, a_Changes);
+
+			// Source blocks spread both downwards and sideways
+			if (MyMeta != 0)
+			{
+				SpreadFurther = false;
+			}
+		}
+		if (SpreadFurther && (NewMeta < 8))
+		{
+			for (size_t i = 0; i < ARRAYCOUNT(g_SpreadX); i++)
+			{
+				SpreadToNeighbor(a_Window, a_RelX + g_SpreadX[i], a_RelY, a_RelZ + g_SpreadZ[i], NewMeta, a_Changes);
+			}
+		}
+
+		if (
+			(m_NumNeighborsForSource > 0) &&
+			(MyMeta == m_Falloff) &&
+			(!m_IsPassable[Below] || (Below == m_StationaryFluidBlock)) &&
+			CheckNeighborsForSource(a_Window, a_RelX, a_RelY, a_RelZ, a_Changes)
+		)
+		{
+			return;
+		}
+	}
+
+	// Mark as processed:
+	if (a_Window.m_BlockTypes[Index] != m_StationaryFluidBlock)
+	{
+		SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, m_StationaryFluidBlock, MyMeta, ckProcessed, a_Changes);
+	}
+}
+
+
+
+
+
+bool cDenseFluidKernel::HardenBlock(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, cChanges & a_Changes) const
+{
+	if (!IsBlockLava(a_BlockType))
+	{
+		return false;
+	}
+
+	bool ShouldHarden = false;
+	for (size_t i = 0; i < ARRAYCOUNT(g_LateralX); i++)
+	{
+		if (IsBlockWater(a_Window.m_BlockTypes[cWindow::MakeIndex(a_RelX + g_LateralX[i], a_RelY, a_RelZ + g_LateralZ[i])]))
+		{
+			ShouldHarden = true;
+			break;
+		}
+	}
+	if (!ShouldHarden)
+	{
+		return false;
+	}
+
+	if (a_Meta == 0)
+	{
+		SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, E_BLOCK_OBSIDIAN, 0, ckSet, a_Changes);
+		return true;
+	}
+	else if (a_Meta <= 4)
+	{
+		SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, E_BLOCK_COBBLESTONE, 0, ckSet, a_Changes);
+		return true;
+	}
+	return false;
+}
+
+
+
+
+
+bool cDenseFluidKernel::CheckTributaries(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_MyMeta, cChanges & a_Changes) const
+{
+	if (
+		(a_Window.m_BaseY + a_RelY < cChunkDef::Height - 1) &&
+		IsAnyFluidBlock(a_Window.m_BlockTypes[cWindow::MakeIndex(a_RelX, a_RelY + 1, a_RelZ)])
+	)
+	{
+		// Fed from above
+		return false;
+	}
+
+	if (a_MyMeta != 8)
+	{
+		for (size_t i = 0; i < ARRAYCOUNT(g_LateralX); i++)
+		{
+			int Index = cWindow::MakeIndex(a_RelX + g_LateralX[i], a_RelY, a_RelZ + g_LateralZ[i]);
+			if (IsAnyFluidBlock(a_Window.m_BlockTypes[Index]) && cFluidSimulator::IsHigherMeta(a_Window.m_Metas[Index], a_MyMeta))
+			{
+				// Fed from the side
+				return false;
+			}
+		}
+	}
+
+	// Not fed, decrease by m_Falloff levels:
+	if (a_MyMeta >= 8)
+	{
+		SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, m_StationaryFluidBlock, m_Falloff, ckSet, a_Changes);
+	}
+	else if (a_MyMeta + m_Falloff < 8)
+	{
+		SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, m_StationaryFluidBlock, a_MyMeta + m_Falloff, ckSet, a_Changes);
+	}
+	else
+	{
+		SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, E_BLOCK_AIR, 0, ckSet, a_Changes);
+	}
+	return true;
+}
+
+
+
+
+
+void cDenseFluidKernel::SpreadToNeighbor(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_NewMeta, cChanges & a_Changes) const
+{
+	ASSERT(a_NewMeta <= 8);  // Invalid meta values
+	ASSERT(a_NewMeta > 0);  // Source blocks aren't spread
+
+	int Index = cWindow::MakeIndex(a_RelX, a_RelY, a_RelZ);
+	BLOCKTYPE BlockType = a_Window.m_BlockTypes[Index];
+	NIBBLETYPE BlockMeta = a_Window.m_Metas[Index];
+
+	if (IsAnyFluidBlock(BlockType) && ((BlockMeta == a_NewMeta) || cFluidSimulator::IsHigherMeta(BlockMeta, a_NewMeta)))
+	{
+		// There's already a higher or same level there
+		return;
+	}
+
+	// Water - lava interaction:
+	if ((m_FluidBlock == E_BLOCK_LAVA) && IsBlockWater(BlockType))
+	{
+		SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, (a_NewMeta == 8) ? E_BLOCK_STONE : E_BLOCK_COBBLESTONE, 0, ckExtinguish, a_Changes);
+		return;
+	}
+	if ((m_FluidBlock == E_BLOCK_WATER) && IsBlockLava(BlockType))
+	{
+		SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, (BlockMeta == 0) ? E_BLOCK_OBSIDIAN : E_BLOCK_COBBLESTONE, 0, ckExtinguish, a_Changes);
+		return;
+	}
+
+	if (!m_IsPassable[BlockType])
+	{
+		return;
+	}
+
+	SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, m_FluidBlock, a_NewMeta, ckSpread, a_Changes);
+}
+
+
+
+
+
+bool cDenseFluidKernel::CheckNeighborsForSource(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, cChanges & a_Changes) const
+{
+	int NumNeeded = m_NumNeighborsForSource;
+	for (size_t i = 0; i < ARRAYCOUNT(g_SpreadX); i++)
+	{
+		int Index = cWindow::MakeIndex(a_RelX + g_SpreadX[i], a_RelY, a_RelZ + g_SpreadZ[i]);
+		if ((a_Window.m_Metas[Index] == 0) && IsAnyFluidBlock(a_Window.m_BlockTypes[Index]))
+		{
+			NumNeeded--;
+			if (NumNeeded == 0)
+			{
+				SetBlock(a_Window, a_RelX, a_RelY, a_RelZ, m_FluidBlock, 0, ckSet, a_Changes);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+
+
+
+void cDenseFluidKernel::SetBlock(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, eChangeKind a_Kind, cChanges & a_Changes)
+{
+	int Index = cWindow::MakeIndex(a_RelX, a_RelY, a_RelZ);
+	sChange Change;
+	Change.m_RelX = a_RelX;
+	Change.m_RelY = a_RelY;
+	Change.m_RelZ = a_RelZ;
+	Change.m_Kind = a_Kind;
+	Change.m_OldBlockType = a_Window.m_BlockTypes[Index];
+	Change.m_BlockType = a_BlockType;
+	Change.m_Meta = a_Meta;
+	a_Changes.push_back(Change);
+
+	a_Window.m_BlockTypes[Index] = a_BlockType;
+	a_Window.m_Metas[Index] = a_Meta;
+}
+
+
+
+
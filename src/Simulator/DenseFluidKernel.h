@@ -0,0 +1,220 @@
+
+// DenseFluidKernel.h
+
+// Declares the cDenseFluidKernel class that simulates the fluid blocks of a single chunk section in one sweep over a dense array
+
+/*
+The kernel works on a cWindow, a copy of one 16 * 16 * 16 chunk section with a one-block halo around it,
+taken from the neighboring sections and chunks. The blocks to simulate are given by a cDirtyMask, one bit per
+block of the section. Sweep() then runs the Floody rules for each dirty block in array order, reading and writing
+only the window, and records each block it changed into a list of sChange, so that the caller can write the changes
+back to the world (including the halo blocks, which belong to the neighbors), with all the side effects that
+need the world (washing away, sounds, waking up the simulators).
+
+The kernel doesn't depend on cWorld or cChunk, the window is filled from raw cChunkData sections,
+so that it can be driven by the cDenseFluidSimulator as well as by a benchmark.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../BlockID.h"
+#include "../ChunkData.h"
+
+
+
+
+
+class cDenseFluidKernel
+{
+public:
+
+	/** The faces of the window's halo, as a bitmask. */
+	enum eFace
+	{
+		faceXM = 0x01,
+		faceXP = 0x02,
+		faceYM = 0x04,
+		faceYP = 0x08,
+		faceZM = 0x10,
+		faceZP = 0x20,
+	} ;
+
+
+	/** Marks the blocks of a single section that are to be simulated; indexed the same way as the section's arrays. */
+	class cDirtyMask
+	{
+	public:
+		cDirtyMask(void) { Clear(); }
+
+		/** Marks the specified block, given in section-relative coords. */
+		void Set(int a_RelX, int a_RelY, int a_RelZ)
+		{
+			int Index = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
+			m_Bits[Index / 64] |= (static_cast<UInt64>(1) << (Index % 64));
+		}
+
+		/** Returns true if the specified block, given in section-relative coords, is marked. */
+		bool IsSet(int a_RelX, int a_RelY, int a_RelZ) const
+		{
+			int Index = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
+			return ((m_Bits[Index / 64] >> (Index % 64)) & 1) != 0;
+		}
+
+		void Clear(void);
+
+		bool IsEmpty(void) const;
+
+		/** Returns the number of marked blocks. */
+		int Count(void) const;
+
+		/** Returns the faces (eFace bitmask) next to which there's a marked block.
+		Only the halo on these faces is ever read or written when simulating the marked blocks. */
+		int GetTouchedFaces(void) const;
+
+		/** The bits, 64 blocks per item. */
+		UInt64 m_Bits[cChunkData::SectionBlockCount / 64];
+	} ;
+
+
+	/** A copy of a single section with a one-block halo around it. */
+	class cWindow
+	{
+	public:
+		/** The size of the window in each direction, including the halo. */
+		static const int SIZE = cChunkDef::Width + 2;
+
+		/** The block type used for the halo blocks that are not available (outside the world or in an unloaded chunk).
+		Neither the fluids nor the spreading treat it any differently from a missing block. */
+		static const BLOCKTYPE UNAVAILABLE_BLOCK = E_BLOCK_BEDROCK;
+
+		/** The absolute Y coord of the section's lowest layer. */
+		int m_BaseY;
+
+		BLOCKTYPE m_BlockTypes[SIZE * SIZE * SIZE];
+
+		/** The metas, unpacked into one per byte. */
+		NIBBLETYPE m_Metas[SIZE * SIZE * SIZE];
+
+
+		cWindow(void);
+
+		/** Returns the index into the arrays of the specified block, given in section-relative coords (-1 .. 16). */
+		static int MakeIndex(int a_RelX, int a_RelY, int a_RelZ)
+		{
+			return (a_RelX + 1) + (a_RelZ + 1) * SIZE + (a_RelY + 1) * SIZE * SIZE;
+		}
+
+		/** Sets all blocks of the window to UNAVAILABLE_BLOCK. */
+		void Reset(void);
+
+		/** Copies the specified box of blocks (inclusive, section-relative coords of a_Section) into the window, moved by the offset.
+		If a_Section is nullptr, the section is all air. */
+		void CopyFromSection(
+			const cChunkData::sChunkSection * a_Section,
+			int a_MinX, int a_MinY, int a_MinZ,
+			int a_MaxX, int a_MaxY, int a_MaxZ,
+			int a_OffsetX, int a_OffsetY, int a_OffsetZ
+		);
+	} ;
+
+
+	/** The sections from which a window is filled. */
+	struct sNeighborhood
+	{
+		/** The section itself. nullptr if the section is all air. */
+		const cChunkData::sChunkSection * m_Center;
+
+		/** The neighboring sections, indexed by the eFace bit number (XM, XP, YM, YP, ZM, ZP). nullptr if all air. */
+		const cChunkData::sChunkSection * m_Neighbors[6];
+
+		/** Whether each of the neighbors is available; an unavailable neighbor's halo is filled with UNAVAILABLE_BLOCK. */
+		bool m_IsAvailable[6];
+	} ;
+
+
+	/** The kinds of changes recorded by Sweep(), by what the caller needs to do when writing them back. */
+	enum eChangeKind
+	{
+		/** The fluid has been processed and turned stationary, no block updates needed. */
+		ckProcessed,
+
+		/** The block has been set (a level decreased, a source created, lava hardened). */
+		ckSet,
+
+		/** The fluid has spread into the block, washing away m_OldBlockType if needed; the neighbors need waking up. */
+		ckSpread,
+
+		/** Lava and water met in the block; the extinguish sound needs playing. */
+		ckExtinguish,
+	} ;
+
+
+	/** A single block changed by Sweep(). */
+	struct sChange
+	{
+		/** The section-relative coords of the block, may be in the halo (-1 or 16). */
+		int m_RelX, m_RelY, m_RelZ;
+
+		eChangeKind m_Kind;
+
+		/** The block that was there before the change. */
+		BLOCKTYPE m_OldBlockType;
+
+		BLOCKTYPE m_BlockType;
+		NIBBLETYPE m_Meta;
+	} ;
+
+	typedef std::vector<sChange> cChanges;
+
+
+	/** Creates a kernel for the specified fluid, using the parameters of the Floody simulator. */
+	cDenseFluidKernel(BLOCKTYPE a_FluidBlock, BLOCKTYPE a_StationaryFluidBlock, NIBBLETYPE a_Falloff, int a_NumNeighborsForSource);
+
+	/** Fills the window from the neighborhood; the halo is filled only on the faces touched by a_Dirty. */
+	void FillWindow(cWindow & a_Window, int a_BaseY, const cDirtyMask & a_Dirty, const sNeighborhood & a_Neighborhood) const;
+
+	/** Simulates all the blocks marked in a_Dirty, in array order, updating a_Window and appending the changed blocks to a_Changes. */
+	void Sweep(cWindow & a_Window, const cDirtyMask & a_Dirty, cChanges & a_Changes) const;
+
+protected:
+
+	BLOCKTYPE  m_FluidBlock;
+	BLOCKTYPE  m_StationaryFluidBlock;
+	NIBBLETYPE m_Falloff;
+	int        m_NumNeighborsForSource;
+
+	/** For each block type, true if the fluid can spread into it (cFluidSimulator::IsPassableForFluid()). */
+	bool m_IsPassable[256];
+
+
+	bool IsAnyFluidBlock(BLOCKTYPE a_BlockType) const
+	{
+		return ((a_BlockType == m_FluidBlock) || (a_BlockType == m_StationaryFluidBlock));
+	}
+
+	/** Simulates a single block, see cFloodyFluidSimulator::SimulateBlock(). */
+	void SimulateBlock(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, cChanges & a_Changes) const;
+
+	/** Hardens lava touching water; returns true if the block was changed. See cFloodyFluidSimulator::HardenBlock(). */
+	bool HardenBlock(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, cChanges & a_Changes) const;
+
+	/** Decreases the block if it isn't fed; returns true if it was decreased. See cFloodyFluidSimulator::CheckTributaries(). */
+	bool CheckTributaries(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_MyMeta, cChanges & a_Changes) const;
+
+	/** Spreads into the specified block, if possible. See cFloodyFluidSimulator::SpreadToNeighbor(). */
+	void SpreadToNeighbor(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_NewMeta, cChanges & a_Changes) const;
+
+	/** Turns the block into a source if it has enough source neighbors; returns true if so. See cFloodyFluidSimulator::CheckNeighborsForSource(). */
+	bool CheckNeighborsForSource(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, cChanges & a_Changes) const;
+
+	/** Sets the block in the window and records the change. */
+	static void SetBlock(cWindow & a_Window, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, eChangeKind a_Kind, cChanges & a_Changes);
+} ;
+
+
+
+
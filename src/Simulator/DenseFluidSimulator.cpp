@@ -0,0 +1,286 @@
+
+// DenseFluidSimulator.cpp
+
+// Implements the cDenseFluidSimulator class representing a fluid simulator that uses the Floody rules,
+// but keeps the scheduled blocks in per-section bitmasks and simulates them section by section using cDenseFluidKernel
+
+#include "Globals.h"
+
+#include "DenseFluidSimulator.h"
+#include "../World.h"
+#include "../Chunk.h"
+#include "../Blocks/BlockHandler.h"
+#include "../BlockInServerPluginInterface.h"
+#include "../Blocks/ChunkInterface.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cDenseFluidSimulatorChunkData:
+
+cDenseFluidSimulatorChunkData::cDenseFluidSimulatorChunkData(void)
+{
+	m_DirtySections[0] = 0;
+	m_DirtySections[1] = 0;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cDenseFluidSimulator:
+
+cDenseFluidSimulator::cDenseFluidSimulator(
+	cWorld & a_World,
+	BLOCKTYPE a_Fluid,
+	BLOCKTYPE a_StationaryFluid,
+	NIBBLETYPE a_Falloff,
+	int a_TickDelay,
+	int a_NumNeighborsForSource
+) :
+	super(a_World, a_Fluid, a_StationaryFluid),
+	m_Kernel(a_Fluid, a_StationaryFluid, a_Falloff, a_NumNeighborsForSource),
+	m_TickDelay(std::max(a_TickDelay, 1)),
+	m_TicksSinceSweep(0),
+	m_IsSweepTick(false),
+	m_AddSet(0)
+{
+}
+
+
+
+
+
+void cDenseFluidSimulator::AddBlock(Vector3i a_Block, cChunk * a_Chunk)
+{
+	if ((a_Block.y < 0) || (a_Block.y >= cChunkDef::Height))
+	{
+		// Not inside the world (may happen when rclk with a full bucket - the client sends Y = -1)
+		return;
+	}
+
+	if ((a_Chunk == nullptr) || !a_Chunk->IsValid())
+	{
+		return;
+	}
+
+	int RelX = a_Block.x - a_Chunk->GetPosX() * cChunkDef::Width;
+	int RelZ = a_Block.z - a_Chunk->GetPosZ() * cChunkDef::Width;
+	if (a_Chunk->GetBlock(RelX, a_Block.y, RelZ) != m_FluidBlock)
+	{
+		return;
+	}
+
+	auto ChunkData = GetChunkData(*a_Chunk);
+	int SectionNum = a_Block.y / cChunkData::SectionHeight;
+	auto & Mask = ChunkData->m_Masks[m_AddSet][SectionNum];
+	if (Mask == nullptr)
+	{
+		Mask.reset(new cDenseFluidKernel::cDirtyMask);
+	}
+	Mask->Set(RelX, a_Block.y % cChunkData::SectionHeight, RelZ);
+	ChunkData->m_DirtySections[m_AddSet] |= static_cast<UInt16>(1 << SectionNum);
+}
+
+
+
+
+
+void cDenseFluidSimulator::Simulate(float a_Dt)
+{
+	m_TicksSinceSweep += 1;
+	m_IsSweepTick = (m_TicksSinceSweep >= m_TickDelay);
+	if (m_IsSweepTick)
+	{
+		// Sweep the blocks added until now, add the new ones into the other set:
+		m_TicksSinceSweep = 0;
+		m_AddSet = 1 - m_AddSet;
+	}
+}
+
+
+
+
+
+void cDenseFluidSimulator::SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk)
+{
+	if (!m_IsSweepTick)
+	{
+		return;
+	}
+
+	auto ChunkData = GetChunkData(*a_Chunk);
+	int SweepSet = 1 - m_AddSet;
+	if (ChunkData->m_DirtySections[SweepSet] == 0)
+	{
+		return;
+	}
+
+	// The blocks woken up by the sweep are added to the other set, so the masks can be swept in place:
+	for (int SectionNum = 0; SectionNum < static_cast<int>(cChunkData::NumSections); SectionNum++)
+	{
+		if ((ChunkData->m_DirtySections[SweepSet] & (1 << SectionNum)) == 0)
+		{
+			continue;
+		}
+		auto & Mask = *ChunkData->m_Masks[SweepSet][SectionNum];
+		SweepSection(*a_Chunk, SectionNum, Mask);
+		Mask.Clear();
+	}
+	ChunkData->m_DirtySections[SweepSet] = 0;
+}
+
+
+
+
+
+cDenseFluidSimulatorChunkData * cDenseFluidSimulator::GetChunkData(cChunk & a_Chunk)
+{
+	auto ChunkDataRaw = (m_FluidBlock == E_BLOCK_WATER) ? a_Chunk.GetWaterSimulatorData() : a_Chunk.GetLavaSimulatorData();
+	return static_cast<cDenseFluidSimulatorChunkData *>(ChunkDataRaw);
+}
+
+
+
+
+
+void cDenseFluidSimulator::SweepSection(cChunk & a_Chunk, int a_SectionNum, const cDenseFluidKernel::cDirtyMask & a_Mask)
+{
+	size_t SectionNum = static_cast<size_t>(a_SectionNum);
+	cDenseFluidKernel::sNeighborhood Neighborhood;
+	Neighborhood.m_Center = a_Chunk.GetSection(SectionNum);
+
+	// The neighbor chunks, in the order of cDenseFluidKernel::eFace; the vertical neighbors are in this chunk:
+	cChunk * Neighbors[] =
+	{
+		a_Chunk.GetRelNeighborChunk(-1, 0),
+		a_Chunk.GetRelNeighborChunk(cChunkDef::Width, 0),
+		nullptr,
+		nullptr,
+		a_Chunk.GetRelNeighborChunk(0, -1),
+		a_Chunk.GetRelNeighborChunk(0, cChunkDef::Width),
+	};
+	for (size_t i = 0; i < ARRAYCOUNT(Neighbors); i++)
+	{
+		Neighborhood.m_IsAvailable[i] = (Neighbors[i] != nullptr) && Neighbors[i]->IsValid();
+		Neighborhood.m_Neighbors[i] = Neighborhood.m_IsAvailable[i] ? Neighbors[i]->GetSection(SectionNum) : nullptr;
+	}
+	Neighborhood.m_IsAvailable[2] = (SectionNum > 0);
+	Neighborhood.m_Neighbors[2] = (SectionNum > 0) ? a_Chunk.GetSection(SectionNum - 1) : nullptr;
+	Neighborhood.m_IsAvailable[3] = (SectionNum < cChunkData::NumSections - 1);
+	Neighborhood.m_Neighbors[3] = (SectionNum < cChunkData::NumSections - 1) ? a_Chunk.GetSection(SectionNum + 1) : nullptr;
+
+	m_Kernel.FillWindow(m_Window, a_SectionNum * cChunkData::SectionHeight, a_Mask, Neighborhood);
+	m_Changes.clear();
+	m_Kernel.Sweep(m_Window, a_Mask, m_Changes);
+	ApplyChanges(a_Chunk, a_SectionNum);
+}
+
+
+
+
+
+void cDenseFluidSimulator::ApplyChanges(cChunk & a_Chunk, int a_SectionNum)
+{
+	for (const auto & Change : m_Changes)
+	{
+		int RelX = Change.m_RelX;
+		int RelY = a_SectionNum * cChunkData::SectionHeight + Change.m_RelY;
+		int RelZ = Change.m_RelZ;
+		cChunk * Chunk = a_Chunk.GetRelNeighborChunkAdjustCoords(RelX, RelZ);
+		if ((Chunk == nullptr) || !Chunk->IsValid())
+		{
+			// The kernel only changes the halo of the available neighbors
+			ASSERT(!"Fluid change in an unavailable chunk");
+			continue;
+		}
+		const int BlockX = Chunk->GetPosX() * cChunkDef::Width + RelX;
+		const int BlockZ = Chunk->GetPosZ() * cChunkDef::Width + RelZ;
+
+		switch (Change.m_Kind)
+		{
+			case cDenseFluidKernel::ckProcessed:
+			{
+				Chunk->FastSetBlock(RelX, RelY, RelZ, Change.m_BlockType, Change.m_Meta);
+				break;
+			}
+			case cDenseFluidKernel::ckSet:
+			{
+				Chunk->SetBlock(RelX, RelY, RelZ, Change.m_BlockType, Change.m_Meta);
+				break;
+			}
+			case cDenseFluidKernel::ckExtinguish:
+			{
+				Chunk->SetBlock(RelX, RelY, RelZ, Change.m_BlockType, Change.m_Meta);
+				Chunk->BroadcastSoundEffect("block.lava.extinguish", Vector3d(BlockX, RelY, BlockZ), 0.5f, 1.5f);
+				break;
+			}
+			case cDenseFluidKernel::ckSpread:
+			{
+				// Wash away the block there, if possible:
+				if (CanWashAway(Change.m_OldBlockType))
+				{
+					cBlockHandler * Handler = BlockHandler(Change.m_OldBlockType);
+					if (Handler->DoesDropOnUnsuitable())
+					{
+						cChunkInterface ChunkInterface(m_World.GetChunkMap());
+						cBlockInServerPluginInterface PluginInterface(m_World);
+						Handler->DropBlock(ChunkInterface, m_World, PluginInterface, nullptr, BlockX, RelY, BlockZ);
+					}
+				}
+				Chunk->SetBlock(RelX, RelY, RelZ, Change.m_BlockType, Change.m_Meta);
+				m_World.GetSimulatorManager()->WakeUp({BlockX, RelY, BlockZ}, Chunk);
+				HardenSpreadLava(*Chunk, RelX, RelY, RelZ, Change.m_Meta);
+				break;
+			}
+		}
+	}
+}
+
+
+
+
+
+void cDenseFluidSimulator::HardenSpreadLava(cChunk & a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Meta)
+{
+	if (!IsBlockLava(m_FluidBlock))
+	{
+		return;
+	}
+
+	static const Vector3i Coords[] =
+	{
+		Vector3i( 1, 0,  0),
+		Vector3i(-1, 0,  0),
+		Vector3i( 0, 0,  1),
+		Vector3i( 0, 0, -1),
+	};
+	for (size_t i = 0; i < ARRAYCOUNT(Coords); i++)
+	{
+		BLOCKTYPE BlockType;
+		NIBBLETYPE BlockMeta;
+		if (!a_Chunk.UnboundedRelGetBlock(a_RelX + Coords[i].x, a_RelY, a_RelZ + Coords[i].z, BlockType, BlockMeta))
+		{
+			continue;
+		}
+		if (IsBlockWater(BlockType))
+		{
+			if (a_Meta == 0)
+			{
+				a_Chunk.SetBlock(a_RelX, a_RelY, a_RelZ, E_BLOCK_OBSIDIAN, 0);
+			}
+			else if (a_Meta <= 4)
+			{
+				a_Chunk.SetBlock(a_RelX, a_RelY, a_RelZ, E_BLOCK_COBBLESTONE, 0);
+			}
+			return;
+		}
+	}
+}
+
+
+
+
@@ -0,0 +1,99 @@
+
+// DenseFluidSimulator.h
+
+// Declares the cDenseFluidSimulator class representing a fluid simulator that uses the Floody rules,
+// but keeps the scheduled blocks in per-section bitmasks and simulates them section by section using cDenseFluidKernel
+
+/*
+Each chunk keeps two sets of per-section masks: the blocks woken up since the last sweep are marked in one set,
+while the other set is being swept. Every m_TickDelay ticks, the sets are swapped and each chunk sweeps all the
+marked blocks of each of its sections at once: the section and the needed parts of its neighbors are copied into
+the kernel's window, the kernel simulates the blocks within the window, and the changes are written back.
+Blocks woken up during the sweep are thus simulated in the next sweep, the same delay as in the Floody simulator.
+*/
+
+
+
+
+
+#pragma once
+
+#include "FluidSimulator.h"
+#include "DenseFluidKernel.h"
+
+
+
+
+
+class cDenseFluidSimulatorChunkData :
+	public cFluidSimulatorData
+{
+public:
+	cDenseFluidSimulatorChunkData(void);
+
+	/** The masks of blocks to simulate, two sets (see cDenseFluidSimulator::m_AddSet), one mask per section.
+	Allocated when first needed. */
+	std::unique_ptr<cDenseFluidKernel::cDirtyMask> m_Masks[2][cChunkData::NumSections];
+
+	/** For each set of masks, the bitmask of the sections that have any block marked. */
+	UInt16 m_DirtySections[2];
+} ;
+
+
+
+
+
+class cDenseFluidSimulator :
+	public cFluidSimulator
+{
+	typedef cFluidSimulator super;
+
+public:
+	cDenseFluidSimulator(cWorld & a_World, BLOCKTYPE a_Fluid, BLOCKTYPE a_StationaryFluid, NIBBLETYPE a_Falloff, int a_TickDelay, int a_NumNeighborsForSource);
+
+	// cSimulator overrides:
+	virtual void AddBlock(Vector3i a_Block, cChunk * a_Chunk) override;
+	virtual void Simulate(float a_Dt) override;
+	virtual void SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk) override;
+	virtual cFluidSimulatorData * CreateChunkData(void) override { return new cDenseFluidSimulatorChunkData; }
+
+protected:
+
+	cDenseFluidKernel m_Kernel;
+
+	/** The number of ticks between two sweeps. */
+	int m_TickDelay;
+
+	/** The number of ticks since the last sweep. */
+	int m_TicksSinceSweep;
+
+	/** True if the current tick sweeps the chunks. */
+	bool m_IsSweepTick;
+
+	/** The index of the set of masks in each chunk data where the new blocks are added; the other set is being swept. */
+	int m_AddSet;
+
+	/** The window reused for all the sweeps. */
+	cDenseFluidKernel::cWindow m_Window;
+
+	/** The changes of the current sweep, reused for all the sweeps. */
+	cDenseFluidKernel::cChanges m_Changes;
+
+
+	/** Returns the chunk data of this simulator's fluid in the specified chunk. */
+	cDenseFluidSimulatorChunkData * GetChunkData(cChunk & a_Chunk);
+
+	/** Sweeps the blocks marked in a_Mask in the specified section of the chunk. */
+	void SweepSection(cChunk & a_Chunk, int a_SectionNum, const cDenseFluidKernel::cDirtyMask & a_Mask);
+
+	/** Writes the changes made by the kernel in the specified section back into the world. */
+	void ApplyChanges(cChunk & a_Chunk, int a_SectionNum);
+
+	/** Hardens the lava that has spread next to water, see cFloodyFluidSimulator::HardenBlock().
+	This is the only rule that needs blocks outside the window (the spread may have gone into the halo), so it's done by the writeback. */
+	void HardenSpreadLava(cChunk & a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Meta);
+} ;
+
+
+
+
@@ -61,7 +61,7 @@ public:
 	bool IsPassableForFluid(BLOCKTYPE a_BlockType);
 
 	/** Returns true if a_Meta1 is a higher fluid than a_Meta2. Takes source blocks into account. */
-	bool IsHigherMeta(NIBBLETYPE a_Meta1, NIBBLETYPE a_Meta2);
+	static bool IsHigherMeta(NIBBLETYPE a_Meta1, NIBBLETYPE a_Meta2);
 
 protected:
 	BLOCKTYPE m_FluidBlock;            // The fluid block type that needs simulating
@@ -135,22 +135,38 @@ void cIncrementalRedstoneSimulator::Simulate(float a_dt)
 	}
 
 	// Build our work queue
-	cVector3iArray WorkQueue;
-	std::swap(WorkQueue, m_Data.GetActiveBlocks());
+	std::vector<sQueuedComponent> WorkQueue;
+	WorkQueue.reserve(m_Data.GetActiveBlocks().size());
+	for (const auto & Position : m_Data.GetActiveBlocks())
+	{
+		WorkQueue.emplace_back(Position);
+	}
+	m_Data.GetActiveBlocks().clear();
+
+	ProcessWorkQueue(WorkQueue);
+}
+
+
 
-	// Process the work queue
-	while (!WorkQueue.empty())
+
+
+void cIncrementalRedstoneSimulator::ProcessWorkQueue(std::vector<sQueuedComponent> & a_WorkQueue)
+{
+	std::vector<sSourceBlock> Sources;
+	while (!a_WorkQueue.empty())
 	{
 		// Grab the first element and remove it from the list
-		Vector3i CurrentLocation = WorkQueue.back();
-		WorkQueue.pop_back();
+		sQueuedComponent Current = a_WorkQueue.back();
+		a_WorkQueue.pop_back();
+		Vector3i CurrentLocation = Current.m_Position;
 
-		BLOCKTYPE CurrentBlock;
-		NIBBLETYPE CurrentMeta;
-		if (!m_World.GetBlockTypeMeta(CurrentLocation.x, CurrentLocation.y, CurrentLocation.z, CurrentBlock, CurrentMeta))
+		sComponent Component;
+		if (!ReadComponent(CurrentLocation, Component, Sources))
 		{
 			continue;
 		}
+		BLOCKTYPE CurrentBlock = Component.m_BlockType;
+		NIBBLETYPE CurrentMeta = Component.m_Meta;
 
 		auto CurrentHandler = GetComponentHandler(CurrentBlock);
 		if (CurrentHandler == nullptr)  // Block at CurrentPosition doesn't have a corresponding redstone handler
@@ -161,30 +177,61 @@ void cIncrementalRedstoneSimulator::Simulate(float a_dt)
 			continue;
 		}
 
-		cRedstoneHandler::PoweringData Power;
-		for (const auto & Location : CurrentHandler->GetValidSourcePositions(m_World, CurrentLocation, CurrentBlock, CurrentMeta))
+		if (m_UseCompiledNetworks && !Component.m_IsCompiled && cRedstoneGraph::IsCompiledType(CurrentBlock))
 		{
-			if (!cChunk::IsValidHeight(Location.y))
+			CompileComponent(CurrentLocation, CurrentBlock, CurrentMeta, *CurrentHandler);
+			if (!ReadComponent(CurrentLocation, Component, Sources))
 			{
 				continue;
 			}
-			BLOCKTYPE PotentialBlock;
-			NIBBLETYPE PotentialMeta;
-			m_World.GetBlockTypeMeta(Location.x, Location.y, Location.z, PotentialBlock, PotentialMeta);
+		}
+
+		if (Component.m_CanSkip && Current.m_HasQueuer && !IsSource(Current.m_Queuer, Sources))
+		{
+			// The component has settled and the queuer isn't one of its sources, none of its inputs has changed:
+			continue;
+		}
+
+		if (!Component.m_IsCompiled)
+		{
+			ReadSources(CurrentLocation, CurrentBlock, CurrentMeta, *CurrentHandler, Sources);
+		}
+		#ifdef _DEBUG
+			else
+			{
+				VerifyCompiledSources(CurrentLocation, CurrentBlock, CurrentMeta, *CurrentHandler, Sources);
+			}
+		#endif
 
-			auto PotentialSourceHandler = GetComponentHandler(PotentialBlock);
+		cRedstoneHandler::PoweringData Power;
+		for (const auto & Source : Sources)
+		{
+			auto PotentialSourceHandler = GetComponentHandler(Source.m_BlockType);
 			if (PotentialSourceHandler == nullptr)
 			{
 				continue;
 			}
 
-			decltype(Power) PotentialPower(PotentialBlock, PotentialSourceHandler->GetPowerDeliveredToPosition(m_World, Location, PotentialBlock, PotentialMeta, CurrentLocation, CurrentBlock));
+			decltype(Power) PotentialPower(Source.m_BlockType, PotentialSourceHandler->GetPowerDeliveredToPosition(m_World, Source.m_Position, Source.m_BlockType, Source.m_Meta, CurrentLocation, CurrentBlock));
 			Power = std::max(Power, PotentialPower);
 		}
 
 		// Inform the handler to update
 		cVector3iArray Updates = CurrentHandler->Update(m_World, CurrentLocation, CurrentBlock, CurrentMeta, Power);
-		WorkQueue.insert(WorkQueue.end(), Updates.begin(), Updates.end());
+		for (const auto & Update : Updates)
+		{
+			a_WorkQueue.emplace_back(Update, CurrentLocation);
+		}
+
+		if (Component.m_IsCompiled)
+		{
+			// The component has settled if it neither changed nor started a delay:
+			bool IsSettled = (Updates.empty() && (m_Data.GetMechanismDelayInfo(CurrentLocation) == nullptr));
+			if (IsSettled != Component.m_IsNodeSettled)
+			{
+				SetNodeSettled(CurrentLocation, CurrentBlock, CurrentMeta, IsSettled);
+			}
+		}
 
 		if (IsAlwaysTicked(CurrentBlock))
 		{
@@ -192,3 +239,304 @@ void cIncrementalRedstoneSimulator::Simulate(float a_dt)
 		}
 	}
 }
+
+
+
+
+
+void cIncrementalRedstoneSimulator::SetComponentVariant(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta)
+{
+	m_IsSettingComponentVariant = true;
+	m_World.SetBlock(a_Position.x, a_Position.y, a_Position.z, a_BlockType, a_Meta);
+	m_IsSettingComponentVariant = false;
+}
+
+
+
+
+
+bool cIncrementalRedstoneSimulator::GetCompiledTerracingOffsets(Vector3i a_Position, cVector3iArray & a_Offsets)
+{
+	if (!m_UseCompiledNetworks || !cChunkDef::IsValidHeight(a_Position.y))
+	{
+		return false;
+	}
+
+	return m_World.DoWithChunkAt(a_Position, [&](cChunk & a_Chunk)
+		{
+			int RelX = a_Position.x - a_Chunk.GetPosX() * cChunkDef::Width;
+			int RelZ = a_Position.z - a_Chunk.GetPosZ() * cChunkDef::Width;
+			auto Graph = static_cast<cRedstoneGraph *>(a_Chunk.GetRedstoneSimulatorData());
+			auto Node = Graph->GetNode(RelX, a_Position.y, RelZ, E_BLOCK_REDSTONE_WIRE, 0);
+			if (Node == nullptr)
+			{
+				return false;
+			}
+			a_Offsets = Node->m_TerracingOffsets;
+			return true;
+		}
+	);
+}
+
+
+
+
+
+bool cIncrementalRedstoneSimulator::ReadComponent(Vector3i a_Position, sComponent & a_Component, std::vector<sSourceBlock> & a_Sources)
+{
+	a_Component.m_IsCompiled = false;
+	a_Component.m_IsNodeSettled = false;
+	a_Component.m_CanSkip = false;
+	if (!m_UseCompiledNetworks)
+	{
+		return m_World.GetBlockTypeMeta(a_Position.x, a_Position.y, a_Position.z, a_Component.m_BlockType, a_Component.m_Meta);
+	}
+
+	if (!cChunkDef::IsValidHeight(a_Position.y))
+	{
+		return false;
+	}
+
+	// Read the component and its sources all from within the chunk and its neighbors, with a single chunk map lookup.
+	// The chunk map is only locked for the lookup, not while the handlers evaluate the component:
+	return m_World.DoWithChunkAt(a_Position, [&](cChunk & a_Chunk)
+		{
+			if (!a_Chunk.IsValid())
+			{
+				return false;
+			}
+			int RelX = a_Position.x - a_Chunk.GetPosX() * cChunkDef::Width;
+			int RelZ = a_Position.z - a_Chunk.GetPosZ() * cChunkDef::Width;
+			a_Chunk.GetBlockTypeMeta(RelX, a_Position.y, RelZ, a_Component.m_BlockType, a_Component.m_Meta);
+			auto Graph = static_cast<cRedstoneGraph *>(a_Chunk.GetRedstoneSimulatorData());
+			auto Node = Graph->GetNode(RelX, a_Position.y, RelZ, a_Component.m_BlockType, a_Component.m_Meta);
+			if (Node == nullptr)
+			{
+				return true;
+			}
+
+			a_Sources.clear();
+			bool ArePushedSources = true;
+			for (const auto & Offset : Node->m_SourceOffsets)
+			{
+				int SourceY = a_Position.y + Offset.y;
+				if (!cChunkDef::IsValidHeight(SourceY))
+				{
+					continue;
+				}
+				sSourceBlock Source;
+				Source.m_Position = a_Position + Offset;
+				if (a_Chunk.UnboundedRelGetBlock(RelX + Offset.x, SourceY, RelZ + Offset.z, Source.m_BlockType, Source.m_Meta))
+				{
+					a_Sources.push_back(Source);
+					ArePushedSources = ArePushedSources && IsPushingSource(Source.m_BlockType);
+				}
+				else
+				{
+					ArePushedSources = false;
+				}
+			}
+			a_Component.m_IsCompiled = true;
+			a_Component.m_IsNodeSettled = Node->m_IsSettled;
+			a_Component.m_CanSkip = Node->m_IsSettled && ArePushedSources && IsSkippableType(a_Component.m_BlockType);
+			return true;
+		}
+	);
+}
+
+
+
+
+
+void cIncrementalRedstoneSimulator::ReadSources(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const cRedstoneHandler & a_Handler, std::vector<sSourceBlock> & a_Sources)
+{
+	a_Sources.clear();
+	for (const auto & Location : a_Handler.GetValidSourcePositions(m_World, a_Position, a_BlockType, a_Meta))
+	{
+		if (!cChunk::IsValidHeight(Location.y))
+		{
+			continue;
+		}
+		sSourceBlock Source;
+		Source.m_Position = Location;
+		if (m_World.GetBlockTypeMeta(Location.x, Location.y, Location.z, Source.m_BlockType, Source.m_Meta))
+		{
+			a_Sources.push_back(Source);
+		}
+	}
+}
+
+
+
+
+
+bool cIncrementalRedstoneSimulator::IsSource(Vector3i a_Position, const std::vector<sSourceBlock> & a_Sources)
+{
+	for (const auto & Source : a_Sources)
+	{
+		if (Source.m_Position == a_Position)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
+#ifdef _DEBUG
+
+void cIncrementalRedstoneSimulator::VerifyCompiledSources(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const cRedstoneHandler & a_Handler, const std::vector<sSourceBlock> & a_Sources)
+{
+	// Read the sources the way the simulator does without the compiled networks, including the wires' terracing:
+	std::vector<sSourceBlock> Expected;
+	m_UseCompiledNetworks = false;
+	ReadSources(a_Position, a_BlockType, a_Meta, a_Handler, Expected);
+	m_UseCompiledNetworks = true;
+
+	ASSERT(a_Sources.size() == Expected.size());
+	for (size_t i = 0; i < std::min(a_Sources.size(), Expected.size()); i++)
+	{
+		ASSERT(a_Sources[i].m_Position == Expected[i].m_Position);
+		ASSERT(a_Sources[i].m_BlockType == Expected[i].m_BlockType);
+		ASSERT(a_Sources[i].m_Meta == Expected[i].m_Meta);
+	}
+}
+
+#endif  // _DEBUG
+
+
+
+
+
+void cIncrementalRedstoneSimulator::CompileComponent(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const cRedstoneHandler & a_Handler)
+{
+	cRedstoneGraph::sNode Node;
+	for (const auto & Location : a_Handler.GetValidSourcePositions(m_World, a_Position, a_BlockType, a_Meta))
+	{
+		Node.m_SourceOffsets.push_back(Location - a_Position);
+	}
+	if (a_BlockType == E_BLOCK_REDSTONE_WIRE)
+	{
+		Node.m_TerracingOffsets = cRedstoneWireHandler::ComputeTerracingConnectionOffsets(m_World, a_Position);
+	}
+	Node.m_BlockType = a_BlockType;
+	Node.m_Meta = a_Meta;
+	cRedstoneGraph::GetStamp(Node.m_BlockType, Node.m_Meta);
+
+	m_World.DoWithChunkAt(a_Position, [&](cChunk & a_Chunk)
+		{
+			// Only compile when all the blocks around the component are available, so that loading a neighbor chunk
+			// (which doesn't wake up its non-redstone blocks) cannot change the topology:
+			for (int x = -1; x <= 1; x++)
+			{
+				for (int z = -1; z <= 1; z++)
+				{
+					auto Neighbor = a_Chunk.GetNeighborChunk(a_Position.x + x, a_Position.z + z);
+					if ((Neighbor == nullptr) || !Neighbor->IsValid())
+					{
+						return false;
+					}
+				}
+			}
+			int RelX = a_Position.x - a_Chunk.GetPosX() * cChunkDef::Width;
+			int RelZ = a_Position.z - a_Chunk.GetPosZ() * cChunkDef::Width;
+			static_cast<cRedstoneGraph *>(a_Chunk.GetRedstoneSimulatorData())->SetNode(RelX, a_Position.y, RelZ, std::move(Node));
+			return true;
+		}
+	);
+}
+
+
+
+
+
+void cIncrementalRedstoneSimulator::SetNodeSettled(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, bool a_IsSettled)
+{
+	m_World.DoWithChunkAt(a_Position, [&](cChunk & a_Chunk)
+		{
+			int RelX = a_Position.x - a_Chunk.GetPosX() * cChunkDef::Width;
+			int RelZ = a_Position.z - a_Chunk.GetPosZ() * cChunkDef::Width;
+			auto Node = static_cast<cRedstoneGraph *>(a_Chunk.GetRedstoneSimulatorData())->GetNode(RelX, a_Position.y, RelZ, a_BlockType, a_Meta);
+			if (Node == nullptr)
+			{
+				// The evaluation has replaced the component, or a block next to it
+				return false;
+			}
+			Node->m_IsSettled = a_IsSettled;
+			return true;
+		}
+	);
+}
+
+
+
+
+
+void cIncrementalRedstoneSimulator::ChunkBlocksSet(cChunk & a_Chunk)
+{
+	if (!m_UseCompiledNetworks)
+	{
+		return;
+	}
+
+	// All the chunk's nodes are stale, and so are the neighbors' nodes next to the chunk:
+	EraseNodes(a_Chunk, -INVALIDATION_RADIUS, cChunkDef::Width - 1 + INVALIDATION_RADIUS, 0, cChunkDef::Height - 1, -INVALIDATION_RADIUS, cChunkDef::Width - 1 + INVALIDATION_RADIUS);
+}
+
+
+
+
+
+void cIncrementalRedstoneSimulator::InvalidateCompiledNetworks(Vector3i a_Block, cChunk & a_Chunk)
+{
+	int RelX = a_Block.x - a_Chunk.GetPosX() * cChunkDef::Width;
+	int RelZ = a_Block.z - a_Chunk.GetPosZ() * cChunkDef::Width;
+	EraseNodes(
+		a_Chunk,
+		RelX - INVALIDATION_RADIUS, RelX + INVALIDATION_RADIUS,
+		a_Block.y - INVALIDATION_RADIUS, a_Block.y + INVALIDATION_RADIUS,
+		RelZ - INVALIDATION_RADIUS, RelZ + INVALIDATION_RADIUS
+	);
+}
+
+
+
+
+
+void cIncrementalRedstoneSimulator::EraseNodes(cChunk & a_Chunk, int a_MinRelX, int a_MaxRelX, int a_MinY, int a_MaxY, int a_MinRelZ, int a_MaxRelZ)
+{
+	// The box reaches at most one chunk beyond a_Chunk, erase its part in each chunk it touches:
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int z = -1; z <= 1; z++)
+		{
+			int OffsetX = x * cChunkDef::Width;
+			int OffsetZ = z * cChunkDef::Width;
+			if (
+				(a_MaxRelX < OffsetX) || (a_MinRelX >= OffsetX + cChunkDef::Width) ||
+				(a_MaxRelZ < OffsetZ) || (a_MinRelZ >= OffsetZ + cChunkDef::Width)
+			)
+			{
+				continue;
+			}
+			auto Chunk = a_Chunk.GetRelNeighborChunk(OffsetX, OffsetZ);
+			if (Chunk == nullptr)
+			{
+				continue;
+			}
+			static_cast<cRedstoneGraph *>(Chunk->GetRedstoneSimulatorData())->EraseNodes(
+				a_MinRelX - OffsetX, a_MaxRelX - OffsetX,
+				a_MinY, a_MaxY,
+				a_MinRelZ - OffsetZ, a_MaxRelZ - OffsetZ
+			);
+		}
+	}
+}
+
+
+
+
+
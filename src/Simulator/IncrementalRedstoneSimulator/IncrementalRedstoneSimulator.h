@@ -3,6 +3,7 @@
 
 #include "../RedstoneSimulator.h"
 #include "RedstoneSimulatorChunkData.h"
+#include "RedstoneGraph.h"
 
 
 
@@ -13,17 +14,21 @@ class cIncrementalRedstoneSimulator :
 {
 	typedef cRedstoneSimulator super;
 public:
-	cIncrementalRedstoneSimulator(cWorld & a_World) :
-		super(a_World)
+	/** Creates the simulator. If a_UseCompiledNetworks is true, the topology of the wires, repeaters, comparators
+	and torches is compiled into a per-chunk cRedstoneGraph and reused until a block changes its type near them. */
+	cIncrementalRedstoneSimulator(cWorld & a_World, bool a_UseCompiledNetworks = false) :
+		super(a_World),
+		m_UseCompiledNetworks(a_UseCompiledNetworks),
+		m_IsSettingComponentVariant(false)
 	{
 	}
 
 	virtual void Simulate(float a_dt) override;
 	virtual void SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk) override {}
 
-	virtual cIncrementalRedstoneSimulatorChunkData * CreateChunkData() override
+	virtual cRedstoneGraph * CreateChunkData() override
 	{
-		return new cIncrementalRedstoneSimulatorChunkData;
+		return new cRedstoneGraph;
 	}
 
 	virtual bool IsAllowedBlock(BLOCKTYPE a_BlockType) override
@@ -36,6 +41,24 @@ public:
 		m_Data.WakeUp(a_Block);
 	}
 
+	virtual void BlockTypeChanged(Vector3i a_Block, cChunk & a_Chunk) override
+	{
+		if (m_UseCompiledNetworks && !m_IsSettingComponentVariant)
+		{
+			InvalidateCompiledNetworks(a_Block, a_Chunk);
+		}
+	}
+
+	virtual void ChunkBlocksSet(cChunk & a_Chunk) override;
+
+	/** Sets the block to another variant of the same component, such as a torch turning on.
+	The variants don't differ in anything the compiled networks depend on, so unlike other block type changes, this doesn't invalidate them. */
+	void SetComponentVariant(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta);
+
+	/** If the wire at the specified position has been compiled, stores the offsets of the wires connected to it by terracing
+	into a_Offsets and returns true. Returns false if compiled networks are disabled or the wire hasn't been compiled. */
+	bool GetCompiledTerracingOffsets(Vector3i a_Position, cVector3iArray & a_Offsets);
+
 	/** Returns if a block is a mechanism (something that accepts power and does something)
 	Used by torches to determine if they will power a block
 	*/
@@ -163,8 +186,144 @@ public:
 
 private:
 
+	/** The distance from a changed block within which the compiled nodes are dropped.
+	The block's type changes the terracing of the wires next to it, and the power those wires deliver to their neighbors. */
+	static const int INVALIDATION_RADIUS = 2;
+
+	/** A component waiting in the work queue, with the component that queued it, if any. */
+	struct sQueuedComponent
+	{
+		Vector3i m_Position;
+
+		/** The position of the component whose evaluation queued this one. Only valid if m_HasQueuer is set. */
+		Vector3i m_Queuer;
+
+		/** False for the components woken up from outside the work queue, such as by a block change or a delay running out. */
+		bool m_HasQueuer;
+
+		sQueuedComponent(Vector3i a_Position) :
+			m_Position(a_Position),
+			m_HasQueuer(false)
+		{
+		}
+
+		sQueuedComponent(Vector3i a_Position, Vector3i a_Queuer) :
+			m_Position(a_Position),
+			m_Queuer(a_Queuer),
+			m_HasQueuer(true)
+		{
+		}
+	};
+
+	/** A component as read from the world by ReadComponent(). */
+	struct sComponent
+	{
+		BLOCKTYPE m_BlockType;
+		NIBBLETYPE m_Meta;
+
+		/** True if the component has been compiled, its sources were read using the compiled node. */
+		bool m_IsCompiled;
+
+		/** The compiled node's m_IsSettled. */
+		bool m_IsNodeSettled;
+
+		/** True if the component can be skipped when queued by a block that isn't one of its sources:
+		it has settled, and each of its sources queues it whenever the power delivered to it may change. */
+		bool m_CanSkip;
+	};
+
+	/** A block a component takes its power from, as read from the chunk together with the component. */
+	struct sSourceBlock
+	{
+		Vector3i m_Position;
+		BLOCKTYPE m_BlockType;
+		NIBBLETYPE m_Meta;
+	};
+
 	static std::unique_ptr<cRedstoneHandler> CreateComponent(BLOCKTYPE a_BlockType);
 
+	/** Returns true if the power a block of the specified type delivers only changes when the simulator evaluates it,
+	and the evaluation then queues all the blocks the power may reach (or the block never delivers any power).
+	The components with such sources only need evaluating when queued by a source, or woken up. */
+	inline static bool IsPushingSource(BLOCKTYPE a_BlockType)
+	{
+		switch (a_BlockType)
+		{
+			case E_BLOCK_BLOCK_OF_REDSTONE:
+			case E_BLOCK_REDSTONE_LAMP_OFF:
+			case E_BLOCK_REDSTONE_LAMP_ON:
+			case E_BLOCK_REDSTONE_REPEATER_OFF:
+			case E_BLOCK_REDSTONE_REPEATER_ON:
+			case E_BLOCK_REDSTONE_TORCH_OFF:
+			case E_BLOCK_REDSTONE_TORCH_ON:
+			case E_BLOCK_REDSTONE_WIRE:
+			{
+				return true;
+			}
+			default:
+			{
+				// The other blocks either have no handler, or the solid block handler:
+				return !IsRedstone(a_BlockType);
+			}
+		}
+	}
+
+	/** Returns true if evaluating a settled component of the specified type again, with the same sources, changes nothing.
+	Comparators aren't skippable, they also read the contents of the container behind them. */
+	inline static bool IsSkippableType(BLOCKTYPE a_BlockType)
+	{
+		switch (a_BlockType)
+		{
+			case E_BLOCK_REDSTONE_REPEATER_OFF:
+			case E_BLOCK_REDSTONE_REPEATER_ON:
+			case E_BLOCK_REDSTONE_TORCH_OFF:
+			case E_BLOCK_REDSTONE_TORCH_ON:
+			case E_BLOCK_REDSTONE_WIRE:
+			{
+				return true;
+			}
+			default: return false;
+		}
+	}
+
+	/** Evaluates the components in the work queue, and the components they update, until the queue is empty.
+	With the compiled networks, a settled component is skipped when queued by a block that isn't one of its sources. */
+	void ProcessWorkQueue(std::vector<sQueuedComponent> & a_WorkQueue);
+
+	/** Reads the block at a_Position into a_Component. If the block has been compiled, also reads the blocks of its sources
+	into a_Sources, all from the same chunk and its neighbors. Returns false if the chunk isn't available. */
+	bool ReadComponent(Vector3i a_Position, sComponent & a_Component, std::vector<sSourceBlock> & a_Sources);
+
+	/** Reads the blocks of the sources the handler reports for the component into a_Sources, one by one through the world. */
+	void ReadSources(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const cRedstoneHandler & a_Handler, std::vector<sSourceBlock> & a_Sources);
+
+	/** Returns true if a_Position is one of the sources in a_Sources. */
+	static bool IsSource(Vector3i a_Position, const std::vector<sSourceBlock> & a_Sources);
+
+	#ifdef _DEBUG
+		/** Checks that the sources read for a compiled component are the same as the ones read without the compiled networks.
+		Catches any block change that should have invalidated the graph but didn't. */
+		void VerifyCompiledSources(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const cRedstoneHandler & a_Handler, const std::vector<sSourceBlock> & a_Sources);
+	#endif
+
+	/** Compiles the topology of the component at a_Position into its chunk's graph. */
+	void CompileComponent(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const cRedstoneHandler & a_Handler);
+
+	/** Sets whether the compiled component at a_Position has settled, if it is still compiled for the specified block. */
+	void SetNodeSettled(Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, bool a_IsSettled);
+
+	/** Drops the compiled nodes that may depend on the type of the block at a_Block, contained in a_Chunk. */
+	void InvalidateCompiledNetworks(Vector3i a_Block, cChunk & a_Chunk);
+
+	/** Drops the compiled nodes within the box, specified in coords relative to a_Chunk, in a_Chunk and its neighbors. */
+	void EraseNodes(cChunk & a_Chunk, int a_MinRelX, int a_MaxRelX, int a_MinY, int a_MaxY, int a_MinRelZ, int a_MaxRelZ);
+
 	// oh yea its crazy time
 	cIncrementalRedstoneSimulatorChunkData m_Data;
+
+	/** If true, the topology of the components is compiled into the chunks' cRedstoneGraph. */
+	bool m_UseCompiledNetworks;
+
+	/** Set while SetComponentVariant() is changing a block, so that BlockTypeChanged() doesn't invalidate the compiled networks. */
+	bool m_IsSettingComponentVariant;
 } ;
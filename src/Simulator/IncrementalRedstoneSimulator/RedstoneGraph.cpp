@@ -0,0 +1,159 @@
+
+// RedstoneGraph.cpp
+
+// Implements the cRedstoneGraph class that stores the compiled topology of the redstone components in a single chunk
+
+#include "Globals.h"
+#include "RedstoneGraph.h"
+#include "BlockID.h"
+#include "ChunkDef.h"
+
+
+
+
+
+const cRedstoneGraph::sNode * cRedstoneGraph::GetNode(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta) const
+{
+	auto itr = m_Nodes.find(cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ));
+	if (itr == m_Nodes.end())
+	{
+		return nullptr;
+	}
+	GetStamp(a_BlockType, a_Meta);
+	if ((itr->second.m_BlockType != a_BlockType) || (itr->second.m_Meta != a_Meta))
+	{
+		// The block has been replaced without an invalidation, by a block of the same type (e.g. a torch rotated by a plugin)
+		return nullptr;
+	}
+	return &itr->second;
+}
+
+
+
+
+
+cRedstoneGraph::sNode * cRedstoneGraph::GetNode(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta)
+{
+	return const_cast<sNode *>(static_cast<const cRedstoneGraph *>(this)->GetNode(a_RelX, a_RelY, a_RelZ, a_BlockType, a_Meta));
+}
+
+
+
+
+
+void cRedstoneGraph::SetNode(int a_RelX, int a_RelY, int a_RelZ, sNode && a_Node)
+{
+	m_Nodes[cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ)] = std::move(a_Node);
+}
+
+
+
+
+
+void cRedstoneGraph::EraseNodes(int a_MinRelX, int a_MaxRelX, int a_MinY, int a_MaxY, int a_MinRelZ, int a_MaxRelZ)
+{
+	a_MinRelX = std::max(a_MinRelX, 0);
+	a_MaxRelX = std::min(a_MaxRelX, cChunkDef::Width - 1);
+	a_MinY = std::max(a_MinY, 0);
+	a_MaxY = std::min(a_MaxY, cChunkDef::Height - 1);
+	a_MinRelZ = std::max(a_MinRelZ, 0);
+	a_MaxRelZ = std::min(a_MaxRelZ, cChunkDef::Width - 1);
+	if ((a_MinRelX > a_MaxRelX) || (a_MinY > a_MaxY) || (a_MinRelZ > a_MaxRelZ) || m_Nodes.empty())
+	{
+		return;
+	}
+
+	// Walk whichever is smaller, the box or the nodes:
+	size_t BoxVolume = static_cast<size_t>((a_MaxRelX - a_MinRelX + 1) * (a_MaxY - a_MinY + 1) * (a_MaxRelZ - a_MinRelZ + 1));
+	if (BoxVolume <= m_Nodes.size())
+	{
+		for (int y = a_MinY; y <= a_MaxY; y++)
+		{
+			for (int z = a_MinRelZ; z <= a_MaxRelZ; z++)
+			{
+				for (int x = a_MinRelX; x <= a_MaxRelX; x++)
+				{
+					m_Nodes.erase(cChunkDef::MakeIndexNoCheck(x, y, z));
+				}
+			}
+		}
+		return;
+	}
+
+	for (auto itr = m_Nodes.begin(); itr != m_Nodes.end();)
+	{
+		auto Pos = cChunkDef::IndexToCoordinate(static_cast<unsigned>(itr->first));
+		if (
+			(Pos.x >= a_MinRelX) && (Pos.x <= a_MaxRelX) &&
+			(Pos.y >= a_MinY) && (Pos.y <= a_MaxY) &&
+			(Pos.z >= a_MinRelZ) && (Pos.z <= a_MaxRelZ)
+		)
+		{
+			itr = m_Nodes.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+
+
+
+
+bool cRedstoneGraph::IsCompiledType(BLOCKTYPE a_BlockType)
+{
+	switch (a_BlockType)
+	{
+		case E_BLOCK_ACTIVE_COMPARATOR:
+		case E_BLOCK_INACTIVE_COMPARATOR:
+		case E_BLOCK_REDSTONE_REPEATER_OFF:
+		case E_BLOCK_REDSTONE_REPEATER_ON:
+		case E_BLOCK_REDSTONE_TORCH_OFF:
+		case E_BLOCK_REDSTONE_TORCH_ON:
+		case E_BLOCK_REDSTONE_WIRE:
+		{
+			return true;
+		}
+		default: return false;
+	}
+}
+
+
+
+
+
+void cRedstoneGraph::GetStamp(BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Meta)
+{
+	switch (a_BlockType)
+	{
+		case E_BLOCK_ACTIVE_COMPARATOR:
+		case E_BLOCK_INACTIVE_COMPARATOR:
+		{
+			a_BlockType = E_BLOCK_INACTIVE_COMPARATOR;
+			a_Meta &= 0x7;  // Drop the powered bit
+			break;
+		}
+		case E_BLOCK_REDSTONE_REPEATER_ON:
+		{
+			a_BlockType = E_BLOCK_REDSTONE_REPEATER_OFF;
+			break;
+		}
+		case E_BLOCK_REDSTONE_TORCH_ON:
+		{
+			a_BlockType = E_BLOCK_REDSTONE_TORCH_OFF;
+			break;
+		}
+		case E_BLOCK_REDSTONE_WIRE:
+		{
+			a_Meta = 0;  // The meta is the power level
+			break;
+		}
+		default: break;
+	}
+}
+
+
+
+
@@ -0,0 +1,99 @@
+
+// RedstoneGraph.h
+
+// Declares the cRedstoneGraph class that stores the compiled topology of the redstone components in a single chunk
+
+/*
+When the incremental redstone simulator evaluates a component, it needs the positions the component takes its power
+from. For wires, these depend on the blocks around the wire (terracing), so finding them takes a dozen block lookups
+through the chunk map, and the same lookups are repeated each time the wire's power changes or a neighbor asks for it.
+
+With compiled networks enabled, the simulator stores the result for wires, repeaters, comparators and torches in the
+chunk's cRedstoneGraph the first time it evaluates them. Each node is stamped with the block type and meta it was
+compiled for, without the bits that only hold the power state, so that a torch turning on or a wire changing its
+power level keeps using its node.
+
+The node's source offsets are the edges of the graph, along which the changes travel: a component that changes queues
+its neighbors, and a settled node (see sNode::m_IsSettled) queued by a block that isn't one of its sources is skipped
+instead of evaluated again. Without the graph, each of these neighbors is evaluated, only to find nothing has changed.
+
+The chunk reports any other change of a block's type, however it was made (including cChunk::FastSetBlock() and
+cChunk::WriteBlockArea(), which don't wake up the simulators); such a change drops the nodes within two blocks of it,
+which covers the wires whose terracing depends on the block and the components that take power from those wires.
+Loading or regenerating a chunk drops its nodes and its neighbors' nodes within two blocks of it. The nodes get
+compiled again as the components are evaluated. Debug builds check each compiled component's sources against the ones
+read without the graph.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../RedstoneSimulator.h"
+#include <unordered_map>
+
+
+
+
+
+class cRedstoneGraph :
+	public cRedstoneSimulatorChunkData
+{
+public:
+
+	/** The compiled topology of a single component. */
+	struct sNode
+	{
+		/** The block type the node was compiled for, see GetStamp(). */
+		BLOCKTYPE m_BlockType;
+
+		/** The block meta the node was compiled for, see GetStamp(). */
+		NIBBLETYPE m_Meta;
+
+		/** The positions the component takes its power from, relative to the component. */
+		cVector3iArray m_SourceOffsets;
+
+		/** For wires, the offsets of the wires connected to this one by terracing. Empty for the other components. */
+		cVector3iArray m_TerracingOffsets;
+
+		/** True if the component's last evaluation changed nothing and left no delay pending, so that evaluating it again
+		changes nothing either, until one of its sources changes. Set by the simulator after each evaluation. */
+		bool m_IsSettled = false;
+	};
+
+
+	/** Returns the node compiled at the specified chunk-relative position for the specified block, or nullptr if there's none.
+	A node compiled for a different block (other than in its power state) isn't returned. */
+	const sNode * GetNode(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta) const;
+	sNode * GetNode(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta);
+
+	/** Stores the node for the specified chunk-relative position, replacing any previous one.
+	The node's stamp is expected to have been set using GetStamp(). */
+	void SetNode(int a_RelX, int a_RelY, int a_RelZ, sNode && a_Node);
+
+	/** Drops the compiled nodes within the specified box of chunk-relative coords, inclusive.
+	The box may reach outside the chunk, only its part inside the chunk is used. */
+	void EraseNodes(int a_MinRelX, int a_MaxRelX, int a_MinY, int a_MaxY, int a_MinRelZ, int a_MaxRelZ);
+
+	/** Returns the number of compiled nodes. */
+	size_t GetNumNodes(void) const { return m_Nodes.size(); }
+
+	/** Returns true if the topology of the specified block type is compiled into the graph. */
+	static bool IsCompiledType(BLOCKTYPE a_BlockType);
+
+	/** Converts the block type and meta into the node's stamp, by dropping the power state:
+	the powered variants of the block types are replaced with the unpowered ones, and the meta of wires (their power level)
+	and the powered bit of comparators are cleared. */
+	static void GetStamp(BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Meta);
+
+protected:
+
+	/** The compiled nodes, indexed by the chunk-relative block index (cChunkDef::MakeIndexNoCheck()). */
+	std::unordered_map<int, sNode> m_Nodes;
+} ;
+
+
+
+
@@ -33,14 +33,14 @@ public:
 		{
 			if (!IsOn(a_BlockType))
 			{
-				a_World.SetBlock(a_Position.x, a_Position.y, a_Position.z, E_BLOCK_REDSTONE_LAMP_ON, 0);
+				static_cast<cIncrementalRedstoneSimulator *>(a_World.GetRedstoneSimulator())->SetComponentVariant(a_Position, E_BLOCK_REDSTONE_LAMP_ON, 0);
 			}
 		}
 		else
 		{
 			if (IsOn(a_BlockType))
 			{
-				a_World.SetBlock(a_Position.x, a_Position.y, a_Position.z, E_BLOCK_REDSTONE_LAMP_OFF, 0);
+				static_cast<cIncrementalRedstoneSimulator *>(a_World.GetRedstoneSimulator())->SetComponentVariant(a_Position, E_BLOCK_REDSTONE_LAMP_OFF, 0);
 			}
 		}
 
@@ -56,7 +56,7 @@ public:
 
 			if (DelayTicks == 0)
 			{
-				a_World.SetBlock(a_Position.x, a_Position.y, a_Position.z, ShouldPowerOn ? E_BLOCK_REDSTONE_REPEATER_ON : E_BLOCK_REDSTONE_REPEATER_OFF, a_Meta);
+				static_cast<cIncrementalRedstoneSimulator *>(a_World.GetRedstoneSimulator())->SetComponentVariant(a_Position, ShouldPowerOn ? E_BLOCK_REDSTONE_REPEATER_ON : E_BLOCK_REDSTONE_REPEATER_OFF, a_Meta);
 				Data->m_MechanismDelays.erase(a_Position);
 				return cVector3iArray{ cBlockRedstoneRepeaterHandler::GetFrontCoordinateOffset(a_Meta) + a_Position };
 			}
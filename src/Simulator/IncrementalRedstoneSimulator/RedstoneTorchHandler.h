@@ -74,7 +74,7 @@ public:
 
 			if (DelayTicks == 0)
 			{
-				a_World.SetBlock(a_Position.x, a_Position.y, a_Position.z, ShouldPowerOn ? E_BLOCK_REDSTONE_TORCH_ON : E_BLOCK_REDSTONE_TORCH_OFF, a_Meta);
+				static_cast<cIncrementalRedstoneSimulator *>(a_World.GetRedstoneSimulator())->SetComponentVariant(a_Position, ShouldPowerOn ? E_BLOCK_REDSTONE_TORCH_ON : E_BLOCK_REDSTONE_TORCH_OFF, a_Meta);
 				Data->m_MechanismDelays.erase(a_Position);
 
 				cVector3iArray RelativePositions = GetRelativeAdjacents();
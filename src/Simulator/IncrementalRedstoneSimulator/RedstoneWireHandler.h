@@ -27,7 +27,20 @@ public:
 		}
 	}
 
-	cVector3iArray GetTerracingConnectionOffsets(cWorld & a_World, Vector3i a_Position) const
+	/** Returns the offsets of the wires connected to the wire at a_Position by terracing.
+	Uses the compiled network, if available. */
+	static cVector3iArray GetTerracingConnectionOffsets(cWorld & a_World, Vector3i a_Position)
+	{
+		cVector3iArray Offsets;
+		if (static_cast<cIncrementalRedstoneSimulator *>(a_World.GetRedstoneSimulator())->GetCompiledTerracingOffsets(a_Position, Offsets))
+		{
+			return Offsets;
+		}
+		return ComputeTerracingConnectionOffsets(a_World, a_Position);
+	}
+
+	/** Returns the offsets of the wires connected to the wire at a_Position by terracing, as read from the world. */
+	static cVector3iArray ComputeTerracingConnectionOffsets(cWorld & a_World, Vector3i a_Position)
 	{
 		cVector3iArray RelativePositions;
 		auto YPTerraceBlock = a_World.GetBlock(a_Position + OffsetYP());
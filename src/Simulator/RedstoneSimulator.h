@@ -37,4 +37,18 @@ public:
 
 	virtual cRedstoneSimulatorChunkData * CreateChunkData() = 0;
 
+	/** Called by the chunk whenever the type of a block changes, including the changes that don't wake up the simulators,
+	such as cChunk::FastSetBlock() and cChunk::WriteBlockArea(). a_Chunk is the chunk containing a_Block. */
+	virtual void BlockTypeChanged(Vector3i a_Block, cChunk & a_Chunk)
+	{
+		UNUSED(a_Block);
+		UNUSED(a_Chunk);
+	}
+
+	/** Called by the chunk when all of its blocks have been replaced, when it is loaded, generated or regenerated. */
+	virtual void ChunkBlocksSet(cChunk & a_Chunk)
+	{
+		UNUSED(a_Chunk);
+	}
+
 };
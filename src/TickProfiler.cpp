@@ -0,0 +1,373 @@
+
+// TickProfiler.cpp
+
+// Implements the cTickProfiler class that measures how long the individual parts of the world tick take
+
+#include "Globals.h"
+#include "TickProfiler.h"
+
+#if defined (__GNUC__)
+	#define ATTRIBUTE_TLS static __thread
+#elif defined (_MSC_VER)
+	#define ATTRIBUTE_TLS static __declspec(thread)
+#else
+	#define ATTRIBUTE_TLS thread_local
+#endif
+
+
+
+
+
+/** The number of items listed in each of the "hot" sections of the report. */
+static const size_t REPORT_NUM_HOT_ITEMS = 10;
+
+/** The name of the subsystem event that wraps a whole world tick; used for counting the ticks in the report. */
+static const char * WORLD_TICK_NAME = "WorldTick";
+
+
+
+
+
+std::atomic<bool> cTickProfiler::s_IsRunning(false);
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cTickProfiler::cScope:
+
+void cTickProfiler::cScope::Begin(eCategory a_Category, const char * a_Name, int a_ArgX, int a_ArgZ)
+{
+	auto & Profiler = cTickProfiler::Get();
+	Profiler.GetThreadBuffer().m_Depth += 1;
+	m_Name = a_Name;
+	m_Category = a_Category;
+	m_ArgX = a_ArgX;
+	m_ArgZ = a_ArgZ;
+	m_Start = Profiler.Now();
+}
+
+
+
+
+
+void cTickProfiler::cScope::End(void)
+{
+	auto & Profiler = cTickProfiler::Get();
+	auto & Buffer = Profiler.GetThreadBuffer();
+	Buffer.m_Depth -= 1;
+
+	sEvent Event;
+	Event.m_Name = m_Name;
+	Event.m_Start = m_Start;
+	Event.m_Duration = Profiler.Now() - m_Start;
+	Event.m_ArgX = m_ArgX;
+	Event.m_ArgZ = m_ArgZ;
+	Event.m_Category = static_cast<UInt8>(m_Category);
+	Event.m_Depth = static_cast<UInt8>(std::min(std::max(Buffer.m_Depth, 0), 255));
+	Buffer.Add(Event);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cTickProfiler::sThreadBuffer:
+
+void cTickProfiler::sThreadBuffer::Add(const sEvent & a_Event)
+{
+	std::lock_guard<std::mutex> Lock(m_CS);
+	if (m_Events.size() < MAX_EVENTS_PER_THREAD)
+	{
+		m_Events.push_back(a_Event);
+	}
+	else
+	{
+		m_Events[m_NumEvents % MAX_EVENTS_PER_THREAD] = a_Event;
+	}
+	m_NumEvents += 1;
+}
+
+
+
+
+
+void cTickProfiler::sThreadBuffer::CopyEvents(std::vector<sEvent> & a_Events)
+{
+	std::lock_guard<std::mutex> Lock(m_CS);
+	if (m_Events.size() < MAX_EVENTS_PER_THREAD)
+	{
+		a_Events.insert(a_Events.end(), m_Events.begin(), m_Events.end());
+		return;
+	}
+
+	// The buffer has wrapped around, the oldest event is the one to be overwritten next:
+	auto Oldest = m_Events.begin() + static_cast<std::ptrdiff_t>(m_NumEvents % MAX_EVENTS_PER_THREAD);
+	a_Events.insert(a_Events.end(), Oldest, m_Events.end());
+	a_Events.insert(a_Events.end(), m_Events.begin(), Oldest);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cTickProfiler:
+
+cTickProfiler::cTickProfiler(void):
+	m_Epoch(std::chrono::steady_clock::now())
+{
+}
+
+
+
+
+
+cTickProfiler & cTickProfiler::Get(void)
+{
+	static cTickProfiler Instance;
+	return Instance;
+}
+
+
+
+
+
+void cTickProfiler::Start(void)
+{
+	s_IsRunning = true;
+}
+
+
+
+
+
+void cTickProfiler::Stop(void)
+{
+	s_IsRunning = false;
+}
+
+
+
+
+
+Int64 cTickProfiler::Now(void) const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Epoch).count();
+}
+
+
+
+
+
+cTickProfiler::sThreadBuffer & cTickProfiler::GetThreadBuffer(void)
+{
+	// The buffers are owned by m_ThreadBuffers, the thread only keeps a pointer, same as GetRandomProvider() does:
+	ATTRIBUTE_TLS sThreadBuffer * LocalPtr = nullptr;
+	if (LocalPtr == nullptr)
+	{
+		cCSLock Lock(m_CS);
+		m_ThreadBuffers.push_back(cpp14::make_unique<sThreadBuffer>(static_cast<int>(m_ThreadBuffers.size())));
+		LocalPtr = m_ThreadBuffers.back().get();
+	}
+	return *LocalPtr;
+}
+
+
+
+
+
+std::vector<std::pair<int, cTickProfiler::sEvent>> cTickProfiler::CollectEvents(void)
+{
+	std::vector<std::pair<int, sEvent>> Res;
+	std::vector<sEvent> Events;
+	cCSLock Lock(m_CS);
+	for (const auto & Buffer : m_ThreadBuffers)
+	{
+		Events.clear();
+		Buffer->CopyEvents(Events);
+		for (const auto & Event : Events)
+		{
+			Res.emplace_back(Buffer->m_ThreadID, Event);
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+AStringVector cTickProfiler::GetReport(int a_WindowSec)
+{
+	struct sStats
+	{
+		Int64 m_Total;
+		Int64 m_Max;
+		int m_Count;
+	};
+	typedef std::map<AString, sStats> cStatsMap;
+
+	// Aggregate the events that ended within the window:
+	Int64 WindowStart = Now() - static_cast<Int64>(a_WindowSec) * 1000000000;
+	cStatsMap Stats[catMax];
+	sStats Ticks = {0, 0, 0};
+	for (const auto & Item : CollectEvents())
+	{
+		const auto & Event = Item.second;
+		if ((Event.m_Start + Event.m_Duration < WindowStart) || (Event.m_Category >= catMax))
+		{
+			continue;
+		}
+		AString Key;
+		if (Event.m_Category == catChunk)
+		{
+			Key = Printf("[%d, %d]", Event.m_ArgX, Event.m_ArgZ);
+		}
+		else
+		{
+			Key = Event.m_Name;
+		}
+		auto itr = Stats[Event.m_Category].find(Key);
+		if (itr == Stats[Event.m_Category].end())
+		{
+			itr = Stats[Event.m_Category].insert(std::make_pair(Key, sStats{0, 0, 0})).first;
+		}
+		itr->second.m_Total += Event.m_Duration;
+		itr->second.m_Max = std::max(itr->second.m_Max, Event.m_Duration);
+		itr->second.m_Count += 1;
+
+		if ((Event.m_Category == catSubsystem) && (strcmp(Event.m_Name, WORLD_TICK_NAME) == 0))
+		{
+			Ticks.m_Total += Event.m_Duration;
+			Ticks.m_Max = std::max(Ticks.m_Max, Event.m_Duration);
+			Ticks.m_Count += 1;
+		}
+	}
+
+	AStringVector Res;
+	Res.push_back(Printf("Tick profile of the last %d seconds%s:", a_WindowSec, IsRunning() ? "" : " (the profiler is stopped)"));
+	if (Ticks.m_Count > 0)
+	{
+		Res.push_back(Printf("  %d world ticks, %.2f msec average, %.2f msec max",
+			Ticks.m_Count, static_cast<double>(Ticks.m_Total) / Ticks.m_Count / 1e6, static_cast<double>(Ticks.m_Max) / 1e6
+		));
+	}
+
+	static const char * SectionNames[catMax] =
+	{
+		"Subsystems",
+		"Hot chunks",
+		"Hot entity types",
+		"Hot block entity types",
+		"Hot plugin hooks",
+	};
+	for (int Category = 0; Category < catMax; Category++)
+	{
+		std::vector<cStatsMap::const_iterator> Sorted;
+		for (auto itr = Stats[Category].cbegin(), end = Stats[Category].cend(); itr != end; ++itr)
+		{
+			Sorted.push_back(itr);
+		}
+		std::sort(Sorted.begin(), Sorted.end(), [](cStatsMap::const_iterator a_First, cStatsMap::const_iterator a_Second)
+			{
+				return (a_First->second.m_Total > a_Second->second.m_Total);
+			}
+		);
+		if ((Category != catSubsystem) && (Sorted.size() > REPORT_NUM_HOT_ITEMS))
+		{
+			Sorted.resize(REPORT_NUM_HOT_ITEMS);
+		}
+
+		Res.push_back(Printf("%s:", SectionNames[Category]));
+		if (Sorted.empty())
+		{
+			Res.push_back("  (none)");
+		}
+		for (const auto & itr : Sorted)
+		{
+			const auto & ItemStats = itr->second;
+			Res.push_back(Printf("  %s: %.2f msec total, %.3f msec average, %.3f msec max, %d calls",
+				itr->first.c_str(),
+				static_cast<double>(ItemStats.m_Total) / 1e6,
+				static_cast<double>(ItemStats.m_Total) / ItemStats.m_Count / 1e6,
+				static_cast<double>(ItemStats.m_Max) / 1e6,
+				ItemStats.m_Count
+			));
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+int cTickProfiler::ExportChromeTrace(const AString & a_FileName)
+{
+	static const char * CategoryNames[catMax] =
+	{
+		"subsystem",
+		"chunk",
+		"entity",
+		"blockentity",
+		"pluginhook",
+	};
+
+	auto Events = CollectEvents();
+	std::sort(Events.begin(), Events.end(), [](const std::pair<int, sEvent> & a_First, const std::pair<int, sEvent> & a_Second)
+		{
+			return (a_First.second.m_Start < a_Second.second.m_Start);
+		}
+	);
+
+	AString Out;
+	Out.reserve(Events.size() * 120 + 32);
+	Out.append("{\"traceEvents\":[\n");
+	bool IsFirst = true;
+	int NumWritten = 0;
+	for (const auto & Item : Events)
+	{
+		const auto & Event = Item.second;
+		if (Event.m_Category >= catMax)
+		{
+			continue;
+		}
+		if (!IsFirst)
+		{
+			Out.append(",\n");
+		}
+		IsFirst = false;
+
+		// The names are class names, hook names and literals, none of them needs escaping:
+		AppendPrintf(Out, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+			Event.m_Name, CategoryNames[Event.m_Category],
+			static_cast<double>(Event.m_Start) / 1000, static_cast<double>(Event.m_Duration) / 1000,
+			Item.first
+		);
+		if (Event.m_Category == catChunk)
+		{
+			AppendPrintf(Out, ",\"args\":{\"x\":%d,\"z\":%d}", Event.m_ArgX, Event.m_ArgZ);
+		}
+		Out.push_back('}');
+		NumWritten += 1;
+	}
+	Out.append("\n]}\n");
+
+	cFile f;
+	if (!f.Open(a_FileName, cFile::fmWrite))
+	{
+		return -1;
+	}
+	if (f.Write(Out.data(), Out.size()) != static_cast<int>(Out.size()))
+	{
+		return -1;
+	}
+	return NumWritten;
+}
+
+
+
+
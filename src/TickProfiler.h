@@ -0,0 +1,187 @@
+
+// TickProfiler.h
+
+// Declares the cTickProfiler class that measures how long the individual parts of the world tick take
+
+/*
+The profiler is off by default and costs a single atomic load per measured scope while off.
+When started, each cTickProfiler::cScope records one event (name, category, start, duration) into a ring buffer
+that belongs to the current thread, so the threads never contend on a shared lock; the per-thread lock is only
+ever taken by the thread itself and, occasionally, by a reader producing a report or an export.
+
+The scopes nest: cWorld::Tick() measures its subsystems, cChunk::Tick() measures itself and the entities and
+block entities it ticks, and the cPluginManager measures every hook call that has plugins registered. The events are kept
+for as long as the ring buffer allows, so a lag spike can be examined (or exported) after it has happened.
+
+The names passed to the scopes must be static strings (string literals, GetClass() results), because only
+the pointer is stored.
+
+Usage:
+	void cSomething::Tick(void)
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "Something");
+		...
+	}
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cTickProfiler
+{
+public:
+
+	enum eCategory
+	{
+		catSubsystem,
+		catChunk,
+		catEntity,
+		catBlockEntity,
+		catPluginHook,
+		catMax,
+	};
+
+
+	/** Measures the time between its construction and destruction and records it as a single event.
+	Does nothing if the profiler is not running when the scope is constructed, or if a_Name is nullptr. */
+	class cScope
+	{
+	public:
+		cScope(eCategory a_Category, const char * a_Name, int a_ArgX = 0, int a_ArgZ = 0):
+			m_Name(nullptr)
+		{
+			if (IsRunning() && (a_Name != nullptr))
+			{
+				Begin(a_Category, a_Name, a_ArgX, a_ArgZ);
+			}
+		}
+
+		~cScope()
+		{
+			if (m_Name != nullptr)
+			{
+				End();
+			}
+		}
+
+	private:
+		const char * m_Name;
+		eCategory m_Category;
+		int m_ArgX;
+		int m_ArgZ;
+		Int64 m_Start;
+
+		void Begin(eCategory a_Category, const char * a_Name, int a_ArgX, int a_ArgZ);
+		void End(void);
+	} ;
+
+
+	/** Returns the single profiler instance. */
+	static cTickProfiler & Get(void);
+
+	/** Returns true if the profiler is recording events. */
+	static bool IsRunning(void) { return s_IsRunning.load(std::memory_order_relaxed); }
+
+	/** Starts recording. The events recorded previously are kept, until overwritten. */
+	void Start(void);
+
+	/** Stops recording. The recorded events are kept for reports and exports. */
+	void Stop(void);
+
+	/** Returns a human-readable report of the events that ended within the last a_WindowSec seconds:
+	the per-subsystem totals and the hottest chunks, entity types, block entity types and plugin hooks.
+	Each line is a separate item in the returned vector. */
+	AStringVector GetReport(int a_WindowSec);
+
+	/** Writes all the recorded events into the specified file in the Chrome trace event format
+	(load it in chrome://tracing or any compatible viewer).
+	Returns the number of events written, or -1 if the file cannot be written. */
+	int ExportChromeTrace(const AString & a_FileName);
+
+protected:
+
+	/** A single recorded scope. */
+	struct sEvent
+	{
+		const char * m_Name;
+		Int64 m_Start;     ///< Start time, in nanoseconds since the profiler was created
+		Int64 m_Duration;  ///< Duration, in nanoseconds
+		int m_ArgX;        ///< Chunk X coord for chunk events, 0 otherwise
+		int m_ArgZ;        ///< Chunk Z coord for chunk events, 0 otherwise
+		UInt8 m_Category;  ///< The eCategory
+		UInt8 m_Depth;     ///< Nesting level of the scope within its thread
+	};
+
+
+	/** The events recorded by a single thread. */
+	struct sThreadBuffer
+	{
+		/** Protects m_Events and m_NumEvents. Normally taken only by the owning thread; readers take it briefly to copy the events. */
+		std::mutex m_CS;
+
+		/** The ring buffer. Grows on demand up to MAX_EVENTS_PER_THREAD items, then the oldest events are overwritten. */
+		std::vector<sEvent> m_Events;
+
+		/** The total number of events ever recorded into this buffer. The newest event is at ((m_NumEvents - 1) % MAX_EVENTS_PER_THREAD). */
+		UInt64 m_NumEvents;
+
+		/** The ID of the thread, used for the exports. */
+		int m_ThreadID;
+
+		/** The current nesting level of the scopes in the owning thread. */
+		int m_Depth;
+
+		sThreadBuffer(int a_ThreadID):
+			m_NumEvents(0),
+			m_ThreadID(a_ThreadID),
+			m_Depth(0)
+		{
+		}
+
+		/** Appends the event, overwriting the oldest one if the buffer is full. */
+		void Add(const sEvent & a_Event);
+
+		/** Appends copies of all the events in the buffer to a_Events, oldest first. */
+		void CopyEvents(std::vector<sEvent> & a_Events);
+	};
+
+
+	/** The maximum number of events kept per thread. At about 30K events per second for a busy world,
+	this covers roughly the last 10 seconds of the world's tick thread. */
+	static const size_t MAX_EVENTS_PER_THREAD = 256 * 1024;
+
+	/** True while recording, checked by every cScope. */
+	static std::atomic<bool> s_IsRunning;
+
+	/** The reference point of all the event timestamps. */
+	std::chrono::steady_clock::time_point m_Epoch;
+
+	/** Protects m_ThreadBuffers. */
+	cCriticalSection m_CS;
+
+	/** The buffers of all threads that have ever recorded an event. Never shrinks, so that the threads' pointers stay valid. */
+	std::vector<std::unique_ptr<sThreadBuffer>> m_ThreadBuffers;
+
+
+	cTickProfiler(void);
+
+	/** Returns the current time, in nanoseconds since m_Epoch. */
+	Int64 Now(void) const;
+
+	/** Returns the buffer of the calling thread, creating it on the first call. */
+	sThreadBuffer & GetThreadBuffer(void);
+
+	/** Returns copies of all the events from all the threads' buffers, together with the ID of the thread they came from. */
+	std::vector<std::pair<int, sEvent>> CollectEvents(void);
+} ;
+
+
+
+
@@ -7,6 +7,7 @@
 #include "Entities/Player.h"
 #include "Server.h"
 #include "Root.h"
+#include "TickProfiler.h"
 
 #include "HTTP/HTTPServerConnection.h"
 #include "HTTP/HTTPFormParser.h"
@@ -55,6 +56,69 @@ public:
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cTickProfilerWebTab
+
+/** The built-in webadmin page that controls the tick profiler and displays its report. */
+class cTickProfilerWebTab :
+	public cWebAdmin::cWebTabCallback
+{
+public:
+	virtual bool Call(
+		const HTTPRequest & a_Request,
+		const AString & a_UrlPath,
+		AString & a_Content,
+		AString & a_ContentType
+	) override
+	{
+		UNUSED(a_UrlPath);
+		UNUSED(a_ContentType);
+		auto & Profiler = cTickProfiler::Get();
+
+		// Process the form buttons:
+		auto Action = a_Request.PostParams.find("Action");
+		if (Action != a_Request.PostParams.end())
+		{
+			if (Action->second == "Start")
+			{
+				Profiler.Start();
+			}
+			else if (Action->second == "Stop")
+			{
+				Profiler.Stop();
+			}
+		}
+		int WindowSec = 10;
+		auto Window = a_Request.Params.find("window");
+		if ((Window != a_Request.Params.end()) && (!StringToInteger(Window->second, WindowSec) || (WindowSec <= 0)))
+		{
+			WindowSec = 10;
+		}
+
+		a_Content.append("<form method=\"POST\">");
+		a_Content.append(cTickProfiler::IsRunning() ?
+			"<p>The profiler is running. <input type=\"submit\" name=\"Action\" value=\"Stop\"/></p>" :
+			"<p>The profiler is stopped. <input type=\"submit\" name=\"Action\" value=\"Start\"/></p>"
+		);
+		a_Content.append("</form>");
+		AppendPrintf(a_Content, "<form method=\"GET\"><p>Window: <input type=\"number\" name=\"window\" min=\"1\" value=\"%d\"/> seconds ", WindowSec);
+		a_Content.append("<input type=\"submit\" value=\"Refresh\"/></p></form>");
+		a_Content.append("<p>Use the \"tickprof export &lt;filename&gt;\" console command to save the recorded events as a Chrome trace.</p>");
+		a_Content.append("<pre>");
+		for (const auto & Line : Profiler.GetReport(WindowSec))
+		{
+			a_Content.append(cWebAdmin::GetHTMLEscapedString(Line));
+			a_Content.push_back('\n');
+		}
+		a_Content.append("</pre>");
+		return true;
+	}
+} ;
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cWebAdmin:
 
@@ -90,6 +154,8 @@ bool cWebAdmin::Init(void)
 
 	Reload();
 
+	AddWebTab("Tick Profiler", "TickProfiler", "Server", std::make_shared<cTickProfilerWebTab>());
+
 	// Read the ports to be used:
 	// Note that historically the ports were stored in the "Port" and "PortsIPv6" values
 	m_Ports = ReadUpgradeIniPorts(m_IniFile, "WebAdmin", "Ports", "Port", "PortsIPv6", DEFAULT_WEBADMIN_PORTS);
@@ -27,6 +27,7 @@
 #include "BlockEntities/BeaconEntity.h"
 
 // Simulators:
+#include "Simulator/DenseFluidSimulator.h"
 #include "Simulator/FloodyFluidSimulator.h"
 #include "Simulator/FluidSimulator.h"
 #include "Simulator/FireSimulator.h"
@@ -53,6 +54,7 @@
 #include "Broadcaster.h"
 #include "SpawnPrepare.h"
 #include "FastRandom.h"
+#include "TickProfiler.h"
 
 
 
@@ -117,6 +119,28 @@ void cWorld::cTickThread::Execute(void)
 
 
 
+/** Returns the table of solid block types for the path finding, cBlockInfo::IsSolid() of each block type. */
+static const bool * GetSolidBlockTypes(void)
+{
+	static const struct sSolidBlockTypes
+	{
+		bool m_IsSolid[256];
+
+		sSolidBlockTypes(void)
+		{
+			for (size_t i = 0; i < ARRAYCOUNT(m_IsSolid); i++)
+			{
+				m_IsSolid[i] = cBlockInfo::IsSolid(static_cast<BLOCKTYPE>(i));
+			}
+		}
+	} SolidBlockTypes;
+	return SolidBlockTypes.m_IsSolid;
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cWorld:
 
@@ -155,6 +179,7 @@ cWorld::cWorld(
 	m_IsDeepSnowEnabled(false),
 	m_ShouldLavaSpawnFire(true),
 	m_VillagersShouldHarvestCrops(true),
+	m_RandomTickSpeed(3),
 	m_SimulatorManager(),
 	m_SandSimulator(),
 	m_WaterSimulator(nullptr),
@@ -197,6 +222,7 @@ cWorld::cWorld(
 	m_GeneratorCallbacks(*this),
 	m_ChunkSender(*this),
 	m_Lighting(*this),
+	m_PathFinderService(GetSolidBlockTypes()),
 	m_TickThread(*this)
 {
 	LOGD("cWorld::cWorld(\"%s\")", a_WorldName.c_str());
@@ -233,6 +259,11 @@ cWorld::cWorld(
 		IniFile.SetValueI("General", "UnusedChunkCap", UnusedDirtyChunksCap);
 	}
 	m_UnusedDirtyChunksCap = static_cast<size_t>(UnusedDirtyChunksCap);
+	m_NumLightingThreads = Clamp(IniFile.GetValueSetI("General", "LightingThreads", 1), 1, 64);
+	m_NumPathFinderThreads = Clamp(IniFile.GetValueSetI("General", "PathFinderThreads", 1), 0, 64);
+	m_NumChunkTickThreads = Clamp(IniFile.GetValueSetI("General", "ChunkTickThreads", 0), 0, 64);
+	int ChunkDataCacheMiB = Clamp(IniFile.GetValueSetI("General", "SerializedChunkCacheMiB", 16), 0, 4096);
+	m_ChunkSender.GetCache().SetMaxSize(static_cast<size_t>(ChunkDataCacheMiB) * 1024 * 1024);
 
 	m_BroadcastDeathMessages = IniFile.GetValueSetB("Broadcasting", "BroadcastDeathMessages", true);
 	m_BroadcastAchievementMessages = IniFile.GetValueSetB("Broadcasting", "BroadcastAchievementMessages", true);
@@ -261,6 +292,14 @@ cWorld::cWorld(
 
 	m_StorageSchema               = IniFile.GetValueSet ("Storage",       "Schema",                      m_StorageSchema);
 	m_StorageCompressionFactor    = IniFile.GetValueSetI("Storage",       "CompressionFactor",           m_StorageCompressionFactor);
+	int StorageMaxSavesPerFlush   = IniFile.GetValueSetI("Storage",       "MaxSavesPerFlush",            64);
+	int StorageMaxFlushDelaySec   = IniFile.GetValueSetI("Storage",       "MaxFlushDelaySec",            2);
+	if (IniFile.GetNumKeyComments("Storage") == 0)
+	{
+		IniFile.AddKeyComment("Storage", " The saved chunks are batched and written to the region files together, after the save queue empties,");
+		IniFile.AddKeyComment("Storage", " after MaxSavesPerFlush chunks, or MaxFlushDelaySec seconds after the first chunk of the batch, whichever comes first.");
+		IniFile.AddKeyComment("Storage", " The chunks of an unwritten batch are lost if the server crashes; lower values narrow that window, at the cost of more writes.");
+	}
 	m_MaxCactusHeight             = IniFile.GetValueSetI("Plants",        "MaxCactusHeight",             3);
 	m_MaxSugarcaneHeight          = IniFile.GetValueSetI("Plants",        "MaxSugarcaneHeight",          3);
 	m_IsBeetrootsBonemealable     = IniFile.GetValueSetB("Plants",        "IsBeetrootsBonemealable",     true);
@@ -279,6 +318,7 @@ cWorld::cWorld(
 	m_IsTallGrassBonemealable     = IniFile.GetValueSetB("Plants",        "IsTallGrassBonemealable",     true);
 	m_IsDeepSnowEnabled           = IniFile.GetValueSetB("Physics",       "DeepSnow",                    true);
 	m_ShouldLavaSpawnFire         = IniFile.GetValueSetB("Physics",       "ShouldLavaSpawnFire",         true);
+	m_RandomTickSpeed             = IniFile.GetValueSetI("Physics",       "RandomTickSpeed",             3);
 	int TNTShrapnelLevel          = IniFile.GetValueSetI("Physics",       "TNTShrapnelLevel",            static_cast<int>(slAll));
 	m_bCommandBlocksEnabled       = IniFile.GetValueSetB("Mechanics",     "CommandBlocksEnabled",        false);
 	m_bEnabledPVP                 = IniFile.GetValueSetB("Mechanics",     "PVPEnabled",                  true);
@@ -406,7 +446,7 @@ cWorld::cWorld(
 	m_SimulatorManager->RegisterSimulator(m_SandSimulator.get(), 1);
 	m_SimulatorManager->RegisterSimulator(m_FireSimulator.get(), 1);
 
-	m_Storage.Initialize(*this, m_StorageSchema, m_StorageCompressionFactor);
+	m_Storage.Initialize(*this, m_StorageSchema, m_StorageCompressionFactor, StorageMaxSavesPerFlush, StorageMaxFlushDelaySec);
 	m_Generator.Initialize(m_GeneratorCallbacks, m_GeneratorCallbacks, IniFile);
 
 	m_MapManager.LoadMapData();
@@ -637,7 +677,9 @@ void cWorld::InitializeSpawn(void)
 
 void cWorld::Start()
 {
-	m_Lighting.Start();
+	m_Lighting.Start(m_NumLightingThreads);
+	m_PathFinderService.Start(m_NumPathFinderThreads);
+	m_ChunkMap->StartTickWorkers(m_NumChunkTickThreads);
 	m_Storage.Start();
 	m_Generator.Start();
 	m_ChunkSender.Start();
@@ -990,7 +1032,9 @@ void cWorld::Stop(cDeadlockDetect & a_DeadlockDetect)
 	IniFile.WriteFile(m_IniFileName);
 
 	m_TickThread.Stop();
+	m_ChunkMap->StopTickWorkers();
 	m_Lighting.Stop();
+	m_PathFinderService.Stop();
 	m_Generator.Stop();
 	m_ChunkSender.Stop();
 	m_Storage.Stop();
@@ -1007,19 +1051,24 @@ void cWorld::Stop(cDeadlockDetect & a_DeadlockDetect)
 
 void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_LastTickDurationMSec)
 {
+	cTickProfiler::cScope ProfilerScope(cTickProfiler::catSubsystem, "WorldTick");
+
 	// Call the plugins
 	cPluginManager::Get()->CallHookWorldTick(*this, a_Dt, a_LastTickDurationMSec);
 
 	// Set any chunk data that has been queued for setting:
-	cSetChunkDataPtrs SetChunkDataQueue;
 	{
-		cCSLock Lock(m_CSSetChunkDataQueue);
-		std::swap(SetChunkDataQueue, m_SetChunkDataQueue);
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "SetChunkData");
+		cSetChunkDataPtrs SetChunkDataQueue;
+		{
+			cCSLock Lock(m_CSSetChunkDataQueue);
+			std::swap(SetChunkDataQueue, m_SetChunkDataQueue);
+		}
+		for (cSetChunkDataPtrs::iterator itr = SetChunkDataQueue.begin(), end = SetChunkDataQueue.end(); itr != end; ++itr)
+		{
+			SetChunkData(**itr);
+		}  // for itr - SetChunkDataQueue[]
 	}
-	for (cSetChunkDataPtrs::iterator itr = SetChunkDataQueue.begin(), end = SetChunkDataQueue.end(); itr != end; ++itr)
-	{
-		SetChunkData(**itr);
-	}  // for itr - SetChunkDataQueue[]
 
 	m_WorldAge += a_Dt;
 
@@ -1046,39 +1095,67 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 	}
 
 	// Add entities waiting in the queue to be added:
-	cEntityList EntitiesToAdd;
 	{
-		// Don't access chunkmap while holding lock
-		cCSLock Lock(m_CSEntitiesToAdd);
-		std::swap(EntitiesToAdd, m_EntitiesToAdd);
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "AddEntities");
+		cEntityList EntitiesToAdd;
+		{
+			// Don't access chunkmap while holding lock
+			cCSLock Lock(m_CSEntitiesToAdd);
+			std::swap(EntitiesToAdd, m_EntitiesToAdd);
+		}
+		for (auto & Entity : EntitiesToAdd)
+		{
+			Entity->SetWorld(this);
+			auto EntityPtr = Entity.get();
+			m_ChunkMap->AddEntity(std::move(Entity));
+			ASSERT(!EntityPtr->IsTicking());
+			EntityPtr->SetIsTicking(true);
+		}
+		EntitiesToAdd.clear();
+
+		// Add players waiting in the queue to be added:
+		AddQueuedPlayers();
 	}
-	for (auto & Entity : EntitiesToAdd)
+
 	{
-		Entity->SetWorld(this);
-		auto EntityPtr = Entity.get();
-		m_ChunkMap->AddEntity(std::move(Entity));
-		ASSERT(!EntityPtr->IsTicking());
-		EntityPtr->SetIsTicking(true);
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "ChunkMap");
+		m_ChunkMap->Tick(a_Dt);
+	}
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "TickMobs");
+		TickMobs(a_Dt);
+	}
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "PathFinder");
+		m_PathFinderService.Tick();
+	}
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "TickMaps");
+		m_MapManager.TickMaps();
+	}
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "TickClients");
+		TickClients(static_cast<float>(a_Dt.count()));
+	}
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "TickQueuedBlocks");
+		TickQueuedBlocks();
+	}
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "TickQueuedTasks");
+		TickQueuedTasks();
+	}
+	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "Simulators");
+		GetSimulatorManager()->Simulate(static_cast<float>(a_Dt.count()));
 	}
-	EntitiesToAdd.clear();
-
-	// Add players waiting in the queue to be added:
-	AddQueuedPlayers();
-
-	m_ChunkMap->Tick(a_Dt);
-	TickMobs(a_Dt);
-	m_MapManager.TickMaps();
-
-	TickClients(static_cast<float>(a_Dt.count()));
-	TickQueuedBlocks();
-	TickQueuedTasks();
-
-	GetSimulatorManager()->Simulate(static_cast<float>(a_Dt.count()));
 
 	TickWeather(static_cast<float>(a_Dt.count()));
 
 	if (m_WorldAge - m_LastChunkCheck > std::chrono::seconds(10))
 	{
+		cTickProfiler::cScope Scope(cTickProfiler::catSubsystem, "UnloadAndSave");
+
 		// Unload every 10 seconds
 		UnloadUnusedChunks();
 
@@ -1193,6 +1270,7 @@ void cWorld::TickMobs(std::chrono::milliseconds a_Dt)
 			// Tick close mobs
 			if (Monster.GetParentChunk()->HasAnyClients())
 			{
+				cTickProfiler::cScope Scope(cTickProfiler::catEntity, Monster.GetClass());
 				Monster.Tick(a_Dt, *(a_Entity.GetParentChunk()));
 			}
 			// Destroy far hostile mobs except if last target was a player
@@ -2600,6 +2678,15 @@ void cWorld::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientHand
 
 
 
+void cWorld::BroadcastEntityMovement(const cEntity & a_Entity, const cClientHandle * a_Exclude)
+{
+	m_ChunkMap->BroadcastEntityMovement(a_Entity, a_Exclude);
+}
+
+
+
+
+
 void cWorld::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
 	m_ChunkMap->BroadcastEntityRelMove(a_Entity, a_RelX, a_RelY, a_RelZ, a_Exclude);
@@ -3785,6 +3872,15 @@ void cWorld::GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLigh
 
 
 
+cChunkData::sMemoryStats cWorld::GetChunkDataMemoryStats(void)
+{
+	return m_ChunkMap->GetChunkDataMemoryStats();
+}
+
+
+
+
+
 void cWorld::TickQueuedBlocks(void)
 {
 	if (m_BlockTickQueue.empty())
@@ -4001,7 +4097,7 @@ cRedstoneSimulator * cWorld::InitializeRedstoneSimulator(cIniFile & a_IniFile)
 
 	if (NoCaseCompare(SimulatorName, "Incremental") == 0)
 	{
-		res = new cIncrementalRedstoneSimulator(*this);
+		res = new cIncrementalRedstoneSimulator(*this, a_IniFile.GetValueSetB("Physics", "CompiledRedstoneNetworks", false));
 	}
 	else if (NoCaseCompare(SimulatorName, "noop") == 0)
 	{
@@ -4010,7 +4106,7 @@ cRedstoneSimulator * cWorld::InitializeRedstoneSimulator(cIniFile & a_IniFile)
 	else
 	{
 		LOGWARNING("[Physics] Unknown RedstoneSimulator \"%s\" in %s, using the default of \"Incremental\".", SimulatorName.c_str(), GetIniFileName().c_str());
-		res = new cIncrementalRedstoneSimulator(*this);
+		res = new cIncrementalRedstoneSimulator(*this, a_IniFile.GetValueSetB("Physics", "CompiledRedstoneNetworks", false));
 	}
 
 	m_SimulatorManager->RegisterSimulator(res, 2 /* Two game ticks is a redstone tick */);
@@ -4071,6 +4167,10 @@ cFluidSimulator * cWorld::InitializeFluidSimulator(cIniFile & a_IniFile, const c
 		{
 			res = new cFloodyFluidSimulator(*this, a_SimulateBlock, a_StationaryBlock, static_cast<NIBBLETYPE>(Falloff), TickDelay, NumNeighborsForSource);
 		}
+		else if (NoCaseCompare(SimulatorName, "dense") == 0)
+		{
+			res = new cDenseFluidSimulator(*this, a_SimulateBlock, a_StationaryBlock, static_cast<NIBBLETYPE>(Falloff), TickDelay, NumNeighborsForSource);
+		}
 		else if (NoCaseCompare(SimulatorName, "vanilla") == 0)
 		{
 			res = new cVanillaFluidSimulator(*this, a_SimulateBlock, a_StationaryBlock, static_cast<NIBBLETYPE>(Falloff), TickDelay, NumNeighborsForSource);
@@ -12,6 +12,7 @@
 #include "ChunkSender.h"
 #include "Defines.h"
 #include "LightingThread.h"
+#include "Mobs/PathFinderService.h"
 #include "IniFile.h"
 #include "Item.h"
 #include "Mobs/Monster.h"
@@ -146,6 +147,9 @@ public:
 
 	bool ShouldLavaSpawnFire(void) const { return m_ShouldLavaSpawnFire; }
 
+	/** Returns the number of random block ticks per chunk section per tick (vanilla's randomTickSpeed) */
+	int GetRandomTickSpeed(void) const { return m_RandomTickSpeed; }
+
 	bool VillagersShouldHarvestCrops(void) const { return m_VillagersShouldHarvestCrops; }
 
 	virtual eDimension GetDimension(void) const override { return m_Dimension; }
@@ -185,6 +189,7 @@ public:
 	void BroadcastEntityHeadLook             (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityLook                 (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityMetadata             (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
+	void BroadcastEntityMovement             (const cEntity & a_Entity, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMove              (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityRelMoveLook          (const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude = nullptr);
 	void BroadcastEntityStatus               (const cEntity & a_Entity, char a_Status, const cClientHandle * a_Exclude = nullptr);
@@ -721,6 +726,9 @@ public:
 	/** Returns the number of chunks loaded and dirty, and in the lighting queue */
 	void GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue);
 
+	/** Returns the memory stats of the block and light data of all loaded chunks: the sections in each storage form and the bytes allocated */
+	cChunkData::sMemoryStats GetChunkDataMemoryStats(void);
+
 	// Various queues length queries (cannot be const, they lock their CS):
 	inline int GetGeneratorQueueLength     (void) { return m_Generator.GetQueueLength();   }    // tolua_export
 	inline size_t GetLightingQueueLength   (void) { return m_Lighting.GetQueueLength();    }    // tolua_export
@@ -729,6 +737,10 @@ public:
 
 	cLightingThread & GetLightingThread(void) { return m_Lighting; }
 
+	cPathFinderService & GetPathFinderService(void) { return m_PathFinderService; }
+
+	cChunkSender & GetChunkSender(void) { return m_ChunkSender; }
+
 	void InitializeSpawn(void);
 
 	/** Starts threads that belong to this world. */
@@ -901,6 +913,16 @@ private:
 	if this was exceeded. */
 	size_t m_UnusedDirtyChunksCap;
 
+	/** The number of threads lighting the chunks in this world, loaded from config. */
+	int m_NumLightingThreads;
+
+	/** The number of threads calculating the mobs' paths in this world, loaded from config. 0 means on the tick thread. */
+	int m_NumPathFinderThreads;
+
+	/** The number of threads preparing the chunks' ticks along with the tick thread in this world, loaded from config.
+	0 means on the tick thread only. */
+	int m_NumChunkTickThreads;
+
 	AString m_WorldName;
 
 	/** The path to the root directory for the world files. Does not including trailing path specifier. */
@@ -957,6 +979,9 @@ private:
 	bool m_ShouldLavaSpawnFire;
 	bool m_VillagersShouldHarvestCrops;
 
+	/** The number of random block ticks per chunk section per tick; only the sections with random-tickable blocks are ticked. */
+	int m_RandomTickSpeed;
+
 	std::vector<BlockTickQueueItem *> m_BlockTickQueue;
 	std::vector<BlockTickQueueItem *> m_BlockTickQueueCopy;  // Second is for safely removing the objects from the queue
 
@@ -1035,6 +1060,7 @@ private:
 
 	cChunkSender     m_ChunkSender;
 	cLightingThread  m_Lighting;
+	cPathFinderService m_PathFinderService;
 	cTickThread      m_TickThread;
 
 	/** Guards the m_Tasks */
@@ -242,6 +242,19 @@ bool cWSSAnvil::GetChunkData(const cChunkCoords & a_Chunk, AString & a_Data)
 
 
 
+void cWSSAnvil::Flush(void)
+{
+	cCSLock Lock(m_CS);
+	for (auto File : m_Files)
+	{
+		File->Flush();
+	}
+}
+
+
+
+
+
 bool cWSSAnvil::SetChunkData(const cChunkCoords & a_Chunk, const AString & a_Data)
 {
 	cCSLock Lock(m_CS);
@@ -524,17 +537,18 @@ bool cWSSAnvil::SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_
 			continue;
 		}
 
+		BLOCKTYPE BlockTypes[cChunkData::SectionBlockCount];
 		a_Writer.BeginCompound("");
-		a_Writer.AddByteArray("Blocks", reinterpret_cast<const char *>(Section->m_BlockTypes), ARRAYCOUNT(Section->m_BlockTypes));
+		a_Writer.AddByteArray("Blocks", reinterpret_cast<const char *>(Section->GetBlockTypes(BlockTypes)), cChunkData::SectionBlockCount);
 		a_Writer.AddByteArray("Data",   reinterpret_cast<const char *>(Section->m_BlockMetas), ARRAYCOUNT(Section->m_BlockMetas));
 
 		#ifdef DEBUG_SKYLIGHT
-			a_Writer.AddByteArray("BlockLight", reinterpret_cast<const char *>(Section->m_BlockSkyLight), ARRAYCOUNT(Section->m_BlockSkyLight));
+			a_Writer.AddByteArray("BlockLight", reinterpret_cast<const char *>(Section->GetSkyLight()), cChunkData::SectionNibbleCount);
 		#else
-			a_Writer.AddByteArray("BlockLight", reinterpret_cast<const char *>(Section->m_BlockLight),    ARRAYCOUNT(Section->m_BlockLight));
+			a_Writer.AddByteArray("BlockLight", reinterpret_cast<const char *>(Section->GetBlockLight()), cChunkData::SectionNibbleCount);
 		#endif
 
-		a_Writer.AddByteArray("SkyLight", reinterpret_cast<const char *>(Section->m_BlockSkyLight), ARRAYCOUNT(Section->m_BlockSkyLight));
+		a_Writer.AddByteArray("SkyLight", reinterpret_cast<const char *>(Section->GetSkyLight()), cChunkData::SectionNibbleCount);
 		a_Writer.AddByte("Y", static_cast<unsigned char>(Y));
 		a_Writer.EndCompound();
 	}
@@ -3382,7 +3396,8 @@ cWSSAnvil::cMCAFile::cMCAFile(cWSSAnvil & a_ParentSchema, const AString & a_File
 	m_ParentSchema(a_ParentSchema),
 	m_RegionX(a_RegionX),
 	m_RegionZ(a_RegionZ),
-	m_FileName(a_FileName)
+	m_FileName(a_FileName),
+	m_IsHeaderDirty(false)
 {
 }
 
@@ -3390,6 +3405,15 @@ cWSSAnvil::cMCAFile::cMCAFile(cWSSAnvil & a_ParentSchema, const AString & a_File
 
 
 
+cWSSAnvil::cMCAFile::~cMCAFile()
+{
+	Flush();
+}
+
+
+
+
+
 bool cWSSAnvil::cMCAFile::OpenFile(bool a_IsForReading)
 {
 	bool writeOutNeeded = false;
@@ -3477,6 +3501,18 @@ bool cWSSAnvil::cMCAFile::GetChunkData(const cChunkCoords & a_Chunk, AString & a
 		return false;
 	}
 
+	// A chunk saved in the current batch hasn't been written to the file yet:
+	auto Pending = m_PendingWrites.find(ChunkOffset);
+	if (Pending != m_PendingWrites.end())
+	{
+		UInt32 PendingSize;
+		memcpy(&PendingSize, Pending->second.data(), 4);
+		PendingSize = NetToHost(PendingSize);
+		ASSERT((PendingSize >= 1) && (PendingSize + 4 <= Pending->second.size()));
+		a_Data.assign(Pending->second, MCA_CHUNK_HEADER_LENGTH, PendingSize - 1);
+		return true;
+	}
+
 	m_File.Seek(static_cast<int>(ChunkOffset * 4096));
 
 	UInt32 ChunkSize = 0;
@@ -3540,69 +3576,96 @@ bool cWSSAnvil::cMCAFile::SetChunkData(const cChunkCoords & a_Chunk, const AStri
 		LocalZ = 32 + LocalZ;
 	}
 
-	unsigned ChunkSector = FindFreeLocation(LocalX, LocalZ, a_Data);
-
-	// Store the chunk data:
-	m_File.Seek(static_cast<int>(ChunkSector * 4096));
-	UInt32 ChunkSize = HostToNet(static_cast<UInt32>(a_Data.size() + 1));
-	if (m_File.Write(&ChunkSize, 4) != 4)
+	// Check the size before touching the file:
+	UInt32 NumSectors = (static_cast<UInt32>(a_Data.size()) + MCA_CHUNK_HEADER_LENGTH + 4095) / 4096;  // Round data size up to nearest 4KB sector, make it a sector number
+	if (NumSectors > 255)
 	{
-		LOGWARNING("Cannot save chunk [%d, %d], writing(1) data to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
-		return false;
-	}
-	char CompressionType = 2;
-	if (m_File.Write(&CompressionType, 1) != 1)
-	{
-		LOGWARNING("Cannot save chunk [%d, %d], writing(2) data to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
-		return false;
-	}
-	if (m_File.Write(a_Data.data(), a_Data.size()) != static_cast<int>(a_Data.size()))
-	{
-		LOGWARNING("Cannot save chunk [%d, %d], writing(3) data to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
+		LOGWARNING("Cannot save chunk [%d, %d], the data is too large (%u KiB, maximum is 1024 KiB). Remove some entities and retry.",
+			a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, static_cast<unsigned>(NumSectors * 4)
+		);
 		return false;
 	}
 
-	// Add padding to 4K boundary:
-	size_t BytesWritten = a_Data.size() + MCA_CHUNK_HEADER_LENGTH;
-	if (BytesWritten % 4096 != 0)
+	unsigned OldChunkSector = NetToHost(m_Header[LocalX + 32 * LocalZ]) >> 8;
+	unsigned ChunkSector = FindFreeLocation(LocalX, LocalZ, a_Data);
+	if (ChunkSector != OldChunkSector)
 	{
-		static const char Padding[4095] = {0};
-		m_File.Write(Padding, 4096 - (BytesWritten % 4096));
+		// The chunk has moved, any data still pending for its old location is garbage:
+		m_PendingWrites.erase(OldChunkSector);
 	}
 
-	// Store the header:
-	ChunkSize = (static_cast<UInt32>(a_Data.size()) + MCA_CHUNK_HEADER_LENGTH + 4095) / 4096;  // Round data size up to nearest 4KB sector, make it a sector number
-	if (ChunkSize > 255)
-	{
-		LOGWARNING("Cannot save chunk [%d, %d], the data is too large (%u KiB, maximum is 1024 KiB). Remove some entities and retry.",
-			a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, static_cast<unsigned>(ChunkSize * 4)
-		);
-		return false;
-	}
+	// Assemble the chunk header, data and padding to the 4K boundary; the sectors are written in Flush(), together with the adjacent ones:
+	AString & Sectors = m_PendingWrites[ChunkSector];
+	Sectors.clear();
+	Sectors.reserve(NumSectors * 4096);
+	UInt32 ChunkSize = HostToNet(static_cast<UInt32>(a_Data.size() + 1));
+	Sectors.append(reinterpret_cast<const char *>(&ChunkSize), 4);
+	Sectors.push_back(2);  // Compression type: zlib
+	Sectors.append(a_Data);
+	Sectors.resize(NumSectors * 4096, 0);
 
 	// Store the header info in the table
-	m_Header[LocalX + 32 * LocalZ] = HostToNet(static_cast<UInt32>((ChunkSector << 8) | ChunkSize));
+	m_Header[LocalX + 32 * LocalZ] = HostToNet(static_cast<UInt32>((ChunkSector << 8) | NumSectors));
 
 	// Set the modification time
 	m_TimeStamps[LocalX + 32 * LocalZ] =  HostToNet(static_cast<UInt32>(time(nullptr)));
 
-	if (m_File.Seek(0) < 0)
+	// The header is written in Flush(), once for the whole batch of chunks saved into this file, after their data:
+	m_IsHeaderDirty = true;
+	return true;
+}
+
+
+
+
+
+bool cWSSAnvil::cMCAFile::Flush(void)
+{
+	if (!m_IsHeaderDirty)
 	{
-		LOGWARNING("Cannot save chunk [%d, %d], seeking in file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
-		return false;
+		ASSERT(m_PendingWrites.empty());
+		return true;
 	}
-	if (m_File.Write(m_Header, sizeof(m_Header)) != sizeof(m_Header))
+	ASSERT(m_File.IsOpen());
+
+	// Write the chunk data, in runs of adjacent sectors, one write per run. The sectors are sorted by the map:
+	bool IsSuccess = true;
+	auto itr = m_PendingWrites.begin();
+	while (itr != m_PendingWrites.end())
 	{
-		LOGWARNING("Cannot save chunk [%d, %d], writing header to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
-		return false;
+		unsigned RunStart = itr->first;
+		AString Run;
+		std::swap(Run, itr->second);
+		for (++itr; (itr != m_PendingWrites.end()) && (itr->first == RunStart + Run.size() / 4096); ++itr)
+		{
+			Run.append(itr->second);
+		}
+		if (
+			(m_File.Seek(static_cast<int>(RunStart * 4096)) < 0) ||
+			(m_File.Write(Run.data(), Run.size()) != static_cast<int>(Run.size()))
+		)
+		{
+			LOGWARNING("Cannot write chunk data to file \"%s\", %u sectors starting at sector %u will be corrupt",
+				GetFileName().c_str(), static_cast<unsigned>(Run.size() / 4096), RunStart
+			);
+			IsSuccess = false;
+		}
 	}
-	if (m_File.Write(m_TimeStamps, sizeof(m_TimeStamps)) != sizeof(m_TimeStamps))
+	m_PendingWrites.clear();
+
+	// Only update the header once the data is in the file:
+	if (
+		(m_File.Seek(0) < 0) ||
+		(m_File.Write(m_Header, sizeof(m_Header)) != sizeof(m_Header)) ||
+		(m_File.Write(m_TimeStamps, sizeof(m_TimeStamps)) != sizeof(m_TimeStamps))
+	)
 	{
-		LOGWARNING("Cannot save chunk [%d, %d], writing timestamps to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
+		LOGWARNING("Cannot write the header to file \"%s\", recently saved chunks may be lost", GetFileName().c_str());
 		return false;
 	}
-
-	return true;
+	m_File.Flush();
+	m_IsHeaderDirty = false;
+	return IsSuccess;
 }
 
 
@@ -60,10 +60,17 @@ protected:
 
 		cMCAFile(cWSSAnvil & a_ParentSchema, const AString & a_FileName, int a_RegionX, int a_RegionZ);
 
+		/** Writes out the pending chunk data and the header, if modified. */
+		~cMCAFile();
+
 		bool GetChunkData  (const cChunkCoords & a_Chunk, AString & a_Data);
 		bool SetChunkData  (const cChunkCoords & a_Chunk, const AString & a_Data);
 		bool EraseChunkData(const cChunkCoords & a_Chunk);
 
+		/** Writes the pending chunk data into the file, coalescing the writes to adjacent sectors, and then the header
+		and timestamps, if they have changed since the last flush. Returns true on success. */
+		bool Flush(void);
+
 		int             GetRegionX (void) const {return m_RegionX; }
 		int             GetRegionZ (void) const {return m_RegionZ; }
 		const AString & GetFileName(void) const {return m_FileName; }
@@ -84,6 +91,13 @@ protected:
 		// Chunk timestamps, following the chunk headers
 		unsigned m_TimeStamps[MCA_MAX_CHUNKS];
 
+		/** Set when m_Header or m_TimeStamps have been modified by SetChunkData() and not yet written by Flush(). */
+		bool m_IsHeaderDirty;
+
+		/** The chunks saved by SetChunkData() and not yet written by Flush(), as the contents of whole sectors,
+		indexed by the first sector. m_Header already points to them, GetChunkData() reads them from here. */
+		std::map<unsigned, AString> m_PendingWrites;
+
 		/** Finds a free location large enough to hold a_Data. Gets a hint of the chunk coords, places the data there if it fits. Returns the sector number. */
 		unsigned FindFreeLocation(int a_LocalX, int a_LocalZ, const AString & a_Data);
 
@@ -264,6 +278,7 @@ protected:
 	// cWSSchema overrides:
 	virtual bool LoadChunk(const cChunkCoords & a_Chunk) override;
 	virtual bool SaveChunk(const cChunkCoords & a_Chunk) override;
+	virtual void Flush(void) override;
 	virtual const AString GetName(void) const override {return "anvil"; }
 } ;
 
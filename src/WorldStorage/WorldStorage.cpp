@@ -16,6 +16,15 @@
 
 
 
+
+/** The number of chunks loaded in a row, while more loads are queued, before a queued save gets its turn.
+Loads have priority, players are waiting for them, but the saves mustn't starve while players keep exploring. */
+static const int LOADS_PER_SAVE = 8;
+
+
+
+
+
 /** Example storage schema - forgets all chunks */
 class cWSSForgetful :
 	public cWSSchema
@@ -40,7 +49,9 @@ protected:
 cWorldStorage::cWorldStorage(void) :
 	super("cWorldStorage"),
 	m_World(nullptr),
-	m_SaveSchema(nullptr)
+	m_SaveSchema(nullptr),
+	m_MaxSavesPerFlush(64),
+	m_MaxFlushDelay(2)
 {
 }
 
@@ -60,10 +71,12 @@ cWorldStorage::~cWorldStorage()
 
 
 
-void cWorldStorage::Initialize(cWorld & a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor)
+void cWorldStorage::Initialize(cWorld & a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor, int a_MaxSavesPerFlush, int a_MaxFlushDelaySec)
 {
 	m_World = &a_World;
 	m_StorageSchemaName = a_StorageSchemaName;
+	m_MaxSavesPerFlush = std::max(a_MaxSavesPerFlush, 1);
+	m_MaxFlushDelay = std::chrono::seconds(std::max(a_MaxFlushDelaySec, 0));
 	InitSchemas(a_StorageCompressionFactor);
 }
 
@@ -206,17 +219,61 @@ void cWorldStorage::Execute(void)
 	{
 		m_Event.Wait();
 		// Process both queues until they are empty again:
-		bool Success;
-		do
+		int NumLoadsSinceSave = 0;
+		int NumUnflushedSaves = 0;
+		auto FirstUnflushedSave = std::chrono::steady_clock::now();
+		for (;;)
 		{
 			if (m_ShouldTerminate)
 			{
-				return;
+				break;
+			}
+
+			// Loads have priority, but after each LOADS_PER_SAVE loads, a save is let through:
+			bool IsSaveTurn = (NumLoadsSinceSave >= LOADS_PER_SAVE);
+			if (!IsSaveTurn && LoadOneChunk())
+			{
+				NumLoadsSinceSave += 1;
+				continue;
+			}
+			NumLoadsSinceSave = 0;
+			if (SaveOneChunk())
+			{
+				if (NumUnflushedSaves == 0)
+				{
+					FirstUnflushedSave = std::chrono::steady_clock::now();
+				}
+				NumUnflushedSaves += 1;
+				if (
+					(NumUnflushedSaves >= m_MaxSavesPerFlush) ||
+					(std::chrono::steady_clock::now() - FirstUnflushedSave >= m_MaxFlushDelay)
+				)
+				{
+					m_SaveSchema->Flush();
+					NumUnflushedSaves = 0;
+				}
+				continue;
+			}
+
+			// The save queue has run dry, write out the batch even if the loads go on:
+			if (NumUnflushedSaves > 0)
+			{
+				m_SaveSchema->Flush();
+				NumUnflushedSaves = 0;
+			}
+			if (!IsSaveTurn)
+			{
+				// Both queues are empty
+				break;
 			}
+			// There was nothing to save on the save's turn, continue with the loads
+		}
 
-			Success = LoadOneChunk();
-			Success |= SaveOneChunk();
-		} while (Success);
+		// Write out what the schema has batched from the saves:
+		if (NumUnflushedSaves > 0)
+		{
+			m_SaveSchema->Flush();
+		}
 	}
 }
 
@@ -242,7 +299,7 @@ bool cWorldStorage::LoadOneChunk(void)
 	{
 		ToLoad.m_Callback->Call(ToLoad.m_ChunkX, ToLoad.m_ChunkZ, res);
 	}
-	return res;
+	return true;
 }
 
 
@@ -37,6 +37,13 @@ public:
 
 	virtual bool LoadChunk(const cChunkCoords & a_Chunk) = 0;
 	virtual bool SaveChunk(const cChunkCoords & a_Chunk) = 0;
+
+	/** Writes out anything the schema has buffered from the previous SaveChunk() calls.
+	Called whenever the save queue becomes empty, and while it doesn't, after the number of saves or the time
+	configured in the world.ini [Storage] section (MaxSavesPerFlush, MaxFlushDelaySec).
+	The chunks saved since the last flush may be lost if the server crashes before it. */
+	virtual void Flush(void) {}
+
 	virtual const AString GetName(void) const = 0;
 
 protected:
@@ -69,8 +76,9 @@ public:
 	The callback, if specified, will be called with the result of the save operation. */
 	void QueueSaveChunk(int a_ChunkX, int a_ChunkZ, cChunkCoordCallback * a_Callback = nullptr);
 
-	/** Initializes the storage schemas, ready to be started. */
-	void Initialize(cWorld & a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor);
+	/** Initializes the storage schemas, ready to be started.
+	The saved chunks are flushed after at most a_MaxSavesPerFlush saves, or a_MaxFlushDelaySec seconds after the first unflushed save. */
+	void Initialize(cWorld & a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor, int a_MaxSavesPerFlush, int a_MaxFlushDelaySec);
 	void Stop(void);  // Hide the cIsThread's Stop() method, we need to signal the event
 	void WaitForFinish(void);
 	void WaitForLoadQueueEmpty(void);
@@ -96,6 +104,14 @@ protected:
 	/** Set when there's any addition to the queues */
 	cEvent m_Event;
 
+	/** The maximum number of chunks saved before the schema is told to flush, even if more saves are queued.
+	Caps the number of chunks a crash may lose during a long save storm, see cWSSchema::Flush(). */
+	int m_MaxSavesPerFlush;
+
+	/** The maximum time from the first unflushed save to the flush, even if more saves are queued.
+	Caps the time span of the chunks a crash may lose while the saves trickle in between the loads. */
+	std::chrono::seconds m_MaxFlushDelay;
+
 
 	/** Loads the chunk specified; returns true on success, false on failure */
 	bool LoadChunk(int a_ChunkX, int a_ChunkZ);
@@ -104,10 +120,10 @@ protected:
 
 	virtual void Execute(void) override;
 
-	/** Loads one chunk from the queue (if any queued); returns true if there are more chunks in the load queue */
+	/** Loads one chunk from the queue (if any queued); returns true if a chunk was dequeued */
 	bool LoadOneChunk(void);
 
-	/** Saves one chunk from the queue (if any queued); returns true if there are more chunks in the save queue */
+	/** Saves one chunk from the queue (if any queued); returns true if a chunk was dequeued */
 	bool SaveOneChunk(void);
 } ;
 
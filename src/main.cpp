@@ -37,6 +37,7 @@
 #include "Logger.h"
 
 #include "MemorySettingsRepository.h"
+#include "IniFile.h"
 
 
 
@@ -44,6 +45,7 @@
 // Forward declarations to satisfy Clang's -Wmissing-variable-declarations:
 extern bool g_ShouldLogCommIn;
 extern bool g_ShouldLogCommOut;
+extern bool g_ShouldCapturePackets;
 
 
 
@@ -58,6 +60,9 @@ bool g_ShouldLogCommIn;
 /** If set to true, the protocols will log each player's outgoing (S->C) communication to a per-connection logfile */
 bool g_ShouldLogCommOut;
 
+/** If set to true, the protocols will capture each player's game state traffic into a binary file for replaying, see cPacketCapture */
+bool g_ShouldCapturePackets;
+
 /** If set to true, binary will attempt to run as a service on Windows */
 bool cRoot::m_RunAsService = false;
 
@@ -223,6 +228,28 @@ static BOOL CtrlHandler(DWORD fdwCtrlType)
 
 
 
+/** Returns the number of network event loops configured in the settings file, 0 for the default.
+The network needs to be initialised before cRoot reads the settings, so the value is read from the file here;
+cRoot stores the default value into the file, so that the admins can find the setting. */
+static size_t GetNumNetworkEventLoops(cSettingsRepositoryInterface & a_OverridesRepo)
+{
+	AString SettingsFilename = "settings.ini";
+	if (a_OverridesRepo.HasValue("Server", "ConfigFile"))
+	{
+		SettingsFilename = a_OverridesRepo.GetValue("Server", "ConfigFile");
+	}
+	cIniFile IniFile;
+	if (!IniFile.ReadFile(SettingsFilename))
+	{
+		return 0;
+	}
+	return static_cast<size_t>(Clamp(IniFile.GetValueI("Server", "NetworkEventLoops", 0), 0, 64));
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // UniversalMain - Main startup logic for both standard running and as a service
 
@@ -232,7 +259,7 @@ static void UniversalMain(std::unique_ptr<cSettingsRepositoryInterface> a_Overri
 	cLogger::InitiateMultithreading();
 
 	// Initialize LibEvent:
-	cNetworkSingleton::Get().Initialise();
+	cNetworkSingleton::Get().Initialise(GetNumNetworkEventLoops(*a_OverridesRepo));
 
 	try
 	{
@@ -383,6 +410,7 @@ static std::unique_ptr<cMemorySettingsRepository> ParseArguments(int argc, char
 		TCLAP::SwitchArg commLogArg      ("",  "log-comm",            "Log server client communications to file", cmd);
 		TCLAP::SwitchArg commLogInArg    ("",  "log-comm-in",         "Log inbound server client communications to file", cmd);
 		TCLAP::SwitchArg commLogOutArg   ("",  "log-comm-out",        "Log outbound server client communications to file", cmd);
+		TCLAP::SwitchArg captureArg      ("",  "capture-packets",     "Capture the game traffic of each client to a binary file, for replaying in benchmarks", cmd);
 		TCLAP::SwitchArg crashDumpFull   ("",  "crash-dump-full",     "Crashdumps created by the server will contain full server memory", cmd);
 		TCLAP::SwitchArg crashDumpGlobals("",  "crash-dump-globals",  "Crashdumps created by the server will contain the global variables' values", cmd);
 		TCLAP::SwitchArg noBufArg        ("",  "no-output-buffering", "Disable output buffering", cmd);
@@ -423,6 +451,7 @@ static std::unique_ptr<cMemorySettingsRepository> ParseArguments(int argc, char
 			g_ShouldLogCommIn = commLogInArg.getValue();
 			g_ShouldLogCommOut = commLogOutArg.getValue();
 		}
+		g_ShouldCapturePackets = captureArg.getValue();
 		if (noBufArg.getValue())
 		{
 			setvbuf(stdout, nullptr, _IONBF, 0);
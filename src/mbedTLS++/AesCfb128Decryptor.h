@@ -10,6 +10,7 @@
 #pragma once
 
 #include "mbedtls/aes.h"
+#include "AesNiCfb8.h"
 
 
 
@@ -40,6 +41,12 @@ protected:
 
 	/** Indicates whether the object has been initialized with the Key / IV */
 	bool m_IsValid;
+
+	/** The AES-NI implementation, used instead of m_Aes when the CPU supports it */
+	cAesNiCfb8 m_AesNi;
+
+	/** Indicates whether m_AesNi is used; decided in Init() */
+	bool m_UseAesNi;
 } ;
 
 
@@ -11,7 +11,8 @@
 
 
 cAesCfb128Encryptor::cAesCfb128Encryptor(void):
-	m_IsValid(false)
+	m_IsValid(false),
+	m_UseAesNi(false)
 {
 	mbedtls_aes_init(&m_Aes);
 }
@@ -36,6 +37,11 @@ void cAesCfb128Encryptor::Init(const Byte a_Key[16], const Byte a_IV[16])
 
 	memcpy(m_IV, a_IV, 16);
 	mbedtls_aes_setkey_enc(&m_Aes, a_Key, 128);
+	m_UseAesNi = cAesNiCfb8::IsSupported();
+	if (m_UseAesNi)
+	{
+		m_AesNi.Init(a_Key);
+	}
 	m_IsValid = true;
 }
 
@@ -46,6 +52,11 @@ void cAesCfb128Encryptor::Init(const Byte a_Key[16], const Byte a_IV[16])
 void cAesCfb128Encryptor::ProcessData(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length)
 {
 	ASSERT(IsValid());  // Must Init() first
+	if (m_UseAesNi)
+	{
+		m_AesNi.Encrypt(m_IV, a_EncryptedOut, a_PlainIn, a_Length);
+		return;
+	}
 	mbedtls_aes_crypt_cfb8(&m_Aes, MBEDTLS_AES_ENCRYPT, a_Length, m_IV, a_PlainIn, a_EncryptedOut);
 }
 
@@ -0,0 +1,291 @@
+
+// AesNiCfb8.cpp
+
+// Implements the cAesNiCfb8 class implementing AES-128 / CFB8 using the AES-NI instructions
+
+#include "Globals.h"
+#include "AesNiCfb8.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define AESNI_AVAILABLE 1
+	#include <wmmintrin.h>
+	#include <emmintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		// MSVC allows the intrinsics in any function
+		#define AESNI_TARGET
+	#else
+		#include <cpuid.h>
+		// GCC and Clang only allow the intrinsics in functions compiled for the instruction set:
+		#define AESNI_TARGET __attribute__((target("aes,sse2")))
+	#endif
+#else
+	#define AESNI_AVAILABLE 0
+#endif
+
+
+
+
+
+#if AESNI_AVAILABLE
+
+/** Number of blocks that are processed interleaved when decrypting. */
+static const size_t DECRYPT_INTERLEAVE = 8;
+
+
+
+
+
+/** Computes the next round key from the previous one and the output of aeskeygenassist. */
+AESNI_TARGET static inline __m128i ExpandKeyStep(__m128i a_Key, __m128i a_KeyGenAssist)
+{
+	a_KeyGenAssist = _mm_shuffle_epi32(a_KeyGenAssist, 0xff);
+	a_Key = _mm_xor_si128(a_Key, _mm_slli_si128(a_Key, 4));
+	a_Key = _mm_xor_si128(a_Key, _mm_slli_si128(a_Key, 4));
+	a_Key = _mm_xor_si128(a_Key, _mm_slli_si128(a_Key, 4));
+	return _mm_xor_si128(a_Key, a_KeyGenAssist);
+}
+
+
+
+
+
+/** Encrypts a single block using the expanded key. */
+AESNI_TARGET static inline __m128i EncryptBlock(const __m128i * a_RoundKeys, __m128i a_Block)
+{
+	a_Block = _mm_xor_si128(a_Block, _mm_load_si128(a_RoundKeys));
+	for (int i = 1; i < 10; i++)
+	{
+		a_Block = _mm_aesenc_si128(a_Block, _mm_load_si128(a_RoundKeys + i));
+	}
+	return _mm_aesenclast_si128(a_Block, _mm_load_si128(a_RoundKeys + 10));
+}
+
+
+
+
+
+/** Shifts the CFB register by one byte and appends a_Byte at its end. */
+AESNI_TARGET static inline __m128i ShiftIn(__m128i a_Register, Byte a_Byte)
+{
+	return _mm_or_si128(_mm_srli_si128(a_Register, 1), _mm_slli_si128(_mm_cvtsi32_si128(a_Byte), 15));
+}
+
+#endif  // AESNI_AVAILABLE
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cAesNiCfb8:
+
+cAesNiCfb8::cAesNiCfb8(void)
+{
+	memset(m_RoundKeys, 0, sizeof(m_RoundKeys));
+}
+
+
+
+
+
+cAesNiCfb8::~cAesNiCfb8()
+{
+	// Clear the leftover in-memory data, so that they can't be accessed by a backdoor
+	volatile Byte * RoundKeys = m_RoundKeys;
+	for (size_t i = 0; i < sizeof(m_RoundKeys); i++)
+	{
+		RoundKeys[i] = 0;
+	}
+}
+
+
+
+
+
+bool cAesNiCfb8::IsSupported(void)
+{
+	#if AESNI_AVAILABLE
+		static const bool IsAesNiSupported = []()
+		{
+			#ifdef _MSC_VER
+				int Regs[4];
+				__cpuid(Regs, 1);
+				return ((Regs[2] & (1 << 25)) != 0);
+			#else
+				unsigned int Eax, Ebx, Ecx, Edx;
+				if (__get_cpuid(1, &Eax, &Ebx, &Ecx, &Edx) == 0)
+				{
+					return false;
+				}
+				return ((Ecx & bit_AES) != 0);
+			#endif
+		}();
+		return IsAesNiSupported;
+	#else
+		return false;
+	#endif
+}
+
+
+
+
+
+#if AESNI_AVAILABLE
+
+AESNI_TARGET void cAesNiCfb8::Init(const Byte a_Key[16])
+{
+	ASSERT(IsSupported());
+
+	__m128i * RoundKeys = reinterpret_cast<__m128i *>(m_RoundKeys);
+	__m128i Key = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_Key));
+	_mm_store_si128(RoundKeys, Key);
+
+	// The round constants must be immediate values, so the steps can't be a loop:
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x01)); _mm_store_si128(RoundKeys + 1, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x02)); _mm_store_si128(RoundKeys + 2, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x04)); _mm_store_si128(RoundKeys + 3, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x08)); _mm_store_si128(RoundKeys + 4, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x10)); _mm_store_si128(RoundKeys + 5, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x20)); _mm_store_si128(RoundKeys + 6, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x40)); _mm_store_si128(RoundKeys + 7, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x80)); _mm_store_si128(RoundKeys + 8, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x1b)); _mm_store_si128(RoundKeys + 9, Key);
+	Key = ExpandKeyStep(Key, _mm_aeskeygenassist_si128(Key, 0x36)); _mm_store_si128(RoundKeys + 10, Key);
+}
+
+
+
+
+
+AESNI_TARGET void cAesNiCfb8::Encrypt(Byte a_IV[16], Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length) const
+{
+	const __m128i * RoundKeys = reinterpret_cast<const __m128i *>(m_RoundKeys);
+	__m128i Register = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_IV));
+	for (size_t i = 0; i < a_Length; i++)
+	{
+		__m128i KeyStream = EncryptBlock(RoundKeys, Register);
+		Byte Encrypted = static_cast<Byte>(a_PlainIn[i] ^ static_cast<Byte>(_mm_cvtsi128_si32(KeyStream)));
+		a_EncryptedOut[i] = Encrypted;
+		Register = ShiftIn(Register, Encrypted);
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(a_IV), Register);
+}
+
+
+
+
+
+AESNI_TARGET void cAesNiCfb8::Decrypt(Byte a_IV[16], Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length) const
+{
+	const __m128i * RoundKeys = reinterpret_cast<const __m128i *>(m_RoundKeys);
+	__m128i Register = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_IV));
+
+	// The block input for each byte past the first 16 is the 16 ciphertext bytes preceding it, so those blocks
+	// can be read straight from the input and run interleaved. That doesn't work when decrypting in place,
+	// the preceding ciphertext would already be overwritten; such calls decrypt serially.
+	bool IsInPlace = (
+		(a_DecryptedOut < a_EncryptedIn + a_Length) &&
+		(a_EncryptedIn < a_DecryptedOut + a_Length)
+	);
+	size_t NumSerial = IsInPlace ? a_Length : std::min<size_t>(a_Length, 16);
+	for (size_t i = 0; i < NumSerial; i++)
+	{
+		__m128i KeyStream = EncryptBlock(RoundKeys, Register);
+		Byte Encrypted = a_EncryptedIn[i];
+		a_DecryptedOut[i] = static_cast<Byte>(Encrypted ^ static_cast<Byte>(_mm_cvtsi128_si32(KeyStream)));
+		Register = ShiftIn(Register, Encrypted);
+	}
+	if (NumSerial == a_Length)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(a_IV), Register);
+		return;
+	}
+
+	size_t Pos = NumSerial;
+	for (; Pos + DECRYPT_INTERLEAVE <= a_Length; Pos += DECRYPT_INTERLEAVE)
+	{
+		// The blocks are kept in separate variables, so that they stay in registers even without loop unrolling:
+		const Byte * In = a_EncryptedIn + Pos - 16;
+		__m128i FirstRoundKey = _mm_load_si128(RoundKeys);
+		__m128i B0 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(In + 0)), FirstRoundKey);
+		__m128i B1 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(In + 1)), FirstRoundKey);
+		__m128i B2 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(In + 2)), FirstRoundKey);
+		__m128i B3 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(In + 3)), FirstRoundKey);
+		__m128i B4 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(In + 4)), FirstRoundKey);
+		__m128i B5 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(In + 5)), FirstRoundKey);
+		__m128i B6 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(In + 6)), FirstRoundKey);
+		__m128i B7 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(In + 7)), FirstRoundKey);
+		for (int r = 1; r < 10; r++)
+		{
+			__m128i RoundKey = _mm_load_si128(RoundKeys + r);
+			B0 = _mm_aesenc_si128(B0, RoundKey);
+			B1 = _mm_aesenc_si128(B1, RoundKey);
+			B2 = _mm_aesenc_si128(B2, RoundKey);
+			B3 = _mm_aesenc_si128(B3, RoundKey);
+			B4 = _mm_aesenc_si128(B4, RoundKey);
+			B5 = _mm_aesenc_si128(B5, RoundKey);
+			B6 = _mm_aesenc_si128(B6, RoundKey);
+			B7 = _mm_aesenc_si128(B7, RoundKey);
+		}
+		__m128i LastRoundKey = _mm_load_si128(RoundKeys + 10);
+		const Byte * Encrypted = a_EncryptedIn + Pos;
+		Byte * Decrypted = a_DecryptedOut + Pos;
+		Decrypted[0] = static_cast<Byte>(Encrypted[0] ^ static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(B0, LastRoundKey))));
+		Decrypted[1] = static_cast<Byte>(Encrypted[1] ^ static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(B1, LastRoundKey))));
+		Decrypted[2] = static_cast<Byte>(Encrypted[2] ^ static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(B2, LastRoundKey))));
+		Decrypted[3] = static_cast<Byte>(Encrypted[3] ^ static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(B3, LastRoundKey))));
+		Decrypted[4] = static_cast<Byte>(Encrypted[4] ^ static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(B4, LastRoundKey))));
+		Decrypted[5] = static_cast<Byte>(Encrypted[5] ^ static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(B5, LastRoundKey))));
+		Decrypted[6] = static_cast<Byte>(Encrypted[6] ^ static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(B6, LastRoundKey))));
+		Decrypted[7] = static_cast<Byte>(Encrypted[7] ^ static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(B7, LastRoundKey))));
+	}
+	for (; Pos < a_Length; Pos++)
+	{
+		__m128i KeyStream = EncryptBlock(RoundKeys, _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_EncryptedIn + Pos - 16)));
+		a_DecryptedOut[Pos] = static_cast<Byte>(a_EncryptedIn[Pos] ^ static_cast<Byte>(_mm_cvtsi128_si32(KeyStream)));
+	}
+
+	// The new IV is the last 16 bytes of the ciphertext:
+	memcpy(a_IV, a_EncryptedIn + a_Length - 16, 16);
+}
+
+#else  // AESNI_AVAILABLE
+
+void cAesNiCfb8::Init(const Byte a_Key[16])
+{
+	UNUSED(a_Key);
+	ASSERT(!"AES-NI is not available on this platform");
+}
+
+
+
+
+
+void cAesNiCfb8::Encrypt(Byte a_IV[16], Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length) const
+{
+	UNUSED(a_IV);
+	UNUSED(a_EncryptedOut);
+	UNUSED(a_PlainIn);
+	UNUSED(a_Length);
+	ASSERT(!"AES-NI is not available on this platform");
+}
+
+
+
+
+
+void cAesNiCfb8::Decrypt(Byte a_IV[16], Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length) const
+{
+	UNUSED(a_IV);
+	UNUSED(a_DecryptedOut);
+	UNUSED(a_EncryptedIn);
+	UNUSED(a_Length);
+	ASSERT(!"AES-NI is not available on this platform");
+}
+
+#endif  // else AESNI_AVAILABLE
+
+
+
+
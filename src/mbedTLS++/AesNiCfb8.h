@@ -0,0 +1,56 @@
+
+// AesNiCfb8.h
+
+// Declares the cAesNiCfb8 class implementing AES-128 / CFB8 using the AES-NI instructions
+
+/*
+The CFB8 mode needs a full AES block operation for each byte of data. The mbedTLS implementation does that using
+table lookups, which makes the encryption one of the most expensive parts of sending chunks to clients.
+This class does the block operations using the AES-NI instructions instead. Encryption is inherently serial
+(each block depends on the previous ciphertext byte), so it only benefits from the faster block operation.
+Decryption knows all the block inputs up front (they are the ciphertext itself), so it runs several blocks
+interleaved to hide the instruction latency.
+
+The results are byte-exact with mbedtls_aes_crypt_cfb8(). The class is only usable if IsSupported() returns true,
+cAesCfb128Encryptor and cAesCfb128Decryptor check that at runtime and fall back to mbedTLS otherwise.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cAesNiCfb8
+{
+public:
+
+	cAesNiCfb8(void);
+	~cAesNiCfb8();
+
+	/** Returns true if the CPU supports the AES-NI instructions (and the build targets x86 / x64).
+	The result is detected once, using CPUID. */
+	static bool IsSupported(void);
+
+	/** Expands the 128-bit key into the round keys. Only call when IsSupported() returns true. */
+	void Init(const Byte a_Key[16]);
+
+	/** Encrypts a_Length bytes, updating the IV (the CFB shift register) in a_IV. */
+	void Encrypt(Byte a_IV[16], Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length) const;
+
+	/** Decrypts a_Length bytes, updating the IV (the CFB shift register) in a_IV. */
+	void Decrypt(Byte a_IV[16], Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length) const;
+
+protected:
+
+	/** The expanded encryption key, 11 round keys of 16 bytes each. Aligned for the 128-bit loads. */
+	alignas(16) Byte m_RoundKeys[11 * 16];
+} ;
+
+
+
+
@@ -0,0 +1,161 @@
+
+// AesCfb8Test.cpp
+
+// Implements the main app entrypoint for the AES / CFB8 test
+// Cross-checks the AES-NI implementation and the encryptor / decryptor classes against mbedTLS on random streams
+
+#include "Globals.h"
+#include "mbedTLS++/AesCfb128Decryptor.h"
+#include "mbedTLS++/AesCfb128Encryptor.h"
+#include "mbedTLS++/AesNiCfb8.h"
+
+
+
+
+
+/** Number of random streams to check. */
+static const int NUM_STREAMS = 50;
+
+/** The maximum length of a single random stream. */
+static const size_t MAX_STREAM_LENGTH = 20000;
+
+
+
+
+
+/** Fills the buffer with random bytes. */
+static void FillRandom(std::mt19937 & a_Random, Byte * a_Buffer, size_t a_Length)
+{
+	std::uniform_int_distribution<int> Dist(0, 255);
+	for (size_t i = 0; i < a_Length; i++)
+	{
+		a_Buffer[i] = static_cast<Byte>(Dist(a_Random));
+	}
+}
+
+
+
+
+
+/** Processes the data in randomly sized pieces, the same as the data arriving from the network.
+a_ProcessFn is called with the output pointer, input pointer and the size of each piece. */
+template <typename ProcessFn>
+static void ProcessInPieces(std::mt19937 & a_Random, std::vector<Byte> & a_Out, const std::vector<Byte> & a_In, ProcessFn a_ProcessFn)
+{
+	a_Out.resize(a_In.size());
+	std::uniform_int_distribution<size_t> Dist(0, 100);
+	size_t Pos = 0;
+	while (Pos < a_In.size())
+	{
+		// Mostly short pieces, sometimes a long one, to exercise both the serial and the interleaved paths:
+		size_t Size = Dist(a_Random);
+		if (Size > 90)
+		{
+			Size *= 40;
+		}
+		Size = std::min(Size, a_In.size() - Pos);
+		a_ProcessFn(a_Out.data() + Pos, a_In.data() + Pos, Size);
+		Pos += Size;
+	}
+}
+
+
+
+
+
+static void TestStreams(void)
+{
+	bool HasAesNi = cAesNiCfb8::IsSupported();
+	LOG("AES-NI is %s", HasAesNi ? "supported, cross-checking it against mbedTLS" : "not supported, checking the mbedTLS path only");
+
+	std::mt19937 Random(1234);
+	std::uniform_int_distribution<size_t> LengthDist(0, MAX_STREAM_LENGTH);
+	for (int s = 0; s < NUM_STREAMS; s++)
+	{
+		Byte Key[16], IV[16];
+		FillRandom(Random, Key, sizeof(Key));
+		FillRandom(Random, IV, sizeof(IV));
+		std::vector<Byte> Plain(LengthDist(Random));
+		FillRandom(Random, Plain.data(), Plain.size());
+
+		// The reference encryption, done by mbedTLS in one go:
+		std::vector<Byte> Reference(Plain.size());
+		{
+			mbedtls_aes_context Aes;
+			mbedtls_aes_init(&Aes);
+			mbedtls_aes_setkey_enc(&Aes, Key, 128);
+			Byte RefIV[16];
+			memcpy(RefIV, IV, sizeof(RefIV));
+			mbedtls_aes_crypt_cfb8(&Aes, MBEDTLS_AES_ENCRYPT, Plain.size(), RefIV, Plain.data(), Reference.data());
+			mbedtls_aes_free(&Aes);
+		}
+
+		// The encryptor and decryptor classes (using AES-NI, if available):
+		{
+			cAesCfb128Encryptor Encryptor;
+			Encryptor.Init(Key, IV);
+			std::vector<Byte> Encrypted;
+			ProcessInPieces(Random, Encrypted, Plain, [&](Byte * a_Out, const Byte * a_In, size_t a_Size)
+				{
+					Encryptor.ProcessData(a_Out, a_In, a_Size);
+				}
+			);
+			assert_test(Encrypted == Reference);
+
+			cAesCfb128Decryptor Decryptor;
+			Decryptor.Init(Key, IV);
+			std::vector<Byte> Decrypted;
+			ProcessInPieces(Random, Decrypted, Reference, [&](Byte * a_Out, const Byte * a_In, size_t a_Size)
+				{
+					Decryptor.ProcessData(a_Out, a_In, a_Size);
+				}
+			);
+			assert_test(Decrypted == Plain);
+		}
+
+		if (!HasAesNi)
+		{
+			continue;
+		}
+
+		// The AES-NI implementation directly, including decrypting in place:
+		cAesNiCfb8 AesNi;
+		AesNi.Init(Key);
+		Byte EncIV[16], DecIV[16];
+		memcpy(EncIV, IV, sizeof(EncIV));
+		memcpy(DecIV, IV, sizeof(DecIV));
+		std::vector<Byte> Encrypted;
+		ProcessInPieces(Random, Encrypted, Plain, [&](Byte * a_Out, const Byte * a_In, size_t a_Size)
+			{
+				AesNi.Encrypt(EncIV, a_Out, a_In, a_Size);
+			}
+		);
+		assert_test(Encrypted == Reference);
+		std::vector<Byte> InPlace(Reference);
+		ProcessInPieces(Random, InPlace, InPlace, [&](Byte * a_Out, const Byte * a_In, size_t a_Size)
+			{
+				AesNi.Decrypt(DecIV, a_Out, a_In, a_Size);
+			}
+		);
+		assert_test(InPlace == Plain);
+	}
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	LOGD("Testing random streams");
+	TestStreams();
+
+	LOG("AesCfb8 test finished.");
+	return 0;
+}
+
+
+
+
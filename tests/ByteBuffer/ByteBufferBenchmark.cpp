@@ -0,0 +1,254 @@
+
+// ByteBufferBenchmark.cpp
+
+// Implements a benchmark of the cByteBuffer reading and writing used by the protocols
+// Reports the time per VarInt, both in a linear buffer and in a ringbuffer that keeps wrapping around its end,
+// and the time per packet when the packet is copied into a new buffer (as the tick thread used to do)
+// versus when it is written once into a reused buffer and handled in place (as the packet decoder does now),
+// read either through the buffer's checked reads or through a cByteView (as the movement packet handlers do)
+
+#include "Globals.h"
+#include "ByteBuffer.h"
+#include "ByteView.h"
+
+
+
+
+
+/** The number of VarInts written and read in each VarInt benchmark. */
+static const size_t NUM_VARINTS = 1000000;
+
+/** The number of packets handled in each packet benchmark. */
+static const size_t NUM_PACKETS = 200000;
+
+/** The VarInt values used, with sizes from one to five bytes. */
+static const UInt32 g_VarIntValues[] = { 5, 300, 70000, 20000000, 0xffffffff, 0, 127, 128 };
+
+/** The number of values in g_VarIntValues. */
+static const size_t NUM_VALUES = ARRAYCOUNT(g_VarIntValues);
+
+
+
+
+
+/** Returns the time elapsed since a_Start, in nanoseconds per a_Count operations. */
+static double NsPer(std::chrono::steady_clock::time_point a_Start, size_t a_Count)
+{
+	auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(std::chrono::steady_clock::now() - a_Start);
+	return Elapsed.count() / static_cast<double>(a_Count);
+}
+
+
+
+
+
+/** Writes and reads NUM_VARINTS VarInts in a single buffer large enough for all of them. */
+static void BenchmarkLinearVarInts(void)
+{
+	cByteBuffer Buffer(NUM_VARINTS * 5);
+	auto Start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < NUM_VARINTS; i++)
+	{
+		Buffer.WriteVarInt32(g_VarIntValues[i % NUM_VALUES]);
+	}
+	double WriteNs = NsPer(Start, NUM_VARINTS);
+
+	Start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < NUM_VARINTS; i++)
+	{
+		UInt32 Value = 0;
+		assert_test(Buffer.ReadVarInt32(Value));
+		assert_test(Value == g_VarIntValues[i % NUM_VALUES]);
+	}
+	double ReadNs = NsPer(Start, NUM_VARINTS);
+
+	Buffer.ResetRead();
+	Start = std::chrono::steady_clock::now();
+	cByteView View = Buffer.GetReadView();
+	for (size_t i = 0; i < NUM_VARINTS; i++)
+	{
+		UInt32 Value = 0;
+		assert_test(View.ReadVarInt32(Value));
+		assert_test(Value == g_VarIntValues[i % NUM_VALUES]);
+	}
+	double ViewNs = NsPer(Start, NUM_VARINTS);
+	LOG("Linear buffer: %.1f ns per VarInt written, %.1f ns per VarInt read, %.1f ns per VarInt read through a view", WriteNs, ReadNs, ViewNs);
+}
+
+
+
+
+
+/** Writes and reads NUM_VARINTS VarInts in batches through a small ringbuffer, the way a protocol's m_ReceivedData is used. */
+static void BenchmarkRingVarInts(void)
+{
+	// The buffer size isn't a multiple of the batch size, so that the VarInts keep being split across the buffer end:
+	const size_t BatchSize = 500;
+	cByteBuffer Buffer(4 KiB - 3);
+	auto Start = std::chrono::steady_clock::now();
+	for (size_t Batch = 0; Batch < NUM_VARINTS; Batch += BatchSize)
+	{
+		for (size_t i = Batch; i < Batch + BatchSize; i++)
+		{
+			assert_test(Buffer.WriteVarInt32(g_VarIntValues[i % NUM_VALUES]));
+		}
+		for (size_t i = Batch; i < Batch + BatchSize; i++)
+		{
+			UInt32 Value = 0;
+			assert_test(Buffer.ReadVarInt32(Value));
+			assert_test(Value == g_VarIntValues[i % NUM_VALUES]);
+		}
+		Buffer.CommitRead();
+	}
+	LOG("Ringbuffer: %.1f ns per VarInt written and read", NsPer(Start, NUM_VARINTS));
+}
+
+
+
+
+
+/** Creates the payload of a Player Position And Look packet: the position, the rotation and the on-ground flag. */
+static AString CreatePositionLookPayload(void)
+{
+	cByteBuffer Payload(64);
+	Payload.WriteBEDouble(100.5);
+	Payload.WriteBEDouble(64);
+	Payload.WriteBEDouble(-200.25);
+	Payload.WriteBEFloat(90);
+	Payload.WriteBEFloat(-15);
+	Payload.WriteBool(true);
+	AString Res;
+	Payload.ReadAll(Res);
+	return Res;
+}
+
+
+
+
+
+/** Reads the packet the way the packet handler does and checks the values. */
+static void ReadPositionLook(cByteBuffer & a_Packet)
+{
+	double PosX = 0, PosY = 0, PosZ = 0;
+	float Yaw = 0, Pitch = 0;
+	bool IsOnGround = false;
+	assert_test(a_Packet.ReadBEDouble(PosX));
+	assert_test(a_Packet.ReadBEDouble(PosY));
+	assert_test(a_Packet.ReadBEDouble(PosZ));
+	assert_test(a_Packet.ReadBEFloat(Yaw));
+	assert_test(a_Packet.ReadBEFloat(Pitch));
+	assert_test(a_Packet.ReadBool(IsOnGround));
+	assert_test((PosX == 100.5) && (PosY == 64) && (PosZ == -200.25) && (Yaw == 90) && (Pitch == -15) && IsOnGround);
+	assert_test(a_Packet.GetReadableSpace() == 1);
+}
+
+
+
+
+
+/** Reads the packet through a view, the way the movement packet handlers do, and checks the values. */
+static void ReadPositionLookView(cByteBuffer & a_Packet)
+{
+	cByteView View = a_Packet.GetReadView();
+	double PosX = 0, PosY = 0, PosZ = 0;
+	float Yaw = 0, Pitch = 0;
+	bool IsOnGround = false;
+	assert_test(View.ReadBEDouble(PosX));
+	assert_test(View.ReadBEDouble(PosY));
+	assert_test(View.ReadBEDouble(PosZ));
+	assert_test(View.ReadBEFloat(Yaw));
+	assert_test(View.ReadBEFloat(Pitch));
+	assert_test(View.ReadBool(IsOnGround));
+	assert_test(a_Packet.SkipRead(View.GetReadSize()));
+	assert_test((PosX == 100.5) && (PosY == 64) && (PosZ == -200.25) && (Yaw == 90) && (Pitch == -15) && IsOnGround);
+	assert_test(a_Packet.GetReadableSpace() == 1);
+}
+
+
+
+
+
+/** Handles NUM_PACKETS packets, each read from the received data into a string and copied into a new buffer before handling. */
+static void BenchmarkCopiedPackets(const AString & a_Payload)
+{
+	// The received data, as the packet decoder finds it in the protocol's m_ReceivedData:
+	cByteBuffer Received(a_Payload.size() + 6);
+	auto Start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < NUM_PACKETS; i++)
+	{
+		Received.WriteVarInt32(0x06);
+		Received.Write(a_Payload.data(), a_Payload.size());
+		UInt32 ReceivedType = 0;
+		AString Data;
+		assert_test(Received.ReadVarInt32(ReceivedType));
+		assert_test(Received.ReadString(Data, Received.GetReadableSpace()));
+		Received.CommitRead();
+
+		cByteBuffer Packet(Data.size() + 6);
+		Packet.WriteVarInt32(ReceivedType);
+		Packet.Write(Data.data(), Data.size());
+		Packet.Write("\0", 1);
+		UInt32 PacketType = 0;
+		assert_test(Packet.ReadVarInt32(PacketType) && (PacketType == 0x06));
+		ReadPositionLook(Packet);
+	}
+	LOG("Packets copied into a new buffer: %.1f ns per packet", NsPer(Start, NUM_PACKETS));
+}
+
+
+
+
+
+/** Handles NUM_PACKETS packets, each written once from the received data into a reused buffer and handled in place,
+read through the buffer itself or, if a_UseView is true, through a view. */
+static void BenchmarkPooledPackets(const AString & a_Payload, bool a_UseView)
+{
+	// The received data, as the packet decoder finds it in the protocol's m_ReceivedData:
+	cByteBuffer Received(a_Payload.size() + 6);
+	cByteBuffer Packet(1 KiB);
+	auto Start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < NUM_PACKETS; i++)
+	{
+		Received.WriteVarInt32(0x06);
+		Received.Write(a_Payload.data(), a_Payload.size());
+		Packet.Clear();
+		assert_test(Received.ReadToByteBuffer(Packet, Received.GetReadableSpace()));
+		Received.CommitRead();
+		UInt32 PacketType = 0;
+		assert_test(Packet.ReadVarInt32(PacketType) && (PacketType == 0x06));
+		Packet.Write("\0", 1);
+		if (a_UseView)
+		{
+			ReadPositionLookView(Packet);
+		}
+		else
+		{
+			ReadPositionLook(Packet);
+		}
+	}
+	LOG("Packets handled in place in a pooled buffer%s: %.1f ns per packet", a_UseView ? ", read through a view" : "", NsPer(Start, NUM_PACKETS));
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Benchmark started");
+
+	BenchmarkLinearVarInts();
+	BenchmarkRingVarInts();
+
+	AString Payload = CreatePositionLookPayload();
+	BenchmarkCopiedPackets(Payload);
+	BenchmarkPooledPackets(Payload, false);
+	BenchmarkPooledPackets(Payload, true);
+
+	LOG("ByteBuffer benchmark finished");
+	return 0;
+}
+
+
+
+
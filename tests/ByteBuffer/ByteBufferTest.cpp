@@ -5,6 +5,7 @@
 
 #include "Globals.h"
 #include "ByteBuffer.h"
+#include "ByteView.h"
 
 
 
@@ -66,6 +67,119 @@ static void TestWrap(void)
 
 
 
+static void TestVarIntWrap(void)
+{
+	// Move the data start close to the buffer end, so that the VarInts get split across it:
+	cByteBuffer buf(10);
+	for (size_t Offset = 0; Offset < 10; Offset++)
+	{
+		buf.Clear();
+		assert_test(buf.Write("0123456789", Offset));
+		assert_test(buf.SkipRead(Offset));
+		buf.CommitRead();
+		assert_test(buf.WriteVarInt32(300));
+		assert_test(buf.WriteVarInt64(0x123456789aULL));
+		UInt32 v1;
+		assert_test(buf.ReadVarInt32(v1) && (v1 == 300));
+		UInt64 v2;
+		assert_test(buf.ReadVarInt64(v2) && (v2 == 0x123456789aULL));
+		assert_test(buf.GetReadableSpace() == 0);
+
+		// An incomplete VarInt must fail and leave the read position untouched:
+		buf.CommitRead();
+		assert_test(buf.Write("\xac", 1));
+		assert_test(!buf.ReadVarInt32(v1));
+		assert_test(buf.GetReadableSpace() == 1);
+	}
+}
+
+
+
+
+
+static void TestReadToByteBuffer(void)
+{
+	cByteBuffer src(10);
+	assert_test(src.Write("abcdefgh", 8));
+	assert_test(src.SkipRead(6));
+	src.CommitRead();
+	assert_test(src.Write("ijklmn", 6));  // Wraps around the buffer end
+	assert_test(src.SkipRead(2));
+	cByteBuffer dst(10);
+	assert_test(!src.ReadToByteBuffer(dst, 7));
+	assert_test(src.ReadToByteBuffer(dst, 6));
+	AString All;
+	dst.ReadAll(All);
+	assert_test(All == "ijklmn");
+}
+
+
+
+
+
+static void TestView(void)
+{
+	// A packet laid out the way the packet decoder writes it: the type, the payload, the extra NUL:
+	cByteBuffer buf(64);
+	assert_test(buf.WriteVarInt32(0x06));
+	assert_test(buf.WriteBEDouble(-200.25));
+	assert_test(buf.WriteBEFloat(90));
+	assert_test(buf.WriteBEInt16(-2));
+	assert_test(buf.WriteBool(true));
+	assert_test(buf.WriteVarInt64(0x123456789aULL));
+	assert_test(buf.WritePosition64(-10, 64, 30000000));
+	assert_test(buf.WriteVarUTF8String("abc"));
+	assert_test(buf.Write("\0", 1));
+	UInt32 PacketType;
+	assert_test(buf.ReadVarInt32(PacketType) && (PacketType == 0x06));
+
+	// The view reads the same values as the buffer, without moving the buffer's read position:
+	cByteView View = buf.GetReadView();
+	assert_test(View.GetReadableSpace() == buf.GetReadableSpace());
+	double d;
+	assert_test(View.ReadBEDouble(d) && (d == -200.25));
+	float f;
+	assert_test(View.ReadBEFloat(f) && (f == 90));
+	Int16 i16;
+	assert_test(View.ReadBEInt16(i16) && (i16 == -2));
+	bool b;
+	assert_test(View.ReadBool(b) && b);
+	UInt64 v64;
+	assert_test(View.ReadVarInt64(v64) && (v64 == 0x123456789aULL));
+	int x, y, z;
+	assert_test(View.ReadPosition64(x, y, z) && (x == -10) && (y == 64) && (z == 30000000));
+	const char * String;
+	size_t Size;
+	assert_test(View.ReadVarUTF8String(String, Size) && (Size == 3) && (memcmp(String, "abc", 3) == 0));
+	assert_test(View.GetReadableSpace() == 1);
+	assert_test(buf.GetReadableSpace() == View.GetReadSize() + 1);
+	assert_test(buf.SkipRead(View.GetReadSize()));
+	assert_test(buf.GetReadableSpace() == 1);
+
+	// Reads past the end fail and don't move the read position:
+	UInt8 NUL;
+	assert_test(View.ReadBEUInt8(NUL) && (NUL == 0));
+	assert_test(!View.ReadBEInt32(x));
+	assert_test(!View.ReadBool(b));
+	assert_test(View.GetReadableSpace() == 0);
+
+	// An incomplete VarInt and a string longer than the data fail, leaving the read position untouched:
+	cByteView Incomplete("\x05" "ab", 3);
+	assert_test(!Incomplete.ReadVarUTF8String(String, Size));
+	assert_test(Incomplete.GetReadableSpace() == 3);
+	cByteView Truncated("\xac", 1);
+	assert_test(!Truncated.ReadVarInt64(v64));
+	assert_test(Truncated.GetReadableSpace() == 1);
+
+	// A VarInt longer than 10 bytes is malformed:
+	cByteView TooLong("\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01", 11);
+	assert_test(!TooLong.ReadVarInt64(v64));
+}
+
+
+
+
+
 int main(int argc, char * argv[])
 {
 	LOGD("Test started");
@@ -79,6 +193,15 @@ int main(int argc, char * argv[])
 	LOGD("Testing wraps");
 	TestWrap();
 
+	LOGD("Testing VarInts across the buffer end");
+	TestVarIntWrap();
+
+	LOGD("Testing copying between buffers");
+	TestReadToByteBuffer();
+
+	LOGD("Testing views of the buffers");
+	TestView();
+
 	LOG("ByteBuffer test finished.");
 }
 
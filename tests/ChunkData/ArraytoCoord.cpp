@@ -1,6 +1,7 @@
 
 #include "Globals.h"
 #include "ChunkData.h"
+#include "MockPools.h"
 
 
 
@@ -8,23 +9,11 @@ int main(int argc, char** argv)
 {
 	LOGD("Test started");
 
-	class cMockAllocationPool
-		: public cAllocationPool<cChunkData::sChunkSection>
- 	{
-		virtual cChunkData::sChunkSection * Allocate()
-		{
-			return new cChunkData::sChunkSection();
-		}
-		
-		virtual void Free(cChunkData::sChunkSection * a_Ptr)
-		{
-			delete a_Ptr;
-		}
-	} Pool;
+	cMockChunkDataPools Pools;
 	{
 	
 		// Test first segment
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 
 		BLOCKTYPE SrcBlockBuffer[16 * 16 * 256];
 		memset(SrcBlockBuffer, 0x00, sizeof(SrcBlockBuffer));
@@ -51,7 +40,7 @@ int main(int argc, char** argv)
 	
 	{
 		// test following segment
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 
 		BLOCKTYPE SrcBlockBuffer[16 * 16 * 256];
 		memset(SrcBlockBuffer, 0x00, sizeof(SrcBlockBuffer));
@@ -78,7 +67,7 @@ int main(int argc, char** argv)
 	
 	{
 		// test zeros
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 
 		BLOCKTYPE SrcBlockBuffer[16 * 16 * 256];
 		memset(SrcBlockBuffer, 0x00, sizeof(SrcBlockBuffer));
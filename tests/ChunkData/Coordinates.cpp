@@ -1,6 +1,7 @@
 
 #include "Globals.h"
 #include "ChunkData.h"
+#include "MockPools.h"
 
 
 
@@ -8,21 +9,9 @@ int main(int argc, char** argv)
 {
 	LOGD("Test started");
 
-	class cMockAllocationPool
-		: public cAllocationPool<cChunkData::sChunkSection>
+	cMockChunkDataPools Pools;
 	{
-		virtual cChunkData::sChunkSection * Allocate()
-		{
-			return new cChunkData::sChunkSection();
-		}
-
-		virtual void Free(cChunkData::sChunkSection * a_Ptr)
-		{
-			delete a_Ptr;
-		}
-	} Pool;
-	{
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 
 		// Empty chunks
 		buffer.SetBlock(0, 0, 0, 0xAB);
@@ -95,7 +84,7 @@ int main(int argc, char** argv)
 	}
 
 	{
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 
 		// Zero's
 		buffer.SetBlock(0, 0, 0, 0x0);
@@ -109,12 +98,43 @@ int main(int argc, char** argv)
 		testassert(buffer.GetMeta(0, 16, 1) == 0xc);
 	}
 
+	{
+		// Single-block light
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
+
+		// Setting the default values of missing sections doesn't allocate them
+		testassert(!buffer.SetBlockLight(0, 0, 0, 0x0));
+		testassert(!buffer.SetSkyLight(0, 0, 0, 0xf));
+		testassert(buffer.GetSectionBitmask() == 0);
+
+		// Non-default values allocate the section, the rest of it keeps the uniform value
+		testassert(buffer.SetBlockLight(1, 0, 0, 0xe));
+		testassert(buffer.SetSkyLight(0, 16, 1, 0x3));
+		testassert(buffer.GetBlockLight(1, 0, 0) == 0xe);
+		testassert(buffer.GetBlockLight(0, 0, 0) == 0x0);
+		testassert(buffer.GetSkyLight(0, 16, 1) == 0x3);
+		testassert(buffer.GetSkyLight(0, 16, 0) == 0xf);
+		testassert(buffer.GetSkyLight(1, 0, 0) == 0xf);
+
+		// Setting the same value again reports no change
+		testassert(!buffer.SetBlockLight(1, 0, 0, 0xe));
+		testassert(buffer.SetBlockLight(1, 0, 0, 0x0));
+		testassert(buffer.GetBlockLight(1, 0, 0) == 0x0);
+
+		CheckAsserts(
+			buffer.SetBlockLight(0, 256, 0, 0);
+		);
+		CheckAsserts(
+			buffer.SetSkyLight(0, -1, 0, 0);
+		);
+	}
+
 
 	{
 		// Operator =
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 		buffer.SetBlock(0, 0, 0, 0x42);
-		cChunkData copy(Pool);
+		cChunkData copy(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 		copy = std::move(buffer);
 		testassert(copy.GetBlock(0, 0, 0) == 0x42);
 	}
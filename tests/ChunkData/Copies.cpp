@@ -1,6 +1,7 @@
 
 #include "Globals.h"
 #include "ChunkData.h"
+#include "MockPools.h"
 
 
 
@@ -8,29 +9,31 @@ int main(int argc, char** argv)
 {
 	LOGD("Test started");
 
-	class cMockAllocationPool
-		: public cAllocationPool<cChunkData::sChunkSection>
- 	{
-		virtual cChunkData::sChunkSection * Allocate()
-		{
-			return new cChunkData::sChunkSection();
-		}
-		
-		virtual void Free(cChunkData::sChunkSection * a_Ptr)
-		{
-			delete a_Ptr;
-		}
-	} Pool;
+	cMockChunkDataPools Pools;
 	{
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 	
 		buffer.SetBlock(3, 1, 4, 0xDE);
 		buffer.SetMeta(3, 1, 4, 0xA);
 	
-		cChunkData copy(Pool);
+		cChunkData copy(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 		copy.Assign(buffer);
 		testassert(copy.GetBlock(3, 1, 4) == 0xDE);
 		testassert(copy.GetMeta(3, 1, 4) == 0xA);
+
+		// A copy gets its own generations, so that the original and the copy, modified separately, don't collide
+		testassert(copy.GetGeneration() != buffer.GetGeneration());
+		UInt64 BufferGeneration = buffer.GetGeneration();
+		copy.SetBlock(3, 1, 5, 0x01);
+		buffer.SetBlock(3, 1, 5, 0x02);
+		testassert(buffer.GetGeneration() != BufferGeneration);
+		testassert(copy.GetGeneration() != buffer.GetGeneration());
+
+		// Unrelated data with the same content doesn't share the generation either
+		cChunkData other(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
+		other.SetBlock(3, 1, 4, 0xDE);
+		other.SetMeta(3, 1, 4, 0xA);
+		testassert(other.GetGeneration() != buffer.GetGeneration());
 	
 		BLOCKTYPE SrcBlockBuffer[16 * 16 * 256];
 		for (int i = 0; i < 16 * 16 * 256; i += 4)
@@ -53,7 +56,7 @@ int main(int argc, char** argv)
 	}
 	
 	{
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 	
 		NIBBLETYPE SrcNibbleBuffer[16 * 16 * 256 / 2];
 		for (int i = 0; i < 16 * 16 * 256 / 2; i += 4)
@@ -76,7 +79,7 @@ int main(int argc, char** argv)
 	}
 	
 	{
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 		
 		NIBBLETYPE SrcNibbleBuffer[16 * 16 * 256 / 2];
 		for (int i = 0; i < 16 * 16 * 256 / 2; i += 4)
@@ -99,7 +102,7 @@ int main(int argc, char** argv)
 	}
 	
 	{
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 		
 		NIBBLETYPE SrcNibbleBuffer[16 * 16 * 256 / 2];
 		for (int i = 0; i < 16 * 16 * 256 / 2; i += 4)
@@ -122,7 +125,7 @@ int main(int argc, char** argv)
 	}
 	
 	{
-		cChunkData buffer(Pool);
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 		
 		BLOCKTYPE SrcBlockBuffer[16 * 16 * 256];
 		memset(SrcBlockBuffer, 0x00, 16 * 16 * 256);
@@ -145,6 +148,49 @@ int main(int argc, char** argv)
 		testassert(memcmp(SrcNibbleBuffer, DstNibbleBuffer, (16 * 16 * 256 / 2) - 1) == 0);
 	}
 	
+	{
+		cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
+
+		// Fully dark and fully lit sections don't allocate their light arrays (nor does a meta need any block type array):
+		buffer.SetMeta(0, 0, 0, 0x01);
+		testassert(buffer.GetMemoryUsage() == sizeof(cChunkData::sChunkSection));
+		buffer.FillBlockLight(0x00);
+		buffer.FillSkyLight(0x00);  // Allocates all sections, since the default skylight is 15
+		const size_t AllSectionsSize = cChunkData::NumSections * sizeof(cChunkData::sChunkSection);
+		testassert(buffer.GetMemoryUsage() == AllSectionsSize);
+		testassert(buffer.GetSkyLight(0, 0, 0) == 0x00);
+		testassert(buffer.GetSection(0)->GetSkyLight()[0] == 0x00);
+
+		// Uneven light allocates the array and reads back the values:
+		NIBBLETYPE SrcNibbleBuffer[16 * 16 * 256 / 2];
+		memset(SrcNibbleBuffer, 0x00, 16 * 16 * 256 / 2);
+		SrcNibbleBuffer[0] = 0x5a;
+		buffer.SetBlockLight(SrcNibbleBuffer);
+		testassert(buffer.GetMemoryUsage() == AllSectionsSize + sizeof(cChunkData::sSectionNibbles));
+		testassert(Pools.m_Nibbles.m_NumAllocated == 1);
+		testassert(buffer.GetBlockLight(0, 0, 0) == 0x0a);
+		testassert(buffer.GetBlockLight(1, 0, 0) == 0x05);
+
+		// Copies keep the light values:
+		cChunkData copy(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
+		copy.Assign(buffer);
+		testassert(copy.GetBlockLight(1, 0, 0) == 0x05);
+		testassert(copy.GetMemoryUsage() == buffer.GetMemoryUsage());
+		testassert(Pools.m_Nibbles.m_NumAllocated == 2);
+
+		// Setting the light back to uniform frees the array:
+		buffer.FillBlockLight(0x0f);
+		testassert(buffer.GetMemoryUsage() == AllSectionsSize);
+		testassert(Pools.m_Nibbles.m_NumAllocated == 1);
+		testassert(buffer.GetBlockLight(1, 0, 0) == 0x0f);
+		NIBBLETYPE DstNibbleBuffer[16 * 16 * 256 / 2];
+		buffer.CopyBlockLight(DstNibbleBuffer);
+		testassert(DstNibbleBuffer[0] == 0xff);
+	}
+
+	// All the light arrays have been returned to the pool:
+	testassert(Pools.m_Nibbles.m_NumAllocated == 0);
+
 	// All tests successful:
 	return 0;
 }
@@ -9,6 +9,7 @@
 
 #include "Globals.h"
 #include "ChunkData.h"
+#include "MockPools.h"
 
 
 
@@ -19,20 +20,8 @@ int main(int argc, char ** argv)
 	LOGD("Test started");
 
 	// Set up a cChunkData with known contents - all blocks 0x01, all metas 0x02:
-	class cMockAllocationPool
-		: public cAllocationPool<cChunkData::sChunkSection>
- 	{
-		virtual cChunkData::sChunkSection * Allocate()
-		{
-			return new cChunkData::sChunkSection();
-		}
-		
-		virtual void Free(cChunkData::sChunkSection * a_Ptr)
-		{
-			delete a_Ptr;
-		}
-	} Pool;
-	cChunkData Data(Pool);
+	cMockChunkDataPools Pools;
+	cChunkData Data(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 	cChunkDef::BlockTypes   BlockTypes;
 	cChunkDef::BlockNibbles BlockMetas;
 	memset(BlockTypes, 0x01, sizeof(BlockTypes));
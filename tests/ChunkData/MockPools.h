@@ -0,0 +1,62 @@
+
+// MockPools.h
+
+// Declares the cMockAllocationPool class template and the cMockChunkDataPools class, the pools of the tests' cChunkData instances
+
+
+
+
+
+#pragma once
+
+#include "ChunkData.h"
+
+
+
+
+
+/** An allocation pool taking its elements directly from the heap, counting the elements currently allocated. */
+template <class T>
+class cMockAllocationPool :
+	public cAllocationPool<T>
+{
+public:
+
+	cMockAllocationPool(void):
+		m_NumAllocated(0)
+	{
+	}
+
+	/** The number of elements taken from the pool and not yet returned. */
+	int m_NumAllocated;
+
+	virtual T * Allocate() override
+	{
+		m_NumAllocated += 1;
+		return new T();
+	}
+
+	virtual void Free(T * a_Ptr) override
+	{
+		m_NumAllocated -= 1;
+		delete a_Ptr;
+	}
+} ;
+
+
+
+
+
+/** The pools that a cChunkData takes its sections, nibble arrays and plain block type arrays from. */
+class cMockChunkDataPools
+{
+public:
+
+	cMockAllocationPool<cChunkData::sChunkSection> m_Sections;
+	cMockAllocationPool<cChunkData::sSectionNibbles> m_Nibbles;
+	cMockAllocationPool<cChunkData::sSectionBlockTypes> m_BlockTypes;
+} ;
+
+
+
+
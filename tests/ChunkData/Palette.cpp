@@ -0,0 +1,205 @@
+
+// Palette.cpp
+
+// Implements the test for the storage forms of the sections' block types: single type, palette with 4-bit indices, plain array
+
+#include "Globals.h"
+#include "ChunkData.h"
+#include "MockPools.h"
+
+
+
+
+
+/** Returns the stats of the single chunk. */
+static cChunkData::sMemoryStats GetStats(const cChunkData & a_Data)
+{
+	cChunkData::sMemoryStats Stats;
+	a_Data.AddMemoryStats(Stats);
+	return Stats;
+}
+
+
+
+
+
+/** Checks that the data reads back the same blocks as the flat array, through both GetBlock() and CopyBlockTypes(). */
+static void CheckBlocks(const cChunkData & a_Data, const BLOCKTYPE * a_Expected)
+{
+	std::vector<BLOCKTYPE> Copy(cChunkDef::NumBlocks);
+	a_Data.CopyBlockTypes(Copy.data());
+	testassert(memcmp(Copy.data(), a_Expected, cChunkDef::NumBlocks) == 0);
+	for (int y = 0; y < cChunkDef::Height; y++)
+	{
+		for (int z = 0; z < cChunkDef::Width; z++)
+		{
+			for (int x = 0; x < cChunkDef::Width; x++)
+			{
+				testassert(a_Data.GetBlock(x, y, z) == a_Expected[cChunkDef::MakeIndexNoCheck(x, y, z)]);
+			}
+		}
+	}
+
+	// A range starting and ending mid-section, at odd indices into the packed nibbles:
+	const size_t Start = cChunkData::SectionBlockCount / 2 + 1;
+	const size_t Length = cChunkData::SectionBlockCount * 2 + 3;
+	std::vector<BLOCKTYPE> Range(Length);
+	a_Data.CopyBlockTypes(Range.data(), Start, Length);
+	testassert(memcmp(Range.data(), a_Expected + Start, Length) == 0);
+}
+
+
+
+
+
+/** Checks that SetBlock() moves a section from a single type through the palette to the plain array as the types are added. */
+static void TestSetBlock(cMockChunkDataPools & a_Pools)
+{
+	cChunkData Data(a_Pools.m_Sections, a_Pools.m_Nibbles, a_Pools.m_BlockTypes);
+	std::vector<BLOCKTYPE> Expected(cChunkDef::NumBlocks, 0);
+
+	// A single stone layer fills its section with stone and air, two types:
+	for (int z = 0; z < cChunkDef::Width; z++)
+	{
+		for (int x = 0; x < cChunkDef::Width; x++)
+		{
+			Data.SetBlock(x, 20, z, 1);
+			Expected[cChunkDef::MakeIndexNoCheck(x, 20, z)] = 1;
+		}
+	}
+	auto Stats = GetStats(Data);
+	testassert((Stats.m_NumSingleType == 0) && (Stats.m_NumPacked == 1) && (Stats.m_NumPlain == 0));
+	testassert(Stats.m_NumBytes == sizeof(cChunkData::sChunkSection) + sizeof(cChunkData::sSectionNibbles));
+	CheckBlocks(Data, Expected.data());
+
+	// Up to 16 types stay packed:
+	for (int i = 2; i < static_cast<int>(cChunkData::PaletteSize); i++)
+	{
+		Data.SetBlock(i, 21, 0, static_cast<BLOCKTYPE>(i));
+		Expected[cChunkDef::MakeIndexNoCheck(i, 21, 0)] = static_cast<BLOCKTYPE>(i);
+	}
+	Stats = GetStats(Data);
+	testassert((Stats.m_NumPacked == 1) && (Stats.m_NumPlain == 0));
+	CheckBlocks(Data, Expected.data());
+
+	// Setting a type already in the palette doesn't change the form:
+	Data.SetBlock(5, 22, 5, 3);
+	Expected[cChunkDef::MakeIndexNoCheck(5, 22, 5)] = 3;
+	testassert(GetStats(Data).m_NumPacked == 1);
+
+	// The 17th type unpacks the section into the plain array, returning the packed indices to the pool:
+	int NumNibblesBefore = a_Pools.m_Nibbles.m_NumAllocated;
+	Data.SetBlock(15, 31, 15, 200);
+	Expected[cChunkDef::MakeIndexNoCheck(15, 31, 15)] = 200;
+	Stats = GetStats(Data);
+	testassert((Stats.m_NumPacked == 0) && (Stats.m_NumPlain == 1));
+	testassert(Stats.m_NumBytes == sizeof(cChunkData::sChunkSection) + sizeof(cChunkData::sSectionBlockTypes));
+	testassert(a_Pools.m_Nibbles.m_NumAllocated == NumNibblesBefore - 1);
+	testassert(a_Pools.m_BlockTypes.m_NumAllocated == 1);
+	CheckBlocks(Data, Expected.data());
+
+	// Replacing the whole contents shrinks the section back, to a single type if possible:
+	Data.SetBlockTypes(Expected.data());
+	testassert(GetStats(Data).m_NumPlain == 1);
+	for (int i = 0; i < cChunkData::SectionHeight; i++)
+	{
+		for (int z = 0; z < cChunkDef::Width; z++)
+		{
+			for (int x = 0; x < cChunkDef::Width; x++)
+			{
+				Expected[cChunkDef::MakeIndexNoCheck(x, 16 + i, z)] = (i < 8) ? 7 : 0;
+			}
+		}
+	}
+	Data.SetBlockTypes(Expected.data());
+	Stats = GetStats(Data);
+	testassert((Stats.m_NumPacked == 1) && (Stats.m_NumPlain == 0));
+	testassert(a_Pools.m_BlockTypes.m_NumAllocated == 0);
+	CheckBlocks(Data, Expected.data());
+	Data.FillBlockTypes(4);
+	Stats = GetStats(Data);
+	testassert((Stats.m_NumSingleType == cChunkData::NumSections) && (Stats.m_NumPacked == 0));
+	testassert(Data.GetBlock(3, 200, 3) == 4);
+}
+
+
+
+
+
+/** Checks that the copies keep each section's form and the blocks, and that all the arrays return to the pools. */
+static void TestCopies(cMockChunkDataPools & a_Pools)
+{
+	{
+		std::vector<BLOCKTYPE> Expected(cChunkDef::NumBlocks);
+		for (size_t i = 0; i < cChunkDef::NumBlocks; i++)
+		{
+			size_t Section = i / cChunkData::SectionBlockCount;
+			if (Section < 4)
+			{
+				Expected[i] = 1;  // Single type
+			}
+			else if (Section < 8)
+			{
+				Expected[i] = static_cast<BLOCKTYPE>((i * 7) % 13);  // Packed
+			}
+			else if (Section < 10)
+			{
+				Expected[i] = static_cast<BLOCKTYPE>(i % 251);  // Plain
+			}
+			else
+			{
+				Expected[i] = 0;  // Missing
+			}
+		}
+		cChunkData Data(a_Pools.m_Sections, a_Pools.m_Nibbles, a_Pools.m_BlockTypes);
+		Data.SetBlockTypes(Expected.data());
+		auto Stats = GetStats(Data);
+		testassert((Stats.m_NumSingleType == 4) && (Stats.m_NumPacked == 4) && (Stats.m_NumPlain == 2));
+		CheckBlocks(Data, Expected.data());
+
+		cChunkData Copy(a_Pools.m_Sections, a_Pools.m_Nibbles, a_Pools.m_BlockTypes);
+		Copy.Assign(Data);
+		auto CopyStats = GetStats(Copy);
+		testassert((CopyStats.m_NumSingleType == 4) && (CopyStats.m_NumPacked == 4) && (CopyStats.m_NumPlain == 2));
+		testassert(CopyStats.m_NumBytes == Stats.m_NumBytes);
+		CheckBlocks(Copy, Expected.data());
+
+		// The copy is independent of the original:
+		Copy.SetBlock(0, 70, 0, 99);
+		testassert(Data.GetBlock(0, 70, 0) == Expected[cChunkDef::MakeIndexNoCheck(0, 70, 0)]);
+		testassert(Copy.GetBlock(0, 70, 0) == 99);
+
+		// The section accessors give the same blocks in any form:
+		BLOCKTYPE Buffer[cChunkData::SectionBlockCount];
+		for (size_t i = 0; i < 10; i++)
+		{
+			const auto * Section = Data.GetSection(i);
+			testassert(Section != nullptr);
+			testassert(memcmp(Section->GetBlockTypes(Buffer), Expected.data() + i * cChunkData::SectionBlockCount, cChunkData::SectionBlockCount) == 0);
+			testassert(Section->GetBlockType(77) == Expected[i * cChunkData::SectionBlockCount + 77]);
+		}
+	}
+	testassert(a_Pools.m_Sections.m_NumAllocated == 0);
+	testassert(a_Pools.m_Nibbles.m_NumAllocated == 0);
+	testassert(a_Pools.m_BlockTypes.m_NumAllocated == 0);
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	LOGD("Test started");
+
+	cMockChunkDataPools Pools;
+	TestSetBlock(Pools);
+	testassert(Pools.m_Sections.m_NumAllocated == 0);
+	testassert(Pools.m_Nibbles.m_NumAllocated == 0);
+	testassert(Pools.m_BlockTypes.m_NumAllocated == 0);
+
+	TestCopies(Pools);
+
+	LOG("Palette test finished");
+	return 0;
+}
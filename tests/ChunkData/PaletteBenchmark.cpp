@@ -0,0 +1,130 @@
+
+// PaletteBenchmark.cpp
+
+// Implements the benchmark of the block access in each storage form of the sections' block types
+// Three chunks are filled with terrain that ends up in each of the forms: single-type sections (solid stone), sections
+// of a few types (stone with ores, packed into the palette) and sections of many types (plain array). For each, the
+// benchmark reports the memory per chunk and the time of GetBlock() over the whole chunk, of random SetBlock() calls
+// that keep the section's form, and of CopyBlockTypes() of the whole chunk, the way the chunk is serialized and saved.
+
+#include "Globals.h"
+#include "ChunkData.h"
+#include "MockPools.h"
+#include "FastRandom.h"
+
+
+
+
+
+/** The number of times each measured operation is repeated. */
+static const int NUM_REPEATS = 20;
+
+
+
+
+
+/** Fills the terrain and returns the block type for the specified index, for the three kinds of the terrain. */
+static BLOCKTYPE GetTerrainBlock(int a_Kind, size_t a_Index, cFastRandom & a_Random)
+{
+	int y = static_cast<int>(a_Index / (cChunkDef::Width * cChunkDef::Width));
+	if (y >= 64)
+	{
+		return 0;  // Air above the terrain, no sections there
+	}
+	switch (a_Kind)
+	{
+		case 0: return 1;  // Solid stone
+		case 1: return static_cast<BLOCKTYPE>((a_Random.RandInt(19) == 0) ? (14 + a_Random.RandInt(2)) : 1);  // Stone with ores
+		default: return static_cast<BLOCKTYPE>(a_Random.RandInt(99));  // Many types
+	}
+}
+
+
+
+
+
+/** Returns the milliseconds elapsed since a_Start. */
+static double MsSince(std::chrono::steady_clock::time_point a_Start)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(std::chrono::steady_clock::now() - a_Start).count();
+}
+
+
+
+
+
+static void Benchmark(int a_Kind, const char * a_Name)
+{
+	cMockChunkDataPools Pools;
+	cChunkData Data(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
+	cFastRandom Random;
+	std::vector<BLOCKTYPE> Blocks(cChunkDef::NumBlocks);
+	for (size_t i = 0; i < Blocks.size(); i++)
+	{
+		Blocks[i] = GetTerrainBlock(a_Kind, i, Random);
+	}
+	Data.SetBlockTypes(Blocks.data());
+	cChunkData::sMemoryStats Stats;
+	Data.AddMemoryStats(Stats);
+
+	// GetBlock() over the whole chunk:
+	auto Start = std::chrono::steady_clock::now();
+	size_t Checksum = 0;
+	for (int r = 0; r < NUM_REPEATS; r++)
+	{
+		for (int y = 0; y < cChunkDef::Height; y++)
+		{
+			for (int z = 0; z < cChunkDef::Width; z++)
+			{
+				for (int x = 0; x < cChunkDef::Width; x++)
+				{
+					Checksum += Data.GetBlock(x, y, z);
+				}
+			}
+		}
+	}
+	double GetNs = MsSince(Start) * 1e6 / (NUM_REPEATS * static_cast<double>(cChunkDef::NumBlocks));
+
+	// SetBlock() at random places, with types already present in the terrain so that the forms stay the same:
+	const int NumSets = 100000;
+	Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < NumSets; i++)
+	{
+		int x = Random.RandInt(cChunkDef::Width - 1);
+		int y = Random.RandInt(63);
+		int z = Random.RandInt(cChunkDef::Width - 1);
+		Data.SetBlock(x, y, z, Blocks[static_cast<size_t>(cChunkDef::MakeIndexNoCheck(x, y ^ 1, z))]);
+	}
+	double SetNs = MsSince(Start) * 1e6 / NumSets;
+
+	// CopyBlockTypes() of the whole chunk:
+	Start = std::chrono::steady_clock::now();
+	for (int r = 0; r < NUM_REPEATS; r++)
+	{
+		Data.CopyBlockTypes(Blocks.data());
+		Checksum += Blocks[static_cast<size_t>(r)];
+	}
+	double CopyUs = MsSince(Start) * 1000 / NUM_REPEATS;
+
+	LOG("%s: %u single-type, %u packed, %u plain sections; " SIZE_T_FMT " bytes per chunk; GetBlock %.2f ns, SetBlock %.2f ns, CopyBlockTypes %.1f us (checksum " SIZE_T_FMT ")",
+		a_Name,
+		static_cast<unsigned>(Stats.m_NumSingleType), static_cast<unsigned>(Stats.m_NumPacked), static_cast<unsigned>(Stats.m_NumPlain),
+		Stats.m_NumBytes, GetNs, SetNs, CopyUs, Checksum
+	);
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	LOGD("Benchmark started");
+
+	Benchmark(0, "Solid stone");
+	Benchmark(1, "Stone with ores");
+	Benchmark(2, "Many types");
+
+	LOG("PaletteBenchmark finished");
+	return 0;
+}
@@ -1,24 +1,13 @@
 
 #include "Globals.h"
 #include "ChunkData.h"
+#include "MockPools.h"
 
 int main(int argc, char** argv)
 {
 	LOGD("Test started");
 
-	class cMockAllocationPool
-		: public cAllocationPool<cChunkData::sChunkSection>
- 	{
-		virtual cChunkData::sChunkSection * Allocate()
-		{
-			return new cChunkData::sChunkSection();
-		}
-		
-		virtual void Free(cChunkData::sChunkSection * a_Ptr)
-		{
-			delete a_Ptr;
-		}
-	} Pool;
-	cChunkData buffer(Pool);
+	cMockChunkDataPools Pools;
+	cChunkData buffer(Pools.m_Sections, Pools.m_Nibbles, Pools.m_BlockTypes);
 	return 0;
 }
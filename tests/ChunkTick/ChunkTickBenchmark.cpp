@@ -0,0 +1,167 @@
+// ChunkTickBenchmark.cpp
+
+// Implements the benchmark of the chunk tick's parallel phase, the random-tick block selection, with each number of workers
+// Each chunk gets a terrain of dirt topped by grass, with tree leaves above it, so that every section up to the treetops
+// has random-tickable blocks. The chunks' blocks are then picked by the cChunkTickScheduler the same way as
+// cChunkMap::Tick() does it, with the scheduler running on 0, 1, 2, 4, ... workers, and the time per tick is reported.
+// Usage: ChunkTickBenchmark [<NumChunks> [<NumTicks> [<MaxWorkers>]]]
+// MaxWorkers defaults to one less than the number of the hardware threads, the calling thread works as well.
+
+#include "Globals.h"
+#include "ChunkData.h"
+#include "ChunkTickScheduler.h"
+#include "../ChunkData/MockPools.h"
+
+
+
+
+
+/** The number of blocks picked in each section per tick, the default randomTickSpeed of the worlds. */
+static const int NUM_PER_SECTION = 3;
+
+/** The block types used in the terrain. */
+static const BLOCKTYPE BLOCK_DIRT = 3;
+static const BLOCKTYPE BLOCK_GRASS = 2;
+static const BLOCKTYPE BLOCK_LEAVES = 18;
+
+
+
+
+
+/** Returns the milliseconds elapsed since a_Start. */
+static double MsSince(std::chrono::steady_clock::time_point a_Start)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(std::chrono::steady_clock::now() - a_Start).count();
+}
+
+
+
+
+
+/** A single benchmarked chunk: the block data and what the chunk keeps for picking its random-ticked blocks. */
+struct sChunk
+{
+	sChunk(cMockChunkDataPools & a_Pools):
+		m_Data(a_Pools.m_Sections, a_Pools.m_Nibbles, a_Pools.m_BlockTypes)
+	{
+	}
+
+	cChunkData m_Data;
+	UInt16 m_NumRandomTickable[cChunkData::NumSections];
+	std::vector<Vector3i> m_RandomTickBlocks;
+} ;
+
+
+
+
+
+/** Fills the chunk with the terrain and counts its random-tickable blocks per section. */
+static void FillChunk(sChunk & a_Chunk, const bool * a_IsTickable)
+{
+	std::vector<BLOCKTYPE> Blocks(cChunkDef::NumBlocks);
+	for (size_t i = 0; i < Blocks.size(); i++)
+	{
+		int y = static_cast<int>(i / (cChunkDef::Width * cChunkDef::Width));
+		if (y < 63)
+		{
+			Blocks[i] = BLOCK_DIRT;
+		}
+		else if (y == 63)
+		{
+			Blocks[i] = BLOCK_GRASS;
+		}
+		else if ((y >= 68) && (y < 76))
+		{
+			Blocks[i] = BLOCK_LEAVES;
+		}
+	}
+	a_Chunk.m_Data.SetBlockTypes(Blocks.data());
+
+	std::fill(std::begin(a_Chunk.m_NumRandomTickable), std::end(a_Chunk.m_NumRandomTickable), 0);
+	for (size_t i = 0; i < Blocks.size(); i++)
+	{
+		if (a_IsTickable[Blocks[i]])
+		{
+			a_Chunk.m_NumRandomTickable[i / (cChunkDef::Width * cChunkDef::Width * cChunkData::SectionHeight)] += 1;
+		}
+	}
+}
+
+
+
+
+
+/** Picks the chunks' random-ticked blocks a_NumTicks times on a scheduler with the specified number of workers.
+Returns the milliseconds per tick. */
+static double Measure(std::vector<std::unique_ptr<sChunk>> & a_Chunks, const std::vector<cChunkCoords> & a_Coords, const bool * a_IsTickable, int a_NumWorkers, int a_NumTicks, size_t & a_NumPicked)
+{
+	cChunkTickScheduler Scheduler;
+	Scheduler.Start(a_NumWorkers);
+	auto Start = std::chrono::steady_clock::now();
+	for (int Tick = 0; Tick < a_NumTicks; Tick++)
+	{
+		Scheduler.Run(a_Coords, [&a_Chunks, a_IsTickable](size_t a_ChunkIndex)
+			{
+				auto & Chunk = *a_Chunks[a_ChunkIndex];
+				Chunk.m_Data.PickRandomBlocks(a_IsTickable, Chunk.m_NumRandomTickable, NUM_PER_SECTION, Chunk.m_RandomTickBlocks);
+			}
+		);
+
+		// The serial part of the tick would use the picked blocks here:
+		for (auto & Chunk : a_Chunks)
+		{
+			a_NumPicked += Chunk->m_RandomTickBlocks.size();
+			Chunk->m_RandomTickBlocks.clear();
+		}
+	}
+	double Ms = MsSince(Start) / a_NumTicks;
+	Scheduler.Stop();
+	return Ms;
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	LOGD("Benchmark started");
+
+	int NumChunks = (argc > 1) ? std::max(1, atoi(argv[1])) : 1024;
+	int NumTicks = (argc > 2) ? std::max(1, atoi(argv[2])) : 200;
+	int MaxWorkers = (argc > 3) ? std::max(0, atoi(argv[3])) : static_cast<int>(std::thread::hardware_concurrency()) - 1;
+
+	bool IsTickable[256] = {};
+	IsTickable[BLOCK_GRASS] = true;
+	IsTickable[BLOCK_LEAVES] = true;
+
+	// Lay the chunks out in a square around the origin, the way the players' view distance loads them:
+	cMockChunkDataPools Pools;
+	std::vector<std::unique_ptr<sChunk>> Chunks;
+	std::vector<cChunkCoords> Coords;
+	int Side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(NumChunks))));
+	for (int i = 0; i < NumChunks; i++)
+	{
+		Chunks.push_back(cpp14::make_unique<sChunk>(Pools));
+		FillChunk(*Chunks.back(), IsTickable);
+		Coords.emplace_back(i % Side - Side / 2, i / Side - Side / 2);
+	}
+
+	for (int NumWorkers = 0; ; NumWorkers = std::min(std::max(1, NumWorkers * 2), MaxWorkers))
+	{
+		size_t NumPicked = 0;
+		double Ms = Measure(Chunks, Coords, IsTickable, NumWorkers, NumTicks, NumPicked);
+		LOG("%d chunks, %d ticks, %d workers: %.3f ms/tick (" SIZE_T_FMT " blocks picked)", NumChunks, NumTicks, NumWorkers, Ms, NumPicked);
+		if (NumWorkers >= MaxWorkers)
+		{
+			break;
+		}
+	}
+
+	LOG("ChunkTickBenchmark finished");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,197 @@
+// ChunkTickSchedulerTest.cpp
+
+// Implements the test of the cChunkTickScheduler class that runs a part of the chunks' tick on a pool of worker threads
+// The job marks the chunk it runs for and the chunk's neighbors as used for a while; no chunk may be used by two jobs
+// at once. Each job also records when it started and finished, so that the test can check that each chunk's job ran
+// exactly once and that all the jobs of a phase finished before any job of the next phase started.
+
+#include "Globals.h"
+#include "ChunkTickScheduler.h"
+#include "FastRandom.h"
+
+
+
+
+
+/** The chunks are in a square of this many chunks per side, centered on the world's origin. */
+static const int AREA_SIZE = 24;
+
+/** The number of times each scheduler runs the job over the chunks. */
+static const int NUM_RUNS = 5;
+
+
+
+
+
+/** The state of the chunks used by the test jobs. */
+class cTestChunks
+{
+public:
+
+	cTestChunks(void):
+		m_Clock(0),
+		m_NumConflicts(0)
+	{
+		cFastRandom Random;
+		for (int z = -AREA_SIZE / 2; z < AREA_SIZE / 2; z++)
+		{
+			for (int x = -AREA_SIZE / 2; x < AREA_SIZE / 2; x++)
+			{
+				// Leave some holes in the area, not all the loaded chunks are ticked:
+				if (Random.RandInt(9) != 0)
+				{
+					m_Coords.emplace_back(x, z);
+				}
+			}
+		}
+		std::shuffle(m_Coords.begin(), m_Coords.end(), Random.Engine());
+
+		for (auto & IsUsed : m_IsUsed)
+		{
+			IsUsed = false;
+		}
+		m_NumRuns.resize(m_Coords.size());
+		m_Start.resize(m_Coords.size());
+		m_End.resize(m_Coords.size());
+	}
+
+	/** Runs the job for the chunk of the specified index: marks the chunk and its neighbors as used, checking that
+	they weren't used before, waits a while, then marks them unused again. */
+	void Job(size_t a_ChunkIndex)
+	{
+		m_Start[a_ChunkIndex] = m_Clock++;
+		const auto & Coords = m_Coords[a_ChunkIndex];
+		for (int z = Coords.m_ChunkZ - 1; z <= Coords.m_ChunkZ + 1; z++)
+		{
+			for (int x = Coords.m_ChunkX - 1; x <= Coords.m_ChunkX + 1; x++)
+			{
+				if (GetIsUsed(x, z).exchange(true))
+				{
+					m_NumConflicts++;
+				}
+			}
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+		for (int z = Coords.m_ChunkZ - 1; z <= Coords.m_ChunkZ + 1; z++)
+		{
+			for (int x = Coords.m_ChunkX - 1; x <= Coords.m_ChunkX + 1; x++)
+			{
+				GetIsUsed(x, z) = false;
+			}
+		}
+		m_NumRuns[a_ChunkIndex] += 1;
+		m_End[a_ChunkIndex] = m_Clock++;
+	}
+
+	/** Checks the jobs of a single run: each chunk's job ran once, no jobs conflicted, the phases didn't overlap. */
+	void CheckRun(int a_RunNum)
+	{
+		assert_test(m_NumConflicts == 0);
+		for (size_t i = 0; i < m_Coords.size(); i++)
+		{
+			assert_test(m_NumRuns[i] == a_RunNum);
+			for (size_t j = 0; j < m_Coords.size(); j++)
+			{
+				if (GetColor(m_Coords[i]) < GetColor(m_Coords[j]))
+				{
+					assert_test(m_End[i] < m_Start[j]);
+				}
+			}
+		}
+	}
+
+	/** The chunks to run the job for. */
+	std::vector<cChunkCoords> m_Coords;
+
+protected:
+
+	/** The ordering of the jobs' starts and ends. */
+	std::atomic<int> m_Clock;
+
+	/** The number of times a job found a chunk used by another job. */
+	std::atomic<int> m_NumConflicts;
+
+	/** For each chunk of the area, including the row of the neighbors around it, true while a job uses it. */
+	std::atomic<bool> m_IsUsed[(AREA_SIZE + 2) * (AREA_SIZE + 2)];
+
+	/** The number of times the job ran for each of m_Coords. Each is written by one job at a time only. */
+	std::vector<int> m_NumRuns;
+
+	/** The m_Clock values when the last job for each of m_Coords started and ended. */
+	std::vector<int> m_Start;
+	std::vector<int> m_End;
+
+
+	std::atomic<bool> & GetIsUsed(int a_ChunkX, int a_ChunkZ)
+	{
+		int x = a_ChunkX + AREA_SIZE / 2 + 1;
+		int z = a_ChunkZ + AREA_SIZE / 2 + 1;
+		return m_IsUsed[x + z * (AREA_SIZE + 2)];
+	}
+
+	/** Returns the checkerboard color of the chunk's region, the same way as the scheduler. */
+	static int GetColor(const cChunkCoords & a_Coords)
+	{
+		int RegionX = static_cast<int>(std::floor(static_cast<double>(a_Coords.m_ChunkX) / cChunkTickScheduler::REGION_SIZE));
+		int RegionZ = static_cast<int>(std::floor(static_cast<double>(a_Coords.m_ChunkZ) / cChunkTickScheduler::REGION_SIZE));
+		return (RegionX & 1) | ((RegionZ & 1) << 1);
+	}
+} ;
+
+
+
+
+
+/** Runs the job over the test chunks NUM_RUNS times with the specified number of workers, checking each run. */
+static void TestWorkers(int a_NumWorkers)
+{
+	LOGD("Testing with %d workers", a_NumWorkers);
+	cTestChunks Chunks;
+	cChunkTickScheduler Scheduler;
+	Scheduler.Start(a_NumWorkers);
+	assert_test(Scheduler.GetNumWorkers() == static_cast<size_t>(a_NumWorkers));
+	for (int i = 1; i <= NUM_RUNS; i++)
+	{
+		Scheduler.Run(Chunks.m_Coords, [&Chunks](size_t a_ChunkIndex)
+			{
+				Chunks.Job(a_ChunkIndex);
+			}
+		);
+		Chunks.CheckRun(i);
+	}
+	Scheduler.Stop();
+
+	// Running without any chunks, or after stopping the workers, still works:
+	Scheduler.Run({}, [](size_t a_ChunkIndex)
+		{
+			assert_test(!"No job may run without chunks");
+		}
+	);
+	Scheduler.Run(Chunks.m_Coords, [&Chunks](size_t a_ChunkIndex)
+		{
+			Chunks.Job(a_ChunkIndex);
+		}
+	);
+	Chunks.CheckRun(NUM_RUNS + 1);
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	TestWorkers(0);
+	TestWorkers(1);
+	TestWorkers(3);
+	TestWorkers(8);
+
+	LOG("ChunkTickScheduler test finished");
+	return 0;
+}
+
+
+
+
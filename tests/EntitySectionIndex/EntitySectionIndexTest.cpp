@@ -0,0 +1,262 @@
+
+// EntitySectionIndexTest.cpp
+
+// Implements the test for the cEntitySectionIndex class template that indexes a chunk's entities by section
+
+#include "Globals.h"
+#include "EntitySectionIndex.h"
+
+
+
+
+
+/** A stand-in for cEntity, providing just what the index needs. */
+class cTestEntity
+{
+public:
+
+	cTestEntity(double a_PosY, bool a_IsPlayer = false):
+		m_PosY(a_PosY),
+		m_IsPlayer(a_IsPlayer),
+		m_IndexedSection(-1)
+	{
+	}
+
+	bool IsPlayer(void) const { return m_IsPlayer; }
+	double GetPosY(void) const { return m_PosY; }
+	void SetPosY(double a_PosY) { m_PosY = a_PosY; }
+	int GetIndexedSection(void) const { return m_IndexedSection; }
+	void SetIndexedSection(int a_Section) { m_IndexedSection = a_Section; }
+
+protected:
+
+	double m_PosY;
+	bool m_IsPlayer;
+	int m_IndexedSection;
+} ;
+
+typedef cEntitySectionIndex<cTestEntity> cTestIndex;
+
+
+
+
+
+/** Returns the entities that the index reports for the Y range. */
+static std::vector<cTestEntity *> Query(cTestIndex & a_Index, double a_MinY, double a_MaxY)
+{
+	std::vector<cTestEntity *> Res;
+	assert_test(a_Index.ForEachAroundHeight(a_MinY, a_MaxY, [&](cTestEntity & a_Entity)
+		{
+			Res.push_back(&a_Entity);
+			return false;
+		}
+	));
+	return Res;
+}
+
+
+
+
+
+/** Returns true if the entity is in the list. */
+static bool Contains(const std::vector<cTestEntity *> & a_Entities, const cTestEntity & a_Entity)
+{
+	return (std::find(a_Entities.begin(), a_Entities.end(), &a_Entity) != a_Entities.end());
+}
+
+
+
+
+
+/** Checks which entities the queries find, including the entities reaching in from the section below, and the players. */
+static void TestQueries(void)
+{
+	cTestIndex Index;
+	cTestEntity Low(5), Border(31.5), Mid(40), High(100), Above(300), Below(-10), Player(100, true);
+	for (auto Entity : {&Low, &Border, &Mid, &High, &Above, &Below, &Player})
+	{
+		Index.Add(*Entity);
+	}
+	assert_test(Index.GetNumEntities() == 7);
+	assert_test(Low.GetIndexedSection() == 0);
+	assert_test(Border.GetIndexedSection() == 1);
+	assert_test(Above.GetIndexedSection() == 15);
+	assert_test(Below.GetIndexedSection() == 0);
+	assert_test(Player.GetIndexedSection() == -1);
+
+	// A box in section 2 also gets section 1, whose entities may be tall enough to reach in, section 3, whose entities
+	// may have fallen in since they were indexed, and all the players:
+	auto Res = Query(Index, 34, 38);
+	assert_test(Res.size() == 3);
+	assert_test(Contains(Res, Border) && Contains(Res, Mid) && Contains(Res, Player));
+
+	// Above and below the world:
+	Res = Query(Index, 260, 270);
+	assert_test((Res.size() == 2) && Contains(Res, Above) && Contains(Res, Player));
+	Res = Query(Index, -20, -15);
+	assert_test((Res.size() == 3) && Contains(Res, Low) && Contains(Res, Below) && Contains(Res, Player));
+
+	// A callback returning true stops the query:
+	int NumCalls = 0;
+	assert_test(!Index.ForEachAroundHeight(0, 255, [&](cTestEntity & a_Entity)
+		{
+			UNUSED(a_Entity);
+			NumCalls += 1;
+			return true;
+		}
+	));
+	assert_test(NumCalls == 1);
+}
+
+
+
+
+
+/** Checks that the moved entities are found at their new height only after Update(), while the players are always found. */
+static void TestUpdate(void)
+{
+	cTestIndex Index;
+	cTestEntity Mob(10), Player(10, true);
+	Index.Add(Mob);
+	Index.Add(Player);
+
+	// The index is a hint until the chunk ticks; the moved mob is still listed at its old height:
+	Mob.SetPosY(200);
+	Player.SetPosY(200);
+	auto Res = Query(Index, 199, 201);
+	assert_test((Res.size() == 1) && Contains(Res, Player));
+	assert_test(Contains(Query(Index, 9, 11), Mob));
+
+	Index.Update(Mob);
+	Index.Update(Player);
+	assert_test(Mob.GetIndexedSection() == 12);
+	Res = Query(Index, 199, 201);
+	assert_test((Res.size() == 2) && Contains(Res, Mob));
+	assert_test(!Contains(Query(Index, 9, 11), Mob));
+
+	// Moving within the section keeps the entity in place:
+	Mob.SetPosY(207);
+	Index.Update(Mob);
+	assert_test(Mob.GetIndexedSection() == 12);
+	assert_test(Index.GetNumEntities() == 2);
+
+	Index.Remove(Mob);
+	Index.Remove(Player);
+	assert_test(Mob.GetIndexedSection() == -1);
+	assert_test(Index.GetNumEntities() == 0);
+}
+
+
+
+
+
+/** Checks that an entity that has fallen into a lower section since it was indexed is still found there,
+before the chunk ticks and re-indexes it. */
+static void TestFalling(void)
+{
+	cTestIndex Index;
+	cTestEntity Mob(65);
+	Index.Add(Mob);
+	assert_test(Mob.GetIndexedSection() == 4);
+
+	// Falling from the bottom of section 4 into the top of section 3:
+	Mob.SetPosY(62);
+	assert_test(Contains(Query(Index, 61, 63), Mob));
+
+	// Falling through the whole of section 3, which takes more than a tick even at the terminal velocity:
+	Mob.SetPosY(48.5);
+	assert_test(Contains(Query(Index, 48, 49), Mob));
+
+	// Queries two sections below aren't affected:
+	Mob.SetPosY(40);
+	assert_test(!Contains(Query(Index, 39, 41), Mob));
+	Index.Update(Mob);
+	assert_test(Contains(Query(Index, 39, 41), Mob));
+}
+
+
+
+
+
+/** Checks that the callbacks may add and remove entities, including nested queries, without skipping any entity. */
+static void TestChangesInCallbacks(void)
+{
+	cTestIndex Index;
+	std::vector<std::unique_ptr<cTestEntity>> Entities;
+	for (int i = 0; i < 10; i++)
+	{
+		Entities.emplace_back(new cTestEntity(64));
+		Index.Add(*Entities.back());
+	}
+
+	// Remove every other entity from a nested query while the outer query walks the list:
+	cTestEntity Spawned(65);
+	std::vector<cTestEntity *> Visited;
+	assert_test(Index.ForEachAroundHeight(64, 66, [&](cTestEntity & a_Entity)
+		{
+			Visited.push_back(&a_Entity);
+			if (&a_Entity == Entities[0].get())
+			{
+				// Spawn an entity into the list being walked; it's found by this very query, too:
+				Index.Add(Spawned);
+				Index.ForEachAroundHeight(64, 66, [&](cTestEntity & a_Inner)
+					{
+						for (size_t i = 1; i < Entities.size(); i += 2)
+						{
+							if (&a_Inner == Entities[i].get())
+							{
+								Index.Remove(a_Inner);
+							}
+						}
+						return false;
+					}
+				);
+			}
+			return false;
+		}
+	));
+
+	// The outer query skipped the removed entities, but visited all the others and the spawned one:
+	assert_test(Visited.size() == 6);
+	for (size_t i = 0; i < Entities.size(); i += 2)
+	{
+		assert_test(Contains(Visited, *Entities[i]));
+	}
+	assert_test(Contains(Visited, Spawned));
+
+	// The empty slots have been compacted once the outer query finished:
+	assert_test(Index.GetNumEntities() == 6);
+	assert_test(Query(Index, 64, 66).size() == 6);
+	for (size_t i = 1; i < Entities.size(); i += 2)
+	{
+		assert_test(Entities[i]->GetIndexedSection() == -1);
+	}
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	LOGD("Testing the queries");
+	TestQueries();
+
+	LOGD("Testing the updates of the moved entities");
+	TestUpdate();
+
+	LOGD("Testing the entities falling between the updates");
+	TestFalling();
+
+	LOGD("Testing the changes made by the callbacks");
+	TestChangesInCallbacks();
+
+	LOG("EntitySectionIndex test finished");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,496 @@
+// FloodyEquivalenceTest.cpp
+
+// Implements the test that the Dense fluid simulator's kernel floods the same way as the Floody simulator
+// The test terrain is flooded twice, tick by tick: once by sweeping the sections with the cDenseFluidKernel, and once
+// block by block with a reference implementation of the cFloodyFluidSimulator's rules, scheduled the way
+// cDelayedFluidSimulator does (the real simulator needs a cWorld with its chunks).
+// Both simulate the same blocks in each tick and see the blocks changed earlier in the same tick, but in a different
+// order: the kernel in the sections' array order, Floody in the order the blocks were woken up. Where a flow front runs
+// along the array order, the kernel moves it by one more block in a tick than Floody does. This is intended: after each
+// tick, the floods may differ only in such blocks, with the dense flood ahead, and the dense flood settles no later,
+// with the last Floody ticks only re-checking the blocks without changing them. Both floods settle into byte-identical
+// block types and metas.
+
+#include "Globals.h"
+#include "FluidTestTerrain.h"
+#include "Simulator/FluidSimulator.h"
+
+
+
+
+
+/** The maximum number of ticks before the flood is considered not settling. */
+static const int MAX_TICKS = 5000;
+
+
+
+
+
+/** The Floody simulator's rules for water (falloff 1, source creation on), simulating single blocks of a cTestTerrain.
+Mirrors cFloodyFluidSimulator, with the blocks outside the terrain treated as the blocks of unavailable chunks.
+The blocks woken up while simulating are simulated in the next tick, each block once, in the order they were woken up. */
+class cFloodyReference
+{
+public:
+	cFloodyReference(cTestTerrain & a_Terrain) :
+		m_Terrain(a_Terrain),
+		m_Falloff(1),
+		m_NumNeighborsForSource(2),
+		m_AddSet(0)
+	{
+		m_IsScheduled[0].resize(SIZE_X * SIZE_Y * SIZE_Z);
+		m_IsScheduled[1].resize(SIZE_X * SIZE_Y * SIZE_Z);
+	}
+
+
+	/** Schedules the block for simulation, if it's flowing water and not scheduled yet, see cDelayedFluidSimulator::AddBlock(). */
+	void AddBlock(int a_X, int a_Y, int a_Z)
+	{
+		BLOCKTYPE BlockType;
+		NIBBLETYPE Meta;
+		if (!GetBlock(a_X, a_Y, a_Z, BlockType, Meta) || (BlockType != E_BLOCK_WATER))
+		{
+			return;
+		}
+		size_t Idx = static_cast<size_t>(a_X + SIZE_X * (a_Z + SIZE_Z * a_Y));
+		if (m_IsScheduled[m_AddSet][Idx])
+		{
+			return;
+		}
+		m_IsScheduled[m_AddSet][Idx] = true;
+		m_Scheduled[m_AddSet].push_back(Vector3i(a_X, a_Y, a_Z));
+	}
+
+
+	/** Simulates all the scheduled blocks once. Returns false if there were no blocks scheduled. */
+	bool Tick(void)
+	{
+		int SimSet = m_AddSet;
+		m_AddSet = 1 - m_AddSet;
+		if (m_Scheduled[SimSet].empty())
+		{
+			return false;
+		}
+		for (const auto & Block: m_Scheduled[SimSet])
+		{
+			m_IsScheduled[SimSet][static_cast<size_t>(Block.x + SIZE_X * (Block.z + SIZE_Z * Block.y))] = false;
+			SimulateBlock(Block.x, Block.y, Block.z);
+		}
+		m_Scheduled[SimSet].clear();
+		return true;
+	}
+
+protected:
+
+	cTestTerrain & m_Terrain;
+
+	NIBBLETYPE m_Falloff;
+	int m_NumNeighborsForSource;
+
+	/** The blocks scheduled for simulation, two sets: one being simulated, the other one collecting the woken up blocks. */
+	std::vector<Vector3i> m_Scheduled[2];
+
+	/** For each block of the terrain and each set, whether it is in m_Scheduled. */
+	std::vector<bool> m_IsScheduled[2];
+
+	/** The set into which the woken up blocks are added. */
+	int m_AddSet;
+
+
+	/** Returns the block, or false if it is outside the terrain (cChunk::UnboundedRelGetBlock()). */
+	bool GetBlock(int a_X, int a_Y, int a_Z, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Meta)
+	{
+		if (!cTestTerrain::IsInside(a_X, a_Y, a_Z))
+		{
+			return false;
+		}
+		m_Terrain.GetBlock(a_X, a_Y, a_Z, a_BlockType, a_Meta);
+		return true;
+	}
+
+
+	/** Sets the block and wakes up its neighborhood, the way cChunk::SetBlock() and its block check do. */
+	void SetBlock(int a_X, int a_Y, int a_Z, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta)
+	{
+		m_Terrain.SetBlock(a_X, a_Y, a_Z, a_BlockType, a_Meta);
+		static const int Offsets[][3] =
+		{
+			{ 0, 0, 0 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 },
+		};
+		for (const auto & Checked: Offsets)
+		{
+			for (const auto & Woken: Offsets)
+			{
+				AddBlock(a_X + Checked[0] + Woken[0], a_Y + Checked[1] + Woken[1], a_Z + Checked[2] + Woken[2]);
+			}
+		}
+	}
+
+
+	static bool IsAnyFluidBlock(BLOCKTYPE a_BlockType)
+	{
+		return ((a_BlockType == E_BLOCK_WATER) || (a_BlockType == E_BLOCK_STATIONARY_WATER));
+	}
+
+
+	/** See cFluidSimulator::IsPassableForFluid(). */
+	static bool IsPassableForFluid(BLOCKTYPE a_BlockType)
+	{
+		return (
+			(a_BlockType == E_BLOCK_AIR) ||
+			(a_BlockType == E_BLOCK_FIRE) ||
+			IsAnyFluidBlock(a_BlockType) ||
+			cFluidSimulator::CanWashAway(a_BlockType)
+		);
+	}
+
+
+	/** See cFloodyFluidSimulator::SimulateBlock(). */
+	void SimulateBlock(int a_X, int a_Y, int a_Z)
+	{
+		BLOCKTYPE MyBlock;
+		NIBBLETYPE MyMeta;
+		if (!GetBlock(a_X, a_Y, a_Z, MyBlock, MyMeta) || !IsAnyFluidBlock(MyBlock))
+		{
+			return;
+		}
+
+		// Water never hardens, HardenBlock() is a no-op
+
+		if ((MyMeta != 0) && CheckTributaries(a_X, a_Y, a_Z, MyMeta))
+		{
+			return;
+		}
+
+		NIBBLETYPE NewMeta = ((MyMeta == 0) || ((MyMeta & 0x08) != 0)) ? m_Falloff : (MyMeta + m_Falloff);
+		if (a_Y > 0)
+		{
+			bool SpreadFurther = true;
+			BLOCKTYPE Below = E_BLOCK_AIR;
+			NIBBLETYPE BelowMeta;
+			VERIFY(GetBlock(a_X, a_Y - 1, a_Z, Below, BelowMeta));
+			if (IsPassableForFluid(Below) || IsBlockLava(Below) || IsBlockWater(Below))
+			{
+				SpreadToNeighbor(a_X, a_Y - 1, a_Z, 8);
+				if (MyMeta != 0)
+				{
+					SpreadFurther = false;
+				}
+			}
+			if (SpreadFurther && (NewMeta < 8))
+			{
+				SpreadToNeighbor(a_X - 1, a_Y, a_Z,     NewMeta);
+				SpreadToNeighbor(a_X + 1, a_Y, a_Z,     NewMeta);
+				SpreadToNeighbor(a_X,     a_Y, a_Z - 1, NewMeta);
+				SpreadToNeighbor(a_X,     a_Y, a_Z + 1, NewMeta);
+			}
+			if (
+				(m_NumNeighborsForSource > 0) &&
+				(MyMeta == m_Falloff) &&
+				(!IsPassableForFluid(Below) || (Below == E_BLOCK_STATIONARY_WATER)) &&
+				CheckNeighborsForSource(a_X, a_Y, a_Z)
+			)
+			{
+				return;
+			}
+		}
+
+		// Mark as processed, without any block updates (cChunk::FastSetBlock()):
+		m_Terrain.SetBlock(a_X, a_Y, a_Z, E_BLOCK_STATIONARY_WATER, MyMeta);
+	}
+
+
+	/** See cFloodyFluidSimulator::CheckTributaries(). */
+	bool CheckTributaries(int a_X, int a_Y, int a_Z, NIBBLETYPE a_MyMeta)
+	{
+		BLOCKTYPE BlockType;
+		NIBBLETYPE BlockMeta;
+		if (GetBlock(a_X, a_Y + 1, a_Z, BlockType, BlockMeta) && IsAnyFluidBlock(BlockType))
+		{
+			return false;
+		}
+		if (a_MyMeta != 8)
+		{
+			static const int Coords[][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+			for (const auto & Coord: Coords)
+			{
+				if (
+					GetBlock(a_X + Coord[0], a_Y, a_Z + Coord[1], BlockType, BlockMeta) &&
+					IsAnyFluidBlock(BlockType) &&
+					cFluidSimulator::IsHigherMeta(BlockMeta, a_MyMeta)
+				)
+				{
+					return false;
+				}
+			}
+		}
+
+		if (a_MyMeta >= 8)
+		{
+			SetBlock(a_X, a_Y, a_Z, E_BLOCK_STATIONARY_WATER, m_Falloff);
+		}
+		else if (a_MyMeta + m_Falloff < 8)
+		{
+			SetBlock(a_X, a_Y, a_Z, E_BLOCK_STATIONARY_WATER, a_MyMeta + m_Falloff);
+		}
+		else
+		{
+			SetBlock(a_X, a_Y, a_Z, E_BLOCK_AIR, 0);
+		}
+		return true;
+	}
+
+
+	/** See cFloodyFluidSimulator::SpreadToNeighbor(). */
+	void SpreadToNeighbor(int a_X, int a_Y, int a_Z, NIBBLETYPE a_NewMeta)
+	{
+		BLOCKTYPE BlockType;
+		NIBBLETYPE BlockMeta;
+		if (!GetBlock(a_X, a_Y, a_Z, BlockType, BlockMeta))
+		{
+			return;
+		}
+		if (IsAnyFluidBlock(BlockType) && ((BlockMeta == a_NewMeta) || cFluidSimulator::IsHigherMeta(BlockMeta, a_NewMeta)))
+		{
+			return;
+		}
+		if (IsBlockLava(BlockType))
+		{
+			SetBlock(a_X, a_Y, a_Z, (BlockMeta == 0) ? E_BLOCK_OBSIDIAN : E_BLOCK_COBBLESTONE, 0);
+			return;
+		}
+		if (!IsPassableForFluid(BlockType))
+		{
+			return;
+		}
+
+		// The explicit cSimulator::WakeUp() after the spread is covered by SetBlock()'s block check:
+		SetBlock(a_X, a_Y, a_Z, E_BLOCK_WATER, a_NewMeta);
+	}
+
+
+	/** See cFloodyFluidSimulator::CheckNeighborsForSource(). */
+	bool CheckNeighborsForSource(int a_X, int a_Y, int a_Z)
+	{
+		static const int Coords[][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+		int NumNeeded = m_NumNeighborsForSource;
+		for (const auto & Coord: Coords)
+		{
+			BLOCKTYPE BlockType;
+			NIBBLETYPE BlockMeta;
+			if (!GetBlock(a_X + Coord[0], a_Y, a_Z + Coord[1], BlockType, BlockMeta))
+			{
+				continue;
+			}
+			if ((BlockMeta == 0) && IsAnyFluidBlock(BlockType))
+			{
+				NumNeeded--;
+				if (NumNeeded == 0)
+				{
+					SetBlock(a_X, a_Y, a_Z, E_BLOCK_WATER, 0);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+} ;
+
+
+
+
+
+/** Adds the features that exercise more of the rules into the flooded area: a lava pool, partly flowing,
+that the water turns into obsidian and cobblestone, and a walled trench between two rows of sources, which fills up with new sources. */
+static void AddFeatures(cTestTerrain & a_Terrain)
+{
+	for (int z = 28; z <= 34; z++)
+	{
+		for (int x = 18; x <= 21; x++)
+		{
+			a_Terrain.SetBlock(x, 4, z, E_BLOCK_STATIONARY_LAVA, (x == 21) ? 3 : 0);
+		}
+	}
+
+	for (int z = 40; z <= 46; z++)
+	{
+		for (int x = 26; x <= 30; x++)
+		{
+			bool IsWall = (x == 26) || (x == 30) || (z == 40) || (z == 46);
+			for (int y = 4; y <= 6; y++)
+			{
+				a_Terrain.SetBlock(x, y, z, IsWall ? E_BLOCK_STONE : E_BLOCK_AIR, 0);
+			}
+		}
+	}
+	for (int z = 41; z <= 45; z++)
+	{
+		a_Terrain.SetBlock(27, 4, z, E_BLOCK_WATER, 0);
+		a_Terrain.SetBlock(29, 4, z, E_BLOCK_WATER, 0);
+	}
+}
+
+
+
+
+
+/** Builds a fresh terrain and schedules its water for the simulator. */
+template <typename SimulatorType>
+static void PrepareFlood(cTestTerrain & a_Terrain, SimulatorType & a_Simulator)
+{
+	BuildTerrain(a_Terrain);
+	AddFeatures(a_Terrain);
+	ScheduleReservoir(a_Simulator);
+	for (int z = 41; z <= 45; z++)
+	{
+		a_Simulator.AddBlock(27, 4, z);
+		a_Simulator.AddBlock(29, 4, z);
+	}
+}
+
+
+
+
+
+/** Returns true if the dense flood's block is ahead of the Floody flood's different block: water where Floody has none
+yet, water of a higher level, or water of the same level that has already settled. */
+static bool IsDenseAhead(BLOCKTYPE a_DenseType, NIBBLETYPE a_DenseMeta, BLOCKTYPE a_FloodyType, NIBBLETYPE a_FloodyMeta)
+{
+	if (!IsBlockWater(a_DenseType))
+	{
+		return false;
+	}
+	if (!IsBlockWater(a_FloodyType))
+	{
+		return true;
+	}
+	if (a_DenseMeta != a_FloodyMeta)
+	{
+		return (a_DenseMeta < a_FloodyMeta);
+	}
+	return (a_DenseType == E_BLOCK_STATIONARY_WATER) && (a_FloodyType == E_BLOCK_WATER);
+}
+
+
+
+
+
+/** Compares the floods after the same number of ticks. Returns the number of different blocks.
+Checks that the dense flood is ahead in all of them. */
+static int CompareFloods(const cTestTerrain & a_Dense, const cTestTerrain & a_Floody)
+{
+	int NumDifferent = 0;
+	for (int y = 0; y < SIZE_Y; y++)
+	{
+		for (int z = 0; z < SIZE_Z; z++)
+		{
+			for (int x = 0; x < SIZE_X; x++)
+			{
+				BLOCKTYPE DenseType, FloodyType;
+				NIBBLETYPE DenseMeta, FloodyMeta;
+				a_Dense.GetBlock(x, y, z, DenseType, DenseMeta);
+				a_Floody.GetBlock(x, y, z, FloodyType, FloodyMeta);
+				if ((DenseType == FloodyType) && (DenseMeta == FloodyMeta))
+				{
+					continue;
+				}
+				if (!IsDenseAhead(DenseType, DenseMeta, FloodyType, FloodyMeta))
+				{
+					LOGERROR("{%d, %d, %d}: the dense flood has %d:%d, the Floody flood %d:%d",
+						x, y, z, DenseType, DenseMeta, FloodyType, FloodyMeta
+					);
+				}
+				assert_test(IsDenseAhead(DenseType, DenseMeta, FloodyType, FloodyMeta));
+				NumDifferent += 1;
+			}
+		}
+	}
+	return NumDifferent;
+}
+
+
+
+
+
+/** Returns the number of blocks of the specified type in the terrain. */
+static int CountBlocks(const cTestTerrain & a_Terrain, BLOCKTYPE a_BlockType)
+{
+	int Res = 0;
+	for (int y = 0; y < SIZE_Y; y++)
+	{
+		for (int z = 0; z < SIZE_Z; z++)
+		{
+			for (int x = 0; x < SIZE_X; x++)
+			{
+				BLOCKTYPE BlockType;
+				NIBBLETYPE Meta;
+				a_Terrain.GetBlock(x, y, z, BlockType, Meta);
+				if (BlockType == a_BlockType)
+				{
+					Res += 1;
+				}
+			}
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	std::unique_ptr<cTestTerrain> Dense(new cTestTerrain);
+	PrepareFlood(*Dense, *Dense);
+	std::unique_ptr<cTestTerrain> Floody(new cTestTerrain);
+	cFloodyReference Reference(*Floody);
+	PrepareFlood(*Floody, Reference);
+
+	// Flood both tick by tick, comparing them after each tick:
+	int NumSweeps = -1;
+	int NumTicks = -1;
+	int MaxDifferent = 0;
+	for (int Tick = 0; (NumSweeps < 0) || (NumTicks < 0); Tick++)
+	{
+		assert_test(Tick < MAX_TICKS);
+		if ((NumSweeps < 0) && !Dense->Sweep())
+		{
+			NumSweeps = Tick;
+		}
+		if ((NumTicks < 0) && !Reference.Tick())
+		{
+			NumTicks = Tick;
+		}
+		int NumDifferent = CompareFloods(*Dense, *Floody);
+		MaxDifferent = std::max(MaxDifferent, NumDifferent);
+
+		// By the time the dense flood settles, the Floody flood has caught up and only re-checks the blocks:
+		if (NumSweeps >= 0)
+		{
+			assert_test(NumDifferent == 0);
+		}
+	}
+	LOG("The dense kernel settles after %d sweeps, the Floody rules after %d ticks, with at most %d blocks different after a tick",
+		NumSweeps, NumTicks, MaxDifferent
+	);
+	assert_test(NumSweeps <= NumTicks);
+
+	// Both have settled, the lava has been hit and the basin filled with sources:
+	assert_test(CountBlocks(*Dense, E_BLOCK_WATER) == 0);
+	assert_test(CountBlocks(*Dense, E_BLOCK_OBSIDIAN) > 0);
+	assert_test(CountBlocks(*Dense, E_BLOCK_COBBLESTONE) > 0);
+	assert_test(CountBlocks(*Floody, E_BLOCK_WATER) == 0);
+	BLOCKTYPE BlockType;
+	NIBBLETYPE Meta;
+	Dense->GetBlock(28, 4, 43, BlockType, Meta);
+	assert_test((BlockType == E_BLOCK_STATIONARY_WATER) && (Meta == 0));
+
+	// Into the same blocks:
+	assert_test(Dense->IsSameAs(*Floody));
+
+	LOG("FloodyEquivalenceTest finished");
+	return 0;
+}
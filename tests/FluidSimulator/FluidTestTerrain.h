@@ -0,0 +1,319 @@
+
+// FluidTestTerrain.h
+
+// Declares the cTestTerrain class, the fixed test terrain flooded by the FluidSimulator tests and benchmark
+// The terrain of 4 * 4 chunks holds a reservoir of about 20k water blocks behind a broken dam; the blocks
+// scheduled for simulation are swept section by section, the way cDenseFluidSimulator does.
+
+
+
+
+
+#pragma once
+
+#include "Defines.h"
+#include "Simulator/DenseFluidKernel.h"
+#include "../ChunkData/MockPools.h"
+
+
+
+
+
+/** The size of the test terrain, in chunks and sections. */
+static const int NUM_CHUNKS_X = 4;
+static const int NUM_CHUNKS_Z = 4;
+static const int NUM_SECTIONS = 2;
+
+/** The size of the test terrain, in blocks. */
+static const int SIZE_X = NUM_CHUNKS_X * cChunkDef::Width;
+static const int SIZE_Y = NUM_SECTIONS * cChunkData::SectionHeight;
+static const int SIZE_Z = NUM_CHUNKS_Z * cChunkDef::Width;
+
+/** The X coord of the dam, the reservoir is on its lower X side. */
+static const int DAM_X = 15;
+
+/** The highest Y coord of the water in the reservoir; the floor is below Y = 4. */
+static const int WATER_TOP = 27;
+
+
+
+
+
+/** The test terrain and the masks of the scheduled blocks, with the cDenseFluidSimulator's way of sweeping them. */
+class cTestTerrain
+{
+public:
+	cTestTerrain(void) :
+		m_Kernel(E_BLOCK_WATER, E_BLOCK_STATIONARY_WATER, 1, 2),
+		m_AddSet(0),
+		m_NumSimulated(0)
+	{
+		for (int i = 0; i < NUM_CHUNKS_X * NUM_CHUNKS_Z; i++)
+		{
+			m_Chunks.emplace_back(new cChunkData(m_Pools.m_Sections, m_Pools.m_Nibbles, m_Pools.m_BlockTypes));
+		}
+		m_Masks[0].resize(NUM_CHUNKS_X * NUM_CHUNKS_Z * NUM_SECTIONS);
+		m_Masks[1].resize(NUM_CHUNKS_X * NUM_CHUNKS_Z * NUM_SECTIONS);
+	}
+
+
+	/** Returns true if the specified block is within the terrain. */
+	static bool IsInside(int a_X, int a_Y, int a_Z)
+	{
+		return (a_X >= 0) && (a_X < SIZE_X) && (a_Y >= 0) && (a_Y < SIZE_Y) && (a_Z >= 0) && (a_Z < SIZE_Z);
+	}
+
+
+	void GetBlock(int a_X, int a_Y, int a_Z, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Meta) const
+	{
+		const auto & Chunk = *m_Chunks[ChunkIndex(a_X / cChunkDef::Width, a_Z / cChunkDef::Width)];
+		a_BlockType = Chunk.GetBlock(a_X % cChunkDef::Width, a_Y, a_Z % cChunkDef::Width);
+		a_Meta = Chunk.GetMeta(a_X % cChunkDef::Width, a_Y, a_Z % cChunkDef::Width);
+	}
+
+
+	void SetBlock(int a_X, int a_Y, int a_Z, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta)
+	{
+		auto & Chunk = *m_Chunks[ChunkIndex(a_X / cChunkDef::Width, a_Z / cChunkDef::Width)];
+		Chunk.SetBlock(a_X % cChunkDef::Width, a_Y, a_Z % cChunkDef::Width, a_BlockType);
+		Chunk.SetMeta(a_X % cChunkDef::Width, a_Y, a_Z % cChunkDef::Width, a_Meta);
+	}
+
+
+	/** Returns true if both terrains have the same blocks and metas. */
+	bool IsSameAs(const cTestTerrain & a_Other) const
+	{
+		std::vector<BLOCKTYPE> BlockTypes(cChunkDef::NumBlocks), OtherBlockTypes(cChunkDef::NumBlocks);
+		std::vector<NIBBLETYPE> Metas(cChunkDef::NumBlocks / 2), OtherMetas(cChunkDef::NumBlocks / 2);
+		for (size_t i = 0; i < m_Chunks.size(); i++)
+		{
+			m_Chunks[i]->CopyBlockTypes(BlockTypes.data());
+			a_Other.m_Chunks[i]->CopyBlockTypes(OtherBlockTypes.data());
+			m_Chunks[i]->CopyMetas(Metas.data());
+			a_Other.m_Chunks[i]->CopyMetas(OtherMetas.data());
+			if ((BlockTypes != OtherBlockTypes) || (Metas != OtherMetas))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	/** Schedules the block for simulation, if it's flowing water, the way cDenseFluidSimulator::AddBlock() does. */
+	void AddBlock(int a_X, int a_Y, int a_Z)
+	{
+		if (!IsInside(a_X, a_Y, a_Z))
+		{
+			return;
+		}
+		BLOCKTYPE BlockType;
+		NIBBLETYPE Meta;
+		GetBlock(a_X, a_Y, a_Z, BlockType, Meta);
+		if (BlockType != E_BLOCK_WATER)
+		{
+			return;
+		}
+		m_Masks[m_AddSet][SectionIndex(a_X / cChunkDef::Width, a_Y / cChunkData::SectionHeight, a_Z / cChunkDef::Width)].Set(
+			a_X % cChunkDef::Width, a_Y % cChunkData::SectionHeight, a_Z % cChunkDef::Width
+		);
+	}
+
+
+	/** Sweeps all the scheduled blocks once. Returns false if there were no blocks scheduled. */
+	bool Sweep(void)
+	{
+		int SweepSet = m_AddSet;
+		m_AddSet = 1 - m_AddSet;
+		bool HasSwept = false;
+		for (int ChunkX = 0; ChunkX < NUM_CHUNKS_X; ChunkX++)
+		{
+			for (int ChunkZ = 0; ChunkZ < NUM_CHUNKS_Z; ChunkZ++)
+			{
+				for (int SectionY = 0; SectionY < NUM_SECTIONS; SectionY++)
+				{
+					auto & Mask = m_Masks[SweepSet][SectionIndex(ChunkX, SectionY, ChunkZ)];
+					if (Mask.IsEmpty())
+					{
+						continue;
+					}
+					HasSwept = true;
+					m_NumSimulated += Mask.Count();
+					SweepSection(ChunkX, SectionY, ChunkZ, Mask);
+					Mask.Clear();
+				}
+			}
+		}
+		return HasSwept;
+	}
+
+
+	/** Returns the number of blocks simulated so far. */
+	long long GetNumSimulated(void) const { return m_NumSimulated; }
+
+protected:
+
+	cDenseFluidKernel m_Kernel;
+
+	/** The pools of the chunks' data, outliving the chunks. */
+	cMockChunkDataPools m_Pools;
+
+	/** The chunks, see ChunkIndex(). All-air sections are not stored, as in the server's chunks. */
+	std::vector<std::unique_ptr<cChunkData>> m_Chunks;
+
+	/** The two sets of masks of the scheduled blocks, one mask per section, see cDenseFluidSimulator. */
+	std::vector<cDenseFluidKernel::cDirtyMask> m_Masks[2];
+
+	/** The set of masks into which the new blocks are added. */
+	int m_AddSet;
+
+	cDenseFluidKernel::cWindow m_Window;
+	cDenseFluidKernel::cChanges m_Changes;
+
+	long long m_NumSimulated;
+
+
+	static size_t SectionIndex(int a_ChunkX, int a_SectionY, int a_ChunkZ)
+	{
+		return static_cast<size_t>(a_SectionY + NUM_SECTIONS * (a_ChunkZ + NUM_CHUNKS_Z * a_ChunkX));
+	}
+
+
+	static size_t ChunkIndex(int a_ChunkX, int a_ChunkZ)
+	{
+		return static_cast<size_t>(a_ChunkZ + NUM_CHUNKS_Z * a_ChunkX);
+	}
+
+
+	/** Returns the section, or nullptr if it is all air. */
+	const cChunkData::sChunkSection * GetSection(int a_ChunkX, int a_SectionY, int a_ChunkZ) const
+	{
+		return m_Chunks[ChunkIndex(a_ChunkX, a_ChunkZ)]->GetSection(static_cast<size_t>(a_SectionY));
+	}
+
+
+	/** Wakes up the block and its neighbors, the way cSimulator::WakeUp() does. */
+	void WakeUp(int a_X, int a_Y, int a_Z)
+	{
+		AddBlock(a_X, a_Y, a_Z);
+		AddBlock(a_X - 1, a_Y, a_Z);
+		AddBlock(a_X + 1, a_Y, a_Z);
+		AddBlock(a_X, a_Y - 1, a_Z);
+		AddBlock(a_X, a_Y + 1, a_Z);
+		AddBlock(a_X, a_Y, a_Z - 1);
+		AddBlock(a_X, a_Y, a_Z + 1);
+	}
+
+
+	/** Wakes up the neighborhood of a block set by cChunk::SetBlock(): it queues the block and its neighbors
+	for the block check (cChunk::CheckBlocks()), which wakes up the simulators for each of them. */
+	void WakeUpChecked(int a_X, int a_Y, int a_Z)
+	{
+		WakeUp(a_X, a_Y, a_Z);
+		WakeUp(a_X - 1, a_Y, a_Z);
+		WakeUp(a_X + 1, a_Y, a_Z);
+		WakeUp(a_X, a_Y - 1, a_Z);
+		WakeUp(a_X, a_Y + 1, a_Z);
+		WakeUp(a_X, a_Y, a_Z - 1);
+		WakeUp(a_X, a_Y, a_Z + 1);
+	}
+
+
+	void SweepSection(int a_ChunkX, int a_SectionY, int a_ChunkZ, const cDenseFluidKernel::cDirtyMask & a_Mask)
+	{
+		// The neighbors in the order of cDenseFluidKernel::eFace; those outside the terrain are unavailable:
+		static const int Offsets[][3] =
+		{
+			{ -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 },
+		};
+		cDenseFluidKernel::sNeighborhood Neighborhood;
+		Neighborhood.m_Center = GetSection(a_ChunkX, a_SectionY, a_ChunkZ);
+		for (size_t i = 0; i < ARRAYCOUNT(Offsets); i++)
+		{
+			int x = a_ChunkX + Offsets[i][0];
+			int y = a_SectionY + Offsets[i][1];
+			int z = a_ChunkZ + Offsets[i][2];
+			Neighborhood.m_IsAvailable[i] = (x >= 0) && (x < NUM_CHUNKS_X) && (y >= 0) && (y < NUM_SECTIONS) && (z >= 0) && (z < NUM_CHUNKS_Z);
+			Neighborhood.m_Neighbors[i] = Neighborhood.m_IsAvailable[i] ? GetSection(x, y, z) : nullptr;
+		}
+
+		m_Kernel.FillWindow(m_Window, a_SectionY * cChunkData::SectionHeight, a_Mask, Neighborhood);
+		m_Changes.clear();
+		m_Kernel.Sweep(m_Window, a_Mask, m_Changes);
+
+		// Write the changes back the way cDenseFluidSimulator does. All but the processed blocks are set with
+		// cChunk::SetBlock(), whose block check wakes up the neighborhood; the spread blocks are also woken up explicitly,
+		// which the block check covers:
+		for (const auto & Change: m_Changes)
+		{
+			int x = a_ChunkX * cChunkDef::Width + Change.m_RelX;
+			int y = a_SectionY * cChunkData::SectionHeight + Change.m_RelY;
+			int z = a_ChunkZ * cChunkDef::Width + Change.m_RelZ;
+			SetBlock(x, y, z, Change.m_BlockType, Change.m_Meta);
+			if (Change.m_Kind != cDenseFluidKernel::ckProcessed)
+			{
+				WakeUpChecked(x, y, z);
+			}
+		}
+	}
+} ;
+
+
+
+
+
+/** Builds the test terrain: a stone floor and walls, a reservoir of water behind a dam, tall grass and pillars in the flooded area.
+The dam is already broken, the reservoir isn't scheduled yet, see ScheduleReservoir(). */
+inline void BuildTerrain(cTestTerrain & a_Terrain)
+{
+	for (int x = 0; x < SIZE_X; x++)
+	{
+		for (int z = 0; z < SIZE_Z; z++)
+		{
+			for (int y = 0; y < SIZE_Y; y++)
+			{
+				bool IsWall = ((x == 0) || (x == SIZE_X - 1) || (z == 0) || (z == SIZE_Z - 1)) && (y <= WATER_TOP + 1);
+				if ((y < 4) || IsWall)
+				{
+					a_Terrain.SetBlock(x, y, z, E_BLOCK_STONE, 0);
+				}
+				else if ((x < DAM_X) && (y <= WATER_TOP))
+				{
+					a_Terrain.SetBlock(x, y, z, E_BLOCK_WATER, 0);
+				}
+				else if ((x > DAM_X) && (y < 12) && (x % 8 == 0) && (z % 8 == 0))
+				{
+					a_Terrain.SetBlock(x, y, z, E_BLOCK_STONE, 0);
+				}
+				else if ((x > DAM_X) && (y == 4) && ((x + z) % 5 == 0))
+				{
+					a_Terrain.SetBlock(x, y, z, E_BLOCK_TALL_GRASS, 1);
+				}
+			}
+		}
+	}
+}
+
+
+
+
+
+/** Schedules the whole reservoir for simulation, as if it was just placed, using a_Simulator's AddBlock(). */
+template <typename SimulatorType>
+void ScheduleReservoir(SimulatorType & a_Simulator)
+{
+	for (int x = 1; x < DAM_X; x++)
+	{
+		for (int z = 1; z < SIZE_Z - 1; z++)
+		{
+			for (int y = 4; y <= WATER_TOP; y++)
+			{
+				a_Simulator.AddBlock(x, y, z);
+			}
+		}
+	}
+}
+
+
+
+
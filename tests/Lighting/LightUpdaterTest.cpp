@@ -0,0 +1,294 @@
+
+// LightUpdaterTest.cpp
+
+// Implements the test that checks the light updated incrementally by cLightUpdater against the full relight by cLightCalculator
+
+#include "Globals.h"
+#include "BlockID.h"
+#include "ChunkData.h"
+#include "LightCalculator.h"
+#include "LightUpdater.h"
+#include "../ChunkData/MockPools.h"
+
+
+
+
+
+/** The number of chunks of the test terrain in each direction.
+Only the inner 3x3 chunks are lit, each by a full relight of its own 3x3 neighborhood; the blocks are changed
+in the middle chunk only, so that the updater's 3x3 chunks are exactly the lit ones. */
+static const int NUM_CHUNKS = 5;
+
+/** The coords of the middle chunk's first block, in which all the blocks are changed. */
+static const int MID = 2 * cChunkDef::Width;
+
+
+
+
+
+/** A terrain of NUM_CHUNKS * NUM_CHUNKS chunks, lit the same way the server lights its chunks. */
+class cTestTerrain
+{
+public:
+
+	cTestTerrain(void):
+		m_Calculator(new cLightCalculator)
+	{
+		for (int i = 0; i < NUM_CHUNKS * NUM_CHUNKS; i++)
+		{
+			m_Chunks.emplace_back(new cChunkData(m_Pools.m_Sections, m_Pools.m_Nibbles, m_Pools.m_BlockTypes));
+		}
+		memset(m_HeightMaps, 0, sizeof(m_HeightMaps));
+	}
+
+	/** Fills the specified box (inclusive, absolute block coords) with the block, without updating the light.
+	Used for building the terrain before it is lit. */
+	void Fill(int a_MinX, int a_MinY, int a_MinZ, int a_MaxX, int a_MaxY, int a_MaxZ, BLOCKTYPE a_BlockType)
+	{
+		for (int y = a_MinY; y <= a_MaxY; y++)
+		{
+			for (int z = a_MinZ; z <= a_MaxZ; z++)
+			{
+				for (int x = a_MinX; x <= a_MaxX; x++)
+				{
+					GetChunk(x, z).SetBlock(x % cChunkDef::Width, y, z % cChunkDef::Width, a_BlockType);
+					UpdateHeight(x, y, z, a_BlockType);
+				}
+			}
+		}
+	}
+
+	/** Lights the inner 3x3 chunks by the full relight. */
+	void LightAll(void)
+	{
+		cChunkDef::BlockNibbles BlockLight, SkyLight;
+		for (int z = 1; z < NUM_CHUNKS - 1; z++)
+		{
+			for (int x = 1; x < NUM_CHUNKS - 1; x++)
+			{
+				Relight(x, z, BlockLight, SkyLight);
+				m_Chunks[static_cast<size_t>(x + z * NUM_CHUNKS)]->SetBlockLight(BlockLight);
+				m_Chunks[static_cast<size_t>(x + z * NUM_CHUNKS)]->SetSkyLight(SkyLight);
+			}
+		}
+	}
+
+	/** Changes the block at the specified absolute coords, which must be in the middle chunk, and updates the light
+	the same way cChunk::FastSetBlock() does. Checks that the updater reports exactly the chunks whose light has changed. */
+	void ChangeBlock(int a_X, int a_Y, int a_Z, BLOCKTYPE a_BlockType)
+	{
+		int RelX = a_X - MID;
+		int RelZ = a_Z - MID;
+		assert_test((RelX >= 0) && (RelX < cChunkDef::Width) && (RelZ >= 0) && (RelZ < cChunkDef::Width));
+
+		// Remember the light before the change:
+		cChunkData * Chunks[3][3];
+		std::vector<NIBBLETYPE> OldLight(9 * 2 * cChunkDef::NumBlocks / 2);
+		for (int x = 0; x < 3; x++)
+		{
+			for (int z = 0; z < 3; z++)
+			{
+				Chunks[x][z] = m_Chunks[static_cast<size_t>(x + 1 + (z + 1) * NUM_CHUNKS)].get();
+				size_t Offset = static_cast<size_t>(x + z * 3) * cChunkDef::NumBlocks;
+				Chunks[x][z]->CopyBlockLight(OldLight.data() + Offset);
+				Chunks[x][z]->CopySkyLight(OldLight.data() + Offset + cChunkDef::NumBlocks / 2);
+			}
+		}
+
+		cChunkData & Chunk = *Chunks[1][1];
+		BLOCKTYPE OldBlockType = Chunk.GetBlock(RelX, a_Y, RelZ);
+		Chunk.SetBlock(RelX, a_Y, RelZ, a_BlockType);
+		cLightUpdater Updater(Chunks);
+		Updater.BlockChanged(RelX, a_Y, RelZ, OldBlockType);
+		UpdateHeight(a_X, a_Y, a_Z, a_BlockType);
+
+		// Only the chunks reported as changed may have changed:
+		std::vector<NIBBLETYPE> NewLight(cChunkDef::NumBlocks);
+		for (int x = 0; x < 3; x++)
+		{
+			for (int z = 0; z < 3; z++)
+			{
+				Chunks[x][z]->CopyBlockLight(NewLight.data());
+				Chunks[x][z]->CopySkyLight(NewLight.data() + cChunkDef::NumBlocks / 2);
+				size_t Offset = static_cast<size_t>(x + z * 3) * cChunkDef::NumBlocks;
+				bool HasChanged = (memcmp(OldLight.data() + Offset, NewLight.data(), NewLight.size()) != 0);
+				assert_test(HasChanged == Updater.HasChanged(x, z));
+			}
+		}
+	}
+
+	/** Checks that the light of each inner chunk is byte-identical to the light the full relight calculates. */
+	void CheckLight(const char * a_Step)
+	{
+		cChunkDef::BlockNibbles BlockLight, SkyLight;
+		cChunkDef::BlockNibbles ChunkBlockLight, ChunkSkyLight;
+		for (int z = 1; z < NUM_CHUNKS - 1; z++)
+		{
+			for (int x = 1; x < NUM_CHUNKS - 1; x++)
+			{
+				Relight(x, z, BlockLight, SkyLight);
+				const cChunkData & Chunk = *m_Chunks[static_cast<size_t>(x + z * NUM_CHUNKS)];
+				Chunk.CopyBlockLight(ChunkBlockLight);
+				Chunk.CopySkyLight(ChunkSkyLight);
+				ReportDifference(a_Step, "blocklight", x, z, BlockLight, ChunkBlockLight);
+				ReportDifference(a_Step, "skylight", x, z, SkyLight, ChunkSkyLight);
+				assert_test(memcmp(BlockLight, ChunkBlockLight, sizeof(BlockLight)) == 0);
+				assert_test(memcmp(SkyLight, ChunkSkyLight, sizeof(SkyLight)) == 0);
+			}
+		}
+	}
+
+protected:
+
+	cMockChunkDataPools m_Pools;
+
+	/** The chunks, indexed by x + z * NUM_CHUNKS. */
+	std::vector<std::unique_ptr<cChunkData>> m_Chunks;
+
+	/** The heightmaps of the chunks, maintained the same way cChunk maintains its heightmap. */
+	cChunkDef::HeightMap m_HeightMaps[NUM_CHUNKS * NUM_CHUNKS];
+
+	/** The full relight calculator; too large for the stack. */
+	std::unique_ptr<cLightCalculator> m_Calculator;
+
+
+	cChunkData & GetChunk(int a_X, int a_Z)
+	{
+		return *m_Chunks[static_cast<size_t>(a_X / cChunkDef::Width + (a_Z / cChunkDef::Width) * NUM_CHUNKS)];
+	}
+
+	/** Updates the heightmap after the block at the specified absolute coords has been set, same as cChunk::FastSetBlock(). */
+	void UpdateHeight(int a_X, int a_Y, int a_Z, BLOCKTYPE a_BlockType)
+	{
+		cChunkDef::HeightMap & HeightMap = m_HeightMaps[static_cast<size_t>(a_X / cChunkDef::Width + (a_Z / cChunkDef::Width) * NUM_CHUNKS)];
+		int RelX = a_X % cChunkDef::Width;
+		int RelZ = a_Z % cChunkDef::Width;
+		if (a_Y < cChunkDef::GetHeight(HeightMap, RelX, RelZ))
+		{
+			return;
+		}
+		if (a_BlockType != E_BLOCK_AIR)
+		{
+			cChunkDef::SetHeight(HeightMap, RelX, RelZ, static_cast<HEIGHTTYPE>(a_Y));
+			return;
+		}
+		for (int y = a_Y - 1; y > 0; --y)
+		{
+			if (GetChunk(a_X, a_Z).GetBlock(RelX, y, RelZ) != E_BLOCK_AIR)
+			{
+				cChunkDef::SetHeight(HeightMap, RelX, RelZ, static_cast<HEIGHTTYPE>(y));
+				break;
+			}
+		}
+	}
+
+	/** Calculates the light of the specified chunk from its 3x3 neighborhood, the same way cLightingThread does. */
+	void Relight(int a_ChunkX, int a_ChunkZ, cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight)
+	{
+		m_Calculator->Reset();
+		for (int z = 0; z < 3; z++)
+		{
+			for (int x = 0; x < 3; x++)
+			{
+				size_t Idx = static_cast<size_t>(a_ChunkX + x - 1 + (a_ChunkZ + z - 1) * NUM_CHUNKS);
+				m_Calculator->ReadHeightMap(x, z, m_HeightMaps[Idx]);
+				m_Calculator->ReadBlockTypes(x, z, *m_Chunks[Idx]);
+			}
+		}
+		m_Calculator->CalcLight(a_BlockLight, a_SkyLight);
+	}
+
+	/** Logs the first block whose light differs, to make the failures easier to investigate. */
+	static void ReportDifference(const char * a_Step, const char * a_Kind, int a_ChunkX, int a_ChunkZ, const NIBBLETYPE * a_Expected, const NIBBLETYPE * a_Actual)
+	{
+		for (int i = 0; i < cChunkDef::NumBlocks; i++)
+		{
+			NIBBLETYPE Expected = (a_Expected[i / 2] >> ((i & 1) * 4)) & 0x0f;
+			NIBBLETYPE Actual = (a_Actual[i / 2] >> ((i & 1) * 4)) & 0x0f;
+			if (Expected != Actual)
+			{
+				Vector3i Pos = cChunkDef::IndexToCoordinate(static_cast<unsigned>(i));
+				LOGWARNING("%s: the %s at {%d, %d, %d} is %d, the full relight gives %d",
+					a_Step, a_Kind,
+					a_ChunkX * cChunkDef::Width + Pos.x, Pos.y, a_ChunkZ * cChunkDef::Width + Pos.z,
+					Actual, Expected
+				);
+				return;
+			}
+		}
+	}
+} ;
+
+
+
+
+
+/** Changes the block and checks the light against the full relight. */
+static void ChangeAndCheck(cTestTerrain & a_Terrain, const char * a_Step, int a_X, int a_Y, int a_Z, BLOCKTYPE a_BlockType)
+{
+	a_Terrain.ChangeBlock(a_X, a_Y, a_Z, a_BlockType);
+	a_Terrain.CheckLight(a_Step);
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	// The ground's surface crosses a section border (y = 31 / 32), a cave below spans several chunks.
+	// A stone pillar is the highest block of the area until a torch is placed on its top:
+	std::unique_ptr<cTestTerrain> Terrain(new cTestTerrain);
+	const int Max = NUM_CHUNKS * cChunkDef::Width - 1;
+	Terrain->Fill(0, 0, 0, Max, 31, Max, E_BLOCK_STONE);
+	Terrain->Fill(20, 20, 20, 60, 27, 60, E_BLOCK_AIR);
+	Terrain->Fill(44, 32, 36, 44, 40, 36, E_BLOCK_STONE);
+	Terrain->LightAll();
+	Terrain->CheckLight("Initial light");
+
+	LOGD("Testing a light source at the chunk corner");
+	ChangeAndCheck(*Terrain, "Glowstone placed", MID, 21, MID, E_BLOCK_GLOWSTONE);
+	ChangeAndCheck(*Terrain, "Glowstone removed", MID, 21, MID, E_BLOCK_AIR);
+
+	LOGD("Testing the skylight coming down a shaft into the cave");
+	for (int y = 31; y >= 28; y--)
+	{
+		ChangeAndCheck(*Terrain, "Shaft dug", 40, y, 40, E_BLOCK_AIR);
+	}
+	ChangeAndCheck(*Terrain, "Glass placed in the shaft", 40, 31, 40, E_BLOCK_GLASS);
+	ChangeAndCheck(*Terrain, "Roof placed", 40, 35, 40, E_BLOCK_STONE);
+	ChangeAndCheck(*Terrain, "Roof removed", 40, 35, 40, E_BLOCK_AIR);
+	ChangeAndCheck(*Terrain, "Glass removed", 40, 31, 40, E_BLOCK_AIR);
+
+	LOGD("Testing a light source on the highest block");
+	ChangeAndCheck(*Terrain, "Torch placed on the pillar", 44, 41, 36, E_BLOCK_TORCH);
+	ChangeAndCheck(*Terrain, "Torch removed from the pillar", 44, 41, 36, E_BLOCK_AIR);
+
+	LOGD("Testing the light across the section and chunk borders");
+	ChangeAndCheck(*Terrain, "Torch placed on the ground", 45, 32, 45, E_BLOCK_TORCH);
+	ChangeAndCheck(*Terrain, "Leaves placed at the chunk border", 47, 32, 40, E_BLOCK_LEAVES);
+	ChangeAndCheck(*Terrain, "Ground dug at the section border", 47, 31, 40, E_BLOCK_AIR);
+	ChangeAndCheck(*Terrain, "Torch removed from the ground", 45, 32, 45, E_BLOCK_AIR);
+	ChangeAndCheck(*Terrain, "Leaves removed", 47, 32, 40, E_BLOCK_AIR);
+
+	LOGD("Testing the light through water");
+	for (int z = 43; z <= 46; z++)
+	{
+		for (int x = 33; x <= 36; x++)
+		{
+			ChangeAndCheck(*Terrain, "Pond dug", x, 31, z, E_BLOCK_STATIONARY_WATER);
+		}
+	}
+	ChangeAndCheck(*Terrain, "Pond deepened into the cave", 35, 28, 44, E_BLOCK_AIR);
+	ChangeAndCheck(*Terrain, "Pond deepened into the cave", 35, 29, 44, E_BLOCK_AIR);
+	ChangeAndCheck(*Terrain, "Pond deepened into the cave", 35, 30, 44, E_BLOCK_STATIONARY_WATER);
+
+	LOG("LightUpdater test finished");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,51 @@
+
+// Stubs.cpp
+
+// Implements stubs of various Cuberite methods that are needed for linking but not for runtime
+// This is required so that we don't bring in the entire Cuberite via dependencies
+
+#include "Globals.h"
+#include "BlockInfo.h"
+
+
+
+
+
+void cBlockInfo::sHandlerDeleter::operator () (cBlockHandler * a_Handler)
+{
+	// The tests don't create any handlers
+	UNUSED(a_Handler);
+	ASSERT(a_Handler == nullptr);
+}
+
+
+
+
+
+cBlockInfo::cBlockInfoArray::cBlockInfoArray()
+{
+	cBlockInfoArray & Info = *this;
+
+	// Only the light properties of the blocks used by the tests, same values as in the server's BlockInfo.cpp:
+	Info[E_BLOCK_GLOWSTONE       ].m_LightValue = 15;
+	Info[E_BLOCK_TORCH           ].m_LightValue = 14;
+
+	Info[E_BLOCK_AIR             ].m_SpreadLightFalloff = 1;
+	Info[E_BLOCK_GLASS           ].m_SpreadLightFalloff = 1;
+	Info[E_BLOCK_LEAVES          ].m_SpreadLightFalloff = 1;
+	Info[E_BLOCK_TORCH           ].m_SpreadLightFalloff = 1;
+	Info[E_BLOCK_STATIONARY_WATER].m_SpreadLightFalloff = 3;
+
+	Info[E_BLOCK_AIR             ].m_Transparent = true;
+	Info[E_BLOCK_GLASS           ].m_Transparent = true;
+	Info[E_BLOCK_GLOWSTONE       ].m_Transparent = true;
+	Info[E_BLOCK_LEAVES          ].m_Transparent = true;
+	Info[E_BLOCK_STATIONARY_WATER].m_Transparent = true;
+	Info[E_BLOCK_TORCH           ].m_Transparent = true;
+
+	Info[E_BLOCK_LEAVES          ].m_IsSkylightDispersant = true;
+}
+
+
+
+
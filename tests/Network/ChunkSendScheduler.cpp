@@ -0,0 +1,168 @@
+
+// ChunkSendScheduler.cpp
+
+// Implements a test of the cChunkSendScheduler pacing the chunks over a simulated connection
+// The connection drains a fixed number of bytes per second; the test checks that the scheduler finds the bandwidth
+// and keeps the data queued in the link within its budget, and that chunks slow to generate don't stall the streaming
+
+#include "Globals.h"
+#include "ChunkSendScheduler.h"
+
+
+
+
+
+/** The simulated tick length. */
+static const std::chrono::milliseconds TICK_LENGTH(50);
+
+/** The size of each simulated chunk. */
+static const size_t CHUNK_SIZE = 12 KiB;
+
+/** The maximum number of chunks requested per tick, the same as the client handle's limit. */
+static const size_t MAX_REQUESTS_PER_TICK = 16;
+
+
+
+
+
+/** The results of a single simulation run. */
+struct sSimResult
+{
+	/** The largest amount of data queued in the link during the second half of the run. */
+	size_t m_MaxLinkBuffer;
+
+	/** The number of bytes the connection delivered during the second half of the run. */
+	size_t m_NumDrainedLate;
+};
+
+
+
+
+
+/** Runs the scheduler against a connection with the specified bandwidth (bytes per second) and base round trip time for the specified number of ticks.
+Each chunk requested is queued a_GenerationTicks ticks later (1 for the chunks already loaded). */
+static sSimResult Simulate(cChunkSendScheduler & a_Scheduler, size_t a_Bandwidth, std::chrono::milliseconds a_BaseRtt, int a_NumTicks, int a_GenerationTicks = 1)
+{
+	auto Now = std::chrono::steady_clock::now();
+	size_t LinkBuffer = 0;
+	std::vector<size_t> NumReady(static_cast<size_t>(a_NumTicks + a_GenerationTicks), 0);  // The number of chunks getting ready in each tick
+	sSimResult Res = {0, 0};
+	size_t DrainPerTick = a_Bandwidth * static_cast<size_t>(TICK_LENGTH.count()) / 1000;
+	for (int i = 0; i < a_NumTicks; i++)
+	{
+		// The connection drains the link:
+		size_t Drained = std::min(LinkBuffer, DrainPerTick);
+		LinkBuffer -= Drained;
+		if (i > a_NumTicks / 2)
+		{
+			Res.m_NumDrainedLate += Drained;
+		}
+
+		// The chunks generated by now are queued and get flushed:
+		size_t Ready = NumReady[static_cast<size_t>(i)];
+		size_t Flushed = Ready * CHUNK_SIZE;
+		for (size_t c = 0; c < Ready; c++)
+		{
+			a_Scheduler.OnChunkQueued(CHUNK_SIZE);
+		}
+		a_Scheduler.OnFlush(Now, LinkBuffer, Flushed);
+		LinkBuffer += Flushed;
+		if (i > a_NumTicks / 2)
+		{
+			Res.m_MaxLinkBuffer = std::max(Res.m_MaxLinkBuffer, LinkBuffer);
+		}
+
+		// A keep-alive comes back once per second, delayed by the data queued before it:
+		if (i % 20 == 0)
+		{
+			auto QueueDelay = std::chrono::milliseconds(1000 * LinkBuffer / a_Bandwidth);
+			a_Scheduler.OnRttSample(a_BaseRtt + QueueDelay);
+		}
+
+		// Request chunks while the scheduler allows:
+		for (size_t r = 0; (r < MAX_REQUESTS_PER_TICK) && a_Scheduler.CanRequestChunk(); r++)
+		{
+			NumReady[static_cast<size_t>(i + a_GenerationTicks)] += 1;
+		}
+		Now += TICK_LENGTH;
+	}
+	return Res;
+}
+
+
+
+
+
+/** Checks the scheduler on a slow connection: it must not queue much more than the budget. */
+static void TestSlowConnection(void)
+{
+	LOG("Testing a slow connection...");
+	const size_t Bandwidth = 100 KiB;
+	cChunkSendScheduler Scheduler;
+	auto MaxLinkBuffer = Simulate(Scheduler, Bandwidth, std::chrono::milliseconds(100), 1200).m_MaxLinkBuffer;
+	LOG("Bandwidth estimate %.0f, budget %u, max link buffer %u",
+		Scheduler.GetBandwidth(), static_cast<unsigned>(Scheduler.GetBudget()), static_cast<unsigned>(MaxLinkBuffer)
+	);
+	assert_test(Scheduler.GetBandwidth() > Bandwidth / 2);
+	assert_test(Scheduler.GetBandwidth() < Bandwidth * 2);
+	assert_test(MaxLinkBuffer <= Scheduler.GetBudget() + MAX_REQUESTS_PER_TICK * CHUNK_SIZE);
+	assert_test(Scheduler.GetMinRtt() >= std::chrono::milliseconds(50));
+	assert_test(Scheduler.GetQueuedChunkBytes() <= MaxLinkBuffer + MAX_REQUESTS_PER_TICK * CHUNK_SIZE);
+}
+
+
+
+
+
+/** Checks the scheduler on a fast connection: the estimate must grow so that the budget doesn't hold the streaming back. */
+static void TestFastConnection(void)
+{
+	LOG("Testing a fast connection...");
+	const size_t Bandwidth = 50 MiB;
+	cChunkSendScheduler Scheduler;
+	Simulate(Scheduler, Bandwidth, std::chrono::milliseconds(1), 200);
+	LOG("Bandwidth estimate %.0f, budget %u", Scheduler.GetBandwidth(), static_cast<unsigned>(Scheduler.GetBudget()));
+	assert_test(Scheduler.GetBandwidth() >= MAX_REQUESTS_PER_TICK * CHUNK_SIZE * 20);  // At least the chunks requested at the maximum rate
+	assert_test(Scheduler.GetBudget() > cChunkSendScheduler::MIN_BUDGET);
+	assert_test(Scheduler.GetQueuedChunkBytes() <= MAX_REQUESTS_PER_TICK * CHUNK_SIZE);
+}
+
+
+
+
+
+/** Checks the scheduler with chunks that take a second to generate: the chunks being generated must not count against
+the budget, the connection must still be kept busy. */
+static void TestSlowGenerator(void)
+{
+	LOG("Testing a slow generator...");
+	const size_t Bandwidth = 200 KiB;
+	const int NumTicks = 1200;
+	cChunkSendScheduler Scheduler;
+	auto Res = Simulate(Scheduler, Bandwidth, std::chrono::milliseconds(50), NumTicks, 20);
+	double Utilization = static_cast<double>(Res.m_NumDrainedLate) / (static_cast<double>(Bandwidth) * (NumTicks / 2 - 1) * TICK_LENGTH.count() / 1000);
+	LOG("Bandwidth estimate %.0f, budget %u, connection utilization %.1f %%",
+		Scheduler.GetBandwidth(), static_cast<unsigned>(Scheduler.GetBudget()), 100 * Utilization
+	);
+	assert_test(Utilization > 0.9);
+}
+
+
+
+
+
+int main()
+{
+	LOGD("Test started");
+
+	TestSlowConnection();
+	TestFastConnection();
+	TestSlowGenerator();
+
+	LOG("ChunkSendScheduler test finished");
+	return 0;
+}
+
+
+
+
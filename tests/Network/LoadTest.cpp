@@ -0,0 +1,366 @@
+
+// LoadTest.cpp
+
+// Implements a loopback load test of the LibEvent-based cNetwork API
+// Opens many connections to an in-process echo server and measures the connect and echo latencies
+// Usage: LoadTest [<NumConnections> [<NumEventLoops> [<NumPings>]]]
+
+#include "Globals.h"
+#include <thread>
+#include "OSSupport/Event.h"
+#include "OSSupport/Network.h"
+#include "OSSupport/NetworkSingleton.h"
+
+#ifndef _WIN32
+	#include <sys/resource.h>
+#endif
+
+
+
+
+
+/** The port on which the echo server listens. */
+static const UInt16 TEST_PORT = 9877;
+
+/** The maximum number of connections that are being connected at the same time. */
+static const int MAX_PENDING_CONNECTS = 128;
+
+/** The size of a single ping message. */
+static const size_t PING_SIZE = 16;
+
+
+
+
+
+/** Collects latency samples from multiple threads and reports their percentiles. */
+class cLatencyStats
+{
+public:
+	void Add(std::chrono::steady_clock::time_point a_Start)
+	{
+		double Msec = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(std::chrono::steady_clock::now() - a_Start).count();
+		cCSLock Lock(m_CS);
+		m_Samples.push_back(Msec);
+	}
+
+	void Report(const char * a_Name)
+	{
+		cCSLock Lock(m_CS);
+		if (m_Samples.empty())
+		{
+			LOG("%s: no samples", a_Name);
+			return;
+		}
+		std::sort(m_Samples.begin(), m_Samples.end());
+		auto Percentile = [this](double a_Percent)
+		{
+			size_t Idx = static_cast<size_t>(a_Percent / 100 * static_cast<double>(m_Samples.size() - 1));
+			return m_Samples[Idx];
+		};
+		LOG("%s: %u samples, p50 %.3f msec, p90 %.3f msec, p99 %.3f msec, max %.3f msec",
+			a_Name, static_cast<unsigned>(m_Samples.size()),
+			Percentile(50), Percentile(90), Percentile(99), m_Samples.back()
+		);
+	}
+
+protected:
+	cCriticalSection m_CS;
+	std::vector<double> m_Samples;
+};
+
+
+
+
+
+/** The state shared by all the clients of a single test run. */
+struct sLoadTest
+{
+	cLatencyStats m_ConnectLatency;
+	cLatencyStats m_EchoLatency;
+
+	/** The number of connections that have been requested but haven't connected yet. */
+	std::atomic<int> m_NumPendingConnects;
+
+	/** The number of clients that haven't finished yet, either successfully or by an error. */
+	std::atomic<int> m_NumRemaining;
+
+	/** The number of clients that have failed. */
+	std::atomic<int> m_NumFailed;
+
+	/** Set when m_NumRemaining reaches zero. */
+	cEvent m_Done;
+
+	sLoadTest(int a_NumConnections):
+		m_NumPendingConnects(0),
+		m_NumRemaining(a_NumConnections),
+		m_NumFailed(0)
+	{
+	}
+
+	void ClientFinished(bool a_HasFailed)
+	{
+		if (a_HasFailed)
+		{
+			m_NumFailed += 1;
+		}
+		if (--m_NumRemaining == 0)
+		{
+			m_Done.Set();
+		}
+	}
+};
+
+
+
+
+
+/** cTCPLink callbacks for the server side, echoing everything back. */
+class cEchoLinkCallbacks:
+	public cTCPLink::cCallbacks
+{
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		m_Link = a_Link;
+	}
+
+	virtual void OnReceivedData(const char * a_Data, size_t a_Size) override
+	{
+		m_Link->Send(a_Data, a_Size);
+	}
+
+	virtual void OnRemoteClosed(void) override
+	{
+		m_Link.reset();
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		m_Link.reset();
+	}
+
+	cTCPLinkPtr m_Link;
+};
+
+
+
+
+
+class cEchoServerCallbacks:
+	public cNetwork::cListenCallbacks
+{
+	virtual cTCPLink::cCallbacksPtr OnIncomingConnection(const AString & a_RemoteIPAddress, UInt16 a_RemotePort) override
+	{
+		return std::make_shared<cEchoLinkCallbacks>();
+	}
+
+	virtual void OnAccepted(cTCPLink & a_Link) override
+	{
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		LOGWARNING("Cannot listen: %d (%s)", a_ErrorCode, a_ErrorMsg.c_str());
+	}
+};
+
+
+
+
+
+/** The client side of a single connection: connects, then sends pings one after another, measuring each round trip. */
+class cLoadClient:
+	public cTCPLink::cCallbacks,
+	public cNetwork::cConnectCallbacks
+{
+public:
+	cLoadClient(sLoadTest & a_Test, int a_NumPings):
+		m_Test(a_Test),
+		m_NumPingsLeft(a_NumPings),
+		m_NumReceived(0),
+		m_Start(std::chrono::steady_clock::now())
+	{
+	}
+
+	/** Closes the link, if still open. */
+	void Close(void)
+	{
+		cTCPLinkPtr Link;
+		{
+			cCSLock Lock(m_CS);
+			std::swap(Link, m_Link);
+		}
+		if (Link != nullptr)
+		{
+			Link->Close();
+		}
+	}
+
+protected:
+	sLoadTest & m_Test;
+	cCriticalSection m_CS;
+	cTCPLinkPtr m_Link;
+	int m_NumPingsLeft;
+	size_t m_NumReceived;
+	std::chrono::steady_clock::time_point m_Start;
+
+
+	void SendPing(cTCPLink & a_Link)
+	{
+		m_Start = std::chrono::steady_clock::now();
+		m_NumReceived = 0;
+		a_Link.Send(AString(PING_SIZE, 'p'));
+	}
+
+	// cNetwork::cConnectCallbacks overrides:
+	virtual void OnConnected(cTCPLink & a_Link) override
+	{
+		m_Test.m_ConnectLatency.Add(m_Start);
+		m_Test.m_NumPendingConnects -= 1;
+		SendPing(a_Link);
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		{
+			cCSLock Lock(m_CS);
+			if (m_NumPingsLeft <= 0)
+			{
+				// Already finished, the error is from closing the link
+				return;
+			}
+			m_NumPingsLeft = 0;
+		}
+		LOGD("Client error %d (%s)", a_ErrorCode, a_ErrorMsg.c_str());
+		m_Test.ClientFinished(true);
+	}
+
+	// cTCPLink::cCallbacks overrides:
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		cCSLock Lock(m_CS);
+		m_Link = a_Link;
+	}
+
+	virtual void OnReceivedData(const char * a_Data, size_t a_Size) override
+	{
+		m_NumReceived += a_Size;
+		if (m_NumReceived < PING_SIZE)
+		{
+			return;
+		}
+		m_Test.m_EchoLatency.Add(m_Start);
+		bool IsFinished;
+		cTCPLinkPtr Link;
+		{
+			cCSLock Lock(m_CS);
+			m_NumPingsLeft -= 1;
+			IsFinished = (m_NumPingsLeft <= 0);
+			Link = m_Link;
+		}
+		if (IsFinished)
+		{
+			// Keep the link open until all the clients finish, so that the server keeps all the connections:
+			m_Test.ClientFinished(false);
+		}
+		else if (Link != nullptr)
+		{
+			SendPing(*Link);
+		}
+	}
+
+	virtual void OnRemoteClosed(void) override
+	{
+		OnError(0, "Remote closed the connection");
+	}
+};
+
+
+
+
+
+/** Raises the limit on open files, each connection needs two sockets in this process. */
+static void RaiseFileLimit(void)
+{
+	#ifndef _WIN32
+		rlimit Limit;
+		if (getrlimit(RLIMIT_NOFILE, &Limit) == 0)
+		{
+			Limit.rlim_cur = Limit.rlim_max;
+			setrlimit(RLIMIT_NOFILE, &Limit);
+		}
+	#endif
+}
+
+
+
+
+
+static bool DoTest(int a_NumConnections, int a_NumPings)
+{
+	cServerHandlePtr Server = cNetwork::Listen(TEST_PORT, std::make_shared<cEchoServerCallbacks>());
+	if (!Server->IsListening())
+	{
+		LOGWARNING("Cannot listen on port %d", TEST_PORT);
+		return false;
+	}
+
+	sLoadTest Test(a_NumConnections);
+	std::vector<std::shared_ptr<cLoadClient>> Clients;
+	Clients.reserve(static_cast<size_t>(a_NumConnections));
+	auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < a_NumConnections; i++)
+	{
+		while (Test.m_NumPendingConnects >= MAX_PENDING_CONNECTS)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		auto Client = std::make_shared<cLoadClient>(Test, a_NumPings);
+		Clients.push_back(Client);
+		Test.m_NumPendingConnects += 1;
+		if (!cNetwork::Connect("127.0.0.1", TEST_PORT, Client, Client))
+		{
+			Test.m_NumPendingConnects -= 1;
+			Test.ClientFinished(true);
+		}
+	}
+
+	bool IsFinished = Test.m_Done.Wait(60000);
+	auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - Start).count();
+	LOG("%d connections, %d pings each, finished in %.2f sec, %d failed%s",
+		a_NumConnections, a_NumPings, Elapsed, Test.m_NumFailed.load(), IsFinished ? "" : " (TIMED OUT)"
+	);
+	Test.m_ConnectLatency.Report("Connect");
+	Test.m_EchoLatency.Report("Echo");
+
+	for (auto & Client : Clients)
+	{
+		Client->Close();
+	}
+	Server->Close();
+	return (IsFinished && (Test.m_NumFailed == 0));
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	int NumConnections = (argc > 1) ? atoi(argv[1]) : 2000;
+	int NumEventLoops = (argc > 2) ? atoi(argv[2]) : 0;
+	int NumPings = (argc > 3) ? atoi(argv[3]) : 10;
+
+	RaiseFileLimit();
+	cNetworkSingleton::Get().Initialise(static_cast<size_t>(std::max(NumEventLoops, 0)));
+	LOG("Using %u event loops", static_cast<unsigned>(cNetworkSingleton::Get().GetNumEventLoops()));
+
+	bool Res = DoTest(std::max(NumConnections, 1), std::max(NumPings, 1));
+
+	cNetworkSingleton::Get().Terminate();
+	LOG("Network load test finished.");
+	return Res ? 0 : 1;
+}
+
+
+
+
@@ -0,0 +1,466 @@
+
+// PingLoadTest.cpp
+
+// Implements a loopback load test of the server list ping answered on the network threads
+// Runs an in-process server that answers pings using cPingResponder, the same way cClientHandle does, and many
+// clients doing the full ping (handshake, status request, ping) or the legacy one. Reports the pings per second,
+// first with the cached status response, then with the response rebuilt for each ping.
+// Usage: PingLoadTest [<NumPings> [<NumConcurrent> [<NumEventLoops>]]]
+
+#include "Globals.h"
+#include <thread>
+#include "ByteBuffer.h"
+#include "OSSupport/Event.h"
+#include "OSSupport/Network.h"
+#include "OSSupport/NetworkSingleton.h"
+#include "Protocol/PingResponder.h"
+#include "Protocol/StatusResponseCache.h"
+
+#ifndef _WIN32
+	#include <sys/resource.h>
+#endif
+
+
+
+
+
+/** The port on which the ping server listens. */
+static const UInt16 TEST_PORT = 9878;
+
+/** The protocol version sent by the clients (1.12.2). */
+static const UInt32 TEST_PROTOCOL_VERSION = 340;
+
+/** The server description, checked in each response. */
+static const char TEST_DESCRIPTION[] = "Ping load test server";
+
+/** Each n-th client uses the legacy ping. */
+static const int LEGACY_PING_RATIO = 10;
+
+
+
+
+
+/** The state shared by the server and all the clients of a single test run. */
+struct sPingTest
+{
+	cStatusResponseCache m_Cache;
+
+	/** If set, the server changes the player count before each ping, so that the response is never cached. */
+	bool m_ShouldInvalidate;
+
+	/** The number of clients that are yet to be started. */
+	std::atomic<int> m_NumToStart;
+
+	/** The number of clients that haven't finished yet, either successfully or by an error. */
+	std::atomic<int> m_NumRemaining;
+
+	/** The number of clients that have failed. */
+	std::atomic<int> m_NumFailed;
+
+	/** The number of pings answered by the server, used for the invalidation. */
+	std::atomic<int> m_NumAnswered;
+
+	/** Set when m_NumRemaining reaches zero. */
+	cEvent m_Done;
+
+	sPingTest(int a_NumPings, bool a_ShouldInvalidate):
+		m_ShouldInvalidate(a_ShouldInvalidate),
+		m_NumToStart(a_NumPings),
+		m_NumRemaining(a_NumPings),
+		m_NumFailed(0),
+		m_NumAnswered(0)
+	{
+	}
+
+	/** Starts the next client, if there are any left to start. */
+	void StartClient(void);
+
+	void ClientFinished(bool a_HasFailed)
+	{
+		if (a_HasFailed)
+		{
+			m_NumFailed += 1;
+		}
+		if (--m_NumRemaining == 0)
+		{
+			m_Done.Set();
+		}
+		else
+		{
+			StartClient();
+		}
+	}
+};
+
+
+
+
+
+/** cTCPLink callbacks for the server side, answering the pings the same way cClientHandle does. */
+class cPingLinkCallbacks:
+	public cTCPLink::cCallbacks
+{
+public:
+	cPingLinkCallbacks(sPingTest & a_Test):
+		m_Test(a_Test),
+		m_Responder(a_Test.m_Cache, true)
+	{
+	}
+
+protected:
+	sPingTest & m_Test;
+	cPingResponder m_Responder;
+	cTCPLinkPtr m_Link;
+
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		m_Link = a_Link;
+		if (m_Test.m_ShouldInvalidate)
+		{
+			m_Test.m_Cache.SetPlayerCounts(++m_Test.m_NumAnswered, 1000000);
+		}
+	}
+
+	virtual void OnReceivedData(const char * a_Data, size_t a_Size) override
+	{
+		AString Response;
+		auto Result = m_Responder.ProcessData(a_Data, a_Size, Response);
+		if (Result == cPingResponder::prNotAPing)
+		{
+			LOGWARNING("The responder didn't recognize the ping");
+			m_Link->Close();
+			m_Link.reset();
+			return;
+		}
+		if (!Response.empty())
+		{
+			m_Link->Send(Response);
+		}
+		if (Result == cPingResponder::prFinished)
+		{
+			m_Link->Shutdown();
+		}
+	}
+
+	virtual void OnRemoteClosed(void) override
+	{
+		m_Link.reset();
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		m_Link.reset();
+	}
+};
+
+
+
+
+
+class cPingServerCallbacks:
+	public cNetwork::cListenCallbacks
+{
+public:
+	cPingServerCallbacks(sPingTest & a_Test):
+		m_Test(a_Test)
+	{
+	}
+
+protected:
+	sPingTest & m_Test;
+
+	virtual cTCPLink::cCallbacksPtr OnIncomingConnection(const AString & a_RemoteIPAddress, UInt16 a_RemotePort) override
+	{
+		return std::make_shared<cPingLinkCallbacks>(m_Test);
+	}
+
+	virtual void OnAccepted(cTCPLink & a_Link) override
+	{
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		LOGWARNING("Cannot listen: %d (%s)", a_ErrorCode, a_ErrorMsg.c_str());
+	}
+};
+
+
+
+
+
+/** The client side of a single ping: connects, asks for the status and pings, or sends the legacy ping. */
+class cPingClient:
+	public cTCPLink::cCallbacks,
+	public cNetwork::cConnectCallbacks
+{
+public:
+	cPingClient(sPingTest & a_Test, bool a_IsLegacy):
+		m_Test(a_Test),
+		m_IsLegacy(a_IsLegacy),
+		m_IsFinished(false),
+		m_HasStatus(false),
+		m_Received(64 KiB)
+	{
+	}
+
+protected:
+	sPingTest & m_Test;
+	bool m_IsLegacy;
+	bool m_IsFinished;
+
+	/** Set once the status response has been received and the ping sent. */
+	bool m_HasStatus;
+
+	/** The data received so far. */
+	cByteBuffer m_Received;
+
+	cTCPLinkPtr m_Link;
+
+
+	/** Appends a packet with the uncompressed framing to a_Data. */
+	static void AppendPacket(AString & a_Data, cByteBuffer & a_Packet)
+	{
+		AString Packet;
+		a_Packet.ReadAll(Packet);
+		a_Packet.CommitRead();
+		cByteBuffer Length(8);
+		Length.WriteVarInt32(static_cast<UInt32>(Packet.size()));
+		AString LengthData;
+		Length.ReadAll(LengthData);
+		a_Data.append(LengthData);
+		a_Data.append(Packet);
+	}
+
+
+	void Finish(bool a_HasFailed)
+	{
+		if (m_IsFinished)
+		{
+			return;
+		}
+		m_IsFinished = true;
+		if (a_HasFailed)
+		{
+			LOGD("Ping failed");
+		}
+		m_Test.ClientFinished(a_HasFailed);
+	}
+
+
+	/** Reads the next complete packet from m_Received, returns false if there's none yet. */
+	bool ReadPacket(UInt32 & a_PacketType, AString & a_Payload)
+	{
+		UInt32 PacketLen, PacketType;
+		if (!m_Received.ReadVarInt(PacketLen) || !m_Received.CanReadBytes(PacketLen))
+		{
+			m_Received.ResetRead();
+			return false;
+		}
+		size_t PacketEnd = m_Received.GetReadableSpace() - PacketLen;
+		m_Received.ReadVarInt(PacketType);
+		m_Received.ReadString(a_Payload, m_Received.GetReadableSpace() - PacketEnd);
+		m_Received.CommitRead();
+		a_PacketType = PacketType;
+		return true;
+	}
+
+
+	// cNetwork::cConnectCallbacks overrides:
+	virtual void OnConnected(cTCPLink & a_Link) override
+	{
+		AString Data;
+		if (m_IsLegacy)
+		{
+			Data.push_back(static_cast<char>(0xfe));
+			Data.push_back(0x01);
+			a_Link.Send(Data);
+			return;
+		}
+
+		// Handshake with the status state, then the status request, in a single send, the same as the vanilla client:
+		cByteBuffer Packet(1 KiB);
+		Packet.WriteVarInt32(0x00);
+		Packet.WriteVarInt32(TEST_PROTOCOL_VERSION);
+		Packet.WriteVarUTF8String("localhost");
+		Packet.WriteBEUInt16(TEST_PORT);
+		Packet.WriteVarInt32(1);
+		AppendPacket(Data, Packet);
+		Packet.WriteVarInt32(0x00);
+		AppendPacket(Data, Packet);
+		a_Link.Send(Data);
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		m_Link.reset();
+		Finish(true);
+	}
+
+	// cTCPLink::cCallbacks overrides:
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		m_Link = a_Link;
+	}
+
+	virtual void OnReceivedData(const char * a_Data, size_t a_Size) override
+	{
+		if (!m_Received.Write(a_Data, a_Size))
+		{
+			Finish(true);
+			return;
+		}
+
+		if (m_IsLegacy)
+		{
+			// The kick packet: 0xff, the length in UTF-16 characters, the UTF-16BE string:
+			UInt8 PacketType;
+			UInt16 NumChars;
+			if (!m_Received.ReadBEUInt8(PacketType) || !m_Received.ReadBEUInt16(NumChars) || !m_Received.CanReadBytes(2u * NumChars))
+			{
+				m_Received.ResetRead();
+				return;
+			}
+			Finish((PacketType != 0xff) || (NumChars < sizeof(TEST_DESCRIPTION)));
+			return;
+		}
+
+		UInt32 PacketType;
+		AString Payload;
+		while (ReadPacket(PacketType, Payload))
+		{
+			if (!m_HasStatus)
+			{
+				if ((PacketType != 0x00) || (Payload.find(TEST_DESCRIPTION) == AString::npos))
+				{
+					Finish(true);
+					return;
+				}
+				m_HasStatus = true;
+				cByteBuffer Packet(64);
+				Packet.WriteVarInt32(0x01);
+				Packet.WriteBEInt64(0x0123456789abcdef);
+				AString Data;
+				AppendPacket(Data, Packet);
+				m_Link->Send(Data);
+			}
+			else
+			{
+				// The pong, the ping is complete:
+				Finish((PacketType != 0x01) || (Payload.size() != 8));
+				return;
+			}
+		}
+	}
+
+	virtual void OnRemoteClosed(void) override
+	{
+		m_Link.reset();
+
+		// The server closes the link after answering, a ping that hasn't completed by then has failed:
+		Finish(true);
+	}
+};
+
+
+
+
+
+void sPingTest::StartClient(void)
+{
+	int Index = --m_NumToStart;
+	if (Index < 0)
+	{
+		return;
+	}
+	auto Client = std::make_shared<cPingClient>(*this, (Index % LEGACY_PING_RATIO) == 0);
+	if (!cNetwork::Connect("127.0.0.1", TEST_PORT, Client, Client))
+	{
+		ClientFinished(true);
+	}
+}
+
+
+
+
+
+/** Raises the limit on open files, each connection needs two sockets in this process. */
+static void RaiseFileLimit(void)
+{
+	#ifndef _WIN32
+		rlimit Limit;
+		if (getrlimit(RLIMIT_NOFILE, &Limit) == 0)
+		{
+			Limit.rlim_cur = Limit.rlim_max;
+			setrlimit(RLIMIT_NOFILE, &Limit);
+		}
+	#endif
+}
+
+
+
+
+
+static bool DoTest(int a_NumPings, int a_NumConcurrent, bool a_ShouldInvalidate)
+{
+	sPingTest Test(a_NumPings, a_ShouldInvalidate);
+	Test.m_Cache.SetDescription(TEST_DESCRIPTION);
+	Test.m_Cache.SetPlayerCounts(0, 1000000);
+
+	// A favicon of a typical size, about 6 KiB of Base64:
+	AString Favicon;
+	for (int i = 0; i < 6000; i++)
+	{
+		Favicon.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[(i * 37) % 64]);
+	}
+	Test.m_Cache.SetFavicon(Favicon);
+
+	cServerHandlePtr Server = cNetwork::Listen(TEST_PORT, std::make_shared<cPingServerCallbacks>(Test));
+	if (!Server->IsListening())
+	{
+		LOGWARNING("Cannot listen on port %d", TEST_PORT);
+		return false;
+	}
+
+	auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < a_NumConcurrent; i++)
+	{
+		Test.StartClient();
+	}
+	bool IsFinished = Test.m_Done.Wait(60000);
+	auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - Start).count();
+	LOG("%s response: %d pings, %d at a time, finished in %.2f sec, %.0f pings / sec, %d failed%s",
+		a_ShouldInvalidate ? "Rebuilt" : "Cached",
+		a_NumPings, a_NumConcurrent, Elapsed, a_NumPings / Elapsed, Test.m_NumFailed.load(), IsFinished ? "" : " (TIMED OUT)"
+	);
+
+	Server->Close();
+	return (IsFinished && (Test.m_NumFailed == 0));
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	int NumPings = (argc > 1) ? atoi(argv[1]) : 20000;
+	int NumConcurrent = (argc > 2) ? atoi(argv[2]) : 100;
+	int NumEventLoops = (argc > 3) ? atoi(argv[3]) : 0;
+
+	RaiseFileLimit();
+	cNetworkSingleton::Get().Initialise(static_cast<size_t>(std::max(NumEventLoops, 0)));
+	LOG("Using %u event loops", static_cast<unsigned>(cNetworkSingleton::Get().GetNumEventLoops()));
+
+	NumPings = std::max(NumPings, 1);
+	NumConcurrent = Clamp(NumConcurrent, 1, NumPings);
+	bool Res = DoTest(NumPings, NumConcurrent, false);
+	Res = DoTest(NumPings, NumConcurrent, true) && Res;
+
+	cNetworkSingleton::Get().Terminate();
+	LOG("Ping load test finished.");
+	return Res ? 0 : 1;
+}
+
+
+
+
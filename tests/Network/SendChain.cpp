@@ -0,0 +1,216 @@
+
+// SendChain.cpp
+
+// Implements a test of sending a cSendChain over a loopback TCP link
+// The chain mixes copied and shared slices, the echo server sends everything back and the client checks the data
+
+#include "Globals.h"
+#include "OSSupport/Event.h"
+#include "OSSupport/Network.h"
+#include "OSSupport/NetworkSingleton.h"
+#include "OSSupport/SendChain.h"
+
+
+
+
+
+/** The port on which the echo server listens. */
+static const UInt16 TEST_PORT = 9878;
+
+
+
+
+
+/** cTCPLink callbacks for the server side, echoing everything back. */
+class cEchoLinkCallbacks:
+	public cTCPLink::cCallbacks
+{
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		m_Link = a_Link;
+	}
+
+	virtual void OnReceivedData(const char * a_Data, size_t a_Size) override
+	{
+		m_Link->Send(a_Data, a_Size);
+	}
+
+	virtual void OnRemoteClosed(void) override
+	{
+		m_Link.reset();
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		m_Link.reset();
+	}
+
+	cTCPLinkPtr m_Link;
+};
+
+
+
+
+
+class cEchoServerCallbacks:
+	public cNetwork::cListenCallbacks
+{
+	virtual cTCPLink::cCallbacksPtr OnIncomingConnection(const AString & a_RemoteIPAddress, UInt16 a_RemotePort) override
+	{
+		return std::make_shared<cEchoLinkCallbacks>();
+	}
+
+	virtual void OnAccepted(cTCPLink & a_Link) override
+	{
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		LOGWARNING("Cannot listen: %d (%s)", a_ErrorCode, a_ErrorMsg.c_str());
+	}
+};
+
+
+
+
+
+/** The client side: sends the chain once connected and collects the echoed data until all of it arrives. */
+class cChainClient:
+	public cTCPLink::cCallbacks,
+	public cNetwork::cConnectCallbacks
+{
+public:
+	cChainClient(cSendChain & a_Chain, size_t a_ExpectedSize):
+		m_Chain(a_Chain),
+		m_ExpectedSize(a_ExpectedSize)
+	{
+	}
+
+	cEvent m_Done;
+	AString m_Received;
+	cTCPLinkPtr m_Link;
+
+protected:
+	cSendChain & m_Chain;
+	size_t m_ExpectedSize;
+
+
+	virtual void OnConnected(cTCPLink & a_Link) override
+	{
+		assert_test(a_Link.Send(m_Chain));
+	}
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		LOGWARNING("Client error %d (%s)", a_ErrorCode, a_ErrorMsg.c_str());
+		m_Done.Set();
+	}
+
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		m_Link = a_Link;
+	}
+
+	virtual void OnReceivedData(const char * a_Data, size_t a_Size) override
+	{
+		m_Received.append(a_Data, a_Size);
+		if (m_Received.size() >= m_ExpectedSize)
+		{
+			m_Done.Set();
+		}
+	}
+
+	virtual void OnRemoteClosed(void) override
+	{
+		m_Done.Set();
+	}
+};
+
+
+
+
+
+static void TestChainContents(void)
+{
+	cSendChain Chain;
+	assert_test(Chain.IsEmpty());
+	Chain.Append("abc", 3);
+	Chain.Append("def", 3);
+	auto Large = std::make_shared<const AString>(static_cast<size_t>(cSendChain::MIN_SHARED_SLICE_SIZE), 'L');
+	auto Small = std::make_shared<const AString>("small");
+	Chain.AppendShared(Large);
+	Chain.AppendShared(Small);
+	Chain.Append("ghi", 3);
+
+	// The copied data is merged into slices around the shared slice, the small shared data is copied:
+	const auto & Slices = Chain.GetSlices();
+	assert_test(Slices.size() == 3);
+	assert_test(*Slices[0] == "abcdef");
+	assert_test(Slices[1] == Large);
+	assert_test(*Slices[2] == "smallghi");
+	assert_test(Chain.GetSize() == Large->size() + 14);
+	assert_test(Chain.GetNumBytesCopied() == 14);
+
+	Chain.Clear();
+	assert_test(Chain.IsEmpty());
+	assert_test(Chain.GetSlices().empty());
+}
+
+
+
+
+
+static void TestChainSending(void)
+{
+	// Build a chain of a few large shared slices interleaved with copied data:
+	cSendChain Chain;
+	AString Expected;
+	for (int i = 0; i < 20; i++)
+	{
+		AString Copied = Printf("[%d]", i);
+		Chain.Append(Copied.data(), Copied.size());
+		Expected.append(Copied);
+		auto Shared = std::make_shared<const AString>(10000 + static_cast<size_t>(i), static_cast<char>('a' + i));
+		Chain.AppendShared(Shared);
+		Expected.append(*Shared);
+	}
+
+	auto Server = cNetwork::Listen(TEST_PORT, std::make_shared<cEchoServerCallbacks>());
+	assert_test(Server->IsListening());
+	auto Client = std::make_shared<cChainClient>(Chain, Expected.size());
+	assert_test(cNetwork::Connect("127.0.0.1", TEST_PORT, Client, Client));
+	assert_test(Client->m_Done.Wait(10000));
+	assert_test(Client->m_Received == Expected);
+	LOGD("Received %u bytes of echoed chain data", static_cast<unsigned>(Client->m_Received.size()));
+
+	if (Client->m_Link != nullptr)
+	{
+		Client->m_Link->Close();
+		Client->m_Link.reset();
+	}
+	Server->Close();
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+	cNetworkSingleton::Get().Initialise();
+
+	LOGD("Testing chain contents");
+	TestChainContents();
+
+	LOGD("Testing sending a chain");
+	TestChainSending();
+
+	cNetworkSingleton::Get().Terminate();
+	LOG("SendChain test finished.");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,138 @@
+
+// PacketCompressorTest.cpp
+
+// Implements the main app entrypoint for the cPacketCompressor class test
+
+#include "Globals.h"
+#include "ByteBuffer.h"
+#include "StringCompression.h"
+#include "Protocol/PacketCompressor.h"
+
+
+
+
+
+/** Returns a payload of the specified size that compresses reasonably, but not trivially. */
+static AString CreatePayload(size_t a_Size, int a_Seed)
+{
+	AString Res;
+	Res.reserve(a_Size);
+	for (size_t i = 0; i < a_Size; i++)
+	{
+		Res.push_back(static_cast<char>((i * static_cast<size_t>(a_Seed)) % 17 + (i / 64) % 3));
+	}
+	return Res;
+}
+
+
+
+
+
+/** Parses the framed packet and checks that it decodes back into a_Payload. */
+static void CheckFramedPacket(const char * a_Framed, size_t a_FramedSize, bool a_IsCompressionEnabled, const AString & a_Payload, bool a_ShouldBeCompressed)
+{
+	cByteBuffer Buf(a_FramedSize + 1);
+	assert_test(Buf.Write(a_Framed, a_FramedSize));
+	UInt32 PacketLength;
+	assert_test(Buf.ReadVarInt32(PacketLength));
+	assert_test(PacketLength == Buf.GetReadableSpace());
+	if (!a_IsCompressionEnabled)
+	{
+		AString Data;
+		Buf.ReadAll(Data);
+		assert_test(Data == a_Payload);
+		return;
+	}
+
+	UInt32 DataLength;
+	assert_test(Buf.ReadVarInt32(DataLength));
+	AString Data;
+	Buf.ReadAll(Data);
+	if (!a_ShouldBeCompressed)
+	{
+		assert_test(DataLength == 0);
+		assert_test(Data == a_Payload);
+		return;
+	}
+	assert_test(DataLength == a_Payload.size());
+	AString Uncompressed;
+	assert_test(UncompressString(Data.data(), Data.size(), Uncompressed, DataLength) == Z_OK);
+	assert_test(Uncompressed == a_Payload);
+}
+
+
+
+
+
+static void TestFraming(void)
+{
+	cPacketCompressor Compressor(256, Z_DEFAULT_COMPRESSION);
+	const size_t Sizes[] = {1, 100, 255, 256, 511, 512, 513, 4000, 100000};
+	for (int Pass = 0; Pass < 2; Pass++)  // Twice, to check that the reused stream and buffers work
+	{
+		for (size_t i = 0; i < ARRAYCOUNT(Sizes); i++)
+		{
+			AString Payload = CreatePayload(Sizes[i], static_cast<int>(i) + 3);
+			bool ShouldBeCompressed = (Payload.size() >= 256);
+			const char * Framed;
+			size_t FramedSize;
+
+			// Contiguous input, both with and without compression:
+			assert_test(Compressor.FramePacket(Payload.data(), Payload.size(), true, Framed, FramedSize));
+			CheckFramedPacket(Framed, FramedSize, true, Payload, ShouldBeCompressed);
+			assert_test(Compressor.FramePacket(Payload.data(), Payload.size(), false, Framed, FramedSize));
+			CheckFramedPacket(Framed, FramedSize, false, Payload, false);
+
+			// Bytebuffer input, with the data wrapping around the end of the buffer:
+			cByteBuffer Buf(Payload.size() + 100);
+			assert_test(Buf.Write(Payload.data(), 50));
+			assert_test(Buf.SkipRead(50));
+			Buf.CommitRead();
+			assert_test(Buf.Write(Payload.data(), Payload.size()));
+			assert_test(Compressor.FramePacket(Buf, Payload.size(), true, Framed, FramedSize));
+			assert_test(Buf.GetReadableSpace() == 0);
+			CheckFramedPacket(Framed, FramedSize, true, Payload, ShouldBeCompressed);
+		}
+	}
+}
+
+
+
+
+
+static void TestThreshold(void)
+{
+	// Threshold 0 compresses everything:
+	cPacketCompressor Compressor(0, 1);
+	AString Payload("\x01\x02\x03", 3);
+	const char * Framed;
+	size_t FramedSize;
+	assert_test(Compressor.FramePacket(Payload.data(), Payload.size(), true, Framed, FramedSize));
+	CheckFramedPacket(Framed, FramedSize, true, Payload, true);
+
+	// Not enough data in the buffer:
+	cByteBuffer Buf(10);
+	assert_test(Buf.Write(Payload.data(), Payload.size()));
+	assert_test(!Compressor.FramePacket(Buf, 5, true, Framed, FramedSize));
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	LOGD("Testing framing");
+	TestFraming();
+
+	LOGD("Testing threshold");
+	TestThreshold();
+
+	LOG("PacketCompressor test finished.");
+}
+
+
+
+
@@ -0,0 +1,398 @@
+
+// PacketDecoderTest.cpp
+
+// Implements the main app entrypoint for the cPacketDecoder class test
+// Frames packets using cPacketCompressor and checks that the decoder gets them back, parses the movement packets,
+// rejects bad data and floods
+
+#include "Globals.h"
+#include "ByteBuffer.h"
+#include "Protocol/PacketCompressor.h"
+#include "Protocol/PacketDecoder.h"
+
+
+
+
+
+/** Returns the payload for the packet with the specified index; every tenth one is large enough to get compressed. */
+static AString CreatePayload(int a_Index)
+{
+	size_t Size = ((a_Index % 10) == 9) ? 3000 : static_cast<size_t>(a_Index % 50);
+	AString Res;
+	for (size_t i = 0; i < Size; i++)
+	{
+		Res.push_back(static_cast<char>((i * 7 + static_cast<size_t>(a_Index)) % 23));
+	}
+	return Res;
+}
+
+
+
+
+
+/** Returns the packet type for the packet with the specified index, some of them needing more than one VarInt byte. */
+static UInt32 GetPacketType(int a_Index)
+{
+	return static_cast<UInt32>(a_Index * 37) % 300;
+}
+
+
+
+
+
+/** Appends the framed packet of the specified type and payload to a_Stream. */
+static void AppendPacket(AString & a_Stream, cPacketCompressor & a_Compressor, UInt32 a_PacketType, const AString & a_Payload)
+{
+	cByteBuffer Packet(64 KiB);
+	assert_test(Packet.WriteVarInt32(a_PacketType));
+	assert_test(Packet.Write(a_Payload.data(), a_Payload.size()));
+	AString Data;
+	Packet.ReadAll(Data);
+	const char * Framed;
+	size_t FramedSize;
+	assert_test(a_Compressor.FramePacket(Data.data(), Data.size(), true, Framed, FramedSize));
+	a_Stream.append(Framed, FramedSize);
+}
+
+
+
+
+
+/** Appends the framed packet with the specified index to a_Stream. */
+static void AppendPacket(AString & a_Stream, cPacketCompressor & a_Compressor, int a_Index)
+{
+	AppendPacket(a_Stream, a_Compressor, GetPacketType(a_Index), CreatePayload(a_Index));
+}
+
+
+
+
+
+/** Returns the payload of a Player Position And Look packet. */
+static AString CreatePositionLook(double a_PosX, double a_PosY, double a_PosZ, float a_Yaw, float a_Pitch, bool a_IsOnGround)
+{
+	cByteBuffer Payload(64);
+	assert_test(Payload.WriteBEDouble(a_PosX));
+	assert_test(Payload.WriteBEDouble(a_PosY));
+	assert_test(Payload.WriteBEDouble(a_PosZ));
+	assert_test(Payload.WriteBEFloat(a_Yaw));
+	assert_test(Payload.WriteBEFloat(a_Pitch));
+	assert_test(Payload.WriteBool(a_IsOnGround));
+	AString Res;
+	Payload.ReadAll(Res);
+	return Res;
+}
+
+
+
+
+
+/** Returns the payload of the decoded packet, checking the buffer's layout: the type has been read and an extra NUL follows the payload. */
+static AString GetPayload(cPacketDecoder::sPacket & a_Packet)
+{
+	cByteBuffer & Data = *a_Packet.m_Data;
+	assert_test(Data.GetUsedSpace() == a_Packet.m_PacketLen + 1);
+	assert_test(Data.GetReadableSpace() == a_Packet.m_PacketLen + 1 - cByteBuffer::GetVarIntSize(a_Packet.m_PacketType));
+	AString Payload;
+	assert_test(Data.ReadString(Payload, Data.GetReadableSpace() - 1));
+	UInt8 Nul = 1;
+	assert_test(Data.ReadBEUInt8(Nul) && (Nul == 0));
+	return Payload;
+}
+
+
+
+
+
+/** Checks that the decoder returns the packets with indices [a_First, a_First + a_Count), and nothing more. */
+static void CheckPackets(cPacketDecoder & a_Decoder, int a_First, int a_Count)
+{
+	cPacketDecoder::sPacket Packet;
+	for (int i = a_First; i < a_First + a_Count; i++)
+	{
+		assert_test(a_Decoder.Pop(Packet));
+		assert_test(Packet.m_PacketType == GetPacketType(i));
+		assert_test(GetPayload(Packet) == CreatePayload(i));
+		a_Decoder.Recycle(std::move(Packet));
+	}
+	assert_test(!a_Decoder.Pop(Packet));
+}
+
+
+
+
+
+static void TestDecoding(void)
+{
+	cPacketCompressor Compressor(cPacketCompressor::DEFAULT_THRESHOLD, Z_DEFAULT_COMPRESSION);
+	AString Stream;
+	for (int i = 0; i < 100; i++)
+	{
+		AppendPacket(Stream, Compressor, i);
+	}
+
+	// All data at once:
+	{
+		cPacketDecoder Decoder;
+		cByteBuffer ReceivedData(32 KiB);
+		assert_test(Decoder.Decode(ReceivedData, Stream.data(), Stream.size()));
+		CheckPackets(Decoder, 0, 100);
+	}
+
+	// Byte by byte, as if each byte came in a separate TCP segment:
+	{
+		cPacketDecoder Decoder;
+		cByteBuffer ReceivedData(32 KiB);
+		for (size_t i = 0; i < Stream.size(); i++)
+		{
+			assert_test(Decoder.Decode(ReceivedData, Stream.data() + i, 1));
+		}
+		CheckPackets(Decoder, 0, 100);
+		AString Reason;
+		assert_test(!Decoder.TakeFailure(Reason));
+	}
+}
+
+
+
+
+
+static void TestMalformed(void)
+{
+	// A compressed packet with garbage instead of the deflated data:
+	{
+		cPacketDecoder Decoder;
+		cByteBuffer ReceivedData(32 KiB);
+		const char Garbage[] = {5, static_cast<char>(0x80), 0x02, 1, 2, 3};  // Length 5, uncompressed size 256, 3 bytes of junk
+		assert_test(!Decoder.Decode(ReceivedData, Garbage, sizeof(Garbage)));
+		assert_test(Decoder.HasFailed());
+		AString Reason;
+		assert_test(Decoder.TakeFailure(Reason));
+		assert_test(!Reason.empty());
+		assert_test(!Decoder.TakeFailure(Reason));  // Reported only once
+
+		// Any further data is ignored, even if valid:
+		cPacketCompressor Compressor(cPacketCompressor::DEFAULT_THRESHOLD, Z_DEFAULT_COMPRESSION);
+		AString Stream;
+		AppendPacket(Stream, Compressor, 1);
+		assert_test(!Decoder.Decode(ReceivedData, Stream.data(), Stream.size()));
+		cPacketDecoder::sPacket Packet;
+		assert_test(!Decoder.Pop(Packet));
+	}
+
+	// A packet declaring a huge uncompressed size is rejected without inflating:
+	{
+		cPacketDecoder Decoder;
+		cByteBuffer ReceivedData(32 KiB);
+		const char Huge[] = {5, static_cast<char>(0xff), static_cast<char>(0xff), static_cast<char>(0xff), 0x7f, 0};
+		assert_test(!Decoder.Decode(ReceivedData, Huge, sizeof(Huge)));
+	}
+
+	// More data than the receive buffer can hold:
+	{
+		cPacketDecoder Decoder;
+		cByteBuffer ReceivedData(1 KiB);
+		AString Large(2000, 'x');
+		assert_test(!Decoder.Decode(ReceivedData, Large.data(), Large.size()));
+	}
+}
+
+
+
+
+
+/** Checks that the movement packets are parsed into records, in order with the other packets, and that bad ones are rejected. */
+static void TestMovement(void)
+{
+	// The 1.9 movement packet types; 0x0d is the Player Position And Look, 0x0f the Player:
+	const UInt32 OnGround = 0x0f, Position = 0x0c, Look = 0x0e, PositionLook = 0x0d;
+	cPacketCompressor Compressor(cPacketCompressor::DEFAULT_THRESHOLD, Z_DEFAULT_COMPRESSION);
+
+	// A movement between other packets:
+	{
+		AString Stream;
+		AppendPacket(Stream, Compressor, 1);
+		AppendPacket(Stream, Compressor, PositionLook, CreatePositionLook(-12.5, 64, 1000.25, 90, -45, true));
+		AppendPacket(Stream, Compressor, OnGround, AString(1, '\0'));
+		AppendPacket(Stream, Compressor, 2);
+		cPacketDecoder Decoder;
+		Decoder.SetMovementPacketTypes(OnGround, Position, Look, PositionLook);
+		cByteBuffer ReceivedData(32 KiB);
+		assert_test(Decoder.Decode(ReceivedData, Stream.data(), Stream.size()));
+
+		cPacketDecoder::sPacket Packet;
+		assert_test(Decoder.Pop(Packet));
+		assert_test(Packet.m_Movement.m_Type == cPacketDecoder::mvNone);
+		assert_test(GetPayload(Packet) == CreatePayload(1));
+		Decoder.Recycle(std::move(Packet));
+
+		assert_test(Decoder.Pop(Packet));
+		assert_test(Packet.m_PacketType == PositionLook);
+		assert_test(Packet.m_Data == nullptr);
+		const auto & Movement = Packet.m_Movement;
+		assert_test(Movement.m_Type == cPacketDecoder::mvPositionLook);
+		assert_test((Movement.m_PosX == -12.5) && (Movement.m_PosY == 64) && (Movement.m_PosZ == 1000.25));
+		assert_test((Movement.m_Yaw == 90) && (Movement.m_Pitch == -45) && Movement.m_IsOnGround);
+		Decoder.Recycle(std::move(Packet));
+
+		assert_test(Decoder.Pop(Packet));
+		assert_test(Packet.m_Movement.m_Type == cPacketDecoder::mvOnGround);
+		assert_test(!Packet.m_Movement.m_IsOnGround);
+		Decoder.Recycle(std::move(Packet));
+
+		assert_test(Decoder.Pop(Packet));
+		assert_test(Packet.m_Movement.m_Type == cPacketDecoder::mvNone);
+		assert_test(GetPayload(Packet) == CreatePayload(2));
+		assert_test(!Decoder.Pop(Packet));
+	}
+
+	// Without the packet types set, the same packet is queued as is:
+	{
+		AString Stream;
+		AString Payload = CreatePositionLook(1, 2, 3, 4, 5, false);
+		AppendPacket(Stream, Compressor, PositionLook, Payload);
+		cPacketDecoder Decoder;
+		cByteBuffer ReceivedData(32 KiB);
+		assert_test(Decoder.Decode(ReceivedData, Stream.data(), Stream.size()));
+		cPacketDecoder::sPacket Packet;
+		assert_test(Decoder.Pop(Packet));
+		assert_test(Packet.m_Movement.m_Type == cPacketDecoder::mvNone);
+		assert_test(GetPayload(Packet) == Payload);
+	}
+
+	// Packets of the wrong size, and coords that aren't finite or are out of the world, fail the decoder:
+	const double Nan = std::numeric_limits<double>::quiet_NaN();
+	const double Inf = std::numeric_limits<double>::infinity();
+	const AString BadPayloads[] =
+	{
+		CreatePositionLook(1, 2, 3, 4, 5, false).substr(1),
+		CreatePositionLook(1, 2, 3, 4, 5, false) + AString(1, 'x'),
+		CreatePositionLook(Nan, 64, 0, 0, 0, true),
+		CreatePositionLook(0, Inf, 0, 0, 0, true),
+		CreatePositionLook(0, 64, cPacketDecoder::MAX_MOVEMENT_COORD + 1.0, 0, 0, true),
+		CreatePositionLook(0, 64, 0, std::numeric_limits<float>::quiet_NaN(), 0, true),
+	};
+	for (const auto & Payload: BadPayloads)
+	{
+		AString Stream;
+		AppendPacket(Stream, Compressor, PositionLook, Payload);
+		cPacketDecoder Decoder;
+		Decoder.SetMovementPacketTypes(OnGround, Position, Look, PositionLook);
+		cByteBuffer ReceivedData(32 KiB);
+		assert_test(!Decoder.Decode(ReceivedData, Stream.data(), Stream.size()));
+		cPacketDecoder::sPacket Packet;
+		assert_test(!Decoder.Pop(Packet));
+		AString Reason;
+		assert_test(Decoder.TakeFailure(Reason));
+		LOGD("Bad movement detected: %s", Reason.c_str());
+	}
+}
+
+
+
+
+
+static void TestFlood(void)
+{
+	cPacketCompressor Compressor(cPacketCompressor::DEFAULT_THRESHOLD, Z_DEFAULT_COMPRESSION);
+	AString OnePacket;
+	AppendPacket(OnePacket, Compressor, 1);
+	cPacketDecoder Decoder;
+	cByteBuffer ReceivedData(32 KiB);
+	for (size_t i = 0; i < cPacketDecoder::MAX_QUEUED_PACKETS; i++)
+	{
+		assert_test(Decoder.Decode(ReceivedData, OnePacket.data(), OnePacket.size()));
+	}
+	assert_test(!Decoder.Decode(ReceivedData, OnePacket.data(), OnePacket.size()));
+	AString Reason;
+	assert_test(Decoder.TakeFailure(Reason));
+	LOGD("Flood detected: %s", Reason.c_str());
+}
+
+
+
+
+
+/** Decodes the stream on a separate thread while the main thread pops the packets, the same as the network and tick threads. */
+static void TestThreaded(void)
+{
+	const int NumPackets = 20000;
+	cPacketCompressor Compressor(cPacketCompressor::DEFAULT_THRESHOLD, Z_DEFAULT_COMPRESSION);
+	AString Stream;
+	std::vector<size_t> PacketEnds;
+	for (int i = 0; i < NumPackets; i++)
+	{
+		AppendPacket(Stream, Compressor, i);
+		PacketEnds.push_back(Stream.size());
+	}
+
+	cPacketDecoder Decoder;
+	std::atomic<int> NumReceived(0);
+	std::thread Network([&]()
+		{
+			cByteBuffer ReceivedData(32 KiB);
+			size_t Pos = 0;
+			while (Pos < Stream.size())
+			{
+				// Don't let the queue overflow, the consumer isn't limited to a tick rate but may still fall behind:
+				size_t Size = std::min<size_t>(1460, Stream.size() - Pos);
+				auto NumComplete = std::upper_bound(PacketEnds.begin(), PacketEnds.end(), Pos + Size) - PacketEnds.begin();
+				while (NumComplete - NumReceived.load() > static_cast<int>(cPacketDecoder::MAX_QUEUED_PACKETS) / 2)
+				{
+					std::this_thread::yield();
+				}
+				assert_test(Decoder.Decode(ReceivedData, Stream.data() + Pos, Size));
+				Pos += Size;
+			}
+		}
+	);
+
+	cPacketDecoder::sPacket Packet;
+	for (int i = 0; i < NumPackets;)
+	{
+		if (!Decoder.Pop(Packet))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		assert_test(Packet.m_PacketType == GetPacketType(i));
+		assert_test(GetPayload(Packet) == CreatePayload(i));
+		Decoder.Recycle(std::move(Packet));
+		i += 1;
+		NumReceived = i;
+	}
+	Network.join();
+	assert_test(!Decoder.Pop(Packet));
+	assert_test(!Decoder.HasFailed());
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	LOGD("Testing decoding");
+	TestDecoding();
+
+	LOGD("Testing malformed data");
+	TestMalformed();
+
+	LOGD("Testing the movement packets");
+	TestMovement();
+
+	LOGD("Testing flood detection");
+	TestFlood();
+
+	LOGD("Testing decoding on a separate thread");
+	TestThreaded();
+
+	LOG("PacketDecoder test finished.");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,357 @@
+
+// NavPlannerTest.cpp
+
+// Implements the test for the cNavPlanner class that plans the mobs' long paths over the sections' walkable regions
+
+#include "Globals.h"
+#include "BlockID.h"
+#include "Mobs/NavPlanner.h"
+
+#include <unordered_map>
+
+
+
+
+
+/** The number of chunks of the test terrain in each direction. */
+static const int NUM_CHUNKS = 3;
+
+/** The maximum number of legs a mob walks before it is expected to be near the destination. */
+static const int MAX_LEGS = 20;
+
+/** The table of solid blocks used by the tests: everything but air. */
+static bool g_IsSolid[256];
+
+
+
+
+
+/** A terrain of NUM_CHUNKS * NUM_CHUNKS chunks, providing the nav sections built from its blocks. */
+class cTestTerrain :
+	public cNavPlanner::cSections
+{
+public:
+
+	cTestTerrain(void):
+		m_BlockTypes(static_cast<size_t>(NUM_CHUNKS * NUM_CHUNKS * cChunkDef::NumBlocks), E_BLOCK_AIR)
+	{
+	}
+
+	/** Fills the specified box (inclusive, absolute block coords) with stone. */
+	void Fill(int a_MinX, int a_MinY, int a_MinZ, int a_MaxX, int a_MaxY, int a_MaxZ)
+	{
+		for (int y = a_MinY; y <= a_MaxY; y++)
+		{
+			for (int z = a_MinZ; z <= a_MaxZ; z++)
+			{
+				for (int x = a_MinX; x <= a_MaxX; x++)
+				{
+					GetChunkBlocks(x / cChunkDef::Width, z / cChunkDef::Width)[cChunkDef::MakeIndexNoCheck(x % cChunkDef::Width, y, z % cChunkDef::Width)] = E_BLOCK_STONE;
+				}
+			}
+		}
+		m_NavSections.clear();
+	}
+
+	/** Returns the number of the nav sections built since the last change of the blocks. */
+	size_t GetNumNavSections(void) const { return m_NavSections.size(); }
+
+	/** Returns true if a mob can stand in the specified cell. */
+	bool IsWalkable(const Vector3i & a_Cell)
+	{
+		return (
+			(a_Cell.y > 0) && (a_Cell.y < cChunkDef::Height - 1) &&
+			IsSolid(a_Cell.x, a_Cell.y - 1, a_Cell.z) && !IsSolid(a_Cell.x, a_Cell.y, a_Cell.z) && !IsSolid(a_Cell.x, a_Cell.y + 1, a_Cell.z)
+		);
+	}
+
+	virtual const cNavSection * GetNavSection(int a_ChunkX, int a_SectionNum, int a_ChunkZ) override
+	{
+		if ((a_ChunkX < 0) || (a_ChunkX >= NUM_CHUNKS) || (a_ChunkZ < 0) || (a_ChunkZ >= NUM_CHUNKS))
+		{
+			return nullptr;
+		}
+		auto & NavSection = m_NavSections[Vector3i(a_ChunkX, a_SectionNum, a_ChunkZ)];
+		if (NavSection == nullptr)
+		{
+			const BLOCKTYPE * Blocks = GetChunkBlocks(a_ChunkX, a_ChunkZ);
+			const int SectionSize = static_cast<int>(cChunkData::SectionBlockCount);
+			NavSection.reset(new cNavSection(
+				(a_SectionNum > 0) ? Blocks + (a_SectionNum - 1) * SectionSize : nullptr,
+				Blocks + a_SectionNum * SectionSize,
+				(a_SectionNum < static_cast<int>(cChunkData::NumSections) - 1) ? Blocks + (a_SectionNum + 1) * SectionSize : nullptr,
+				g_IsSolid
+			));
+		}
+		return NavSection.get();
+	}
+
+protected:
+
+	/** The blocks of all the chunks, each chunk in the cChunkDef::MakeIndexNoCheck() layout, the sections following each other. */
+	std::vector<BLOCKTYPE> m_BlockTypes;
+
+	/** The nav sections built so far, by (ChunkX, SectionNum, ChunkZ). */
+	std::unordered_map<Vector3i, std::unique_ptr<cNavSection>, VectorHasher<int>> m_NavSections;
+
+
+	BLOCKTYPE * GetChunkBlocks(int a_ChunkX, int a_ChunkZ)
+	{
+		return m_BlockTypes.data() + (a_ChunkX + a_ChunkZ * NUM_CHUNKS) * cChunkDef::NumBlocks;
+	}
+
+	bool IsSolid(int a_X, int a_Y, int a_Z)
+	{
+		return g_IsSolid[GetChunkBlocks(a_X / cChunkDef::Width, a_Z / cChunkDef::Width)[cChunkDef::MakeIndexNoCheck(a_X % cChunkDef::Width, a_Y, a_Z % cChunkDef::Width)]];
+	}
+} ;
+
+
+
+
+
+/** Walks a mob from a_Source towards a_Destination leg by leg, as the cPathFinder does, re-planning at each leg's end.
+Checks that each leg ends in a walkable cell and that the mob arrives within reach of the block-level search.
+Returns the leg ends, in the order they were walked. */
+static std::vector<Vector3i> WalkLegs(cTestTerrain & a_Terrain, const Vector3i & a_Source, const Vector3i & a_Destination)
+{
+	cNavPlanner Planner;
+	std::vector<Vector3i> Legs;
+	Vector3i Position = a_Source;
+	Vector3i LegEnd;
+	while (Planner.PlanFirstLeg(a_Terrain, Position, a_Destination, LegEnd))
+	{
+		assert_test(a_Terrain.IsWalkable(LegEnd));
+		assert_test(LegEnd != Position);
+		Legs.push_back(LegEnd);
+		assert_test(Legs.size() <= MAX_LEGS);
+		Position = LegEnd;
+	}
+
+	// The planner gives up only once the block-level search can handle the rest, which is when the mob is close or
+	// it has reached the destination's region; in this terrain, both mean being within the block-level search's reach:
+	assert_test((a_Destination - Position).SqrLength() < 32 * 32);
+	return Legs;
+}
+
+
+
+
+
+/** Checks that the route goes around a wall through its only gap. */
+static void TestWall(void)
+{
+	cTestTerrain Terrain;
+	const int Max = NUM_CHUNKS * cChunkDef::Width - 1;
+	Terrain.Fill(0, 0, 0, Max, 3, Max);
+	Vector3i Source(2, 4, 2);
+	Vector3i Destination(Max - 2, 4, 2);
+
+	// Without the wall, the mob walks straight:
+	auto Legs = WalkLegs(Terrain, Source, Destination);
+	assert_test(!Legs.empty());
+	for (const auto & Leg: Legs)
+	{
+		assert_test(Leg.z < cChunkDef::Width);
+	}
+
+	// A wall two blocks high across the middle, with a gap at the far end; the mob needs to go through the gap.
+	// The legs end on the regions' borders, so the route needs to lead through the last row of chunks, the gap's:
+	Terrain.Fill(24, 4, 0, 24, 5, Max - 8);
+	Legs = WalkLegs(Terrain, Source, Destination);
+	bool HasPassedGap = false;
+	for (const auto & Leg: Legs)
+	{
+		assert_test(Leg.x != 24);
+		if (Leg.z >= 2 * cChunkDef::Width)
+		{
+			HasPassedGap = true;
+		}
+	}
+	assert_test(HasPassedGap);
+}
+
+
+
+
+
+/** Checks the route up a staircase that crosses the border of two sections. */
+static void TestStairs(void)
+{
+	cTestTerrain Terrain;
+	const int Max = NUM_CHUNKS * cChunkDef::Width - 1;
+
+	// The lower floor walked at y = 14 (section 0), the upper one at y = 22 (section 1), one step per block between them:
+	Terrain.Fill(0, 0, 0, 15, 13, Max);
+	for (int i = 0; i < 8; i++)
+	{
+		Terrain.Fill(16 + i, 0, 0, 16 + i, 14 + i, Max);
+	}
+	Terrain.Fill(24, 0, 0, Max, 21, Max);
+	Vector3i Source(2, 14, 8);
+	Vector3i Destination(Max - 2, 22, 8);
+	assert_test(Terrain.IsWalkable(Source));
+	assert_test(Terrain.IsWalkable(Destination));
+
+	auto Legs = WalkLegs(Terrain, Source, Destination);
+	assert_test(!Legs.empty());
+	assert_test(Legs.back().y >= cChunkData::SectionHeight);
+
+	// The mob goes up the stairs, never back down:
+	for (size_t i = 1; i < Legs.size(); i++)
+	{
+		assert_test(Legs[i].y >= Legs[i - 1].y);
+	}
+}
+
+
+
+
+
+/** Checks the route up a step that crosses a chunk border and a section boundary at once. */
+static void TestStepAtChunkBorder(void)
+{
+	cTestTerrain Terrain;
+	const int Max = NUM_CHUNKS * cChunkDef::Width - 1;
+
+	// The first chunk's floor is walked at y = 15, the top layer of section 0, the rest one block higher, at y = 16 in section 1;
+	// the only step up is from x = 15 to x = 16, from section 0 of the first chunk into section 1 of the next one:
+	Terrain.Fill(0, 0, 0, 15, 14, Max);
+	Terrain.Fill(16, 0, 0, Max, 15, Max);
+	Vector3i Source(2, 15, 8);
+	Vector3i Destination(Max - 2, 16, 8);
+	assert_test(Terrain.IsWalkable(Source));
+	assert_test(Terrain.IsWalkable(Destination));
+
+	auto Legs = WalkLegs(Terrain, Source, Destination);
+	assert_test(!Legs.empty());
+	assert_test(Legs.front().x >= cChunkDef::Width);
+	assert_test(Legs.front().y == cChunkData::SectionHeight);
+
+	// And back down:
+	Legs = WalkLegs(Terrain, Destination, Source);
+	assert_test(!Legs.empty());
+	assert_test(Legs.back().y == cChunkData::SectionHeight - 1);
+}
+
+
+
+
+
+/** Measures the plans across a maze of walls, first with the nav sections being built, then with them all built.
+The terrain is the test's 3 * 3 chunks, the walls two blocks high with a gap at alternating ends. */
+static void Benchmark(void)
+{
+	cTestTerrain Terrain;
+	const int Max = NUM_CHUNKS * cChunkDef::Width - 1;
+	Terrain.Fill(0, 0, 0, Max, 3, Max);
+	for (int x = 6; x < Max - 4; x += 6)
+	{
+		bool IsGapNorth = ((x / 6) % 2 == 0);
+		Terrain.Fill(x, 4, IsGapNorth ? 3 : 0, x, 5, IsGapNorth ? Max : Max - 3);
+	}
+
+	// The pairs of the sources and the destinations, on the opposite sides of the maze:
+	std::vector<std::pair<Vector3i, Vector3i>> Requests;
+	for (int z = 1; z < Max; z += 3)
+	{
+		for (int z2 = 1; z2 < Max; z2 += 7)
+		{
+			Requests.emplace_back(Vector3i(2, 4, z), Vector3i(Max - 2, 4, z2));
+		}
+	}
+
+	cNavPlanner Planner;
+	for (int Pass = 0; Pass < 2; Pass++)
+	{
+		const int NumRepeats = (Pass == 0) ? 1 : 20;
+		int NumPlanned = 0;
+		auto Start = std::chrono::steady_clock::now();
+		for (int r = 0; r < NumRepeats; r++)
+		{
+			for (const auto & Request: Requests)
+			{
+				Vector3i LegEnd;
+				if (Planner.PlanFirstLeg(Terrain, Request.first, Request.second, LegEnd))
+				{
+					NumPlanned += 1;
+				}
+			}
+		}
+		auto Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Start).count();
+		assert_test(NumPlanned == NumRepeats * static_cast<int>(Requests.size()));
+		LOG("%s: %d plans in %.1f ms, %.1f us per plan, " SIZE_T_FMT " nav sections",
+			(Pass == 0) ? "Building the nav sections" : "Nav sections built",
+			NumPlanned, static_cast<double>(Elapsed) / 1000, static_cast<double>(Elapsed) / NumPlanned, Terrain.GetNumNavSections()
+		);
+	}
+}
+
+
+
+
+
+/** Checks that the planner leaves the paths it can't plan to the block-level search. */
+static void TestNoRoute(void)
+{
+	cTestTerrain Terrain;
+	const int Max = NUM_CHUNKS * cChunkDef::Width - 1;
+	Terrain.Fill(0, 0, 0, Max, 3, Max);
+	cNavPlanner Planner;
+	Vector3i LegEnd;
+
+	// A destination walled in all around:
+	Terrain.Fill(36, 4, 36, 44, 5, 36);
+	Terrain.Fill(36, 4, 44, 44, 5, 44);
+	Terrain.Fill(36, 4, 36, 36, 5, 44);
+	Terrain.Fill(44, 4, 36, 44, 5, 44);
+	assert_test(!Planner.PlanFirstLeg(Terrain, Vector3i(2, 4, 2), Vector3i(40, 4, 40), LegEnd));
+
+	// A destination in the air, where there are no regions:
+	assert_test(!Planner.PlanFirstLeg(Terrain, Vector3i(2, 4, 2), Vector3i(20, 10, 30), LegEnd));
+
+	// A destination outside of the loaded chunks:
+	assert_test(!Planner.PlanFirstLeg(Terrain, Vector3i(2, 4, 2), Vector3i(2, 4, 60), LegEnd));
+
+	// A destination close enough for the block-level search alone:
+	assert_test(!Planner.PlanFirstLeg(Terrain, Vector3i(2, 4, 2), Vector3i(12, 4, 2), LegEnd));
+
+	// A destination outside of the walls is planned:
+	assert_test(Planner.PlanFirstLeg(Terrain, Vector3i(2, 4, 2), Vector3i(40, 4, 30), LegEnd));
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	for (size_t i = 0; i < ARRAYCOUNT(g_IsSolid); i++)
+	{
+		g_IsSolid[i] = (i != E_BLOCK_AIR);
+	}
+
+	LOGD("Testing the route around a wall");
+	TestWall();
+
+	LOGD("Testing the route up the stairs");
+	TestStairs();
+
+	LOGD("Testing the step across a chunk border and a section boundary");
+	TestStepAtChunkBorder();
+
+	LOGD("Testing the paths without a route");
+	TestNoRoute();
+
+	LOGD("Benchmarking the plans through a maze");
+	Benchmark();
+
+	LOG("NavPlanner test finished");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,240 @@
+
+// NavSectionTest.cpp
+
+// Implements the test for the cNavSection class representing the walkable regions of a chunk section
+
+#include "Globals.h"
+#include "BlockID.h"
+#include "Mobs/NavSection.h"
+
+
+
+
+
+/** The block types of a single section, with helpers for building the test terrain. */
+class cTestSection
+{
+public:
+	cTestSection(void)
+	{
+		memset(m_BlockTypes, 0, sizeof(m_BlockTypes));
+	}
+
+	/** Fills the specified box (inclusive) with stone. */
+	void Fill(int a_MinX, int a_MinY, int a_MinZ, int a_MaxX, int a_MaxY, int a_MaxZ)
+	{
+		for (int y = a_MinY; y <= a_MaxY; y++)
+		{
+			for (int z = a_MinZ; z <= a_MaxZ; z++)
+			{
+				for (int x = a_MinX; x <= a_MaxX; x++)
+				{
+					m_BlockTypes[cChunkDef::MakeIndexNoCheck(x, y, z)] = E_BLOCK_STONE;
+				}
+			}
+		}
+	}
+
+	BLOCKTYPE m_BlockTypes[cChunkData::SectionBlockCount];
+} ;
+
+
+
+
+
+/** The table of solid blocks used by the tests: everything but air. */
+static bool g_IsSolid[256];
+
+
+
+
+
+/** Returns the index of the neighboring section at the specified offset, for cNavSection::GetPortals(). */
+static int GetNeighbor(int a_OffsetX, int a_OffsetY, int a_OffsetZ)
+{
+	for (int i = 0; i < cNavSection::NUM_NEIGHBORS; i++)
+	{
+		if (cNavSection::GetNeighborOffset(i) == Vector3i(a_OffsetX, a_OffsetY, a_OffsetZ))
+		{
+			return i;
+		}
+	}
+	assert_test(!"No such neighbor");
+	return -1;
+}
+
+
+
+
+
+/** Checks the regions of sections with a floor and walls of various heights. */
+static void TestRegions(void)
+{
+	// A flat floor is a single region, right above it:
+	cTestSection Floor;
+	Floor.Fill(0, 0, 0, 15, 3, 15);
+	cNavSection Flat(nullptr, Floor.m_BlockTypes, nullptr, g_IsSolid);
+	assert_test(Flat.GetNumRegions() == 1);
+	assert_test(Flat.GetRegion(5, 4, 5) != cNavSection::NO_REGION);
+	assert_test(Flat.GetRegion(5, 3, 5) == cNavSection::NO_REGION);
+	assert_test(Flat.GetRegion(5, 5, 5) == cNavSection::NO_REGION);
+
+	// A wall one block high can be stepped over:
+	cTestSection LowWall(Floor);
+	LowWall.Fill(8, 4, 0, 8, 4, 15);
+	cNavSection Low(nullptr, LowWall.m_BlockTypes, nullptr, g_IsSolid);
+	assert_test(Low.GetNumRegions() == 1);
+	assert_test(Low.GetRegion(8, 5, 3) == Low.GetRegion(0, 4, 3));
+
+	// A wall two blocks high splits the floor, its top is a separate region:
+	cTestSection HighWall(Floor);
+	HighWall.Fill(8, 4, 0, 8, 5, 15);
+	cNavSection High(nullptr, HighWall.m_BlockTypes, nullptr, g_IsSolid);
+	assert_test(High.GetNumRegions() == 3);
+	assert_test(High.GetRegion(0, 4, 3) != High.GetRegion(15, 4, 3));
+	assert_test(High.GetRegion(8, 6, 3) != cNavSection::NO_REGION);
+	assert_test(High.GetRegion(8, 6, 3) != High.GetRegion(0, 4, 3));
+	assert_test(High.GetRegion(8, 6, 3) != High.GetRegion(15, 4, 3));
+
+	// The floor may be the top layer of the section below, the ceiling the bottom layer of the section above:
+	cTestSection Full;
+	Full.Fill(0, 0, 0, 15, 15, 15);
+	cTestSection Empty;
+	cNavSection Bottom(Full.m_BlockTypes, nullptr, nullptr, g_IsSolid);
+	assert_test(Bottom.GetNumRegions() == 1);
+	assert_test(Bottom.GetRegion(7, 0, 7) != cNavSection::NO_REGION);
+	cTestSection Ceiling;
+	Ceiling.Fill(0, 14, 0, 15, 14, 15);
+	cNavSection Top(nullptr, Ceiling.m_BlockTypes, Full.m_BlockTypes, g_IsSolid);
+	assert_test(Top.GetNumRegions() == 0);
+	assert_test(Top.GetRegion(7, 15, 7) == cNavSection::NO_REGION);
+	cNavSection Air(nullptr, Empty.m_BlockTypes, nullptr, g_IsSolid);
+	assert_test(Air.GetNumRegions() == 0);
+}
+
+
+
+
+
+/** Checks the portals between neighboring sections. */
+static void TestPortals(void)
+{
+	std::vector<cNavSection::sPortal> Portals;
+
+	// Two flat floors next to each other in X are connected along the whole border:
+	cTestSection Floor;
+	Floor.Fill(0, 0, 0, 15, 3, 15);
+	cNavSection Flat(nullptr, Floor.m_BlockTypes, nullptr, g_IsSolid);
+	Flat.GetPortals(Flat.GetRegion(0, 4, 0), Flat, GetNeighbor(1, 0, 0), Portals);
+	assert_test(Portals.size() == 16);
+	for (const auto & Portal: Portals)
+	{
+		assert_test(Portal.m_ToRegion == Flat.GetRegion(0, 4, 0));
+		assert_test((Portal.m_ToCell.x == 0) && (Portal.m_ToCell.y == 4));
+	}
+
+	// A floor one block higher in Z can be stepped on, two blocks higher can't:
+	cTestSection Higher;
+	Higher.Fill(0, 0, 0, 15, 4, 15);
+	cNavSection Step(nullptr, Higher.m_BlockTypes, nullptr, g_IsSolid);
+	Portals.clear();
+	Flat.GetPortals(Flat.GetRegion(0, 4, 0), Step, GetNeighbor(0, 0, -1), Portals);
+	assert_test(Portals.size() == 16);
+	assert_test(Portals[0].m_ToCell.z == 15);
+	cTestSection Highest;
+	Highest.Fill(0, 0, 0, 15, 5, 15);
+	cNavSection Cliff(nullptr, Highest.m_BlockTypes, nullptr, g_IsSolid);
+	Portals.clear();
+	Flat.GetPortals(Flat.GetRegion(0, 4, 0), Cliff, GetNeighbor(0, 0, -1), Portals);
+	assert_test(Portals.empty());
+
+	// A step up from the top layer of a section into the section above:
+	cTestSection Lower;
+	Lower.Fill(0, 14, 0, 15, 14, 15);
+	Lower.Fill(8, 15, 0, 15, 15, 15);
+	cTestSection Empty;
+	cNavSection LowerNav(nullptr, Lower.m_BlockTypes, Empty.m_BlockTypes, g_IsSolid);
+	cNavSection UpperNav(Lower.m_BlockTypes, Empty.m_BlockTypes, nullptr, g_IsSolid);
+	assert_test(LowerNav.GetRegion(7, 15, 0) != cNavSection::NO_REGION);
+	assert_test(UpperNav.GetRegion(8, 0, 0) != cNavSection::NO_REGION);
+	Portals.clear();
+	LowerNav.GetPortals(LowerNav.GetRegion(7, 15, 0), UpperNav, GetNeighbor(0, 1, 0), Portals);
+	assert_test(Portals.size() == 16);
+	for (const auto & Portal: Portals)
+	{
+		assert_test((Portal.m_ToCell.x == 8) && (Portal.m_ToCell.y == 0));
+	}
+	Portals.clear();
+	UpperNav.GetPortals(UpperNav.GetRegion(8, 0, 0), LowerNav, GetNeighbor(0, -1, 0), Portals);
+	assert_test(Portals.size() == 16);
+	for (const auto & Portal: Portals)
+	{
+		assert_test((Portal.m_ToCell.x == 7) && (Portal.m_ToCell.y == 15));
+	}
+
+	// A step up across a chunk border and a section boundary at once: the floor is walked at y = 15 up to the border,
+	// the next chunk's floor one block higher, at y = 0 of the section above:
+	cTestSection Border;
+	Border.Fill(0, 0, 0, 15, 14, 15);
+	cTestSection NextBorder;
+	NextBorder.Fill(0, 0, 0, 15, 15, 15);
+	cNavSection BorderNav(nullptr, Border.m_BlockTypes, Empty.m_BlockTypes, g_IsSolid);
+	cNavSection NextAboveNav(NextBorder.m_BlockTypes, Empty.m_BlockTypes, nullptr, g_IsSolid);
+	UInt8 BorderRegion = BorderNav.GetRegion(15, 15, 3);
+	assert_test(BorderRegion != cNavSection::NO_REGION);
+	assert_test(NextAboveNav.GetRegion(0, 0, 3) != cNavSection::NO_REGION);
+	Portals.clear();
+	assert_test(BorderNav.HasExits(BorderRegion, GetNeighbor(1, 1, 0)));
+	BorderNav.GetPortals(BorderRegion, NextAboveNav, GetNeighbor(1, 1, 0), Portals);
+	assert_test(Portals.size() == 16);
+	for (const auto & Portal: Portals)
+	{
+		assert_test((Portal.m_ToCell.x == 0) && (Portal.m_ToCell.y == 0));
+	}
+
+	// And back down:
+	Portals.clear();
+	NextAboveNav.GetPortals(NextAboveNav.GetRegion(0, 0, 3), BorderNav, GetNeighbor(-1, -1, 0), Portals);
+	assert_test(Portals.size() == 16);
+	for (const auto & Portal: Portals)
+	{
+		assert_test((Portal.m_ToCell.x == 15) && (Portal.m_ToCell.y == 15));
+	}
+
+	// The regions in the middle of a section have no exits at all:
+	cTestSection Pit(Floor);
+	Pit.Fill(4, 4, 4, 11, 5, 4);
+	Pit.Fill(4, 4, 11, 11, 5, 11);
+	Pit.Fill(4, 4, 4, 4, 5, 11);
+	Pit.Fill(11, 4, 4, 11, 5, 11);
+	cNavSection PitNav(nullptr, Pit.m_BlockTypes, nullptr, g_IsSolid);
+	UInt8 PitRegion = PitNav.GetRegion(7, 4, 7);
+	assert_test(PitRegion != PitNav.GetRegion(0, 4, 0));
+	for (int i = 0; i < cNavSection::NUM_NEIGHBORS; i++)
+	{
+		assert_test(!PitNav.HasExits(PitRegion, i));
+	}
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	for (size_t i = 0; i < ARRAYCOUNT(g_IsSolid); i++)
+	{
+		g_IsSolid[i] = (i != E_BLOCK_AIR);
+	}
+
+	LOGD("Testing the regions");
+	TestRegions();
+
+	LOGD("Testing the portals");
+	TestPortals();
+
+	LOG("NavSection test finished");
+	return 0;
+}
@@ -0,0 +1,366 @@
+
+// PathSearchBenchmark.cpp
+
+// Implements a benchmark of the cPathFinderService, the way the world drives it
+// A fixed test terrain of 4 * 4 chunks models a dense mob farm: every chunk is a spawning pad with stone pillars
+// and a fenced collection pit in its middle, crowded by mobs that all path towards the pit. Each tick, a share of
+// the mobs requests its path from the service through RequestPath(), the same as the cPathFinders do; the tick
+// waits for the paths and ends with the service's Tick(). This covers the whole service: the nav planner, the
+// snapshots with the per-tick section copies, the path cache and the searches on the worker threads.
+// The benchmark runs with zero (searching on the "world thread"), one, two and four workers and reports the time
+// per tick, the paths per second and the share of the requests that the path cache served. It also checks that all
+// the paths are found and are the same regardless of the number of workers.
+// The farm is benchmarked twice: on a solid floor at the bottom of the world, and as an elevated farm, with pads
+// only one block thick, high above the air, which is how the mob farms are usually built.
+
+#include "Globals.h"
+#include "Defines.h"
+#include "Mobs/PathFinderService.h"
+
+
+
+
+
+/** The size of the area crowded by the mobs, in chunks. */
+static const int NUM_CHUNKS_X = 4;
+static const int NUM_CHUNKS_Z = 4;
+
+/** The Y coord of the spawning pads, right above the floor, relative to the farm's section. */
+static const int FLOOR_TOP = 4;
+
+/** The section of the elevated farm; the sections below it are air. */
+static const int ELEVATED_FARM_SECTION = 2;
+
+/** The number of mobs crowding each chunk. */
+static const int NUM_MOBS_PER_CHUNK = 250;
+
+/** Each mob requests its path once per this many ticks, a different share of the mobs in each tick. */
+static const int REQUEST_INTERVAL = 10;
+
+/** The number of ticks simulated for each worker count. */
+static const int NUM_TICKS = 40;
+
+
+
+
+
+/** A single mob's path request. */
+struct sRequest
+{
+	Vector3i m_Source;
+	Vector3i m_Destination;
+};
+
+
+
+
+
+/** Returns the section for the specified chunk of the mob farm. All the chunks are the same.
+The floor is solid down to the bottom of the section, unless a_IsElevated, then it is only the single layer of the pads,
+and the pits have a floor of their own. */
+static cPathSnapshot::cSectionPtr BuildFarmSection(bool a_IsElevated)
+{
+	auto Section = std::make_shared<cPathSnapshot::sSection>();
+	memset(Section->m_BlockTypes, 0, sizeof(Section->m_BlockTypes));
+	memset(Section->m_BlockMetas, 0, sizeof(Section->m_BlockMetas));
+	for (int z = 0; z < cChunkDef::Width; z++)
+	{
+		for (int x = 0; x < cChunkDef::Width; x++)
+		{
+			for (int y = a_IsElevated ? (FLOOR_TOP - 1) : 0; y < FLOOR_TOP; y++)
+			{
+				Section->m_BlockTypes[cChunkDef::MakeIndexNoCheck(x, y, z)] = E_BLOCK_STONE;
+			}
+
+			// Pillars, 2 blocks high, on a grid:
+			if ((x % 4 == 1) && (z % 4 == 1) && ((x < 6) || (x > 9) || (z < 6) || (z > 9)))
+			{
+				Section->m_BlockTypes[cChunkDef::MakeIndexNoCheck(x, FLOOR_TOP, z)] = E_BLOCK_STONE;
+				Section->m_BlockTypes[cChunkDef::MakeIndexNoCheck(x, FLOOR_TOP + 1, z)] = E_BLOCK_STONE;
+			}
+
+			// The collection pit, fenced on all sides but the south one:
+			bool IsPitEdge = ((x == 6) || (x == 9) || (z == 6)) && (x >= 6) && (x <= 9) && (z >= 6) && (z <= 9);
+			if (IsPitEdge)
+			{
+				Section->m_BlockTypes[cChunkDef::MakeIndexNoCheck(x, FLOOR_TOP, z)] = E_BLOCK_FENCE;
+			}
+			else if ((x > 6) && (x < 9) && (z > 6) && (z <= 9))
+			{
+				Section->m_BlockTypes[cChunkDef::MakeIndexNoCheck(x, FLOOR_TOP - 1, z)] = E_BLOCK_AIR;
+				if (a_IsElevated)
+				{
+					Section->m_BlockTypes[cChunkDef::MakeIndexNoCheck(x, FLOOR_TOP - 2, z)] = E_BLOCK_STONE;
+				}
+			}
+		}
+	}
+	return Section;
+}
+
+
+
+
+
+/** The mob farm, as seen by the cPathFinderService. The farm continues beyond the crowded chunks, so that all the chunks
+are available: one section of each chunk is the farm section, all the others are air. */
+class cFarmBlocks :
+	public cPathFinderService::cBlockSource
+{
+public:
+
+	cFarmBlocks(const bool * a_IsSolid, bool a_IsElevated):
+		m_Section(BuildFarmSection(a_IsElevated)),
+		m_FarmSection(a_IsElevated ? ELEVATED_FARM_SECTION : 0),
+		m_IsSolid(a_IsSolid),
+		m_NumCopies(0)
+	{
+	}
+
+	/** Returns the farm section. */
+	const cPathSnapshot::sSection & GetSection(void) const { return *m_Section; }
+
+	/** Returns the Y coord of the bottom of the farm section. */
+	int GetBaseY(void) const { return m_FarmSection * cChunkData::SectionHeight; }
+
+	/** Returns the number of sections copied by the service so far. */
+	int GetNumCopies(void) const { return m_NumCopies; }
+
+	virtual bool IsChunkAvailable(int a_ChunkX, int a_ChunkZ) override
+	{
+		return true;
+	}
+
+	virtual bool CopySection(int a_ChunkX, int a_SectionNum, int a_ChunkZ, cPathSnapshot::sSection & a_Section) override
+	{
+		if (a_SectionNum != m_FarmSection)
+		{
+			return false;
+		}
+		m_NumCopies += 1;
+		memcpy(&a_Section, m_Section.get(), sizeof(a_Section));
+		return true;
+	}
+
+	virtual const cNavSection * GetNavSection(int a_ChunkX, int a_SectionNum, int a_ChunkZ) override
+	{
+		auto & NavSection = m_NavSections[Vector3i(a_ChunkX, a_SectionNum, a_ChunkZ)];
+		if (NavSection == nullptr)
+		{
+			NavSection.reset(new cNavSection(
+				(a_SectionNum == m_FarmSection + 1) ? m_Section->m_BlockTypes : nullptr,
+				(a_SectionNum == m_FarmSection)     ? m_Section->m_BlockTypes : nullptr,
+				(a_SectionNum == m_FarmSection - 1) ? m_Section->m_BlockTypes : nullptr,
+				m_IsSolid
+			));
+		}
+		return NavSection.get();
+	}
+
+protected:
+
+	cPathSnapshot::cSectionPtr m_Section;
+
+	/** The section number of the farm section in each chunk. */
+	int m_FarmSection;
+
+	const bool * m_IsSolid;
+
+	int m_NumCopies;
+
+	std::unordered_map<Vector3i, std::unique_ptr<cNavSection>, VectorHasher<int>> m_NavSections;
+} ;
+
+
+
+
+
+/** Returns the mobs' path requests: the mobs are scattered over the free cells of each chunk's floor, heading for the chunk's pit.
+Uses a fixed LCG, so that the requests are the same in each run. */
+static std::vector<sRequest> BuildRequests(const cFarmBlocks & a_Blocks)
+{
+	const auto & Section = a_Blocks.GetSection();
+	const int BaseY = a_Blocks.GetBaseY();
+	std::vector<sRequest> Res;
+	UInt32 Seed = 12345;
+	for (int ChunkZ = 0; ChunkZ < NUM_CHUNKS_Z; ChunkZ++)
+	{
+		for (int ChunkX = 0; ChunkX < NUM_CHUNKS_X; ChunkX++)
+		{
+			Vector3i Pit(ChunkX * cChunkDef::Width + 7, BaseY + FLOOR_TOP - 1, ChunkZ * cChunkDef::Width + 8);
+			int NumMobs = 0;
+			while (NumMobs < NUM_MOBS_PER_CHUNK)
+			{
+				Seed = Seed * 1103515245u + 12345u;
+				int RelX = static_cast<int>((Seed >> 16) % cChunkDef::Width);
+				Seed = Seed * 1103515245u + 12345u;
+				int RelZ = static_cast<int>((Seed >> 16) % cChunkDef::Width);
+				if (Section.m_BlockTypes[cChunkDef::MakeIndexNoCheck(RelX, FLOOR_TOP, RelZ)] != E_BLOCK_AIR)
+				{
+					continue;
+				}
+				if (Section.m_BlockTypes[cChunkDef::MakeIndexNoCheck(RelX, FLOOR_TOP - 1, RelZ)] == E_BLOCK_AIR)
+				{
+					// Above the pit
+					continue;
+				}
+				Res.push_back({Vector3i(ChunkX * cChunkDef::Width + RelX, BaseY + FLOOR_TOP, ChunkZ * cChunkDef::Width + RelZ), Pit});
+				NumMobs += 1;
+			}
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+/** The results of a single benchmark run. */
+struct sRunStats
+{
+	/** The number of path requests made and the number of paths found. */
+	int m_NumRequests;
+	int m_NumFound;
+
+	/** The number of distinct jobs returned by the service, i.e. the searches actually run. */
+	int m_NumJobs;
+
+	/** The total and the longest tick time. */
+	std::chrono::duration<double, std::milli> m_TotalTime;
+	std::chrono::duration<double, std::milli> m_MaxTickTime;
+
+	/** The checksum of all the paths received. */
+	UInt64 m_Checksum;
+};
+
+
+
+
+
+/** Simulates NUM_TICKS ticks of the mob farm with a service with the specified number of workers. */
+static sRunStats RunTicks(const bool * a_IsSolid, cFarmBlocks & a_Blocks, const std::vector<sRequest> & a_Requests, int a_NumWorkers)
+{
+	sRunStats Stats;
+	Stats.m_NumRequests = 0;
+	Stats.m_NumFound = 0;
+	Stats.m_NumJobs = 0;
+	Stats.m_TotalTime = std::chrono::duration<double, std::milli>(0);
+	Stats.m_MaxTickTime = std::chrono::duration<double, std::milli>(0);
+	Stats.m_Checksum = 0;
+
+	cPathFinderService Service(a_IsSolid);
+	Service.Start(a_NumWorkers);
+	std::set<cPathFinderService::cJobPtr> AllJobs;  // Keeps the jobs alive, so that their pointers are unique
+	std::vector<std::pair<size_t, cPathFinderService::cJobPtr>> TickJobs;
+	for (int Tick = 0; Tick < NUM_TICKS; Tick++)
+	{
+		auto Start = std::chrono::steady_clock::now();
+
+		// The mobs whose turn it is request their paths, the same way the cPathFinder does:
+		TickJobs.clear();
+		for (size_t i = static_cast<size_t>(Tick % REQUEST_INTERVAL); i < a_Requests.size(); i += REQUEST_INTERVAL)
+		{
+			const auto & Request = a_Requests[i];
+			Vector3d Source(Request.m_Source.x + 0.5, Request.m_Source.y, Request.m_Source.z + 0.5);
+			Vector3d Destination(Request.m_Destination.x + 0.5, Request.m_Destination.y, Request.m_Destination.z + 0.5);
+			TickJobs.emplace_back(i, Service.RequestPath(a_Blocks, Source, Destination, 1, 2));
+		}
+
+		// Wait for the paths; the mobs would poll them in the following ticks instead:
+		for (const auto & Job: TickJobs)
+		{
+			while (!Job.second->IsDone())
+			{
+				std::this_thread::yield();
+			}
+		}
+		Service.Tick();
+		std::chrono::duration<double, std::milli> TickTime = std::chrono::steady_clock::now() - Start;
+		Stats.m_TotalTime += TickTime;
+		Stats.m_MaxTickTime = std::max(Stats.m_MaxTickTime, TickTime);
+
+		for (const auto & Job: TickJobs)
+		{
+			const auto & Result = Job.second->GetResult();
+			Stats.m_NumRequests += 1;
+			AllJobs.insert(Job.second);
+			if (Result.m_Status != ePathFinderStatus::PATH_FOUND)
+			{
+				continue;
+			}
+			Stats.m_NumFound += 1;
+			Stats.m_Checksum += Result.m_PathPoints.size();
+			for (const auto & Point: Result.m_PathPoints)
+			{
+				Stats.m_Checksum += static_cast<UInt64>(Point.x * 31 + Point.y * 17 + Point.z) * (Job.first + 1);
+			}
+		}
+	}
+	Service.Stop();
+	Stats.m_NumJobs = static_cast<int>(AllJobs.size());
+	return Stats;
+}
+
+
+
+
+
+/** Runs the benchmark over the mob farm, either on the solid floor or elevated, with zero to four workers. */
+static void BenchmarkFarm(const bool * a_IsSolid, bool a_IsElevated)
+{
+	cFarmBlocks Blocks(a_IsSolid, a_IsElevated);
+	auto Requests = BuildRequests(Blocks);
+	LOG("%s farm: %u mobs, each requesting its path every %d ticks, %d ticks per run",
+		a_IsElevated ? "Elevated" : "Ground", static_cast<unsigned>(Requests.size()), REQUEST_INTERVAL, NUM_TICKS
+	);
+
+	UInt64 ExpectedChecksum = 0;
+	for (int NumWorkers = 0; NumWorkers <= 4; NumWorkers = std::max(NumWorkers * 2, 1))
+	{
+		int NumCopiesBefore = Blocks.GetNumCopies();
+		auto Stats = RunTicks(a_IsSolid, Blocks, Requests, NumWorkers);
+
+		// All the mobs reach the pit, along the same paths regardless of the number of workers:
+		assert_test(Stats.m_NumFound == Stats.m_NumRequests);
+		if (ExpectedChecksum == 0)
+		{
+			ExpectedChecksum = Stats.m_Checksum;
+		}
+		assert_test(Stats.m_Checksum == ExpectedChecksum);
+
+		LOG("%d worker(s): %.2f ms per tick (max %.2f ms), %.0f paths per second; %d searches for %d requests, the cache served %.1f %%; %d section copies",
+			NumWorkers, Stats.m_TotalTime.count() / NUM_TICKS, Stats.m_MaxTickTime.count(),
+			static_cast<double>(Stats.m_NumRequests) * 1000 / Stats.m_TotalTime.count(),
+			Stats.m_NumJobs, Stats.m_NumRequests,
+			100.0 * static_cast<double>(Stats.m_NumRequests - Stats.m_NumJobs) / static_cast<double>(Stats.m_NumRequests),
+			Blocks.GetNumCopies() - NumCopiesBefore
+		);
+	}
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Benchmark started");
+
+	// Everything but air is solid, the fences are further handled as special blocks by the search:
+	bool IsSolid[256];
+	for (size_t i = 0; i < ARRAYCOUNT(IsSolid); i++)
+	{
+		IsSolid[i] = (i != E_BLOCK_AIR);
+	}
+
+	BenchmarkFarm(IsSolid, false);
+	BenchmarkFarm(IsSolid, true);
+
+	LOG("PathSearchBenchmark finished");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,130 @@
+
+// BroadcastBenchmark.cpp
+
+// Implements the benchmark of broadcasting packets to many clients
+// The same broadcasts are sent through each client's own send functions, serializing, framing and compressing them for
+// every client, and through cSharedBroadcast, encoding them once per protocol version and queueing the shared result
+// to the other clients. Both paths run through the real protocols, from the client's send functions to the data handed
+// to the link at the end of the tick.
+// The clients are unencrypted; for the encrypted ones, the encryption adds the same per-client cost to both paths.
+// Usage: BroadcastBenchmark [<NumClients> [<NumBroadcasts>]]
+
+#include "Globals.h"
+#include "Broadcaster.h"
+#include "Root.h"
+#include "TestClients.h"
+
+
+
+
+
+/** The number of broadcasts after which the clients' outgoing data is flushed, as if a tick ended. */
+static const int BROADCASTS_PER_TICK = 100;
+
+
+
+
+
+/** Runs a_NumBroadcasts broadcasts to the clients, through cSharedBroadcast if a_IsShared is set, otherwise through
+each client's own send functions. Flushes the clients' data every tick. Returns the number of broadcasts per second. */
+static double Measure(std::vector<sTestClient> & a_Clients, int a_NumBroadcasts, bool a_IsShared)
+{
+	size_t NumBytesBefore = 0;
+	for (const auto & Client: a_Clients)
+	{
+		NumBytesBefore += Client.m_Link->m_NumBytes;
+	}
+
+	auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < a_NumBroadcasts; i++)
+	{
+		if (a_IsShared)
+		{
+			cSharedBroadcast Broadcast([i](cClientHandle & a_Client)
+				{
+					SendBroadcastPacket(a_Client, i);
+				}
+			);
+			for (auto & Client: a_Clients)
+			{
+				Broadcast.SendTo(*Client.m_Client);
+			}
+		}
+		else
+		{
+			for (auto & Client: a_Clients)
+			{
+				SendBroadcastPacket(*Client.m_Client, i);
+			}
+		}
+		if (((i + 1) % BROADCASTS_PER_TICK == 0) || (i + 1 == a_NumBroadcasts))
+		{
+			for (auto & Client: a_Clients)
+			{
+				Client.m_Client->ServerTick(0);
+			}
+		}
+	}
+	auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - Start).count();
+
+	size_t NumBytes = 0;
+	for (const auto & Client: a_Clients)
+	{
+		NumBytes += Client.m_Link->m_NumBytes;
+	}
+	printf("  %8.0f broadcasts / sec, %7.2f usec / broadcast, %6.1f MiB sent\n",
+		static_cast<double>(a_NumBroadcasts) / Elapsed,
+		Elapsed * 1e6 / static_cast<double>(a_NumBroadcasts),
+		static_cast<double>(NumBytes - NumBytesBefore) / 1024 / 1024
+	);
+	return static_cast<double>(a_NumBroadcasts) / Elapsed;
+}
+
+
+
+
+
+/** Measures both paths for a_NumClients clients, all talking the newest protocol version, or spread evenly over all
+the supported versions if a_ShouldMixVersions is set. */
+static void Benchmark(int a_NumClients, int a_NumBroadcasts, bool a_ShouldMixVersions)
+{
+	std::vector<sTestClient> Clients;
+	for (int i = 0; i < a_NumClients; i++)
+	{
+		size_t Version = a_ShouldMixVersions ? (static_cast<size_t>(i) % ARRAYCOUNT(g_ProtocolVersions)) : (ARRAYCOUNT(g_ProtocolVersions) - 1);
+		Clients.push_back(CreateTestClient(g_ProtocolVersions[Version], false));
+	}
+	printf("%d clients, %s, %d broadcasts:\n",
+		a_NumClients, a_ShouldMixVersions ? "all protocol versions" : "a single protocol version", a_NumBroadcasts
+	);
+
+	printf("Per-client encoding:\n");
+	double PerClient = Measure(Clients, a_NumBroadcasts, false);
+	printf("Shared encoding:\n");
+	double Shared = Measure(Clients, a_NumBroadcasts, true);
+	printf("Speedup: %.2fx\n\n", Shared / PerClient);
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	int NumClients = (argc > 1) ? atoi(argv[1]) : 200;
+	int NumBroadcasts = (argc > 2) ? atoi(argv[2]) : 20000;
+	if ((NumClients <= 0) || (NumBroadcasts <= 0))
+	{
+		LOGERROR("Usage: BroadcastBenchmark [<NumClients> [<NumBroadcasts>]]");
+		return 1;
+	}
+
+	cRoot Root;
+	Benchmark(NumClients, NumBroadcasts, false);
+	Benchmark(NumClients, NumBroadcasts, true);
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,604 @@
+
+// ClientHandle.cpp
+
+// Mocks the cClientHandle class used by the tests
+// The client talks to the real protocol, created by the real protocol recognizer, and queues the outgoing data the same
+// way as the real client. Only the flush is simplified, ServerTick() hands the queued data to the link and does nothing
+// else. The functions that send packets and the broadcast functions are the same as in the real client; the packets
+// that the client receives are parsed by the protocol, but the client's handlers do nothing. The client has a mock
+// player (Player.cpp) for the protocol's handlers that use it.
+
+#include "Globals.h"
+#include "ClientHandle.h"
+#include "Entities/Player.h"
+#include "Protocol/PingResponder.h"
+#include "Protocol/ProtocolRecognizer.h"
+
+
+
+
+
+cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
+	m_LastSentDimension(dimNotSet),
+	m_ForgeHandshake(this),
+	m_CurrentViewDistance(a_ViewDistance),
+	m_RequestedViewDistance(a_ViewDistance),
+	m_IPString(a_IPString),
+	m_IsDecodingAsync(false),
+	m_Player(nullptr),
+	m_CachedSentChunk(0, 0),
+	m_HasSentDC(false),
+	m_State(csPlaying),
+	m_NumExplosionsThisTick(0),
+	m_UniqueID(1),
+	m_ProtocolVersion(0),
+	m_NumPacketsSent(0),
+	m_NumBytesSent(0),
+	m_NumBytesCopied(0),
+	m_NumStatsTicks(0),
+	m_PacketsPerTick(0),
+	m_BytesPerTick(0),
+	m_CopiedBytesPerByteSent(0)
+{
+	m_Protocol = cpp14::make_unique<cProtocolRecognizer>(this);
+
+	// The client has its player from the start, for the packet handlers that use it. The client owns the player:
+	m_Player = new cPlayer(nullptr, "TestPlayer");
+}
+
+
+
+
+
+cClientHandle::~cClientHandle()
+{
+	delete m_Player;
+	m_Player = nullptr;
+}
+
+
+
+
+
+void cClientHandle::ServerTick(float a_Dt)
+{
+	UNUSED(a_Dt);
+
+	// Send any queued outgoing data, all in a single flush:
+	cSendChain OutgoingData;
+	{
+		cCSLock Lock(m_CSOutgoingData);
+		std::swap(OutgoingData, m_OutgoingData);
+	}
+	if ((m_Link != nullptr) && !OutgoingData.IsEmpty())
+	{
+		m_Link->Send(OutgoingData);
+		m_NumBytesSent += OutgoingData.GetSize();
+		m_NumBytesCopied += OutgoingData.GetNumBytesCopied();
+	}
+}
+
+
+
+
+
+void cClientHandle::Kick(const AString & a_Reason)
+{
+	LOGWARNING("The test client would have been kicked: %s", a_Reason.c_str());
+}
+
+
+
+
+
+void cClientHandle::PacketBufferFull(void)
+{
+}
+
+
+
+
+
+void cClientHandle::PacketUnknown(UInt32 a_PacketType)
+{
+	UNUSED(a_PacketType);
+}
+
+
+
+
+
+void cClientHandle::PacketError(UInt32 a_PacketType)
+{
+	UNUSED(a_PacketType);
+}
+
+
+
+
+
+void cClientHandle::SendData(const char * a_Data, size_t a_Size)
+{
+	if (m_HasSentDC)
+	{
+		return;
+	}
+
+	cCSLock Lock(m_CSOutgoingData);
+	m_OutgoingData.Append(a_Data, a_Size);
+}
+
+
+
+
+
+void cClientHandle::SendSharedData(const cSendChain::cSlicePtr & a_Data)
+{
+	if (m_HasSentDC)
+	{
+		return;
+	}
+
+	cCSLock Lock(m_CSOutgoingData);
+	m_OutgoingData.AppendShared(a_Data);
+}
+
+
+
+
+
+UInt32 cClientHandle::GetBroadcastKey(void)
+{
+	if (m_HasSentDC)
+	{
+		return 0;
+	}
+	return m_Protocol->GetBroadcastKey();
+}
+
+
+
+
+
+cSendChain::cSlicePtr cClientHandle::EncodeBroadcast(const std::function<void()> & a_SendFn)
+{
+	return m_Protocol->EncodeBroadcast(a_SendFn);
+}
+
+
+
+
+
+void cClientHandle::SendEncodedBroadcast(const cSendChain::cSlicePtr & a_Data)
+{
+	m_Protocol->SendEncodedBroadcast(a_Data);
+}
+
+
+
+
+
+void cClientHandle::SendBlockAction(int a_BlockX, int a_BlockY, int a_BlockZ, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType)
+{
+	m_Protocol->SendBlockAction(a_BlockX, a_BlockY, a_BlockZ, a_Byte1, a_Byte2, a_BlockType);
+}
+
+
+
+
+
+void cClientHandle::SendBlockBreakAnim(UInt32 a_EntityID, int a_BlockX, int a_BlockY, int a_BlockZ, char a_Stage)
+{
+	m_Protocol->SendBlockBreakAnim(a_EntityID, a_BlockX, a_BlockY, a_BlockZ, a_Stage);
+}
+
+
+
+
+
+void cClientHandle::SendExplosion(double a_BlockX, double a_BlockY, double a_BlockZ, float a_Radius, const cVector3iArray & a_BlocksAffected, const Vector3d & a_PlayerMotion)
+{
+	m_Protocol->SendExplosion(a_BlockX, a_BlockY, a_BlockZ, a_Radius, a_BlocksAffected, a_PlayerMotion);
+}
+
+
+
+
+
+void cClientHandle::SendParticleEffect(const AString & a_ParticleName, float a_SrcX, float a_SrcY, float a_SrcZ, float a_OffsetX, float a_OffsetY, float a_OffsetZ, float a_ParticleData, int a_ParticleAmount)
+{
+	m_Protocol->SendParticleEffect(a_ParticleName, a_SrcX, a_SrcY, a_SrcZ, a_OffsetX, a_OffsetY, a_OffsetZ, a_ParticleData, a_ParticleAmount);
+}
+
+
+
+
+
+void cClientHandle::SendParticleEffect(const AString & a_ParticleName, const Vector3f a_Src, const Vector3f a_Offset, float a_ParticleData, int a_ParticleAmount, std::array<int, 2> a_Data)
+{
+	m_Protocol->SendParticleEffect(a_ParticleName, a_Src, a_Offset, a_ParticleData, a_ParticleAmount, a_Data);
+}
+
+
+
+
+
+void cClientHandle::SendSoundEffect(const AString & a_SoundName, Vector3d a_Position, float a_Volume, float a_Pitch)
+{
+	m_Protocol->SendSoundEffect(a_SoundName, a_Position.x, a_Position.y, a_Position.z, a_Volume, a_Pitch);
+}
+
+
+
+
+
+void cClientHandle::SendSoundParticleEffect(const EffectID a_EffectID, int a_SrcX, int a_SrcY, int a_SrcZ, int a_Data)
+{
+	m_Protocol->SendSoundParticleEffect(a_EffectID, a_SrcX, a_SrcY, a_SrcZ, a_Data);
+}
+
+
+
+
+
+void cClientHandle::SendTimeUpdate(Int64 a_WorldAge, Int64 a_TimeOfDay, bool a_DoDaylightCycle)
+{
+	m_Protocol->SendTimeUpdate(a_WorldAge, a_TimeOfDay, a_DoDaylightCycle);
+}
+
+
+
+
+
+void cClientHandle::OnLinkCreated(cTCPLinkPtr a_Link)
+{
+	m_Link = a_Link;
+}
+
+
+
+
+
+void cClientHandle::OnReceivedData(const char * a_Data, size_t a_Length)
+{
+	// Only the handshake is ever received, it goes to the protocol recognizer:
+	m_Protocol->DataReceived(a_Data, a_Length);
+}
+
+
+
+
+
+void cClientHandle::OnRemoteClosed(void)
+{
+}
+
+
+
+
+
+void cClientHandle::OnError(int a_ErrorCode, const AString & a_ErrorMsg)
+{
+	UNUSED(a_ErrorCode);
+	UNUSED(a_ErrorMsg);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Needed for linking only; the packets that the clients receive aren't handled:
+
+const AString & cClientHandle::GetUsername(void) const
+{
+	return m_Username;
+}
+
+
+
+
+
+void cClientHandle::SetUsername(const AString & a_Username)
+{
+	m_Username = a_Username;
+}
+
+
+
+
+
+void cClientHandle::SetViewDistance(int a_ViewDistance)
+{
+	m_RequestedViewDistance = a_ViewDistance;
+}
+
+
+
+
+
+void cClientHandle::SendChat(const AString & a_Message, eMessageType a_ChatPrefix, const AString & a_AdditionalData)
+{
+}
+
+
+
+
+
+void cClientHandle::SendPluginMessage(const AString & a_Channel, const AString & a_Message)
+{
+}
+
+
+
+
+
+void cClientHandle::FinishAuthenticate(const AString & a_Name, const cUUID & a_UUID, const Json::Value & a_Properties)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleAnimation(int a_Animation)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleAnvilItemName(const AString & a_ItemName)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleBeaconSelection(int a_PrimaryEffect, int a_SecondaryEffect)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleChat(const AString & a_Message)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleCommandBlockBlockChange(int a_BlockX, int a_BlockY, int a_BlockZ, const AString & a_NewCommand)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleCreativeInventory(Int16 a_SlotNum, const cItem & a_HeldItem, eClickAction a_ClickAction)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleEnchantItem(UInt8 a_WindowID, UInt8 a_Enchantment)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleEntityCrouch(UInt32 a_EntityID, bool a_IsCrouching)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleEntityLeaveBed(UInt32 a_EntityID)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleEntitySprinting(UInt32 a_EntityID, bool a_IsSprinting)
+{
+}
+
+
+
+
+
+bool cClientHandle::HandleHandshake(const AString & a_Username)
+{
+	return true;
+}
+
+
+
+
+
+void cClientHandle::HandleKeepAlive(UInt32 a_KeepAliveID)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleLeftClick(int a_BlockX, int a_BlockY, int a_BlockZ, eBlockFace a_BlockFace, UInt8 a_Status)
+{
+}
+
+
+
+
+
+bool cClientHandle::HandleLogin(const AString & a_Username)
+{
+	return true;
+}
+
+
+
+
+
+void cClientHandle::HandleNPCTrade(int a_SlotNum)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleOpenHorseInventory(UInt32 a_EntityID)
+{
+}
+
+
+
+
+
+void cClientHandle::HandlePlayerAbilities(bool a_CanFly, bool a_IsFlying, float FlyingSpeed, float WalkingSpeed)
+{
+}
+
+
+
+
+
+void cClientHandle::HandlePlayerLook(float a_Rotation, float a_Pitch, bool a_IsOnGround)
+{
+}
+
+
+
+
+
+void cClientHandle::HandlePlayerMoveLook(double a_PosX, double a_PosY, double a_PosZ, double a_Stance, float a_Rotation, float a_Pitch, bool a_IsOnGround)
+{
+}
+
+
+
+
+
+void cClientHandle::HandlePlayerPos(double a_PosX, double a_PosY, double a_PosZ, double a_Stance, bool a_IsOnGround)
+{
+}
+
+
+
+
+
+void cClientHandle::HandlePluginMessage(const AString & a_Channel, const AString & a_Message)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleRespawn(void)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleRightClick(int a_BlockX, int a_BlockY, int a_BlockZ, eBlockFace a_BlockFace, int a_CursorX, int a_CursorY, int a_CursorZ, const cItem & a_HeldItem)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleSlotSelected(Int16 a_SlotNum)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleSpectate(const cUUID & a_PlayerUUID)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleSteerVehicle(float a_Forward, float a_Sideways)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleTabCompletion(const AString & a_Text)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleUpdateSign(
+	int a_BlockX, int a_BlockY, int a_BlockZ,
+	const AString & a_Line1, const AString & a_Line2,
+	const AString & a_Line3, const AString & a_Line4
+)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleUnmount(void)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleUseEntity(UInt32 a_TargetEntityID, bool a_IsLeftClick)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleWindowClick(UInt8 a_WindowID, Int16 a_SlotNum, eClickAction a_ClickAction, const cItem & a_HeldItem)
+{
+}
+
+
+
+
+
+void cClientHandle::HandleWindowClose(UInt8 a_WindowID)
+{
+}
+
+
+
+
@@ -0,0 +1,746 @@
+
+// PacketDecodeBenchmark.cpp
+
+// Implements the benchmark of the protocols' packet decoding, handling and encoding, for each protocol version
+// The client's side is a recording of a player's session: either a capture made by the server's --capture-packets
+// switch (see cPacketCapture), replayed for the captured protocol version, or a synthetic recording of a player walking,
+// digging, building, chatting and using the creative inventory, created for each protocol version from 1.8 to 1.12.2.
+// The recording is decoded the same way as the network thread does (decryption, framing, decompression, parsing the
+// movement packets), and handed to the protocol's packet handlers as the tick thread does, timed per packet type.
+// The handlers are given the test client with its test player (see ClientHandle.cpp and Player.cpp), so the time is the
+// protocol's parsing and dispatching, not the game logic behind it.
+// The server's side is a synthetic mix of what the server sends a player each tick: the movement of the entities around,
+// block changes, sounds, inventory updates, chat. It is sent through the protocol's own serializers, framed and
+// compressed the same way as for a real client, timed per packet.
+// Usage: PacketDecodeBenchmark [<NumReplays> [<CaptureFile>]]
+
+#include "Globals.h"
+#include "ByteBuffer.h"
+#include "Root.h"
+#include "TestClients.h"
+#include "Entities/Player.h"
+#include "OSSupport/File.h"
+#include "Protocol/PacketCompressor.h"
+#include "Protocol/PacketCapture.h"
+#include "Protocol/PacketDecoder.h"
+#include "Protocol/Protocol_1_8.h"
+#include "Protocol/Protocol_1_9.h"
+#include "Protocol/Protocol_1_10.h"
+#include "Protocol/Protocol_1_11.h"
+#include "Protocol/Protocol_1_12.h"
+#include "mbedTLS++/AesCfb128Decryptor.h"
+#include "mbedTLS++/AesCfb128Encryptor.h"
+
+
+
+
+
+/** The size of the pieces in which the data is replayed, a typical TCP segment. */
+static const size_t SEGMENT_SIZE = 1460;
+
+/** The number of ticks in the synthetic recordings and in the server's packet mix, 10 minutes of play. */
+static const int NUM_TICKS = 20 * 60 * 10;
+
+
+
+
+
+/** Converts the duration to seconds. */
+static double ToSeconds(std::chrono::steady_clock::duration a_Duration)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double>>(a_Duration).count();
+}
+
+
+
+
+
+/** The time spent on packets of a single type, and their count. */
+struct sTypeStats
+{
+	size_t m_NumPackets = 0;
+	std::chrono::steady_clock::duration m_Time = std::chrono::steady_clock::duration::zero();
+};
+
+
+
+
+
+/** Prints the time per packet of each packet type, and the type's share of the total time. */
+template <typename KeyType>
+static void PrintTypeStats(const std::map<KeyType, sTypeStats> & a_Stats, const std::function<AString(const KeyType &)> & a_Name)
+{
+	std::chrono::steady_clock::duration Total(0);
+	for (const auto & TypeStats: a_Stats)
+	{
+		Total += TypeStats.second.m_Time;
+	}
+	printf("    packet                   packets  ns / packet  %% of time\n");
+	for (const auto & TypeStats: a_Stats)
+	{
+		const auto & Type = TypeStats.second;
+		printf("    %-22s %9u %12.1f %10.1f\n",
+			a_Name(TypeStats.first).c_str(), static_cast<unsigned>(Type.m_NumPackets),
+			ToSeconds(Type.m_Time) * 1e9 / static_cast<double>(Type.m_NumPackets),
+			100 * ToSeconds(Type.m_Time) / ToSeconds(Total)
+		);
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// The synthetic recording:
+
+/** The packet types of the client's packets in the synthetic recording, which differ between the protocol versions. */
+struct sClientPacketTypes
+{
+	UInt32 m_KeepAlive;
+	UInt32 m_ChatMessage;
+	UInt32 m_ClientSettings;
+	UInt32 m_PlayerPos;
+	UInt32 m_PlayerPosLook;
+	UInt32 m_PlayerLook;
+	UInt32 m_BlockDig;
+	UInt32 m_BlockPlace;
+	UInt32 m_SlotSelect;
+	UInt32 m_Animation;
+	UInt32 m_CreativeInventoryAction;
+};
+
+
+
+
+
+/** Returns the packet types of the client's packets, as handled by the protocol's HandlePacket(). */
+static sClientPacketTypes GetClientPacketTypes(UInt32 a_ProtocolVersion)
+{
+	if (a_ProtocolVersion < cProtocolRecognizer::PROTO_VERSION_1_9_0)
+	{
+		return {0x00, 0x01, 0x15, 0x04, 0x06, 0x05, 0x07, 0x08, 0x09, 0x0a, 0x10};
+	}
+	if (a_ProtocolVersion < cProtocolRecognizer::PROTO_VERSION_1_12)
+	{
+		return {0x0b, 0x02, 0x04, 0x0c, 0x0d, 0x0e, 0x13, 0x1c, 0x17, 0x1a, 0x18};
+	}
+	if (a_ProtocolVersion < cProtocolRecognizer::PROTO_VERSION_1_12_1)
+	{
+		return {0x0c, 0x03, 0x05, 0x0e, 0x0f, 0x10, 0x14, 0x1f, 0x1a, 0x1d, 0x1b};
+	}
+	return {0x0b, 0x02, 0x04, 0x0d, 0x0e, 0x0f, 0x14, 0x1f, 0x1a, 0x1d, 0x1b};
+}
+
+
+
+
+
+/** Frames a single packet the same way the client does, and appends it to a_Recording. */
+static void AppendPacket(AString & a_Recording, cPacketCompressor & a_Compressor, UInt32 a_PacketType, cByteBuffer & a_Payload)
+{
+	cByteBuffer Packet(64 KiB);
+	Packet.WriteVarInt32(a_PacketType);
+	AString Payload;
+	a_Payload.ReadAll(Payload);
+	a_Payload.CommitRead();
+	Packet.Write(Payload.data(), Payload.size());
+	AString Data;
+	Packet.ReadAll(Data);
+	const char * Framed;
+	size_t FramedSize;
+	VERIFY(a_Compressor.FramePacket(Data.data(), Data.size(), true, Framed, FramedSize));
+	a_Recording.append(Framed, FramedSize);
+}
+
+
+
+
+
+/** Creates a synthetic recording of a_NumTicks ticks of a player's session, in the format of the protocol version. */
+static AString CreateRecording(UInt32 a_ProtocolVersion, int a_NumTicks)
+{
+	bool HasHands = (a_ProtocolVersion >= cProtocolRecognizer::PROTO_VERSION_1_9_0);
+	bool HasFloatCursor = (a_ProtocolVersion >= cProtocolRecognizer::PROTO_VERSION_1_11_0);
+	bool HasLongKeepAlive = (a_ProtocolVersion >= cProtocolRecognizer::PROTO_VERSION_1_12_2);
+	auto Types = GetClientPacketTypes(a_ProtocolVersion);
+
+	AString Recording;
+	cPacketCompressor Compressor(cPacketCompressor::DEFAULT_THRESHOLD, Z_DEFAULT_COMPRESSION);
+	cByteBuffer Payload(64 KiB);
+
+	// Client settings, once at the start:
+	Payload.WriteVarUTF8String("en_US");
+	Payload.WriteBEUInt8(10);  // View distance
+	Payload.WriteBEUInt8(0);   // Chat flags
+	Payload.WriteBool(true);   // Chat colors
+	Payload.WriteBEUInt8(0x7f);  // Skin parts
+	if (HasHands)
+	{
+		Payload.WriteVarInt32(1);  // Main hand
+	}
+	AppendPacket(Recording, Compressor, Types.m_ClientSettings, Payload);
+
+	for (int Tick = 0; Tick < a_NumTicks; Tick++)
+	{
+		// The player's movement, every tick:
+		double PosX = 100.5 + Tick * 0.2;
+		double PosZ = -20.5 + Tick * 0.1;
+		switch (Tick % 4)
+		{
+			case 0:
+			case 1:
+			{
+				Payload.WriteBEDouble(PosX);
+				Payload.WriteBEDouble(64);
+				Payload.WriteBEDouble(PosZ);
+				Payload.WriteBEFloat(static_cast<float>(Tick % 360));
+				Payload.WriteBEFloat(10);
+				Payload.WriteBool(true);
+				AppendPacket(Recording, Compressor, Types.m_PlayerPosLook, Payload);
+				break;
+			}
+			case 2:
+			{
+				Payload.WriteBEDouble(PosX);
+				Payload.WriteBEDouble(64);
+				Payload.WriteBEDouble(PosZ);
+				Payload.WriteBool(true);
+				AppendPacket(Recording, Compressor, Types.m_PlayerPos, Payload);
+				break;
+			}
+			default:
+			{
+				Payload.WriteBEFloat(static_cast<float>(Tick % 360));
+				Payload.WriteBEFloat(12);
+				Payload.WriteBool(true);
+				AppendPacket(Recording, Compressor, Types.m_PlayerLook, Payload);
+				break;
+			}
+		}
+
+		// Arm swing and digging, every few ticks:
+		if ((Tick % 4) == 0)
+		{
+			if (HasHands)
+			{
+				Payload.WriteVarInt32(0);  // Main hand
+			}
+			AppendPacket(Recording, Compressor, Types.m_Animation, Payload);
+			Payload.WriteVarInt32(static_cast<UInt32>(Tick % 3));  // Dig status
+			Payload.WritePosition64(100, 63, -20 + Tick % 5);
+			Payload.WriteBEInt8(1);  // Face
+			AppendPacket(Recording, Compressor, Types.m_BlockDig, Payload);
+		}
+
+		// Selecting a block and placing it, every half a second:
+		if ((Tick % 10) == 5)
+		{
+			Payload.WriteBEInt16(static_cast<Int16>(Tick % 9));
+			AppendPacket(Recording, Compressor, Types.m_SlotSelect, Payload);
+			Payload.WritePosition64(101, 63, -20 + Tick % 5);
+			if (HasHands)
+			{
+				Payload.WriteVarInt32(1);  // Face
+				Payload.WriteVarInt32(0);  // Main hand
+			}
+			else
+			{
+				Payload.WriteBEInt8(1);  // Face
+				Payload.WriteBEInt16(-1);  // The held item, empty
+			}
+			if (HasFloatCursor)
+			{
+				Payload.WriteBEFloat(0.5f);
+				Payload.WriteBEFloat(1);
+				Payload.WriteBEFloat(0.5f);
+			}
+			else
+			{
+				Payload.WriteBEUInt8(8);
+				Payload.WriteBEUInt8(16);
+				Payload.WriteBEUInt8(8);
+			}
+			AppendPacket(Recording, Compressor, Types.m_BlockPlace, Payload);
+		}
+
+		// Keep-alive, every second:
+		if ((Tick % 20) == 0)
+		{
+			if (HasLongKeepAlive)
+			{
+				Payload.WriteBEInt64(Tick);
+			}
+			else
+			{
+				Payload.WriteVarInt32(static_cast<UInt32>(Tick));
+			}
+			AppendPacket(Recording, Compressor, Types.m_KeepAlive, Payload);
+		}
+
+		// Chat, every few seconds:
+		if ((Tick % 60) == 0)
+		{
+			Payload.WriteVarUTF8String(Printf("Hello, this is chat message number %d", Tick));
+			AppendPacket(Recording, Compressor, Types.m_ChatMessage, Payload);
+		}
+
+		// Creative inventory action with a written book, large enough to get compressed, every ten seconds:
+		if ((Tick % 200) == 0)
+		{
+			Payload.WriteBEInt16(36);  // Slot
+			Payload.WriteBEInt16(387);  // Written book
+			Payload.WriteBEInt8(1);
+			Payload.WriteBEInt16(0);
+			Payload.WriteBEInt8(10);  // TAG_Compound
+			Payload.WriteBEInt16(0);
+			Payload.WriteBEInt8(9);   // TAG_List "pages"
+			Payload.WriteBEInt16(5);
+			Payload.Write("pages", 5);
+			Payload.WriteBEInt8(8);   // of TAG_String
+			Payload.WriteBEInt32(20);
+			for (int Page = 0; Page < 20; Page++)
+			{
+				AString Text = Printf("Page %d: All work and no play makes Jack a dull boy. ", Page);
+				Text.append(Text);
+				Payload.WriteBEInt16(static_cast<Int16>(Text.size()));
+				Payload.Write(Text.data(), Text.size());
+			}
+			Payload.WriteBEInt8(0);  // TAG_End
+			AppendPacket(Recording, Compressor, Types.m_CreativeInventoryAction, Payload);
+		}
+	}
+	return Recording;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// The server's packet mix:
+
+/** A packet that the server sends to the player every m_Period ticks, through the protocol's serializer. */
+struct sServerPacket
+{
+	const char * m_Name;
+	int m_Period;
+	void (*m_Send)(cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick);
+};
+
+/** The mix of the server's packets: the player's own state and the entities around it, here all played by the player. */
+static const sServerPacket g_ServerPackets[] =
+{
+	{"EntityRelMove", 1, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendEntityRelMove(a_Entity, 4, 0, static_cast<char>(a_Tick % 8 - 4));
+		}
+	},
+	{"EntityRelMoveLook", 1, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendEntityRelMoveLook(a_Entity, 2, static_cast<char>(a_Tick % 3 - 1), -2);
+		}
+	},
+	{"EntityLook", 2, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendEntityLook(a_Entity);
+		}
+	},
+	{"EntityHeadLook", 1, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendEntityHeadLook(a_Entity);
+		}
+	},
+	{"EntityVelocity", 2, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendEntityVelocity(a_Entity);
+		}
+	},
+	{"TeleportEntity", 20, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendTeleportEntity(a_Entity);
+		}
+	},
+	{"EntityMetadata", 20, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendEntityMetadata(a_Entity);
+		}
+	},
+	{"EntityEquipment", 40, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendEntityEquipment(a_Entity, 0, cItem(E_ITEM_DIAMOND_SWORD));
+		}
+	},
+	{"BlockChange", 2, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendBlockChange(100, 63, -20 + a_Tick % 5, E_BLOCK_AIR, 0);
+		}
+	},
+	{"BlockChanges", 10, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			sSetBlockVector Changes;
+			for (int i = 0; i < 20; i++)
+			{
+				Changes.emplace_back(6, -2, i % 16, 60 + i / 16, (i * 7) % 16, E_BLOCK_STONE, 0);
+			}
+			a_Protocol.SendBlockChanges(6, -2, Changes);
+		}
+	},
+	{"SoundEffect", 5, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendSoundEffect("entity.item.pickup", 100.5, 64, -20.5, 0.5f, 1.5f);
+		}
+	},
+	{"InventorySlot", 20, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			cItem Item(E_ITEM_DIAMOND_SWORD, 1, 0, "Sharpness=4;Unbreaking=3", "Test sword");
+			a_Protocol.SendInventorySlot(0, static_cast<short>(36 + a_Tick % 9), Item);
+		}
+	},
+	{"Health", 20, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendHealth();
+		}
+	},
+	{"TimeUpdate", 20, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendTimeUpdate(a_Tick, a_Tick % 24000, true);
+		}
+	},
+	{"KeepAlive", 40, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendKeepAlive(static_cast<UInt32>(a_Tick));
+		}
+	},
+	{"PlayerListUpdatePing", 40, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendPlayerListUpdatePing(a_Entity);
+		}
+	},
+	{"Chat", 60, [](cProtocol & a_Protocol, const cPlayer & a_Entity, int a_Tick)
+		{
+			a_Protocol.SendChat(Printf("<TestPlayer> Hello, this is chat message number %d", a_Tick), ctChatBox);
+		}
+	},
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// The replays:
+
+/** Gives the replay access to the protocol's decoder and packet handling. */
+template <class ProtocolType>
+class cReplayProtocol :
+	public ProtocolType
+{
+public:
+
+	cReplayProtocol(cClientHandle * a_Client) :
+		ProtocolType(a_Client, "localhost", 25565, 3)  // Straight into the game state
+	{
+	}
+
+	/** Decodes the data the same way DecodeReceivedData() does, with the protocol's own decoder settings. */
+	bool Decode(const char * a_Data, size_t a_Size)
+	{
+		return this->m_Decoder.Decode(this->m_ReceivedData, a_Data, a_Size);
+	}
+
+	cPacketDecoder & GetDecoder(void) { return this->m_Decoder; }
+
+	/** Handles a single decoded packet, the same way HandleDecodedPackets() does. */
+	using ProtocolType::HandleDecodedPacket;
+} ;
+
+
+
+
+
+/** Replays the recording a_NumReplays times through the protocol's decoder, optionally encrypted, and prints the costs
+of the network thread (decryption, framing, decompression, parsing the movement packets) and of the tick thread
+(popping the decoded packets, before the handlers). */
+template <class ProtocolType>
+static void ReplayDecoding(cClientHandle & a_Client, const AString & a_Recording, bool a_IsEncrypted, int a_NumReplays)
+{
+	Byte Key[16];
+	for (size_t i = 0; i < sizeof(Key); i++)
+	{
+		Key[i] = static_cast<Byte>(i * 13);
+	}
+
+	// Encrypt the recording the same way the client would:
+	AString Stream(a_Recording);
+	if (a_IsEncrypted)
+	{
+		cAesCfb128Encryptor Encryptor;
+		Encryptor.Init(Key, Key);
+		Encryptor.ProcessData(reinterpret_cast<Byte *>(&Stream[0]), reinterpret_cast<const Byte *>(a_Recording.data()), a_Recording.size());
+	}
+
+	std::chrono::steady_clock::duration NetworkTime(0), TickTime(0);
+	size_t NumPackets = 0;
+	for (int r = 0; r < a_NumReplays; r++)
+	{
+		cReplayProtocol<ProtocolType> Protocol(&a_Client);
+		cPacketDecoder & Decoder = Protocol.GetDecoder();
+		cAesCfb128Decryptor Decryptor;
+		Decryptor.Init(Key, Key);
+		Byte Decrypted[SEGMENT_SIZE];
+		for (size_t Pos = 0; Pos < Stream.size(); Pos += SEGMENT_SIZE)
+		{
+			size_t Size = std::min(SEGMENT_SIZE, Stream.size() - Pos);
+
+			// The network thread's work, the same as DecodeReceivedData():
+			auto Start = std::chrono::steady_clock::now();
+			const char * Data = Stream.data() + Pos;
+			if (a_IsEncrypted)
+			{
+				Decryptor.ProcessData(Decrypted, reinterpret_cast<const Byte *>(Data), Size);
+				Data = reinterpret_cast<const char *>(Decrypted);
+			}
+			if (!Protocol.Decode(Data, Size))
+			{
+				AString Reason;
+				Decoder.TakeFailure(Reason);
+				LOGERROR("The recording cannot be decoded: %s", Reason.c_str());
+				return;
+			}
+			auto Decoded = std::chrono::steady_clock::now();
+			NetworkTime += Decoded - Start;
+
+			// The tick thread's work before the packet handlers, the same as HandleDecodedPackets():
+			cPacketDecoder::sPacket Packet;
+			while (Decoder.Pop(Packet))
+			{
+				Decoder.Recycle(std::move(Packet));
+				NumPackets += 1;
+			}
+			TickTime += std::chrono::steady_clock::now() - Decoded;
+		}
+	}
+
+	double NetworkSec = ToSeconds(NetworkTime);
+	double TickSec = ToSeconds(TickTime);
+	double NumBytes = static_cast<double>(Stream.size()) * a_NumReplays;
+	printf("  Decoding, %s, %u packets, %.1f MiB:\n",
+		a_IsEncrypted ? "encrypted" : "unencrypted", static_cast<unsigned>(NumPackets), NumBytes / 1024 / 1024
+	);
+	printf("    Network thread: %8.1f ns / packet, %8.1f MB / sec\n", NetworkSec * 1e9 / static_cast<double>(NumPackets), NumBytes / NetworkSec / 1e6);
+	printf("    Tick thread:    %8.1f ns / packet\n", TickSec * 1e9 / static_cast<double>(NumPackets));
+	printf("    Decoding work moved off the tick thread: %.1f %%\n", 100 * NetworkSec / (NetworkSec + TickSec));
+}
+
+
+
+
+
+/** Replays the recording a_NumReplays times through the protocol's packet handlers, for the test client and its
+player, and prints the handling cost per packet type. The decoding is done beforehand, it isn't part of the timing.
+Returns false if the protocol cannot handle a packet. */
+template <class ProtocolType>
+static bool ReplayHandlers(cClientHandle & a_Client, const AString & a_Recording, int a_NumReplays)
+{
+	std::map<UInt32, sTypeStats> Stats;
+	size_t NumPackets = 0;
+	std::chrono::steady_clock::duration HandleTime(0);
+	for (int r = 0; r < a_NumReplays; r++)
+	{
+		cReplayProtocol<ProtocolType> Protocol(&a_Client);
+		cPacketDecoder & Decoder = Protocol.GetDecoder();
+		for (size_t Pos = 0; Pos < a_Recording.size(); Pos += SEGMENT_SIZE)
+		{
+			size_t Size = std::min(SEGMENT_SIZE, a_Recording.size() - Pos);
+			if (!Protocol.Decode(a_Recording.data() + Pos, Size))
+			{
+				LOGERROR("The recording cannot be decoded");
+				return false;
+			}
+			cPacketDecoder::sPacket Packet;
+			while (Decoder.Pop(Packet))
+			{
+				UInt32 PacketType = Packet.m_PacketType;
+				auto Start = std::chrono::steady_clock::now();
+				bool IsHandled = Protocol.HandleDecodedPacket(Packet);
+				auto Elapsed = std::chrono::steady_clock::now() - Start;
+				auto & TypeStats = Stats[PacketType];
+				TypeStats.m_Time += Elapsed;
+				TypeStats.m_NumPackets += 1;
+				HandleTime += Elapsed;
+				NumPackets += 1;
+				Decoder.Recycle(std::move(Packet));
+				if (!IsHandled)
+				{
+					LOGERROR("The protocol cannot handle a packet of type 0x%02x", PacketType);
+					return false;
+				}
+			}
+
+			// Drop whatever the handlers sent back, as if the tick ended:
+			a_Client.ServerTick(0);
+		}
+	}
+
+	printf("  Packet handlers (tick thread), %u packets: %8.1f ns / packet\n",
+		static_cast<unsigned>(NumPackets), ToSeconds(HandleTime) * 1e9 / static_cast<double>(std::max<size_t>(NumPackets, 1))
+	);
+	PrintTypeStats<UInt32>(Stats, [](const UInt32 & a_PacketType)
+		{
+			return Printf("0x%02x", a_PacketType);
+		}
+	);
+	return (NumPackets > 0);
+}
+
+
+
+
+
+/** Sends the server's packet mix for a_NumTicks ticks, a_NumReplays times, through the protocol's serializers, and prints
+the encoding cost per packet. The client's outgoing data is flushed at the end of each tick. */
+template <class ProtocolType>
+static void ReplayServerPackets(cClientHandle & a_Client, const cTestLink & a_Link, int a_NumTicks, int a_NumReplays)
+{
+	const cPlayer & Player = *a_Client.GetPlayer();
+	std::map<size_t, sTypeStats> Stats;
+	size_t NumPackets = 0;
+	std::chrono::steady_clock::duration EncodeTime(0);
+	size_t NumBytesBefore = a_Link.m_NumBytes;
+	for (int r = 0; r < a_NumReplays; r++)
+	{
+		cReplayProtocol<ProtocolType> Protocol(&a_Client);
+		for (int Tick = 0; Tick < a_NumTicks; Tick++)
+		{
+			for (size_t i = 0; i < ARRAYCOUNT(g_ServerPackets); i++)
+			{
+				if ((Tick % g_ServerPackets[i].m_Period) != 0)
+				{
+					continue;
+				}
+				auto Start = std::chrono::steady_clock::now();
+				g_ServerPackets[i].m_Send(Protocol, Player, Tick);
+				auto Elapsed = std::chrono::steady_clock::now() - Start;
+				auto & TypeStats = Stats[i];
+				TypeStats.m_Time += Elapsed;
+				TypeStats.m_NumPackets += 1;
+				EncodeTime += Elapsed;
+				NumPackets += 1;
+			}
+			a_Client.ServerTick(0);
+		}
+	}
+
+	printf("  Server packets (serializing, framing, compressing), %u packets, %.1f MiB: %8.1f ns / packet\n",
+		static_cast<unsigned>(NumPackets), static_cast<double>(a_Link.m_NumBytes - NumBytesBefore) / 1024 / 1024,
+		ToSeconds(EncodeTime) * 1e9 / static_cast<double>(std::max<size_t>(NumPackets, 1))
+	);
+	PrintTypeStats<size_t>(Stats, [](const size_t & a_Index)
+		{
+			return AString(g_ServerPackets[a_Index].m_Name);
+		}
+	);
+}
+
+
+
+
+
+/** Runs all the replays for the protocol ProtocolType, talking a_ProtocolVersion. Returns false if any replay failed. */
+template <class ProtocolType>
+static bool Benchmark(UInt32 a_ProtocolVersion, const AString & a_Recording, int a_NumReplays)
+{
+	auto Client = CreateTestClient(a_ProtocolVersion, false);
+	ReplayDecoding<ProtocolType>(*Client.m_Client, a_Recording, true, a_NumReplays);
+	ReplayDecoding<ProtocolType>(*Client.m_Client, a_Recording, false, a_NumReplays);
+	if (!ReplayHandlers<ProtocolType>(*Client.m_Client, a_Recording, a_NumReplays))
+	{
+		return false;
+	}
+	ReplayServerPackets<ProtocolType>(*Client.m_Client, *Client.m_Link, NUM_TICKS, a_NumReplays);
+	return true;
+}
+
+
+
+
+
+/** Runs all the replays for the protocol matching a_ProtocolVersion. Returns false if the version isn't supported
+or any replay failed. */
+static bool Benchmark(UInt32 a_ProtocolVersion, const AString & a_Recording, int a_NumReplays)
+{
+	printf("Protocol version %u, %.1f KiB recorded:\n", a_ProtocolVersion, static_cast<double>(a_Recording.size()) / 1024);
+	switch (a_ProtocolVersion)
+	{
+		case cProtocolRecognizer::PROTO_VERSION_1_8_0:  return Benchmark<cProtocol_1_8_0> (a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_9_0:  return Benchmark<cProtocol_1_9_0> (a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_9_1:  return Benchmark<cProtocol_1_9_1> (a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_9_2:  return Benchmark<cProtocol_1_9_2> (a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_9_4:  return Benchmark<cProtocol_1_9_4> (a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_10_0: return Benchmark<cProtocol_1_10_0>(a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_11_0: return Benchmark<cProtocol_1_11_0>(a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_11_1: return Benchmark<cProtocol_1_11_1>(a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_12:   return Benchmark<cProtocol_1_12>  (a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_12_1: return Benchmark<cProtocol_1_12_1>(a_ProtocolVersion, a_Recording, a_NumReplays);
+		case cProtocolRecognizer::PROTO_VERSION_1_12_2: return Benchmark<cProtocol_1_12_2>(a_ProtocolVersion, a_Recording, a_NumReplays);
+	}
+	LOGERROR("Protocol version %u isn't supported", a_ProtocolVersion);
+	return false;
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	int NumReplays = (argc > 1) ? atoi(argv[1]) : 20;
+	if (NumReplays <= 0)
+	{
+		LOGERROR("Usage: PacketDecodeBenchmark [<NumReplays> [<CaptureFile>]]");
+		return 1;
+	}
+
+	cRoot Root;
+	if (argc > 2)
+	{
+		// Replay the client's data from the capture:
+		AString Capture = cFile::ReadWholeFile(argv[2]);
+		UInt32 ProtocolVersion;
+		int CompressionThreshold;
+		std::vector<cPacketCapture::sRecord> Records;
+		if (Capture.empty() || !cPacketCapture::Parse(Capture, ProtocolVersion, CompressionThreshold, Records))
+		{
+			LOGERROR("Cannot read the capture from file \"%s\"", argv[2]);
+			return 1;
+		}
+		AString Recording;
+		for (const auto & Record: Records)
+		{
+			if (Record.m_Direction == cPacketCapture::dirFromClient)
+			{
+				Recording.append(Record.m_Data);
+			}
+		}
+		double Duration = Records.empty() ? 0 : static_cast<double>(Records.back().m_Time.count()) / 1e6;
+		printf("Capture of %u records over %.1f seconds, compression threshold %d\n",
+			static_cast<unsigned>(Records.size()), Duration, CompressionThreshold
+		);
+		return Benchmark(ProtocolVersion, Recording, NumReplays) ? 0 : 1;
+	}
+
+	// Replay a synthetic recording for each protocol version:
+	for (auto ProtocolVersion: g_ProtocolVersions)
+	{
+		if (!Benchmark(ProtocolVersion, CreateRecording(ProtocolVersion, NUM_TICKS), NumReplays))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,782 @@
+
+// Player.cpp
+
+// Mocks the cPlayer class used by the tests, along with its base classes and its inventory
+// The player isn't in any world; it only keeps the state that the protocols read and set when handling the client's
+// packets and serializing the server's ones. Everything else does nothing.
+
+#include "Globals.h"
+#include "ClientHandle.h"
+#include "Inventory.h"
+#include "ItemGrid.h"
+#include "Entities/Player.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cEntity:
+
+cEntity::cEntity(eEntityType a_EntityType, double a_X, double a_Y, double a_Z, double a_Width, double a_Height):
+	m_UniqueID(1),
+	m_Health(1),
+	m_MaxHealth(1),
+	m_AttachedTo(nullptr),
+	m_Attachee(nullptr),
+	m_bOnGround(false),
+	m_Gravity(-9.81f),
+	m_AirDrag(0.02f),
+	m_LastPosition(a_X, a_Y, a_Z),
+	m_EntityType(a_EntityType),
+	m_World(nullptr),
+	m_IsWorldChangeScheduled(false),
+	m_IsFireproof(false),
+	m_TicksSinceLastBurnDamage(0),
+	m_TicksSinceLastLavaDamage(0),
+	m_TicksSinceLastFireDamage(0),
+	m_TicksLeftBurning(0),
+	m_TicksSinceLastVoidDamage(0),
+	m_IsSwimming(false),
+	m_IsSubmerged(false),
+	m_AirLevel(MAX_AIR_LEVEL),
+	m_AirTickTimer(DROWNING_TICKS),
+	m_TicksAlive(0),
+	m_IsTicking(false),
+	m_ParentChunk(nullptr),
+	m_IndexedSection(-1),
+	m_HeadYaw(0.0),
+	m_Rot(0.0, 0.0, 0.0),
+	m_Position(a_X, a_Y, a_Z),
+	m_LastSentPosition(a_X, a_Y, a_Z),
+	m_WaterSpeed(0, 0, 0),
+	m_Mass (0.001),
+	m_Width(a_Width),
+	m_Height(a_Height),
+	m_InvulnerableTicks(0)
+{
+}
+
+
+
+
+
+cEntity::~cEntity()
+{
+}
+
+
+
+
+
+bool cEntity::Initialize(OwnedEntity a_Self, cWorld & a_EntityWorld)
+{
+	return false;
+}
+
+
+
+
+
+bool cEntity::IsA(const char * a_ClassName) const
+{
+	return ((a_ClassName != nullptr) && (strcmp(a_ClassName, "cEntity") == 0));
+}
+
+
+
+
+
+const char * cEntity::GetClass(void) const
+{
+	return "cEntity";
+}
+
+
+
+
+
+const char * cEntity::GetParentClass(void) const
+{
+	return "";
+}
+
+
+
+
+
+cEntity * cEntity::GetAttached()
+{
+	return m_AttachedTo;
+}
+
+
+
+
+
+void cEntity::SetPosition(const Vector3d & a_Position)
+{
+	m_Position = a_Position;
+}
+
+
+
+
+
+void cEntity::SetYaw(double a_Yaw)
+{
+	m_Rot.x = a_Yaw;
+}
+
+
+
+
+
+void cEntity::SetPitch(double a_Pitch)
+{
+	m_Rot.y = a_Pitch;
+}
+
+
+
+
+
+void cEntity::HandleSpeedFromAttachee(float a_Forward, float a_Sideways)
+{
+}
+
+
+
+
+
+void cEntity::Destroy(bool a_ShouldBroadcast)
+{
+}
+
+
+
+
+
+bool cEntity::DoTakeDamage(TakeDamageInfo & a_TDI)
+{
+	return false;
+}
+
+
+
+
+
+int cEntity::GetRawDamageAgainst(const cEntity & a_Receiver)
+{
+	return 0;
+}
+
+
+
+
+
+bool cEntity::ArmorCoversAgainst(eDamageType a_DamageType)
+{
+	return false;
+}
+
+
+
+
+
+int cEntity::GetArmorCoverAgainst(const cEntity * a_Attacker, eDamageType a_DamageType, int a_RawDamage)
+{
+	return 0;
+}
+
+
+
+
+
+int cEntity::GetEnchantmentCoverAgainst(const cEntity * a_Attacker, eDamageType a_DamageType, int a_Damage)
+{
+	return 0;
+}
+
+
+
+
+
+double cEntity::GetKnockbackAmountAgainst(const cEntity & a_Receiver)
+{
+	return 0;
+}
+
+
+
+
+
+void cEntity::ApplyArmorDamage(int DamageBlocked)
+{
+}
+
+
+
+
+
+void cEntity::KilledBy(TakeDamageInfo & a_TDI)
+{
+}
+
+
+
+
+
+void cEntity::Heal(int a_HitPoints)
+{
+}
+
+
+
+
+
+void cEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+void cEntity::HandlePhysics(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+void cEntity::TickBurning(cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+void cEntity::DetectCacti(void)
+{
+}
+
+
+
+
+
+bool cEntity::DetectPortal(void)
+{
+	return false;
+}
+
+
+
+
+
+void cEntity::TickInVoid(cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+void cEntity::OnStartedBurning(void)
+{
+}
+
+
+
+
+
+void cEntity::OnFinishedBurning(void)
+{
+}
+
+
+
+
+
+void cEntity::TeleportToEntity(cEntity & a_Entity)
+{
+}
+
+
+
+
+
+void cEntity::TeleportToCoords(double a_PosX, double a_PosY, double a_PosZ)
+{
+}
+
+
+
+
+
+bool cEntity::DoMoveToWorld(cWorld * a_World, bool a_ShouldSendRespawn, Vector3d a_NewPosition)
+{
+	return false;
+}
+
+
+
+
+
+void cEntity::BroadcastMovementUpdate(const cClientHandle * a_Exclude)
+{
+}
+
+
+
+
+
+void cEntity::AttachTo(cEntity * a_AttachTo)
+{
+}
+
+
+
+
+
+void cEntity::Detach(void)
+{
+}
+
+
+
+
+
+void cEntity::DoSetSpeed(double a_SpeedX, double a_SpeedY, double a_SpeedZ)
+{
+}
+
+
+
+
+
+void cEntity::HandleAir(void)
+{
+}
+
+
+
+
+
+void cEntity::SetSwimState(cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPawn:
+
+cPawn::cPawn(eEntityType a_EntityType, double a_Width, double a_Height) :
+	super(a_EntityType, 0, 0, 0, a_Width, a_Height),
+	m_LastGroundHeight(0),
+	m_bTouchGround(false)
+{
+}
+
+
+
+
+
+cPawn::~cPawn()
+{
+}
+
+
+
+
+
+void cPawn::Destroyed()
+{
+}
+
+
+
+
+
+void cPawn::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+void cPawn::KilledBy(TakeDamageInfo & a_TDI)
+{
+}
+
+
+
+
+
+bool cPawn::IsFireproof(void) const
+{
+	return false;
+}
+
+
+
+
+
+bool cPawn::IsInvisible() const
+{
+	return false;
+}
+
+
+
+
+
+void cPawn::HandleAir(void)
+{
+}
+
+
+
+
+
+void cPawn::HandleFalling(void)
+{
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cPlayer:
+
+const int cPlayer::MAX_HEALTH = 20;
+
+const int cPlayer::MAX_FOOD_LEVEL = 20;
+
+
+
+
+
+cPlayer::cPlayer(cClientHandlePtr a_Client, const AString & a_PlayerName) :
+	super(etPlayer, 0.6, 1.8),
+	m_bVisible(true),
+	m_FoodLevel(MAX_FOOD_LEVEL),
+	m_FoodSaturationLevel(5.0),
+	m_FoodTickTimer(0),
+	m_FoodExhaustionLevel(0.0),
+	m_Stance(0.0),
+	m_Inventory(*this),
+	m_EnderChestContents(9, 3),
+	m_CurrentWindow(nullptr),
+	m_InventoryWindow(nullptr),
+	m_GameMode(eGameMode_Survival),
+	m_ClientHandle(a_Client),
+	m_IsFrozen(false),
+	m_NormalMaxSpeed(1.0),
+	m_SprintingMaxSpeed(1.3),
+	m_FlyingMaxSpeed(1.0),
+	m_IsCrouched(false),
+	m_IsSprinting(false),
+	m_IsFlying(false),
+	m_IsFishing(false),
+	m_CanFly(false),
+	m_EatingFinishTick(-1),
+	m_LifetimeTotalXp(0),
+	m_CurrentXp(0),
+	m_bDirtyExperience(false),
+	m_IsChargingBow(false),
+	m_BowCharge(0),
+	m_FloaterID(cEntity::INVALID_ID),
+	m_Team(nullptr),
+	m_bIsInBed(false),
+	m_TicksUntilNextSave(0),
+	m_bIsTeleporting(false),
+	m_SkinParts(0),
+	m_MainHand(mhRight)
+{
+	m_PlayerName = a_PlayerName;
+	m_Health = MAX_HEALTH;
+	m_MaxHealth = MAX_HEALTH;
+}
+
+
+
+
+
+cPlayer::~cPlayer()
+{
+}
+
+
+
+
+
+bool cPlayer::Initialize(OwnedEntity a_Self, cWorld & a_World)
+{
+	return false;
+}
+
+
+
+
+
+void cPlayer::SpawnOn(cClientHandle & a_Client)
+{
+}
+
+
+
+
+
+void cPlayer::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+void cPlayer::ApplyArmorDamage(int DamageBlocked)
+{
+}
+
+
+
+
+
+void cPlayer::TeleportToCoords(double a_PosX, double a_PosY, double a_PosZ)
+{
+}
+
+
+
+
+
+void cPlayer::Heal(int a_Health)
+{
+}
+
+
+
+
+
+void cPlayer::KilledBy(TakeDamageInfo & a_TDI)
+{
+}
+
+
+
+
+
+void cPlayer::Killed(cEntity * a_Victim)
+{
+}
+
+
+
+
+
+bool cPlayer::DoMoveToWorld(cWorld * a_World, bool a_ShouldSendRespawn, Vector3d a_NewPosition)
+{
+	return false;
+}
+
+
+
+
+
+void cPlayer::AttachTo(cEntity * a_AttachTo)
+{
+}
+
+
+
+
+
+void cPlayer::Detach(void)
+{
+}
+
+
+
+
+
+void cPlayer::DoSetSpeed(double a_SpeedX, double a_SpeedY, double a_SpeedZ)
+{
+}
+
+
+
+
+
+void cPlayer::Destroyed(void)
+{
+}
+
+
+
+
+
+bool cPlayer::DoTakeDamage(TakeDamageInfo & TDI)
+{
+	return false;
+}
+
+
+
+
+
+unsigned int cPlayer::AwardAchievement(const eStatistic a_Ach)
+{
+	return 0;
+}
+
+
+
+
+
+AString cPlayer::GetPlayerListName(void) const
+{
+	return m_PlayerName;
+}
+
+
+
+
+
+int cPlayer::GetXpLevel(void)
+{
+	return 0;
+}
+
+
+
+
+
+float cPlayer::GetXpPercentage(void)
+{
+	return 0;
+}
+
+
+
+
+
+bool cPlayer::IsGameModeCreative(void) const
+{
+	return (m_GameMode == eGameMode_Creative);
+}
+
+
+
+
+
+bool cPlayer::IsGameModeSpectator(void) const
+{
+	return (m_GameMode == eGameMode_Spectator);
+}
+
+
+
+
+
+void cPlayer::SendMessageInfo(const AString & a_Message)
+{
+}
+
+
+
+
+
+void cPlayer::SetMainHand(eMainHand a_Hand)
+{
+	m_MainHand = a_Hand;
+}
+
+
+
+
+
+void cPlayer::SetSkinParts(int a_Parts)
+{
+	m_SkinParts = a_Parts & spMask;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cInventory, cItemGrid:
+
+cInventory::cInventory(cPlayer & a_Owner) :
+	m_ArmorSlots    (1, 4),
+	m_InventorySlots(9, 3),
+	m_HotbarSlots   (9, 1),
+	m_ShieldSlots   (1, 1),
+	m_EquippedSlotNum(0),
+	m_Owner(a_Owner)
+{
+}
+
+
+
+
+
+const cItem & cInventory::GetEquippedItem(void) const
+{
+	return m_HotbarSlots.GetSlot(m_EquippedSlotNum);
+}
+
+
+
+
+
+void cInventory::OnSlotChanged(cItemGrid * a_ItemGrid, int a_SlotNum)
+{
+}
+
+
+
+
+
+cItemGrid::cItemGrid(int a_Width, int a_Height) :
+	m_Width(a_Width),
+	m_Height(a_Height),
+	m_NumSlots(a_Width * a_Height),
+	m_Slots(new cItem[a_Width * a_Height]),
+	m_IsInTriggerListeners(false)
+{
+}
+
+
+
+
+
+cItemGrid::~cItemGrid()
+{
+	delete[] m_Slots;
+	m_Slots = nullptr;
+}
+
+
+
+
+
+const cItem & cItemGrid::GetSlot(int a_SlotNum) const
+{
+	ASSERT((a_SlotNum >= 0) && (a_SlotNum < m_NumSlots));
+	return m_Slots[a_SlotNum];
+}
+
+
+
+
+
@@ -0,0 +1,134 @@
+
+// SharedBroadcastTest.cpp
+
+// Implements the test that the packets broadcast through cSharedBroadcast are byte-identical to the packets sent to each
+// client separately, for each protocol version
+
+#include "Globals.h"
+#include "Broadcaster.h"
+#include "Root.h"
+#include "TestClients.h"
+
+
+
+
+
+/** The number of clients of each protocol version receiving the shared broadcasts. */
+static const int NUM_CLIENTS = 3;
+
+/** The number of broadcasts sent, several rounds of the broadcast mix. */
+static const int NUM_BROADCASTS = NUM_BROADCAST_PACKETS * 5;
+
+
+
+
+
+/** Sends the broadcast mix to a client of each protocol version separately, and to NUM_CLIENTS clients of each
+protocol version, all mixed together, through cSharedBroadcast. Checks that each client gets the same bytes as the
+separate client of its protocol version. */
+static void TestSharedBroadcast(void)
+{
+	std::vector<sTestClient> Reference, Shared;
+	for (auto ProtocolVersion: g_ProtocolVersions)
+	{
+		Reference.push_back(CreateTestClient(ProtocolVersion, true));
+	}
+	for (int i = 0; i < NUM_CLIENTS; i++)
+	{
+		for (auto ProtocolVersion: g_ProtocolVersions)
+		{
+			Shared.push_back(CreateTestClient(ProtocolVersion, true));
+		}
+	}
+	for (const auto & Client: Shared)
+	{
+		assert_test(Client.m_Client->GetBroadcastKey() != 0);
+	}
+
+	for (int i = 0; i < NUM_BROADCASTS; i++)
+	{
+		for (auto & Client: Reference)
+		{
+			SendBroadcastPacket(*Client.m_Client, i);
+		}
+		cSharedBroadcast Broadcast([i](cClientHandle & a_Client)
+			{
+				SendBroadcastPacket(a_Client, i);
+			}
+		);
+		for (auto & Client: Shared)
+		{
+			Broadcast.SendTo(*Client.m_Client);
+		}
+
+		// Flush every few broadcasts, as if a tick ended:
+		if ((i % 7) == 6)
+		{
+			for (auto & Client: Reference)
+			{
+				Client.m_Client->ServerTick(0);
+			}
+			for (auto & Client: Shared)
+			{
+				Client.m_Client->ServerTick(0);
+			}
+		}
+	}
+	for (auto & Client: Reference)
+	{
+		Client.m_Client->ServerTick(0);
+	}
+	for (auto & Client: Shared)
+	{
+		Client.m_Client->ServerTick(0);
+	}
+
+	// Each protocol version gets its own encoding, each shared client the same bytes as its reference client:
+	for (size_t i = 0; i < Reference.size(); i++)
+	{
+		const AString & Expected = Reference[i].m_Link->m_Data;
+		assert_test(!Expected.empty());
+		for (size_t j = 0; j < i; j++)
+		{
+			if (Reference[i].m_Client->GetBroadcastKey() != Reference[j].m_Client->GetBroadcastKey())
+			{
+				continue;
+			}
+			// Protocol versions sharing the key must share the encoding, too:
+			assert_test(Reference[j].m_Link->m_Data == Expected);
+		}
+		for (size_t j = i; j < Shared.size(); j += Reference.size())
+		{
+			assert_test(Shared[j].m_Client->GetProtocolVersion() == g_ProtocolVersions[i]);
+			if (Shared[j].m_Link->m_Data != Expected)
+			{
+				LOGERROR("Protocol version %u: the shared broadcast differs from the per-client one (" SIZE_T_FMT " vs " SIZE_T_FMT " bytes)",
+					g_ProtocolVersions[i], Shared[j].m_Link->m_Data.size(), Expected.size()
+				);
+			}
+			assert_test(Shared[j].m_Link->m_Data == Expected);
+		}
+		LOG("Protocol version %u: " SIZE_T_FMT " bytes, identical for all %d clients",
+			g_ProtocolVersions[i], Expected.size(), NUM_CLIENTS + 1
+		);
+	}
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	cRoot Root;
+	TestSharedBroadcast();
+
+	LOG("SharedBroadcast test finished");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,365 @@
+
+
+// Stubs.cpp
+
+// Implements the stub server that the protocols read their settings from, and stubs of various Cuberite methods
+// that are needed for linking but not for runtime
+// This is required so that we don't bring in the entire Cuberite via dependencies
+
+#include "Globals.h"
+#include "ClientHandle.h"
+#include "Root.h"
+#include "Server.h"
+#include "RankManager.h"
+#include "BrewingRecipes.h"
+#include "CompositeChat.h"
+#include "Inventory.h"
+#include "Statistics.h"
+#include "BlockEntities/CommandBlockEntity.h"
+#include "Bindings/PluginManager.h"
+#include "Entities/Boat.h"
+#include "Entities/EntityEffect.h"
+#include "Entities/Player.h"
+#include "Mobs/Horse.h"
+#include "Mobs/Monster.h"
+#include "Protocol/Authenticator.h"
+#include "Protocol/ChunkDataSerializer.h"
+#include "Protocol/PacketCompressor.h"
+#include "Protocol/PingResponder.h"
+#include "Protocol/Protocol.h"
+#include "UI/HorseWindow.h"
+#include "UI/Window.h"
+#include "World.h"
+
+
+
+
+
+// The command line switches, normally in main.cpp:
+bool g_ShouldLogCommIn = false;
+bool g_ShouldLogCommOut = false;
+bool g_ShouldCapturePackets = false;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cRoot, cServer:
+// The protocols read the server's settings through cRoot in their constructors. Only the objects themselves
+// are created here, with the default settings; nothing is loaded and no threads are started.
+
+cRoot * cRoot::s_Root = nullptr;
+
+
+
+
+
+cRoot::cRoot(void) :
+	m_pDefaultWorld(nullptr),
+	m_Server(new cServer),
+	m_MonsterConfig(nullptr),
+	m_CraftingRecipes(nullptr),
+	m_FurnaceRecipe(nullptr),
+	m_WebAdmin(nullptr),
+	m_PluginManager(nullptr),
+	m_MojangAPI(nullptr)
+{
+	s_Root = this;
+	m_InputThreadRunFlag.clear();
+}
+
+
+
+
+
+cRoot::~cRoot()
+{
+	delete m_Server;
+	s_Root = nullptr;
+}
+
+
+
+
+
+cServer::cServer(void) :
+	m_PlayerCount(0),
+	m_ClientViewDistance(0),
+	m_bIsConnected(false),
+	m_bRestarting(false),
+	m_RCONServer(*this),
+	m_MaxPlayers(0),
+	m_bIsHardcore(false),
+	m_TickThread(*this),
+	m_ShouldAuthenticate(false),
+	m_ShouldLoadOfflinePlayerData(false),
+	m_ShouldLoadNamedPlayerData(true),
+	m_CompressionThreshold(cPacketCompressor::DEFAULT_THRESHOLD),
+	m_CompressionLevel(Z_DEFAULT_COMPRESSION),
+	m_ShouldAllowBungeeCord(false),
+	m_ShouldAllowMultiWorldTabCompletion(false)
+{
+}
+
+
+
+
+
+AString cServer::GetStatusResponse(cClientHandle & a_Client, UInt32 a_ProtocolVersion)
+{
+	return "{}";
+}
+
+
+
+
+
+cServer::cTickThread::cTickThread(cServer & a_Server) :
+	super("ServerTickThread"),
+	m_Server(a_Server)
+{
+}
+
+
+
+
+
+void cServer::cTickThread::Execute(void)
+{
+}
+
+
+
+
+
+cRCONServer::cRCONServer(cServer & a_Server) :
+	m_Server(a_Server)
+{
+}
+
+
+
+
+
+cRCONServer::~cRCONServer()
+{
+}
+
+
+
+
+
+cAuthenticator::cAuthenticator(void) :
+	super("cAuthenticator"),
+	m_ShouldAuthenticate(false)
+{
+}
+
+
+
+
+
+cAuthenticator::~cAuthenticator()
+{
+}
+
+
+
+
+
+void cAuthenticator::Execute(void)
+{
+}
+
+
+
+
+
+cHTTPServer::cHTTPServer(void) :
+	m_Callbacks(nullptr)
+{
+}
+
+
+
+
+
+cHTTPServer::~cHTTPServer()
+{
+}
+
+
+
+
+
+cRankManager::~cRankManager()
+{
+}
+
+
+
+
+
+bool cPluginManager::CallHookLoginForge(cClientHandle & a_Client, AStringMap & a_Mods)
+{
+	return false;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Needed for linking only; the protocols only get to these when handling the received packets:
+
+std::shared_ptr<const AString> cChunkDataSerializer::Serialize(int a_Version, int a_ChunkX, int a_ChunkZ)
+{
+	return nullptr;
+}
+
+
+
+
+
+AString cCompositeChat::CreateJsonString(bool a_ShouldUseChatPrefixes) const
+{
+	return "{}";
+}
+
+
+
+
+
+const AString & cCommandBlockEntity::GetCommand(void) const
+{
+	return m_Command;
+}
+
+
+
+
+
+const AString & cCommandBlockEntity::GetLastOutput(void) const
+{
+	return m_LastOutput;
+}
+
+
+
+
+
+NIBBLETYPE cCommandBlockEntity::GetResult(void) const
+{
+	return m_Result;
+}
+
+
+
+
+
+cEntityEffect::eType cEntityEffect::GetPotionEffectType(short a_ItemDamage)
+{
+	return effNoEffect;
+}
+
+
+
+
+
+short cEntityEffect::GetPotionEffectIntensity(short a_ItemDamage)
+{
+	return 0;
+}
+
+
+
+
+
+void cBoat::UpdatePaddles(bool a_RightPaddleUsed, bool a_LeftPaddleUsed)
+{
+}
+
+
+
+
+
+int cHorse::GetHorseArmour(void) const
+{
+	return 0;
+}
+
+
+
+
+
+UInt32 cHorseWindow::GetHorseID() const
+{
+	return 0;
+}
+
+
+
+
+
+AString cMonster::MobTypeToVanillaName(eMonsterType a_MobType)
+{
+	return AString();
+}
+
+
+
+
+
+AString cMonster::MobTypeToVanillaNBT(eMonsterType a_MobType)
+{
+	return AString();
+}
+
+
+
+
+
+eMonsterType cMonster::StringToMobType(const AString & a_MobTypeName)
+{
+	return mtInvalidType;
+}
+
+
+
+
+
+const AString cWindow::GetWindowTypeName(void) const
+{
+	return AString();
+}
+
+
+
+
+
+int cWindow::GetNumSlots(void) const
+{
+	return 0;
+}
+
+
+
+
+
+void cWindow::GetSlots(cPlayer & a_Player, cItems & a_Slots) const
+{
+}
+
+
+
+
+
+bool cWorld::DoWithChunkAt(Vector3i a_BlockPos, cChunkCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
@@ -0,0 +1,208 @@
+
+// TestClients.h
+
+// Declares the helpers shared by the broadcast test and benchmark: clients of any protocol version that are in the game
+// state and record what is sent to them, and the mix of broadcast packets sent to them
+
+#pragma once
+
+#include "ClientHandle.h"
+#include "OSSupport/Network.h"
+#include "Protocol/ProtocolRecognizer.h"
+
+
+
+
+
+/** The link of a test client. Collects the data sent to the client, or only counts it. */
+class cTestLink:
+	public cTCPLink
+{
+	typedef cTCPLink super;
+
+public:
+
+	cTestLink(bool a_ShouldKeepData):
+		super(nullptr),
+		m_ShouldKeepData(a_ShouldKeepData),
+		m_NumBytes(0)
+	{
+	}
+
+	virtual bool Send(const void * a_Data, size_t a_Length) override
+	{
+		if (m_ShouldKeepData)
+		{
+			m_Data.append(static_cast<const char *>(a_Data), a_Length);
+		}
+		m_NumBytes += a_Length;
+		return true;
+	}
+
+	virtual bool Send(cSendChain & a_Chain) override
+	{
+		if (m_ShouldKeepData)
+		{
+			for (const auto & Slice: a_Chain.GetSlices())
+			{
+				m_Data.append(*Slice);
+			}
+		}
+		m_NumBytes += a_Chain.GetSize();
+		return true;
+	}
+
+	virtual AString GetLocalIP(void) const override { return "127.0.0.1"; }
+	virtual UInt16 GetLocalPort(void) const override { return 25565; }
+	virtual AString GetRemoteIP(void) const override { return "127.0.0.1"; }
+	virtual UInt16 GetRemotePort(void) const override { return 12345; }
+	virtual size_t GetOutgoingDataSize(void) const override { return 0; }
+	virtual void Shutdown(void) override {}
+	virtual void Close(void) override {}
+	virtual AString StartTLSClient(cX509CertPtr, cCryptoKeyPtr) override { return "Not supported"; }
+	virtual AString StartTLSServer(cX509CertPtr, cCryptoKeyPtr, const AString &) override { return "Not supported"; }
+
+	/** If true, the data sent is collected in m_Data, otherwise it is only counted. */
+	bool m_ShouldKeepData;
+
+	/** All the data sent to the client so far. */
+	AString m_Data;
+
+	/** The number of bytes sent to the client so far. */
+	size_t m_NumBytes;
+};
+
+
+
+
+
+/** A client with its link. */
+struct sTestClient
+{
+	cClientHandlePtr m_Client;
+	std::shared_ptr<cTestLink> m_Link;
+};
+
+
+
+
+
+/** Creates a client talking the specified protocol version, straight in the game state.
+The client receives the handshake packet as a real client would send it, only with the game state as the next state,
+so that the protocol recognizer creates the protocol the same way as for a real client. */
+inline sTestClient CreateTestClient(UInt32 a_ProtocolVersion, bool a_ShouldKeepData)
+{
+	sTestClient Res;
+	Res.m_Client = std::make_shared<cClientHandle>("127.0.0.1", cClientHandle::DEFAULT_VIEW_DISTANCE);
+	Res.m_Link = std::make_shared<cTestLink>(a_ShouldKeepData);
+	cTCPLink::cCallbacks & Callbacks = *Res.m_Client;  // The client's link callbacks are private, only the link calls them
+	Callbacks.OnLinkCreated(Res.m_Link);
+
+	cByteBuffer Handshake(1 KiB);
+	Handshake.WriteVarInt32(0);  // Handshake packet
+	Handshake.WriteVarInt32(a_ProtocolVersion);
+	Handshake.WriteVarUTF8String("localhost");
+	Handshake.WriteBEUInt16(25565);
+	Handshake.WriteVarInt32(3);  // Next state: game
+	AString Payload;
+	Handshake.ReadAll(Payload);
+	Handshake.CommitRead();
+	Handshake.WriteVarInt32(static_cast<UInt32>(Payload.size()));
+	Handshake.Write(Payload.data(), Payload.size());
+	AString Packet;
+	Handshake.ReadAll(Packet);
+	Callbacks.OnReceivedData(Packet.data(), Packet.size());
+	return Res;
+}
+
+
+
+
+
+/** The protocol versions that the server supports. */
+static const UInt32 g_ProtocolVersions[] =
+{
+	cProtocolRecognizer::PROTO_VERSION_1_8_0,
+	cProtocolRecognizer::PROTO_VERSION_1_9_0,
+	cProtocolRecognizer::PROTO_VERSION_1_9_1,
+	cProtocolRecognizer::PROTO_VERSION_1_9_2,
+	cProtocolRecognizer::PROTO_VERSION_1_9_4,
+	cProtocolRecognizer::PROTO_VERSION_1_10_0,
+	cProtocolRecognizer::PROTO_VERSION_1_11_0,
+	cProtocolRecognizer::PROTO_VERSION_1_11_1,
+	cProtocolRecognizer::PROTO_VERSION_1_12,
+	cProtocolRecognizer::PROTO_VERSION_1_12_1,
+	cProtocolRecognizer::PROTO_VERSION_1_12_2,
+};
+
+
+
+
+
+/** The number of different packets in the broadcast mix. */
+static const int NUM_BROADCAST_PACKETS = 10;
+
+/** Sends the a_Index-th packet of the broadcast mix to the client, through the client's regular send functions.
+The mix resembles what the chunks broadcast: mostly block actions and sounds, some particles and an occasional
+explosion large enough to get compressed. */
+inline void SendBroadcastPacket(cClientHandle & a_Client, int a_Index)
+{
+	int x = a_Index % 1000;
+	int z = -(a_Index % 777);
+	switch (a_Index % NUM_BROADCAST_PACKETS)
+	{
+		case 0:
+		case 1:
+		{
+			a_Client.SendSoundEffect("entity.item.pickup", Vector3d(x + 0.5, 64, z + 0.5), 0.5f, 1.5f);
+			break;
+		}
+		case 2:
+		case 3:
+		{
+			a_Client.SendBlockAction(x, 64, z, 1, static_cast<char>(a_Index % 2), E_BLOCK_CHEST);
+			break;
+		}
+		case 4:
+		{
+			a_Client.SendBlockBreakAnim(static_cast<UInt32>(a_Index), x, 64, z, static_cast<char>(a_Index % 10));
+			break;
+		}
+		case 5:
+		{
+			a_Client.SendSoundParticleEffect(EffectID::SFX_RANDOM_WOODEN_DOOR_OPEN, x, 64, z, 0);
+			break;
+		}
+		case 6:
+		{
+			a_Client.SendParticleEffect("flame", static_cast<float>(x), 65, static_cast<float>(z), 0.2f, 0.2f, 0.2f, 0.01f, 10);
+			break;
+		}
+		case 7:
+		{
+			std::array<int, 2> Data = {{E_BLOCK_STONE, 0}};
+			a_Client.SendParticleEffect("blockcrack", Vector3f(static_cast<float>(x), 65, static_cast<float>(z)), Vector3f(0.5f, 0.5f, 0.5f), 0.1f, 30, Data);
+			break;
+		}
+		case 8:
+		{
+			a_Client.SendTimeUpdate(a_Index, a_Index % 24000, true);
+			break;
+		}
+		default:
+		{
+			// An explosion with all its blocks, large enough to get compressed:
+			cVector3iArray Blocks;
+			for (int i = 0; i < 100; i++)
+			{
+				Blocks.emplace_back(x + i % 5, 60 + i / 25, z + (i / 5) % 5);
+			}
+			a_Client.SendExplosion(x, 62, z, 4, Blocks, Vector3d(0.1, 0.2, 0.3));
+			break;
+		}
+	}
+}
+
+
+
+
@@ -0,0 +1,511 @@
+
+// Chunk.cpp
+
+// Mocks the cChunkMap and cChunk classes used by the redstone tests
+// The chunks store their blocks in the real cChunkData and link to their neighbors the same way as the real chunks. There
+// is no storage and no generator, a chunk is created empty and valid the first time it is used. Setting a block's type
+// notifies the redstone simulator the same way as the real chunk, and setting a block through the chunk map wakes up the
+// redstone simulator, the only one in the test world, the same way as the real simulator manager. Block entities,
+// entities, lighting and clients are left out.
+
+#include "Globals.h"
+#include "Chunk.h"
+#include "ChunkMap.h"
+#include "World.h"
+#include "Blocks/ChunkInterface.h"
+#include "Simulator/RedstoneSimulator.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkMap:
+
+cChunkMap::cChunkMap(cWorld * a_World) :
+	m_World(a_World),
+	m_Pool(
+		new cListAllocationPool<cChunkData::sChunkSection, 1600>(
+			std::unique_ptr<cAllocationPool<cChunkData::sChunkSection>::cStarvationCallbacks>(
+				new cStarvationCallbacks<cChunkData::sChunkSection>()
+			)
+		)
+	),
+	m_NibblePool(
+		new cListAllocationPool<cChunkData::sSectionNibbles, 1600>(
+			std::unique_ptr<cAllocationPool<cChunkData::sSectionNibbles>::cStarvationCallbacks>(
+				new cStarvationCallbacks<cChunkData::sSectionNibbles>()
+			)
+		)
+	),
+	m_BlockTypePool(
+		new cListAllocationPool<cChunkData::sSectionBlockTypes, 1600>(
+			std::unique_ptr<cAllocationPool<cChunkData::sSectionBlockTypes>::cStarvationCallbacks>(
+				new cStarvationCallbacks<cChunkData::sSectionBlockTypes>()
+			)
+		)
+	)
+{
+}
+
+
+
+
+
+cChunkMap::~cChunkMap()
+{
+	// The chunks' data uses the pools, destroy the chunks first:
+	m_Chunks.clear();
+}
+
+
+
+
+
+cChunkPtr cChunkMap::ConstructChunk(int a_ChunkX, int a_ChunkZ)
+{
+	auto Chunk = FindChunk(a_ChunkX, a_ChunkZ);
+	if (Chunk == nullptr)
+	{
+		Chunk = (
+			*m_Chunks.emplace(
+				ChunkCoordinate{ a_ChunkX, a_ChunkZ },
+				cpp14::make_unique<cChunk>(
+					a_ChunkX,
+					a_ChunkZ,
+					this,
+					GetWorld(),
+					FindChunk(a_ChunkX - 1, a_ChunkZ),
+					FindChunk(a_ChunkX + 1, a_ChunkZ),
+					FindChunk(a_ChunkX, a_ChunkZ - 1),
+					FindChunk(a_ChunkX, a_ChunkZ + 1),
+					*m_Pool,
+					*m_NibblePool,
+					*m_BlockTypePool
+				)
+			).first
+		).second.get();
+
+		// There's nothing to load or generate, the chunk is valid with all air:
+		Chunk->SetPresence(cChunk::cpPresent);
+	}
+	return Chunk;
+}
+
+
+
+
+
+cChunkPtr cChunkMap::GetChunk(int a_ChunkX, int a_ChunkZ)
+{
+	ASSERT(m_CSChunks.IsLockedByCurrentThread());
+	return ConstructChunk(a_ChunkX, a_ChunkZ);
+}
+
+
+
+
+
+cChunkPtr cChunkMap::GetChunkNoGen(cChunkCoords a_Chunk)
+{
+	ASSERT(m_CSChunks.IsLockedByCurrentThread());
+	return ConstructChunk(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+}
+
+
+
+
+
+cChunkPtr cChunkMap::GetChunkNoLoad(int a_ChunkX, int a_ChunkZ)
+{
+	ASSERT(m_CSChunks.IsLockedByCurrentThread());
+	return ConstructChunk(a_ChunkX, a_ChunkZ);
+}
+
+
+
+
+
+cChunk * cChunkMap::FindChunk(int a_ChunkX, int a_ChunkZ)
+{
+	ASSERT(m_CSChunks.IsLockedByCurrentThread());
+
+	auto Chunk = m_Chunks.find({ a_ChunkX, a_ChunkZ });
+	return (Chunk == m_Chunks.end()) ? nullptr : Chunk->second.get();
+}
+
+
+
+
+
+bool cChunkMap::DoWithChunk(int a_ChunkX, int a_ChunkZ, cChunkCallback a_Callback)
+{
+	cCSLock Lock(m_CSChunks);
+	cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, a_ChunkZ);
+	if (Chunk == nullptr)
+	{
+		return false;
+	}
+	return a_Callback(*Chunk);
+}
+
+
+
+
+
+bool cChunkMap::DoWithChunkAt(Vector3i a_BlockPos, cChunkCallback a_Callback)
+{
+	int ChunkX, ChunkZ;
+	cChunkDef::BlockToChunk(a_BlockPos.x, a_BlockPos.z, ChunkX, ChunkZ);
+	return DoWithChunk(ChunkX, ChunkZ, a_Callback);
+}
+
+
+
+
+
+void cChunkMap::WakeUpSimulators(Vector3i a_Block)
+{
+	cCSLock Lock(m_CSChunks);
+	cChunkPtr Chunk = GetChunkNoGen(cChunkDef::BlockToChunk(a_Block));
+	if ((Chunk == nullptr) || !Chunk->IsValid())
+	{
+		return;
+	}
+	m_World->GetRedstoneSimulator()->WakeUp(a_Block, Chunk);
+}
+
+
+
+
+
+BLOCKTYPE cChunkMap::GetBlock(int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+	int X = a_BlockX, Y = a_BlockY, Z = a_BlockZ;
+	int ChunkX, ChunkZ;
+	cChunkDef::AbsoluteToRelative(X, Y, Z, ChunkX, ChunkZ);
+
+	cCSLock Lock(m_CSChunks);
+	return GetChunk(ChunkX, ChunkZ)->GetBlock(X, Y, Z);
+}
+
+
+
+
+
+NIBBLETYPE cChunkMap::GetBlockMeta(int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+	int X = a_BlockX, Y = a_BlockY, Z = a_BlockZ;
+	int ChunkX, ChunkZ;
+	cChunkDef::AbsoluteToRelative(X, Y, Z, ChunkX, ChunkZ);
+
+	cCSLock Lock(m_CSChunks);
+	return GetChunk(ChunkX, ChunkZ)->GetMeta(X, Y, Z);
+}
+
+
+
+
+
+bool cChunkMap::GetBlockTypeMeta(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta)
+{
+	int X = a_BlockX, Y = a_BlockY, Z = a_BlockZ;
+	int ChunkX, ChunkZ;
+	cChunkDef::AbsoluteToRelative(X, Y, Z, ChunkX, ChunkZ);
+
+	cCSLock Lock(m_CSChunks);
+	GetChunk(ChunkX, ChunkZ)->GetBlockTypeMeta(X, Y, Z, a_BlockType, a_BlockMeta);
+	return true;
+}
+
+
+
+
+
+void cChunkMap::SetBlockMeta(int a_BlockX, int a_BlockY, int a_BlockZ, NIBBLETYPE a_BlockMeta, bool a_ShouldMarkDirty, bool a_ShouldInformClients)
+{
+	int ChunkX, ChunkZ;
+	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
+	// a_BlockXYZ now contains relative coords!
+
+	cCSLock Lock(m_CSChunks);
+	GetChunk(ChunkX, ChunkZ)->SetMeta(a_BlockX, a_BlockY, a_BlockZ, a_BlockMeta, a_ShouldMarkDirty, a_ShouldInformClients);
+}
+
+
+
+
+
+void cChunkMap::SetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, bool a_SendToClients)
+{
+	int ChunkX, ChunkZ, X = a_BlockX, Y = a_BlockY, Z = a_BlockZ;
+	cChunkDef::AbsoluteToRelative(X, Y, Z, ChunkX, ChunkZ);
+
+	cCSLock Lock(m_CSChunks);
+	cChunkPtr Chunk = GetChunk(ChunkX, ChunkZ);
+	Chunk->SetBlock(X, Y, Z, a_BlockType, a_BlockMeta, a_SendToClients);
+	m_World->GetRedstoneSimulator()->WakeUp({a_BlockX, a_BlockY, a_BlockZ}, Chunk);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunk:
+
+cChunk::cChunk(
+	int a_ChunkX, int a_ChunkZ,
+	cChunkMap * a_ChunkMap, cWorld * a_World,
+	cChunk * a_NeighborXM, cChunk * a_NeighborXP, cChunk * a_NeighborZM, cChunk * a_NeighborZP,
+	cAllocationPool<cChunkData::sChunkSection> & a_Pool, cAllocationPool<cChunkData::sSectionNibbles> & a_NibblePool,
+	cAllocationPool<cChunkData::sSectionBlockTypes> & a_BlockTypePool
+) :
+	m_Presence(cpInvalid),
+	m_ShouldGenerateIfLoadFailed(false),
+	m_IsLightValid(false),
+	m_IsDirty(false),
+	m_IsSaving(false),
+	m_HasLoadFailed(false),
+	m_LightUpdatesWorldAge(-1),
+	m_NumLightUpdates(0),
+	m_HasEntitiesToMove(false),
+	m_StayCount(0),
+	m_PosX(a_ChunkX),
+	m_PosZ(a_ChunkZ),
+	m_World(a_World),
+	m_ChunkMap(a_ChunkMap),
+	m_ChunkData(a_Pool, a_NibblePool, a_BlockTypePool),
+	m_BlockTickX(0),
+	m_BlockTickY(0),
+	m_BlockTickZ(0),
+	m_IsNextBlockTickSet(false),
+	m_NeighborXM(a_NeighborXM),
+	m_NeighborXP(a_NeighborXP),
+	m_NeighborZM(a_NeighborZM),
+	m_NeighborZP(a_NeighborZP),
+	m_WaterSimulatorData(nullptr),
+	m_LavaSimulatorData(nullptr),
+	m_RedstoneSimulatorData(a_World->GetRedstoneSimulator()->CreateChunkData()),
+	m_AlwaysTicked(0)
+{
+	memset(m_NumRandomTickableBlocks, 0, sizeof(m_NumRandomTickableBlocks));
+
+	if (a_NeighborXM != nullptr)
+	{
+		a_NeighborXM->m_NeighborXP = this;
+	}
+	if (a_NeighborXP != nullptr)
+	{
+		a_NeighborXP->m_NeighborXM = this;
+	}
+	if (a_NeighborZM != nullptr)
+	{
+		a_NeighborZM->m_NeighborZP = this;
+	}
+	if (a_NeighborZP != nullptr)
+	{
+		a_NeighborZP->m_NeighborZM = this;
+	}
+}
+
+
+
+
+
+cChunk::~cChunk()
+{
+	if (m_NeighborXM != nullptr)
+	{
+		m_NeighborXM->m_NeighborXP = nullptr;
+	}
+	if (m_NeighborXP != nullptr)
+	{
+		m_NeighborXP->m_NeighborXM = nullptr;
+	}
+	if (m_NeighborZM != nullptr)
+	{
+		m_NeighborZM->m_NeighborZP = nullptr;
+	}
+	if (m_NeighborZP != nullptr)
+	{
+		m_NeighborZP->m_NeighborZM = nullptr;
+	}
+	delete m_RedstoneSimulatorData;
+	m_RedstoneSimulatorData = nullptr;
+}
+
+
+
+
+
+void cChunk::SetPresence(cChunk::ePresence a_Presence)
+{
+	m_Presence = a_Presence;
+}
+
+
+
+
+
+void cChunk::SetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, bool a_SendToClients)
+{
+	FastSetBlock(a_RelX, a_RelY, a_RelZ, a_BlockType, a_BlockMeta, a_SendToClients);
+}
+
+
+
+
+
+void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, BLOCKTYPE a_BlockMeta, bool a_SendToClients)
+{
+	ASSERT(!((a_RelX < 0) || (a_RelX >= Width) || (a_RelY < 0) || (a_RelY >= Height) || (a_RelZ < 0) || (a_RelZ >= Width)));
+	UNUSED(a_SendToClients);
+
+	const BLOCKTYPE OldBlockType = GetBlock(a_RelX, a_RelY, a_RelZ);
+	m_ChunkData.SetBlock(a_RelX, a_RelY, a_RelZ, a_BlockType);
+	m_ChunkData.SetMeta(a_RelX, a_RelY, a_RelZ, a_BlockMeta);
+
+	if (OldBlockType != a_BlockType)
+	{
+		m_World->GetRedstoneSimulator()->BlockTypeChanged(PositionToWorldPosition(a_RelX, a_RelY, a_RelZ), *this);
+	}
+}
+
+
+
+
+
+BLOCKTYPE cChunk::GetBlock(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	return m_ChunkData.GetBlock(a_RelX, a_RelY, a_RelZ);
+}
+
+
+
+
+
+void cChunk::GetBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const
+{
+	a_BlockType = GetBlock(a_RelX, a_RelY, a_RelZ);
+	a_BlockMeta = m_ChunkData.GetMeta(a_RelX, a_RelY, a_RelZ);
+}
+
+
+
+
+
+bool cChunk::UnboundedRelGetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const
+{
+	if (!cChunkDef::IsValidHeight(a_RelY))
+	{
+		return false;
+	}
+	cChunk * Chunk = GetRelNeighborChunkAdjustCoords(a_RelX, a_RelZ);
+	if ((Chunk == nullptr) || !Chunk->IsValid())
+	{
+		return false;
+	}
+	Chunk->GetBlockTypeMeta(a_RelX, a_RelY, a_RelZ, a_BlockType, a_BlockMeta);
+	return true;
+}
+
+
+
+
+
+cChunk * cChunk::GetNeighborChunk(int a_BlockX, int a_BlockZ)
+{
+	// Convert coords to relative, then call the relative version:
+	a_BlockX -= m_PosX * cChunkDef::Width;
+	a_BlockZ -= m_PosZ * cChunkDef::Width;
+	return GetRelNeighborChunk(a_BlockX, a_BlockZ);
+}
+
+
+
+
+
+cChunk * cChunk::GetRelNeighborChunk(int a_RelX, int a_RelZ)
+{
+	return GetRelNeighborChunkAdjustCoords(a_RelX, a_RelZ);
+}
+
+
+
+
+
+cChunk * cChunk::GetRelNeighborChunkAdjustCoords(int & a_RelX, int & a_RelZ) const
+{
+	// The test world is small, look the chunk up in the chunk map instead of walking the neighbors:
+	int AbsX = a_RelX + m_PosX * Width;
+	int AbsZ = a_RelZ + m_PosZ * Width;
+	int DstChunkX, DstChunkZ;
+	BlockToChunk(AbsX, AbsZ, DstChunkX, DstChunkZ);
+	a_RelX = AbsX - DstChunkX * Width;
+	a_RelZ = AbsZ - DstChunkZ * Width;
+	return m_ChunkMap->FindChunk(DstChunkX, DstChunkZ);
+}
+
+
+
+
+
+Vector3i cChunk::PositionToWorldPosition(int a_RelX, int a_RelY, int a_RelZ)
+{
+	return Vector3i(m_PosX * Width + a_RelX, a_RelY, m_PosZ * Width + a_RelZ);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkInterface:
+// The redstone handlers of doors and pistons reach the chunk map through it.
+
+BLOCKTYPE cChunkInterface::GetBlock(Vector3i a_Pos)
+{
+	return m_ChunkMap->GetBlock(a_Pos.x, a_Pos.y, a_Pos.z);
+}
+
+
+
+
+
+NIBBLETYPE cChunkInterface::GetBlockMeta(Vector3i a_Pos)
+{
+	return m_ChunkMap->GetBlockMeta(a_Pos.x, a_Pos.y, a_Pos.z);
+}
+
+
+
+
+
+void cChunkInterface::SetBlockMeta(int a_BlockX, int a_BlockY, int a_BlockZ, NIBBLETYPE a_MetaData, bool a_ShouldMarkDirty, bool a_ShouldInformClient)
+{
+	m_ChunkMap->SetBlockMeta(a_BlockX, a_BlockY, a_BlockZ, a_MetaData, a_ShouldMarkDirty, a_ShouldInformClient);
+}
+
+
+
+
+
+bool cChunkInterface::ForEachChunkInRect(int a_MinChunkX, int a_MaxChunkX, int a_MinChunkZ, int a_MaxChunkZ, cChunkDataCallback & a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cChunkInterface::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes)
+{
+	return false;
+}
+
+
+
+
+
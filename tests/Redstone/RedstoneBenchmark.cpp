@@ -0,0 +1,108 @@
+
+// RedstoneBenchmark.cpp
+
+// Implements the benchmark of the redstone simulator with and without the compiled networks
+// Both test worlds get the same grid of circuits, each a torch clock and a chain of repeaters whose input is toggled
+// periodically, then each world is ticked on its own and the time spent in the redstone simulator is measured.
+// Usage: RedstoneBenchmark [<NumCircuits> [<NumTicks>]]
+
+#include "Globals.h"
+#include "Root.h"
+#include "TestWorld.h"
+
+
+
+
+
+/** The number of repeaters in each circuit's chain. */
+static const int CHAIN_LENGTH = 12;
+
+/** The number of circuits in each row of the grid, along the X axis. */
+static const int CIRCUITS_PER_ROW = 8;
+
+/** The number of ticks between toggling the chains' inputs. */
+static const int TOGGLE_INTERVAL = 20;
+
+/** The number of ticks run before measuring, so that all the circuits have been compiled and are running. */
+static const int NUM_WARMUP_TICKS = 20;
+
+
+
+
+
+/** Builds a_NumCircuits circuits in the world, in a grid. Returns the positions of the chains' inputs. */
+static std::vector<Vector3i> BuildCircuits(cWorld & a_World, int a_NumCircuits)
+{
+	std::vector<Vector3i> Inputs;
+	for (int i = 0; i < a_NumCircuits; i++)
+	{
+		Vector3i Origin((i % CIRCUITS_PER_ROW) * (CHAIN_LENGTH + 8), 10, (i / CIRCUITS_PER_ROW) * 4);
+		BuildTorchClock(a_World, Origin);
+		Inputs.push_back(BuildRepeaterChain(a_World, Origin + Vector3i(4, 0, 0), CHAIN_LENGTH));
+	}
+	return Inputs;
+}
+
+
+
+
+
+/** Ticks the world's redstone a_NumTicks times, toggling the inputs periodically. Returns the milliseconds per tick. */
+static double Measure(cWorld & a_World, const std::vector<Vector3i> & a_Inputs, int a_NumTicks)
+{
+	for (int i = 0; i < NUM_WARMUP_TICKS; i++)
+	{
+		TickRedstone(a_World);
+	}
+
+	auto Start = std::chrono::steady_clock::now();
+	for (int Tick = 0; Tick < a_NumTicks; Tick++)
+	{
+		if (Tick % TOGGLE_INTERVAL == 0)
+		{
+			for (const auto & Input: a_Inputs)
+			{
+				ToggleInput(a_World, Input);
+			}
+		}
+		TickRedstone(a_World);
+	}
+	auto Elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - Start).count();
+
+	double MsPerTick = Elapsed * 1000 / static_cast<double>(a_NumTicks);
+	printf("  %8.3f msec / tick\n", MsPerTick);
+	return MsPerTick;
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	int NumCircuits = (argc > 1) ? atoi(argv[1]) : 400;
+	int NumTicks = (argc > 2) ? atoi(argv[2]) : 1000;
+	if ((NumCircuits <= 0) || (NumTicks <= 0))
+	{
+		LOGERROR("Usage: RedstoneBenchmark [<NumCircuits> [<NumTicks>]]");
+		return 1;
+	}
+
+	cRoot Root;
+	cWorld & Plain = *Root.GetWorld("Plain");
+	cWorld & Compiled = *Root.GetWorld(COMPILED_WORLD_NAME);
+	auto Inputs = BuildCircuits(Plain, NumCircuits);
+	BuildCircuits(Compiled, NumCircuits);
+	printf("%d circuits, %d ticks:\n", NumCircuits, NumTicks);
+
+	printf("Without the compiled networks:\n");
+	double PlainMs = Measure(Plain, Inputs, NumTicks);
+	printf("With the compiled networks:\n");
+	double CompiledMs = Measure(Compiled, Inputs, NumTicks);
+	printf("Speedup: %.2fx\n", PlainMs / CompiledMs);
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,264 @@
+
+// RedstoneCircuitsTest.cpp
+
+// Implements the test that the redstone simulator with the compiled networks runs circuits tick for tick the same as without
+// Both test worlds get the same circuits and the same block changes, then tick in lockstep; after every tick, the blocks of
+// the circuits, including the wires' power levels, the torches', repeaters' and lamps' states and the comparators' metas,
+// must be the same in both worlds.
+
+#include "Globals.h"
+#include "Root.h"
+#include "Simulator/IncrementalRedstoneSimulator/IncrementalRedstoneSimulator.h"
+#include "TestWorld.h"
+
+
+
+
+
+/** The number of ticks each circuit is run for. */
+static const int NUM_TICKS = 200;
+
+
+
+
+
+/** A circuit built in both test worlds, with the inputs toggled while it runs. */
+class cCircuit
+{
+public:
+	/** The blocks of the circuit, compared between the worlds. */
+	cCuboid m_Cuboid;
+
+	/** The blocks toggled between a block of redstone and a stone block, at the specified ticks. */
+	std::vector<std::pair<int, Vector3i>> m_Toggles;
+
+	/** A block set while the circuit runs, changing its topology. */
+	struct sChange
+	{
+		int m_Tick;
+		Vector3i m_Pos;
+		BLOCKTYPE m_BlockType;
+	};
+
+	/** The blocks set at the specified ticks. */
+	std::vector<sChange> m_Changes;
+
+	/** A wire that the compiled world must have compiled after the first tick. */
+	Vector3i m_CompiledWire;
+
+	cCircuit(const cCuboid & a_Cuboid, Vector3i a_CompiledWire) :
+		m_Cuboid(a_Cuboid),
+		m_CompiledWire(a_CompiledWire)
+	{
+	}
+};
+
+
+
+
+
+/** Runs the circuit built by a_BuildFn in both worlds, comparing them after every tick.
+Checks that the circuit isn't idle, its blocks change in at least a_MinNumChanges ticks. */
+template <typename BuildFn>
+static void RunCircuit(const char * a_Name, int a_MinNumChanges, BuildFn a_BuildFn)
+{
+	LOGD("Testing %s", a_Name);
+
+	cRoot Root;
+	cWorld & Plain = *Root.GetWorld("Plain");
+	cWorld & Compiled = *Root.GetWorld(COMPILED_WORLD_NAME);
+	cCircuit Circuit = a_BuildFn(Plain);
+	a_BuildFn(Compiled);
+	assert_test(AreBlocksEqual(Plain, Compiled, Circuit.m_Cuboid));
+
+	int NumChanges = 0;
+	std::vector<std::pair<BLOCKTYPE, NIBBLETYPE>> PrevBlocks;
+	for (int Tick = 0; Tick < NUM_TICKS; Tick++)
+	{
+		for (const auto & Toggle: Circuit.m_Toggles)
+		{
+			if (Toggle.first == Tick)
+			{
+				ToggleInput(Plain, Toggle.second);
+				ToggleInput(Compiled, Toggle.second);
+			}
+		}
+		for (const auto & Change: Circuit.m_Changes)
+		{
+			if (Change.m_Tick == Tick)
+			{
+				Plain.SetBlock(Change.m_Pos.x, Change.m_Pos.y, Change.m_Pos.z, Change.m_BlockType, 0);
+				Compiled.SetBlock(Change.m_Pos.x, Change.m_Pos.y, Change.m_Pos.z, Change.m_BlockType, 0);
+			}
+		}
+
+		TickRedstone(Plain);
+		TickRedstone(Compiled);
+		if (!AreBlocksEqual(Plain, Compiled, Circuit.m_Cuboid))
+		{
+			LOGERROR("%s: The worlds differ after tick %d", a_Name, Tick);
+			assert_test(!"The compiled networks must run the circuit the same as without them");
+		}
+
+		// Count the ticks in which the circuit changed:
+		std::vector<std::pair<BLOCKTYPE, NIBBLETYPE>> Blocks;
+		for (int y = Circuit.m_Cuboid.p1.y; y <= Circuit.m_Cuboid.p2.y; y++)
+		{
+			for (int z = Circuit.m_Cuboid.p1.z; z <= Circuit.m_Cuboid.p2.z; z++)
+			{
+				for (int x = Circuit.m_Cuboid.p1.x; x <= Circuit.m_Cuboid.p2.x; x++)
+				{
+					BLOCKTYPE BlockType;
+					NIBBLETYPE BlockMeta;
+					Plain.GetBlockTypeMeta(x, y, z, BlockType, BlockMeta);
+					Blocks.emplace_back(BlockType, BlockMeta);
+				}
+			}
+		}
+		if (!PrevBlocks.empty() && (Blocks != PrevBlocks))
+		{
+			NumChanges += 1;
+		}
+		std::swap(Blocks, PrevBlocks);
+
+		if (Tick == 0)
+		{
+			cVector3iArray Offsets;
+			auto Simulator = static_cast<cIncrementalRedstoneSimulator *>(Compiled.GetRedstoneSimulator());
+			assert_test(Simulator->GetCompiledTerracingOffsets(Circuit.m_CompiledWire, Offsets));
+		}
+	}
+	LOGD("%s: the circuit changed in %d ticks out of %d", a_Name, NumChanges, NUM_TICKS);
+	assert_test(NumChanges >= a_MinNumChanges);
+}
+
+
+
+
+
+/** A torch clock, with a wire of its loop removed and placed back while it runs. */
+static cCircuit BuildClock(cWorld & a_World)
+{
+	Vector3i Origin(4, 10, 4);
+	BuildTorchClock(a_World, Origin);
+	cCircuit Circuit(cCuboid(Origin, Origin + Vector3i(2, 1, 2)), Origin + Vector3i(2, 1, 1));
+	Circuit.m_Changes.push_back({63, Origin + Vector3i(2, 1, 1), E_BLOCK_AIR});
+	Circuit.m_Changes.push_back({101, Origin + Vector3i(2, 1, 1), E_BLOCK_REDSTONE_WIRE});
+	return Circuit;
+}
+
+
+
+
+
+/** A chain of repeaters crossing a chunk border, with the input turned off and on. */
+static cCircuit BuildRepeaters(cWorld & a_World)
+{
+	const int Length = 12;
+	Vector3i Origin(10, 10, 4);
+	auto Input = BuildRepeaterChain(a_World, Origin, Length);
+
+	// Branch a wire off the input, the wire is the only compiled type in the chain:
+	PlaceWire(a_World, Input + Vector3i(0, 0, 1));
+	PlaceWire(a_World, Input + Vector3i(0, 0, 2));
+	cCircuit Circuit(cCuboid(Origin + Vector3i(0, 0, 0), Origin + Vector3i(Length + 1, 1, 2)), Input + Vector3i(0, 0, 2));
+	Circuit.m_Toggles.emplace_back(40, Input);
+	Circuit.m_Toggles.emplace_back(90, Input);
+	Circuit.m_Toggles.emplace_back(92, Input);
+	Circuit.m_Toggles.emplace_back(150, Input);
+	return Circuit;
+}
+
+
+
+
+
+/** Two comparators in a row, the first comparing and the second subtracting, with the side inputs toggled. */
+static cCircuit BuildComparators(cWorld & a_World)
+{
+	Vector3i Origin(0, 10, 20);
+
+	// The rear input, a block of redstone and a line of wires, delivering the power level 12:
+	Vector3i RearInput = Origin + Vector3i(0, 1, 0);
+	a_World.SetBlock(RearInput.x, RearInput.y, RearInput.z, E_BLOCK_BLOCK_OF_REDSTONE, 0);
+	for (int x = 1; x <= 4; x++)
+	{
+		PlaceWire(a_World, Origin + Vector3i(x, 1, 0));
+	}
+
+	// The comparing comparator, with its side input:
+	a_World.SetBlock(Origin.x + 5, Origin.y + 1, Origin.z, E_BLOCK_INACTIVE_COMPARATOR, 0x1);
+	PlaceWire(a_World, Origin + Vector3i(5, 1, 1));
+	Vector3i SideInput1 = Origin + Vector3i(5, 1, 2);
+	a_World.SetBlock(SideInput1.x, SideInput1.y, SideInput1.z, E_BLOCK_STONE, 0);
+
+	// The subtracting comparator, fed by a line of wires from the first one, with its side input:
+	PlaceWire(a_World, Origin + Vector3i(6, 1, 0));
+	PlaceWire(a_World, Origin + Vector3i(7, 1, 0));
+	a_World.SetBlock(Origin.x + 8, Origin.y + 1, Origin.z, E_BLOCK_INACTIVE_COMPARATOR, 0x1 | 0x4);
+	PlaceWire(a_World, Origin + Vector3i(8, 1, -1));
+	PlaceWire(a_World, Origin + Vector3i(8, 1, -2));
+	Vector3i SideInput2 = Origin + Vector3i(8, 1, -3);
+	a_World.SetBlock(SideInput2.x, SideInput2.y, SideInput2.z, E_BLOCK_STONE, 0);
+	a_World.SetBlock(Origin.x + 9, Origin.y + 1, Origin.z, E_BLOCK_REDSTONE_LAMP_OFF, 0);
+
+	cCircuit Circuit(cCuboid(Origin + Vector3i(0, 0, -3), Origin + Vector3i(9, 1, 2)), Origin + Vector3i(6, 1, 0));
+	Circuit.m_Toggles.emplace_back(30, SideInput2);
+	Circuit.m_Toggles.emplace_back(60, SideInput1);
+	Circuit.m_Toggles.emplace_back(61, SideInput2);
+	Circuit.m_Toggles.emplace_back(100, SideInput1);
+	Circuit.m_Toggles.emplace_back(130, RearInput);
+	Circuit.m_Toggles.emplace_back(160, RearInput);
+	return Circuit;
+}
+
+
+
+
+
+/** A tower of torches inverting each other's power, fed by a repeater, ending in a lamp. */
+static cCircuit BuildTorchTower(cWorld & a_World)
+{
+	const int NumTorches = 5;
+	Vector3i Origin(20, 10, 20);
+	Vector3i Input = Origin + Vector3i(0, 1, 0);
+	a_World.SetBlock(Input.x, Input.y, Input.z, E_BLOCK_STONE, 0);
+	a_World.SetBlock(Origin.x + 1, Origin.y, Origin.z, E_BLOCK_STONE, 0);
+	a_World.SetBlock(Origin.x + 1, Origin.y + 1, Origin.z, E_BLOCK_REDSTONE_REPEATER_OFF, 0x1);
+	for (int i = 0; i < NumTorches; i++)
+	{
+		a_World.SetBlock(Origin.x + 2, Origin.y + 1 + 2 * i, Origin.z, E_BLOCK_STONE, 0);
+		a_World.SetBlock(Origin.x + 2, Origin.y + 2 + 2 * i, Origin.z, E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_FLOOR);
+	}
+	a_World.SetBlock(Origin.x + 2, Origin.y + 2 + 2 * NumTorches, Origin.z, E_BLOCK_REDSTONE_LAMP_OFF, 0);
+
+	// A wire next to the top torch:
+	PlaceWire(a_World, Origin + Vector3i(3, 2 * NumTorches, 0));
+	cCircuit Circuit(cCuboid(Origin, Origin + Vector3i(3, 2 + 2 * NumTorches, 0)), Origin + Vector3i(3, 2 * NumTorches, 0));
+	Circuit.m_Toggles.emplace_back(20, Input);
+	Circuit.m_Toggles.emplace_back(50, Input);
+	Circuit.m_Toggles.emplace_back(51, Input);
+	Circuit.m_Toggles.emplace_back(120, Input);
+	return Circuit;
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	RunCircuit("a torch clock", 20, BuildClock);
+	RunCircuit("a repeater chain", 4, BuildRepeaters);
+	RunCircuit("comparators", 4, BuildComparators);
+	RunCircuit("a torch tower", 4, BuildTorchTower);
+
+	LOG("RedstoneCircuits test finished");
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,154 @@
+
+// RedstoneGraphTest.cpp
+
+// Implements the test for the cRedstoneGraph class storing the compiled redstone components of a chunk
+
+#include "Globals.h"
+#include "BlockID.h"
+#include "Simulator/IncrementalRedstoneSimulator/RedstoneGraph.h"
+
+
+
+
+
+/** Creates a node for the specified block, stamped the way the simulator stamps it. */
+static cRedstoneGraph::sNode CreateNode(BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const cVector3iArray & a_SourceOffsets)
+{
+	cRedstoneGraph::sNode Node;
+	Node.m_BlockType = a_BlockType;
+	Node.m_Meta = a_Meta;
+	cRedstoneGraph::GetStamp(Node.m_BlockType, Node.m_Meta);
+	Node.m_SourceOffsets = a_SourceOffsets;
+	return Node;
+}
+
+
+
+
+
+/** Checks that the nodes are found regardless of the power state of their blocks. */
+static void TestPowerStates(void)
+{
+	cRedstoneGraph Graph;
+	Graph.SetNode(1, 10, 1, CreateNode(E_BLOCK_REDSTONE_WIRE, 15, { Vector3i(1, 0, 0), Vector3i(-1, 0, 0) }));
+	Graph.SetNode(2, 10, 1, CreateNode(E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_EAST, { Vector3i(-1, 0, 0) }));
+	Graph.SetNode(3, 10, 1, CreateNode(E_BLOCK_REDSTONE_REPEATER_OFF, 0x5, { Vector3i(0, 0, -1) }));
+	Graph.SetNode(4, 10, 1, CreateNode(E_BLOCK_ACTIVE_COMPARATOR, 0x9, { Vector3i(0, 0, 1) }));
+	assert_test(Graph.GetNumNodes() == 4);
+
+	// A wire is found at any power level:
+	auto Wire = Graph.GetNode(1, 10, 1, E_BLOCK_REDSTONE_WIRE, 0);
+	assert_test(Wire != nullptr);
+	assert_test(Wire->m_SourceOffsets.size() == 2);
+	assert_test(Graph.GetNode(1, 10, 1, E_BLOCK_REDSTONE_WIRE, 7) == Wire);
+
+	// Torches and repeaters are found both on and off, with the same meta:
+	assert_test(Graph.GetNode(2, 10, 1, E_BLOCK_REDSTONE_TORCH_OFF, E_META_TORCH_EAST) != nullptr);
+	assert_test(Graph.GetNode(2, 10, 1, E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_EAST) != nullptr);
+	assert_test(Graph.GetNode(3, 10, 1, E_BLOCK_REDSTONE_REPEATER_ON, 0x5) != nullptr);
+
+	// Comparators are found regardless of the powered bit:
+	assert_test(Graph.GetNode(4, 10, 1, E_BLOCK_INACTIVE_COMPARATOR, 0x1) != nullptr);
+	assert_test(Graph.GetNode(4, 10, 1, E_BLOCK_ACTIVE_COMPARATOR, 0x9) != nullptr);
+}
+
+
+
+
+
+/** Checks that the nodes aren't found for other blocks, at other positions, or after being erased. */
+static void TestMismatches(void)
+{
+	cRedstoneGraph Graph;
+	Graph.SetNode(0, 0, 0, CreateNode(E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_EAST, { Vector3i(-1, 0, 0) }));
+	Graph.SetNode(15, 255, 15, CreateNode(E_BLOCK_REDSTONE_REPEATER_OFF, 0x0, { Vector3i(0, 0, -1) }));
+
+	// A torch that has been rotated, or replaced by another component, doesn't use the node:
+	assert_test(Graph.GetNode(0, 0, 0, E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_WEST) == nullptr);
+	assert_test(Graph.GetNode(0, 0, 0, E_BLOCK_REDSTONE_WIRE, 0) == nullptr);
+
+	// A repeater with a different delay is a different block:
+	assert_test(Graph.GetNode(15, 255, 15, E_BLOCK_REDSTONE_REPEATER_OFF, 0x4) == nullptr);
+	assert_test(Graph.GetNode(15, 255, 15, E_BLOCK_REDSTONE_REPEATER_ON, 0x0) != nullptr);
+	assert_test(Graph.GetNode(15, 254, 15, E_BLOCK_REDSTONE_REPEATER_ON, 0x0) == nullptr);
+
+	Graph.EraseNodes(0, 15, 0, 255, 0, 15);
+	assert_test(Graph.GetNumNodes() == 0);
+	assert_test(Graph.GetNode(0, 0, 0, E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_EAST) == nullptr);
+
+	assert_test(cRedstoneGraph::IsCompiledType(E_BLOCK_REDSTONE_WIRE));
+	assert_test(!cRedstoneGraph::IsCompiledType(E_BLOCK_REDSTONE_LAMP_OFF));
+	assert_test(!cRedstoneGraph::IsCompiledType(E_BLOCK_STONE));
+}
+
+
+
+
+
+/** Checks that erasing a box drops exactly the nodes inside it, also for boxes reaching outside the chunk. */
+static void TestEraseNodes(void)
+{
+	cRedstoneGraph Graph;
+	for (int x = 0; x < cChunkDef::Width; x++)
+	{
+		Graph.SetNode(x, 10, 0, CreateNode(E_BLOCK_REDSTONE_WIRE, 0, { Vector3i(-1, 0, 0), Vector3i(1, 0, 0) }));
+	}
+	Graph.SetNode(0, 0, 15, CreateNode(E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_FLOOR, { Vector3i(0, -1, 0) }));
+	Graph.SetNode(0, 255, 15, CreateNode(E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_FLOOR, { Vector3i(0, -1, 0) }));
+	assert_test(Graph.GetNumNodes() == 18);
+
+	// A box around a single block, as erased for a block change, drops only the nodes within it:
+	Graph.EraseNodes(3, 7, 8, 12, -2, 2);
+	assert_test(Graph.GetNumNodes() == 13);
+	assert_test(Graph.GetNode(2, 10, 0, E_BLOCK_REDSTONE_WIRE, 0) != nullptr);
+	assert_test(Graph.GetNode(3, 10, 0, E_BLOCK_REDSTONE_WIRE, 0) == nullptr);
+	assert_test(Graph.GetNode(7, 10, 0, E_BLOCK_REDSTONE_WIRE, 0) == nullptr);
+	assert_test(Graph.GetNode(8, 10, 0, E_BLOCK_REDSTONE_WIRE, 0) != nullptr);
+
+	// A box reaching outside the chunk is clamped to it:
+	Graph.EraseNodes(-2, 1, -2, 1, 13, 17);
+	assert_test(Graph.GetNumNodes() == 12);
+	assert_test(Graph.GetNode(0, 255, 15, E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_FLOOR) != nullptr);
+	Graph.EraseNodes(-2, 1, 254, 257, 13, 17);
+	assert_test(Graph.GetNumNodes() == 11);
+
+	// A box entirely outside the chunk, as erased for a neighbor chunk's block, drops nothing:
+	Graph.EraseNodes(16, 18, 0, 255, 0, 15);
+	Graph.EraseNodes(-3, -1, 0, 255, 0, 15);
+	assert_test(Graph.GetNumNodes() == 11);
+
+	// A box smaller than the number of nodes is walked block by block:
+	Graph.EraseNodes(8, 9, 10, 10, 0, 0);
+	assert_test(Graph.GetNumNodes() == 9);
+	assert_test(Graph.GetNode(8, 10, 0, E_BLOCK_REDSTONE_WIRE, 0) == nullptr);
+	assert_test(Graph.GetNode(10, 10, 0, E_BLOCK_REDSTONE_WIRE, 0) != nullptr);
+
+	// A box larger than the number of nodes drops them all:
+	Graph.EraseNodes(-2, 17, 0, 255, -2, 17);
+	assert_test(Graph.GetNumNodes() == 0);
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	LOGD("Test started");
+
+	LOGD("Testing the power states");
+	TestPowerStates();
+
+	LOGD("Testing the mismatches");
+	TestMismatches();
+
+	LOGD("Testing erasing the nodes");
+	TestEraseNodes();
+
+	LOG("RedstoneGraph test finished");
+	return 0;
+}
+
+
+
+
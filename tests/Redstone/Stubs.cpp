@@ -0,0 +1,589 @@
+
+// Stubs.cpp
+
+// Implements the mock cRoot that creates the test worlds, and stubs of various Cuberite methods
+// that are needed for linking but not for runtime
+// This is required so that we don't bring in the entire Cuberite via dependencies
+
+#include "Globals.h"
+#include "Root.h"
+#include "BrewingRecipes.h"
+#include "DeadlockDetect.h"
+#include "World.h"
+#include "Item.h"
+#include "ItemGrid.h"
+#include "BlockEntities/BlockEntityWithItems.h"
+#include "BlockEntities/CommandBlockEntity.h"
+#include "BlockEntities/DropSpenserEntity.h"
+#include "BlockEntities/NoteEntity.h"
+#include "Blocks/BlockHandler.h"
+#include "Blocks/BlockPiston.h"
+#include "Mobs/PathFinderService.h"
+#include "Simulator/SimulatorManager.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cRoot:
+// Only creates the test worlds, on request; nothing is loaded and no threads are started.
+
+cRoot * cRoot::s_Root = nullptr;
+
+
+
+
+
+cRoot::cRoot(void) :
+	m_pDefaultWorld(nullptr),
+	m_Server(nullptr),
+	m_MonsterConfig(nullptr),
+	m_CraftingRecipes(nullptr),
+	m_FurnaceRecipe(nullptr),
+	m_WebAdmin(nullptr),
+	m_PluginManager(nullptr),
+	m_MojangAPI(nullptr)
+{
+	s_Root = this;
+	m_InputThreadRunFlag.clear();
+}
+
+
+
+
+
+cRoot::~cRoot()
+{
+	for (auto & Entry: m_WorldsByName)
+	{
+		delete Entry.second;
+	}
+	m_WorldsByName.clear();
+	s_Root = nullptr;
+}
+
+
+
+
+
+cWorld * cRoot::GetWorld(const AString & a_WorldName)
+{
+	auto itr = m_WorldsByName.find(a_WorldName);
+	if (itr != m_WorldsByName.end())
+	{
+		return itr->second;
+	}
+
+	// Create an empty test world (World.cpp):
+	static cDeadlockDetect DeadlockDetect;
+	auto World = new cWorld(a_WorldName, a_WorldName, DeadlockDetect, AStringVector(), dimOverworld, AString());
+	m_WorldsByName[a_WorldName] = World;
+	return World;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Needed for linking only; the test worlds have no threads, storage, generator, clients or block entities:
+
+cAuthenticator::cAuthenticator(void) :
+	super("cAuthenticator"),
+	m_ShouldAuthenticate(false)
+{
+}
+
+
+
+
+
+cAuthenticator::~cAuthenticator()
+{
+}
+
+
+
+
+
+void cAuthenticator::Execute(void)
+{
+}
+
+
+
+
+
+cHTTPServer::cHTTPServer(void) :
+	m_Callbacks(nullptr)
+{
+}
+
+
+
+
+
+cHTTPServer::~cHTTPServer()
+{
+}
+
+
+
+
+
+cRankManager::~cRankManager()
+{
+}
+
+
+
+
+
+cDeadlockDetect::cDeadlockDetect(void) :
+	super("DeadlockDetect"),
+	m_IntervalSec(1000)
+{
+}
+
+
+
+
+
+cDeadlockDetect::~cDeadlockDetect()
+{
+}
+
+
+
+
+
+void cDeadlockDetect::Execute(void)
+{
+}
+
+
+
+
+
+cWorldStorage::cWorldStorage(void) :
+	super("cWorldStorage"),
+	m_World(nullptr),
+	m_SaveSchema(nullptr)
+{
+}
+
+
+
+
+
+cWorldStorage::~cWorldStorage()
+{
+}
+
+
+
+
+
+void cWorldStorage::Execute(void)
+{
+}
+
+
+
+
+
+cChunkGenerator::cChunkGenerator(void) :
+	m_Seed(0),
+	m_ShouldTerminate(false),
+	m_NumChunksGenerated(0),
+	m_PluginInterface(nullptr),
+	m_ChunkSink(nullptr)
+{
+}
+
+
+
+
+
+cChunkGenerator::~cChunkGenerator()
+{
+}
+
+
+
+
+
+cChunkSender::cChunkSender(cWorld & a_World) :
+	super("ChunkSender"),
+	m_World(a_World)
+{
+}
+
+
+
+
+
+cChunkSender::~cChunkSender()
+{
+}
+
+
+
+
+
+void cChunkSender::Execute(void)
+{
+}
+
+
+
+
+
+void cChunkSender::BiomeData(const cChunkDef::BiomeMap * a_BiomeMap)
+{
+}
+
+
+
+
+
+void cChunkSender::Entity(cEntity * a_Entity)
+{
+}
+
+
+
+
+
+void cChunkSender::BlockEntity(cBlockEntity * a_Entity)
+{
+}
+
+
+
+
+
+cLightingThread::cLightingThread(cWorld & a_World) :
+	m_World(a_World),
+	m_ShouldTerminate(false)
+{
+}
+
+
+
+
+
+cLightingThread::~cLightingThread()
+{
+}
+
+
+
+
+
+cScoreboard::cScoreboard(cWorld * a_World) :
+	m_World(a_World)
+{
+}
+
+
+
+
+
+cMapManager::cMapManager(cWorld * a_World) :
+	m_World(a_World)
+{
+}
+
+
+
+
+
+cPathFinderService::cPathFinderService(const bool * a_IsSolid) :
+	m_IsSolid(),
+	m_Search(m_IsSolid),
+	m_ShouldTerminate(false),
+	m_CurrentTick(0)
+{
+}
+
+
+
+
+
+cPathFinderService::~cPathFinderService()
+{
+}
+
+
+
+
+
+cSimulatorManager::~cSimulatorManager()
+{
+}
+
+
+
+
+
+cBlockHandler * cBlockHandler::CreateBlockHandler(BLOCKTYPE a_BlockType)
+{
+	// The block infos only need a handler for each block type, none of them is ever used:
+	return new cBlockHandler(a_BlockType);
+}
+
+
+
+
+
+cBlockHandler::cBlockHandler(BLOCKTYPE a_BlockType) :
+	m_BlockType(a_BlockType)
+{
+}
+
+
+
+
+
+void cBlockHandler::OnUpdate(cChunkInterface & cChunkInterface, cWorldInterface & a_WorldInterface, cBlockPluginInterface & a_PluginInterface, cChunk & a_Chunk, int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+}
+
+
+
+
+
+cBoundingBox cBlockHandler::GetPlacementCollisionBox(BLOCKTYPE a_XM, BLOCKTYPE a_XP, BLOCKTYPE a_YM, BLOCKTYPE a_YP, BLOCKTYPE a_ZM, BLOCKTYPE a_ZP)
+{
+	return cBoundingBox(0, 0, 0, 0, 0, 0);
+}
+
+
+
+
+
+bool cBlockHandler::GetPlacementBlockTypeMeta(
+	cChunkInterface & a_ChunkInterface, cPlayer & a_Player,
+	int a_BlockX, int a_BlockY, int a_BlockZ, eBlockFace a_BlockFace,
+	int a_CursorX, int a_CursorY, int a_CursorZ,
+	BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta
+)
+{
+	return true;
+}
+
+
+
+
+
+void cBlockHandler::OnPlaced(cChunkInterface & a_ChunkInterface, cWorldInterface & a_WorldInterface, int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta)
+{
+}
+
+
+
+
+
+void cBlockHandler::OnPlacedByPlayer(cChunkInterface & a_ChunkInterface, cWorldInterface & a_WorldInterface, cPlayer & a_Player, const sSetBlock & a_BlockChange)
+{
+}
+
+
+
+
+
+void cBlockHandler::OnDestroyedByPlayer(cChunkInterface & a_ChunkInterface, cWorldInterface & a_WorldInterface, cPlayer & a_Player, int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+}
+
+
+
+
+
+void cBlockHandler::OnDestroyed(cChunkInterface & a_ChunkInterface, cWorldInterface & a_WorldInterface, int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+}
+
+
+
+
+
+void cBlockHandler::ConvertToPickups(cItems & a_Pickups, NIBBLETYPE a_BlockMeta)
+{
+}
+
+
+
+
+
+void cBlockHandler::DropBlock(cChunkInterface & a_ChunkInterface, cWorldInterface & a_WorldInterface, cBlockPluginInterface & a_BlockPluginInterface, cEntity * a_Digger, int a_BlockX, int a_BlockY, int a_BlockZ, bool a_CanDrop)
+{
+}
+
+
+
+
+
+bool cBlockHandler::CanBeAt(cChunkInterface & a_ChunkInterface, int a_BlockX, int a_BlockY, int a_BlockZ, const cChunk & a_Chunk)
+{
+	return true;
+}
+
+
+
+
+
+bool cBlockHandler::IsUseable()
+{
+	return false;
+}
+
+
+
+
+
+bool cBlockHandler::IsClickedThrough(void)
+{
+	return false;
+}
+
+
+
+
+
+bool cBlockHandler::DoesIgnoreBuildCollision(cChunkInterface & a_ChunkInterface, Vector3i a_Pos, cPlayer & a_Player, NIBBLETYPE a_Meta)
+{
+	return (m_BlockType == E_BLOCK_AIR);
+}
+
+
+
+
+
+bool cBlockHandler::DoesDropOnUnsuitable(void)
+{
+	return true;
+}
+
+
+
+
+
+bool cBlockHandler::IsInsideBlock(Vector3d a_Position, const BLOCKTYPE a_BlockType, const NIBBLETYPE a_BlockMeta)
+{
+	return true;
+}
+
+
+
+
+
+void cBlockHandler::Check(cChunkInterface & a_ChunkInterface, cBlockPluginInterface & a_PluginInterface, int a_RelX, int a_RelY, int a_RelZ, cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+ColourID cBlockHandler::GetMapBaseColourID(NIBBLETYPE a_Meta)
+{
+	return 0;
+}
+
+
+
+
+
+void cBlockPistonHandler::ExtendPiston(Vector3i a_BlockPos, cWorld & a_World)
+{
+}
+
+
+
+
+
+void cBlockPistonHandler::RetractPiston(Vector3i a_BlockPos, cWorld & a_World)
+{
+}
+
+
+
+
+
+void cBlockEntity::CopyFrom(const cBlockEntity & a_Src)
+{
+}
+
+
+
+
+
+void cBlockEntityWithItems::Destroy(void)
+{
+}
+
+
+
+
+
+void cBlockEntityWithItems::CopyFrom(const cBlockEntity & a_Src)
+{
+}
+
+
+
+
+
+void cBlockEntityWithItems::OnSlotChanged(cItemGrid * a_Grid, int a_SlotNum)
+{
+}
+
+
+
+
+
+void cCommandBlockEntity::Activate(void)
+{
+}
+
+
+
+
+
+void cDropSpenserEntity::Activate(void)
+{
+}
+
+
+
+
+
+void cNoteEntity::MakeSound(void)
+{
+}
+
+
+
+
+
+char cItem::GetMaxStackSize(void) const
+{
+	return 64;
+}
+
+
+
+
+
+const cItem & cItemGrid::GetSlot(int a_SlotNum) const
+{
+	return m_Slots[a_SlotNum];
+}
+
+
+
+
+
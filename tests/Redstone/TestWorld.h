@@ -0,0 +1,130 @@
+
+// TestWorld.h
+
+// Declares the helpers for running redstone circuits in the mock test worlds (World.cpp, Chunk.cpp)
+// The worlds are created by the mock cRoot::GetWorld() (Stubs.cpp); a cRoot object needs to exist while they're used.
+
+#pragma once
+
+#include "World.h"
+#include "Cuboid.h"
+#include "Simulator/RedstoneSimulator.h"
+
+
+
+
+
+/** The name of the test world that runs the redstone simulator with the compiled networks.
+The test worlds of any other name run it without them. */
+static const char COMPILED_WORLD_NAME[] = "CompiledRedstone";
+
+/** The length of a single world tick, as passed to the simulators. */
+static const float TICK_LENGTH = 50;
+
+
+
+
+
+/** Runs a single tick of the world's redstone simulator, the same way the world tick does. */
+inline void TickRedstone(cWorld & a_World)
+{
+	a_World.GetRedstoneSimulator()->Simulate(TICK_LENGTH);
+}
+
+
+
+
+
+/** Places a redstone wire at a_Pos, on top of a stone block. */
+inline void PlaceWire(cWorld & a_World, Vector3i a_Pos)
+{
+	a_World.SetBlock(a_Pos.x, a_Pos.y - 1, a_Pos.z, E_BLOCK_STONE, 0);
+	a_World.SetBlock(a_Pos.x, a_Pos.y, a_Pos.z, E_BLOCK_REDSTONE_WIRE, 0);
+}
+
+
+
+
+
+/** Builds a clock next to a_Origin, within the cuboid a_Origin + {0, 0, 0} .. {2, 1, 2}: a torch attached to a block,
+and a loop of wires from the torch to a repeater powering the block, turning the torch off again.
+Returns the position of the torch. */
+inline Vector3i BuildTorchClock(cWorld & a_World, Vector3i a_Origin)
+{
+	a_World.SetBlock(a_Origin.x, a_Origin.y + 1, a_Origin.z, E_BLOCK_STONE, 0);
+	a_World.SetBlock(a_Origin.x + 1, a_Origin.y + 1, a_Origin.z, E_BLOCK_REDSTONE_TORCH_ON, E_META_TORCH_XM);
+	PlaceWire(a_World, a_Origin + Vector3i(2, 1, 0));
+	PlaceWire(a_World, a_Origin + Vector3i(2, 1, 1));
+	PlaceWire(a_World, a_Origin + Vector3i(2, 1, 2));
+	PlaceWire(a_World, a_Origin + Vector3i(1, 1, 2));
+	PlaceWire(a_World, a_Origin + Vector3i(0, 1, 2));
+
+	// A repeater with a delay of 2 ticks, facing the block at a_Origin:
+	a_World.SetBlock(a_Origin.x, a_Origin.y, a_Origin.z + 1, E_BLOCK_STONE, 0);
+	a_World.SetBlock(a_Origin.x, a_Origin.y + 1, a_Origin.z + 1, E_BLOCK_REDSTONE_REPEATER_OFF, 0x4);
+	return a_Origin + Vector3i(1, 1, 0);
+}
+
+
+
+
+
+/** Builds a line of a_Length repeaters in the X+ direction, with delays cycling from 1 to 4 ticks, within the cuboid
+a_Origin + {0, 0, 0} .. {a_Length + 1, 1, 0}. The input at a_Origin + {0, 1, 0} is a block of redstone;
+the repeaters end in a redstone lamp. Returns the position of the input. */
+inline Vector3i BuildRepeaterChain(cWorld & a_World, Vector3i a_Origin, int a_Length)
+{
+	a_World.SetBlock(a_Origin.x, a_Origin.y + 1, a_Origin.z, E_BLOCK_BLOCK_OF_REDSTONE, 0);
+	for (int i = 1; i <= a_Length; i++)
+	{
+		a_World.SetBlock(a_Origin.x + i, a_Origin.y, a_Origin.z, E_BLOCK_STONE, 0);
+		a_World.SetBlock(a_Origin.x + i, a_Origin.y + 1, a_Origin.z, E_BLOCK_REDSTONE_REPEATER_OFF, static_cast<NIBBLETYPE>(0x1 | ((i % 4) << 2)));
+	}
+	a_World.SetBlock(a_Origin.x + a_Length + 1, a_Origin.y + 1, a_Origin.z, E_BLOCK_REDSTONE_LAMP_OFF, 0);
+	return a_Origin + Vector3i(0, 1, 0);
+}
+
+
+
+
+
+/** Toggles the input block at a_Pos between a block of redstone and a stone block. */
+inline void ToggleInput(cWorld & a_World, Vector3i a_Pos)
+{
+	BLOCKTYPE NewBlock = (a_World.GetBlock(a_Pos) == E_BLOCK_BLOCK_OF_REDSTONE) ? E_BLOCK_STONE : E_BLOCK_BLOCK_OF_REDSTONE;
+	a_World.SetBlock(a_Pos.x, a_Pos.y, a_Pos.z, NewBlock, 0);
+}
+
+
+
+
+
+/** Returns true if both worlds have the same blocks, including the metas, within the cuboid. */
+inline bool AreBlocksEqual(cWorld & a_World1, cWorld & a_World2, const cCuboid & a_Cuboid)
+{
+	for (int y = a_Cuboid.p1.y; y <= a_Cuboid.p2.y; y++)
+	{
+		for (int z = a_Cuboid.p1.z; z <= a_Cuboid.p2.z; z++)
+		{
+			for (int x = a_Cuboid.p1.x; x <= a_Cuboid.p2.x; x++)
+			{
+				BLOCKTYPE BlockType1, BlockType2;
+				NIBBLETYPE BlockMeta1, BlockMeta2;
+				a_World1.GetBlockTypeMeta(x, y, z, BlockType1, BlockMeta1);
+				a_World2.GetBlockTypeMeta(x, y, z, BlockType2, BlockMeta2);
+				if ((BlockType1 != BlockType2) || (BlockMeta1 != BlockMeta2))
+				{
+					LOGWARNING("Block {%d, %d, %d} differs: %d:%d vs %d:%d",
+						x, y, z, BlockType1, BlockMeta1, BlockType2, BlockMeta2
+					);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+
+
+
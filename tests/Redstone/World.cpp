@@ -0,0 +1,440 @@
+
+// World.cpp
+
+// Mocks the cWorld class used by the redstone tests
+// The world only has the redstone simulator and the chunk map (Chunk.cpp); it reads and sets the blocks the same way as
+// the real world, through the chunk map, and wakes up the redstone simulator for the changed blocks the same way the
+// real simulator manager does. Everything else (entities, block entities, broadcasts, generating, saving) is left out,
+// the functions needed only for linking do nothing.
+
+#include "Globals.h"
+#include "World.h"
+#include "Chunk.h"
+#include "ChunkMap.h"
+#include "Root.h"
+#include "SetChunkData.h"
+#include "Entities/Player.h"
+#include "Simulator/IncrementalRedstoneSimulator/IncrementalRedstoneSimulator.h"
+#include "TestWorld.h"
+
+
+
+
+
+cWorld::cWorld(
+	const AString & a_WorldName, const AString & a_DataPath,
+	cDeadlockDetect & a_DeadlockDetect, const AStringVector & a_WorldNames,
+	eDimension a_Dimension, const AString & a_LinkedOverworldName
+):
+	m_WorldName(a_WorldName),
+	m_DataPath(a_DataPath),
+	m_LinkedOverworldName(a_LinkedOverworldName),
+	m_IsSavingEnabled(false),
+	m_Dimension(a_Dimension),
+	m_WorldAge(0),
+	m_TimeOfDay(0),
+	m_LastTimeUpdate(0),
+	m_LastChunkCheck(0),
+	m_LastSave(0),
+	m_WaterSimulator(nullptr),
+	m_LavaSimulator(nullptr),
+	m_RedstoneSimulator(nullptr),
+	m_Scoreboard(this),
+	m_MapManager(this),
+	m_GeneratorCallbacks(*this),
+	m_ChunkSender(*this),
+	m_Lighting(*this),
+	m_PathFinderService(nullptr),
+	m_TickThread(*this)
+{
+	UNUSED(a_DeadlockDetect);
+	UNUSED(a_WorldNames);
+
+	m_RedstoneSimulator = new cIncrementalRedstoneSimulator(*this, (a_WorldName == COMPILED_WORLD_NAME));
+	m_ChunkMap = cpp14::make_unique<cChunkMap>(this);
+}
+
+
+
+
+
+cWorld::~cWorld()
+{
+	// The chunks use the simulator's chunk data, destroy them first:
+	m_ChunkMap.reset();
+	delete m_RedstoneSimulator;
+	m_RedstoneSimulator = nullptr;
+}
+
+
+
+
+
+void cWorld::SetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, bool a_SendToClients)
+{
+	m_ChunkMap->SetBlock(a_BlockX, a_BlockY, a_BlockZ, a_BlockType, a_BlockMeta, a_SendToClients);
+}
+
+
+
+
+
+void cWorld::SetBlockMeta(int a_X, int a_Y, int a_Z, NIBBLETYPE a_MetaData, bool a_ShouldMarkDirty, bool a_ShouldInformClients)
+{
+	m_ChunkMap->SetBlockMeta(a_X, a_Y, a_Z, a_MetaData, a_ShouldMarkDirty, a_ShouldInformClients);
+}
+
+
+
+
+
+bool cWorld::GetBlockTypeMeta(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta)
+{
+	return m_ChunkMap->GetBlockTypeMeta(a_BlockX, a_BlockY, a_BlockZ, a_BlockType, a_BlockMeta);
+}
+
+
+
+
+
+bool cWorld::DoWithChunk(int a_ChunkX, int a_ChunkZ, cChunkCallback a_Callback)
+{
+	return m_ChunkMap->DoWithChunk(a_ChunkX, a_ChunkZ, a_Callback);
+}
+
+
+
+
+
+bool cWorld::DoWithChunkAt(Vector3i a_BlockPos, cChunkCallback a_Callback)
+{
+	return m_ChunkMap->DoWithChunkAt(a_BlockPos, a_Callback);
+}
+
+
+
+
+
+void cWorld::WakeUpSimulators(Vector3i a_Block)
+{
+	return m_ChunkMap->WakeUpSimulators(a_Block);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Needed for linking only; the test world has no entities, block entities or clients:
+
+cWorld::cTickThread::cTickThread(cWorld & a_World) :
+	super(Printf("WorldTickThread: %s", a_World.GetName().c_str())),
+	m_World(a_World)
+{
+}
+
+
+
+
+
+void cWorld::cTickThread::Execute(void)
+{
+}
+
+
+
+
+
+cWorld::cChunkGeneratorCallbacks::cChunkGeneratorCallbacks(cWorld & a_World) :
+	m_World(&a_World)
+{
+}
+
+
+
+
+
+void cWorld::cChunkGeneratorCallbacks::OnChunkGenerated(cChunkDesc & a_ChunkDesc)
+{
+}
+
+
+
+
+
+bool cWorld::cChunkGeneratorCallbacks::IsChunkValid(int a_ChunkX, int a_ChunkZ)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::cChunkGeneratorCallbacks::HasChunkAnyClients(int a_ChunkX, int a_ChunkZ)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::cChunkGeneratorCallbacks::IsChunkQueued(int a_ChunkX, int a_ChunkZ)
+{
+	return false;
+}
+
+
+
+
+
+void cWorld::cChunkGeneratorCallbacks::CallHookChunkGenerating(cChunkDesc & a_ChunkDesc)
+{
+}
+
+
+
+
+
+void cWorld::cChunkGeneratorCallbacks::CallHookChunkGenerated(cChunkDesc & a_ChunkDesc)
+{
+}
+
+
+
+
+
+bool cWorld::DoWithBlockEntityAt(int a_BlockX, int a_BlockY, int a_BlockZ, cBlockEntityCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::DoWithChestAt(int a_BlockX, int a_BlockY, int a_BlockZ, cChestCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::DoWithDropSpenserAt(int a_BlockX, int a_BlockY, int a_BlockZ, cDropSpenserCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::DoWithNoteBlockAt(int a_BlockX, int a_BlockY, int a_BlockZ, cNoteBlockCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::DoWithCommandBlockAt(int a_BlockX, int a_BlockY, int a_BlockZ, cCommandBlockCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+UInt32 cWorld::SpawnPrimedTNT(Vector3d a_Pos, int a_FuseTimeInSec, double a_InitialVelocityCoeff)
+{
+	return cEntity::INVALID_ID;
+}
+
+
+
+
+
+void cWorld::BroadcastSoundEffect(const AString & a_SoundName, Vector3d a_Position, float a_Volume, float a_Pitch, const cClientHandle * a_Exclude)
+{
+}
+
+
+
+
+
+void cWorld::BroadcastSoundParticleEffect(const EffectID a_EffectID, int a_SrcX, int a_SrcY, int a_SrcZ, int a_Data, const cClientHandle * a_Exclude)
+{
+}
+
+
+
+
+
+bool cWorld::DoWithBedAt(int a_BlockX, int a_BlockY, int a_BlockZ, cBedCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::ForEachPlayer(cPlayerListCallback a_Callback)
+{
+	return true;
+}
+
+
+
+
+
+bool cWorld::ForEachChunkInRect(int a_MinChunkX, int a_MaxChunkX, int a_MinChunkZ, int a_MaxChunkZ, cChunkDataCallback & a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cWorld::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes)
+{
+	return false;
+}
+
+
+
+
+
+int cWorld::GetHeight(int a_BlockX, int a_BlockZ)
+{
+	return 0;
+}
+
+
+
+
+
+bool cWorld::IsWeatherWetAtXYZ(Vector3i a_Pos)
+{
+	return false;
+}
+
+
+
+
+
+void cWorld::SendBlockTo(int a_X, int a_Y, int a_Z, cPlayer & a_Player)
+{
+}
+
+
+
+
+
+void cWorld::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, bool a_CanCauseFire, eExplosionSource a_Source, void * a_SourceData)
+{
+}
+
+
+
+
+
+void cWorld::SpawnItemPickups(const cItems & a_Pickups, double a_BlockX, double a_BlockY, double a_BlockZ, double a_FlyAwaySpeed, bool IsPlayerCreated)
+{
+}
+
+
+
+
+
+void cWorld::SpawnItemPickups(const cItems & a_Pickups, double a_BlockX, double a_BlockY, double a_BlockZ, double a_SpeedX, double a_SpeedY, double a_SpeedZ, bool IsPlayerCreated)
+{
+}
+
+
+
+
+
+UInt32 cWorld::SpawnItemPickup(double a_PosX, double a_PosY, double a_PosZ, const cItem & a_Item, float a_SpeedX, float a_SpeedY, float a_SpeedZ, int a_LifetimeTicks, bool a_CanCombine)
+{
+	return cEntity::INVALID_ID;
+}
+
+
+
+
+
+UInt32 cWorld::SpawnExperienceOrb(double a_X, double a_Y, double a_Z, int a_Reward)
+{
+	return cEntity::INVALID_ID;
+}
+
+
+
+
+
+UInt32 cWorld::SpawnMob(double a_PosX, double a_PosY, double a_PosZ, eMonsterType a_MonsterType, bool a_Baby)
+{
+	return cEntity::INVALID_ID;
+}
+
+
+
+
+
+void cWorld::BroadcastEntityAnimation(const cEntity & a_Entity, char a_Animation, const cClientHandle * a_Exclude)
+{
+}
+
+
+
+
+
+void cWorld::BroadcastUseBed(const cEntity & a_Entity, int a_BlockX, int a_BlockY, int a_BlockZ)
+{
+}
+
+
+
+
+
+void cWorld::BroadcastTimeUpdate(const cClientHandle * a_Exclude)
+{
+}
+
+
+
+
+
+void cWorld::UpdateSkyDarkness(void)
+{
+}
+
+
+
+
+
+EMCSBiome cWorld::GetBiomeAt(int a_BlockX, int a_BlockZ)
+{
+	return biPlains;
+}
+
+
+
+
+